@@ -46,7 +46,7 @@ controller_interface::CallbackReturn AckermannSteeringController::configure_odom
     odometry_.set_wheel_params(front_wheels_radius, wheelbase, front_wheel_track);
   }
 
-  odometry_.set_odometry_type(steering_odometry::ACKERMANN_CONFIG);
+  odometry_.set_kinematic_model<steering_odometry::AckermannModel>();
 
   set_interface_numbers(NR_STATE_ITFS, NR_CMD_ITFS, NR_REF_ITFS);
 
@@ -62,15 +62,12 @@ bool AckermannSteeringController::update_odometry(const rclcpp::Duration & perio
   }
   else
   {
-    const double rear_right_wheel_value = state_interfaces_[STATE_TRACTION_RIGHT_WHEEL].get_value();
-    const double rear_left_wheel_value = state_interfaces_[STATE_TRACTION_LEFT_WHEEL].get_value();
-    const double front_right_steer_position =
-      state_interfaces_[STATE_STEER_RIGHT_WHEEL].get_value();
-    const double front_left_steer_position = state_interfaces_[STATE_STEER_LEFT_WHEEL].get_value();
-    if (
-      !std::isnan(rear_right_wheel_value) && !std::isnan(rear_left_wheel_value) &&
-      !std::isnan(front_right_steer_position) && !std::isnan(front_left_steer_position))
+    if (state_values_valid_)
     {
+      const double rear_right_wheel_value = state_values_[STATE_TRACTION_RIGHT_WHEEL];
+      const double rear_left_wheel_value = state_values_[STATE_TRACTION_LEFT_WHEEL];
+      const double front_right_steer_position = state_values_[STATE_STEER_RIGHT_WHEEL];
+      const double front_left_steer_position = state_values_[STATE_STEER_LEFT_WHEEL];
       if (params_.position_feedback)
       {
         // Estimate linear and angular velocity using joint information
@@ -18,6 +18,7 @@
 #define ADMITTANCE_CONTROLLER__ADMITTANCE_CONTROLLER_HPP_
 
 #include <chrono>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -27,8 +28,12 @@
 
 #include "admittance_controller/admittance_rule.hpp"
 #include "admittance_controller/visibility_control.h"
+#include "admittance_controller/wrench_filter_chain.hpp"
 #include "control_msgs/msg/admittance_controller_state.hpp"
 #include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_realtime_tools/input_recorder.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
 #include "geometry_msgs/msg/pose_stamped.hpp"
 #include "geometry_msgs/msg/transform_stamped.hpp"
 #include "geometry_msgs/msg/wrench_stamped.hpp"
@@ -38,8 +43,6 @@
 #include "rclcpp/time.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
 #include "semantic_components/force_torque_sensor.hpp"
 
 #include "trajectory_msgs/msg/joint_trajectory.hpp"
@@ -48,6 +51,21 @@ namespace admittance_controller
 {
 using ControllerStateMsg = control_msgs::msg::AdmittanceControllerState;
 
+/// Positions, velocities and accelerations of all joints, passed to the admittance rule in place
+struct JointStateVectors
+{
+  void resize(size_t num_joints)
+  {
+    positions = Eigen::VectorXd::Zero(static_cast<Eigen::Index>(num_joints));
+    velocities = Eigen::VectorXd::Zero(static_cast<Eigen::Index>(num_joints));
+    accelerations = Eigen::VectorXd::Zero(static_cast<Eigen::Index>(num_joints));
+  }
+
+  Eigen::VectorXd positions;
+  Eigen::VectorXd velocities;
+  Eigen::VectorXd accelerations;
+};
+
 class AdmittanceController : public controller_interface::ChainableControllerInterface
 {
 public:
@@ -131,12 +149,21 @@ protected:
     hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY};
   std::vector<std::reference_wrapper<double>> position_reference_;
   std::vector<std::reference_wrapper<double>> velocity_reference_;
+  // index of the wrench of the force torque sensor in reference_interfaces_, after the joint
+  // references, if 'ft_sensor.use_reference_interfaces' is set
+  size_t wrench_reference_index_ = 0;
 
   // Admittance rule and dependent variables;
   std::unique_ptr<admittance_controller::AdmittanceRule> admittance_;
 
   // force torque sensor
   std::unique_ptr<semantic_components::ForceTorqueSensor> force_torque_sensor_;
+  // filters applied to the raw wrench of the force torque sensor
+  WrenchFilterChain wrench_filter_chain_;
+  // additional force torque sensors fused by the admittance rule, and their filters
+  std::vector<std::unique_ptr<semantic_components::ForceTorqueSensor>>
+    additional_force_torque_sensors_;
+  std::vector<WrenchFilterChain> additional_wrench_filter_chains_;
 
   // ROS subscribers
   rclcpp::Subscription<trajectory_msgs::msg::JointTrajectoryPoint>::SharedPtr
@@ -146,43 +173,44 @@ protected:
   // admittance parameters
   std::shared_ptr<admittance_controller::ParamListener> parameter_handler_;
 
-  // ROS messages
-  std::shared_ptr<trajectory_msgs::msg::JointTrajectoryPoint> joint_command_msg_;
-
-  // real-time buffer
-  realtime_tools::RealtimeBuffer<std::shared_ptr<trajectory_msgs::msg::JointTrajectoryPoint>>
+  // joint references of the last message, laid out as reference_interfaces_
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<std::vector<double>>>
     input_joint_command_;
-  std::unique_ptr<realtime_tools::RealtimePublisher<ControllerStateMsg>> state_publisher_;
-
-  trajectory_msgs::msg::JointTrajectoryPoint last_commanded_;
-  trajectory_msgs::msg::JointTrajectoryPoint last_reference_;
+  using StatePublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    ControllerStateMsg, rclcpp::Publisher<ControllerStateMsg>>;
+  std::unique_ptr<StatePublisher> state_publisher_;
+  ControllerStateMsg state_msg_;
+  // records the inputs of every update while active, only with 'input_recording.enable'
+  std::unique_ptr<controller_realtime_tools::InputRecorder> input_recorder_;
 
   // control loop data
-  // reference_: reference value read by the controller
+  // reference_: reference value read by the controller, kept if the reference interfaces are NaN
   // joint_state_: current joint readings from the hardware
   // reference_admittance_: reference value used by the controller after the admittance values are
-  // applied ft_values_: values read from the force torque sensor
-  trajectory_msgs::msg::JointTrajectoryPoint reference_, joint_state_, reference_admittance_;
+  // applied, also the joint state if the hardware reads NaN
+  // ft_values_: values read from the force torque sensor
+  // additional_ft_values_: values read from the additional force torque sensors
+  JointStateVectors reference_, joint_state_, reference_admittance_;
   geometry_msgs::msg::Wrench ft_values_;
+  std::vector<geometry_msgs::msg::Wrench> additional_ft_values_;
 
   /**
    * @brief Read values from hardware interfaces and set corresponding fields of state_current and
-   * ft_values
+   * ft_values, and additional_ft_values_
    */
   void read_state_from_hardware(
-    trajectory_msgs::msg::JointTrajectoryPoint & state_current,
-    geometry_msgs::msg::Wrench & ft_values);
+    JointStateVectors & state_current, geometry_msgs::msg::Wrench & ft_values);
 
   /**
    * @brief Set fields of state_reference with values from controllers exported position and
-   * velocity references
+   * velocity references, the ones which are NaN keep their value
    */
-  void read_state_reference_interfaces(trajectory_msgs::msg::JointTrajectoryPoint & state);
+  void read_state_reference_interfaces(JointStateVectors & state_reference);
 
   /**
    * @brief Write values from state_command to claimed hardware interfaces
    */
-  void write_state_to_hardware(const trajectory_msgs::msg::JointTrajectoryPoint & state_command);
+  void write_state_to_hardware(const JointStateVectors & state_command);
 };
 
 }  // namespace admittance_controller
@@ -17,16 +17,22 @@
 #ifndef ADMITTANCE_CONTROLLER__ADMITTANCE_RULE_HPP_
 #define ADMITTANCE_CONTROLLER__ADMITTANCE_RULE_HPP_
 
+#include <Eigen/Cholesky>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "admittance_controller_parameters.hpp"
 #include "control_msgs/msg/admittance_controller_state.hpp"
 #include "control_toolbox/filters.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/parameter_snapshot.hpp"
+#include "controller_realtime_tools/pipelined_worker.hpp"
 #include "geometry_msgs/msg/wrench_stamped.hpp"
 #include "kinematics_interface/kinematics_interface.hpp"
 #include "pluginlib/class_loader.hpp"
@@ -65,18 +71,17 @@ struct AdmittanceState
   {
     admittance_velocity.setZero();
     admittance_acceleration.setZero();
+    admittance_position.setIdentity();
     damping.setZero();
     mass.setOnes();
     mass_inv.setZero();
     stiffness.setZero();
     selected_axes.setZero();
-    current_joint_pos = Eigen::VectorXd::Zero(num_joints);
     joint_pos = Eigen::VectorXd::Zero(num_joints);
     joint_vel = Eigen::VectorXd::Zero(num_joints);
     joint_acc = Eigen::VectorXd::Zero(num_joints);
   }
 
-  Eigen::VectorXd current_joint_pos;
   Eigen::VectorXd joint_pos;
   Eigen::VectorXd joint_vel;
   Eigen::VectorXd joint_acc;
@@ -91,9 +96,70 @@ struct AdmittanceState
   Eigen::Isometry3d admittance_position;
   Eigen::Matrix<double, 3, 3> rot_base_control;
   Eigen::Isometry3d ref_trans_base_ft;
+  Eigen::Isometry3d trans_base_ft;
   std::string ft_sensor_frame;
 };
 
+/// Parameters of the admittance rule and the values derived from them, built when they change.
+struct AdmittanceParameters
+{
+  explicit AdmittanceParameters(const admittance_controller::Params & parameters);
+
+  admittance_controller::Params params;
+  Eigen::Matrix<double, 6, 1> damping;
+  Eigen::Matrix<double, 6, 1> mass;
+  Eigen::Matrix<double, 6, 1> mass_inv;
+  Eigen::Matrix<double, 6, 1> selected_axes;
+  Eigen::Matrix<double, 6, 1> stiffness;
+  // position of center of gravity in cog_frame
+  Eigen::Vector3d cog_pos;
+  // force applied to sensor due to weight of end effector
+  Eigen::Vector3d end_effector_weight;
+  // distinct frames whose transforms are needed at the current joint state
+  std::vector<std::string> frame_ids;
+  // index in frame_ids of the frame of each transform in AdmittanceTransforms
+  size_t ft_frame_index;
+  size_t tip_frame_index;
+  size_t world_frame_index;
+  size_t cog_frame_index;
+  size_t control_frame_index;
+
+  /// Additional force torque sensor, whose wrench is added to the one of the main sensor.
+  struct AdditionalFtSensor
+  {
+    // index in frame_ids of the sensor frame and of its gravity compensation frame
+    size_t frame_index;
+    size_t cog_frame_index;
+    Eigen::Vector3d cog_pos;
+    Eigen::Vector3d end_effector_weight;
+  };
+  // in the order of params.additional_ft_sensors
+  std::vector<AdditionalFtSensor> additional_ft_sensors;
+};
+
+/// Joint positions the helper thread of the pipelined kinematics computes the transforms at.
+struct KinematicsRequest
+{
+  Eigen::VectorXd joint_pos;
+  Eigen::VectorXd ref_joint_pos;
+  // damping coefficient of the Jacobian pseudo-inverse
+  double alpha = 0.0;
+};
+
+/// Transforms and Jacobian computed by the helper thread of the pipelined kinematics.
+struct KinematicsResult
+{
+  Eigen::VectorXd joint_pos;
+  Eigen::VectorXd ref_joint_pos;
+  // of the frames in AdmittanceRule::pipeline_frame_ids_
+  std::vector<Eigen::Isometry3d> frame_transforms;
+  Eigen::Isometry3d ref_base_ft;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian;
+  Eigen::Matrix<double, Eigen::Dynamic, 6> jacobian_inverse;
+  bool valid = false;
+  bool ref_valid = false;
+};
+
 class AdmittanceRule
 {
 public:
@@ -104,6 +170,9 @@ public:
     parameters_ = parameter_handler_->get_params();
     num_joints_ = parameters_.joints.size();
     admittance_state_ = AdmittanceState(num_joints_);
+    parameter_snapshot_ =
+      std::make_unique<controller_realtime_tools::ParameterSnapshot<AdmittanceParameters>>(
+        std::make_unique<const AdmittanceParameters>(parameters_));
     reset(num_joints_);
   }
 
@@ -120,15 +189,26 @@ public:
    * return value is true if all transformation are calculated without an error \param[in]
    * current_joint_state current joint state of the robot \param[in] reference_joint_state input
    * joint state reference \param[out] success true if no calls to the kinematics interface fail
+   *
+   * Frames shared by several transforms are computed once, and the transforms are only computed
+   * again if the joint state they depend on changed since the last call. The same holds for the
+   * Jacobian of the force torque sensor frame and its damped pseudo-inverse. The ones at the
+   * current joint state are only refreshed as configured by the kinematics.refresh parameters.
    */
   bool get_all_transforms(
     const trajectory_msgs::msg::JointTrajectoryPoint & current_joint_state,
     const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state);
 
+  /// Calculate all transforms as above, from the joint positions only.
+  bool get_all_transforms(
+    const Eigen::Ref<const Eigen::VectorXd> & current_joint_pos,
+    const Eigen::Ref<const Eigen::VectorXd> & reference_joint_pos);
+
   /**
    * Updates parameter_ struct if any parameters have changed since last update. Parameter dependent
-   * Eigen field members (end_effector_weight_, cog_pos_, mass_, mass_inv_ stiffness, selected_axes,
-   * damping_) are also updated
+   * Eigen field members (end_effector_weight, cog_pos, mass, mass_inv, stiffness, selected_axes,
+   * damping) are also updated. Not realtime-safe, while running parameter updates are taken over
+   * from a timer instead.
    */
   void apply_parameters_update();
 
@@ -151,12 +231,45 @@ public:
     trajectory_msgs::msg::JointTrajectoryPoint & desired_joint_states);
 
   /**
-   * Set fields of `state_message` from current admittance controller state.
+   * Calculate 'desired joint states' as above, from the wrenches of the main and the additional
+   * force torque sensors. The gravity compensated wrenches are summed, with the torques taken about
+   * the main sensor frame. The additional sensor frames are computed together with the other
+   * frames, so they only add their own transforms to the kinematics cost.
+   *
+   * \param[in] additional_wrenches most recent measured wrenches of the additional force torque
+   * sensors, in the order of the additional_ft_sensors parameter
+   */
+  controller_interface::return_type update(
+    const trajectory_msgs::msg::JointTrajectoryPoint & current_joint_state,
+    const geometry_msgs::msg::Wrench & measured_wrench,
+    const std::vector<geometry_msgs::msg::Wrench> & additional_wrenches,
+    const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state,
+    const rclcpp::Duration & period,
+    trajectory_msgs::msg::JointTrajectoryPoint & desired_joint_states);
+
+  /**
+   * Calculate the desired joint positions, velocities and accelerations as above, on Eigen vectors
+   * of the caller, e.g. mapped onto its interface values. The reference accelerations are zero.
+   * Nothing is copied besides the joint positions the transforms are computed at.
+   */
+  controller_interface::return_type update(
+    const Eigen::Ref<const Eigen::VectorXd> & current_joint_pos,
+    const geometry_msgs::msg::Wrench & measured_wrench,
+    const std::vector<geometry_msgs::msg::Wrench> & additional_wrenches,
+    const Eigen::Ref<const Eigen::VectorXd> & reference_joint_pos,
+    const Eigen::Ref<const Eigen::VectorXd> & reference_joint_vel, const rclcpp::Duration & period,
+    Eigen::Ref<Eigen::VectorXd> desired_joint_pos, Eigen::Ref<Eigen::VectorXd> desired_joint_vel,
+    Eigen::Ref<Eigen::VectorXd> desired_joint_acc);
+
+  /**
+   * Set fields of `state_message` from current admittance controller state. Once the message has
+   * the sizes of the parameters, e.g. because it was set by a previous call, no memory is
+   * allocated, so the messages rotated by a swapping publisher can be passed.
    *
    * \param[out] state_message message containing target position/vel/accel, wrench, and actual
    * robot state, among other things
    */
-  const control_msgs::msg::AdmittanceControllerState & get_controller_state();
+  void get_controller_state(control_msgs::msg::AdmittanceControllerState & state_message);
 
 public:
   // admittance config parameters
@@ -166,12 +279,12 @@ public:
 protected:
   /**
    * Calculates the admittance rule from given the robot's current joint angles. The admittance
-   * controller state input is updated with the new calculated values. A boolean value is returned
-   * indicating if any of the kinematics plugin calls failed. \param[in] admittance_state contains
-   * all the information needed to calculate the admittance offset \param[in] dt controller period
-   * \param[out] success true if no calls to the kinematics interface fail
+   * controller state input is updated with the new calculated values. The Jacobian computed by
+   * get_all_transforms() at the same joint angles is used for all conversions between joint and
+   * Cartesian space. \param[in] admittance_state contains all the information needed to calculate
+   * the admittance offset \param[in] dt controller period
    */
-  bool calculate_admittance_rule(AdmittanceState & admittance_state, double dt);
+  void calculate_admittance_rule(AdmittanceState & admittance_state, double dt);
 
   /**
    * Updates internal estimate of wrench in world frame `wrench_world_` given the new measurement
@@ -179,15 +292,60 @@ protected:
    * gravity frame to base frame rotation `cog_world_rot`. The `wrench_world_` estimate includes
    * gravity compensation \param[in] measured_wrench  most recent measured wrench from force torque
    * sensor \param[in] sensor_world_rot rotation matrix from world frame to sensor frame \param[in]
-   * cog_world_rot rotation matrix from world frame to center of gravity frame
+   * cog_world_rot rotation matrix from world frame to center of gravity frame \param[in]
+   * additional_wrenches most recent measured wrenches of the additional force torque sensors
    */
   void process_wrench_measurements(
     const geometry_msgs::msg::Wrench & measured_wrench,
     const Eigen::Matrix<double, 3, 3> & sensor_world_rot,
-    const Eigen::Matrix<double, 3, 3> & cog_world_rot);
+    const Eigen::Matrix<double, 3, 3> & cog_world_rot,
+    const std::vector<geometry_msgs::msg::Wrench> & additional_wrenches);
+
+  /**
+   * Rotate `measured_wrench` into the world frame and remove the weight `end_effector_weight` at
+   * `cog_pos` from it. \param[in] sensor_world_rot rotation matrix from world frame to sensor frame
+   * \param[in] cog_world_rot rotation matrix from world frame to center of gravity frame
+   * \return the force and the torque in world frame as columns
+   */
+  static Eigen::Matrix<double, 3, 2> compensate_gravity(
+    const geometry_msgs::msg::Wrench & measured_wrench,
+    const Eigen::Matrix<double, 3, 3> & sensor_world_rot,
+    const Eigen::Matrix<double, 3, 3> & cog_world_rot, const Eigen::Vector3d & cog_pos,
+    const Eigen::Vector3d & end_effector_weight);
+
+  /**
+   * Hand the parameters over to update(), if they changed and updating them without reactivation
+   * is enabled. Called periodically outside of the realtime loop.
+   */
+  void publish_parameters_update();
+
+  /**
+   * Make the parameters taken from parameter_snapshot_ the ones used by update(), and invalidate
+   * the values cached for the previous ones. Realtime-safe.
+   */
+  void use_parameters();
+
+  /// Copy the transforms of the frames used by the admittance rule out of frame_transforms_.
+  void select_admittance_transforms();
 
-  template <typename T1, typename T2>
-  void vec_to_eigen(const std::vector<T1> & data, T2 & matrix);
+  /**
+   * Take the latest transforms and Jacobian of the pipelined kinematics, computed for a previous
+   * update. Realtime-safe.
+   * \return false if there are none yet since the last reset(), nothing is changed then
+   */
+  bool take_pipelined_transforms();
+
+  /// Request the transforms and Jacobian for the next update from the pipelined kinematics.
+  /// Realtime-safe.
+  void request_pipelined_transforms(
+    const Eigen::Ref<const Eigen::VectorXd> & joint_pos,
+    const Eigen::Ref<const Eigen::VectorXd> & ref_joint_pos);
+
+  /// Whether the pipelined kinematics computes the frames of the parameters in use.
+  bool pipelined_kinematics_usable() const;
+
+  /// Compute the transforms and Jacobian of \p request on the helper thread.
+  void compute_pipelined_transforms(const KinematicsRequest & request, KinematicsResult & result);
 
   // number of robot joint
   size_t num_joints_;
@@ -206,14 +364,53 @@ protected:
   // transforms needed for admittance update
   AdmittanceTransforms admittance_transforms_;
 
-  // position of center of gravity in cog_frame
-  Eigen::Vector3d cog_pos_;
+  // parameters handed over to update() by publish_parameters_update(), and the ones it uses,
+  // owned by parameter_snapshot_
+  std::unique_ptr<controller_realtime_tools::ParameterSnapshot<AdmittanceParameters>>
+    parameter_snapshot_;
+  const AdmittanceParameters * admittance_parameters_ = nullptr;
+  // guards parameters_ between the timer and lifecycle transitions
+  std::mutex parameters_mutex_;
+  rclcpp::TimerBase::SharedPtr parameter_update_timer_;
 
-  // force applied to sensor due to weight of end effector
-  Eigen::Vector3d end_effector_weight_;
+  // last computed transforms of the frames in admittance_parameters_->frame_ids
+  std::vector<Eigen::Isometry3d> frame_transforms_;
+  // joint states the cached transforms were computed at, valid only if the computation succeeded
+  Eigen::VectorXd transforms_joint_pos_;
+  Eigen::VectorXd ref_transform_joint_pos_;
+  bool transforms_valid_ = false;
+  bool ref_transform_valid_ = false;
+  // number of updates since the transforms at the current joint state were computed
+  size_t cycles_since_refresh_ = 0;
+
+  // Jacobian of the force torque sensor frame at transforms_joint_pos_, and its damped
+  // least-squares pseudo-inverse (J^T * J + alpha * I)^-1 * J^T
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian_;
+  Eigen::Matrix<double, Eigen::Dynamic, 6> jacobian_inverse_;
+  Eigen::MatrixXd damped_jtj_;
+  Eigen::LDLT<Eigen::MatrixXd> damped_jtj_ldlt_;
+
+  // pipelined kinematics, nullptr unless kinematics.pipelined.enable is set. The helper thread
+  // uses its own instance of the kinematics plugin, for the frames of the parameters at
+  // configuration
+  std::unique_ptr<kinematics_interface::KinematicsInterface> pipelined_kinematics_;
+  std::vector<std::string> pipeline_frame_ids_;
+  std::string pipeline_ft_frame_id_;
+  // only accessed by the helper thread
+  Eigen::MatrixXd pipeline_damped_jtj_;
+  Eigen::LDLT<Eigen::MatrixXd> pipeline_damped_jtj_ldlt_;
+  std::unique_ptr<controller_realtime_tools::PipelinedWorker<KinematicsRequest, KinematicsResult>>
+    kinematics_pipeline_;
+  // results of requests up to this one were made before the last reset()
+  uint64_t pipeline_min_sequence_ = 0;
+  // whether update() runs on the pipelined kinematics
+  bool use_pipelined_kinematics_ = false;
 
-  // ROS
-  control_msgs::msg::AdmittanceControllerState state_message_;
+  // stiffness and damping matrices in base frame, and the control frame rotation they are for
+  Eigen::Matrix<double, 6, 6> stiffness_base_;
+  Eigen::Matrix<double, 6, 6> damping_base_;
+  Eigen::Matrix<double, 3, 3> gains_rot_base_control_;
+  bool gains_valid_ = false;
 };
 
 }  // namespace admittance_controller
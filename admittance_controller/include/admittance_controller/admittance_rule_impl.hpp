@@ -19,21 +19,80 @@
 
 #include "admittance_controller/admittance_rule.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <iterator>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "controller_realtime_tools/tracing.hpp"
 #include "rclcpp/duration.hpp"
 #include "rclcpp/utilities.hpp"
 #include "tf2_ros/transform_listener.h"
 
 namespace admittance_controller
 {
+AdmittanceParameters::AdmittanceParameters(const admittance_controller::Params & parameters)
+: params(parameters)
+{
+  end_effector_weight.setZero();
+  end_effector_weight[2] = -params.gravity_compensation.CoG.force;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    cog_pos[i] = params.gravity_compensation.CoG.pos[i];
+  }
+  for (size_t i = 0; i < 6; ++i)
+  {
+    mass[i] = params.admittance.mass[i];
+    mass_inv[i] = 1.0 / params.admittance.mass[i];
+    stiffness[i] = params.admittance.stiffness[i];
+    selected_axes[i] = params.admittance.selected_axes[i];
+    damping[i] = params.admittance.damping_ratio[i] * 2 * sqrt(mass[i] * stiffness[i]);
+  }
+
+  const auto add_frame = [this](const std::string & frame_id)
+  {
+    const auto it = std::find(frame_ids.begin(), frame_ids.end(), frame_id);
+    if (it != frame_ids.end())
+    {
+      return static_cast<size_t>(std::distance(frame_ids.begin(), it));
+    }
+    frame_ids.push_back(frame_id);
+    return frame_ids.size() - 1;
+  };
+  ft_frame_index = add_frame(params.ft_sensor.frame.id);
+  tip_frame_index = add_frame(params.kinematics.tip);
+  world_frame_index = add_frame(params.fixed_world_frame.frame.id);
+  cog_frame_index = add_frame(params.gravity_compensation.frame.id);
+  control_frame_index = add_frame(params.control.frame.id);
+
+  for (const auto & name : params.additional_ft_sensors)
+  {
+    const auto & sensor_params = params.additional_ft_sensor.additional_ft_sensors_map.at(name);
+    AdditionalFtSensor sensor;
+    sensor.frame_index = add_frame(sensor_params.frame_id);
+    sensor.cog_frame_index = add_frame(sensor_params.gravity_compensation_frame_id);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      sensor.cog_pos[i] = sensor_params.CoG_pos[i];
+    }
+    sensor.end_effector_weight.setZero();
+    sensor.end_effector_weight[2] = -sensor_params.CoG_force;
+    additional_ft_sensors.push_back(sensor);
+  }
+}
+
 /// Configure admittance rule memory for num joints and load kinematics interface
 controller_interface::return_type AdmittanceRule::configure(
   const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node, const size_t num_joints)
 {
   num_joints_ = num_joints;
 
+  // stop the helper thread of the pipelined kinematics before its plugin is unloaded
+  kinematics_pipeline_.reset();
+  pipelined_kinematics_.reset();
+
   // initialize memory and values to zero  (non-realtime function)
   reset(num_joints);
 
@@ -69,39 +128,93 @@ controller_interface::return_type AdmittanceRule::configure(
     return controller_interface::return_type::ERROR;
   }
 
+  // the helper thread of the pipelined kinematics gets an instance of the plugin of its own
+  const auto & pipelined = parameters_.kinematics.pipelined;
+  if (pipelined.enable)
+  {
+    try
+    {
+      pipelined_kinematics_ = std::unique_ptr<kinematics_interface::KinematicsInterface>(
+        kinematics_loader_->createUnmanagedInstance(parameters_.kinematics.plugin_name));
+    }
+    catch (pluginlib::PluginlibException & ex)
+    {
+      RCLCPP_ERROR(
+        rclcpp::get_logger("AdmittanceRule"),
+        "Exception while loading the IK plugin '%s' for the pipelined kinematics: '%s'",
+        parameters_.kinematics.plugin_name.c_str(), ex.what());
+      return controller_interface::return_type::ERROR;
+    }
+    if (!pipelined_kinematics_->initialize(
+          node->get_node_parameters_interface(), parameters_.kinematics.tip))
+    {
+      return controller_interface::return_type::ERROR;
+    }
+    pipeline_frame_ids_ = admittance_parameters_->frame_ids;
+    pipeline_ft_frame_id_ = parameters_.ft_sensor.frame.id;
+    pipeline_damped_jtj_ = Eigen::MatrixXd::Zero(num_joints, num_joints);
+    pipeline_damped_jtj_ldlt_ = Eigen::LDLT<Eigen::MatrixXd>(num_joints);
+
+    KinematicsRequest request;
+    request.joint_pos = Eigen::VectorXd::Zero(num_joints);
+    request.ref_joint_pos = Eigen::VectorXd::Zero(num_joints);
+    KinematicsResult result;
+    result.joint_pos = Eigen::VectorXd::Zero(num_joints);
+    result.ref_joint_pos = Eigen::VectorXd::Zero(num_joints);
+    result.frame_transforms.assign(pipeline_frame_ids_.size(), Eigen::Isometry3d::Identity());
+    result.ref_base_ft = Eigen::Isometry3d::Identity();
+    result.jacobian = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, num_joints);
+    result.jacobian_inverse = Eigen::Matrix<double, Eigen::Dynamic, 6>::Zero(num_joints, 6);
+    kinematics_pipeline_ = std::make_unique<
+      controller_realtime_tools::PipelinedWorker<KinematicsRequest, KinematicsResult>>(
+      [this](const KinematicsRequest & request, KinematicsResult & result)
+      { compute_pipelined_transforms(request, result); },
+      request, result,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(pipelined.poll_period)));
+    if (!kinematics_pipeline_->set_scheduling(controller_realtime_tools::make_thread_scheduling(
+          pipelined.priority, pipelined.cpu_affinity)))
+    {
+      RCLCPP_WARN(
+        rclcpp::get_logger("AdmittanceRule"),
+        "Could not set the scheduling of the pipelined kinematics thread.");
+    }
+    pipeline_min_sequence_ = kinematics_pipeline_->submitted();
+    use_pipelined_kinematics_ = pipelined_kinematics_usable();
+  }
+
+  // check for parameter updates outside of the realtime loop
+  parameter_update_timer_ = node->create_wall_timer(
+    std::chrono::milliseconds(100), [this]() { publish_parameters_update(); });
+
   return controller_interface::return_type::OK;
 }
 
 controller_interface::return_type AdmittanceRule::reset(const size_t num_joints)
 {
-  // reset state message fields
-  state_message_.joint_state.name.assign(num_joints, "");
-  state_message_.joint_state.position.assign(num_joints, 0);
-  state_message_.joint_state.velocity.assign(num_joints, 0);
-  state_message_.joint_state.effort.assign(num_joints, 0);
-  for (size_t i = 0; i < parameters_.joints.size(); ++i)
-  {
-    state_message_.joint_state.name = parameters_.joints;
-  }
-  state_message_.mass.data.resize(6, 0.0);
-  state_message_.selected_axes.data.resize(6, 0);
-  state_message_.damping.data.resize(6, 0);
-  state_message_.stiffness.data.resize(6, 0);
-  state_message_.wrench_base.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_velocity.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_acceleration.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_position.header.frame_id = parameters_.kinematics.base;
-  state_message_.admittance_position.child_frame_id = "admittance_offset";
-
   // reset admittance state
   admittance_state_ = AdmittanceState(num_joints);
 
   // reset transforms and rotations
   admittance_transforms_ = AdmittanceTransforms();
+  transforms_joint_pos_ = Eigen::VectorXd::Zero(num_joints);
+  ref_transform_joint_pos_ = Eigen::VectorXd::Zero(num_joints);
+  // at most one frame per transform, and two per additional force torque sensor
+  frame_transforms_.assign(
+    5 + 2 * parameters_.additional_ft_sensors.size(), Eigen::Isometry3d::Identity());
+  jacobian_ = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, num_joints);
+  jacobian_inverse_ = Eigen::Matrix<double, Eigen::Dynamic, 6>::Zero(num_joints, 6);
+  damped_jtj_ = Eigen::MatrixXd::Zero(num_joints, num_joints);
+  damped_jtj_ldlt_ = Eigen::LDLT<Eigen::MatrixXd>(num_joints);
 
   // reset forces
   wrench_world_.setZero();
-  end_effector_weight_.setZero();
+
+  // the pipelined kinematics computed for the previous activation are stale
+  if (kinematics_pipeline_)
+  {
+    pipeline_min_sequence_ = kinematics_pipeline_->submitted();
+  }
 
   // load/initialize Eigen types from parameters
   apply_parameters_update();
@@ -111,48 +224,179 @@ controller_interface::return_type AdmittanceRule::reset(const size_t num_joints)
 
 void AdmittanceRule::apply_parameters_update()
 {
+  std::lock_guard<std::mutex> guard(parameters_mutex_);
   if (parameter_handler_->is_old(parameters_))
   {
     parameters_ = parameter_handler_->get_params();
   }
-  // update param values
-  end_effector_weight_[2] = -parameters_.gravity_compensation.CoG.force;
-  vec_to_eigen(parameters_.gravity_compensation.CoG.pos, cog_pos_);
-  vec_to_eigen(parameters_.admittance.mass, admittance_state_.mass);
-  vec_to_eigen(parameters_.admittance.stiffness, admittance_state_.stiffness);
-  vec_to_eigen(parameters_.admittance.selected_axes, admittance_state_.selected_axes);
+  // not called while update() runs, so the new parameters can be taken over right away
+  parameter_snapshot_->publish(std::make_unique<const AdmittanceParameters>(parameters_));
+  parameter_snapshot_->update();
+  use_parameters();
+}
 
-  for (size_t i = 0; i < 6; ++i)
+void AdmittanceRule::publish_parameters_update()
+{
+  std::lock_guard<std::mutex> guard(parameters_mutex_);
+  // delete the parameters update() is done with
+  parameter_snapshot_->reclaim();
+  if (
+    !parameters_.enable_parameter_update_without_reactivation ||
+    !parameter_handler_->is_old(parameters_))
+  {
+    return;
+  }
+  parameters_ = parameter_handler_->get_params();
+  parameter_snapshot_->publish(std::make_unique<const AdmittanceParameters>(parameters_));
+}
+
+void AdmittanceRule::use_parameters()
+{
+  admittance_parameters_ = &parameter_snapshot_->get();
+  admittance_state_.mass = admittance_parameters_->mass;
+  admittance_state_.mass_inv = admittance_parameters_->mass_inv;
+  admittance_state_.stiffness = admittance_parameters_->stiffness;
+  admittance_state_.selected_axes = admittance_parameters_->selected_axes;
+  admittance_state_.damping = admittance_parameters_->damping;
+  admittance_state_.ft_sensor_frame = admittance_parameters_->params.ft_sensor.frame.id;
+
+  // the frames or the gains may have changed
+  transforms_valid_ = false;
+  ref_transform_valid_ = false;
+  gains_valid_ = false;
+  use_pipelined_kinematics_ = pipelined_kinematics_usable();
+}
+
+bool AdmittanceRule::pipelined_kinematics_usable() const
+{
+  // comparing the frames doesn't allocate
+  return kinematics_pipeline_ && admittance_parameters_->frame_ids == pipeline_frame_ids_ &&
+         admittance_parameters_->params.ft_sensor.frame.id == pipeline_ft_frame_id_;
+}
+
+void AdmittanceRule::select_admittance_transforms()
+{
+  const AdmittanceParameters & parameters = *admittance_parameters_;
+  admittance_transforms_.base_ft_ = frame_transforms_[parameters.ft_frame_index];
+  admittance_transforms_.base_tip_ = frame_transforms_[parameters.tip_frame_index];
+  admittance_transforms_.world_base_ = frame_transforms_[parameters.world_frame_index];
+  admittance_transforms_.base_cog_ = frame_transforms_[parameters.cog_frame_index];
+  admittance_transforms_.base_control_ = frame_transforms_[parameters.control_frame_index];
+}
+
+bool AdmittanceRule::take_pipelined_transforms()
+{
+  const KinematicsResult * result = kinematics_pipeline_->result(pipeline_min_sequence_);
+  if (!result)
   {
-    admittance_state_.mass_inv[i] = 1.0 / parameters_.admittance.mass[i];
-    admittance_state_.damping[i] = parameters_.admittance.damping_ratio[i] * 2 *
-                                   sqrt(admittance_state_.mass[i] * admittance_state_.stiffness[i]);
+    return false;
   }
+  // the same frames, see pipelined_kinematics_usable()
+  std::copy(
+    result->frame_transforms.begin(), result->frame_transforms.end(), frame_transforms_.begin());
+  jacobian_ = result->jacobian;
+  jacobian_inverse_ = result->jacobian_inverse;
+  transforms_joint_pos_ = result->joint_pos;
+  transforms_valid_ = result->valid;
+  ref_transform_joint_pos_ = result->ref_joint_pos;
+  admittance_transforms_.ref_base_ft_ = result->ref_base_ft;
+  ref_transform_valid_ = result->ref_valid;
+  select_admittance_transforms();
+  return true;
+}
+
+void AdmittanceRule::request_pipelined_transforms(
+  const Eigen::Ref<const Eigen::VectorXd> & joint_pos,
+  const Eigen::Ref<const Eigen::VectorXd> & ref_joint_pos)
+{
+  auto & request = kinematics_pipeline_->request();
+  request.joint_pos = joint_pos;
+  request.ref_joint_pos = ref_joint_pos;
+  request.alpha = admittance_parameters_->params.kinematics.alpha;
+  kinematics_pipeline_->submit();
+}
+
+void AdmittanceRule::compute_pipelined_transforms(
+  const KinematicsRequest & request, KinematicsResult & result)
+{
+  result.joint_pos = request.joint_pos;
+  result.ref_joint_pos = request.ref_joint_pos;
+  result.ref_valid = pipelined_kinematics_->calculate_link_transform(
+    result.ref_joint_pos, pipeline_ft_frame_id_, result.ref_base_ft);
+  result.valid = true;
+  for (size_t i = 0; i < pipeline_frame_ids_.size(); ++i)
+  {
+    result.valid &= pipelined_kinematics_->calculate_link_transform(
+      result.joint_pos, pipeline_frame_ids_[i], result.frame_transforms[i]);
+  }
+  result.valid &= pipelined_kinematics_->calculate_jacobian(
+    result.joint_pos, pipeline_ft_frame_id_, result.jacobian);
+  pipeline_damped_jtj_.noalias() = result.jacobian.transpose() * result.jacobian;
+  pipeline_damped_jtj_.diagonal().array() += request.alpha;
+  pipeline_damped_jtj_ldlt_.compute(pipeline_damped_jtj_);
+  result.jacobian_inverse = pipeline_damped_jtj_ldlt_.solve(result.jacobian.transpose());
 }
 
 bool AdmittanceRule::get_all_transforms(
   const trajectory_msgs::msg::JointTrajectoryPoint & current_joint_state,
   const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state)
 {
-  // get reference transforms
-  bool success = kinematics_->calculate_link_transform(
-    reference_joint_state.positions, parameters_.ft_sensor.frame.id,
-    admittance_transforms_.ref_base_ft_);
+  const auto n = static_cast<Eigen::Index>(num_joints_);
+  return get_all_transforms(
+    Eigen::Map<const Eigen::VectorXd>(current_joint_state.positions.data(), n),
+    Eigen::Map<const Eigen::VectorXd>(reference_joint_state.positions.data(), n));
+}
+
+bool AdmittanceRule::get_all_transforms(
+  const Eigen::Ref<const Eigen::VectorXd> & current_joint_pos,
+  const Eigen::Ref<const Eigen::VectorXd> & reference_joint_pos)
+{
+  const AdmittanceParameters & parameters = *admittance_parameters_;
+  bool success = true;
+
+  // get reference transforms, the joint state is only copied if it changed
+  if (!ref_transform_valid_ || reference_joint_pos != ref_transform_joint_pos_)
+  {
+    ref_transform_joint_pos_ = reference_joint_pos;
+    CONTROLLER_TRACEPOINT(KINEMATICS_BEGIN, this, 0);
+    ref_transform_valid_ = kinematics_->calculate_link_transform(
+      ref_transform_joint_pos_, parameters.params.ft_sensor.frame.id,
+      admittance_transforms_.ref_base_ft_);
+    CONTROLLER_TRACEPOINT(KINEMATICS_END, this, ref_transform_valid_);
+    success &= ref_transform_valid_;
+  }
 
   // get transforms at current configuration
-  success &= kinematics_->calculate_link_transform(
-    current_joint_state.positions, parameters_.ft_sensor.frame.id, admittance_transforms_.base_ft_);
-  success &= kinematics_->calculate_link_transform(
-    current_joint_state.positions, parameters_.kinematics.tip, admittance_transforms_.base_tip_);
-  success &= kinematics_->calculate_link_transform(
-    current_joint_state.positions, parameters_.fixed_world_frame.frame.id,
-    admittance_transforms_.world_base_);
-  success &= kinematics_->calculate_link_transform(
-    current_joint_state.positions, parameters_.gravity_compensation.frame.id,
-    admittance_transforms_.base_cog_);
-  success &= kinematics_->calculate_link_transform(
-    current_joint_state.positions, parameters_.control.frame.id,
-    admittance_transforms_.base_control_);
+  // between refreshes, the admittance rule runs on the transforms and Jacobian of the last one
+  const auto & refresh = parameters.params.kinematics.refresh;
+  ++cycles_since_refresh_;
+  const bool refresh_due =
+    (refresh.cycles > 0 && cycles_since_refresh_ >= static_cast<size_t>(refresh.cycles)) ||
+    (refresh.joint_threshold > 0.0 &&
+     (current_joint_pos - transforms_joint_pos_).cwiseAbs().maxCoeff() > refresh.joint_threshold);
+  if (!transforms_valid_ || (refresh_due && current_joint_pos != transforms_joint_pos_))
+  {
+    cycles_since_refresh_ = 0;
+    transforms_joint_pos_ = current_joint_pos;
+    CONTROLLER_TRACEPOINT(KINEMATICS_BEGIN, this, 0);
+    transforms_valid_ = true;
+    for (size_t i = 0; i < parameters.frame_ids.size(); ++i)
+    {
+      transforms_valid_ &= kinematics_->calculate_link_transform(
+        transforms_joint_pos_, parameters.frame_ids[i], frame_transforms_[i]);
+    }
+
+    // the Jacobian is shared by all conversions between joint and Cartesian deltas in this state
+    transforms_valid_ &= kinematics_->calculate_jacobian(
+      transforms_joint_pos_, parameters.params.ft_sensor.frame.id, jacobian_);
+    CONTROLLER_TRACEPOINT(KINEMATICS_END, this, transforms_valid_);
+    damped_jtj_.noalias() = jacobian_.transpose() * jacobian_;
+    damped_jtj_.diagonal().array() += parameters.params.kinematics.alpha;
+    damped_jtj_ldlt_.compute(damped_jtj_);
+    jacobian_inverse_ = damped_jtj_ldlt_.solve(jacobian_.transpose());
+    success &= transforms_valid_;
+  }
+  select_admittance_transforms();
 
   return success;
 }
@@ -163,22 +407,69 @@ controller_interface::return_type AdmittanceRule::update(
   const geometry_msgs::msg::Wrench & measured_wrench,
   const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state,
   const rclcpp::Duration & period, trajectory_msgs::msg::JointTrajectoryPoint & desired_joint_state)
+{
+  // an empty vector doesn't allocate
+  return update(
+    current_joint_state, measured_wrench, {}, reference_joint_state, period, desired_joint_state);
+}
+
+controller_interface::return_type AdmittanceRule::update(
+  const trajectory_msgs::msg::JointTrajectoryPoint & current_joint_state,
+  const geometry_msgs::msg::Wrench & measured_wrench,
+  const std::vector<geometry_msgs::msg::Wrench> & additional_wrenches,
+  const trajectory_msgs::msg::JointTrajectoryPoint & reference_joint_state,
+  const rclcpp::Duration & period, trajectory_msgs::msg::JointTrajectoryPoint & desired_joint_state)
+{
+  // the message vectors are mapped since their sizes are fixed
+  const auto n = static_cast<Eigen::Index>(num_joints_);
+  const auto result = update(
+    Eigen::Map<const Eigen::VectorXd>(current_joint_state.positions.data(), n), measured_wrench,
+    additional_wrenches,
+    Eigen::Map<const Eigen::VectorXd>(reference_joint_state.positions.data(), n),
+    Eigen::Map<const Eigen::VectorXd>(reference_joint_state.velocities.data(), n), period,
+    Eigen::Map<Eigen::VectorXd>(desired_joint_state.positions.data(), n),
+    Eigen::Map<Eigen::VectorXd>(desired_joint_state.velocities.data(), n),
+    Eigen::Map<Eigen::VectorXd>(desired_joint_state.accelerations.data(), n));
+  if (result != controller_interface::return_type::OK)
+  {
+    desired_joint_state = reference_joint_state;
+    return result;
+  }
+  Eigen::Map<Eigen::VectorXd>(desired_joint_state.accelerations.data(), n) +=
+    Eigen::Map<const Eigen::VectorXd>(reference_joint_state.accelerations.data(), n);
+  return result;
+}
+
+controller_interface::return_type AdmittanceRule::update(
+  const Eigen::Ref<const Eigen::VectorXd> & current_joint_pos,
+  const geometry_msgs::msg::Wrench & measured_wrench,
+  const std::vector<geometry_msgs::msg::Wrench> & additional_wrenches,
+  const Eigen::Ref<const Eigen::VectorXd> & reference_joint_pos,
+  const Eigen::Ref<const Eigen::VectorXd> & reference_joint_vel, const rclcpp::Duration & period,
+  Eigen::Ref<Eigen::VectorXd> desired_joint_pos, Eigen::Ref<Eigen::VectorXd> desired_joint_vel,
+  Eigen::Ref<Eigen::VectorXd> desired_joint_acc)
 {
   const double dt = period.seconds();
 
-  if (parameters_.enable_parameter_update_without_reactivation)
+  // take over parameters updated by publish_parameters_update()
+  if (parameter_snapshot_->update())
   {
-    apply_parameters_update();
+    use_parameters();
   }
 
-  bool success = get_all_transforms(current_joint_state, reference_joint_state);
+  // the pipelined kinematics were computed for the previous update, at the joint positions it
+  // commanded. Until the first ones are done, they are computed here
+  const bool pipelined = use_pipelined_kinematics_ && take_pipelined_transforms();
+  bool success = pipelined ? transforms_valid_ && ref_transform_valid_
+                           : get_all_transforms(current_joint_pos, reference_joint_pos);
 
   // apply filter and update wrench_world_ vector
   Eigen::Matrix<double, 3, 3> rot_world_sensor =
     admittance_transforms_.world_base_.rotation() * admittance_transforms_.base_ft_.rotation();
   Eigen::Matrix<double, 3, 3> rot_world_cog =
     admittance_transforms_.world_base_.rotation() * admittance_transforms_.base_cog_.rotation();
-  process_wrench_measurements(measured_wrench, rot_world_sensor, rot_world_cog);
+  process_wrench_measurements(
+    measured_wrench, rot_world_sensor, rot_world_cog, additional_wrenches);
 
   // transform wrench_world_ into base frame
   admittance_state_.wrench_base.block<3, 1>(0, 0) =
@@ -187,68 +478,76 @@ controller_interface::return_type AdmittanceRule::update(
     admittance_transforms_.world_base_.rotation().transpose() * wrench_world_.block<3, 1>(3, 0);
 
   // Compute admittance control law
-  vec_to_eigen(current_joint_state.positions, admittance_state_.current_joint_pos);
   admittance_state_.rot_base_control = admittance_transforms_.base_control_.rotation();
   admittance_state_.ref_trans_base_ft = admittance_transforms_.ref_base_ft_;
-  admittance_state_.ft_sensor_frame = parameters_.ft_sensor.frame.id;
-  success &= calculate_admittance_rule(admittance_state_, dt);
+  admittance_state_.trans_base_ft = admittance_transforms_.base_ft_;
+  calculate_admittance_rule(admittance_state_, dt);
 
   // if a failure occurred during any kinematics interface calls, return an error and don't
   // modify the desired reference
   if (!success)
   {
-    desired_joint_state = reference_joint_state;
+    desired_joint_pos = reference_joint_pos;
+    desired_joint_vel = reference_joint_vel;
+    desired_joint_acc.setZero();
+    if (use_pipelined_kinematics_)
+    {
+      request_pipelined_transforms(current_joint_pos, reference_joint_pos);
+    }
     return controller_interface::return_type::ERROR;
   }
 
   // update joint desired joint state
-  for (size_t i = 0; i < num_joints_; ++i)
+  desired_joint_pos = reference_joint_pos + admittance_state_.joint_pos;
+  desired_joint_vel = reference_joint_vel + admittance_state_.joint_vel;
+  desired_joint_acc = admittance_state_.joint_acc;
+
+  // the commanded joint positions are where the robot is expected in the next update
+  if (use_pipelined_kinematics_)
   {
-    desired_joint_state.positions[i] =
-      reference_joint_state.positions[i] + admittance_state_.joint_pos[i];
-    desired_joint_state.velocities[i] =
-      reference_joint_state.velocities[i] + admittance_state_.joint_vel[i];
-    desired_joint_state.accelerations[i] =
-      reference_joint_state.accelerations[i] + admittance_state_.joint_acc[i];
+    request_pipelined_transforms(desired_joint_pos, reference_joint_pos);
   }
 
   return controller_interface::return_type::OK;
 }
 
-bool AdmittanceRule::calculate_admittance_rule(AdmittanceState & admittance_state, double dt)
+void AdmittanceRule::calculate_admittance_rule(AdmittanceState & admittance_state, double dt)
 {
   // Create stiffness matrix in base frame. The user-provided values of admittance_state.stiffness
-  // correspond to the six diagonal elements of the stiffness matrix expressed in the control frame
-  auto rot_base_control = admittance_state.rot_base_control;
-  Eigen::Matrix<double, 6, 6> K = Eigen::Matrix<double, 6, 6>::Zero();
-  Eigen::Matrix<double, 3, 3> K_pos = Eigen::Matrix<double, 3, 3>::Zero();
-  Eigen::Matrix<double, 3, 3> K_rot = Eigen::Matrix<double, 3, 3>::Zero();
-  K_pos.diagonal() = admittance_state.stiffness.block<3, 1>(0, 0);
-  K_rot.diagonal() = admittance_state.stiffness.block<3, 1>(3, 0);
-  // Transform to the control frame
-  // A reference is here:  https://users.wpi.edu/~jfu2/rbe502/files/force_control.pdf
-  // Force Control by Luigi Villani and Joris De Schutter
-  // Page 200
-  K_pos = rot_base_control * K_pos * rot_base_control.transpose();
-  K_rot = rot_base_control * K_rot * rot_base_control.transpose();
-  K.block<3, 3>(0, 0) = K_pos;
-  K.block<3, 3>(3, 3) = K_rot;
-
-  // The same for damping
-  Eigen::Matrix<double, 6, 6> D = Eigen::Matrix<double, 6, 6>::Zero();
-  Eigen::Matrix<double, 3, 3> D_pos = Eigen::Matrix<double, 3, 3>::Zero();
-  Eigen::Matrix<double, 3, 3> D_rot = Eigen::Matrix<double, 3, 3>::Zero();
-  D_pos.diagonal() = admittance_state.damping.block<3, 1>(0, 0);
-  D_rot.diagonal() = admittance_state.damping.block<3, 1>(3, 0);
-  D_pos = rot_base_control * D_pos * rot_base_control.transpose();
-  D_rot = rot_base_control * D_rot * rot_base_control.transpose();
-  D.block<3, 3>(0, 0) = D_pos;
-  D.block<3, 3>(3, 3) = D_rot;
+  // correspond to the six diagonal elements of the stiffness matrix expressed in the control frame.
+  // The matrices only change with the parameters or the control frame orientation.
+  const auto & rot_base_control = admittance_state.rot_base_control;
+  if (!gains_valid_ || rot_base_control != gains_rot_base_control_)
+  {
+    // Transform to the control frame
+    // A reference is here:  https://users.wpi.edu/~jfu2/rbe502/files/force_control.pdf
+    // Force Control by Luigi Villani and Joris De Schutter
+    // Page 200
+    stiffness_base_.setZero();
+    stiffness_base_.block<3, 3>(0, 0) = rot_base_control *
+                                        admittance_state.stiffness.block<3, 1>(0, 0).asDiagonal() *
+                                        rot_base_control.transpose();
+    stiffness_base_.block<3, 3>(3, 3) = rot_base_control *
+                                        admittance_state.stiffness.block<3, 1>(3, 0).asDiagonal() *
+                                        rot_base_control.transpose();
+
+    // The same for damping
+    damping_base_.setZero();
+    damping_base_.block<3, 3>(0, 0) = rot_base_control *
+                                      admittance_state.damping.block<3, 1>(0, 0).asDiagonal() *
+                                      rot_base_control.transpose();
+    damping_base_.block<3, 3>(3, 3) = rot_base_control *
+                                      admittance_state.damping.block<3, 1>(3, 0).asDiagonal() *
+                                      rot_base_control.transpose();
+
+    gains_rot_base_control_ = rot_base_control;
+    gains_valid_ = true;
+  }
+  const auto & K = stiffness_base_;
+  const auto & D = damping_base_;
 
   // calculate admittance relative offset in base frame
-  Eigen::Isometry3d desired_trans_base_ft;
-  kinematics_->calculate_link_transform(
-    admittance_state.current_joint_pos, admittance_state.ft_sensor_frame, desired_trans_base_ft);
+  const Eigen::Isometry3d & desired_trans_base_ft = admittance_state.trans_base_ft;
   Eigen::Matrix<double, 6, 1> X;
   X.block<3, 1>(0, 0) =
     desired_trans_base_ft.translation() - admittance_state.ref_trans_base_ft.translation();
@@ -275,36 +574,61 @@ bool AdmittanceRule::calculate_admittance_rule(AdmittanceState & admittance_stat
   // Compute admittance control law in the base frame: F = M*x_ddot + D*x_dot + K*x
   Eigen::Matrix<double, 6, 1> X_ddot =
     admittance_state.mass_inv.cwiseProduct(F_base - D * X_dot - K * X);
-  bool success = kinematics_->convert_cartesian_deltas_to_joint_deltas(
-    admittance_state.current_joint_pos, X_ddot, admittance_state.ft_sensor_frame,
-    admittance_state.joint_acc);
+  admittance_state.joint_acc.noalias() = jacobian_inverse_ * X_ddot;
 
   // add damping if cartesian velocity falls below threshold
-  for (int64_t i = 0; i < admittance_state.joint_acc.size(); ++i)
-  {
-    admittance_state.joint_acc[i] -=
-      parameters_.admittance.joint_damping * admittance_state.joint_vel[i];
-  }
+  admittance_state.joint_acc -=
+    admittance_parameters_->params.admittance.joint_damping * admittance_state.joint_vel;
 
   // integrate motion in joint space
   admittance_state.joint_vel += (admittance_state.joint_acc) * dt;
   admittance_state.joint_pos += admittance_state.joint_vel * dt;
 
   // calculate admittance velocity corresponding to joint velocity ("base_link" frame)
-  success &= kinematics_->convert_joint_deltas_to_cartesian_deltas(
-    admittance_state.current_joint_pos, admittance_state.joint_vel,
-    admittance_state.ft_sensor_frame, admittance_state.admittance_velocity);
-  success &= kinematics_->convert_joint_deltas_to_cartesian_deltas(
-    admittance_state.current_joint_pos, admittance_state.joint_acc,
-    admittance_state.ft_sensor_frame, admittance_state.admittance_acceleration);
-
-  return success;
+  admittance_state.admittance_velocity.noalias() = jacobian_ * admittance_state.joint_vel;
+  admittance_state.admittance_acceleration.noalias() = jacobian_ * admittance_state.joint_acc;
 }
 
 void AdmittanceRule::process_wrench_measurements(
   const geometry_msgs::msg::Wrench & measured_wrench,
   const Eigen::Matrix<double, 3, 3> & sensor_world_rot,
-  const Eigen::Matrix<double, 3, 3> & cog_world_rot)
+  const Eigen::Matrix<double, 3, 3> & cog_world_rot,
+  const std::vector<geometry_msgs::msg::Wrench> & additional_wrenches)
+{
+  Eigen::Matrix<double, 3, 2> new_wrench_base = compensate_gravity(
+    measured_wrench, sensor_world_rot, cog_world_rot, admittance_parameters_->cog_pos,
+    admittance_parameters_->end_effector_weight);
+
+  // add the wrenches of the additional sensors, their forces also act on the main sensor frame
+  const Eigen::Matrix3d world_base_rot = admittance_transforms_.world_base_.rotation();
+  const auto & sensors = admittance_parameters_->additional_ft_sensors;
+  for (size_t i = 0; i < std::min(sensors.size(), additional_wrenches.size()); ++i)
+  {
+    const Eigen::Isometry3d & base_sensor = frame_transforms_[sensors[i].frame_index];
+    const Eigen::Matrix<double, 3, 2> sensor_wrench = compensate_gravity(
+      additional_wrenches[i], world_base_rot * base_sensor.rotation(),
+      world_base_rot * frame_transforms_[sensors[i].cog_frame_index].rotation(),
+      sensors[i].cog_pos, sensors[i].end_effector_weight);
+    const Eigen::Vector3d lever =
+      world_base_rot * (base_sensor.translation() - admittance_transforms_.base_ft_.translation());
+    new_wrench_base.col(0) += sensor_wrench.col(0);
+    new_wrench_base.col(1) += sensor_wrench.col(1) + lever.cross(sensor_wrench.col(0));
+  }
+
+  // apply smoothing filter
+  for (size_t i = 0; i < 6; ++i)
+  {
+    wrench_world_(i) = filters::exponentialSmoothing(
+      new_wrench_base(i), wrench_world_(i),
+      admittance_parameters_->params.ft_sensor.filter_coefficient);
+  }
+}
+
+Eigen::Matrix<double, 3, 2> AdmittanceRule::compensate_gravity(
+  const geometry_msgs::msg::Wrench & measured_wrench,
+  const Eigen::Matrix<double, 3, 3> & sensor_world_rot,
+  const Eigen::Matrix<double, 3, 3> & cog_world_rot, const Eigen::Vector3d & cog_pos,
+  const Eigen::Vector3d & end_effector_weight)
 {
   Eigen::Matrix<double, 3, 2, Eigen::ColMajor> new_wrench;
   new_wrench(0, 0) = measured_wrench.force.x;
@@ -318,86 +642,89 @@ void AdmittanceRule::process_wrench_measurements(
   Eigen::Matrix<double, 3, 2> new_wrench_base = sensor_world_rot * new_wrench;
 
   // apply gravity compensation
-  new_wrench_base(2, 0) -= end_effector_weight_[2];
-  new_wrench_base.block<3, 1>(0, 1) -= (cog_world_rot * cog_pos_).cross(end_effector_weight_);
+  new_wrench_base(2, 0) -= end_effector_weight[2];
+  new_wrench_base.block<3, 1>(0, 1) -= (cog_world_rot * cog_pos).cross(end_effector_weight);
 
-  // apply smoothing filter
-  for (size_t i = 0; i < 6; ++i)
-  {
-    wrench_world_(i) = filters::exponentialSmoothing(
-      new_wrench_base(i), wrench_world_(i), parameters_.ft_sensor.filter_coefficient);
-  }
+  return new_wrench_base;
 }
 
-const control_msgs::msg::AdmittanceControllerState & AdmittanceRule::get_controller_state()
+void AdmittanceRule::get_controller_state(
+  control_msgs::msg::AdmittanceControllerState & state_message)
 {
-  for (size_t i = 0; i < parameters_.joints.size(); ++i)
+  const auto & params = admittance_parameters_->params;
+  const size_t num_joints = params.joints.size();
+
+  // the fields which only depend on the parameters, assigning them reuses the capacity of the
+  // message once it has the sizes of the parameters
+  state_message.joint_state.name = params.joints;
+  state_message.joint_state.position.resize(num_joints, 0.0);
+  state_message.joint_state.velocity.resize(num_joints, 0.0);
+  state_message.joint_state.effort.resize(num_joints, 0.0);
+  state_message.mass.data.resize(6, 0.0);
+  state_message.selected_axes.data.resize(6, 0);
+  state_message.damping.data.resize(6, 0.0);
+  state_message.stiffness.data.resize(6, 0.0);
+  state_message.wrench_base.header.frame_id = params.kinematics.base;
+  state_message.admittance_velocity.header.frame_id = params.kinematics.base;
+  state_message.admittance_acceleration.header.frame_id = params.kinematics.base;
+  state_message.admittance_position.header.frame_id = params.kinematics.base;
+  state_message.admittance_position.child_frame_id = "admittance_offset";
+  state_message.ref_trans_base_ft.header.frame_id = params.kinematics.base;
+  state_message.ref_trans_base_ft.child_frame_id = "ft_reference";
+  state_message.ft_sensor_frame.data = admittance_state_.ft_sensor_frame;
+
+  for (size_t i = 0; i < num_joints; ++i)
   {
-    state_message_.joint_state.name[i] = parameters_.joints[i];
-    state_message_.joint_state.position[i] = admittance_state_.joint_pos[i];
-    state_message_.joint_state.velocity[i] = admittance_state_.joint_vel[i];
-    state_message_.joint_state.effort[i] = admittance_state_.joint_acc[i];
-    state_message_.stiffness.data[i] = admittance_state_.stiffness[i];
-    state_message_.damping.data[i] = admittance_state_.damping[i];
-    state_message_.selected_axes.data[i] = static_cast<bool>(admittance_state_.selected_axes[i]);
-    state_message_.mass.data[i] = admittance_state_.mass[i];
+    state_message.joint_state.position[i] = admittance_state_.joint_pos[i];
+    state_message.joint_state.velocity[i] = admittance_state_.joint_vel[i];
+    state_message.joint_state.effort[i] = admittance_state_.joint_acc[i];
+  }
+  for (size_t i = 0; i < 6; ++i)
+  {
+    state_message.stiffness.data[i] = admittance_state_.stiffness[i];
+    state_message.damping.data[i] = admittance_state_.damping[i];
+    state_message.selected_axes.data[i] = static_cast<bool>(admittance_state_.selected_axes[i]);
+    state_message.mass.data[i] = admittance_state_.mass[i];
   }
 
-  state_message_.wrench_base.wrench.force.x = admittance_state_.wrench_base[0];
-  state_message_.wrench_base.wrench.force.y = admittance_state_.wrench_base[1];
-  state_message_.wrench_base.wrench.force.z = admittance_state_.wrench_base[2];
-  state_message_.wrench_base.wrench.torque.x = admittance_state_.wrench_base[3];
-  state_message_.wrench_base.wrench.torque.y = admittance_state_.wrench_base[4];
-  state_message_.wrench_base.wrench.torque.z = admittance_state_.wrench_base[5];
-
-  state_message_.admittance_velocity.twist.linear.x = admittance_state_.admittance_velocity[0];
-  state_message_.admittance_velocity.twist.linear.y = admittance_state_.admittance_velocity[1];
-  state_message_.admittance_velocity.twist.linear.z = admittance_state_.admittance_velocity[2];
-  state_message_.admittance_velocity.twist.angular.x = admittance_state_.admittance_velocity[3];
-  state_message_.admittance_velocity.twist.angular.y = admittance_state_.admittance_velocity[4];
-  state_message_.admittance_velocity.twist.angular.z = admittance_state_.admittance_velocity[5];
-
-  state_message_.admittance_acceleration.twist.linear.x =
+  state_message.wrench_base.wrench.force.x = admittance_state_.wrench_base[0];
+  state_message.wrench_base.wrench.force.y = admittance_state_.wrench_base[1];
+  state_message.wrench_base.wrench.force.z = admittance_state_.wrench_base[2];
+  state_message.wrench_base.wrench.torque.x = admittance_state_.wrench_base[3];
+  state_message.wrench_base.wrench.torque.y = admittance_state_.wrench_base[4];
+  state_message.wrench_base.wrench.torque.z = admittance_state_.wrench_base[5];
+
+  state_message.admittance_velocity.twist.linear.x = admittance_state_.admittance_velocity[0];
+  state_message.admittance_velocity.twist.linear.y = admittance_state_.admittance_velocity[1];
+  state_message.admittance_velocity.twist.linear.z = admittance_state_.admittance_velocity[2];
+  state_message.admittance_velocity.twist.angular.x = admittance_state_.admittance_velocity[3];
+  state_message.admittance_velocity.twist.angular.y = admittance_state_.admittance_velocity[4];
+  state_message.admittance_velocity.twist.angular.z = admittance_state_.admittance_velocity[5];
+
+  state_message.admittance_acceleration.twist.linear.x =
     admittance_state_.admittance_acceleration[0];
-  state_message_.admittance_acceleration.twist.linear.y =
+  state_message.admittance_acceleration.twist.linear.y =
     admittance_state_.admittance_acceleration[1];
-  state_message_.admittance_acceleration.twist.linear.z =
+  state_message.admittance_acceleration.twist.linear.z =
     admittance_state_.admittance_acceleration[2];
-  state_message_.admittance_acceleration.twist.angular.x =
+  state_message.admittance_acceleration.twist.angular.x =
     admittance_state_.admittance_acceleration[3];
-  state_message_.admittance_acceleration.twist.angular.y =
+  state_message.admittance_acceleration.twist.angular.y =
     admittance_state_.admittance_acceleration[4];
-  state_message_.admittance_acceleration.twist.angular.z =
+  state_message.admittance_acceleration.twist.angular.z =
     admittance_state_.admittance_acceleration[5];
 
-  state_message_.admittance_position = tf2::eigenToTransform(admittance_state_.admittance_position);
-
-  state_message_.ref_trans_base_ft.header.frame_id = parameters_.kinematics.base;
-  state_message_.ref_trans_base_ft.header.frame_id = "ft_reference";
-  state_message_.ref_trans_base_ft = tf2::eigenToTransform(admittance_state_.ref_trans_base_ft);
+  // only the transforms, eigenToTransform() leaves the frame ids empty
+  state_message.admittance_position.transform =
+    tf2::eigenToTransform(admittance_state_.admittance_position).transform;
+  state_message.ref_trans_base_ft.transform =
+    tf2::eigenToTransform(admittance_state_.ref_trans_base_ft).transform;
 
   Eigen::Quaterniond quat(admittance_state_.rot_base_control);
-  state_message_.rot_base_control.w = quat.w();
-  state_message_.rot_base_control.x = quat.x();
-  state_message_.rot_base_control.y = quat.y();
-  state_message_.rot_base_control.z = quat.z();
-
-  state_message_.ft_sensor_frame.data =
-    admittance_state_.ft_sensor_frame;  // TODO(anyone) remove dynamic allocation here
-
-  return state_message_;
-}
-
-template <typename T1, typename T2>
-void AdmittanceRule::vec_to_eigen(const std::vector<T1> & data, T2 & matrix)
-{
-  for (auto col = 0; col < matrix.cols(); col++)
-  {
-    for (auto row = 0; row < matrix.rows(); row++)
-    {
-      matrix(row, col) = data[row + col * matrix.rows()];
-    }
-  }
+  state_message.rot_base_control.w = quat.w();
+  state_message.rot_base_control.x = quat.x();
+  state_message.rot_base_control.y = quat.y();
+  state_message.rot_base_control.z = quat.z();
 }
 
 }  // namespace admittance_controller
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ADMITTANCE_CONTROLLER__ANALYTIC_KINEMATICS_HPP_
+#define ADMITTANCE_CONTROLLER__ANALYTIC_KINEMATICS_HPP_
+
+#include <Eigen/Cholesky>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "admittance_controller/visibility_control.h"
+#include "kinematics_interface/kinematics_interface.hpp"
+#include "rclcpp/node_interfaces/node_parameters_interface.hpp"
+
+namespace admittance_controller
+{
+/**
+ * \brief Kinematics of a serial chain in closed form, with the constants of its joints taken from
+ * the URDF at initialization.
+ *
+ * The chain from the root link of the parameter robot_description to the end effector is reduced
+ * to the fixed origin and the axis of each joint. One pass over the joints computes the transforms
+ * of all links of the chain and the axes of the joints in the root frame, and the geometric
+ * Jacobian of a link follows from them column by column. Unlike with KDL, no generic chain solver
+ * is involved and the pass is cached, so the transforms and the Jacobians of several links at the
+ * same joint state, as the admittance rule requests them, cost a single pass. Nothing is allocated
+ * after initialization.
+ *
+ * Like the KDL plugin, the links of the chain from the root link to the end effector are known,
+ * and the pseudo-inverse of the Jacobian is damped with the parameter alpha.
+ * Selected with kinematics.plugin_name admittance_controller/AnalyticKinematics and
+ * kinematics.plugin_package kinematics_interface.
+ */
+class AnalyticKinematics : public kinematics_interface::KinematicsInterface
+{
+public:
+  ADMITTANCE_CONTROLLER_PUBLIC
+  bool initialize(
+    std::shared_ptr<rclcpp::node_interfaces::NodeParametersInterface> parameters_interface,
+    const std::string & end_effector_name) override;
+
+  /// Initialize with the URDF \p robot_description, without parameters. Not realtime-safe.
+  ADMITTANCE_CONTROLLER_PUBLIC
+  bool initialize_from_urdf(
+    const std::string & robot_description, const std::string & end_effector_name, double alpha);
+
+  ADMITTANCE_CONTROLLER_PUBLIC
+  bool convert_cartesian_deltas_to_joint_deltas(
+    const Eigen::VectorXd & joint_pos, const Eigen::Matrix<double, 6, 1> & delta_x,
+    const std::string & link_name, Eigen::VectorXd & delta_theta) override;
+
+  ADMITTANCE_CONTROLLER_PUBLIC
+  bool convert_joint_deltas_to_cartesian_deltas(
+    const Eigen::VectorXd & joint_pos, const Eigen::VectorXd & delta_theta,
+    const std::string & link_name, Eigen::Matrix<double, 6, 1> & delta_x) override;
+
+  ADMITTANCE_CONTROLLER_PUBLIC
+  bool calculate_link_transform(
+    const Eigen::VectorXd & joint_pos, const std::string & link_name,
+    Eigen::Isometry3d & transform) override;
+
+  ADMITTANCE_CONTROLLER_PUBLIC
+  bool calculate_jacobian(
+    const Eigen::VectorXd & joint_pos, const std::string & link_name,
+    Eigen::Matrix<double, 6, Eigen::Dynamic> & jacobian) override;
+
+  /// Number of moving joints of the chain, 0 before initialization
+  size_t get_num_joints() const { return num_joints_; }
+
+private:
+  /// Joint of the chain, moving its child link relative to its parent link
+  struct Segment
+  {
+    // transform from the parent link to the joint frame
+    Eigen::Isometry3d origin;
+    // unit axis of the joint in the joint frame
+    Eigen::Vector3d axis;
+    // index of the joint in the joint state, -1 for fixed joints
+    int joint_index;
+    bool prismatic;
+  };
+
+  /// Compute the link transforms and joint axes at \p joint_pos, unless they are cached.
+  /// \return false if \p joint_pos doesn't fit the chain
+  bool update(const Eigen::VectorXd & joint_pos);
+
+  /// Index of \p link_name in link_transforms_, or nullptr if it isn't a link of the chain
+  const size_t * find_link(const std::string & link_name) const;
+
+  /// Geometric Jacobian of the link at \p link_index into jacobian_, after update()
+  void compute_jacobian(size_t link_index);
+
+  std::vector<Segment> segments_;
+  // index in link_transforms_ of every link, 0 for the root link and k + 1 for the child of
+  // segments_[k]
+  std::unordered_map<std::string, size_t> link_indices_;
+  size_t num_joints_ = 0;
+  double alpha_ = 0.000005;
+
+  // joint state the cached values below were computed at
+  Eigen::VectorXd cached_joint_pos_;
+  bool cache_valid_ = false;
+  // transforms from the root link to each link
+  std::vector<Eigen::Isometry3d> link_transforms_;
+  // axis and origin of each moving joint in the root frame
+  Eigen::Matrix<double, 3, Eigen::Dynamic> joint_axes_;
+  Eigen::Matrix<double, 3, Eigen::Dynamic> joint_origins_;
+
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian_;
+  Eigen::MatrixXd damped_jtj_;
+  Eigen::LDLT<Eigen::MatrixXd> damped_jtj_ldlt_;
+};
+
+}  // namespace admittance_controller
+
+#endif  // ADMITTANCE_CONTROLLER__ANALYTIC_KINEMATICS_HPP_
@@ -0,0 +1,179 @@
+// Copyright (c) 2024, ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ADMITTANCE_CONTROLLER__WRENCH_FILTER_CHAIN_HPP_
+#define ADMITTANCE_CONTROLLER__WRENCH_FILTER_CHAIN_HPP_
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "control_toolbox/filters.hpp"
+#include "geometry_msgs/msg/wrench.hpp"
+
+namespace admittance_controller
+{
+/**
+ * \brief Filters applied in order to the raw wrench of the force torque sensor.
+ *
+ * The supported filters are:
+ * - "low_pass": exponential smoothing, starting from the first measurement
+ * - "deadband": shrinks each force and torque component towards zero by a threshold
+ * - "moving_average": mean over the last measurements in a fixed-size window
+ *
+ * configure() allocates all memory, reset() and update() are realtime-safe.
+ */
+class WrenchFilterChain
+{
+public:
+  using Wrench = Eigen::Matrix<double, 6, 1>;
+
+  /// Configure the filters from their names in order. Not realtime-safe.
+  /**
+   * \return false if a filter name is unknown, the chain is left empty then.
+   */
+  bool configure(
+    const std::vector<std::string> & filters, double low_pass_coefficient, double force_deadband,
+    double torque_deadband, size_t moving_average_window)
+  {
+    stages_.clear();
+    for (const auto & filter : filters)
+    {
+      Stage stage;
+      if (filter == "low_pass")
+      {
+        stage.type = StageType::LOW_PASS;
+      }
+      else if (filter == "deadband")
+      {
+        stage.type = StageType::DEADBAND;
+      }
+      else if (filter == "moving_average")
+      {
+        stage.type = StageType::MOVING_AVERAGE;
+        stage.window.assign(std::max<size_t>(moving_average_window, 1), Wrench::Zero());
+      }
+      else
+      {
+        stages_.clear();
+        return false;
+      }
+      stages_.push_back(stage);
+    }
+    low_pass_coefficient_ = low_pass_coefficient;
+    deadband_ << force_deadband, force_deadband, force_deadband, torque_deadband,
+      torque_deadband, torque_deadband;
+    reset();
+    return true;
+  }
+
+  /// Forget the previous measurements.
+  void reset()
+  {
+    for (auto & stage : stages_)
+    {
+      stage.count = 0;
+      stage.next = 0;
+    }
+  }
+
+  /// Filter \p wrench in place.
+  void update(Wrench & wrench)
+  {
+    for (auto & stage : stages_)
+    {
+      switch (stage.type)
+      {
+        case StageType::LOW_PASS:
+          if (stage.count > 0)
+          {
+            for (Eigen::Index i = 0; i < 6; ++i)
+            {
+              wrench[i] = filters::exponentialSmoothing(
+                wrench[i], stage.last_value[i], low_pass_coefficient_);
+            }
+          }
+          stage.last_value = wrench;
+          stage.count = 1;
+          break;
+        case StageType::DEADBAND:
+          for (Eigen::Index i = 0; i < 6; ++i)
+          {
+            wrench[i] = std::copysign(std::max(std::abs(wrench[i]) - deadband_[i], 0.0), wrench[i]);
+          }
+          break;
+        case StageType::MOVING_AVERAGE:
+          stage.window[stage.next] = wrench;
+          stage.next = (stage.next + 1) % stage.window.size();
+          stage.count = std::min(stage.count + 1, stage.window.size());
+          wrench.setZero();
+          for (size_t i = 0; i < stage.count; ++i)
+          {
+            wrench += stage.window[i];
+          }
+          wrench /= static_cast<double>(stage.count);
+          break;
+      }
+    }
+  }
+
+  /// Filter \p wrench in place.
+  void update(geometry_msgs::msg::Wrench & wrench)
+  {
+    if (stages_.empty())
+    {
+      return;
+    }
+    Wrench values;
+    values << wrench.force.x, wrench.force.y, wrench.force.z, wrench.torque.x, wrench.torque.y,
+      wrench.torque.z;
+    update(values);
+    wrench.force.x = values[0];
+    wrench.force.y = values[1];
+    wrench.force.z = values[2];
+    wrench.torque.x = values[3];
+    wrench.torque.y = values[4];
+    wrench.torque.z = values[5];
+  }
+
+private:
+  enum class StageType
+  {
+    LOW_PASS,
+    DEADBAND,
+    MOVING_AVERAGE
+  };
+
+  struct Stage
+  {
+    StageType type = StageType::LOW_PASS;
+    // last output of a low pass
+    Wrench last_value = Wrench::Zero();
+    // last measurements of a moving average, the oldest one is overwritten at next
+    std::vector<Wrench> window;
+    size_t next = 0;
+    // number of measurements since the last reset, up to the window size
+    size_t count = 0;
+  };
+
+  std::vector<Stage> stages_;
+  double low_pass_coefficient_ = 1.0;
+  Wrench deadband_ = Wrench::Zero();
+};
+
+}  // namespace admittance_controller
+
+#endif  // ADMITTANCE_CONTROLLER__WRENCH_FILTER_CHAIN_HPP_
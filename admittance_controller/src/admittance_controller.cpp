@@ -16,14 +16,18 @@
 
 #include "admittance_controller/admittance_controller.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "admittance_controller/admittance_rule_impl.hpp"
+#include "controller_realtime_tools/tracing.hpp"
 #include "geometry_msgs/msg/wrench.hpp"
 #include "rcutils/logging_macros.h"
 #include "tf2_ros/buffer.h"
@@ -50,13 +54,9 @@ controller_interface::CallbackReturn AdmittanceController::on_init()
   num_joints_ = admittance_->parameters_.joints.size();
 
   // allocate dynamic memory
-  last_reference_.positions.assign(num_joints_, 0.0);
-  last_reference_.velocities.assign(num_joints_, 0.0);
-  last_reference_.accelerations.assign(num_joints_, 0.0);
-  last_commanded_ = last_reference_;
-  reference_ = last_reference_;
-  reference_admittance_ = last_reference_;
-  joint_state_ = last_reference_;
+  reference_.resize(num_joints_);
+  reference_admittance_.resize(num_joints_);
+  joint_state_.resize(num_joints_);
 
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -93,9 +93,20 @@ controller_interface::InterfaceConfiguration AdmittanceController::state_interfa
     }
   }
 
-  auto ft_interfaces = force_torque_sensor_->get_state_interface_names();
-  state_interfaces_config_names.insert(
-    state_interfaces_config_names.end(), ft_interfaces.begin(), ft_interfaces.end());
+  std::vector<std::string> ft_interfaces;
+  // otherwise a preceding controller writes the wrench to the reference interfaces
+  if (!admittance_->parameters_.ft_sensor.use_reference_interfaces)
+  {
+    ft_interfaces = force_torque_sensor_->get_state_interface_names();
+    state_interfaces_config_names.insert(
+      state_interfaces_config_names.end(), ft_interfaces.begin(), ft_interfaces.end());
+  }
+  for (const auto & sensor : additional_force_torque_sensors_)
+  {
+    ft_interfaces = sensor->get_state_interface_names();
+    state_interfaces_config_names.insert(
+      state_interfaces_config_names.end(), ft_interfaces.begin(), ft_interfaces.end());
+  }
 
   return {
     controller_interface::interface_configuration_type::INDIVIDUAL, state_interfaces_config_names};
@@ -111,9 +122,14 @@ AdmittanceController::on_export_reference_interfaces()
   }
 
   std::vector<hardware_interface::CommandInterface> chainable_command_interfaces;
-  const auto num_chainable_interfaces =
-    admittance_->parameters_.chainable_command_interfaces.size() *
-    admittance_->parameters_.joints.size();
+  const auto num_joint_references = admittance_->parameters_.chainable_command_interfaces.size() *
+                                    admittance_->parameters_.joints.size();
+  const std::vector<std::string> wrench_interfaces =
+    admittance_->parameters_.ft_sensor.use_reference_interfaces
+      ? std::vector<std::string>{"force.x",  "force.y",  "force.z",
+                                 "torque.x", "torque.y", "torque.z"}
+      : std::vector<std::string>{};
+  const auto num_chainable_interfaces = num_joint_references + wrench_interfaces.size();
 
   // allocate dynamic memory
   chainable_command_interfaces.reserve(num_chainable_interfaces);
@@ -141,6 +157,16 @@ AdmittanceController::on_export_reference_interfaces()
     }
   }
 
+  // the wrench of the force torque sensor follows the joint references
+  wrench_reference_index_ = index;
+  for (const auto & interface : wrench_interfaces)
+  {
+    const auto full_name = admittance_->parameters_.ft_sensor.name + "/" + interface;
+    chainable_command_interfaces.emplace_back(hardware_interface::CommandInterface(
+      std::string(get_node()->get_name()), full_name, reference_interfaces_.data() + index));
+    index++;
+  }
+
   return chainable_command_interfaces;
 }
 
@@ -263,25 +289,50 @@ controller_interface::CallbackReturn AdmittanceController::on_configure(
     get_interface_list(admittance_->parameters_.state_interfaces).c_str());
 
   // setup subscribers and publishers
+  // the references are laid out as the reference interfaces, positions first, then velocities
+  input_joint_command_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<std::vector<double>>>(
+      std::vector<double>(2 * num_joints_, std::numeric_limits<double>::quiet_NaN()));
   auto joint_command_callback =
     [this](const std::shared_ptr<trajectory_msgs::msg::JointTrajectoryPoint> msg)
-  { input_joint_command_.writeFromNonRT(msg); };
+  {
+    // values missing in the message are NaN, which keeps the last reference
+    auto & references = input_joint_command_->write_buffer();
+    std::fill(references.begin(), references.end(), std::numeric_limits<double>::quiet_NaN());
+    std::copy_n(
+      msg->positions.begin(), std::min(msg->positions.size(), num_joints_), references.begin());
+    std::copy_n(
+      msg->velocities.begin(), std::min(msg->velocities.size(), num_joints_),
+      references.begin() + static_cast<std::ptrdiff_t>(num_joints_));
+    input_joint_command_->publish();
+  };
   input_joint_command_subscriber_ =
     get_node()->create_subscription<trajectory_msgs::msg::JointTrajectoryPoint>(
       "~/joint_references", rclcpp::SystemDefaultsQoS(), joint_command_callback);
   s_publisher_ = get_node()->create_publisher<control_msgs::msg::AdmittanceControllerState>(
     "~/status", rclcpp::SystemDefaultsQoS());
-  state_publisher_ =
-    std::make_unique<realtime_tools::RealtimePublisher<ControllerStateMsg>>(s_publisher_);
 
   // Initialize state message
-  state_publisher_->lock();
-  state_publisher_->msg_ = admittance_->get_controller_state();
-  state_publisher_->unlock();
+  admittance_->get_controller_state(state_msg_);
+
+  const auto state_publish_period =
+    admittance_->parameters_.state_publish_rate > 0.0
+      ? rclcpp::Duration::from_seconds(1.0 / admittance_->parameters_.state_publish_rate)
+      : rclcpp::Duration::from_nanoseconds(0);
+  state_publisher_ = std::make_unique<StatePublisher>(
+    s_publisher_, state_msg_, state_publish_period.to_chrono<std::chrono::nanoseconds>());
 
   // Initialize FTS semantic semantic_component
   force_torque_sensor_ = std::make_unique<semantic_components::ForceTorqueSensor>(
     semantic_components::ForceTorqueSensor(admittance_->parameters_.ft_sensor.name));
+  additional_force_torque_sensors_.clear();
+  for (const auto & name : admittance_->parameters_.additional_ft_sensors)
+  {
+    additional_force_torque_sensors_.push_back(
+      std::make_unique<semantic_components::ForceTorqueSensor>(name));
+  }
+  additional_ft_values_.assign(
+    additional_force_torque_sensors_.size(), geometry_msgs::msg::Wrench());
 
   // configure admittance rule
   if (admittance_->configure(get_node(), num_joints_) == controller_interface::return_type::ERROR)
@@ -289,6 +340,26 @@ controller_interface::CallbackReturn AdmittanceController::on_configure(
     return controller_interface::CallbackReturn::ERROR;
   }
 
+  // configure filters of the force torque sensor wrench
+  const auto & filter_params = admittance_->parameters_.ft_sensor.filters;
+  if (!wrench_filter_chain_.configure(
+        filter_params.chain, filter_params.low_pass.coefficient, filter_params.deadband.force,
+        filter_params.deadband.torque,
+        static_cast<size_t>(filter_params.moving_average.window)))
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Unknown filter in 'ft_sensor.filters.chain'.");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  additional_wrench_filter_chains_.assign(
+    additional_force_torque_sensors_.size(), wrench_filter_chain_);
+
+  const auto & recording_params = admittance_->parameters_.input_recording;
+  if (recording_params.enable && recording_params.path.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'input_recording.path' is empty.");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -336,22 +407,50 @@ controller_interface::CallbackReturn AdmittanceController::on_activate(
   admittance_->apply_parameters_update();
 
   // initialize interface of the FTS semantic component
-  force_torque_sensor_->assign_loaned_state_interfaces(state_interfaces_);
+  if (!admittance_->parameters_.ft_sensor.use_reference_interfaces)
+  {
+    force_torque_sensor_->assign_loaned_state_interfaces(state_interfaces_);
+  }
+  wrench_filter_chain_.reset();
+  for (size_t i = 0; i < additional_force_torque_sensors_.size(); ++i)
+  {
+    additional_force_torque_sensors_[i]->assign_loaned_state_interfaces(state_interfaces_);
+    additional_wrench_filter_chains_[i].reset();
+  }
 
   // initialize states
   read_state_from_hardware(joint_state_, ft_values_);
-  for (auto val : joint_state_.positions)
+  if (joint_state_.positions.hasNaN())
   {
-    if (std::isnan(val))
+    RCLCPP_ERROR(get_node()->get_logger(), "Failed to read joint positions from the hardware.\n");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  const auto & recording_params = admittance_->parameters_.input_recording;
+  if (recording_params.enable)
+  {
+    std::vector<std::string> state_names;
+    for (const auto & interface : state_interfaces_)
     {
-      RCLCPP_ERROR(get_node()->get_logger(), "Failed to read joint positions from the hardware.\n");
+      state_names.push_back(interface.get_name());
+    }
+    input_recorder_ = std::make_unique<controller_realtime_tools::InputRecorder>(
+      recording_params.path, state_names, reference_interfaces_.size(),
+      static_cast<size_t>(recording_params.capacity));
+    if (!input_recorder_->good())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Unable to record the inputs to '%s'.",
+        recording_params.path.c_str());
+      input_recorder_.reset();
       return controller_interface::CallbackReturn::ERROR;
     }
   }
 
+  // publish the state in the first update
+  state_publisher_->reset_period();
+
   // Use current joint_state as a default reference
-  last_reference_ = joint_state_;
-  last_commanded_ = joint_state_;
   reference_ = joint_state_;
   reference_admittance_ = joint_state_;
 
@@ -367,26 +466,18 @@ controller_interface::return_type AdmittanceController::update_reference_from_su
     return controller_interface::return_type::ERROR;
   }
 
-  joint_command_msg_ = *input_joint_command_.readFromRT();
-
-  // if message exists, load values into references
-  if (joint_command_msg_.get())
-  {
-    for (size_t i = 0; i < joint_command_msg_->positions.size(); ++i)
-    {
-      position_reference_[i].get() = joint_command_msg_->positions[i];
-    }
-    for (size_t i = 0; i < joint_command_msg_->velocities.size(); ++i)
-    {
-      velocity_reference_[i].get() = joint_command_msg_->velocities[i];
-    }
-  }
+  // load the values of the last message into the references, all NaN if none was received yet
+  const auto & references = input_joint_command_->read();
+  CONTROLLER_TRACEPOINT(REFERENCE_RECEIVED, this, 0);
+  std::copy_n(
+    references.begin(), std::min(references.size(), reference_interfaces_.size()),
+    reference_interfaces_.begin());
 
   return controller_interface::return_type::OK;
 }
 
 controller_interface::return_type AdmittanceController::update_and_write_commands(
-  const rclcpp::Time & /*time*/, const rclcpp::Duration & period)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
   // Realtime constraints are required in this function
   if (!admittance_)
@@ -394,22 +485,38 @@ controller_interface::return_type AdmittanceController::update_and_write_command
     return controller_interface::return_type::ERROR;
   }
 
+  if (input_recorder_)
+  {
+    input_recorder_->record(
+      time.nanoseconds(), period.nanoseconds(), state_interfaces_, reference_interfaces_);
+  }
+
   // update input reference from chainable interfaces
   read_state_reference_interfaces(reference_);
 
   // get all controller inputs
   read_state_from_hardware(joint_state_, ft_values_);
+  wrench_filter_chain_.update(ft_values_);
+  for (size_t i = 0; i < additional_ft_values_.size(); ++i)
+  {
+    additional_wrench_filter_chains_[i].update(additional_ft_values_[i]);
+  }
 
-  // apply admittance control to reference to determine desired state
-  admittance_->update(joint_state_, ft_values_, reference_, period, reference_admittance_);
+  // apply admittance control to reference to determine desired state, in place
+  admittance_->update(
+    joint_state_.positions, ft_values_, additional_ft_values_, reference_.positions,
+    reference_.velocities, period, reference_admittance_.positions,
+    reference_admittance_.velocities, reference_admittance_.accelerations);
 
   // write calculated values to joint interfaces
   write_state_to_hardware(reference_admittance_);
 
-  // Publish controller state
-  state_publisher_->lock();
-  state_publisher_->msg_ = admittance_->get_controller_state();
-  state_publisher_->unlockAndPublish();
+  // Publish controller state, the message is only filled when it is published
+  if (state_publisher_->is_due(time.nanoseconds()))
+  {
+    admittance_->get_controller_state(state_msg_);
+    state_publisher_->try_publish(state_msg_, time.nanoseconds());
+  }
 
   return controller_interface::return_type::OK;
 }
@@ -422,8 +529,12 @@ controller_interface::CallbackReturn AdmittanceController::on_deactivate(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  // release force torque sensor interface
+  // release force torque sensor interfaces
   force_torque_sensor_->release_interfaces();
+  for (const auto & sensor : additional_force_torque_sensors_)
+  {
+    sensor->release_interfaces();
+  }
 
   // reset to prevent stale references
   for (size_t i = 0; i < num_joints_; i++)
@@ -439,6 +550,8 @@ controller_interface::CallbackReturn AdmittanceController::on_deactivate(
   }
   release_interfaces();
   admittance_->reset(num_joints_);
+  // writes the inputs left
+  input_recorder_.reset();
 
   return CallbackReturn::SUCCESS;
 }
@@ -461,8 +574,7 @@ controller_interface::CallbackReturn AdmittanceController::on_error(
 }
 
 void AdmittanceController::read_state_from_hardware(
-  trajectory_msgs::msg::JointTrajectoryPoint & state_current,
-  geometry_msgs::msg::Wrench & ft_values)
+  JointStateVectors & state_current, geometry_msgs::msg::Wrench & ft_values)
 {
   // if any interface has nan values, assume state_current is the last command state
   bool nan_position = false;
@@ -474,103 +586,128 @@ void AdmittanceController::read_state_from_hardware(
   size_t acc_ind = vel_ind + has_acceleration_state_interface_;
   for (size_t joint_ind = 0; joint_ind < num_joints_; ++joint_ind)
   {
+    const auto i = static_cast<Eigen::Index>(joint_ind);
     if (has_position_state_interface_)
     {
-      state_current.positions[joint_ind] =
+      state_current.positions[i] =
         state_interfaces_[pos_ind * num_joints_ + joint_ind].get_value();
-      nan_position |= std::isnan(state_current.positions[joint_ind]);
+      nan_position |= std::isnan(state_current.positions[i]);
     }
     else if (has_velocity_state_interface_)
     {
-      state_current.velocities[joint_ind] =
+      state_current.velocities[i] =
         state_interfaces_[vel_ind * num_joints_ + joint_ind].get_value();
-      nan_velocity |= std::isnan(state_current.velocities[joint_ind]);
+      nan_velocity |= std::isnan(state_current.velocities[i]);
     }
     else if (has_acceleration_state_interface_)
     {
-      state_current.accelerations[joint_ind] =
+      state_current.accelerations[i] =
         state_interfaces_[acc_ind * num_joints_ + joint_ind].get_value();
-      nan_acceleration |= std::isnan(state_current.accelerations[joint_ind]);
+      nan_acceleration |= std::isnan(state_current.accelerations[i]);
     }
   }
 
   if (nan_position)
   {
-    state_current.positions = last_commanded_.positions;
+    state_current.positions = reference_admittance_.positions;
   }
   if (nan_velocity)
   {
-    state_current.velocities = last_commanded_.velocities;
+    state_current.velocities = reference_admittance_.velocities;
   }
   if (nan_acceleration)
   {
-    state_current.accelerations = last_commanded_.accelerations;
+    state_current.accelerations = reference_admittance_.accelerations;
   }
 
   // if any ft_values are nan, assume values are zero
-  force_torque_sensor_->get_values_as_message(ft_values);
-  if (
-    std::isnan(ft_values.force.x) || std::isnan(ft_values.force.y) ||
-    std::isnan(ft_values.force.z) || std::isnan(ft_values.torque.x) ||
-    std::isnan(ft_values.torque.y) || std::isnan(ft_values.torque.z))
+  const auto read_wrench =
+    [](semantic_components::ForceTorqueSensor & sensor, geometry_msgs::msg::Wrench & values)
   {
-    ft_values = geometry_msgs::msg::Wrench();
+    sensor.get_values_as_message(values);
+    if (
+      std::isnan(values.force.x) || std::isnan(values.force.y) || std::isnan(values.force.z) ||
+      std::isnan(values.torque.x) || std::isnan(values.torque.y) || std::isnan(values.torque.z))
+    {
+      values = geometry_msgs::msg::Wrench();
+    }
+  };
+  if (admittance_->parameters_.ft_sensor.use_reference_interfaces)
+  {
+    const double * wrench = reference_interfaces_.data() + wrench_reference_index_;
+    ft_values.force.x = wrench[0];
+    ft_values.force.y = wrench[1];
+    ft_values.force.z = wrench[2];
+    ft_values.torque.x = wrench[3];
+    ft_values.torque.y = wrench[4];
+    ft_values.torque.z = wrench[5];
+    if (std::any_of(wrench, wrench + 6, [](double value) { return std::isnan(value); }))
+    {
+      ft_values = geometry_msgs::msg::Wrench();
+    }
+  }
+  else
+  {
+    read_wrench(*force_torque_sensor_, ft_values);
+  }
+  for (size_t i = 0; i < additional_force_torque_sensors_.size(); ++i)
+  {
+    read_wrench(*additional_force_torque_sensors_[i], additional_ft_values_[i]);
   }
 }
 
-void AdmittanceController::write_state_to_hardware(
-  const trajectory_msgs::msg::JointTrajectoryPoint & state_commanded)
+void AdmittanceController::write_state_to_hardware(const JointStateVectors & state_commanded)
 {
-  // if any interface has nan values, assume state_commanded is the last command state
+  // state_commanded is kept as the last command state, in case the hardware reads NaN
   size_t pos_ind = 0;
   size_t vel_ind = pos_ind + has_velocity_command_interface_;
   size_t acc_ind = vel_ind + has_acceleration_state_interface_;
   for (size_t joint_ind = 0; joint_ind < num_joints_; ++joint_ind)
   {
+    const double position = state_commanded.positions[static_cast<Eigen::Index>(joint_ind)];
     if (has_position_command_interface_)
     {
-      command_interfaces_[pos_ind * num_joints_ + joint_ind].set_value(
-        state_commanded.positions[joint_ind]);
+      command_interfaces_[pos_ind * num_joints_ + joint_ind].set_value(position);
     }
     else if (has_velocity_command_interface_)
     {
-      command_interfaces_[vel_ind * num_joints_ + joint_ind].set_value(
-        state_commanded.positions[joint_ind]);
+      command_interfaces_[vel_ind * num_joints_ + joint_ind].set_value(position);
     }
     else if (has_acceleration_command_interface_)
     {
-      command_interfaces_[acc_ind * num_joints_ + joint_ind].set_value(
-        state_commanded.positions[joint_ind]);
+      command_interfaces_[acc_ind * num_joints_ + joint_ind].set_value(position);
     }
   }
-  last_commanded_ = state_commanded;
 }
 
-void AdmittanceController::read_state_reference_interfaces(
-  trajectory_msgs::msg::JointTrajectoryPoint & state_reference)
+void AdmittanceController::read_state_reference_interfaces(JointStateVectors & state_reference)
 {
   // TODO(destogl): check why is this here?
 
-  // if any interface has nan values, assume state_reference is the last set reference
+  // if any interface has nan values, state_reference keeps the last set reference
   for (size_t i = 0; i < num_joints_; ++i)
   {
+    const auto index = static_cast<Eigen::Index>(i);
     // update position
     if (std::isnan(position_reference_[i]))
     {
-      position_reference_[i].get() = last_reference_.positions[i];
+      position_reference_[i].get() = state_reference.positions[index];
+    }
+    else
+    {
+      state_reference.positions[index] = position_reference_[i];
     }
-    state_reference.positions[i] = position_reference_[i];
 
     // update velocity
     if (std::isnan(velocity_reference_[i]))
     {
-      velocity_reference_[i].get() = last_reference_.velocities[i];
+      velocity_reference_[i].get() = state_reference.velocities[index];
+    }
+    else
+    {
+      state_reference.velocities[index] = velocity_reference_[i];
     }
-    state_reference.velocities[i] = velocity_reference_[i];
   }
-
-  last_reference_.positions = state_reference.positions;
-  last_reference_.velocities = state_reference.velocities;
 }
 
 }  // namespace admittance_controller
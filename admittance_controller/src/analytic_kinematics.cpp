@@ -0,0 +1,280 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "admittance_controller/analytic_kinematics.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/logging.hpp"
+#include "rclcpp/parameter.hpp"
+#include "urdf/model.h"
+
+namespace admittance_controller
+{
+namespace
+{
+const rclcpp::Logger LOGGER = rclcpp::get_logger("AnalyticKinematics");
+
+Eigen::Isometry3d to_isometry(const urdf::Pose & pose)
+{
+  Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+  transform.translate(Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z));
+  transform.rotate(
+    Eigen::Quaterniond(pose.rotation.w, pose.rotation.x, pose.rotation.y, pose.rotation.z)
+      .normalized());
+  return transform;
+}
+}  // namespace
+
+bool AnalyticKinematics::initialize(
+  std::shared_ptr<rclcpp::node_interfaces::NodeParametersInterface> parameters_interface,
+  const std::string & end_effector_name)
+{
+  rclcpp::Parameter robot_description;
+  if (!parameters_interface->get_parameter("robot_description", robot_description))
+  {
+    RCLCPP_ERROR(LOGGER, "The parameter robot_description is not set.");
+    return false;
+  }
+  // the damping of the pseudo-inverse has the name and default of the KDL plugin
+  rclcpp::Parameter alpha("alpha", 0.000005);
+  if (parameters_interface->has_parameter("alpha"))
+  {
+    parameters_interface->get_parameter("alpha", alpha);
+  }
+  return initialize_from_urdf(robot_description.as_string(), end_effector_name, alpha.as_double());
+}
+
+bool AnalyticKinematics::initialize_from_urdf(
+  const std::string & robot_description, const std::string & end_effector_name, double alpha)
+{
+  urdf::Model model;
+  if (!model.initString(robot_description))
+  {
+    RCLCPP_ERROR(LOGGER, "Failed to parse robot_description.");
+    return false;
+  }
+  auto link = model.getLink(end_effector_name);
+  if (!link)
+  {
+    RCLCPP_ERROR(LOGGER, "The end effector '%s' is not a link.", end_effector_name.c_str());
+    return false;
+  }
+
+  // walk from the end effector up to the root link
+  std::vector<urdf::JointConstSharedPtr> joints;
+  std::vector<std::string> child_links;
+  while (link->parent_joint)
+  {
+    joints.push_back(link->parent_joint);
+    child_links.push_back(link->name);
+    link = model.getLink(link->parent_joint->parent_link_name);
+  }
+  std::reverse(joints.begin(), joints.end());
+  std::reverse(child_links.begin(), child_links.end());
+
+  segments_.clear();
+  link_indices_.clear();
+  link_indices_.emplace(link->name, 0);
+  num_joints_ = 0;
+  for (size_t k = 0; k < joints.size(); ++k)
+  {
+    const auto & joint = *joints[k];
+    Segment segment;
+    segment.origin = to_isometry(joint.parent_to_joint_origin_transform);
+    segment.axis = Eigen::Vector3d(joint.axis.x, joint.axis.y, joint.axis.z);
+    segment.joint_index = -1;
+    segment.prismatic = joint.type == urdf::Joint::PRISMATIC;
+    switch (joint.type)
+    {
+      case urdf::Joint::REVOLUTE:
+      case urdf::Joint::CONTINUOUS:
+      case urdf::Joint::PRISMATIC:
+        if (segment.axis.norm() == 0.0)
+        {
+          RCLCPP_ERROR(LOGGER, "The joint '%s' has no axis.", joint.name.c_str());
+          return false;
+        }
+        segment.axis.normalize();
+        segment.joint_index = static_cast<int>(num_joints_++);
+        break;
+      case urdf::Joint::FIXED:
+        break;
+      default:
+        RCLCPP_ERROR(
+          LOGGER, "The joint '%s' is neither revolute, prismatic nor fixed.", joint.name.c_str());
+        return false;
+    }
+    segments_.push_back(segment);
+    link_indices_.emplace(child_links[k], k + 1);
+  }
+
+  alpha_ = alpha;
+  const auto n = static_cast<Eigen::Index>(num_joints_);
+  cached_joint_pos_ = Eigen::VectorXd::Zero(n);
+  cache_valid_ = false;
+  link_transforms_.assign(segments_.size() + 1, Eigen::Isometry3d::Identity());
+  joint_axes_ = Eigen::Matrix<double, 3, Eigen::Dynamic>::Zero(3, n);
+  joint_origins_ = Eigen::Matrix<double, 3, Eigen::Dynamic>::Zero(3, n);
+  jacobian_ = Eigen::Matrix<double, 6, Eigen::Dynamic>::Zero(6, n);
+  damped_jtj_ = Eigen::MatrixXd::Zero(n, n);
+  damped_jtj_ldlt_ = Eigen::LDLT<Eigen::MatrixXd>(n);
+  return true;
+}
+
+bool AnalyticKinematics::convert_cartesian_deltas_to_joint_deltas(
+  const Eigen::VectorXd & joint_pos, const Eigen::Matrix<double, 6, 1> & delta_x,
+  const std::string & link_name, Eigen::VectorXd & delta_theta)
+{
+  const size_t * link_index = find_link(link_name);
+  if (!link_index || !update(joint_pos))
+  {
+    return false;
+  }
+  compute_jacobian(*link_index);
+  // damped least-squares: (J^T * J + alpha * I)^-1 * J^T * delta_x
+  damped_jtj_.noalias() = jacobian_.transpose() * jacobian_;
+  damped_jtj_.diagonal().array() += alpha_;
+  damped_jtj_ldlt_.compute(damped_jtj_);
+  delta_theta.noalias() = jacobian_.transpose() * delta_x;
+  damped_jtj_ldlt_.solveInPlace(delta_theta);
+  return true;
+}
+
+bool AnalyticKinematics::convert_joint_deltas_to_cartesian_deltas(
+  const Eigen::VectorXd & joint_pos, const Eigen::VectorXd & delta_theta,
+  const std::string & link_name, Eigen::Matrix<double, 6, 1> & delta_x)
+{
+  const size_t * link_index = find_link(link_name);
+  if (!link_index || !update(joint_pos) || delta_theta.size() != joint_pos.size())
+  {
+    return false;
+  }
+  compute_jacobian(*link_index);
+  delta_x.noalias() = jacobian_ * delta_theta;
+  return true;
+}
+
+bool AnalyticKinematics::calculate_link_transform(
+  const Eigen::VectorXd & joint_pos, const std::string & link_name, Eigen::Isometry3d & transform)
+{
+  const size_t * link_index = find_link(link_name);
+  if (!link_index || !update(joint_pos))
+  {
+    return false;
+  }
+  transform = link_transforms_[*link_index];
+  return true;
+}
+
+bool AnalyticKinematics::calculate_jacobian(
+  const Eigen::VectorXd & joint_pos, const std::string & link_name,
+  Eigen::Matrix<double, 6, Eigen::Dynamic> & jacobian)
+{
+  const size_t * link_index = find_link(link_name);
+  if (!link_index || !update(joint_pos))
+  {
+    return false;
+  }
+  compute_jacobian(*link_index);
+  jacobian = jacobian_;
+  return true;
+}
+
+bool AnalyticKinematics::update(const Eigen::VectorXd & joint_pos)
+{
+  if (joint_pos.size() != static_cast<Eigen::Index>(num_joints_))
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Expected %zu joint positions, got %zu.", num_joints_,
+      static_cast<size_t>(joint_pos.size()));
+    return false;
+  }
+  if (cache_valid_ && joint_pos == cached_joint_pos_)
+  {
+    return true;
+  }
+
+  Eigen::Isometry3d transform = Eigen::Isometry3d::Identity();
+  for (size_t k = 0; k < segments_.size(); ++k)
+  {
+    const Segment & segment = segments_[k];
+    transform = transform * segment.origin;
+    if (segment.joint_index >= 0)
+    {
+      const auto j = static_cast<Eigen::Index>(segment.joint_index);
+      joint_axes_.col(j) = transform.linear() * segment.axis;
+      joint_origins_.col(j) = transform.translation();
+      if (segment.prismatic)
+      {
+        transform.translate(segment.axis * joint_pos[j]);
+      }
+      else
+      {
+        transform.rotate(Eigen::AngleAxisd(joint_pos[j], segment.axis));
+      }
+    }
+    link_transforms_[k + 1] = transform;
+  }
+  cached_joint_pos_ = joint_pos;
+  cache_valid_ = true;
+  return true;
+}
+
+const size_t * AnalyticKinematics::find_link(const std::string & link_name) const
+{
+  const auto it = link_indices_.find(link_name);
+  if (it == link_indices_.end())
+  {
+    RCLCPP_ERROR(LOGGER, "The link '%s' is not in the kinematic chain.", link_name.c_str());
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void AnalyticKinematics::compute_jacobian(size_t link_index)
+{
+  // the joints after the link don't move it
+  jacobian_.setZero();
+  const Eigen::Vector3d link_origin = link_transforms_[link_index].translation();
+  for (size_t k = 0; k < link_index; ++k)
+  {
+    const Segment & segment = segments_[k];
+    if (segment.joint_index < 0)
+    {
+      continue;
+    }
+    const auto j = static_cast<Eigen::Index>(segment.joint_index);
+    const Eigen::Vector3d axis = joint_axes_.col(j);
+    if (segment.prismatic)
+    {
+      jacobian_.block<3, 1>(0, j) = axis;
+    }
+    else
+    {
+      jacobian_.block<3, 1>(0, j) = axis.cross(link_origin - joint_origins_.col(j));
+      jacobian_.block<3, 1>(3, j) = axis;
+    }
+  }
+}
+
+}  // namespace admittance_controller
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  admittance_controller::AnalyticKinematics, kinematics_interface::KinematicsInterface)
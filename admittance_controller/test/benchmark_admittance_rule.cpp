@@ -0,0 +1,331 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of AdmittanceRule::update() with the 6-DOF test robot.
+//
+// The rule is driven with a recording of 10 s at 1 kHz, in which the robot moves every joint on a
+// sine while the sensor measures a contact wrench. With the argument 'moving' set to 0 the robot
+// rests at the start of the recording instead. The argument 'refresh' sets the parameter
+// kinematics.refresh.cycles, and 'pipelined' the parameter kinematics.pipelined.enable, with which
+// only the kinematics computed in the update until the first pipelined ones are done are timed.
+//
+// Every benchmark reports the time per cycle, the heap allocations per cycle, the tail latency of
+// single cycles (p50_ns, p99_ns, max_ns) and the share of the time spent in the kinematics plugin
+// (kinematics_share). The plugin is the KDL one, or the one named by the environment variables
+// KINEMATICS_PLUGIN_NAME and KINEMATICS_PLUGIN_PACKAGE to compare plugins.
+//
+// Like all performance tests, the benchmarks only run with ctest if AMENT_RUN_PERFORMANCE_TESTS is
+// set.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "admittance_controller/admittance_rule.hpp"
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+#include "geometry_msgs/msg/wrench.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+#include "test_asset_6d_robot_description.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace
+{
+const std::vector<std::string> JOINT_NAMES = {"joint1", "joint2", "joint3",
+                                              "joint4", "joint5", "joint6"};
+const rclcpp::Duration CYCLE_PERIOD = rclcpp::Duration::from_seconds(0.001);
+constexpr size_t RECORDING_CYCLES = 10000;
+
+std::string get_env(const char * name, const std::string & default_value)
+{
+  const char * value = std::getenv(name);
+  return value ? std::string(value) : default_value;
+}
+
+/// Joint states and sensor wrenches of one control cycle
+struct RecordedCycle
+{
+  trajectory_msgs::msg::JointTrajectoryPoint joint_state;
+  geometry_msgs::msg::Wrench wrench;
+};
+
+/// Recording of the robot moving every joint on a sine around a pose away from singularities,
+/// while pushing against a contact
+std::vector<RecordedCycle> make_recording(bool moving)
+{
+  const std::vector<double> pose = {0.0, -0.5, 0.8, 0.0, 0.6, 0.0};
+  std::vector<RecordedCycle> recording(RECORDING_CYCLES);
+  for (size_t k = 0; k < recording.size(); ++k)
+  {
+    const double t = moving ? CYCLE_PERIOD.seconds() * static_cast<double>(k) : 0.0;
+    auto & joint_state = recording[k].joint_state;
+    joint_state.positions.resize(JOINT_NAMES.size());
+    joint_state.velocities.resize(JOINT_NAMES.size());
+    joint_state.accelerations.resize(JOINT_NAMES.size());
+    for (size_t i = 0; i < JOINT_NAMES.size(); ++i)
+    {
+      const double phase = t + 0.3 * static_cast<double>(i);
+      joint_state.positions[i] = pose[i] + 0.2 * std::sin(phase);
+      joint_state.velocities[i] = moving ? 0.2 * std::cos(phase) : 0.0;
+      joint_state.accelerations[i] = moving ? -0.2 * std::sin(phase) : 0.0;
+    }
+    auto & wrench = recording[k].wrench;
+    wrench.force.x = 5.0 * std::sin(0.5 * t);
+    wrench.force.y = 2.0 * std::cos(0.7 * t);
+    wrench.force.z = 20.0 + 10.0 * std::sin(0.3 * t);
+    wrench.torque.x = 0.5 * std::sin(0.9 * t);
+    wrench.torque.y = 0.5 * std::cos(1.1 * t);
+    wrench.torque.z = 0.1 * std::sin(1.3 * t);
+  }
+  return recording;
+}
+
+/// Forwards to a kinematics plugin and measures the time spent in it
+class TimedKinematics : public kinematics_interface::KinematicsInterface
+{
+public:
+  explicit TimedKinematics(std::unique_ptr<kinematics_interface::KinematicsInterface> kinematics)
+  : kinematics_(std::move(kinematics))
+  {
+  }
+
+  bool initialize(
+    std::shared_ptr<rclcpp::node_interfaces::NodeParametersInterface> parameters_interface,
+    const std::string & end_effector_name) override
+  {
+    return kinematics_->initialize(parameters_interface, end_effector_name);
+  }
+
+  bool convert_cartesian_deltas_to_joint_deltas(
+    const Eigen::VectorXd & joint_pos, const Eigen::Matrix<double, 6, 1> & delta_x,
+    const std::string & link_name, Eigen::VectorXd & delta_theta) override
+  {
+    return timed(
+      [&]()
+      {
+        return kinematics_->convert_cartesian_deltas_to_joint_deltas(
+          joint_pos, delta_x, link_name, delta_theta);
+      });
+  }
+
+  bool convert_joint_deltas_to_cartesian_deltas(
+    const Eigen::VectorXd & joint_pos, const Eigen::VectorXd & delta_theta,
+    const std::string & link_name, Eigen::Matrix<double, 6, 1> & delta_x) override
+  {
+    return timed(
+      [&]()
+      {
+        return kinematics_->convert_joint_deltas_to_cartesian_deltas(
+          joint_pos, delta_theta, link_name, delta_x);
+      });
+  }
+
+  bool calculate_link_transform(
+    const Eigen::VectorXd & joint_pos, const std::string & link_name,
+    Eigen::Isometry3d & transform) override
+  {
+    return timed(
+      [&]() { return kinematics_->calculate_link_transform(joint_pos, link_name, transform); });
+  }
+
+  bool calculate_jacobian(
+    const Eigen::VectorXd & joint_pos, const std::string & link_name,
+    Eigen::Matrix<double, 6, Eigen::Dynamic> & jacobian) override
+  {
+    return timed([&]() { return kinematics_->calculate_jacobian(joint_pos, link_name, jacobian); });
+  }
+
+  std::chrono::steady_clock::duration elapsed{0};
+
+private:
+  template <typename F>
+  bool timed(F call)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    const bool result = call();
+    elapsed += std::chrono::steady_clock::now() - start;
+    return result;
+  }
+
+  std::unique_ptr<kinematics_interface::KinematicsInterface> kinematics_;
+};
+
+class BenchmarkAdmittanceRule : public admittance_controller::AdmittanceRule
+{
+public:
+  using admittance_controller::AdmittanceRule::AdmittanceRule;
+
+  /// Wrap the loaded kinematics plugin to measure the time spent in it
+  TimedKinematics & time_kinematics()
+  {
+    auto timed_kinematics = std::make_unique<TimedKinematics>(std::move(kinematics_));
+    auto & timed_kinematics_ref = *timed_kinematics;
+    kinematics_ = std::move(timed_kinematics);
+    return timed_kinematics_ref;
+  }
+};
+
+/// Times of single cycles, to report the tail latency
+class CycleTimes
+{
+public:
+  explicit CycleTimes(const benchmark::State & state)
+  {
+    times_ns_.reserve(static_cast<size_t>(state.max_iterations));
+  }
+
+  void add(std::chrono::steady_clock::duration cycle_time, benchmark::State & state)
+  {
+    const auto cycle_time_ns = std::chrono::duration<double, std::nano>(cycle_time).count();
+    times_ns_.push_back(cycle_time_ns);
+    total_ns_ += cycle_time_ns;
+    state.SetIterationTime(cycle_time_ns * 1e-9);
+  }
+
+  void report(
+    benchmark::State & state, size_t allocations,
+    std::chrono::steady_clock::duration kinematics_time)
+  {
+    std::sort(times_ns_.begin(), times_ns_.end());
+    auto percentile = [this](double p)
+    {
+      return times_ns_[static_cast<size_t>(p * static_cast<double>(times_ns_.size() - 1))];
+    };
+    if (!times_ns_.empty())
+    {
+      state.counters["p50_ns"] = percentile(0.5);
+      state.counters["p99_ns"] = percentile(0.99);
+      state.counters["max_ns"] = times_ns_.back();
+      state.counters["kinematics_share"] =
+        std::chrono::duration<double, std::nano>(kinematics_time).count() / total_ns_;
+    }
+    state.counters["allocations"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  std::vector<double> times_ns_;
+  double total_ns_ = 0.0;
+};
+
+class AdmittanceRuleBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    rclcpp::init(0, nullptr);
+
+    const std::vector<rclcpp::Parameter> parameters = {
+      rclcpp::Parameter("joints", JOINT_NAMES),
+      rclcpp::Parameter("command_interfaces", std::vector<std::string>{"position"}),
+      rclcpp::Parameter("state_interfaces", std::vector<std::string>{"position"}),
+      rclcpp::Parameter(
+        "chainable_command_interfaces", std::vector<std::string>{"position", "velocity"}),
+      rclcpp::Parameter(
+        "kinematics.plugin_name",
+        get_env("KINEMATICS_PLUGIN_NAME", "kinematics_interface_kdl/KinematicsInterfaceKDL")),
+      rclcpp::Parameter(
+        "kinematics.plugin_package", get_env("KINEMATICS_PLUGIN_PACKAGE", "kinematics_interface")),
+      rclcpp::Parameter("kinematics.base", "base_link"),
+      rclcpp::Parameter("kinematics.tip", "tool0"),
+      rclcpp::Parameter("kinematics.alpha", 0.0005),
+      rclcpp::Parameter("kinematics.refresh.cycles", static_cast<int64_t>(state.range(1))),
+      rclcpp::Parameter("kinematics.pipelined.enable", state.range(2) != 0),
+      rclcpp::Parameter("ft_sensor.name", "ft_sensor_name"),
+      rclcpp::Parameter("ft_sensor.frame.id", "link_6"),
+      rclcpp::Parameter("control.frame.id", "tool0"),
+      rclcpp::Parameter("fixed_world_frame.frame.id", "base_link"),
+      rclcpp::Parameter("gravity_compensation.frame.id", "tool0"),
+      rclcpp::Parameter("gravity_compensation.CoG.pos", std::vector<double>{0.1, 0.0, 0.0}),
+      rclcpp::Parameter("gravity_compensation.CoG.force", 23.0),
+      rclcpp::Parameter(
+        "admittance.selected_axes", std::vector<bool>{true, true, true, true, true, true}),
+      rclcpp::Parameter("admittance.mass", std::vector<double>{5.5, 6.6, 7.7, 8.8, 9.9, 10.1}),
+      rclcpp::Parameter("admittance.damping_ratio", std::vector<double>(6, 2.828427)),
+      rclcpp::Parameter(
+        "admittance.stiffness", std::vector<double>{214.1, 214.2, 214.3, 214.4, 214.5, 214.6}),
+    };
+    node_ = std::make_shared<rclcpp_lifecycle::LifecycleNode>(
+      "benchmark_admittance_rule", rclcpp::NodeOptions().parameter_overrides(parameters));
+    node_->declare_parameter("robot_description", ros2_control_test_assets::valid_6d_robot_urdf);
+
+    rule_ = std::make_unique<BenchmarkAdmittanceRule>(
+      std::make_shared<admittance_controller::ParamListener>(node_));
+    if (rule_->configure(node_, JOINT_NAMES.size()) != controller_interface::return_type::OK)
+    {
+      state.SkipWithError("Failed to configure the admittance rule.");
+      return;
+    }
+    kinematics_ = &rule_->time_kinematics();
+
+    recording_ = make_recording(state.range(0) != 0);
+    reference_ = recording_.front().joint_state;
+    desired_ = reference_;
+  }
+
+  void TearDown(benchmark::State &) override
+  {
+    rule_.reset();
+    node_.reset();
+    rclcpp::shutdown();
+  }
+
+protected:
+  rclcpp_lifecycle::LifecycleNode::SharedPtr node_;
+  std::unique_ptr<BenchmarkAdmittanceRule> rule_;
+  TimedKinematics * kinematics_ = nullptr;
+  std::vector<RecordedCycle> recording_;
+  trajectory_msgs::msg::JointTrajectoryPoint reference_;
+  trajectory_msgs::msg::JointTrajectoryPoint desired_;
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(AdmittanceRuleBenchmark, update)(benchmark::State & state)
+{
+  if (state.error_occurred())
+  {
+    return;
+  }
+  size_t cycle = 0;
+  CycleTimes cycle_times(state);
+  kinematics_->elapsed = std::chrono::steady_clock::duration::zero();
+  controller_realtime_tools::ScopedRealtimeSafetyCounter allocation_counter;
+  for (auto _ : state)
+  {
+    const auto & recorded = recording_[cycle];
+    // the reference follows the recorded motion
+    reference_.positions = recorded.joint_state.positions;
+
+    const auto start = std::chrono::steady_clock::now();
+    rule_->update(recorded.joint_state, recorded.wrench, reference_, CYCLE_PERIOD, desired_);
+    cycle_times.add(std::chrono::steady_clock::now() - start, state);
+    benchmark::DoNotOptimize(desired_);
+
+    cycle = (cycle + 1) % recording_.size();
+  }
+  cycle_times.report(state, allocation_counter.get_allocations(), kinematics_->elapsed);
+}
+
+BENCHMARK_REGISTER_F(AdmittanceRuleBenchmark, update)
+  ->ArgNames({"moving", "refresh", "pipelined"})
+  ->ArgsProduct({{0, 1}, {1, 8}, {0, 1}})
+  ->UseManualTime();
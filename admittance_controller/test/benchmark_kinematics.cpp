@@ -0,0 +1,109 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the kinematics requested by the admittance rule in one cycle with the 6-DOF test
+// robot: the transforms of the sensor, control and world frames and the Jacobian of the control
+// frame, at a joint state that changes every cycle. The argument 'plugin' selects the KDL plugin
+// (0) or the analytic one of this package (1).
+//
+// Like all performance tests, the benchmarks only run with ctest if AMENT_RUN_PERFORMANCE_TESTS is
+// set.
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "kinematics_interface/kinematics_interface.hpp"
+#include "pluginlib/class_loader.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "test_asset_6d_robot_description.hpp"
+
+namespace
+{
+constexpr size_t NUM_JOINT_STATES = 1000;
+
+class KinematicsBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    rclcpp::init(0, nullptr);
+    node_ = std::make_shared<rclcpp::Node>("benchmark_kinematics");
+    node_->declare_parameter("robot_description", ros2_control_test_assets::valid_6d_robot_urdf);
+
+    loader_ = std::make_unique<pluginlib::ClassLoader<kinematics_interface::KinematicsInterface>>(
+      "kinematics_interface", "kinematics_interface::KinematicsInterface");
+    kinematics_ = loader_->createUniqueInstance(
+      state.range(0) == 0 ? "kinematics_interface_kdl/KinematicsInterfaceKDL"
+                          : "admittance_controller/AnalyticKinematics");
+    if (!kinematics_->initialize(node_->get_node_parameters_interface(), "tool0"))
+    {
+      state.SkipWithError("Failed to initialize the kinematics plugin.");
+      return;
+    }
+
+    // every joint moves on a sine around a pose away from singularities
+    const std::vector<double> pose = {0.0, -0.5, 0.8, 0.0, 0.6, 0.0};
+    joint_states_.assign(NUM_JOINT_STATES, Eigen::VectorXd(6));
+    for (size_t k = 0; k < joint_states_.size(); ++k)
+    {
+      for (Eigen::Index i = 0; i < 6; ++i)
+      {
+        const double phase = 0.001 * static_cast<double>(k) + 0.3 * static_cast<double>(i);
+        joint_states_[k][i] = pose[static_cast<size_t>(i)] + 0.2 * std::sin(phase);
+      }
+    }
+  }
+
+  void TearDown(benchmark::State &) override
+  {
+    kinematics_.reset();
+    loader_.reset();
+    node_.reset();
+    rclcpp::shutdown();
+  }
+
+protected:
+  rclcpp::Node::SharedPtr node_;
+  std::unique_ptr<pluginlib::ClassLoader<kinematics_interface::KinematicsInterface>> loader_;
+  pluginlib::UniquePtr<kinematics_interface::KinematicsInterface> kinematics_;
+  std::vector<Eigen::VectorXd> joint_states_;
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(KinematicsBenchmark, admittance_cycle)(benchmark::State & state)
+{
+  if (state.error_occurred())
+  {
+    return;
+  }
+  size_t cycle = 0;
+  Eigen::Isometry3d ft_sensor_transform, control_transform, world_transform;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian(6, 6);
+  for (auto _ : state)
+  {
+    const auto & joint_pos = joint_states_[cycle];
+    kinematics_->calculate_link_transform(joint_pos, "link_6", ft_sensor_transform);
+    kinematics_->calculate_link_transform(joint_pos, "tool0", control_transform);
+    kinematics_->calculate_link_transform(joint_pos, "base_link", world_transform);
+    kinematics_->calculate_jacobian(joint_pos, "tool0", jacobian);
+    benchmark::DoNotOptimize(jacobian);
+    cycle = (cycle + 1) % joint_states_.size();
+  }
+}
+
+BENCHMARK_REGISTER_F(KinematicsBenchmark, admittance_cycle)->ArgNames({"plugin"})->Arg(0)->Arg(1);
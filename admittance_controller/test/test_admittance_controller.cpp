@@ -16,8 +16,10 @@
 
 #include "test_admittance_controller.hpp"
 
+#include <chrono>
 #include <limits>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -161,6 +163,54 @@ TEST_F(AdmittanceControllerTest, check_interfaces)
     state_interface_types_.size() * joint_names_.size() + fts_state_values_.size());
 }
 
+TEST_F(AdmittanceControllerTest, check_interfaces_with_additional_ft_sensor)
+{
+  const std::string sensor_name = "second_ft_sensor_name";
+  SetUpController(
+    "test_admittance_controller",
+    {rclcpp::Parameter("additional_ft_sensors", std::vector<std::string>{sensor_name}),
+     rclcpp::Parameter("additional_ft_sensor." + sensor_name + ".frame_id", sensor_frame_),
+     rclcpp::Parameter(
+       "additional_ft_sensor." + sensor_name + ".gravity_compensation_frame_id", sensor_frame_)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // the interfaces of the additional sensor follow the ones of the main sensor
+  auto state_interfaces = controller_->state_interface_configuration();
+  ASSERT_EQ(
+    state_interfaces.names.size(), joint_state_values_.size() + 2 * fts_state_values_.size());
+  EXPECT_EQ(state_interfaces.names.back(), sensor_name + "/torque.z");
+}
+
+TEST_F(AdmittanceControllerTest, wrench_from_reference_interfaces)
+{
+  SetUpController(
+    "test_admittance_controller", {rclcpp::Parameter("ft_sensor.use_reference_interfaces", true)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // the sensor isn't claimed, its wrench follows the joint references
+  auto state_interfaces = controller_->state_interface_configuration();
+  ASSERT_EQ(state_interfaces.names.size(), joint_state_values_.size());
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_EQ(reference_interfaces.size(), 2 * joint_names_.size() + fts_state_values_.size());
+  EXPECT_EQ(
+    reference_interfaces.back().get_name(),
+    "test_admittance_controller/" + ft_sensor_name_ + "/torque.z");
+
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  broadcast_tfs();
+  for (size_t i = 0; i < fts_state_values_.size(); ++i)
+  {
+    reference_interfaces[2 * joint_names_.size() + i].set_value(static_cast<double>(i + 1));
+  }
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(controller_->ft_values_.force.x, 1.0);
+  EXPECT_EQ(controller_->ft_values_.torque.z, 6.0);
+}
+
 TEST_F(AdmittanceControllerTest, activate_success)
 {
   SetUpController();
@@ -183,6 +233,26 @@ TEST_F(AdmittanceControllerTest, update_success)
     controller_interface::return_type::OK);
 }
 
+TEST_F(AdmittanceControllerTest, update_success_with_pipelined_kinematics)
+{
+  SetUpController(
+    "test_admittance_controller", {rclcpp::Parameter("kinematics.pipelined.enable", true)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  broadcast_tfs();
+  // the first update computes the kinematics itself, the later ones take them from the helper
+  // thread once it is done
+  for (int i = 0; i < 100; ++i)
+  {
+    ASSERT_EQ(
+      controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(controller_->on_deactivate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+}
+
 TEST_F(AdmittanceControllerTest, deactivate_success)
 {
   SetUpController();
@@ -241,6 +311,26 @@ TEST_F(AdmittanceControllerTest, publish_status_success)
   //   }
 }
 
+TEST_F(AdmittanceControllerTest, publish_status_with_rate)
+{
+  SetUpController("test_admittance_controller", {rclcpp::Parameter("state_publish_rate", 10.0)});
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  broadcast_tfs();
+
+  // the state is published in the first update after activation
+  ControllerStateMsg msg;
+  subscribe_and_get_messages(msg);
+
+  // the fields depending only on the parameters are set as well
+  EXPECT_THAT(msg.joint_state.name, ::testing::ElementsAreArray(joint_names_));
+  EXPECT_EQ(msg.wrench_base.header.frame_id, ik_base_frame_);
+  EXPECT_EQ(msg.ref_trans_base_ft.header.frame_id, ik_base_frame_);
+  EXPECT_EQ(msg.ft_sensor_frame.data, sensor_frame_);
+}
+
 TEST_F(AdmittanceControllerTest, receive_message_and_publish_updated_status)
 {
   SetUpController();
@@ -278,6 +368,40 @@ TEST_F(AdmittanceControllerTest, receive_message_and_publish_updated_status)
   subscribe_and_get_messages(msg);
 }
 
+TEST(WrenchFilterChainTest, filters_apply_in_order)
+{
+  using Wrench = admittance_controller::WrenchFilterChain::Wrench;
+  admittance_controller::WrenchFilterChain filter_chain;
+  EXPECT_FALSE(filter_chain.configure({"unknown"}, 1.0, 0.0, 0.0, 1));
+
+  // deadband
+  ASSERT_TRUE(filter_chain.configure({"deadband"}, 1.0, 1.0, 0.5, 1));
+  Wrench wrench;
+  wrench << 3.0, -3.0, 0.5, 1.0, -1.0, 0.25;
+  filter_chain.update(wrench);
+  EXPECT_THAT(wrench, ::testing::ElementsAre(2.0, -2.0, 0.0, 0.5, -0.5, 0.0));
+
+  // moving average, then low pass starting from the first average
+  ASSERT_TRUE(filter_chain.configure({"moving_average", "low_pass"}, 0.5, 0.0, 0.0, 2));
+  wrench.setConstant(2.0);
+  filter_chain.update(wrench);
+  EXPECT_DOUBLE_EQ(wrench[0], 2.0);
+  wrench.setConstant(4.0);
+  filter_chain.update(wrench);
+  // average 3.0, smoothed with 2.0
+  EXPECT_DOUBLE_EQ(wrench[0], 2.5);
+  wrench.setConstant(4.0);
+  filter_chain.update(wrench);
+  // average 4.0, smoothed with 2.5
+  EXPECT_DOUBLE_EQ(wrench[5], 3.25);
+
+  // the history is dropped on reset
+  filter_chain.reset();
+  wrench.setConstant(1.0);
+  filter_chain.update(wrench);
+  EXPECT_DOUBLE_EQ(wrench[0], 1.0);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -76,6 +76,7 @@ class TestableAdmittanceController : public admittance_controller::AdmittanceCon
   FRIEND_TEST(AdmittanceControllerTest, all_parameters_set_configure_success);
   FRIEND_TEST(AdmittanceControllerTest, check_interfaces);
   FRIEND_TEST(AdmittanceControllerTest, activate_success);
+  FRIEND_TEST(AdmittanceControllerTest, wrench_from_reference_interfaces);
   FRIEND_TEST(AdmittanceControllerTest, receive_message_and_publish_updated_status);
 
 public:
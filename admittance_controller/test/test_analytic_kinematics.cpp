@@ -0,0 +1,151 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "admittance_controller/analytic_kinematics.hpp"
+#include "pluginlib/class_loader.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "test_asset_6d_robot_description.hpp"
+
+namespace
+{
+const std::vector<std::string> LINKS = {"link_3", "link_6", "tool0"};
+
+std::vector<Eigen::VectorXd> make_joint_states()
+{
+  std::vector<Eigen::VectorXd> joint_states(4, Eigen::VectorXd::Zero(6));
+  joint_states[1] << 0.0, -0.5, 0.8, 0.0, 0.6, 0.0;
+  joint_states[2] << 1.2, -1.1, 0.3, -2.0, 1.4, 0.7;
+  joint_states[3] << -0.4, 0.2, -1.3, 0.9, -0.3, 2.5;
+  return joint_states;
+}
+
+class TestAnalyticKinematics : public testing::Test
+{
+public:
+  static void SetUpTestCase() { rclcpp::init(0, nullptr); }
+  static void TearDownTestCase() { rclcpp::shutdown(); }
+
+protected:
+  void SetUp() override
+  {
+    node_ = std::make_shared<rclcpp::Node>("test_analytic_kinematics");
+    node_->declare_parameter("robot_description", ros2_control_test_assets::valid_6d_robot_urdf);
+    loader_ = std::make_unique<pluginlib::ClassLoader<kinematics_interface::KinematicsInterface>>(
+      "kinematics_interface", "kinematics_interface::KinematicsInterface");
+    kdl_ = loader_->createUniqueInstance("kinematics_interface_kdl/KinematicsInterfaceKDL");
+    ASSERT_TRUE(kdl_->initialize(node_->get_node_parameters_interface(), "tool0"));
+    ASSERT_TRUE(analytic_.initialize(node_->get_node_parameters_interface(), "tool0"));
+  }
+
+  rclcpp::Node::SharedPtr node_;
+  std::unique_ptr<pluginlib::ClassLoader<kinematics_interface::KinematicsInterface>> loader_;
+  pluginlib::UniquePtr<kinematics_interface::KinematicsInterface> kdl_;
+  admittance_controller::AnalyticKinematics analytic_;
+};
+}  // namespace
+
+TEST_F(TestAnalyticKinematics, matches_kdl)
+{
+  ASSERT_EQ(analytic_.get_num_joints(), 6u);
+  Eigen::Isometry3d kdl_transform, analytic_transform;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> kdl_jacobian(6, 6), analytic_jacobian(6, 6);
+  for (const auto & joint_pos : make_joint_states())
+  {
+    for (const auto & link : LINKS)
+    {
+      ASSERT_TRUE(kdl_->calculate_link_transform(joint_pos, link, kdl_transform));
+      ASSERT_TRUE(analytic_.calculate_link_transform(joint_pos, link, analytic_transform));
+      EXPECT_TRUE(analytic_transform.isApprox(kdl_transform, 1e-9)) << link;
+
+      ASSERT_TRUE(kdl_->calculate_jacobian(joint_pos, link, kdl_jacobian));
+      ASSERT_TRUE(analytic_.calculate_jacobian(joint_pos, link, analytic_jacobian));
+      EXPECT_TRUE(analytic_jacobian.isApprox(kdl_jacobian, 1e-9)) << link;
+    }
+
+    const Eigen::Matrix<double, 6, 1> delta_x =
+      (Eigen::Matrix<double, 6, 1>() << 0.01, -0.02, 0.005, 0.01, 0.0, -0.01).finished();
+    Eigen::VectorXd kdl_delta_theta(6), analytic_delta_theta(6);
+    ASSERT_TRUE(
+      kdl_->convert_cartesian_deltas_to_joint_deltas(joint_pos, delta_x, "tool0", kdl_delta_theta));
+    ASSERT_TRUE(analytic_.convert_cartesian_deltas_to_joint_deltas(
+      joint_pos, delta_x, "tool0", analytic_delta_theta));
+    EXPECT_TRUE(analytic_delta_theta.isApprox(kdl_delta_theta, 1e-6));
+
+    Eigen::Matrix<double, 6, 1> kdl_delta_x, analytic_delta_x;
+    ASSERT_TRUE(kdl_->convert_joint_deltas_to_cartesian_deltas(
+      joint_pos, analytic_delta_theta, "tool0", kdl_delta_x));
+    ASSERT_TRUE(analytic_.convert_joint_deltas_to_cartesian_deltas(
+      joint_pos, analytic_delta_theta, "tool0", analytic_delta_x));
+    EXPECT_TRUE(analytic_delta_x.isApprox(kdl_delta_x, 1e-9));
+  }
+}
+
+TEST_F(TestAnalyticKinematics, jacobian_matches_finite_differences)
+{
+  constexpr double step = 1e-7;
+  Eigen::Isometry3d transform, moved_transform;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian(6, 6);
+  for (const auto & joint_pos : make_joint_states())
+  {
+    ASSERT_TRUE(analytic_.calculate_jacobian(joint_pos, "tool0", jacobian));
+    ASSERT_TRUE(analytic_.calculate_link_transform(joint_pos, "tool0", transform));
+    for (Eigen::Index j = 0; j < joint_pos.size(); ++j)
+    {
+      Eigen::VectorXd moved_joint_pos = joint_pos;
+      moved_joint_pos[j] += step;
+      ASSERT_TRUE(analytic_.calculate_link_transform(moved_joint_pos, "tool0", moved_transform));
+      const Eigen::Vector3d linear =
+        (moved_transform.translation() - transform.translation()) / step;
+      const Eigen::AngleAxisd rotation(moved_transform.linear() * transform.linear().transpose());
+      const Eigen::Vector3d angular = rotation.axis() * rotation.angle() / step;
+      EXPECT_TRUE(linear.isApprox(jacobian.block<3, 1>(0, j), 1e-5)) << "joint " << j;
+      EXPECT_TRUE(angular.isApprox(jacobian.block<3, 1>(3, j), 1e-5)) << "joint " << j;
+    }
+  }
+}
+
+TEST_F(TestAnalyticKinematics, root_link_does_not_move)
+{
+  Eigen::Isometry3d transform;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian(6, 6);
+  for (const auto & joint_pos : make_joint_states())
+  {
+    ASSERT_TRUE(analytic_.calculate_link_transform(joint_pos, "base_link", transform));
+    EXPECT_TRUE(transform.isApprox(Eigen::Isometry3d::Identity()));
+    ASSERT_TRUE(analytic_.calculate_jacobian(joint_pos, "base_link", jacobian));
+    EXPECT_TRUE(jacobian.isZero());
+  }
+}
+
+TEST_F(TestAnalyticKinematics, rejects_invalid_arguments)
+{
+  Eigen::Isometry3d transform;
+  Eigen::Matrix<double, 6, Eigen::Dynamic> jacobian(6, 6);
+  EXPECT_FALSE(analytic_.calculate_link_transform(Eigen::VectorXd::Zero(6), "unknown", transform));
+  EXPECT_FALSE(analytic_.calculate_jacobian(Eigen::VectorXd::Zero(6), "unknown", jacobian));
+  EXPECT_FALSE(analytic_.calculate_link_transform(Eigen::VectorXd::Zero(5), "tool0", transform));
+  EXPECT_FALSE(analytic_.calculate_jacobian(Eigen::VectorXd::Zero(7), "tool0", jacobian));
+
+  admittance_controller::AnalyticKinematics kinematics;
+  EXPECT_FALSE(kinematics.initialize_from_urdf(
+    ros2_control_test_assets::valid_6d_robot_urdf, "unknown", 0.000005));
+  EXPECT_FALSE(kinematics.initialize_from_urdf("<robot", "tool0", 0.000005));
+  EXPECT_FALSE(kinematics.calculate_link_transform(Eigen::VectorXd::Zero(6), "tool0", transform));
+}
@@ -44,7 +44,7 @@ controller_interface::CallbackReturn BicycleSteeringController::configure_odomet
     odometry_.set_wheel_params(front_wheel_radius, wheelbase);
   }
 
-  odometry_.set_odometry_type(steering_odometry::BICYCLE_CONFIG);
+  odometry_.set_kinematic_model<steering_odometry::BicycleModel>();
 
   set_interface_numbers(NR_STATE_ITFS, NR_CMD_ITFS, NR_REF_ITFS);
 
@@ -60,10 +60,10 @@ bool BicycleSteeringController::update_odometry(const rclcpp::Duration & period)
   }
   else
   {
-    const double rear_wheel_value = state_interfaces_[STATE_TRACTION_WHEEL].get_value();
-    const double steer_position = state_interfaces_[STATE_STEER_AXIS].get_value();
-    if (!std::isnan(rear_wheel_value) && !std::isnan(steer_position))
+    if (state_values_valid_)
     {
+      const double rear_wheel_value = state_values_[STATE_TRACTION_WHEEL];
+      const double steer_position = state_values_[STATE_STEER_AXIS];
       if (params_.position_feedback)
       {
         // Estimate linear and angular velocity using joint information
@@ -0,0 +1,40 @@
+# Copyright (c) 2024 ros2_control Development Team
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Plugin libraries of the controller packages.
+#
+# With CONTROLLERS_BUNDLE, the controllers are built as static libraries and their plugin
+# descriptions are installed without being exported to pluginlib. ros2_controllers_bundle then
+# links all of them into a single plugin library, which is loaded once for all controllers.
+option(CONTROLLERS_BUNDLE
+  "Build the controllers for the single plugin library of ros2_controllers_bundle" OFF)
+
+# Add the library ${target} of the controllers of a package from the sources in ARGN
+macro(controller_add_plugin_library target)
+  if(CONTROLLERS_BUNDLE)
+    add_library(${target} STATIC ${ARGN})
+    set_target_properties(${target} PROPERTIES POSITION_INDEPENDENT_CODE ON)
+  else()
+    add_library(${target} SHARED ${ARGN})
+  endif()
+endmacro()
+
+# Export the plugin description file ${xml_file} of the controllers of a package
+macro(controller_export_plugin_description_file xml_file)
+  if(CONTROLLERS_BUNDLE)
+    install(FILES ${xml_file} DESTINATION share/${PROJECT_NAME})
+  else()
+    pluginlib_export_plugin_description_file(controller_interface ${xml_file})
+  endif()
+endmacro()
@@ -0,0 +1,191 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__ACTION_MONITOR_HPP_
+#define CONTROLLER_REALTIME_TOOLS__ACTION_MONITOR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <semaphore.h>
+#include <time.h>
+
+#include <cerrno>
+#endif
+
+#include "controller_realtime_tools/thread_scheduling.hpp"
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Thread servicing the action goals of a controller when their state changes.
+ *
+ * Replaces a timer per goal: the controller signals the monitor with notify() whenever a goal
+ * needs the non-realtime side, e.g. the realtime side completed it or set its feedback, and the
+ * monitor runs the service on its thread, at most once per period. While the service returns true
+ * it also runs once per period without a signal, e.g. while a transition of the goal only the
+ * action server can complete is pending. Otherwise the thread sleeps until the next signal.
+ *
+ * notify() is realtime-safe: it sets a flag and, on Linux, posts a semaphore once per run of the
+ * service. On other platforms the monitor checks the flag once per period instead.
+ */
+class ActionMonitor
+{
+public:
+  using Service = std::function<bool()>;
+  using Clock = std::chrono::steady_clock;
+
+  /// Start the thread. Non-realtime.
+  ActionMonitor(std::chrono::nanoseconds period, Service service)
+  : period_(std::max(period, std::chrono::nanoseconds(0))), service_(std::move(service))
+  {
+#if defined(__linux__)
+    sem_init(&semaphore_, 0, 0);
+#endif
+    thread_ = std::thread(&ActionMonitor::run, this);
+  }
+
+  ActionMonitor(const ActionMonitor &) = delete;
+  ActionMonitor & operator=(const ActionMonitor &) = delete;
+
+  /// Wait for a running service and stop the thread. Non-realtime.
+  ~ActionMonitor()
+  {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      keep_running_.store(false);
+    }
+#if defined(__linux__)
+    sem_post(&semaphore_);
+#endif
+    stopped_.notify_all();
+    thread_.join();
+#if defined(__linux__)
+    sem_destroy(&semaphore_);
+#endif
+  }
+
+  /// Request a run of the service. Realtime-safe, wait-free.
+  void notify()
+  {
+    if (!pending_.exchange(true))
+    {
+#if defined(__linux__)
+      sem_post(&semaphore_);
+#endif
+    }
+  }
+
+  /// Apply \p scheduling to the monitoring thread, see set_thread_scheduling(). Non-realtime.
+  bool set_scheduling(const ThreadScheduling & scheduling)
+  {
+    return set_thread_scheduling(thread_, scheduling);
+  }
+
+private:
+  void run()
+  {
+    bool poll = false;
+    Clock::time_point last_run = Clock::now() - period_;
+    while (true)
+    {
+      wait_for_notification(poll ? Clock::now() + period_ : Clock::time_point::max());
+      // run at most once per period, notifications meanwhile are served by this run
+      const Clock::time_point next_run = last_run + period_;
+      while (keep_running_.load() && Clock::now() < next_run)
+      {
+        sleep_until(next_run);
+      }
+      if (!keep_running_.load())
+      {
+        return;
+      }
+      // reset before running, so a notification during the run triggers another one
+      pending_.store(false);
+      last_run = Clock::now();
+      poll = service_();
+    }
+  }
+
+#if defined(__linux__)
+  void wait_for_notification(Clock::time_point deadline)
+  {
+    if (deadline == Clock::time_point::max())
+    {
+      while (sem_wait(&semaphore_) != 0 && errno == EINTR)
+      {
+      }
+      return;
+    }
+    sleep_until(deadline);
+  }
+
+  /// Wait until \p deadline or a notification, which is consumed.
+  void sleep_until(Clock::time_point deadline)
+  {
+    const auto remaining =
+      std::max(Clock::duration::zero(), deadline - Clock::now()) + std::chrono::nanoseconds(1);
+    // sem_timedwait takes a deadline on CLOCK_REALTIME
+    timespec abs_deadline{};
+    clock_gettime(CLOCK_REALTIME, &abs_deadline);
+    const auto nanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() +
+      abs_deadline.tv_nsec;
+    abs_deadline.tv_sec += static_cast<time_t>(nanoseconds / 1000000000);
+    abs_deadline.tv_nsec = static_cast<long>(nanoseconds % 1000000000);  // NOLINT(runtime/int)
+    while (sem_timedwait(&semaphore_, &abs_deadline) != 0 && errno == EINTR)
+    {
+    }
+  }
+#else
+  void wait_for_notification(Clock::time_point deadline)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // check the flag once per period, notify() can't wake the thread without a lock
+    while (keep_running_.load() && !pending_.load() && Clock::now() < deadline)
+    {
+      stopped_.wait_until(lock, std::min(deadline, Clock::now() + period_));
+    }
+  }
+
+  void sleep_until(Clock::time_point deadline)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopped_.wait_until(lock, deadline, [this] { return !keep_running_.load(); });
+  }
+#endif
+
+  const std::chrono::nanoseconds period_;
+  const Service service_;
+  std::atomic<bool> pending_{false};
+  std::atomic<bool> keep_running_{true};
+  // wake the thread when stopping
+  std::mutex mutex_;
+  std::condition_variable stopped_;
+#if defined(__linux__)
+  sem_t semaphore_;
+#endif
+  std::thread thread_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__ACTION_MONITOR_HPP_
@@ -0,0 +1,123 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__BATCHED_PID_HPP_
+#define CONTROLLER_REALTIME_TOOLS__BATCHED_PID_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief PID controllers of several joints, evaluated together.
+ *
+ * Computes the same commands as one control_toolbox::Pid per joint without anti-windup, with the
+ * integral term limited to [-i_clamp, i_clamp]. The gains and integral states are stored per field
+ * for all joints, so the commands of all joints are computed in one call without locking.
+ */
+class BatchedPid
+{
+public:
+  struct Gains
+  {
+    double p = 0.0;
+    double i = 0.0;
+    double d = 0.0;
+    double i_clamp = 0.0;
+  };
+
+  /// Set the number of joints and their gains, and reset the integral states. Not realtime-safe.
+  void configure(const std::vector<Gains> & gains)
+  {
+    const size_t n = gains.size();
+    p_gains_.resize(n);
+    i_gains_.resize(n);
+    d_gains_.resize(n);
+    i_clamps_.resize(n);
+    set_gains(gains);
+    i_errors_.assign(n, 0.0);
+  }
+
+  /**
+   * Replace the gains of all joints, keeping their integral states. Realtime-safe.
+   *
+   * \param[in] gains Gains of every joint, as many as given to configure().
+   */
+  void set_gains(const std::vector<Gains> & gains)
+  {
+    const size_t n = std::min(size(), gains.size());
+    for (size_t j = 0; j < n; ++j)
+    {
+      p_gains_[j] = gains[j].p;
+      i_gains_[j] = gains[j].i;
+      d_gains_[j] = gains[j].d;
+      i_clamps_[j] = gains[j].i_clamp;
+    }
+  }
+
+  /// Reset the integral states of all joints.
+  void reset() { std::fill(i_errors_.begin(), i_errors_.end(), 0.0); }
+
+  /**
+   * Compute the commands of all joints.
+   *
+   * Joints with a non-finite error or error derivative get a zero command and keep their integral
+   * state. If \p dt is not positive, all commands are zero.
+   *
+   * \param[in] error Error of every joint.
+   * \param[in] error_dot Derivative of the error of every joint.
+   * \param[in] dt Time since the last call in seconds.
+   * \param[out] commands Command of every joint.
+   */
+  void compute_commands(
+    const double * error, const double * error_dot, const double dt, double * commands)
+  {
+    const size_t n = size();
+    if (!(dt > 0.0))
+    {
+      std::fill(commands, commands + n, 0.0);
+      return;
+    }
+
+    for (size_t j = 0; j < n; ++j)
+    {
+      if (!std::isfinite(error[j]) || !std::isfinite(error_dot[j]))
+      {
+        commands[j] = 0.0;
+        continue;
+      }
+      i_errors_[j] += dt * error[j];
+      const double i_term = std::clamp(i_gains_[j] * i_errors_[j], -i_clamps_[j], i_clamps_[j]);
+      commands[j] = p_gains_[j] * error[j] + i_term + d_gains_[j] * error_dot[j];
+    }
+  }
+
+  /// Number of joints
+  size_t size() const { return p_gains_.size(); }
+
+private:
+  std::vector<double> p_gains_;
+  std::vector<double> i_gains_;
+  std::vector<double> d_gains_;
+  std::vector<double> i_clamps_;
+  /// Integral of the error of every joint
+  std::vector<double> i_errors_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__BATCHED_PID_HPP_
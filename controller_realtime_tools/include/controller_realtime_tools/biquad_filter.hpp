@@ -0,0 +1,100 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__BIQUAD_FILTER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__BIQUAD_FILTER_HPP_
+
+#include <cmath>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Second-order IIR filter of a signal sampled at a fixed rate, e.g. a force reading.
+ *
+ * The filter is in transposed direct form II, so it only stores two values and all methods are
+ * realtime-safe. The first value after a reset initializes the state as if the signal had always
+ * been that value, so a filter with unity gain at DC doesn't start with a transient from 0.
+ *
+ * Passes the signal through until configured.
+ *
+ * Not thread-safe.
+ */
+class BiquadFilter
+{
+public:
+  /// Set the coefficients, normalized by a0, and reset.
+  void configure(double b0, double b1, double b2, double a1, double a2)
+  {
+    b0_ = b0;
+    b1_ = b1;
+    b2_ = b2;
+    a1_ = a1;
+    a2_ = a2;
+    reset();
+  }
+
+  /**
+   * \brief Configure as a second-order Butterworth low-pass, discretized with the bilinear
+   * transform prewarped at the cutoff frequency.
+   *
+   * \return false, leaving the filter unchanged, unless 0 < \p cutoff_frequency <
+   * \p sampling_frequency / 2.
+   */
+  bool configure_butterworth_low_pass(double cutoff_frequency, double sampling_frequency)
+  {
+    if (!(cutoff_frequency > 0.0 && 2.0 * cutoff_frequency < sampling_frequency))
+    {
+      return false;
+    }
+    const double k = std::tan(M_PI * cutoff_frequency / sampling_frequency);
+    const double norm = 1.0 / (1.0 + M_SQRT2 * k + k * k);
+    const double b0 = k * k * norm;
+    configure(
+      b0, 2.0 * b0, b0, 2.0 * (k * k - 1.0) * norm, (1.0 - M_SQRT2 * k + k * k) * norm);
+    return true;
+  }
+
+  /// Forget the previous values.
+  void reset() { initialized_ = false; }
+
+  /// Add \p value as the latest value of the signal and return the filtered one.
+  double filter(double value)
+  {
+    if (!initialized_)
+    {
+      // steady state for a constant input, exact for unity gain at DC
+      z1_ = value * (1.0 - b0_);
+      z2_ = value * (b2_ - a2_);
+      initialized_ = true;
+    }
+    const double output = b0_ * value + z1_;
+    z1_ = b1_ * value - a1_ * output + z2_;
+    z2_ = b2_ * value - a2_ * output;
+    return output;
+  }
+
+private:
+  double b0_ = 1.0;
+  double b1_ = 0.0;
+  double b2_ = 0.0;
+  double a1_ = 0.0;
+  double a2_ = 0.0;
+  bool initialized_ = false;
+  double z1_ = 0.0;
+  double z2_ = 0.0;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__BIQUAD_FILTER_HPP_
@@ -0,0 +1,86 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__COMMAND_SEQUENCE_HPP_
+#define CONTROLLER_REALTIME_TOOLS__COMMAND_SEQUENCE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Sequence numbers of the commands of a controller, counted up only when a command
+ * changes, for hardware which transmits only the changed commands, e.g. as acyclic fieldbus
+ * transfers.
+ *
+ * Controllers write all of their commands in every cycle, so the hardware can't tell which of them
+ * changed. With this, a controller also writes the sequence number of every command interface
+ * <tt>\<prefix\>/\<interface\></tt> to the command interface
+ * <tt>\<prefix\>/\<interface\>_sequence</tt> of the hardware. The hardware transmits a command
+ * only if its sequence number differs from the one it transmitted last.
+ *
+ * A command changed if it differs bitwise from the previous one, so an unchanged NaN stays
+ * unchanged. The sequence numbers keep counting over restart(), so the hardware never sees the
+ * number of its last transmitted command for a new one. As doubles, they count exactly up to
+ * 2^53.
+ */
+class CommandSequence
+{
+public:
+  /// Name of the sequence interface of the command interface \p name.
+  static std::string interface_name(const std::string & name) { return name + "_sequence"; }
+
+  /// Track \p size commands, starting with the sequence number 0. Non-realtime.
+  void reset(std::size_t size)
+  {
+    previous_.assign(size, 0.0);
+    known_.assign(size, false);
+    sequences_.assign(size, 0);
+  }
+
+  /// Count the next command of every interface as changed, e.g. on activation. Realtime.
+  void restart() { std::fill(known_.begin(), known_.end(), false); }
+
+  /// Count up the sequence number of command \p index if \p command changed. Realtime.
+  /**
+   * \return the sequence number of command \p index
+   */
+  double update(std::size_t index, double command)
+  {
+    if (!known_[index] || std::memcmp(&previous_[index], &command, sizeof(double)) != 0)
+    {
+      previous_[index] = command;
+      known_[index] = true;
+      ++sequences_[index];
+    }
+    return static_cast<double>(sequences_[index]);
+  }
+
+  std::size_t size() const { return sequences_.size(); }
+
+private:
+  std::vector<double> previous_;
+  // whether previous_ holds a command since the last restart()
+  std::vector<bool> known_;
+  std::vector<std::uint64_t> sequences_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__COMMAND_SEQUENCE_HPP_
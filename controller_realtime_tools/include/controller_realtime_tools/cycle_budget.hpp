@@ -0,0 +1,177 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__CYCLE_BUDGET_HPP_
+#define CONTROLLER_REALTIME_TOOLS__CYCLE_BUDGET_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Time budget of the update of a controller, to skip its non-essential stages under load.
+ *
+ * The realtime side measures every update. Once an update takes longer than the budget, the
+ * non-essential stages, e.g. publishing the state, are skipped in the updates of the next
+ * recovery cycles, and also in the rest of an update that is already over the budget. The
+ * commands are always computed and written. The non-realtime side reads the number of updates
+ * over the budget and of skipped stages since its previous read.
+ *
+ * Only one thread may call the realtime methods.
+ */
+class CycleBudget
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Non-realtime, \p stage_names names the stages that can be skipped, by their index.
+  CycleBudget(
+    std::chrono::nanoseconds budget, std::uint32_t recovery_cycles,
+    std::vector<std::string> stage_names)
+  : budget_(budget),
+    recovery_cycles_(recovery_cycles),
+    stage_names_(std::move(stage_names)),
+    skipped_(std::make_unique<Counter[]>(stage_names_.size()))
+  {
+  }
+
+  /// Measures the update it lives in, does nothing without a budget.
+  class Scope
+  {
+  public:
+    explicit Scope(CycleBudget * budget) : budget_(budget)
+    {
+      if (budget_)
+      {
+        budget_->start_cycle();
+      }
+    }
+    ~Scope()
+    {
+      if (budget_)
+      {
+        budget_->end_cycle();
+      }
+    }
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+
+  private:
+    CycleBudget * budget_;
+  };
+
+  /// Mark the start of an update. Realtime, lock-free.
+  void start_cycle() { start_ = Clock::now(); }
+
+  /// Mark the end of an update, which starts shedding if it was over the budget. Realtime.
+  void end_cycle()
+  {
+    if (Clock::now() - start_ > budget_)
+    {
+      shedding_cycles_ = recovery_cycles_;
+      overruns_.add();
+    }
+    else if (shedding_cycles_ > 0)
+    {
+      --shedding_cycles_;
+    }
+  }
+
+  /// Whether to skip \p stage in this update, counted if so. Realtime, lock-free.
+  bool skip(std::size_t stage)
+  {
+    if (shedding_cycles_ == 0 && Clock::now() - start_ <= budget_)
+    {
+      return false;
+    }
+    skipped_[stage].add();
+    return true;
+  }
+
+  /// Number of updates over the budget since the previous call. Non-realtime.
+  std::uint64_t get_overruns() { return overruns_.read(); }
+
+  /// Number of times \p stage was skipped since the previous call. Non-realtime.
+  std::uint64_t get_skipped(std::size_t stage) { return skipped_[stage].read(); }
+
+  /// Summary of the overruns and skipped stages since the previous call, empty if there were
+  /// none. Non-realtime.
+  std::string get_report()
+  {
+    const std::uint64_t overruns = get_overruns();
+    std::string skipped;
+    for (std::size_t stage = 0; stage < stage_names_.size(); ++stage)
+    {
+      const std::uint64_t count = get_skipped(stage);
+      if (count > 0)
+      {
+        skipped += (skipped.empty() ? "" : ", ") + stage_names_[stage] + " " +
+                   std::to_string(count) + " times";
+      }
+    }
+    if (overruns == 0 && skipped.empty())
+    {
+      return "";
+    }
+    return std::to_string(overruns) + " updates over the cycle budget of " +
+           std::to_string(
+             std::chrono::duration_cast<std::chrono::microseconds>(budget_).count()) +
+           " us, skipped " + (skipped.empty() ? std::string("nothing") : skipped);
+  }
+
+private:
+  struct Counter
+  {
+    // written by the realtime side only
+    std::atomic<std::uint64_t> total{0};
+    // total at the last read, only accessed by the non-realtime side
+    std::uint64_t read_total = 0;
+
+    void add()
+    {
+      total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t read()
+    {
+      const std::uint64_t current = total.load(std::memory_order_relaxed);
+      const std::uint64_t count = current - read_total;
+      read_total = current;
+      return count;
+    }
+  };
+
+  static_assert(
+    std::atomic<std::uint64_t>::is_always_lock_free, "CycleBudget requires lock-free atomics");
+
+  Clock::duration budget_;
+  std::uint32_t recovery_cycles_;
+  std::vector<std::string> stage_names_;
+  std::unique_ptr<Counter[]> skipped_;
+  Counter overruns_;
+  // only accessed by the realtime thread
+  Clock::time_point start_;
+  std::uint32_t shedding_cycles_ = 0;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__CYCLE_BUDGET_HPP_
@@ -0,0 +1,152 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__CYCLE_TIMING_HPP_
+#define CONTROLLER_REALTIME_TOOLS__CYCLE_TIMING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Time of the phases of a control cycle, measured in the realtime thread.
+ *
+ * The realtime side marks the start of a cycle and the end of each phase, taking the time of the
+ * phase since the previous mark. The non-realtime side reads the statistics of every phase since
+ * its previous read. Neither side takes a lock or waits for the other one.
+ *
+ * Only one thread may call the realtime methods. The statistics of a read may be off by the
+ * sample recorded at the same time.
+ */
+class CycleTiming
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Statistics
+  {
+    uint64_t count = 0;
+    double mean_ns = 0.0;
+    double min_ns = 0.0;
+    double max_ns = 0.0;
+    double stddev_ns = 0.0;
+  };
+
+  /// Non-realtime.
+  explicit CycleTiming(size_t num_phases)
+  : num_phases_(num_phases), phases_(std::make_unique<Phase[]>(num_phases))
+  {
+  }
+
+  size_t size() const { return num_phases_; }
+
+  /// Mark the start of a cycle. Realtime, lock-free.
+  void start_cycle() { last_mark_ = Clock::now(); }
+
+  /// Record the time since the previous mark for \p phase. Realtime, lock-free.
+  void end_phase(size_t phase)
+  {
+    const auto now = Clock::now();
+    const auto duration_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_mark_).count());
+    last_mark_ = now;
+
+    auto & p = phases_[phase];
+    // single writer, the sums don't need a read-modify-write
+    p.sum_ns.store(
+      p.sum_ns.load(std::memory_order_relaxed) + duration_ns, std::memory_order_relaxed);
+    p.sum_squares_ns.store(
+      p.sum_squares_ns.load(std::memory_order_relaxed) +
+        static_cast<double>(duration_ns) * static_cast<double>(duration_ns),
+      std::memory_order_relaxed);
+    p.count.store(p.count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    // the reader resets the extrema
+    uint64_t min_ns = p.min_ns.load(std::memory_order_relaxed);
+    while (duration_ns < min_ns &&
+           !p.min_ns.compare_exchange_weak(min_ns, duration_ns, std::memory_order_relaxed))
+    {
+    }
+    uint64_t max_ns = p.max_ns.load(std::memory_order_relaxed);
+    while (duration_ns > max_ns &&
+           !p.max_ns.compare_exchange_weak(max_ns, duration_ns, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  /// Get the statistics of \p phase since the previous call. Non-realtime.
+  Statistics get_statistics(size_t phase)
+  {
+    auto & p = phases_[phase];
+    const uint64_t count = p.count.load(std::memory_order_acquire);
+    const uint64_t sum_ns = p.sum_ns.load(std::memory_order_relaxed);
+    const double sum_squares_ns = p.sum_squares_ns.load(std::memory_order_relaxed);
+    const uint64_t min_ns = p.min_ns.exchange(NO_MIN, std::memory_order_relaxed);
+    const uint64_t max_ns = p.max_ns.exchange(0, std::memory_order_relaxed);
+
+    Statistics statistics;
+    statistics.count = count - p.read_count;
+    if (statistics.count > 0)
+    {
+      const auto n = static_cast<double>(statistics.count);
+      statistics.mean_ns = static_cast<double>(sum_ns - p.read_sum_ns) / n;
+      const double variance =
+        (sum_squares_ns - p.read_sum_squares_ns) / n - statistics.mean_ns * statistics.mean_ns;
+      statistics.stddev_ns = std::sqrt(std::max(variance, 0.0));
+      statistics.min_ns = min_ns == NO_MIN ? statistics.mean_ns : static_cast<double>(min_ns);
+      statistics.max_ns = static_cast<double>(max_ns);
+    }
+    p.read_count = count;
+    p.read_sum_ns = sum_ns;
+    p.read_sum_squares_ns = sum_squares_ns;
+    return statistics;
+  }
+
+private:
+  static constexpr uint64_t NO_MIN = std::numeric_limits<uint64_t>::max();
+
+  struct Phase
+  {
+    // running totals, written by the realtime side only
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum_ns{0};
+    std::atomic<double> sum_squares_ns{0.0};
+    // extrema since the last read
+    std::atomic<uint64_t> min_ns{NO_MIN};
+    std::atomic<uint64_t> max_ns{0};
+    // totals at the last read, only accessed by the non-realtime side
+    uint64_t read_count = 0;
+    uint64_t read_sum_ns = 0;
+    double read_sum_squares_ns = 0.0;
+  };
+
+  static_assert(
+    std::atomic<uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+    "CycleTiming requires lock-free atomics");
+
+  size_t num_phases_;
+  std::unique_ptr<Phase[]> phases_;
+  // only accessed by the realtime thread
+  Clock::time_point last_mark_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__CYCLE_TIMING_HPP_
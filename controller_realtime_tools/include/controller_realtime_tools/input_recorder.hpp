@@ -0,0 +1,327 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__INPUT_RECORDER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__INPUT_RECORDER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Format of the files of the InputRecorder, in the native byte order:
+ *  - the 8 characters of INPUT_RECORDING_MAGIC and the uint32 INPUT_RECORDING_VERSION,
+ *  - the uint32 number of state interfaces, and the uint32 length and the characters of the name
+ *    of each of them,
+ *  - the uint32 number of reference values,
+ *  - one frame per cycle until the end of the file: the int64 time and period of the cycle [ns],
+ *    the double values of the state interfaces and then the ones of the references.
+ */
+constexpr char INPUT_RECORDING_MAGIC[8] = {'C', 'T', 'R', 'L', 'I', 'N', 'P', 'T'};
+constexpr std::uint32_t INPUT_RECORDING_VERSION = 1;
+
+/**
+ * \brief Records the inputs of the update of a controller in every cycle to a file, to replay
+ * them offline with replay_inputs().
+ *
+ * The realtime thread copies the values of the state interfaces, the references and the time and
+ * period of the cycle into a preallocated ring. A thread of the recorder drains the ring into the
+ * file every drain period. Neither side takes a lock or waits for the other one; frames are
+ * dropped while the ring is full.
+ *
+ * Only one thread may record.
+ */
+class InputRecorder
+{
+public:
+  /// Non-realtime, opens \p path and starts the thread writing the recorded frames to it.
+  /**
+   * \param capacity Number of frames kept until the thread writes them.
+   */
+  InputRecorder(
+    const std::string & path, const std::vector<std::string> & state_names,
+    std::size_t num_references, std::size_t capacity = 1024,
+    std::chrono::milliseconds drain_period = std::chrono::milliseconds(10))
+  : num_states_(state_names.size()),
+    frame_size_(state_names.size() + num_references),
+    // one slot stays empty to tell a full ring from an empty one
+    capacity_(capacity + 1),
+    times_(std::make_unique<std::int64_t[]>(2 * (capacity + 1))),
+    values_(std::make_unique<double[]>(frame_size_ * (capacity + 1))),
+    file_(path, std::ios::binary | std::ios::trunc)
+  {
+    file_.write(INPUT_RECORDING_MAGIC, sizeof(INPUT_RECORDING_MAGIC));
+    write_value(INPUT_RECORDING_VERSION);
+    write_value(static_cast<std::uint32_t>(state_names.size()));
+    for (const auto & name : state_names)
+    {
+      write_value(static_cast<std::uint32_t>(name.size()));
+      file_.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+    write_value(static_cast<std::uint32_t>(num_references));
+    if (file_)
+    {
+      thread_ = std::thread(
+        [this, drain_period]()
+        {
+          std::unique_lock<std::mutex> lock(stop_mutex_);
+          while (!stop_condition_.wait_for(lock, drain_period, [this] { return stop_; }))
+          {
+            drain();
+          }
+        });
+    }
+  }
+
+  InputRecorder(const InputRecorder &) = delete;
+  InputRecorder & operator=(const InputRecorder &) = delete;
+
+  /// Non-realtime, writes the frames left in the ring and closes the file.
+  ~InputRecorder()
+  {
+    if (thread_.joinable())
+    {
+      {
+        std::lock_guard<std::mutex> guard(stop_mutex_);
+        stop_ = true;
+      }
+      stop_condition_.notify_all();
+      thread_.join();
+    }
+    drain();
+  }
+
+  /// The file was opened and all frames drained so far were written to it.
+  bool good()
+  {
+    std::lock_guard<std::mutex> guard(drain_mutex_);
+    return static_cast<bool>(file_);
+  }
+
+  /// Record the inputs of a cycle at \p time_ns lasting \p period_ns. Realtime, wait-free.
+  /**
+   * \param state_interfaces The state interfaces, with get_value(), in the order of the names.
+   * \param references The reference values.
+   * \return false if the frame was dropped, because the ring is full or the sizes don't match.
+   */
+  template <typename StateInterfaces, typename References>
+  bool record(
+    std::int64_t time_ns, std::int64_t period_ns, const StateInterfaces & state_interfaces,
+    const References & references)
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t next = (head + 1) % capacity_;
+    if (
+      next == tail_.load(std::memory_order_acquire) || state_interfaces.size() != num_states_ ||
+      references.size() != frame_size_ - num_states_)
+    {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    times_[2 * head] = time_ns;
+    times_[2 * head + 1] = period_ns;
+    double * values = &values_[frame_size_ * head];
+    for (std::size_t i = 0; i < num_states_; ++i)
+    {
+      values[i] = state_interfaces[i].get_value();
+    }
+    for (std::size_t i = 0; i < frame_size_ - num_states_; ++i)
+    {
+      values[num_states_ + i] = references[i];
+    }
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// Write the recorded frames to the file now, besides the thread. Non-realtime.
+  void drain()
+  {
+    std::lock_guard<std::mutex> guard(drain_mutex_);
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; tail = (tail + 1) % capacity_)
+    {
+      file_.write(
+        reinterpret_cast<const char *>(&times_[2 * tail]), 2 * sizeof(std::int64_t));
+      file_.write(
+        reinterpret_cast<const char *>(&values_[frame_size_ * tail]),
+        static_cast<std::streamsize>(frame_size_ * sizeof(double)));
+    }
+    tail_.store(tail, std::memory_order_release);
+    file_.flush();
+  }
+
+  /// Number of frames dropped since construction.
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  template <typename T>
+  void write_value(T value)
+  {
+    file_.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  static_assert(
+    std::atomic<std::size_t>::is_always_lock_free &&
+      std::atomic<std::uint64_t>::is_always_lock_free,
+    "InputRecorder requires lock-free atomics");
+
+  std::size_t num_states_;
+  std::size_t frame_size_;
+  std::size_t capacity_;
+  // time and period of each frame, and its values of the states and then the references
+  std::unique_ptr<std::int64_t[]> times_;
+  std::unique_ptr<double[]> values_;
+  // next frame written by the realtime thread, and next one written to the file
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+
+  // guarded by drain_mutex_, never taken by the realtime thread
+  std::mutex drain_mutex_;
+  std::ofstream file_;
+
+  std::mutex stop_mutex_;
+  std::condition_variable stop_condition_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+/**
+ * \brief Inputs of a controller read from a file of the InputRecorder.
+ */
+struct InputRecording
+{
+  std::vector<std::string> state_names;
+  std::size_t num_references = 0;
+  // time and period of each frame [ns]
+  std::vector<std::int64_t> times_ns;
+  std::vector<std::int64_t> periods_ns;
+  // per frame the values of the states and then the ones of the references
+  std::vector<double> values;
+
+  std::size_t size() const { return times_ns.size(); }
+  std::size_t frame_size() const { return state_names.size() + num_references; }
+  const double * states(std::size_t frame) const { return &values[frame * frame_size()]; }
+  const double * references(std::size_t frame) const
+  {
+    return states(frame) + state_names.size();
+  }
+};
+
+/// Read the file \p path of an InputRecorder. Non-realtime.
+/**
+ * A frame cut off at the end of the file, e.g. by a crash, is ignored.
+ * \return false if the file can't be read or isn't a recording of this version.
+ */
+inline bool read_input_recording(const std::string & path, InputRecording & recording)
+{
+  std::ifstream file(path, std::ios::binary);
+  const auto read_value = [&file](auto & value)
+  { return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(value))); };
+
+  char magic[sizeof(INPUT_RECORDING_MAGIC)];
+  std::uint32_t version = 0;
+  std::uint32_t num_states = 0;
+  if (
+    !file.read(magic, sizeof(magic)) ||
+    std::memcmp(magic, INPUT_RECORDING_MAGIC, sizeof(magic)) != 0 || !read_value(version) ||
+    version != INPUT_RECORDING_VERSION || !read_value(num_states))
+  {
+    return false;
+  }
+  recording = InputRecording();
+  recording.state_names.resize(num_states);
+  for (auto & name : recording.state_names)
+  {
+    std::uint32_t length = 0;
+    if (!read_value(length))
+    {
+      return false;
+    }
+    name.resize(length);
+    if (!file.read(&name[0], length))
+    {
+      return false;
+    }
+  }
+  std::uint32_t num_references = 0;
+  if (!read_value(num_references))
+  {
+    return false;
+  }
+  recording.num_references = num_references;
+
+  std::int64_t times[2];
+  std::vector<double> frame(recording.frame_size());
+  const auto frame_bytes = static_cast<std::streamsize>(frame.size() * sizeof(double));
+  while (read_value(times) && file.read(reinterpret_cast<char *>(frame.data()), frame_bytes))
+  {
+    recording.times_ns.push_back(times[0]);
+    recording.periods_ns.push_back(times[1]);
+    recording.values.insert(recording.values.end(), frame.begin(), frame.end());
+  }
+  return true;
+}
+
+/**
+ * \brief Feed the inputs of \p recording back into a controller, frame by frame.
+ *
+ * Every frame writes the recorded values into the state interfaces and the references the
+ * controller reads, e.g. the doubles behind the state interfaces of a test and the reference
+ * interfaces of the controller in chained mode, and then calls update(time_ns, period_ns), which
+ * runs the update of the controller.
+ *
+ * \return false if the numbers of values don't match the recording, then nothing is replayed.
+ */
+template <typename Update>
+bool replay_inputs(
+  const InputRecording & recording, const std::vector<double *> & state_values,
+  const std::vector<double *> & reference_values, Update && update)
+{
+  if (
+    state_values.size() != recording.state_names.size() ||
+    reference_values.size() != recording.num_references)
+  {
+    return false;
+  }
+  for (std::size_t frame = 0; frame < recording.size(); ++frame)
+  {
+    for (std::size_t i = 0; i < state_values.size(); ++i)
+    {
+      *state_values[i] = recording.states(frame)[i];
+    }
+    for (std::size_t i = 0; i < reference_values.size(); ++i)
+    {
+      *reference_values[i] = recording.references(frame)[i];
+    }
+    update(recording.times_ns[frame], recording.periods_ns[frame]);
+  }
+  return true;
+}
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__INPUT_RECORDER_HPP_
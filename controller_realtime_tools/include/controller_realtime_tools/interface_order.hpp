@@ -0,0 +1,103 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__INTERFACE_ORDER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__INTERFACE_ORDER_HPP_
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Positions of the loaned interfaces of a controller in the order the controller uses them.
+ *
+ * controller_interface::get_ordered_interfaces() compares every name with every loaned interface
+ * on each activation. The positions found here on one activation are checked with one comparison
+ * per interface on the next, and only looked up again if the interfaces are loaned in another
+ * order, with a hash map instead of nested loops.
+ */
+class InterfaceOrder
+{
+public:
+  /// Set the full names of the interfaces, <prefix>/<interface>, in the order of the controller.
+  /// Not realtime-safe.
+  void configure(std::vector<std::string> names)
+  {
+    names_ = std::move(names);
+    indices_.clear();
+    indices_.reserve(names_.size());
+  }
+
+  /**
+   * \brief Find the configured interfaces in \p interfaces, whose get_name() gives their full
+   * name.
+   * \return false if one of them is missing, indices() is empty then.
+   */
+  template <typename InterfaceT>
+  bool update(const std::vector<InterfaceT> & interfaces)
+  {
+    if (indices_.size() == names_.size() && matches(interfaces))
+    {
+      return true;
+    }
+    indices_.clear();
+    std::unordered_map<std::string, size_t> positions;
+    positions.reserve(interfaces.size());
+    for (size_t i = 0; i < interfaces.size(); ++i)
+    {
+      positions.emplace(interfaces[i].get_name(), i);
+    }
+    for (const auto & name : names_)
+    {
+      const auto it = positions.find(name);
+      if (it == positions.end())
+      {
+        indices_.clear();
+        return false;
+      }
+      indices_.push_back(it->second);
+    }
+    return true;
+  }
+
+  /// Position in the interfaces given to update() of every configured interface, in their order
+  const std::vector<size_t> & indices() const { return indices_; }
+
+  const std::vector<std::string> & names() const { return names_; }
+
+private:
+  template <typename InterfaceT>
+  bool matches(const std::vector<InterfaceT> & interfaces) const
+  {
+    for (size_t i = 0; i < names_.size(); ++i)
+    {
+      if (indices_[i] >= interfaces.size() || interfaces[indices_[i]].get_name() != names_[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<std::string> names_;
+  std::vector<size_t> indices_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__INTERFACE_ORDER_HPP_
@@ -0,0 +1,172 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__JITTER_BUFFER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__JITTER_BUFFER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Plays out stamped commands a fixed delay after their stamp, e.g. commands sent over a
+ * lossy wireless link, which arrive in bursts and with gaps.
+ *
+ * The subscription callback pushes each command with its stamp, the realtime thread plays them
+ * out in the order of their stamps: a command is due once the time minus the delay reached its
+ * stamp, and the latest due command stays the current one until the next one is due. A burst
+ * of commands is thereby spread out again as it was sent, at the cost of a known latency of the
+ * delay.
+ *
+ * Up to \p Capacity commands wait for their turn. A command stamped before the current one
+ * arrived too late and is dropped, as is the oldest waiting command if a new one doesn't fit.
+ * Nothing is allocated, and neither side takes a lock or waits for the other one, so both are
+ * realtime-safe as long as copying T is.
+ *
+ * Only one thread may push commands and only one thread may play them out.
+ */
+template <typename T, std::size_t Capacity>
+class JitterBuffer
+{
+  static_assert(Capacity > 0, "JitterBuffer requires a capacity of at least one command");
+
+public:
+  /// Set the delay between the stamp of a command and its play out. Non-realtime, before use.
+  void set_delay(std::int64_t delay_ns) { delay_ns_ = delay_ns; }
+  std::int64_t delay() const { return delay_ns_; }
+
+  /// Forget all commands. Non-realtime, while no command is pushed or played out.
+  void reset()
+  {
+    tail_.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    size_ = 0;
+    has_current_ = false;
+    dropped_.store(0, std::memory_order_relaxed);
+  }
+
+  /// Queue \p value stamped \p stamp_ns for its play out. Wait-free.
+  /**
+   * \return false if the command is dropped, because the realtime thread didn't take the
+   * previous ones yet
+   */
+  bool push(std::int64_t stamp_ns, const T & value)
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t next = (head + 1) % kIncomingSize;
+    if (next == tail_.load(std::memory_order_acquire))
+    {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    incoming_[head] = {stamp_ns, value};
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// Play out the commands due at \p now_ns. Realtime, wait-free.
+  /**
+   * \return whether there is a current command, i.e. any command was due since reset()
+   */
+  bool play_out(std::int64_t now_ns)
+  {
+    // take the pushed commands into the queue ordered by their stamps
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; tail = (tail + 1) % kIncomingSize)
+    {
+      insert(incoming_[tail]);
+    }
+    tail_.store(tail, std::memory_order_release);
+
+    const std::int64_t play_out_ns = now_ns - delay_ns_;
+    std::size_t due = 0;
+    while (due < size_ && queue_[due].stamp_ns <= play_out_ns)
+    {
+      ++due;
+    }
+    if (due > 0)
+    {
+      current_ = queue_[due - 1];
+      has_current_ = true;
+      std::copy(queue_.begin() + due, queue_.begin() + size_, queue_.begin());
+      size_ -= due;
+    }
+    return has_current_;
+  }
+
+  /// The current command and its stamp, after play_out() returned true. Realtime.
+  const T & value() const { return current_.value; }
+  std::int64_t stamp() const { return current_.stamp_ns; }
+
+  /// Number of commands waiting for their turn. Realtime.
+  std::size_t size() const { return size_; }
+  static constexpr std::size_t capacity() { return Capacity; }
+
+  /// Number of commands dropped since reset(), because they arrived too late or didn't fit.
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  struct Entry
+  {
+    std::int64_t stamp_ns;
+    T value;
+  };
+
+  void insert(const Entry & entry)
+  {
+    // its turn is over
+    if (has_current_ && entry.stamp_ns < current_.stamp_ns)
+    {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    if (size_ == Capacity)
+    {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      std::copy(queue_.begin() + 1, queue_.begin() + size_, queue_.begin());
+      --size_;
+    }
+    // commands with the same stamp keep the order of their arrival
+    std::size_t i = size_;
+    for (; i > 0 && queue_[i - 1].stamp_ns > entry.stamp_ns; --i)
+    {
+      queue_[i] = queue_[i - 1];
+    }
+    queue_[i] = entry;
+    ++size_;
+  }
+
+  // one slot stays empty to tell a full ring from an empty one
+  static constexpr std::size_t kIncomingSize = Capacity + 1;
+
+  std::int64_t delay_ns_ = 0;
+  // pushed commands, not taken by play_out() yet
+  std::array<Entry, kIncomingSize> incoming_{};
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+  // commands waiting for their turn, ordered by their stamps, realtime only
+  std::array<Entry, Capacity> queue_{};
+  std::size_t size_ = 0;
+  Entry current_{};
+  bool has_current_ = false;
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__JITTER_BUFFER_HPP_
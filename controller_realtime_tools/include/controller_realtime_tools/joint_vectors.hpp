@@ -0,0 +1,116 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__JOINT_VECTORS_HPP_
+#define CONTROLLER_REALTIME_TOOLS__JOINT_VECTORS_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Positions, velocities, accelerations and efforts of the joints of a controller, the
+ * working storage of its realtime loop instead of a trajectory_msgs::msg::JointTrajectoryPoint.
+ *
+ * Every field holds either one value per joint or, if the controller doesn't have it, none, as
+ * the fields of the message do, so code written for the message also works with it. The storage
+ * of all fields is reserved for all joints once by reserve(), so making a field present or absent
+ * and copy assigning a JointVectors of the same joints never allocates. Messages are only filled
+ * at the boundaries, e.g. when publishing, with to_msg().
+ */
+struct JointVectors
+{
+  std::vector<double> positions;
+  std::vector<double> velocities;
+  std::vector<double> accelerations;
+  std::vector<double> effort;
+
+  /// Reserve the storage of all fields for \p num_joints. Non-realtime.
+  void reserve(std::size_t num_joints)
+  {
+    positions.reserve(num_joints);
+    velocities.reserve(num_joints);
+    accelerations.reserve(num_joints);
+    effort.reserve(num_joints);
+    num_joints_ = num_joints;
+  }
+
+  /// Reserve the storage for \p num_joints, and make the given fields present with 0.0 and the
+  /// others absent. Non-realtime.
+  void resize(
+    std::size_t num_joints, bool has_velocities, bool has_accelerations, bool has_effort = false)
+  {
+    reserve(num_joints);
+    positions.assign(num_joints, 0.0);
+    velocities.assign(has_velocities ? num_joints : 0, 0.0);
+    accelerations.assign(has_accelerations ? num_joints : 0, 0.0);
+    effort.assign(has_effort ? num_joints : 0, 0.0);
+  }
+
+  /// Number of joints the storage is reserved for.
+  std::size_t num_joints() const { return num_joints_; }
+
+  bool has_positions() const { return !positions.empty(); }
+  bool has_velocities() const { return !velocities.empty(); }
+  bool has_accelerations() const { return !accelerations.empty(); }
+  bool has_effort() const { return !effort.empty(); }
+
+  /// Make \p field present with \p value for all joints, or absent. Realtime.
+  void set_present(std::vector<double> & field, bool present, double value = 0.0)
+  {
+    field.assign(present ? num_joints_ : 0, value);
+  }
+
+  /// Copy the fields into \p point, e.g. a JointTrajectoryPoint, absent ones are cleared.
+  /**
+   * Realtime if the fields of \p point have the capacity for all joints.
+   */
+  template <typename PointT>
+  void to_msg(PointT & point) const
+  {
+    point.positions.assign(positions.begin(), positions.end());
+    point.velocities.assign(velocities.begin(), velocities.end());
+    point.accelerations.assign(accelerations.begin(), accelerations.end());
+    point.effort.assign(effort.begin(), effort.end());
+  }
+
+  /// Copy the fields of \p point, e.g. a JointTrajectoryPoint, with up to num_joints() values.
+  /**
+   * Realtime. Values beyond num_joints() are ignored, so the storage is never reallocated.
+   */
+  template <typename PointT>
+  void from_msg(const PointT & point)
+  {
+    copy_field(point.positions, positions);
+    copy_field(point.velocities, velocities);
+    copy_field(point.accelerations, accelerations);
+    copy_field(point.effort, effort);
+  }
+
+private:
+  template <typename FieldT>
+  void copy_field(const FieldT & source, std::vector<double> & field)
+  {
+    field.assign(source.begin(), source.begin() + static_cast<std::ptrdiff_t>(
+                                                    std::min(source.size(), num_joints_)));
+  }
+
+  std::size_t num_joints_ = 0;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__JOINT_VECTORS_HPP_
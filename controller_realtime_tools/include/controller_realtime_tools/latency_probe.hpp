@@ -0,0 +1,216 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__LATENCY_PROBE_HPP_
+#define CONTROLLER_REALTIME_TOOLS__LATENCY_PROBE_HPP_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Latency of commands from their publication to their write to the command interfaces.
+ *
+ * The subscription callback notes the stamp of each command and the time it was received, the
+ * realtime thread notes the time the latest command was first written to the command interfaces.
+ * Each written command is a sample, pushed into a ring the non-realtime side drains to get the
+ * statistics of each stage. Commands replaced before the realtime thread wrote them are not
+ * sampled. Neither side takes a lock or waits for the other one; samples are dropped while the
+ * ring is full.
+ *
+ * All times are in nanoseconds of the same clock, e.g. the node clock. Commands without a stamp
+ * only have a receive to write latency.
+ *
+ * Only one thread may note received commands and only one thread may note written ones.
+ */
+class LatencyProbe
+{
+public:
+  enum Stage : std::size_t
+  {
+    PUBLISH_TO_RECEIVE,
+    RECEIVE_TO_WRITE,
+    PUBLISH_TO_WRITE,
+    NUM_STAGES
+  };
+  static constexpr std::array<const char *, NUM_STAGES> STAGE_NAMES = {
+    "publish_to_receive", "receive_to_write", "publish_to_write"};
+
+  struct Statistics
+  {
+    std::uint64_t count = 0;
+    double mean_ns = 0.0;
+    double min_ns = 0.0;
+    double max_ns = 0.0;
+    double stddev_ns = 0.0;
+  };
+
+  /// Non-realtime, \p capacity is the number of samples kept until the next read.
+  explicit LatencyProbe(std::size_t capacity = 1024)
+  : received_(Received()),
+    // one slot stays empty to tell a full ring from an empty one
+    capacity_(capacity + 1),
+    samples_(std::make_unique<Sample[]>(capacity + 1))
+  {
+  }
+
+  LatencyProbe(const LatencyProbe &) = delete;
+  LatencyProbe & operator=(const LatencyProbe &) = delete;
+
+  /// Note a command stamped \p stamp_ns, 0 if it has no stamp, received at \p receive_ns.
+  /// Wait-free.
+  void command_received(std::int64_t stamp_ns, std::int64_t receive_ns)
+  {
+    auto & received = received_.write_buffer();
+    received.sequence = ++received_sequence_;
+    received.stamp_ns = stamp_ns;
+    received.receive_ns = receive_ns;
+    received_.publish();
+  }
+
+  /// Note that the latest received command is written at \p write_ns. Realtime, wait-free.
+  /**
+   * Only its first write is sampled, so this can be called in every cycle writing the command.
+   */
+  void command_written(std::int64_t write_ns)
+  {
+    const auto & received = received_.read();
+    if (received.sequence == written_sequence_)
+    {
+      return;
+    }
+    written_sequence_ = received.sequence;
+
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t next = (head + 1) % capacity_;
+    if (next == tail_.load(std::memory_order_acquire))
+    {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return;
+    }
+    samples_[head] = {received.stamp_ns, received.receive_ns, write_ns};
+    head_.store(next, std::memory_order_release);
+  }
+
+  /// Get the statistics of each stage of the commands written since the previous call.
+  /// Non-realtime.
+  std::array<Statistics, NUM_STAGES> get_statistics()
+  {
+    std::array<Accumulator, NUM_STAGES> accumulators;
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; tail = (tail + 1) % capacity_)
+    {
+      const Sample & sample = samples_[tail];
+      accumulators[RECEIVE_TO_WRITE].add(sample.write_ns - sample.receive_ns);
+      if (sample.stamp_ns != 0)
+      {
+        accumulators[PUBLISH_TO_RECEIVE].add(sample.receive_ns - sample.stamp_ns);
+        accumulators[PUBLISH_TO_WRITE].add(sample.write_ns - sample.stamp_ns);
+      }
+    }
+    tail_.store(tail, std::memory_order_release);
+
+    std::array<Statistics, NUM_STAGES> statistics;
+    for (std::size_t stage = 0; stage < NUM_STAGES; ++stage)
+    {
+      statistics[stage] = accumulators[stage].get();
+    }
+    return statistics;
+  }
+
+  /// Number of samples dropped because the ring was full, since construction.
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  struct Received
+  {
+    std::uint64_t sequence = 0;
+    std::int64_t stamp_ns = 0;
+    std::int64_t receive_ns = 0;
+  };
+
+  struct Sample
+  {
+    std::int64_t stamp_ns = 0;
+    std::int64_t receive_ns = 0;
+    std::int64_t write_ns = 0;
+  };
+
+  struct Accumulator
+  {
+    std::uint64_t count = 0;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(std::int64_t latency_ns)
+    {
+      const auto latency = static_cast<double>(latency_ns);
+      ++count;
+      sum += latency;
+      sum_squares += latency * latency;
+      min = std::min(min, latency);
+      max = std::max(max, latency);
+    }
+
+    Statistics get() const
+    {
+      Statistics statistics;
+      statistics.count = count;
+      if (count > 0)
+      {
+        const auto n = static_cast<double>(count);
+        statistics.mean_ns = sum / n;
+        statistics.stddev_ns =
+          std::sqrt(std::max(sum_squares / n - statistics.mean_ns * statistics.mean_ns, 0.0));
+        statistics.min_ns = min;
+        statistics.max_ns = max;
+      }
+      return statistics;
+    }
+  };
+
+  static_assert(
+    std::atomic<std::size_t>::is_always_lock_free &&
+      std::atomic<std::uint64_t>::is_always_lock_free,
+    "LatencyProbe requires lock-free atomics");
+
+  RealtimeTripleBuffer<Received> received_;
+  // only accessed by the thread noting received commands
+  std::uint64_t received_sequence_ = 0;
+  // only accessed by the realtime thread
+  std::uint64_t written_sequence_ = 0;
+
+  std::size_t capacity_;
+  std::unique_ptr<Sample[]> samples_;
+  // next sample written by the realtime thread, and next one read by the non-realtime side
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__LATENCY_PROBE_HPP_
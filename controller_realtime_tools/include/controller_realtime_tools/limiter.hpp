@@ -0,0 +1,173 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__LIMITER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__LIMITER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Limits of a command and of its first two differences over time, for several channels.
+ *
+ * Each channel is a command, e.g. a wheel velocity or a steering position, limited in three
+ * stages applied in this order:
+ *  - its second rate, (v - 2 * v0 + v1) / (2 * dt^2), e.g. the jerk of a velocity,
+ *  - its rate, (v - v0) / dt, e.g. the acceleration of a velocity, with separate limits while
+ *    the magnitude of the command decreases, e.g. its deceleration,
+ *  - its value.
+ *
+ * The limits of a stage are a lower and an upper bound and a minimum magnitude, all of them NaN,
+ * i.e. not applied, until set. The limits are stored by stage for all channels, so each stage
+ * is a loop over the channels without branches which the compilers vectorize, and limiting
+ * neither allocates nor throws.
+ */
+template <std::size_t Channels>
+class Limiter
+{
+public:
+  using Values = std::array<double, Channels>;
+
+  /// Set the limits of the value of \p channel, NaN not to apply one of them.
+  void set_value_limits(
+    std::size_t channel, double lower, double upper,
+    double min_magnitude = std::numeric_limits<double>::quiet_NaN())
+  {
+    value_.set(channel, lower, upper, min_magnitude);
+  }
+
+  /// Set the limits of the rate of \p channel, also while its magnitude decreases.
+  void set_rate_limits(
+    std::size_t channel, double lower, double upper,
+    double min_magnitude = std::numeric_limits<double>::quiet_NaN())
+  {
+    rate_.set(channel, lower, upper, min_magnitude);
+    decreasing_rate_.set(channel, lower, upper, min_magnitude);
+  }
+
+  /// Set the limits of the rate of \p channel while its magnitude decreases, after the rate ones.
+  void set_decreasing_rate_limits(
+    std::size_t channel, double lower, double upper,
+    double min_magnitude = std::numeric_limits<double>::quiet_NaN())
+  {
+    decreasing_rate_.set(channel, lower, upper, min_magnitude);
+  }
+
+  /// Set the limits of the second rate of \p channel.
+  void set_second_rate_limits(
+    std::size_t channel, double lower, double upper,
+    double min_magnitude = std::numeric_limits<double>::quiet_NaN())
+  {
+    second_rate_.set(channel, lower, upper, min_magnitude);
+  }
+
+  /**
+   * \brief Limit the second rate, the rate and the value of all channels
+   * \param [in, out] v  Commands
+   * \param [in]      v0 Previous commands to v
+   * \param [in]      v1 Previous commands to v0
+   * \param [in]      dt Time step [s]
+   */
+  void limit(Values & v, const Values & v0, const Values & v1, double dt) const
+  {
+    limit_second_rate(v, v0, v1, dt);
+    limit_rate(v, v0, dt);
+    limit_value(v);
+  }
+
+  /// Limit the value of all channels.
+  void limit_value(Values & v) const
+  {
+    for (std::size_t i = 0; i < Channels; ++i)
+    {
+      v[i] = clamp(v[i], value_.lower[i], value_.upper[i], value_.min_magnitude[i], 1.0);
+    }
+  }
+
+  /// Limit the rate of all channels, with the decreasing limits where |v| < |v0|.
+  void limit_rate(Values & v, const Values & v0, double dt) const
+  {
+    for (std::size_t i = 0; i < Channels; ++i)
+    {
+      const double dv = v[i] - v0[i];
+      // select the limits rather than the stage, so the loop has no branch
+      const bool decreasing = std::fabs(v[i]) < std::fabs(v0[i]);
+      const double limited = clamp(
+        dv, decreasing ? decreasing_rate_.lower[i] : rate_.lower[i],
+        decreasing ? decreasing_rate_.upper[i] : rate_.upper[i],
+        decreasing ? decreasing_rate_.min_magnitude[i] : rate_.min_magnitude[i], dt);
+      // adding 0 keeps the commands within their limits exactly as they were
+      v[i] += limited - dv;
+    }
+  }
+
+  /// Limit the second rate of all channels.
+  void limit_second_rate(Values & v, const Values & v0, const Values & v1, double dt) const
+  {
+    const double dt2 = 2. * dt * dt;
+    for (std::size_t i = 0; i < Channels; ++i)
+    {
+      const double da = (v[i] - v0[i]) - (v0[i] - v1[i]);
+      const double limited = clamp(
+        da, second_rate_.lower[i], second_rate_.upper[i], second_rate_.min_magnitude[i], dt2);
+      v[i] += limited - da;
+    }
+  }
+
+private:
+  struct Limits
+  {
+    Values lower = nan_values();
+    Values upper = nan_values();
+    Values min_magnitude = nan_values();
+
+    void set(std::size_t channel, double lower_limit, double upper_limit, double min_value)
+    {
+      lower[channel] = lower_limit;
+      upper[channel] = upper_limit;
+      min_magnitude[channel] = min_value;
+    }
+  };
+
+  /// Clamp \p x to the limits times \p scale, comparisons with NaN limits keep x as it is.
+  static double clamp(double x, double lower, double upper, double min_magnitude, double scale)
+  {
+    x = std::copysign(std::max(std::fabs(x), min_magnitude * scale), x);
+    return std::min(std::max(x, lower * scale), upper * scale);
+  }
+
+  static Values nan_values()
+  {
+    Values values{};
+    for (auto & value : values)
+    {
+      value = std::numeric_limits<double>::quiet_NaN();
+    }
+    return values;
+  }
+
+  Limits value_;
+  Limits rate_;
+  Limits decreasing_rate_;
+  Limits second_rate_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__LIMITER_HPP_
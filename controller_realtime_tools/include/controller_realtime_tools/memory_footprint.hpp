@@ -0,0 +1,213 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__MEMORY_FOOTPRINT_HPP_
+#define CONTROLLER_REALTIME_TOOLS__MEMORY_FOOTPRINT_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#endif
+
+namespace controller_realtime_tools
+{
+/// Bytes held per buffer of a controller, by the name of the buffer.
+using MemoryFootprint = std::vector<std::pair<std::string, std::size_t>>;
+
+namespace detail
+{
+template <typename T>
+struct HeapBytes
+{
+  static std::size_t of(const T &) { return 0; }
+};
+}  // namespace detail
+
+/// Approximate bytes on the heap held by \p value: the capacity of vectors and strings, and the
+/// nodes and buckets of unordered maps, including the ones nested in them.
+template <typename T>
+std::size_t heap_bytes(const T & value)
+{
+  return detail::HeapBytes<T>::of(value);
+}
+
+namespace detail
+{
+template <typename CharT>
+struct HeapBytes<std::basic_string<CharT>>
+{
+  static std::size_t of(const std::basic_string<CharT> & value)
+  {
+    // the capacity of the small string buffer is in the string itself
+    const std::size_t capacity = value.capacity();
+    return capacity > std::basic_string<CharT>().capacity() ? capacity * sizeof(CharT) : 0;
+  }
+};
+
+template <typename T>
+struct HeapBytes<std::vector<T>>
+{
+  static std::size_t of(const std::vector<T> & values)
+  {
+    std::size_t bytes = values.capacity() * sizeof(T);
+    for (const auto & value : values)
+    {
+      bytes += heap_bytes(value);
+    }
+    return bytes;
+  }
+};
+
+template <>
+struct HeapBytes<std::vector<bool>>
+{
+  static std::size_t of(const std::vector<bool> & values) { return values.capacity() / 8; }
+};
+
+template <typename K, typename V>
+struct HeapBytes<std::unordered_map<K, V>>
+{
+  static std::size_t of(const std::unordered_map<K, V> & map)
+  {
+    // a node holds the next pointer, the cached hash and the value
+    constexpr std::size_t node_bytes =
+      sizeof(void *) + sizeof(std::size_t) + sizeof(std::pair<const K, V>);
+    std::size_t bytes = map.bucket_count() * sizeof(void *) + map.size() * node_bytes;
+    for (const auto & entry : map)
+    {
+      bytes += heap_bytes(entry.first) + heap_bytes(entry.second);
+    }
+    return bytes;
+  }
+};
+}  // namespace detail
+
+/**
+ * \brief Counts the heap allocations of the realtime loop of a controller, e.g. after its
+ * activation.
+ *
+ * The allocations are only counted in processes with libcontroller_allocation_counting.so
+ * preloaded, e.g. with LD_PRELOAD, which interposes malloc() and its siblings of glibc. They
+ * count the allocations of a thread into the counter of the ScopedAllocationCounting active on
+ * it. Without the library, available() is false after reset() and the counts stay 0.
+ */
+class AllocationCounter
+{
+public:
+  /// Zero the counts and look up the interposed malloc(). Non-realtime, e.g. on activation.
+  void reset()
+  {
+    allocations_.store(0, std::memory_order_relaxed);
+    bytes_.store(0, std::memory_order_relaxed);
+    exchange_ = lookup_exchange();
+  }
+
+  /// Whether allocations are counted, after reset().
+  bool available() const { return exchange_ != nullptr; }
+
+  std::uint64_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+  std::uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+  /// Count an allocation of \p bytes. Realtime-safe, called by the interposed malloc().
+  void count(std::size_t bytes) noexcept
+  {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+private:
+  friend class ScopedAllocationCounting;
+
+  /// Make \p counter the one of the current thread, and return the previous one.
+  using ExchangeFunction = AllocationCounter * (*)(AllocationCounter * counter);
+
+  static ExchangeFunction lookup_exchange()
+  {
+#if defined(__GLIBC__)
+    return reinterpret_cast<ExchangeFunction>(
+      dlsym(RTLD_DEFAULT, "controller_realtime_tools_exchange_allocation_counter"));
+#else
+    return nullptr;
+#endif
+  }
+
+  std::atomic<std::uint64_t> allocations_{0};
+  std::atomic<std::uint64_t> bytes_{0};
+  ExchangeFunction exchange_ = nullptr;
+};
+
+/// Count the allocations of the current thread into a counter during the lifetime of this
+/// object, e.g. of update(). Realtime-safe, and nothing but a check without the library.
+class ScopedAllocationCounting
+{
+public:
+  explicit ScopedAllocationCounting(AllocationCounter & counter)
+  : exchange_(counter.exchange_), previous_(exchange_ ? exchange_(&counter) : nullptr)
+  {
+  }
+
+  ~ScopedAllocationCounting()
+  {
+    if (exchange_)
+    {
+      exchange_(previous_);
+    }
+  }
+
+  ScopedAllocationCounting(const ScopedAllocationCounting &) = delete;
+  ScopedAllocationCounting & operator=(const ScopedAllocationCounting &) = delete;
+
+private:
+  AllocationCounter::ExchangeFunction exchange_;
+  AllocationCounter * previous_;
+};
+
+/// Report of \p footprint and of the allocations counted by \p counter, one line per buffer.
+/**
+ * Non-realtime.
+ */
+inline std::string format_memory_report(
+  const MemoryFootprint & footprint, const AllocationCounter & counter)
+{
+  std::string report;
+  std::size_t total = 0;
+  for (const auto & buffer : footprint)
+  {
+    report += buffer.first + ": " + std::to_string(buffer.second) + " bytes\n";
+    total += buffer.second;
+  }
+  report += "total: " + std::to_string(total) + " bytes\n";
+  if (counter.available())
+  {
+    report += "allocations after activation: " + std::to_string(counter.allocations()) + " (" +
+              std::to_string(counter.bytes()) + " bytes)";
+  }
+  else
+  {
+    report +=
+      "allocations after activation: not counted without libcontroller_allocation_counting.so";
+  }
+  return report;
+}
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__MEMORY_FOOTPRINT_HPP_
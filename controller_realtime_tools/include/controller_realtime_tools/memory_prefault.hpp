@@ -0,0 +1,245 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__MEMORY_PREFAULT_HPP_
+#define CONTROLLER_REALTIME_TOOLS__MEMORY_PREFAULT_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace controller_realtime_tools
+{
+/// Size of a page of memory, 4096 if it can't be queried on this platform.
+inline std::size_t memory_page_size()
+{
+#if defined(__linux__)
+  const long page_size = sysconf(_SC_PAGESIZE);  // NOLINT(runtime/int)
+  if (page_size > 0)
+  {
+    return static_cast<std::size_t>(page_size);
+  }
+#endif
+  return 4096;
+}
+
+/**
+ * \brief Touches the memory preallocated for the realtime loop of a controller, so that its pages
+ * don't fault in during the first updates after an activation, and optionally locks them.
+ *
+ * The buffers are collected with add() on activation, with the whole capacity of the vectors and
+ * strings, including the nested ones. prefault() writes one byte of every page of them, by adding
+ * 0 atomically, so it doesn't change any value even if other threads access the buffers. lock()
+ * keeps the pages in RAM with mlock(). The pages stay locked after the buffers are freed, as other
+ * locked memory may share them.
+ *
+ * The buffers added after set_label() are attributed to that label, footprint() has the bytes
+ * added per label, e.g. to report the memory a controller holds.
+ *
+ * Non-realtime.
+ */
+class MemoryPrefaulter
+{
+public:
+  /// Add \p bytes of memory at \p data.
+  void add(void * data, std::size_t bytes)
+  {
+    if (data && bytes > 0)
+    {
+      regions_.push_back({static_cast<unsigned char *>(data), bytes, labels_.size() - 1});
+    }
+  }
+
+  /// Add the whole capacity of \p values, and of the vectors and strings in it.
+  template <typename T>
+  void add(std::vector<T> & values)
+  {
+    if constexpr (!std::is_same_v<T, bool>)
+    {
+      add(values.data(), values.capacity() * sizeof(T));
+      if constexpr (is_container<T>::value)
+      {
+        for (auto & value : values)
+        {
+          add(value);
+        }
+      }
+    }
+  }
+
+  /// Add the capacity of \p value, if it is allocated.
+  void add(std::string & value)
+  {
+    if (value.capacity() > std::string().capacity())
+    {
+      add(&value[0], value.capacity());
+    }
+  }
+
+  /// Add the memory of \p object itself, e.g. of a preallocated object on the heap.
+  template <typename T>
+  void add_object(T & object)
+  {
+    add(static_cast<void *>(&object), sizeof(T));
+  }
+
+  /// Attribute the memory added from now on to \p label, until the next set_label().
+  void set_label(const std::string & label)
+  {
+    if (labels_.back() != label)
+    {
+      labels_.push_back(label);
+    }
+  }
+
+  /// Number of bytes added.
+  std::size_t size() const
+  {
+    std::size_t bytes = 0;
+    for (const auto & region : regions_)
+    {
+      bytes += region.bytes;
+    }
+    return bytes;
+  }
+
+  /// Number of bytes added per label, in the order of the labels, without the empty ones.
+  /**
+   * The memory added before the first set_label() is labeled "other".
+   */
+  std::vector<std::pair<std::string, std::size_t>> footprint() const
+  {
+    std::vector<std::pair<std::string, std::size_t>> footprint;
+    for (const auto & label : labels_)
+    {
+      const auto found = std::find_if(
+        footprint.begin(), footprint.end(), [&label](const auto & entry)
+        { return entry.first == label; });
+      if (found == footprint.end())
+      {
+        footprint.emplace_back(label, 0);
+      }
+    }
+    for (const auto & region : regions_)
+    {
+      const auto & label = labels_[region.label];
+      std::find_if(
+        footprint.begin(), footprint.end(), [&label](const auto & entry)
+        { return entry.first == label; })
+        ->second += region.bytes;
+    }
+    footprint.erase(
+      std::remove_if(
+        footprint.begin(), footprint.end(), [](const auto & entry) { return entry.second == 0; }),
+      footprint.end());
+    return footprint;
+  }
+
+  void clear()
+  {
+    regions_.clear();
+    labels_.assign(1, "other");
+  }
+
+  /// Write to every page of the added memory.
+  /**
+   * \return the number of pages touched, a page shared by several buffers is counted for each.
+   */
+  std::size_t prefault() const
+  {
+    const std::size_t page_size = memory_page_size();
+    std::size_t pages = 0;
+    for (const auto & region : regions_)
+    {
+      const auto begin = reinterpret_cast<std::uintptr_t>(region.data);
+      const std::uintptr_t end = begin + region.bytes;
+      // the start of the region, and then the start of every following page in it
+      for (std::uintptr_t address = begin; address < end;
+           address = (address / page_size + 1) * page_size)
+      {
+        touch(reinterpret_cast<unsigned char *>(address));
+        ++pages;
+      }
+    }
+    return pages;
+  }
+
+  /// Lock the pages of the added memory in RAM, which also faults them in.
+  /**
+   * \return false if any of them couldn't be locked, e.g. without CAP_IPC_LOCK over the
+   * RLIMIT_MEMLOCK, or not supported on this platform.
+   */
+  bool lock() const
+  {
+#if defined(__linux__)
+    const std::size_t page_size = memory_page_size();
+    bool success = true;
+    for (const auto & region : regions_)
+    {
+      const auto begin = reinterpret_cast<std::uintptr_t>(region.data) / page_size * page_size;
+      const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(region.data) + region.bytes;
+      success &= mlock(reinterpret_cast<const void *>(begin), end - begin) == 0;
+    }
+    return success;
+#else
+    return regions_.empty();
+#endif
+  }
+
+private:
+  template <typename T>
+  struct is_container : std::false_type
+  {
+  };
+  template <typename T>
+  struct is_container<std::vector<T>> : std::true_type
+  {
+  };
+  template <typename T>
+  struct is_container<std::basic_string<T>> : std::true_type
+  {
+  };
+
+  static void touch(unsigned char * byte)
+  {
+#if defined(__GNUC__)
+    __atomic_fetch_or(byte, static_cast<unsigned char>(0), __ATOMIC_RELAXED);
+#else
+    *static_cast<volatile unsigned char *>(byte) = *static_cast<volatile unsigned char *>(byte);
+#endif
+  }
+
+  struct Region
+  {
+    unsigned char * data;
+    std::size_t bytes;
+    /// index in labels_
+    std::size_t label;
+  };
+  std::vector<Region> regions_;
+  std::vector<std::string> labels_{"other"};
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__MEMORY_PREFAULT_HPP_
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__METRICS_HPP_
+#define CONTROLLER_REALTIME_TOOLS__METRICS_HPP_
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Fill the unit and statistics of a metrics message with durations in nanoseconds.
+ *
+ * Non-realtime, the statistics of the message are resized.
+ *
+ * \tparam StatisticDataTypeT statistics_msgs::msg::StatisticDataType, or a message with the same
+ * constants.
+ * \tparam StatisticsT Statistics with a count and the mean, min, max and stddev in nanoseconds,
+ * e.g. CycleTiming::Statistics or LatencyProbe::Statistics.
+ * \tparam MetricsMsgT statistics_msgs::msg::MetricsMessage, or a message with the same fields.
+ */
+template <typename StatisticDataTypeT, typename StatisticsT, typename MetricsMsgT>
+void fill_metrics(const StatisticsT & statistics, MetricsMsgT & msg)
+{
+  msg.unit = "ns";
+  msg.statistics.resize(5);
+  msg.statistics[0].data_type = StatisticDataTypeT::STATISTICS_DATA_TYPE_SAMPLE_COUNT;
+  msg.statistics[0].data = static_cast<double>(statistics.count);
+  msg.statistics[1].data_type = StatisticDataTypeT::STATISTICS_DATA_TYPE_AVERAGE;
+  msg.statistics[1].data = statistics.mean_ns;
+  msg.statistics[2].data_type = StatisticDataTypeT::STATISTICS_DATA_TYPE_MINIMUM;
+  msg.statistics[2].data = statistics.min_ns;
+  msg.statistics[3].data_type = StatisticDataTypeT::STATISTICS_DATA_TYPE_MAXIMUM;
+  msg.statistics[3].data = statistics.max_ns;
+  msg.statistics[4].data_type = StatisticDataTypeT::STATISTICS_DATA_TYPE_STDDEV;
+  msg.statistics[4].data = statistics.stddev_ns;
+}
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__METRICS_HPP_
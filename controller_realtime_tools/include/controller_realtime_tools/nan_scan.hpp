@@ -0,0 +1,73 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__NAN_SCAN_HPP_
+#define CONTROLLER_REALTIME_TOOLS__NAN_SCAN_HPP_
+
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace controller_realtime_tools
+{
+/// Whether any of the \p count values at \p values is NaN. Realtime.
+/**
+ * Meant for a snapshot of interface values gathered first, checked in one pass without a branch
+ * per value, two values at a time with SSE2 or NEON where available.
+ */
+inline bool any_nan(const double * values, std::size_t count)
+{
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  // a NaN compares unordered with itself
+  __m128d unordered = _mm_setzero_pd();
+  for (; i + 2 <= count; i += 2)
+  {
+    const __m128d pair = _mm_loadu_pd(values + i);
+    unordered = _mm_or_pd(unordered, _mm_cmpunord_pd(pair, pair));
+  }
+  bool found = _mm_movemask_pd(unordered) != 0;
+#elif defined(__aarch64__)
+  // a NaN is the only value not equal to itself
+  uint64x2_t ordered = vdupq_n_u64(~0ULL);
+  for (; i + 2 <= count; i += 2)
+  {
+    const float64x2_t pair = vld1q_f64(values + i);
+    ordered = vandq_u64(ordered, vceqq_f64(pair, pair));
+  }
+  bool found = (vgetq_lane_u64(ordered, 0) & vgetq_lane_u64(ordered, 1)) != ~0ULL;
+#else
+  bool found = false;
+#endif
+  for (; i < count; ++i)
+  {
+    found = found | (values[i] != values[i]);
+  }
+  return found;
+}
+
+/// Whether any value of \p values, e.g. a std::vector<double>, is NaN. Realtime.
+template <typename ContainerT>
+bool any_nan(const ContainerT & values)
+{
+  return any_nan(values.data(), values.size());
+}
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__NAN_SCAN_HPP_
@@ -0,0 +1,73 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__NEW_SAMPLE_DETECTOR_HPP_
+#define CONTROLLER_REALTIME_TOOLS__NEW_SAMPLE_DETECTOR_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Tells whether the reading of a sensor in an update is a new sample, for sensors
+ * sampling slower than the controller manager updates.
+ *
+ * A sample is new if its key differs bitwise from the key of the previous update: either a
+ * sample sequence number or hardware timestamp of the sensor, which changes with every sample,
+ * or, for sensors without one, all values of the reading. The bitwise comparison takes an
+ * unchanged NaN as unchanged, so a sensor which lost its signal isn't republished on every
+ * update.
+ *
+ * A sensor reading exactly the same values twice in a row, e.g. at rest with a coarse
+ * resolution, loses the second sample if the values are the key.
+ */
+class NewSampleDetector
+{
+public:
+  /// Prepare for keys of \p size values, the next sample is new. Non-realtime.
+  void reset(std::size_t size)
+  {
+    previous_key_.assign(size, 0.0);
+    has_previous_key_ = false;
+  }
+
+  /// Forget the previous key, the next sample is new. Realtime.
+  void reset() { has_previous_key_ = false; }
+
+  /// Whether \p key, of the size given to reset(), differs from the previous one. Realtime.
+  bool is_new(const double * key)
+  {
+    const std::size_t bytes = previous_key_.size() * sizeof(double);
+    if (has_previous_key_ && std::memcmp(previous_key_.data(), key, bytes) == 0)
+    {
+      return false;
+    }
+    std::memcpy(previous_key_.data(), key, bytes);
+    has_previous_key_ = true;
+    return true;
+  }
+
+  /// Whether the single value \p key, e.g. a sequence number, differs from the previous one.
+  bool is_new(double key) { return is_new(&key); }
+
+private:
+  std::vector<double> previous_key_;
+  bool has_previous_key_ = false;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__NEW_SAMPLE_DETECTOR_HPP_
@@ -0,0 +1,210 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__ODOMETRY_PUBLISHER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__ODOMETRY_PUBLISHER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "controller_realtime_tools/seqlock.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+#include "controller_realtime_tools/tracing.hpp"
+
+namespace controller_realtime_tools
+{
+/// Planar odometry of a wheeled controller at one point in time.
+struct OdometrySnapshot
+{
+  std::int64_t stamp_nanoseconds = 0;
+  double x = 0.0;
+  double y = 0.0;
+  double heading = 0.0;
+  double linear = 0.0;
+  double angular = 0.0;
+  // covariance of x, y and heading, row-major, only published if has_pose_covariance
+  std::array<double, 9> pose_covariance{};
+  bool has_pose_covariance = false;
+};
+
+/**
+ * \brief Publisher of the odometry and its transform at a fixed rate, from its own thread.
+ *
+ * The realtime thread only writes a snapshot of the odometry, the messages are filled and
+ * published by the publishing thread with the latest snapshot, so the realtime cost doesn't
+ * depend on the publish rate. Nothing is published until the first snapshot.
+ *
+ * The messages start as copies of prototypes, which hold the frame ids and the constant
+ * covariances. The transform prototype has a single transform.
+ *
+ * \tparam OdometryMsgT nav_msgs::msg::Odometry, or a message with the same fields.
+ * \tparam TransformMsgT tf2_msgs::msg::TFMessage, or a message with the same fields.
+ */
+template <
+  typename OdometryMsgT, typename OdometryPublisherT, typename TransformMsgT,
+  typename TransformPublisherT>
+class OdometryPublisher
+{
+public:
+  /// Non-realtime.
+  /**
+   * \param transform_publisher Publisher of the transform, nullptr to only publish the odometry.
+   */
+  OdometryPublisher(
+    std::shared_ptr<OdometryPublisherT> odometry_publisher, const OdometryMsgT & odometry_prototype,
+    std::shared_ptr<TransformPublisherT> transform_publisher,
+    const TransformMsgT & transform_prototype, std::chrono::nanoseconds period)
+  : odometry_publisher_(std::move(odometry_publisher)),
+    odometry_msg_(odometry_prototype),
+    transform_publisher_(std::move(transform_publisher)),
+    transform_msg_(transform_prototype),
+    period_(period)
+  {
+    thread_ = std::thread(&OdometryPublisher::publishing_loop, this);
+  }
+
+  OdometryPublisher(const OdometryPublisher &) = delete;
+  OdometryPublisher & operator=(const OdometryPublisher &) = delete;
+
+  /// Non-realtime, waits for a running publication.
+  ~OdometryPublisher()
+  {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      keep_running_ = false;
+    }
+    stopped_.notify_all();
+    thread_.join();
+  }
+
+  /// Set the odometry to publish next. Wait-free.
+  void update(const OdometrySnapshot & snapshot) { snapshot_.write(snapshot); }
+
+  /// Apply \p scheduling to the publishing thread, see set_thread_scheduling(). Non-realtime.
+  bool set_scheduling(const ThreadScheduling & scheduling)
+  {
+    return set_thread_scheduling(thread_, scheduling);
+  }
+
+private:
+  void publishing_loop()
+  {
+    std::uint64_t published_version = 0;
+    auto next_time = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      // don't catch up on publications missed by a slow publisher
+      next_time = std::max<std::chrono::steady_clock::time_point>(
+        next_time + period_, std::chrono::steady_clock::now());
+      if (stopped_.wait_until(lock, next_time, [this] { return !keep_running_; }))
+      {
+        return;
+      }
+
+      OdometrySnapshot snapshot;
+      const std::uint64_t version = snapshot_.read(snapshot);
+      if (version == published_version)
+      {
+        // nothing new since the last publication
+        continue;
+      }
+      published_version = version;
+
+      lock.unlock();
+      publish(snapshot);
+      lock.lock();
+    }
+  }
+
+  void publish(const OdometrySnapshot & snapshot)
+  {
+    // yaw only rotation
+    const double qz = std::sin(0.5 * snapshot.heading);
+    const double qw = std::cos(0.5 * snapshot.heading);
+
+    set_stamp(odometry_msg_.header.stamp, snapshot.stamp_nanoseconds);
+    odometry_msg_.pose.pose.position.x = snapshot.x;
+    odometry_msg_.pose.pose.position.y = snapshot.y;
+    odometry_msg_.pose.pose.orientation.x = 0.0;
+    odometry_msg_.pose.pose.orientation.y = 0.0;
+    odometry_msg_.pose.pose.orientation.z = qz;
+    odometry_msg_.pose.pose.orientation.w = qw;
+    odometry_msg_.twist.twist.linear.x = snapshot.linear;
+    odometry_msg_.twist.twist.angular.z = snapshot.angular;
+    if (snapshot.has_pose_covariance)
+    {
+      // x, y and yaw rows and columns of the 6x6 pose covariance
+      constexpr std::size_t POSE_INDICES[3] = {0, 1, 5};
+      for (std::size_t i = 0; i < 3; ++i)
+      {
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+          odometry_msg_.pose.covariance[6 * POSE_INDICES[i] + POSE_INDICES[j]] =
+            snapshot.pose_covariance[3 * i + j];
+        }
+      }
+    }
+    odometry_publisher_->publish(odometry_msg_);
+    CONTROLLER_TRACEPOINT(ODOMETRY_PUBLISHED, this, snapshot.stamp_nanoseconds);
+
+    if (transform_publisher_)
+    {
+      auto & transform = transform_msg_.transforms.front();
+      set_stamp(transform.header.stamp, snapshot.stamp_nanoseconds);
+      transform.transform.translation.x = snapshot.x;
+      transform.transform.translation.y = snapshot.y;
+      transform.transform.rotation.x = 0.0;
+      transform.transform.rotation.y = 0.0;
+      transform.transform.rotation.z = qz;
+      transform.transform.rotation.w = qw;
+      transform_publisher_->publish(transform_msg_);
+    }
+  }
+
+  template <typename StampT>
+  static void set_stamp(StampT & stamp, std::int64_t nanoseconds)
+  {
+    constexpr std::int64_t NANOSECONDS_PER_SECOND = 1000000000;
+    stamp.sec = static_cast<decltype(stamp.sec)>(nanoseconds / NANOSECONDS_PER_SECOND);
+    stamp.nanosec = static_cast<decltype(stamp.nanosec)>(nanoseconds % NANOSECONDS_PER_SECOND);
+  }
+
+  Seqlock<OdometrySnapshot> snapshot_;
+  // only accessed by the publishing thread
+  std::shared_ptr<OdometryPublisherT> odometry_publisher_;
+  OdometryMsgT odometry_msg_;
+  std::shared_ptr<TransformPublisherT> transform_publisher_;
+  TransformMsgT transform_msg_;
+  const std::chrono::nanoseconds period_;
+
+  std::mutex mutex_;
+  std::condition_variable stopped_;
+  // guarded by mutex_
+  bool keep_running_ = true;
+  std::thread thread_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__ODOMETRY_PUBLISHER_HPP_
@@ -0,0 +1,100 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__PARAMETER_SNAPSHOT_HPP_
+#define CONTROLLER_REALTIME_TOOLS__PARAMETER_SNAPSHOT_HPP_
+
+#include <atomic>
+#include <memory>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Immutable parameters built by a non-realtime thread and used by a realtime one.
+ *
+ * The non-realtime thread, e.g. a timer polling the parameter listener, builds a new snapshot
+ * with everything derived from the parameters and publishes it. The realtime thread takes the
+ * latest one with a pointer swap and hands the one it used before back, so it neither copies the
+ * parameters nor takes a lock, and never frees memory: the snapshots it is done with are deleted
+ * by the next publish() or reclaim().
+ *
+ * A published snapshot is only taken once the previous one handed back was reclaimed, so the
+ * non-realtime thread should keep calling reclaim() or publish() while the realtime one runs.
+ * Only one thread may publish and only one thread may take the snapshots at a time.
+ */
+template <typename T>
+class ParameterSnapshot
+{
+public:
+  /// Non-realtime.
+  explicit ParameterSnapshot(std::unique_ptr<const T> initial) : current_(initial.release()) {}
+
+  ParameterSnapshot(const ParameterSnapshot &) = delete;
+  ParameterSnapshot & operator=(const ParameterSnapshot &) = delete;
+
+  ~ParameterSnapshot()
+  {
+    delete pending_.load();
+    delete retired_.load();
+    delete current_;
+  }
+
+  /// Make \p snapshot the latest one, and delete the snapshots the reader is done with.
+  /// Non-realtime.
+  void publish(std::unique_ptr<const T> snapshot)
+  {
+    reclaim();
+    // a snapshot the reader didn't take yet was never used
+    delete pending_.exchange(snapshot.release(), std::memory_order_acq_rel);
+  }
+
+  /// Delete the snapshot the reader is done with, if any. Non-realtime.
+  void reclaim() { delete retired_.exchange(nullptr, std::memory_order_acquire); }
+
+  /// Take the latest published snapshot. Wait-free, realtime.
+  /**
+   * \return whether get() changed.
+   */
+  bool update()
+  {
+    if (
+      pending_.load(std::memory_order_relaxed) == nullptr ||
+      retired_.load(std::memory_order_acquire) != nullptr)
+    {
+      return false;
+    }
+    const T * snapshot = pending_.exchange(nullptr, std::memory_order_acq_rel);
+    retired_.store(current_, std::memory_order_release);
+    current_ = snapshot;
+    return true;
+  }
+
+  /// The snapshot taken by the last update(), or the initial one. Valid until the next update().
+  const T & get() const { return *current_; }
+
+private:
+  static_assert(
+    std::atomic<const T *>::is_always_lock_free, "ParameterSnapshot requires lock-free atomics");
+
+  // latest published snapshot, until the reader takes it
+  std::atomic<const T *> pending_{nullptr};
+  // snapshot the reader is done with, until the writer deletes it
+  std::atomic<const T *> retired_{nullptr};
+  // only accessed by the reader
+  const T * current_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__PARAMETER_SNAPSHOT_HPP_
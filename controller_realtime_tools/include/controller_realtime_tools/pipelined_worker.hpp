@@ -0,0 +1,168 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__PIPELINED_WORKER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__PIPELINED_WORKER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Helper thread computing a stage of the realtime loop one cycle ahead, e.g. kinematics.
+ *
+ * The realtime side fills a request in place and submits it, and uses the latest result of an
+ * earlier request meanwhile, typically the one of the previous cycle. The helper thread runs the
+ * job on the latest request and publishes its result. Requests and results are handed over with
+ * triple buffers, so neither side takes a lock or waits for the other one, and requests submitted
+ * while the job runs are superseded by the latest one.
+ *
+ * The helper thread polls for requests, sleeping for the poll period in between, or yielding if
+ * it is 0, e.g. when pinned to a CPU of its own.
+ *
+ * Only one realtime thread may submit requests and take the results.
+ */
+template <typename RequestT, typename ResultT>
+class PipelinedWorker
+{
+public:
+  using Job = std::function<void(const RequestT & request, ResultT & result)>;
+
+  /// Start the helper thread. Non-realtime.
+  /**
+   * All requests and results start as copies of the prototypes, so a job and a realtime side
+   * that only overwrite their preallocated values never allocate memory.
+   */
+  PipelinedWorker(
+    Job job, const RequestT & request_prototype, const ResultT & result_prototype,
+    std::chrono::nanoseconds poll_period)
+  : job_(std::move(job)),
+    requests_(Request{request_prototype, 0}),
+    results_(Result{result_prototype, 0}),
+    poll_period_(poll_period)
+  {
+    thread_ = std::thread(&PipelinedWorker::run, this);
+  }
+
+  PipelinedWorker(const PipelinedWorker &) = delete;
+  PipelinedWorker & operator=(const PipelinedWorker &) = delete;
+
+  /// Wait for the running job. Non-realtime.
+  ~PipelinedWorker()
+  {
+    keep_running_.store(false);
+    thread_.join();
+  }
+
+  /// Request to fill before submit(), it holds an older request. Realtime, wait-free.
+  RequestT & request() { return requests_.write_buffer().value; }
+
+  /// Hand the filled request over to the job. Realtime, wait-free.
+  /**
+   * \return the sequence number of the request, counting from 1.
+   */
+  std::uint64_t submit()
+  {
+    auto & request = requests_.write_buffer();
+    request.sequence = ++submitted_;
+    requests_.publish();
+    return request.sequence;
+  }
+
+  /// Latest result, nullptr if none of a request after \p min_sequence is done yet. Realtime.
+  /**
+   * \param[out] sequence the sequence number of the request of the result, if not nullptr.
+   * The result stays valid until the next call.
+   */
+  const ResultT * result(std::uint64_t min_sequence = 0, std::uint64_t * sequence = nullptr)
+  {
+    const Result & result = results_.read();
+    if (result.sequence == 0 || result.sequence <= min_sequence)
+    {
+      return nullptr;
+    }
+    if (sequence)
+    {
+      *sequence = result.sequence;
+    }
+    return &result.value;
+  }
+
+  /// Sequence number of the last submitted request, 0 if none. Realtime.
+  std::uint64_t submitted() const { return submitted_; }
+
+  /// Apply \p scheduling to the helper thread, see set_thread_scheduling(). Non-realtime.
+  bool set_scheduling(const ThreadScheduling & scheduling)
+  {
+    return set_thread_scheduling(thread_, scheduling);
+  }
+
+private:
+  struct Request
+  {
+    RequestT value;
+    std::uint64_t sequence;
+  };
+  struct Result
+  {
+    ResultT value;
+    std::uint64_t sequence;
+  };
+
+  void run()
+  {
+    std::uint64_t done = 0;
+    while (keep_running_.load())
+    {
+      const Request & request = requests_.read();
+      if (request.sequence == done)
+      {
+        if (poll_period_.count() > 0)
+        {
+          std::this_thread::sleep_for(poll_period_);
+        }
+        else
+        {
+          std::this_thread::yield();
+        }
+        continue;
+      }
+      auto & result = results_.write_buffer();
+      job_(request.value, result.value);
+      result.sequence = done = request.sequence;
+      results_.publish();
+    }
+  }
+
+  Job job_;
+  RealtimeTripleBuffer<Request> requests_;
+  RealtimeTripleBuffer<Result> results_;
+  std::chrono::nanoseconds poll_period_;
+  // only accessed by the realtime side
+  std::uint64_t submitted_ = 0;
+  std::atomic<bool> keep_running_{true};
+  std::thread thread_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__PIPELINED_WORKER_HPP_
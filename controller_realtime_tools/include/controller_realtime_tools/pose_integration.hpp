@@ -0,0 +1,192 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__POSE_INTEGRATION_HPP_
+#define CONTROLLER_REALTIME_TOOLS__POSE_INTEGRATION_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace controller_realtime_tools
+{
+/// Below this angular displacement [rad] a step is integrated as a straight line
+constexpr double STRAIGHT_STEP_ANGULAR_THRESHOLD = 1e-6;
+
+/**
+ * \brief Integrate the displacements of one step into a planar pose.
+ *
+ * The pose moves exactly along the arc of the step, or with 2nd order Runge-Kutta if the step is
+ * straight and the radius of the arc is ill-conditioned. The odometry of the wheeled controllers
+ * integrates with this function.
+ *
+ * \param[in] linear Linear displacement of the step [m].
+ * \param[in] angular Angular displacement of the step [rad].
+ * \param[in,out] x Position [m].
+ * \param[in,out] y Position [m].
+ * \param[in,out] heading Heading [rad].
+ */
+inline void integrate_pose(double linear, double angular, double & x, double & y, double & heading)
+{
+  if (std::fabs(angular) < STRAIGHT_STEP_ANGULAR_THRESHOLD)
+  {
+    const double direction = heading + angular * 0.5;
+    x += linear * std::cos(direction);
+    y += linear * std::sin(direction);
+    heading += angular;
+  }
+  else
+  {
+    const double heading_old = heading;
+    const double r = linear / angular;
+    heading += angular;
+    x += r * (std::sin(heading) - std::sin(heading_old));
+    y += -r * (std::cos(heading) - std::cos(heading_old));
+  }
+}
+
+/**
+ * \brief Integrate the velocities of the robots [begin, end) over \p dt into their poses.
+ *
+ * Every array holds one value per robot. Ranges of robots that don't overlap can be integrated
+ * from different threads.
+ */
+inline void integrate_poses(
+  const double * linear, const double * angular, double dt, double * x, double * y,
+  double * heading, std::size_t begin, std::size_t end)
+{
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    integrate_pose(linear[i] * dt, angular[i] * dt, x[i], y[i], heading[i]);
+  }
+}
+
+/// Sine and cosine of \p angle, with a single call where the C library has sincos().
+inline void sin_cos(double angle, double & sin_angle, double & cos_angle)
+{
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+  ::sincos(angle, &sin_angle, &cos_angle);
+#else
+  sin_angle = std::sin(angle);
+  cos_angle = std::cos(angle);
+#endif
+}
+
+/**
+ * \brief Planar pose integrated step by step like integrate_pose(), which keeps the sine and
+ * cosine of the heading instead of computing them again at every step.
+ *
+ * Each step rotates them by its angular displacement. Small steps, as at a high rate, rotate by
+ * the Taylor series of the sine and cosine of the step instead of calling them. The rounding
+ * errors of the rotations are bounded by computing them again from the heading every
+ * RESYNC_STEPS steps.
+ */
+class PoseIntegrator
+{
+public:
+  /// Steps between two computations of the sine and cosine from the heading
+  static constexpr std::uint32_t RESYNC_STEPS = 256;
+  /// Below this angular displacement [rad] the rotation of a step uses the Taylor series
+  static constexpr double SERIES_ANGULAR_THRESHOLD = 1e-2;
+
+  PoseIntegrator() { reset(0.0, 0.0, 0.0); }
+
+  /// Move to the pose ( \p x, \p y, \p heading ).
+  void reset(double x, double y, double heading)
+  {
+    x_ = x;
+    y_ = y;
+    set_heading(heading);
+  }
+
+  /// Turn to \p heading [rad], keeping the position.
+  void set_heading(double heading)
+  {
+    heading_ = heading;
+    sin_cos(heading_, sin_heading_, cos_heading_);
+    steps_ = 0;
+  }
+
+  /// Integrate the \p linear [m] and \p angular [rad] displacements of one step.
+  void integrate(double linear, double angular)
+  {
+    double sin_angular, cos_angular_minus_one;
+    rotation(angular, sin_angular, cos_angular_minus_one);
+    // sin(heading + angular) - sin(heading), and the same of the cosine
+    const double delta_sin = sin_heading_ * cos_angular_minus_one + cos_heading_ * sin_angular;
+    const double delta_cos = cos_heading_ * cos_angular_minus_one - sin_heading_ * sin_angular;
+    if (std::fabs(angular) < STRAIGHT_STEP_ANGULAR_THRESHOLD)
+    {
+      // cos(heading + angular / 2) and sin(heading + angular / 2), to first order
+      const double half_angular = angular * 0.5;
+      x_ += linear * (cos_heading_ - sin_heading_ * half_angular);
+      y_ += linear * (sin_heading_ + cos_heading_ * half_angular);
+    }
+    else
+    {
+      const double r = linear / angular;
+      x_ += r * delta_sin;
+      y_ -= r * delta_cos;
+    }
+    heading_ += angular;
+    if (++steps_ >= RESYNC_STEPS)
+    {
+      set_heading(heading_);
+    }
+    else
+    {
+      sin_heading_ += delta_sin;
+      cos_heading_ += delta_cos;
+    }
+  }
+
+  double x() const { return x_; }
+  double y() const { return y_; }
+  double heading() const { return heading_; }
+  double sin_heading() const { return sin_heading_; }
+  double cos_heading() const { return cos_heading_; }
+
+private:
+  /// sin(angle) and cos(angle) - 1, which keeps its precision for small angles
+  static void rotation(double angle, double & sin_angle, double & cos_angle_minus_one)
+  {
+    if (std::fabs(angle) < SERIES_ANGULAR_THRESHOLD)
+    {
+      // the first omitted terms are below 1e-18 at the threshold
+      const double angle2 = angle * angle;
+      sin_angle = angle * (1.0 - angle2 / 6.0 * (1.0 - angle2 / 20.0 * (1.0 - angle2 / 42.0)));
+      cos_angle_minus_one =
+        -angle2 / 2.0 * (1.0 - angle2 / 12.0 * (1.0 - angle2 / 30.0 * (1.0 - angle2 / 56.0)));
+    }
+    else
+    {
+      double sin_half;
+      double cos_half;
+      sin_cos(angle * 0.5, sin_half, cos_half);
+      sin_angle = 2.0 * sin_half * cos_half;
+      cos_angle_minus_one = -2.0 * sin_half * sin_half;
+    }
+  }
+
+  double x_;
+  double y_;
+  double heading_;
+  double sin_heading_;
+  double cos_heading_;
+  std::uint32_t steps_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__POSE_INTEGRATION_HPP_
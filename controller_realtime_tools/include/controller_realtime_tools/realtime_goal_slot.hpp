@@ -0,0 +1,325 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__REALTIME_GOAL_SLOT_HPP_
+#define CONTROLLER_REALTIME_TOOLS__REALTIME_GOAL_SLOT_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Slot holding the active goal, shared between the non-realtime and the realtime thread.
+ *
+ * The non-realtime side sets and resets the goal, e.g., from the action server callbacks.
+ * The realtime side reads the goal and clears it once it is finished, without taking a lock or
+ * waiting for the non-realtime side. The non-realtime side instead waits for the realtime side
+ * to finish reading before it overwrites a value, so the slot only releases goals outside of the
+ * realtime thread.
+ *
+ * Behind the active goal, the non-realtime side may queue a next goal with set_next(), which the
+ * realtime side makes the active goal with advance_from_rt() once it finished the active one.
+ *
+ * Only one thread may call the realtime methods.
+ */
+template <typename T>
+class RealtimeGoalSlot
+{
+public:
+  using ValuePtr = std::shared_ptr<T>;
+
+  RealtimeGoalSlot() = default;
+  RealtimeGoalSlot(const RealtimeGoalSlot &) = delete;
+  RealtimeGoalSlot & operator=(const RealtimeGoalSlot &) = delete;
+
+  /// Set the goal and drop the next goal. Non-realtime.
+  void set(ValuePtr value)
+  {
+    if (!value)
+    {
+      reset();
+      return;
+    }
+
+    std::lock_guard<std::mutex> guard(non_rt_mutex_);
+    set_locked(std::move(value));
+  }
+
+  /**
+   * \brief Queue \p value as next goal, replacing the previous next goal. Non-realtime.
+   *
+   * If there is no goal, \p value becomes the goal right away.
+   * \return the replaced next goal, nullptr if there was none.
+   */
+  ValuePtr set_next(ValuePtr value)
+  {
+    if (!value)
+    {
+      return reset_next();
+    }
+
+    std::lock_guard<std::mutex> guard(non_rt_mutex_);
+    std::uint32_t state = state_.load();
+    if (is_empty(get_current_cell(state)))
+    {
+      set_locked(std::move(value));
+      return ValuePtr();
+    }
+    // the realtime side only frees cells, so the cell stays free
+    const std::uint32_t cell = get_free_cell(state);
+    store_cell(cell, std::move(value));
+    std::uint32_t desired;
+    do
+    {
+      // the realtime side may have finished the goal in between, the next one replaces it then
+      desired = is_empty(get_current_cell(state))
+                  ? make_state(get_version(state) + 1, cell, EMPTY)
+                  : make_state(get_version(state) + 1, get_current_cell(state), cell);
+    } while (!state_.compare_exchange_weak(state, desired));
+    ValuePtr replaced = is_empty(get_next_cell(state)) ? ValuePtr() : cells_[get_next_cell(state)];
+    release_unused_cells(desired);
+    return replaced;
+  }
+
+  /// Clear the goal and the next goal. Non-realtime.
+  void reset()
+  {
+    std::lock_guard<std::mutex> guard(non_rt_mutex_);
+    std::uint32_t state = state_.load();
+    while (!state_.compare_exchange_weak(state, make_state(get_version(state) + 1, EMPTY, EMPTY)))
+    {
+    }
+    release_unused_cells(make_state(0, EMPTY, EMPTY));
+  }
+
+  /**
+   * \brief Clear the next goal. Non-realtime.
+   * \return the cleared next goal, nullptr if there was none or the realtime side made it the goal.
+   */
+  ValuePtr reset_next()
+  {
+    std::lock_guard<std::mutex> guard(non_rt_mutex_);
+    std::uint32_t state = state_.load();
+    std::uint32_t desired;
+    do
+    {
+      if (is_empty(get_next_cell(state)))
+      {
+        return ValuePtr();
+      }
+      desired = make_state(get_version(state) + 1, get_current_cell(state), EMPTY);
+    } while (!state_.compare_exchange_weak(state, desired));
+    ValuePtr cleared = cells_[get_next_cell(state)];
+    release_unused_cells(desired);
+    return cleared;
+  }
+
+  /// Get the goal, if any. Non-realtime.
+  ValuePtr get() const
+  {
+    std::lock_guard<std::mutex> guard(non_rt_mutex_);
+    const std::uint32_t cell = get_current_cell(state_.load());
+    return is_empty(cell) ? ValuePtr() : cells_[cell];
+  }
+
+  /// Get the next goal, if any. Non-realtime.
+  ValuePtr get_next() const
+  {
+    std::lock_guard<std::mutex> guard(non_rt_mutex_);
+    const std::uint32_t cell = get_next_cell(state_.load());
+    return is_empty(cell) ? ValuePtr() : cells_[cell];
+  }
+
+  /// Get the goal, if any. Realtime, lock-free.
+  ValuePtr get_from_rt() { return read_from_rt(get_current_cell, last_rt_id_); }
+
+  /// Get the next goal, if any. Realtime, lock-free.
+  ValuePtr get_next_from_rt() { return read_from_rt(get_next_cell, last_rt_next_id_); }
+
+  /**
+   * \brief Clear the goal returned by the last call of get_from_rt(). Realtime, lock-free.
+   *
+   * If the non-realtime side has set another goal since, that goal is kept. The next goal, if
+   * any, is kept as well, the goal stays empty until the non-realtime side resets or sets it.
+   * \return true if the goal was cleared.
+   */
+  bool reset_from_rt()
+  {
+    std::uint32_t state = state_.load();
+    do
+    {
+      if (!holds_rt_goal(state))
+      {
+        return false;
+      }
+    } while (!state_.compare_exchange_weak(
+      state, make_state(get_version(state) + 1, EMPTY, get_next_cell(state))));
+    last_rt_id_ = 0;
+    return true;
+  }
+
+  /**
+   * \brief Replace the goal returned by the last call of get_from_rt() with the next goal
+   * returned by the last call of get_next_from_rt(). Realtime, lock-free.
+   *
+   * \return true if the next goal is the goal now, false if either of them changed since.
+   */
+  bool advance_from_rt()
+  {
+    std::uint32_t state = state_.load();
+    do
+    {
+      if (
+        !holds_rt_goal(state) || is_empty(get_next_cell(state)) ||
+        read_id_from_rt(get_next_cell(state)) != last_rt_next_id_)
+      {
+        return false;
+      }
+    } while (!state_.compare_exchange_weak(
+      state, make_state(get_version(state) + 1, get_next_cell(state), EMPTY)));
+    last_rt_id_ = last_rt_next_id_;
+    last_rt_next_id_ = 0;
+    return true;
+  }
+
+private:
+  // the state packs a version counter, to detect updates in between, the cell of the goal and the
+  // cell of the next goal
+  static constexpr std::uint32_t CELL_BITS = 2;
+  static constexpr std::uint32_t CELL_MASK = (1u << CELL_BITS) - 1;
+  static constexpr std::uint32_t EMPTY = 3;
+
+  static std::uint32_t make_state(std::uint32_t version, std::uint32_t current, std::uint32_t next)
+  {
+    return (version << (2 * CELL_BITS)) | (next << CELL_BITS) | current;
+  }
+  static std::uint32_t get_version(std::uint32_t state) { return state >> (2 * CELL_BITS); }
+  static std::uint32_t get_current_cell(std::uint32_t state) { return state & CELL_MASK; }
+  static std::uint32_t get_next_cell(std::uint32_t state)
+  {
+    return (state >> CELL_BITS) & CELL_MASK;
+  }
+  static bool is_empty(std::uint32_t cell) { return cell == EMPTY; }
+
+  /// A cell \p state doesn't refer to
+  static std::uint32_t get_free_cell(std::uint32_t state)
+  {
+    std::uint32_t cell = 0;
+    while (cell == get_current_cell(state) || cell == get_next_cell(state))
+    {
+      ++cell;
+    }
+    return cell;
+  }
+
+  void set_locked(ValuePtr value)
+  {
+    const std::uint32_t cell = get_free_cell(state_.load());
+    store_cell(cell, std::move(value));
+    std::uint32_t state = state_.load();
+    while (!state_.compare_exchange_weak(state, make_state(get_version(state) + 1, cell, EMPTY)))
+    {
+    }
+    release_unused_cells(make_state(0, cell, EMPTY));
+  }
+
+  // the ids tell apart the values stored in the same cell one after another
+  void store_cell(std::uint32_t cell, ValuePtr value)
+  {
+    cells_[cell] = std::move(value);
+    ids_[cell] = ++last_id_;
+  }
+
+  /// Release the values of the cells \p state doesn't refer to, once the realtime side can't read
+  /// them anymore
+  void release_unused_cells(std::uint32_t state)
+  {
+    wait_for_rt_read();
+    for (std::uint32_t cell = 0; cell < cells_.size(); ++cell)
+    {
+      if (cell != get_current_cell(state) && cell != get_next_cell(state))
+      {
+        cells_[cell].reset();
+        ids_[cell] = 0;
+      }
+    }
+  }
+
+  void wait_for_rt_read() const
+  {
+    while (rt_reading_.load())
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  ValuePtr read_from_rt(std::uint32_t (*get_cell)(std::uint32_t), std::uint64_t & id)
+  {
+    rt_reading_.store(true);
+    const std::uint32_t cell = get_cell(state_.load());
+    ValuePtr value;
+    id = 0;
+    if (!is_empty(cell))
+    {
+      value = cells_[cell];
+      id = ids_[cell];
+    }
+    rt_reading_.store(false);
+    return value;
+  }
+
+  std::uint64_t read_id_from_rt(std::uint32_t cell)
+  {
+    rt_reading_.store(true);
+    // the cell may have been freed and reused after the state was loaded, so load it again
+    const std::uint32_t state = state_.load();
+    const std::uint64_t id =
+      cell == get_current_cell(state) || cell == get_next_cell(state) ? ids_[cell] : 0;
+    rt_reading_.store(false);
+    return id;
+  }
+
+  /// Whether the goal of \p state is the one returned by the last call of get_from_rt()
+  bool holds_rt_goal(std::uint32_t state)
+  {
+    return !is_empty(get_current_cell(state)) && last_rt_id_ != 0 &&
+           read_id_from_rt(get_current_cell(state)) == last_rt_id_;
+  }
+
+  static_assert(
+    std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<bool>::is_always_lock_free,
+    "RealtimeGoalSlot requires lock-free atomics");
+
+  std::array<ValuePtr, 3> cells_;
+  // id of the value of each cell, 0 if it's empty
+  std::array<std::uint64_t, 3> ids_{};
+  std::atomic<std::uint32_t> state_{make_state(0, EMPTY, EMPTY)};
+  std::atomic<bool> rt_reading_{false};
+  mutable std::mutex non_rt_mutex_;
+  // only accessed while holding non_rt_mutex_
+  std::uint64_t last_id_ = 0;
+  // only accessed by the realtime thread, ids of the values it read last
+  std::uint64_t last_rt_id_ = 0;
+  std::uint64_t last_rt_next_id_ = 0;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__REALTIME_GOAL_SLOT_HPP_
@@ -0,0 +1,211 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__REALTIME_SAFETY_COUNTER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__REALTIME_SAFETY_COUNTER_HPP_
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+// Test utility, which counts the operations of the current thread a realtime loop must not do.
+//
+// With glibc, malloc() and its siblings are interposed, which counts the allocations of all code,
+// e.g. of the containers, Eigen and the middleware, and so is pthread_mutex_lock(), which
+// std::mutex and the locks of the ROS libraries are built on. Elsewhere only the global operator
+// new and delete are replaced, and locks aren't counted.
+//
+// Include this header in only one translation unit of a test executable, never in a library.
+
+namespace controller_realtime_tools
+{
+namespace realtime_safety
+{
+inline thread_local bool counting = false;
+inline thread_local std::size_t allocations = 0;
+inline thread_local std::size_t deallocations = 0;
+inline thread_local std::size_t locks = 0;
+
+inline void count_allocation()
+{
+  if (counting)
+  {
+    ++allocations;
+  }
+}
+
+inline void count_deallocation(const void * ptr)
+{
+  if (counting && ptr)
+  {
+    ++deallocations;
+  }
+}
+}  // namespace realtime_safety
+
+/// Count the operations of the current thread, which aren't realtime safe, during the lifetime of
+/// this object.
+/**
+ * Used to check that the steady state of a realtime loop doesn't allocate or free memory and
+ * doesn't block on a lock, e.g.
+ * \code
+ * ScopedRealtimeSafetyCounter counter;
+ * controller->update(time, period);
+ * EXPECT_EQ(counter.get_allocations(), 0u);
+ * EXPECT_EQ(counter.get_locks(), 0u);
+ * \endcode
+ * Failed attempts of try_lock() don't block, so they aren't counted.
+ */
+class ScopedRealtimeSafetyCounter
+{
+public:
+  ScopedRealtimeSafetyCounter()
+  {
+    realtime_safety::allocations = 0;
+    realtime_safety::deallocations = 0;
+    realtime_safety::locks = 0;
+    realtime_safety::counting = true;
+  }
+
+  ~ScopedRealtimeSafetyCounter() { realtime_safety::counting = false; }
+
+  ScopedRealtimeSafetyCounter(const ScopedRealtimeSafetyCounter &) = delete;
+  ScopedRealtimeSafetyCounter & operator=(const ScopedRealtimeSafetyCounter &) = delete;
+
+  std::size_t get_allocations() const { return realtime_safety::allocations; }
+  std::size_t get_deallocations() const { return realtime_safety::deallocations; }
+  std::size_t get_locks() const { return realtime_safety::locks; }
+};
+
+}  // namespace controller_realtime_tools
+
+#if defined(__GLIBC__)
+
+extern "C"
+{
+  // the implementations of glibc, which stay callable when malloc() is interposed
+  void * __libc_malloc(std::size_t size);
+  void * __libc_calloc(std::size_t count, std::size_t size);
+  void * __libc_realloc(void * ptr, std::size_t size);
+  void * __libc_memalign(std::size_t alignment, std::size_t size);
+  void __libc_free(void * ptr);
+
+  void * malloc(std::size_t size) noexcept
+  {
+    controller_realtime_tools::realtime_safety::count_allocation();
+    return __libc_malloc(size);
+  }
+
+  void * calloc(std::size_t count, std::size_t size) noexcept
+  {
+    controller_realtime_tools::realtime_safety::count_allocation();
+    return __libc_calloc(count, size);
+  }
+
+  void * realloc(void * ptr, std::size_t size) noexcept
+  {
+    controller_realtime_tools::realtime_safety::count_allocation();
+    return __libc_realloc(ptr, size);
+  }
+
+  void * aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+  {
+    controller_realtime_tools::realtime_safety::count_allocation();
+    return __libc_memalign(alignment, size);
+  }
+
+  int posix_memalign(void ** ptr, std::size_t alignment, std::size_t size) noexcept
+  {
+    controller_realtime_tools::realtime_safety::count_allocation();
+    void * memory = __libc_memalign(alignment, size);
+    if (!memory)
+    {
+      return ENOMEM;
+    }
+    *ptr = memory;
+    return 0;
+  }
+
+  void free(void * ptr) noexcept
+  {
+    controller_realtime_tools::realtime_safety::count_deallocation(ptr);
+    __libc_free(ptr);
+  }
+
+  int pthread_mutex_lock(pthread_mutex_t * mutex) noexcept
+  {
+    using LockFunction = int (*)(pthread_mutex_t *);
+    // constant initialized, a guarded static could lock itself
+    static std::atomic<LockFunction> next_lock{nullptr};
+    LockFunction lock = next_lock.load(std::memory_order_relaxed);
+    if (!lock)
+    {
+      lock = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+      next_lock.store(lock, std::memory_order_relaxed);
+    }
+    if (controller_realtime_tools::realtime_safety::counting)
+    {
+      ++controller_realtime_tools::realtime_safety::locks;
+    }
+    return lock(mutex);
+  }
+}
+
+#else
+
+// the replaced functions are inlined at the call sites, hide the false positive of GCC
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void * operator new(std::size_t size)
+{
+  controller_realtime_tools::realtime_safety::count_allocation();
+  void * ptr = std::malloc(size == 0 ? 1 : size);
+  if (!ptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void * operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void * ptr) noexcept
+{
+  controller_realtime_tools::realtime_safety::count_deallocation(ptr);
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept { operator delete(ptr); }
+
+void operator delete(void * ptr, std::size_t) noexcept { operator delete(ptr); }
+
+void operator delete[](void * ptr, std::size_t) noexcept { operator delete(ptr); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // defined(__GLIBC__)
+
+#endif  // CONTROLLER_REALTIME_TOOLS__REALTIME_SAFETY_COUNTER_HPP_
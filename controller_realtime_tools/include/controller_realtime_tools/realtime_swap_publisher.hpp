@@ -0,0 +1,217 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__REALTIME_SWAP_PUBLISHER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__REALTIME_SWAP_PUBLISHER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "controller_realtime_tools/thread_scheduling.hpp"
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Publisher for realtime threads, which hands messages over by swapping instead of copying.
+ *
+ * The realtime side swaps its message with the one held by this publisher, which a non-realtime
+ * thread swaps again to publish it. All messages start as copies of a prototype, so a realtime
+ * side that only overwrites the values of a preallocated message never allocates memory.
+ *
+ * If the middleware can loan messages of this type, the non-realtime thread fills a loaned
+ * message, which replaces the serialization of the message. Otherwise it is published as usual.
+ *
+ * Messages can be decimated to a period: the realtime side checks is_due() before filling a
+ * message, and hands it over with its time. Messages which are not published, because the
+ * publishing thread was busy or a newer message replaced them, are counted as dropped.
+ *
+ * \tparam PublisherT Publisher of MessageT, e.g. rclcpp::Publisher<MessageT>.
+ */
+template <typename MessageT, typename PublisherT>
+class RealtimeSwapPublisher
+{
+public:
+  /// Non-realtime.
+  /**
+   * \param period Minimum time between the messages handed over with their time, if 0 they are
+   * all published.
+   */
+  RealtimeSwapPublisher(
+    std::shared_ptr<PublisherT> publisher, const MessageT & prototype,
+    std::chrono::nanoseconds period = std::chrono::nanoseconds::zero())
+  : publisher_(std::move(publisher)),
+    msg_(prototype),
+    outgoing_msg_(prototype),
+    period_ns_(period.count())
+  {
+    thread_ = std::thread(&RealtimeSwapPublisher::publishing_loop, this);
+  }
+
+  RealtimeSwapPublisher(const RealtimeSwapPublisher &) = delete;
+  RealtimeSwapPublisher & operator=(const RealtimeSwapPublisher &) = delete;
+
+  ~RealtimeSwapPublisher()
+  {
+    keep_running_.store(false);
+    thread_.join();
+  }
+
+  /**
+   * \brief Hand \p msg over to be published. Realtime, doesn't wait for the publishing thread.
+   *
+   * \p msg is swapped with a message published before, or the prototype.
+   * A message handed over before and not published yet is dropped.
+   * \return false if the publishing thread is busy, \p msg is left unchanged then.
+   */
+  bool try_publish(MessageT & msg)
+  {
+    std::unique_lock<std::mutex> lock(msg_mutex_, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+      count_drop();
+      return false;
+    }
+    std::swap(msg, msg_);
+    if (msg_pending_)
+    {
+      count_drop();
+    }
+    msg_pending_ = true;
+    return true;
+  }
+
+  /// Whether a message is due at \p now_ns, i.e. the period elapsed since the last message handed
+  /// over with its time. Realtime.
+  bool is_due(std::int64_t now_ns) const { return now_ns >= next_time_ns_; }
+
+  /**
+   * \brief Hand \p msg, filled at \p now_ns, over to be published. Realtime.
+   *
+   * The next message is due one period later if it was handed over. The steady rate isn't kept
+   * after a pause, e.g. while the controller was inactive.
+   * \return false if the publishing thread is busy, the message is still due then.
+   */
+  bool try_publish(MessageT & msg, std::int64_t now_ns)
+  {
+    if (!try_publish(msg))
+    {
+      return false;
+    }
+    next_time_ns_ = next_time_ns_ + period_ns_ > now_ns ? next_time_ns_ + period_ns_
+                                                       : now_ns + period_ns_;
+    return true;
+  }
+
+  /// Make the next message due immediately, e.g. when the controller is activated. Realtime.
+  void reset_period() { next_time_ns_ = std::numeric_limits<std::int64_t>::min(); }
+
+  /// Number of messages published since construction.
+  std::uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+
+  /// Number of messages dropped since construction, i.e. not handed over or replaced before
+  /// they were published.
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /// Call \p visitor with each message held by this publisher, e.g. to prefault their memory.
+  /**
+   * Non-realtime, waits until the publishing thread is done with its message. The realtime side
+   * can't hand a message over meanwhile.
+   */
+  template <typename Visitor>
+  void visit_messages(Visitor && visitor)
+  {
+    std::lock_guard<std::mutex> publishing_guard(publishing_mutex_);
+    std::lock_guard<std::mutex> guard(msg_mutex_);
+    visitor(msg_);
+    visitor(outgoing_msg_);
+  }
+
+  /// Apply \p scheduling to the publishing thread, see set_thread_scheduling(). Non-realtime.
+  bool set_scheduling(const ThreadScheduling & scheduling)
+  {
+    return set_thread_scheduling(thread_, scheduling);
+  }
+
+private:
+  void publishing_loop()
+  {
+    while (keep_running_.load())
+    {
+      std::unique_lock<std::mutex> publishing_lock(publishing_mutex_);
+      bool publish = false;
+      {
+        std::lock_guard<std::mutex> guard(msg_mutex_);
+        if (msg_pending_)
+        {
+          std::swap(msg_, outgoing_msg_);
+          msg_pending_ = false;
+          publish = true;
+        }
+      }
+      if (!publish)
+      {
+        publishing_lock.unlock();
+        // poll, the realtime side doesn't wake this thread up
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+        continue;
+      }
+
+      if (publisher_->can_loan_messages())
+      {
+        auto loaned_msg = publisher_->borrow_loaned_message();
+        loaned_msg.get() = outgoing_msg_;
+        publisher_->publish(std::move(loaned_msg));
+      }
+      else
+      {
+        publisher_->publish(outgoing_msg_);
+      }
+      published_.store(published_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  }
+
+  // only called by the realtime side
+  void count_drop()
+  {
+    dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  std::shared_ptr<PublisherT> publisher_;
+  std::mutex msg_mutex_;
+  // guarded by msg_mutex_
+  MessageT msg_;
+  bool msg_pending_ = false;
+  // held by the publishing thread while it accesses outgoing_msg_, never taken by the realtime side
+  std::mutex publishing_mutex_;
+  // only accessed by the publishing thread, and by visit_messages()
+  MessageT outgoing_msg_;
+  // only accessed by the realtime side
+  const std::int64_t period_ns_;
+  std::int64_t next_time_ns_ = std::numeric_limits<std::int64_t>::min();
+
+  std::atomic<std::uint64_t> published_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<bool> keep_running_{true};
+  std::thread thread_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__REALTIME_SWAP_PUBLISHER_HPP_
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__REALTIME_TRIPLE_BUFFER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__REALTIME_TRIPLE_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Latest value written by one thread, read by another one, either of them realtime.
+ *
+ * The writer fills a buffer in place and publishes it, the reader gets the last published
+ * buffer. Three buffers rotate between the writer, the reader and the last published value, so
+ * neither side takes a lock or waits for the other one, and neither copies more than the writer
+ * fills. All buffers start as copies of a prototype, so a writer that only overwrites the values
+ * of preallocated fields never allocates memory.
+ *
+ * Only one thread may write and only one thread may read at a time.
+ */
+template <typename T>
+class RealtimeTripleBuffer
+{
+public:
+  /// Non-realtime.
+  explicit RealtimeTripleBuffer(const T & prototype) : buffers_{prototype, prototype, prototype}
+  {
+  }
+
+  RealtimeTripleBuffer(const RealtimeTripleBuffer &) = delete;
+  RealtimeTripleBuffer & operator=(const RealtimeTripleBuffer &) = delete;
+
+  /// Buffer to fill before publish(), it holds an older published value. Wait-free.
+  T & write_buffer() { return buffers_[write_index_]; }
+
+  /// Make the write buffer the latest value. Wait-free.
+  void publish()
+  {
+    write_index_ = get_index(latest_.exchange(write_index_ | NEW_VALUE, std::memory_order_acq_rel));
+  }
+
+  /// Get the latest published value, or the prototype if none. Wait-free.
+  /**
+   * The value stays valid until the next call of read().
+   */
+  const T & read()
+  {
+    if (latest_.load(std::memory_order_relaxed) & NEW_VALUE)
+    {
+      read_index_ = get_index(latest_.exchange(read_index_, std::memory_order_acq_rel));
+    }
+    return buffers_[read_index_];
+  }
+
+private:
+  // the latest value packs the index of its buffer and whether the reader didn't take it yet
+  static constexpr std::uint32_t NEW_VALUE = 4;
+  static constexpr std::uint32_t INDEX_MASK = 3;
+
+  static std::uint32_t get_index(std::uint32_t latest) { return latest & INDEX_MASK; }
+
+  static_assert(
+    std::atomic<std::uint32_t>::is_always_lock_free,
+    "RealtimeTripleBuffer requires lock-free atomics");
+
+  std::array<T, 3> buffers_;
+  std::atomic<std::uint32_t> latest_{1};
+  // only accessed by the writer
+  std::uint32_t write_index_ = 0;
+  // only accessed by the reader
+  std::uint32_t read_index_ = 2;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__REALTIME_TRIPLE_BUFFER_HPP_
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__RING_BUFFER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__RING_BUFFER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Last \p Capacity values pushed, e.g. the history of commands of a controller.
+ *
+ * The values are stored in place, pushing overwrites the oldest value once the buffer is full.
+ * Nothing is ever allocated, so all methods are realtime-safe as long as copying T is.
+ *
+ * Not thread-safe.
+ */
+template <typename T, std::size_t Capacity>
+class RingBuffer
+{
+  static_assert(Capacity > 0, "RingBuffer requires a capacity of at least one value");
+
+public:
+  /// Empty buffer.
+  RingBuffer() = default;
+
+  /// Full buffer with all values equal to \p value.
+  explicit RingBuffer(const T & value) { fill(value); }
+
+  /// Make the buffer full with all values equal to \p value.
+  void fill(const T & value)
+  {
+    values_.fill(value);
+    next_ = 0;
+    size_ = Capacity;
+  }
+
+  /// Forget all values.
+  void clear()
+  {
+    next_ = 0;
+    size_ = 0;
+  }
+
+  /// Add \p value as the latest value, dropping the oldest one if full.
+  void push(const T & value)
+  {
+    values_[next_] = value;
+    next_ = (next_ + 1) % Capacity;
+    size_ = std::min(size_ + 1, Capacity);
+  }
+
+  /// The value pushed \p age values before the latest one, 0 is the latest.
+  /**
+   * \p age has to be less than size().
+   */
+  const T & latest(std::size_t age = 0) const
+  {
+    return values_[(next_ + Capacity - 1 - age) % Capacity];
+  }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == Capacity; }
+  static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+  std::array<T, Capacity> values_{};
+  // index the next value is written to, the one after the latest value
+  std::size_t next_ = 0;
+  std::size_t size_ = 0;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__RING_BUFFER_HPP_
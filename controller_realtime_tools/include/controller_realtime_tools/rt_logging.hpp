@@ -0,0 +1,45 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__RT_LOGGING_HPP_
+#define CONTROLLER_REALTIME_TOOLS__RT_LOGGING_HPP_
+
+/**
+ * \brief Debug output of the realtime loop of a controller, like RCLCPP_DEBUG(logger, ...).
+ *
+ * RCLCPP_DEBUG() checks the severity of the logger on every call, and its arguments, like the
+ * logger of the node and the names of the interfaces, are built even if debug output is disabled.
+ * This is only compiled in with the CMake option CONTROLLER_RT_DEBUG of
+ * controller_realtime_tools, to diagnose a controller with a rebuild. Otherwise its arguments
+ * are not evaluated, so they must not have side effects.
+ *
+ * The including file has to include rclcpp/logging.hpp, as every controller does.
+ */
+#if defined(CONTROLLER_REALTIME_TOOLS_RT_DEBUG)
+#define CONTROLLER_RT_DEBUG(logger, ...) RCLCPP_DEBUG(logger, __VA_ARGS__)
+#else
+// unevaluated, but the arguments still count as used
+#define CONTROLLER_RT_DEBUG(logger, ...) \
+  static_cast<void>(                      \
+    sizeof(logger) + sizeof(::controller_realtime_tools::rt_logging_used(__VA_ARGS__)))
+
+namespace controller_realtime_tools
+{
+/// Only named in unevaluated operands of CONTROLLER_RT_DEBUG()
+template <typename... Args>
+char rt_logging_used(const Args &...);
+}  // namespace controller_realtime_tools
+#endif
+
+#endif  // CONTROLLER_REALTIME_TOOLS__RT_LOGGING_HPP_
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__SEQLOCK_HPP_
+#define CONTROLLER_REALTIME_TOOLS__SEQLOCK_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Small value written by a realtime thread, read by any number of other threads.
+ *
+ * Writing never waits, it marks the value as being written with an odd sequence number while
+ * copying it. Readers copy the value and retry if it was written meanwhile. Suited for snapshots
+ * of a few words written every cycle, e.g. a pose, where a triple buffer would be overkill.
+ *
+ * The value is stored in atomic words, so T has to be trivially copyable.
+ * Only one thread may write at a time.
+ */
+template <typename T>
+class Seqlock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable T");
+
+public:
+  explicit Seqlock(const T & value = T()) { store(value); }
+
+  Seqlock(const Seqlock &) = delete;
+  Seqlock & operator=(const Seqlock &) = delete;
+
+  /// Replace the value. Wait-free.
+  void write(const T & value)
+  {
+    const std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    store(value);
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /// Copy the value into \p value, retrying while it is written.
+  /**
+   * \return the number of writes before, so readers can tell whether the value changed.
+   */
+  std::uint64_t read(T & value) const
+  {
+    std::array<std::uint64_t, WORDS> words;
+    while (true)
+    {
+      const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+      if (before % 2 == 1)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      for (std::size_t i = 0; i < WORDS; ++i)
+      {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == before)
+      {
+        std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+        return before / 2;
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t WORDS = (sizeof(T) + sizeof(std::uint64_t) - 1) /
+                                       sizeof(std::uint64_t);
+
+  void store(const T & value)
+  {
+    std::array<std::uint64_t, WORDS> words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    for (std::size_t i = 0; i < WORDS; ++i)
+    {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<std::uint64_t> sequence_{0};
+  std::array<std::atomic<std::uint64_t>, WORDS> words_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__SEQLOCK_HPP_
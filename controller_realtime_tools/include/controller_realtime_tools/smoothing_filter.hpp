@@ -0,0 +1,179 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__SMOOTHING_FILTER_HPP_
+#define CONTROLLER_REALTIME_TOOLS__SMOOTHING_FILTER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include "controller_realtime_tools/ring_buffer.hpp"
+
+namespace controller_realtime_tools
+{
+enum class SmoothingMode
+{
+  // mean of the last window size values
+  MEAN,
+  // exponential moving average with the smoothing factor 2 / (window size + 1)
+  EXPONENTIAL,
+  // median of the last window size values
+  MEDIAN,
+};
+
+/// Parse "mean", "exponential" or "median" into \p mode, false for other names.
+inline bool smoothing_mode_from_string(const std::string & name, SmoothingMode & mode)
+{
+  if (name == "mean")
+  {
+    mode = SmoothingMode::MEAN;
+  }
+  else if (name == "exponential")
+  {
+    mode = SmoothingMode::EXPONENTIAL;
+  }
+  else if (name == "median")
+  {
+    mode = SmoothingMode::MEDIAN;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * \brief Smoothing of a signal over a window of its last values, e.g. an odometry velocity.
+ *
+ * The values are stored in place for windows of up to \p Capacity values, so neither filtering
+ * nor resetting or reconfiguring ever allocates and all methods are realtime-safe. Filtering is
+ * O(1) for the mean and the exponential moving average and O(window size) for the median.
+ *
+ * Until the window is full, the mean and the median are computed over the values filtered since
+ * the last reset. The value before the first one is 0.
+ *
+ * Not thread-safe.
+ */
+template <std::size_t Capacity>
+class SmoothingFilter
+{
+  static_assert(Capacity > 0, "SmoothingFilter requires a capacity of at least one value");
+
+public:
+  /// \param window_size clamped to [1, Capacity].
+  explicit SmoothingFilter(
+    std::size_t window_size = Capacity, SmoothingMode mode = SmoothingMode::MEAN)
+  {
+    configure(window_size, mode);
+  }
+
+  /// Set the window size, clamped to [1, Capacity], and the mode, and reset.
+  void configure(std::size_t window_size, SmoothingMode mode)
+  {
+    window_size_ = std::clamp<std::size_t>(window_size, 1, Capacity);
+    mode_ = mode;
+    reset();
+  }
+
+  /// Forget all values.
+  void reset()
+  {
+    values_.clear();
+    sum_ = 0.0;
+    pushes_since_sum_ = 0;
+    value_ = 0.0;
+  }
+
+  /// Add \p value as the latest value of the signal.
+  /**
+   * \return the smoothed signal, also returned by value() until the next call.
+   */
+  double filter(double value)
+  {
+    const std::size_t size = std::min(values_.size(), window_size_);
+    switch (mode_)
+    {
+      case SmoothingMode::MEAN:
+        if (size == window_size_)
+        {
+          sum_ -= values_.latest(window_size_ - 1);
+        }
+        values_.push(value);
+        sum_ += value;
+        // sum the window again once per window, so the rounding errors don't accumulate
+        if (++pushes_since_sum_ >= window_size_)
+        {
+          sum_ = 0.0;
+          for (std::size_t i = 0; i < window_size_; ++i)
+          {
+            sum_ += values_.latest(i);
+          }
+          pushes_since_sum_ = 0;
+        }
+        value_ = sum_ / static_cast<double>(std::min(size + 1, window_size_));
+        break;
+      case SmoothingMode::EXPONENTIAL:
+        values_.push(value);
+        value_ = size == 0 ? value : value_ + smoothing_factor() * (value - value_);
+        break;
+      case SmoothingMode::MEDIAN:
+      {
+        values_.push(value);
+        const std::size_t count = std::min(size + 1, window_size_);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+          sorted_[i] = values_.latest(i);
+        }
+        const auto end = sorted_.begin() + static_cast<std::ptrdiff_t>(count);
+        const auto middle = sorted_.begin() + static_cast<std::ptrdiff_t>(count / 2);
+        std::nth_element(sorted_.begin(), middle, end);
+        value_ = *middle;
+        if (count % 2 == 0)
+        {
+          // mean of the two middle values, the lower one is the largest of the lower half
+          value_ = 0.5 * (value_ + *std::max_element(sorted_.begin(), middle));
+        }
+        break;
+      }
+    }
+    return value_;
+  }
+
+  /// The smoothed signal after the last value filtered.
+  double value() const { return value_; }
+
+  std::size_t window_size() const { return window_size_; }
+  SmoothingMode mode() const { return mode_; }
+  static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+  double smoothing_factor() const { return 2.0 / (static_cast<double>(window_size_) + 1.0); }
+
+  RingBuffer<double, Capacity> values_;
+  // scratch space for the median
+  std::array<double, Capacity> sorted_{};
+  std::size_t window_size_ = Capacity;
+  SmoothingMode mode_ = SmoothingMode::MEAN;
+  // sum of the last window size values, for the mean
+  double sum_ = 0.0;
+  std::size_t pushes_since_sum_ = 0;
+  double value_ = 0.0;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__SMOOTHING_FILTER_HPP_
@@ -0,0 +1,121 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__THREAD_SCHEDULING_HPP_
+#define CONTROLLER_REALTIME_TOOLS__THREAD_SCHEDULING_HPP_
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace controller_realtime_tools
+{
+/// Scheduling of a non-realtime thread of a controller, e.g. to keep it off the realtime CPUs.
+struct ThreadScheduling
+{
+  /// SCHED_FIFO priority, 0 keeps the default policy
+  int priority = 0;
+  /// CPUs the thread may run on, all if empty
+  std::vector<int> cpu_affinity;
+};
+
+/// Build the scheduling from the int and int_array parameters of a controller.
+inline ThreadScheduling make_thread_scheduling(
+  std::int64_t priority, const std::vector<std::int64_t> & cpu_affinity)
+{
+  ThreadScheduling scheduling;
+  scheduling.priority = static_cast<int>(priority);
+  for (const auto cpu : cpu_affinity)
+  {
+    scheduling.cpu_affinity.push_back(static_cast<int>(cpu));
+  }
+  return scheduling;
+}
+
+/// Schedule \p thread with SCHED_FIFO and \p priority, 0 restores the default policy.
+/**
+ * \return false if not permitted, or not supported on this platform.
+ */
+inline bool set_thread_priority(std::thread & thread, int priority)
+{
+#if defined(__linux__)
+  sched_param param{};
+  param.sched_priority = priority;
+  return pthread_setschedparam(
+           thread.native_handle(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param) == 0;
+#else
+  (void)thread;
+  (void)priority;
+  return false;
+#endif
+}
+
+/// Pin \p thread to \p cpus, an empty list allows all CPUs.
+/**
+ * \return false if any CPU doesn't exist, or not supported on this platform.
+ */
+inline bool set_thread_cpu_affinity(std::thread & thread, const std::vector<int> & cpus)
+{
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (cpus.empty())
+  {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  for (const int cpu : cpus)
+  {
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+    {
+      return false;
+    }
+    CPU_SET(cpu, &cpu_set);
+  }
+  return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+  (void)thread;
+  (void)cpus;
+  return false;
+#endif
+}
+
+/// Apply the priority and the CPU affinity of \p scheduling which differ from the defaults.
+/**
+ * \return false if either could not be applied.
+ */
+inline bool set_thread_scheduling(std::thread & thread, const ThreadScheduling & scheduling)
+{
+  bool success = true;
+  if (scheduling.priority > 0)
+  {
+    success &= set_thread_priority(thread, scheduling.priority);
+  }
+  if (!scheduling.cpu_affinity.empty())
+  {
+    success &= set_thread_cpu_affinity(thread, scheduling.cpu_affinity);
+  }
+  return success;
+}
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__THREAD_SCHEDULING_HPP_
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__TRACING_HPP_
+#define CONTROLLER_REALTIME_TOOLS__TRACING_HPP_
+
+#include <cstdint>
+
+namespace controller_realtime_tools
+{
+namespace tracing
+{
+/**
+ * \brief Stages of the controllers traced with CONTROLLER_TRACEPOINT().
+ *
+ * Each stage is an lttng-ust event of the provider \c ros2_controllers, named like the stage in
+ * lower case, e.g. \c ros2_controllers:trajectory_received. Every event has the address of the
+ * object emitting it as \c source, to tell the controllers apart, and a \c value, see below.
+ */
+enum class Stage : std::uint8_t
+{
+  TRAJECTORY_RECEIVED,   ///< A trajectory msg or goal is received, value: number of points
+  TRAJECTORY_COMPILED,   ///< A trajectory is ready to be swapped in, value: number of points
+  TRAJECTORY_ACTIVATED,  ///< The realtime loop swapped in a trajectory, value: number of points
+  REFERENCE_RECEIVED,    ///< The realtime loop took the reference of the subscribers, value: 0
+  ODOMETRY_INTEGRATED,   ///< The odometry is integrated, value: time of the cycle in ns
+  ODOMETRY_PUBLISHED,    ///< The odometry is handed to its publisher, value: its stamp in ns
+  KINEMATICS_BEGIN,      ///< Calls of the kinematics plugin begin, value: 0
+  KINEMATICS_END,        ///< Calls of the kinematics plugin end, value: 1 if they succeeded
+};
+
+#if defined(CONTROLLER_REALTIME_TOOLS_TRACING)
+/// Emit the event of \p stage. Realtime-safe, and only a check whether the event is enabled
+/// while no tracing session records it.
+void trace(Stage stage, const void * source, std::uint64_t value) noexcept;
+#endif
+}  // namespace tracing
+}  // namespace controller_realtime_tools
+
+/**
+ * \brief Trace \p stage, one of tracing::Stage, of \p source with \p value.
+ *
+ * Only compiled in with the CMake option CONTROLLER_TRACING of controller_realtime_tools, which
+ * requires lttng-ust. Otherwise its arguments are not evaluated, so they must not have side
+ * effects.
+ */
+#if defined(CONTROLLER_REALTIME_TOOLS_TRACING)
+#define CONTROLLER_TRACEPOINT(stage, source, value)                                        \
+  ::controller_realtime_tools::tracing::trace(                                             \
+    ::controller_realtime_tools::tracing::Stage::stage, static_cast<const void *>(source), \
+    static_cast<std::uint64_t>(value))
+#else
+// unevaluated, but the stage is still checked and the arguments count as used
+#define CONTROLLER_TRACEPOINT(stage, source, value)                                          \
+  static_cast<void>(                                                                         \
+    sizeof(::controller_realtime_tools::tracing::Stage::stage) + sizeof(source) + sizeof(value))
+#endif
+
+#endif  // CONTROLLER_REALTIME_TOOLS__TRACING_HPP_
@@ -0,0 +1,110 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__TRACKING_ERROR_STATISTICS_HPP_
+#define CONTROLLER_REALTIME_TOOLS__TRACKING_ERROR_STATISTICS_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Running RMS and maximum of the tracking errors of the joints during a motion, e.g. the
+ * execution of a goal, so they don't have to be computed from the state logged at full rate.
+ *
+ * The realtime side adds the errors of every update with add(), in constant time per joint.
+ * Errors which are NaN, e.g. of a joint without state, are not counted.
+ */
+class TrackingErrorStatistics
+{
+public:
+  /// Allocate the accumulators of \p num_joints and clear them. Non-realtime.
+  void resize(std::size_t num_joints)
+  {
+    joints_.resize(num_joints);
+    clear(0.0);
+  }
+
+  /// Start a new motion at \p start_time [s]. Realtime.
+  void clear(double start_time)
+  {
+    start_time_ = start_time;
+    for (auto & joint : joints_)
+    {
+      joint = Joint();
+    }
+  }
+
+  /// Add the errors of all joints at \p time [s]. Realtime.
+  void add(const double * errors, double time)
+  {
+    for (std::size_t index = 0; index < joints_.size(); ++index)
+    {
+      const double error = std::abs(errors[index]);
+      if (std::isnan(error))
+      {
+        continue;
+      }
+      auto & joint = joints_[index];
+      ++joint.count;
+      joint.sum_of_squares += error * error;
+      if (error > joint.max)
+      {
+        joint.max = error;
+        joint.time_of_max = time - start_time_;
+      }
+    }
+  }
+
+  std::size_t num_joints() const { return joints_.size(); }
+
+  /// Start time of the motion [s], as given to clear().
+  double start_time() const { return start_time_; }
+
+  /// Number of errors added of joint \p index.
+  std::uint64_t count(std::size_t index) const { return joints_[index].count; }
+
+  /// Root mean square of the errors of joint \p index, 0 without any.
+  double rms(std::size_t index) const
+  {
+    const auto & joint = joints_[index];
+    return joint.count > 0 ? std::sqrt(joint.sum_of_squares / static_cast<double>(joint.count))
+                           : 0.0;
+  }
+
+  /// Maximum absolute error of joint \p index, 0 without any.
+  double max(std::size_t index) const { return joints_[index].max; }
+
+  /// Time of max(), relative to start_time() [s].
+  double time_of_max(std::size_t index) const { return joints_[index].time_of_max; }
+
+private:
+  struct Joint
+  {
+    std::uint64_t count = 0;
+    double sum_of_squares = 0.0;
+    double max = 0.0;
+    double time_of_max = 0.0;
+  };
+
+  std::vector<Joint> joints_;
+  double start_time_ = 0.0;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__TRACKING_ERROR_STATISTICS_HPP_
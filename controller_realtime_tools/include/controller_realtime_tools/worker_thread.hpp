@@ -0,0 +1,132 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_REALTIME_TOOLS__WORKER_THREAD_HPP_
+#define CONTROLLER_REALTIME_TOOLS__WORKER_THREAD_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "controller_realtime_tools/thread_scheduling.hpp"
+
+namespace controller_realtime_tools
+{
+/**
+ * \brief Thread running the jobs posted by other non-realtime threads in order.
+ *
+ * Used to take heavy non-realtime work off the executor threads, e.g. the preprocessing of
+ * messages. The thread can be given a scheduling priority and be pinned to CPUs, to isolate it
+ * from the realtime thread and the executor.
+ *
+ * None of the methods are realtime-safe.
+ */
+class WorkerThread
+{
+public:
+  using Job = std::function<void()>;
+
+  WorkerThread() { thread_ = std::thread(&WorkerThread::run, this); }
+
+  WorkerThread(const WorkerThread &) = delete;
+  WorkerThread & operator=(const WorkerThread &) = delete;
+
+  /// Wait for the running job, the jobs posted but not started yet are dropped.
+  ~WorkerThread()
+  {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      keep_running_ = false;
+      jobs_.clear();
+    }
+    jobs_changed_.notify_all();
+    thread_.join();
+  }
+
+  /// Run \p job after the jobs posted before.
+  void post(Job job)
+  {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    jobs_changed_.notify_all();
+  }
+
+  /// Wait until all jobs posted before ran.
+  void wait_until_idle()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_changed_.wait(lock, [this] { return jobs_.empty() && !job_running_; });
+  }
+
+  /// Schedule the thread with SCHED_FIFO and \p priority, 0 restores the default policy.
+  /**
+   * \return false if not permitted, or not supported on this platform.
+   */
+  bool set_priority(int priority) { return set_thread_priority(thread_, priority); }
+
+  /// Pin the thread to \p cpus, an empty list allows all CPUs.
+  /**
+   * \return false if any CPU doesn't exist, or not supported on this platform.
+   */
+  bool set_cpu_affinity(const std::vector<int> & cpus)
+  {
+    return set_thread_cpu_affinity(thread_, cpus);
+  }
+
+  /// Apply \p scheduling to the thread, see set_thread_scheduling().
+  bool set_scheduling(const ThreadScheduling & scheduling)
+  {
+    return set_thread_scheduling(thread_, scheduling);
+  }
+
+private:
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      jobs_changed_.wait(lock, [this] { return !keep_running_ || !jobs_.empty(); });
+      if (!keep_running_)
+      {
+        return;
+      }
+      Job job = std::move(jobs_.front());
+      jobs_.pop_front();
+      job_running_ = true;
+      lock.unlock();
+      job();
+      lock.lock();
+      job_running_ = false;
+      jobs_changed_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable jobs_changed_;
+  // guarded by mutex_
+  std::deque<Job> jobs_;
+  bool job_running_ = false;
+  bool keep_running_ = true;
+  std::thread thread_;
+};
+
+}  // namespace controller_realtime_tools
+
+#endif  // CONTROLLER_REALTIME_TOOLS__WORKER_THREAD_HPP_
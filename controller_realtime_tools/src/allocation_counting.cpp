@@ -0,0 +1,93 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Interposes malloc() and its siblings of glibc when preloaded, and counts the allocations of a
+// thread into its AllocationCounter, see memory_footprint.hpp. Never link it into a controller.
+
+#include <cerrno>
+#include <cstddef>
+
+#include "controller_realtime_tools/memory_footprint.hpp"
+
+using controller_realtime_tools::AllocationCounter;
+
+namespace
+{
+// static TLS of the preloaded library, its access doesn't allocate
+__attribute__((tls_model("initial-exec"))) thread_local AllocationCounter * current_counter =
+  nullptr;
+
+inline void count(std::size_t bytes)
+{
+  if (current_counter)
+  {
+    current_counter->count(bytes);
+  }
+}
+}  // namespace
+
+extern "C"
+{
+  // the implementations of glibc, which stay callable when malloc() is interposed
+  void * __libc_malloc(std::size_t size);
+  void * __libc_calloc(std::size_t count, std::size_t size);
+  void * __libc_realloc(void * ptr, std::size_t size);
+  void * __libc_memalign(std::size_t alignment, std::size_t size);
+
+  __attribute__((visibility("default"))) AllocationCounter *
+  controller_realtime_tools_exchange_allocation_counter(AllocationCounter * counter)
+  {
+    AllocationCounter * previous = current_counter;
+    current_counter = counter;
+    return previous;
+  }
+
+  __attribute__((visibility("default"))) void * malloc(std::size_t size) noexcept
+  {
+    count(size);
+    return __libc_malloc(size);
+  }
+
+  __attribute__((visibility("default"))) void * calloc(std::size_t count, std::size_t size) noexcept
+  {
+    ::count(count * size);
+    return __libc_calloc(count, size);
+  }
+
+  __attribute__((visibility("default"))) void * realloc(void * ptr, std::size_t size) noexcept
+  {
+    count(size);
+    return __libc_realloc(ptr, size);
+  }
+
+  __attribute__((visibility("default"))) void * aligned_alloc(
+    std::size_t alignment, std::size_t size) noexcept
+  {
+    count(size);
+    return __libc_memalign(alignment, size);
+  }
+
+  __attribute__((visibility("default"))) int posix_memalign(
+    void ** ptr, std::size_t alignment, std::size_t size) noexcept
+  {
+    count(size);
+    void * memory = __libc_memalign(alignment, size);
+    if (!memory)
+    {
+      return ENOMEM;
+    }
+    *ptr = memory;
+    return 0;
+  }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The tracepoints are only defined in this library, so the controllers, each a library of its
+// own, don't need to register the provider themselves.
+#define TRACEPOINT_CREATE_PROBES
+#define TRACEPOINT_DEFINE
+#include "tracing_provider.hpp"
+
+#include "controller_realtime_tools/tracing.hpp"
+
+namespace controller_realtime_tools
+{
+namespace tracing
+{
+void trace(Stage stage, const void * source, std::uint64_t value) noexcept
+{
+  switch (stage)
+  {
+    case Stage::TRAJECTORY_RECEIVED:
+      tracepoint(ros2_controllers, trajectory_received, source, value);
+      break;
+    case Stage::TRAJECTORY_COMPILED:
+      tracepoint(ros2_controllers, trajectory_compiled, source, value);
+      break;
+    case Stage::TRAJECTORY_ACTIVATED:
+      tracepoint(ros2_controllers, trajectory_activated, source, value);
+      break;
+    case Stage::REFERENCE_RECEIVED:
+      tracepoint(ros2_controllers, reference_received, source, value);
+      break;
+    case Stage::ODOMETRY_INTEGRATED:
+      tracepoint(ros2_controllers, odometry_integrated, source, value);
+      break;
+    case Stage::ODOMETRY_PUBLISHED:
+      tracepoint(ros2_controllers, odometry_published, source, value);
+      break;
+    case Stage::KINEMATICS_BEGIN:
+      tracepoint(ros2_controllers, kinematics_begin, source, value);
+      break;
+    case Stage::KINEMATICS_END:
+      tracepoint(ros2_controllers, kinematics_end, source, value);
+      break;
+  }
+}
+}  // namespace tracing
+}  // namespace controller_realtime_tools
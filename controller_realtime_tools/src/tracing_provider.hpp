@@ -0,0 +1,55 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// lttng-ust tracepoint provider of the stages in controller_realtime_tools/tracing.hpp. Like any
+// tracepoint provider, this header is read several times by lttng-ust, so it has no plain include
+// guard.
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER ros2_controllers
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "tracing_provider.hpp"
+
+#if !defined(CONTROLLER_REALTIME_TOOLS__TRACING_PROVIDER_HPP_) || \
+  defined(TRACEPOINT_HEADER_MULTI_READ)
+#define CONTROLLER_REALTIME_TOOLS__TRACING_PROVIDER_HPP_
+
+#include <lttng/tracepoint.h>
+
+#include <cstdint>
+
+TRACEPOINT_EVENT_CLASS(
+  ros2_controllers, stage, TP_ARGS(const void *, source_arg, uint64_t, value_arg),
+  TP_FIELDS(
+    ctf_integer_hex(const void *, source, source_arg) ctf_integer(uint64_t, value, value_arg)))
+
+#define CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(name) \
+  TRACEPOINT_EVENT_INSTANCE(                         \
+    ros2_controllers, stage, name, TP_ARGS(const void *, source_arg, uint64_t, value_arg))
+
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(trajectory_received)
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(trajectory_compiled)
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(trajectory_activated)
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(reference_received)
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(odometry_integrated)
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(odometry_published)
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(kinematics_begin)
+CONTROLLER_REALTIME_TOOLS__STAGE_EVENT(kinematics_end)
+
+#undef CONTROLLER_REALTIME_TOOLS__STAGE_EVENT
+
+#endif  // CONTROLLER_REALTIME_TOOLS__TRACING_PROVIDER_HPP_
+
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,116 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "controller_realtime_tools/action_monitor.hpp"
+
+using controller_realtime_tools::ActionMonitor;
+using namespace std::chrono_literals;
+
+namespace
+{
+// wait up to 5s for the condition
+template <typename Condition>
+bool eventually(Condition condition)
+{
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!condition())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+}  // namespace
+
+TEST(TestActionMonitor, runs_only_when_notified)
+{
+  std::atomic<int> runs{0};
+  ActionMonitor monitor(
+    10ms,
+    [&runs]()
+    {
+      ++runs;
+      return false;
+    });
+
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(0, runs.load());
+
+  monitor.notify();
+  ASSERT_TRUE(eventually([&runs]() { return runs.load() == 1; }));
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(1, runs.load());
+}
+
+TEST(TestActionMonitor, notifications_are_served_once_per_period)
+{
+  std::atomic<int> runs{0};
+  ActionMonitor monitor(
+    100ms,
+    [&runs]()
+    {
+      ++runs;
+      return false;
+    });
+
+  monitor.notify();
+  ASSERT_TRUE(eventually([&runs]() { return runs.load() == 1; }));
+  // notifications within the period are served by one run after it
+  for (int i = 0; i < 100; ++i)
+  {
+    monitor.notify();
+  }
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(1, runs.load());
+  ASSERT_TRUE(eventually([&runs]() { return runs.load() == 2; }));
+  std::this_thread::sleep_for(250ms);
+  EXPECT_EQ(2, runs.load());
+}
+
+TEST(TestActionMonitor, polls_while_the_service_returns_true)
+{
+  std::atomic<int> runs{0};
+  ActionMonitor monitor(
+    5ms,
+    [&runs]()
+    {
+      // poll for 3 runs
+      return ++runs < 3;
+    });
+
+  monitor.notify();
+  ASSERT_TRUE(eventually([&runs]() { return runs.load() == 3; }));
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(3, runs.load());
+}
+
+TEST(TestActionMonitor, destruction_does_not_wait_for_a_notification)
+{
+  const auto start = std::chrono::steady_clock::now();
+  {
+    ActionMonitor monitor(10s, []() { return true; });
+    monitor.notify();
+    std::this_thread::sleep_for(10ms);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
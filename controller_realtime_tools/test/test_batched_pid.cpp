@@ -0,0 +1,116 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "control_toolbox/pid.hpp"
+#include "controller_realtime_tools/batched_pid.hpp"
+
+using controller_realtime_tools::BatchedPid;
+
+namespace
+{
+const std::vector<BatchedPid::Gains> GAINS = {
+  {1.0, 0.0, 0.0, 0.0}, {2.0, 0.5, 0.1, 0.2}, {0.5, 3.0, 0.0, 10.0}, {0.0, 1.0, 2.0, 0.05}};
+}  // namespace
+
+TEST(TestBatchedPid, matches_pid)
+{
+  BatchedPid batched_pid;
+  batched_pid.configure(GAINS);
+  ASSERT_EQ(GAINS.size(), batched_pid.size());
+
+  std::vector<control_toolbox::Pid> pids;
+  for (const auto & gains : GAINS)
+  {
+    pids.emplace_back(gains.p, gains.i, gains.d, gains.i_clamp, -gains.i_clamp);
+  }
+
+  const uint64_t dt_ns = 1000000;
+  std::vector<double> error(GAINS.size());
+  std::vector<double> error_dot(GAINS.size());
+  std::vector<double> commands(GAINS.size());
+  for (size_t k = 0; k < 500; ++k)
+  {
+    for (size_t j = 0; j < GAINS.size(); ++j)
+    {
+      error[j] = std::sin(0.01 * static_cast<double>(k * (j + 1)));
+      error_dot[j] = std::cos(0.03 * static_cast<double>(k + j));
+    }
+    // invalid errors are skipped
+    if (k % 100 == 50)
+    {
+      error[1] = std::numeric_limits<double>::quiet_NaN();
+      error_dot[2] = std::numeric_limits<double>::infinity();
+    }
+
+    batched_pid.compute_commands(
+      error.data(), error_dot.data(), static_cast<double>(dt_ns) / 1e9, commands.data());
+    for (size_t j = 0; j < GAINS.size(); ++j)
+    {
+      EXPECT_NEAR(pids[j].computeCommand(error[j], error_dot[j], dt_ns), commands[j], 1e-12)
+        << "joint " << j << " at cycle " << k;
+    }
+  }
+}
+
+TEST(TestBatchedPid, zero_dt_and_reset)
+{
+  BatchedPid batched_pid;
+  batched_pid.configure(GAINS);
+
+  const std::vector<double> error(GAINS.size(), 1.0);
+  const std::vector<double> error_dot(GAINS.size(), 0.0);
+  std::vector<double> commands(GAINS.size(), 1.0);
+
+  batched_pid.compute_commands(error.data(), error_dot.data(), 0.0, commands.data());
+  EXPECT_THAT(commands, testing::Each(0.0));
+
+  // the integral term of joint 2 is not limited by its clamp within 1s
+  batched_pid.compute_commands(error.data(), error_dot.data(), 1.0, commands.data());
+  EXPECT_DOUBLE_EQ(0.5 + 3.0, commands[2]);
+  batched_pid.compute_commands(error.data(), error_dot.data(), 1.0, commands.data());
+  EXPECT_DOUBLE_EQ(0.5 + 6.0, commands[2]);
+
+  batched_pid.reset();
+  batched_pid.compute_commands(error.data(), error_dot.data(), 1.0, commands.data());
+  EXPECT_DOUBLE_EQ(0.5 + 3.0, commands[2]);
+}
+
+TEST(TestBatchedPid, set_gains_keeps_integral_states)
+{
+  BatchedPid batched_pid;
+  batched_pid.configure(GAINS);
+
+  const std::vector<double> error(GAINS.size(), 1.0);
+  const std::vector<double> error_dot(GAINS.size(), 0.0);
+  std::vector<double> commands(GAINS.size());
+
+  batched_pid.compute_commands(error.data(), error_dot.data(), 1.0, commands.data());
+  EXPECT_DOUBLE_EQ(0.5 + 3.0, commands[2]);
+
+  std::vector<BatchedPid::Gains> gains = GAINS;
+  gains[2].p = 2.0;
+  gains[2].i = 1.0;
+  batched_pid.set_gains(gains);
+  ASSERT_EQ(GAINS.size(), batched_pid.size());
+
+  // the integral of the error is 2 after the second call
+  batched_pid.compute_commands(error.data(), error_dot.data(), 1.0, commands.data());
+  EXPECT_DOUBLE_EQ(2.0 + 2.0, commands[2]);
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+
+#include "controller_realtime_tools/biquad_filter.hpp"
+
+using controller_realtime_tools::BiquadFilter;
+
+TEST(TestBiquadFilter, passes_through_until_configured)
+{
+  BiquadFilter filter;
+  EXPECT_EQ(filter.filter(1.5), 1.5);
+  EXPECT_EQ(filter.filter(-3.0), -3.0);
+}
+
+TEST(TestBiquadFilter, butterworth_low_pass)
+{
+  BiquadFilter filter;
+  EXPECT_FALSE(filter.configure_butterworth_low_pass(0.0, 1000.0));
+  EXPECT_FALSE(filter.configure_butterworth_low_pass(500.0, 1000.0));
+  ASSERT_TRUE(filter.configure_butterworth_low_pass(10.0, 1000.0));
+
+  // a constant signal doesn't start with a transient
+  for (int i = 0; i < 10; ++i)
+  {
+    EXPECT_NEAR(filter.filter(2.0), 2.0, 1e-12);
+  }
+
+  // a sine at the cutoff frequency is attenuated by 3 dB, one far above it by much more
+  const auto amplitude = [&filter](double frequency)
+  {
+    filter.reset();
+    double peak = 0.0;
+    for (int i = 0; i < 4000; ++i)
+    {
+      const double output = filter.filter(std::sin(2.0 * M_PI * frequency * i / 1000.0));
+      if (i >= 2000)
+      {
+        peak = std::max(peak, std::abs(output));
+      }
+    }
+    return peak;
+  };
+  EXPECT_NEAR(amplitude(10.0), M_SQRT1_2, 1e-2);
+  EXPECT_LT(amplitude(200.0), 0.01);
+}
+
+TEST(TestBiquadFilter, reset_forgets_the_previous_values)
+{
+  BiquadFilter filter;
+  ASSERT_TRUE(filter.configure_butterworth_low_pass(5.0, 100.0));
+  filter.filter(0.0);
+  EXPECT_LT(filter.filter(10.0), 10.0);
+
+  filter.reset();
+  EXPECT_NEAR(filter.filter(10.0), 10.0, 1e-12);
+}
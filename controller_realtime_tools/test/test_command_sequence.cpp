@@ -0,0 +1,54 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <limits>
+
+#include "controller_realtime_tools/command_sequence.hpp"
+
+using controller_realtime_tools::CommandSequence;
+
+TEST(TestCommandSequence, counts_up_only_for_changed_commands)
+{
+  CommandSequence sequence;
+  sequence.reset(2);
+  ASSERT_EQ(sequence.size(), 2u);
+  // the first command is always a change
+  EXPECT_EQ(sequence.update(0, 0.0), 1.0);
+  EXPECT_EQ(sequence.update(1, 5.0), 1.0);
+  EXPECT_EQ(sequence.update(0, 0.0), 1.0);
+  EXPECT_EQ(sequence.update(1, 5.0), 1.0);
+  EXPECT_EQ(sequence.update(0, 0.5), 2.0);
+  EXPECT_EQ(sequence.update(1, 5.0), 1.0);
+
+  // an unchanged NaN is no change, unlike with operator==
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_EQ(sequence.update(0, nan), 3.0);
+  EXPECT_EQ(sequence.update(0, nan), 3.0);
+}
+
+TEST(TestCommandSequence, restart_keeps_counting)
+{
+  CommandSequence sequence;
+  sequence.reset(1);
+  EXPECT_EQ(sequence.update(0, 1.0), 1.0);
+  sequence.restart();
+  // the same command is a change after the restart, with a new sequence number
+  EXPECT_EQ(sequence.update(0, 1.0), 2.0);
+  EXPECT_EQ(sequence.update(0, 1.0), 2.0);
+
+  sequence.reset(1);
+  EXPECT_EQ(sequence.update(0, 1.0), 1.0);
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <thread>
+
+#include "controller_realtime_tools/cycle_budget.hpp"
+
+using controller_realtime_tools::CycleBudget;
+
+TEST(TestCycleBudget, stages_are_skipped_for_the_recovery_cycles_after_an_overrun)
+{
+  CycleBudget budget(std::chrono::milliseconds(20), 3, {"publish_state", "feedback"});
+  {
+    CycleBudget::Scope scope(&budget);
+    EXPECT_FALSE(budget.skip(0));
+  }
+
+  {
+    CycleBudget::Scope scope(&budget);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    // the rest of an update over the budget is shed already
+    EXPECT_TRUE(budget.skip(1));
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    CycleBudget::Scope scope(&budget);
+    EXPECT_TRUE(budget.skip(0));
+    EXPECT_TRUE(budget.skip(1));
+  }
+  {
+    CycleBudget::Scope scope(&budget);
+    EXPECT_FALSE(budget.skip(0));
+  }
+
+  EXPECT_EQ(budget.get_overruns(), 1u);
+  EXPECT_EQ(budget.get_skipped(0), 3u);
+  EXPECT_EQ(budget.get_skipped(1), 4u);
+  // counted since the previous read
+  EXPECT_EQ(budget.get_skipped(1), 0u);
+}
+
+TEST(TestCycleBudget, report_summarizes_the_counts_since_the_previous_one)
+{
+  CycleBudget budget(std::chrono::milliseconds(0), 10, {"publish_state", "feedback"});
+  EXPECT_EQ(budget.get_report(), "");
+  {
+    CycleBudget::Scope scope(&budget);
+    std::this_thread::sleep_for(std::chrono::microseconds(10));
+    budget.skip(1);
+  }
+  EXPECT_EQ(
+    budget.get_report(), "1 updates over the cycle budget of 0 us, skipped feedback 1 times");
+  EXPECT_EQ(budget.get_report(), "");
+
+  // without a budget the scope does nothing
+  CycleBudget::Scope scope(nullptr);
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "controller_realtime_tools/cycle_timing.hpp"
+
+using controller_realtime_tools::CycleTiming;
+
+namespace
+{
+void busy_wait(std::chrono::microseconds duration)
+{
+  const auto end = CycleTiming::Clock::now() + duration;
+  while (CycleTiming::Clock::now() < end)
+  {
+  }
+}
+}  // namespace
+
+TEST(TestCycleTiming, statistics_per_phase)
+{
+  CycleTiming timing(2);
+  ASSERT_EQ(timing.size(), 2u);
+  EXPECT_EQ(timing.get_statistics(0).count, 0u);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    timing.start_cycle();
+    busy_wait(std::chrono::microseconds(100));
+    timing.end_phase(0);
+    busy_wait(std::chrono::microseconds(500));
+    timing.end_phase(1);
+  }
+
+  const auto first_phase = timing.get_statistics(0);
+  EXPECT_EQ(first_phase.count, 10u);
+  EXPECT_GE(first_phase.min_ns, 100e3);
+  EXPECT_GE(first_phase.mean_ns, first_phase.min_ns);
+  EXPECT_GE(first_phase.max_ns, first_phase.mean_ns);
+  EXPECT_GE(first_phase.stddev_ns, 0.0);
+
+  const auto second_phase = timing.get_statistics(1);
+  EXPECT_EQ(second_phase.count, 10u);
+  EXPECT_GE(second_phase.min_ns, 500e3);
+  EXPECT_GT(second_phase.mean_ns, first_phase.mean_ns);
+}
+
+TEST(TestCycleTiming, statistics_since_last_read)
+{
+  CycleTiming timing(1);
+  timing.start_cycle();
+  busy_wait(std::chrono::microseconds(1000));
+  timing.end_phase(0);
+  EXPECT_EQ(timing.get_statistics(0).count, 1u);
+
+  // nothing was recorded since
+  const auto empty = timing.get_statistics(0);
+  EXPECT_EQ(empty.count, 0u);
+  EXPECT_EQ(empty.max_ns, 0.0);
+
+  timing.start_cycle();
+  timing.end_phase(0);
+  const auto statistics = timing.get_statistics(0);
+  EXPECT_EQ(statistics.count, 1u);
+  // the long sample of the first window does not show up
+  EXPECT_LT(statistics.max_ns, 1e6);
+  EXPECT_DOUBLE_EQ(statistics.min_ns, statistics.max_ns);
+  EXPECT_NEAR(statistics.stddev_ns, 0.0, 1e-3 * statistics.mean_ns + 1.0);
+}
+
+TEST(TestCycleTiming, concurrent_reads)
+{
+  CycleTiming timing(1);
+  std::atomic<bool> done{false};
+  uint64_t read_count = 0;
+  std::thread reader(
+    [&]()
+    {
+      while (!done.load())
+      {
+        read_count += timing.get_statistics(0).count;
+      }
+    });
+
+  for (int i = 0; i < 100000; ++i)
+  {
+    timing.start_cycle();
+    timing.end_phase(0);
+  }
+  done.store(true);
+  reader.join();
+  read_count += timing.get_statistics(0).count;
+  EXPECT_EQ(read_count, 100000u);
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "controller_realtime_tools/input_recorder.hpp"
+
+using controller_realtime_tools::InputRecorder;
+using controller_realtime_tools::InputRecording;
+
+namespace
+{
+struct StateInterface
+{
+  double value;
+  double get_value() const { return value; }
+};
+
+std::string recording_path(const std::string & name)
+{
+  return testing::TempDir() + "/" + name + ".input_recording";
+}
+}  // namespace
+
+TEST(TestInputRecorder, frames_are_read_back)
+{
+  const auto path = recording_path("frames_are_read_back");
+  {
+    InputRecorder recorder(path, {"joint1/position", "joint2/velocity"}, 1, 100);
+    ASSERT_TRUE(recorder.good());
+    std::vector<StateInterface> states(2);
+    std::vector<double> references(1);
+    for (int i = 0; i < 50; ++i)
+    {
+      states[0].value = i;
+      states[1].value = -i;
+      references[0] = 0.5 * i;
+      EXPECT_TRUE(recorder.record(1000 * i, 1000, states, references));
+    }
+  }
+
+  InputRecording recording;
+  ASSERT_TRUE(controller_realtime_tools::read_input_recording(path, recording));
+  EXPECT_THAT(recording.state_names, testing::ElementsAre("joint1/position", "joint2/velocity"));
+  EXPECT_EQ(recording.num_references, 1u);
+  ASSERT_EQ(recording.size(), 50u);
+  for (size_t i = 0; i < recording.size(); ++i)
+  {
+    const auto value = static_cast<double>(i);
+    EXPECT_EQ(recording.times_ns[i], 1000 * static_cast<std::int64_t>(i));
+    EXPECT_EQ(recording.periods_ns[i], 1000);
+    EXPECT_EQ(recording.states(i)[0], value);
+    EXPECT_EQ(recording.states(i)[1], -value);
+    EXPECT_EQ(recording.references(i)[0], 0.5 * value);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(TestInputRecorder, drops_frames_while_full_or_of_other_sizes)
+{
+  const auto path = recording_path("drops_frames");
+  // a drain period longer than the test, so only the destructor writes the frames
+  InputRecorder recorder(path, {"state"}, 0, 3, std::chrono::hours(1));
+  const std::vector<StateInterface> states = {{1.0}};
+  const std::vector<double> references;
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_TRUE(recorder.record(i, 1, states, references));
+  }
+  EXPECT_FALSE(recorder.record(3, 1, states, references));
+  EXPECT_EQ(recorder.dropped(), 1u);
+
+  recorder.drain();
+  EXPECT_TRUE(recorder.record(4, 1, states, references));
+  EXPECT_FALSE(recorder.record(5, 1, std::vector<StateInterface>(2), references));
+  EXPECT_FALSE(recorder.record(6, 1, states, std::vector<double>(1)));
+  EXPECT_EQ(recorder.dropped(), 3u);
+  recorder.drain();
+
+  InputRecording recording;
+  ASSERT_TRUE(controller_realtime_tools::read_input_recording(path, recording));
+  EXPECT_THAT(recording.times_ns, testing::ElementsAre(0, 1, 2, 4));
+  std::remove(path.c_str());
+}
+
+TEST(TestInputRecorder, cut_off_frames_and_other_files_are_handled)
+{
+  const auto path = recording_path("cut_off");
+  {
+    InputRecorder recorder(path, {"state"}, 1);
+    const std::vector<StateInterface> states = {{1.0}};
+    recorder.record(0, 1, states, std::vector<double>{2.0});
+  }
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write("cut", 3);
+  }
+  InputRecording recording;
+  ASSERT_TRUE(controller_realtime_tools::read_input_recording(path, recording));
+  EXPECT_EQ(recording.size(), 1u);
+
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "not a recording";
+  }
+  EXPECT_FALSE(controller_realtime_tools::read_input_recording(path, recording));
+  EXPECT_FALSE(controller_realtime_tools::read_input_recording(path + ".missing", recording));
+  std::remove(path.c_str());
+}
+
+TEST(TestInputRecorder, replay_writes_the_inputs_before_each_update)
+{
+  InputRecording recording;
+  recording.state_names = {"a", "b"};
+  recording.num_references = 1;
+  recording.times_ns = {10, 20};
+  recording.periods_ns = {10, 10};
+  recording.values = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+
+  double a = 0.0, b = 0.0, reference = 0.0;
+  std::vector<std::vector<double>> updates;
+  ASSERT_TRUE(controller_realtime_tools::replay_inputs(
+    recording, {&a, &b}, {&reference},
+    [&](std::int64_t time_ns, std::int64_t period_ns)
+    {
+      updates.push_back(
+        {static_cast<double>(time_ns), static_cast<double>(period_ns), a, b, reference});
+    }));
+  ASSERT_EQ(updates.size(), 2u);
+  EXPECT_THAT(updates[0], testing::ElementsAre(10.0, 10.0, 1.0, 2.0, 3.0));
+  EXPECT_THAT(updates[1], testing::ElementsAre(20.0, 10.0, 4.0, 5.0, 6.0));
+
+  EXPECT_FALSE(
+    controller_realtime_tools::replay_inputs(recording, {&a}, {&reference}, [](auto, auto) {}));
+}
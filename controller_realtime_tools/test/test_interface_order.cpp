@@ -0,0 +1,87 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include "controller_realtime_tools/interface_order.hpp"
+
+using controller_realtime_tools::InterfaceOrder;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace
+{
+/// Stands in for a loaned interface, counting how often its name is read
+struct FakeInterface
+{
+  const std::string & get_name() const
+  {
+    ++name_reads;
+    return name;
+  }
+
+  std::string name;
+  mutable size_t name_reads = 0;
+};
+}  // namespace
+
+TEST(TestInterfaceOrder, finds_interfaces_in_configured_order)
+{
+  InterfaceOrder order;
+  order.configure({"joint2/position", "joint1/position"});
+  std::vector<FakeInterface> interfaces = {
+    {"joint1/position"}, {"joint1/velocity"}, {"joint2/position"}};
+  ASSERT_TRUE(order.update(interfaces));
+  EXPECT_THAT(order.indices(), ElementsAre(2u, 0u));
+}
+
+TEST(TestInterfaceOrder, checks_cached_order_with_one_comparison_per_interface)
+{
+  InterfaceOrder order;
+  order.configure({"joint1/position", "joint2/position"});
+  std::vector<FakeInterface> interfaces = {{"joint1/position"}, {"joint2/position"}};
+  ASSERT_TRUE(order.update(interfaces));
+
+  interfaces = {{"joint1/position"}, {"joint2/position"}};
+  ASSERT_TRUE(order.update(interfaces));
+  EXPECT_EQ(interfaces[0].name_reads, 1u);
+  EXPECT_EQ(interfaces[1].name_reads, 1u);
+  EXPECT_THAT(order.indices(), ElementsAre(0u, 1u));
+
+  // loaned in another order, looked up again
+  interfaces = {{"joint2/position"}, {"joint1/position"}};
+  ASSERT_TRUE(order.update(interfaces));
+  EXPECT_THAT(order.indices(), ElementsAre(1u, 0u));
+}
+
+TEST(TestInterfaceOrder, fails_for_missing_interfaces)
+{
+  InterfaceOrder order;
+  order.configure({"joint1/position", "joint2/position"});
+  std::vector<FakeInterface> interfaces = {{"joint1/position"}, {"joint2/position"}};
+  ASSERT_TRUE(order.update(interfaces));
+
+  interfaces.pop_back();
+  EXPECT_FALSE(order.update(interfaces));
+  EXPECT_THAT(order.indices(), IsEmpty());
+
+  // reconfiguring drops the cached positions
+  order.configure({"joint1/position"});
+  EXPECT_THAT(order.indices(), IsEmpty());
+  EXPECT_TRUE(order.update(interfaces));
+  EXPECT_THAT(order.indices(), ElementsAre(0u));
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <thread>
+
+#include "controller_realtime_tools/jitter_buffer.hpp"
+
+using controller_realtime_tools::JitterBuffer;
+
+TEST(TestJitterBuffer, plays_out_commands_delayed_in_stamp_order)
+{
+  JitterBuffer<int, 4> buffer;
+  buffer.set_delay(100);
+  EXPECT_FALSE(buffer.play_out(1000));
+
+  // a burst of commands arriving out of order
+  EXPECT_TRUE(buffer.push(1020, 2));
+  EXPECT_TRUE(buffer.push(1000, 1));
+  EXPECT_TRUE(buffer.push(1040, 3));
+  EXPECT_FALSE(buffer.play_out(1050));
+  EXPECT_EQ(buffer.size(), 3u);
+
+  // each one is played out the delay after its stamp, and stays until the next one is due
+  ASSERT_TRUE(buffer.play_out(1100));
+  EXPECT_EQ(buffer.value(), 1);
+  EXPECT_EQ(buffer.stamp(), 1000);
+  ASSERT_TRUE(buffer.play_out(1110));
+  EXPECT_EQ(buffer.value(), 1);
+  ASSERT_TRUE(buffer.play_out(1120));
+  EXPECT_EQ(buffer.value(), 2);
+  // the latest due command wins if the realtime thread was late
+  ASSERT_TRUE(buffer.play_out(1500));
+  EXPECT_EQ(buffer.value(), 3);
+  EXPECT_EQ(buffer.size(), 0u);
+  EXPECT_EQ(buffer.dropped(), 0u);
+
+  // a command stamped before the current one arrived too late
+  EXPECT_TRUE(buffer.push(1030, 4));
+  ASSERT_TRUE(buffer.play_out(1600));
+  EXPECT_EQ(buffer.value(), 3);
+  EXPECT_EQ(buffer.dropped(), 1u);
+
+  buffer.reset();
+  EXPECT_FALSE(buffer.play_out(2000));
+  EXPECT_EQ(buffer.dropped(), 0u);
+}
+
+TEST(TestJitterBuffer, drops_the_oldest_command_if_full)
+{
+  JitterBuffer<int, 2> buffer;
+  buffer.set_delay(0);
+
+  EXPECT_TRUE(buffer.push(10, 1));
+  EXPECT_TRUE(buffer.push(20, 2));
+  // the realtime thread didn't take the pushed commands yet
+  EXPECT_FALSE(buffer.push(30, 3));
+  EXPECT_FALSE(buffer.play_out(0));
+  EXPECT_TRUE(buffer.push(30, 3));
+  EXPECT_FALSE(buffer.play_out(0));
+  EXPECT_EQ(buffer.size(), 2u);
+  EXPECT_EQ(buffer.dropped(), 2u);
+
+  ASSERT_TRUE(buffer.play_out(20));
+  EXPECT_EQ(buffer.value(), 2);
+}
+
+TEST(TestJitterBuffer, concurrent_push_and_play_out)
+{
+  constexpr int NUM_COMMANDS = 10000;
+  JitterBuffer<int, 16> buffer;
+  buffer.set_delay(0);
+
+  std::thread producer(
+    [&buffer]()
+    {
+      for (int i = 1; i <= NUM_COMMANDS; ++i)
+      {
+        while (!buffer.push(i, i))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+  // the commands are played out in the order of their stamps, up to the last one
+  int previous = 0;
+  while (previous < NUM_COMMANDS)
+  {
+    if (buffer.play_out(NUM_COMMANDS))
+    {
+      EXPECT_GE(buffer.value(), previous);
+      EXPECT_EQ(buffer.value(), buffer.stamp());
+      previous = buffer.value();
+    }
+  }
+  producer.join();
+  EXPECT_EQ(buffer.size(), 0u);
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <vector>
+
+#include "controller_realtime_tools/joint_vectors.hpp"
+
+using controller_realtime_tools::JointVectors;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace
+{
+/// The fields of a trajectory_msgs::msg::JointTrajectoryPoint
+struct Point
+{
+  std::vector<double> positions;
+  std::vector<double> velocities;
+  std::vector<double> accelerations;
+  std::vector<double> effort;
+};
+}  // namespace
+
+TEST(TestJointVectors, fields_are_present_or_absent_without_allocating)
+{
+  JointVectors state;
+  state.resize(3, true, false);
+  EXPECT_EQ(state.num_joints(), 3u);
+  EXPECT_THAT(state.positions, ElementsAre(0.0, 0.0, 0.0));
+  EXPECT_TRUE(state.has_velocities());
+  EXPECT_FALSE(state.has_accelerations());
+  EXPECT_FALSE(state.has_effort());
+
+  const double * accelerations = state.accelerations.data();
+  state.set_present(state.accelerations, true, 1.0);
+  EXPECT_THAT(state.accelerations, ElementsAre(1.0, 1.0, 1.0));
+  // reserved by resize()
+  EXPECT_EQ(state.accelerations.data(), accelerations);
+  state.set_present(state.accelerations, false);
+  EXPECT_FALSE(state.has_accelerations());
+
+  JointVectors copy;
+  copy.resize(3, true, true, true);
+  const double * effort = copy.effort.data();
+  copy = state;
+  EXPECT_FALSE(copy.has_effort());
+  copy.set_present(copy.effort, true);
+  EXPECT_EQ(copy.effort.data(), effort);
+}
+
+TEST(TestJointVectors, messages_are_converted_at_the_boundaries)
+{
+  JointVectors state;
+  state.reserve(2);
+  Point point{{1.0, 2.0, 3.0}, {4.0, 5.0}, {}, {6.0, 7.0}};
+  state.from_msg(point);
+  // limited to the reserved joints
+  EXPECT_THAT(state.positions, ElementsAre(1.0, 2.0));
+  EXPECT_THAT(state.velocities, ElementsAre(4.0, 5.0));
+  EXPECT_THAT(state.accelerations, IsEmpty());
+  EXPECT_THAT(state.effort, ElementsAre(6.0, 7.0));
+
+  state.velocities.clear();
+  Point msg{{0.0}, {0.0}, {0.0}, {0.0}};
+  state.to_msg(msg);
+  EXPECT_THAT(msg.positions, ElementsAre(1.0, 2.0));
+  EXPECT_THAT(msg.velocities, IsEmpty());
+  EXPECT_THAT(msg.accelerations, IsEmpty());
+  EXPECT_THAT(msg.effort, ElementsAre(6.0, 7.0));
+}
@@ -0,0 +1,149 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#include "controller_realtime_tools/latency_probe.hpp"
+
+using controller_realtime_tools::LatencyProbe;
+
+TEST(TestLatencyProbe, statistics_per_stage)
+{
+  LatencyProbe probe;
+  // published at 1000, received 100 later, written 200 after that
+  probe.command_received(1000, 1100);
+  probe.command_written(1300);
+  // published at 2000, received 300 later, written 400 after that
+  probe.command_received(2000, 2300);
+  probe.command_written(2700);
+
+  const auto statistics = probe.get_statistics();
+  const auto & publish_to_receive = statistics[LatencyProbe::PUBLISH_TO_RECEIVE];
+  EXPECT_EQ(publish_to_receive.count, 2u);
+  EXPECT_DOUBLE_EQ(publish_to_receive.mean_ns, 200.0);
+  EXPECT_DOUBLE_EQ(publish_to_receive.min_ns, 100.0);
+  EXPECT_DOUBLE_EQ(publish_to_receive.max_ns, 300.0);
+  EXPECT_NEAR(publish_to_receive.stddev_ns, 100.0, 1e-9);
+
+  const auto & receive_to_write = statistics[LatencyProbe::RECEIVE_TO_WRITE];
+  EXPECT_EQ(receive_to_write.count, 2u);
+  EXPECT_DOUBLE_EQ(receive_to_write.mean_ns, 300.0);
+
+  const auto & publish_to_write = statistics[LatencyProbe::PUBLISH_TO_WRITE];
+  EXPECT_EQ(publish_to_write.count, 2u);
+  EXPECT_DOUBLE_EQ(publish_to_write.min_ns, 300.0);
+  EXPECT_DOUBLE_EQ(publish_to_write.max_ns, 700.0);
+
+  // nothing was written since
+  for (const auto & empty : probe.get_statistics())
+  {
+    EXPECT_EQ(empty.count, 0u);
+    EXPECT_EQ(empty.max_ns, 0.0);
+  }
+}
+
+TEST(TestLatencyProbe, only_first_write_of_each_command)
+{
+  LatencyProbe probe;
+  // nothing received yet
+  probe.command_written(100);
+  EXPECT_EQ(probe.get_statistics()[LatencyProbe::RECEIVE_TO_WRITE].count, 0u);
+
+  probe.command_received(0, 1000);
+  probe.command_written(1500);
+  probe.command_written(2500);
+  // replaced before it was written
+  probe.command_received(0, 3000);
+  probe.command_received(0, 3200);
+  probe.command_written(3500);
+
+  const auto statistics = probe.get_statistics();
+  const auto & receive_to_write = statistics[LatencyProbe::RECEIVE_TO_WRITE];
+  EXPECT_EQ(receive_to_write.count, 2u);
+  EXPECT_DOUBLE_EQ(receive_to_write.min_ns, 300.0);
+  EXPECT_DOUBLE_EQ(receive_to_write.max_ns, 500.0);
+  // the commands had no stamp
+  EXPECT_EQ(statistics[LatencyProbe::PUBLISH_TO_RECEIVE].count, 0u);
+  EXPECT_EQ(statistics[LatencyProbe::PUBLISH_TO_WRITE].count, 0u);
+}
+
+TEST(TestLatencyProbe, drops_samples_when_full)
+{
+  LatencyProbe probe(2);
+  for (std::int64_t i = 1; i <= 5; ++i)
+  {
+    probe.command_received(0, i * 100);
+    probe.command_written(i * 100 + 10);
+  }
+  EXPECT_EQ(probe.dropped(), 3u);
+  EXPECT_EQ(probe.get_statistics()[LatencyProbe::RECEIVE_TO_WRITE].count, 2u);
+
+  // there is room again
+  probe.command_received(0, 1000);
+  probe.command_written(1010);
+  EXPECT_EQ(probe.get_statistics()[LatencyProbe::RECEIVE_TO_WRITE].count, 1u);
+  EXPECT_EQ(probe.dropped(), 3u);
+}
+
+TEST(TestLatencyProbe, concurrent_sides)
+{
+  LatencyProbe probe(64);
+  constexpr std::int64_t NUM_COMMANDS = 100000;
+  std::atomic<bool> received_all{false};
+  std::atomic<bool> done{false};
+  std::thread receiver(
+    [&]()
+    {
+      for (std::int64_t i = 1; i <= NUM_COMMANDS; ++i)
+      {
+        probe.command_received(i, i + 10);
+      }
+      received_all.store(true);
+    });
+  std::thread writer(
+    [&]()
+    {
+      while (!done.load())
+      {
+        probe.command_written(std::numeric_limits<std::int32_t>::max());
+      }
+    });
+
+  uint64_t count = 0;
+  bool consistent = true;
+  auto read = [&]()
+  {
+    const auto statistics = probe.get_statistics()[LatencyProbe::PUBLISH_TO_RECEIVE];
+    count += statistics.count;
+    // all commands are received 10 after their stamp, a torn sample would show
+    consistent = consistent && (statistics.count == 0 ||
+                                (statistics.min_ns == 10.0 && statistics.max_ns == 10.0));
+  };
+  while (!received_all.load())
+  {
+    read();
+  }
+  receiver.join();
+  done.store(true);
+  writer.join();
+  read();
+  EXPECT_TRUE(consistent);
+  EXPECT_GT(count, 0u);
+  EXPECT_LE(count + probe.dropped(), static_cast<uint64_t>(NUM_COMMANDS));
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "controller_realtime_tools/limiter.hpp"
+
+using controller_realtime_tools::Limiter;
+
+TEST(TestLimiter, commands_are_kept_without_limits)
+{
+  const Limiter<3> limiter;
+  Limiter<3>::Values v{0.1, -2.0, 3e6};
+  limiter.limit(v, {1.0, 2.0, 3.0}, {-1.0, -2.0, -3.0}, 0.01);
+  EXPECT_THAT(v, testing::ElementsAre(0.1, -2.0, 3e6));
+}
+
+TEST(TestLimiter, limits_each_channel_by_its_own_limits)
+{
+  Limiter<3> limiter;
+  limiter.set_value_limits(0, -1.0, 1.0);
+  limiter.set_rate_limits(1, -10.0, 10.0);
+  limiter.set_second_rate_limits(2, -50.0, 50.0);
+
+  Limiter<3>::Values v{2.0, 2.0, 2.0};
+  limiter.limit(v, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, 0.1);
+  EXPECT_DOUBLE_EQ(v[0], 1.0);
+  // v0 + max rate * dt
+  EXPECT_DOUBLE_EQ(v[1], 1.0);
+  // v0 + (v0 - v1) + max second rate * 2 * dt^2
+  EXPECT_DOUBLE_EQ(v[2], 1.0);
+
+  // within the limits
+  v = {0.5, 0.5, 0.5};
+  limiter.limit(v, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, 0.1);
+  EXPECT_THAT(v, testing::ElementsAre(0.5, 0.5, 0.5));
+}
+
+TEST(TestLimiter, decreasing_rate_limits_apply_while_the_magnitude_decreases)
+{
+  Limiter<2> limiter;
+  for (std::size_t channel = 0; channel < 2; ++channel)
+  {
+    limiter.set_rate_limits(channel, -1.0, 1.0);
+    limiter.set_decreasing_rate_limits(channel, -5.0, 5.0);
+  }
+
+  Limiter<2>::Values v{3.0, -3.0};
+  limiter.limit_rate(v, {2.0, -2.0}, 0.1);
+  EXPECT_DOUBLE_EQ(v[0], 2.1);
+  EXPECT_DOUBLE_EQ(v[1], -2.1);
+
+  v = {0.0, 0.0};
+  limiter.limit_rate(v, {2.0, -2.0}, 0.1);
+  EXPECT_DOUBLE_EQ(v[0], 1.5);
+  EXPECT_DOUBLE_EQ(v[1], -1.5);
+}
+
+TEST(TestLimiter, min_magnitude_keeps_the_sign)
+{
+  Limiter<2> limiter;
+  limiter.set_value_limits(0, -2.0, 2.0, 0.5);
+  limiter.set_value_limits(1, -2.0, 2.0, 0.5);
+
+  Limiter<2>::Values v{0.1, -0.1};
+  limiter.limit_value(v);
+  EXPECT_THAT(v, testing::ElementsAre(0.5, -0.5));
+
+  v = {-3.0, 1.0};
+  limiter.limit_value(v);
+  EXPECT_THAT(v, testing::ElementsAre(-2.0, 1.0));
+}
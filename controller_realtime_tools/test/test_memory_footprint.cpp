@@ -0,0 +1,86 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "controller_realtime_tools/memory_footprint.hpp"
+
+using controller_realtime_tools::AllocationCounter;
+using controller_realtime_tools::heap_bytes;
+using controller_realtime_tools::ScopedAllocationCounting;
+
+TEST(TestMemoryFootprint, heap_bytes_of_nested_containers)
+{
+  std::vector<double> values;
+  values.reserve(100);
+  EXPECT_EQ(heap_bytes(values), 100 * sizeof(double));
+
+  std::vector<std::string> names = {"short", std::string(100, 'x')};
+  EXPECT_EQ(heap_bytes(names), names.capacity() * sizeof(std::string) + names[1].capacity());
+
+  std::unordered_map<std::string, std::vector<double>> map;
+  map["joint"] = std::vector<double>(3);
+  EXPECT_GE(heap_bytes(map), map.bucket_count() * sizeof(void *) + 3 * sizeof(double));
+
+  EXPECT_EQ(heap_bytes(42), 0u);
+}
+
+// the test is linked with libcontroller_allocation_counting.so, which interposes malloc()
+TEST(TestMemoryFootprint, allocations_are_counted_into_the_scoped_counter)
+{
+  AllocationCounter counter;
+  AllocationCounter other;
+  counter.reset();
+  other.reset();
+  ASSERT_TRUE(counter.available());
+
+  std::unique_ptr<std::vector<double>> values;
+  {
+    ScopedAllocationCounting counting(counter);
+    values = std::make_unique<std::vector<double>>(16);
+    {
+      ScopedAllocationCounting nested(other);
+      values->reserve(32);
+    }
+  }
+  // outside of the scopes
+  values->reserve(64);
+
+  EXPECT_EQ(counter.allocations(), 2u);
+  EXPECT_EQ(counter.bytes(), sizeof(std::vector<double>) + 16 * sizeof(double));
+  EXPECT_EQ(other.allocations(), 1u);
+  EXPECT_EQ(other.bytes(), 32 * sizeof(double));
+
+  counter.reset();
+  EXPECT_EQ(counter.allocations(), 0u);
+  EXPECT_EQ(counter.bytes(), 0u);
+}
+
+TEST(TestMemoryFootprint, report_has_every_buffer_and_the_total)
+{
+  AllocationCounter counter;
+  counter.reset();
+  counter.count(24);
+  const std::string report =
+    controller_realtime_tools::format_memory_report({{"state", 100}, {"commands", 28}}, counter);
+  EXPECT_THAT(report, testing::HasSubstr("state: 100 bytes\n"));
+  EXPECT_THAT(report, testing::HasSubstr("commands: 28 bytes\n"));
+  EXPECT_THAT(report, testing::HasSubstr("total: 128 bytes\n"));
+  EXPECT_THAT(report, testing::HasSubstr("allocations after activation: 1 (24 bytes)"));
+}
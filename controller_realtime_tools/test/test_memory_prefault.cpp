@@ -0,0 +1,98 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include "controller_realtime_tools/memory_prefault.hpp"
+
+using controller_realtime_tools::MemoryPrefaulter;
+
+TEST(TestMemoryPrefault, capacities_and_nested_buffers_are_added)
+{
+  std::vector<double> values = {1.0, 2.0};
+  values.reserve(100);
+  std::vector<std::vector<int>> nested = {{1, 2, 3}, {}};
+  std::vector<std::string> names = {"short", std::string(100, 'x')};
+  std::vector<bool> flags(10);
+
+  MemoryPrefaulter prefaulter;
+  prefaulter.add(values);
+  prefaulter.add(nested);
+  prefaulter.add(names);
+  prefaulter.add(flags);
+  EXPECT_EQ(
+    prefaulter.size(), 100 * sizeof(double) + 2 * sizeof(std::vector<int>) + 3 * sizeof(int) +
+                         2 * sizeof(std::string) + names[1].capacity());
+
+  prefaulter.clear();
+  EXPECT_EQ(prefaulter.size(), 0u);
+  EXPECT_EQ(prefaulter.prefault(), 0u);
+}
+
+TEST(TestMemoryPrefault, every_page_is_touched_without_changing_the_values)
+{
+  const size_t page_size = controller_realtime_tools::memory_page_size();
+  std::vector<unsigned char> buffer(4 * page_size);
+  for (size_t i = 0; i < buffer.size(); ++i)
+  {
+    buffer[i] = static_cast<unsigned char>(i);
+  }
+  const auto expected = buffer;
+
+  MemoryPrefaulter prefaulter;
+  // starts one byte into a page, so it spans 4 or 5 pages
+  prefaulter.add(&buffer[1], buffer.size() - 1);
+  int object = 42;
+  prefaulter.add_object(object);
+  const size_t pages = prefaulter.prefault();
+  EXPECT_GE(pages, 5u);
+  EXPECT_LE(pages, 6u);
+  EXPECT_EQ(buffer, expected);
+  EXPECT_EQ(object, 42);
+  // may not be permitted, but must not change anything either
+  prefaulter.lock();
+  EXPECT_EQ(buffer, expected);
+}
+
+TEST(TestMemoryPrefault, footprint_is_summed_per_label)
+{
+  std::vector<double> values(10);
+  std::vector<int> indices(4);
+  std::vector<double> unlabeled(2);
+  std::vector<double> empty;
+
+  MemoryPrefaulter prefaulter;
+  prefaulter.add(unlabeled);
+  prefaulter.set_label("values");
+  prefaulter.add(values);
+  prefaulter.set_label("indices");
+  prefaulter.add(indices);
+  prefaulter.set_label("empty");
+  prefaulter.add(empty);
+  prefaulter.set_label("values");
+  prefaulter.add(values);
+
+  EXPECT_THAT(
+    prefaulter.footprint(),
+    testing::ElementsAre(
+      std::make_pair(std::string("other"), 2 * sizeof(double)),
+      std::make_pair(std::string("values"), 20 * sizeof(double)),
+      std::make_pair(std::string("indices"), 4 * sizeof(int))));
+
+  prefaulter.clear();
+  EXPECT_TRUE(prefaulter.footprint().empty());
+}
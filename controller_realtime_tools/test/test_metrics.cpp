@@ -0,0 +1,72 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "controller_realtime_tools/latency_probe.hpp"
+#include "controller_realtime_tools/metrics.hpp"
+
+namespace
+{
+// same constants and fields as the statistics_msgs messages
+struct StatisticDataType
+{
+  static constexpr uint8_t STATISTICS_DATA_TYPE_AVERAGE = 1;
+  static constexpr uint8_t STATISTICS_DATA_TYPE_MINIMUM = 2;
+  static constexpr uint8_t STATISTICS_DATA_TYPE_MAXIMUM = 3;
+  static constexpr uint8_t STATISTICS_DATA_TYPE_STDDEV = 4;
+  static constexpr uint8_t STATISTICS_DATA_TYPE_SAMPLE_COUNT = 5;
+};
+
+struct StatisticDataPoint
+{
+  uint8_t data_type = 0;
+  double data = 0.0;
+};
+
+struct MetricsMessage
+{
+  std::string unit;
+  std::vector<StatisticDataPoint> statistics;
+};
+}  // namespace
+
+TEST(TestMetrics, fill_metrics)
+{
+  controller_realtime_tools::LatencyProbe::Statistics statistics;
+  statistics.count = 3;
+  statistics.mean_ns = 20.0;
+  statistics.min_ns = 10.0;
+  statistics.max_ns = 30.0;
+  statistics.stddev_ns = 5.0;
+
+  MetricsMessage msg;
+  controller_realtime_tools::fill_metrics<StatisticDataType>(statistics, msg);
+  EXPECT_EQ(msg.unit, "ns");
+  ASSERT_EQ(msg.statistics.size(), 5u);
+  EXPECT_EQ(msg.statistics[0].data_type, StatisticDataType::STATISTICS_DATA_TYPE_SAMPLE_COUNT);
+  EXPECT_DOUBLE_EQ(msg.statistics[0].data, 3.0);
+  EXPECT_EQ(msg.statistics[1].data_type, StatisticDataType::STATISTICS_DATA_TYPE_AVERAGE);
+  EXPECT_DOUBLE_EQ(msg.statistics[1].data, 20.0);
+  EXPECT_EQ(msg.statistics[2].data_type, StatisticDataType::STATISTICS_DATA_TYPE_MINIMUM);
+  EXPECT_DOUBLE_EQ(msg.statistics[2].data, 10.0);
+  EXPECT_EQ(msg.statistics[3].data_type, StatisticDataType::STATISTICS_DATA_TYPE_MAXIMUM);
+  EXPECT_DOUBLE_EQ(msg.statistics[3].data, 30.0);
+  EXPECT_EQ(msg.statistics[4].data_type, StatisticDataType::STATISTICS_DATA_TYPE_STDDEV);
+  EXPECT_DOUBLE_EQ(msg.statistics[4].data, 5.0);
+}
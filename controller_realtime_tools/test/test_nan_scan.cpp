@@ -0,0 +1,45 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <limits>
+#include <vector>
+
+#include "controller_realtime_tools/nan_scan.hpp"
+
+using controller_realtime_tools::any_nan;
+
+TEST(TestNanScan, nan_is_found_at_every_position)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  EXPECT_FALSE(any_nan(std::vector<double>{}));
+  // covers the vectorized pairs and the odd value left
+  for (std::size_t size = 1; size <= 7; ++size)
+  {
+    std::vector<double> values(size, 1.0);
+    values[0] = inf;
+    values[size - 1] = -inf;
+    EXPECT_FALSE(any_nan(values));
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      const double value = values[i];
+      values[i] = nan;
+      EXPECT_TRUE(any_nan(values)) << "size " << size << ", NaN at " << i;
+      EXPECT_FALSE(any_nan(values.data(), i)) << "size " << size << ", NaN at " << i;
+      values[i] = value;
+    }
+  }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <array>
+#include <limits>
+
+#include "controller_realtime_tools/new_sample_detector.hpp"
+
+using controller_realtime_tools::NewSampleDetector;
+
+TEST(TestNewSampleDetector, sequence_number_changes_are_new_samples)
+{
+  NewSampleDetector detector;
+  detector.reset(1);
+  // the first sample is always new
+  EXPECT_TRUE(detector.is_new(0.0));
+  EXPECT_FALSE(detector.is_new(0.0));
+  EXPECT_TRUE(detector.is_new(1.0));
+  EXPECT_FALSE(detector.is_new(1.0));
+  // a wrap around or a restart of the sensor is new as well
+  EXPECT_TRUE(detector.is_new(0.0));
+
+  detector.reset();
+  EXPECT_TRUE(detector.is_new(0.0));
+}
+
+TEST(TestNewSampleDetector, values_are_compared_bitwise)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  NewSampleDetector detector;
+  detector.reset(3);
+  std::array<double, 3> values = {1.0, 2.0, 3.0};
+  EXPECT_TRUE(detector.is_new(values.data()));
+  EXPECT_FALSE(detector.is_new(values.data()));
+
+  values[2] = 3.0000000001;
+  EXPECT_TRUE(detector.is_new(values.data()));
+
+  // an unchanged NaN is no new sample, unlike with operator==
+  values[0] = nan;
+  EXPECT_TRUE(detector.is_new(values.data()));
+  EXPECT_FALSE(detector.is_new(values.data()));
+  values[0] = 1.0;
+  EXPECT_TRUE(detector.is_new(values.data()));
+}
@@ -0,0 +1,211 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "controller_realtime_tools/odometry_publisher.hpp"
+
+using controller_realtime_tools::OdometrySnapshot;
+
+namespace
+{
+// the fields of the messages used by OdometryPublisher
+struct Stamp
+{
+  std::int32_t sec = 0;
+  std::uint32_t nanosec = 0;
+};
+struct Header
+{
+  Stamp stamp;
+  std::string frame_id;
+};
+struct Vector
+{
+  double x = 0.0;
+  double y = 0.0;
+  double z = 0.0;
+};
+struct Quaternion
+{
+  double x = 0.0;
+  double y = 0.0;
+  double z = 0.0;
+  double w = 1.0;
+};
+struct OdometryMessage
+{
+  Header header;
+  struct
+  {
+    struct
+    {
+      Vector position;
+      Quaternion orientation;
+    } pose;
+    std::array<double, 36> covariance{};
+  } pose;
+  struct
+  {
+    struct
+    {
+      Vector linear;
+      Vector angular;
+    } twist;
+  } twist;
+};
+struct TransformMessage
+{
+  struct Transform
+  {
+    Header header;
+    struct
+    {
+      Vector translation;
+      Quaternion rotation;
+    } transform;
+  };
+  std::vector<Transform> transforms;
+};
+
+/// Records the published messages
+template <typename MessageT>
+class FakePublisher
+{
+public:
+  void publish(const MessageT & msg)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    published_.push_back(msg);
+  }
+
+  bool wait_for_messages(size_t count)
+  {
+    const auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < end_time)
+    {
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (published_.size() >= count)
+        {
+          return true;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+
+  std::mutex mutex_;
+  std::vector<MessageT> published_;
+};
+
+using OdometryPublisher = controller_realtime_tools::OdometryPublisher<
+  OdometryMessage, FakePublisher<OdometryMessage>, TransformMessage,
+  FakePublisher<TransformMessage>>;
+}  // namespace
+
+TEST(TestOdometryPublisher, publish_latest_snapshot)
+{
+  auto odometry_publisher = std::make_shared<FakePublisher<OdometryMessage>>();
+  auto transform_publisher = std::make_shared<FakePublisher<TransformMessage>>();
+  OdometryMessage odometry_prototype;
+  odometry_prototype.header.frame_id = "odom";
+  odometry_prototype.pose.covariance[35] = 0.5;
+  TransformMessage transform_prototype;
+  transform_prototype.transforms.resize(1);
+  transform_prototype.transforms.front().header.frame_id = "odom";
+
+  {
+    OdometryPublisher publisher(
+      odometry_publisher, odometry_prototype, transform_publisher, transform_prototype,
+      std::chrono::milliseconds(1));
+
+    // nothing to publish yet
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    {
+      std::lock_guard<std::mutex> guard(odometry_publisher->mutex_);
+      EXPECT_TRUE(odometry_publisher->published_.empty());
+    }
+
+    OdometrySnapshot snapshot;
+    snapshot.stamp_nanoseconds = 12500000000;
+    snapshot.x = 1.0;
+    snapshot.y = 2.0;
+    snapshot.heading = M_PI / 2.0;
+    snapshot.linear = 0.5;
+    snapshot.angular = 0.25;
+    publisher.update(snapshot);
+    ASSERT_TRUE(odometry_publisher->wait_for_messages(1));
+    ASSERT_TRUE(transform_publisher->wait_for_messages(1));
+
+    // published once per snapshot
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  ASSERT_EQ(1u, odometry_publisher->published_.size());
+  const auto & odometry = odometry_publisher->published_.front();
+  EXPECT_EQ("odom", odometry.header.frame_id);
+  EXPECT_EQ(12, odometry.header.stamp.sec);
+  EXPECT_EQ(500000000u, odometry.header.stamp.nanosec);
+  EXPECT_EQ(1.0, odometry.pose.pose.position.x);
+  EXPECT_EQ(2.0, odometry.pose.pose.position.y);
+  EXPECT_NEAR(std::sqrt(0.5), odometry.pose.pose.orientation.z, 1e-12);
+  EXPECT_NEAR(std::sqrt(0.5), odometry.pose.pose.orientation.w, 1e-12);
+  EXPECT_EQ(0.5, odometry.twist.twist.linear.x);
+  EXPECT_EQ(0.25, odometry.twist.twist.angular.z);
+  // the constant covariance of the prototype is kept
+  EXPECT_EQ(0.5, odometry.pose.covariance[35]);
+
+  ASSERT_EQ(1u, transform_publisher->published_.size());
+  const auto & transform = transform_publisher->published_.front().transforms.front();
+  EXPECT_EQ(12, transform.header.stamp.sec);
+  EXPECT_EQ(1.0, transform.transform.translation.x);
+  EXPECT_NEAR(std::sqrt(0.5), transform.transform.rotation.z, 1e-12);
+}
+
+TEST(TestOdometryPublisher, publish_pose_covariance)
+{
+  auto odometry_publisher = std::make_shared<FakePublisher<OdometryMessage>>();
+  OdometryPublisher publisher(
+    odometry_publisher, OdometryMessage(), nullptr, TransformMessage(),
+    std::chrono::milliseconds(1));
+
+  OdometrySnapshot snapshot;
+  snapshot.pose_covariance = {1.0, 2.0, 3.0, 2.0, 4.0, 5.0, 3.0, 5.0, 6.0};
+  snapshot.has_pose_covariance = true;
+  publisher.update(snapshot);
+  ASSERT_TRUE(odometry_publisher->wait_for_messages(1));
+
+  std::lock_guard<std::mutex> guard(odometry_publisher->mutex_);
+  const auto & covariance = odometry_publisher->published_.front().pose.covariance;
+  EXPECT_EQ(1.0, covariance[0]);
+  EXPECT_EQ(2.0, covariance[1]);
+  EXPECT_EQ(3.0, covariance[5]);
+  EXPECT_EQ(4.0, covariance[7]);
+  EXPECT_EQ(5.0, covariance[11]);
+  EXPECT_EQ(3.0, covariance[30]);
+  EXPECT_EQ(6.0, covariance[35]);
+  EXPECT_EQ(0.0, covariance[14]);
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "controller_realtime_tools/parameter_snapshot.hpp"
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+
+using controller_realtime_tools::ParameterSnapshot;
+using controller_realtime_tools::ScopedRealtimeSafetyCounter;
+
+namespace
+{
+std::unique_ptr<const std::vector<int>> make_snapshot(int value)
+{
+  return std::make_unique<const std::vector<int>>(64, value);
+}
+}  // namespace
+
+TEST(TestParameterSnapshot, update_takes_latest_snapshot)
+{
+  ParameterSnapshot<std::vector<int>> snapshot(make_snapshot(0));
+  // the initial snapshot until another one is published
+  EXPECT_FALSE(snapshot.update());
+  EXPECT_THAT(snapshot.get(), ::testing::Each(0));
+
+  snapshot.publish(make_snapshot(1));
+  EXPECT_TRUE(snapshot.update());
+  EXPECT_THAT(snapshot.get(), ::testing::Each(1));
+  EXPECT_FALSE(snapshot.update());
+  EXPECT_THAT(snapshot.get(), ::testing::Each(1));
+
+  // only the latest of several snapshots is taken
+  for (int i = 2; i < 5; ++i)
+  {
+    snapshot.publish(make_snapshot(i));
+  }
+  EXPECT_TRUE(snapshot.update());
+  EXPECT_THAT(snapshot.get(), ::testing::Each(4));
+}
+
+TEST(TestParameterSnapshot, writer_deletes_snapshots)
+{
+  std::weak_ptr<int> initial_alive, first_alive, replaced_alive, second_alive;
+  {
+    // snapshots holding a shared pointer, to see when they are deleted
+    auto make_tracked_snapshot = [](std::weak_ptr<int> & alive)
+    {
+      auto tracked = std::make_unique<const std::shared_ptr<int>>(std::make_shared<int>(0));
+      alive = *tracked;
+      return tracked;
+    };
+    ParameterSnapshot<std::shared_ptr<int>> snapshot(make_tracked_snapshot(initial_alive));
+    snapshot.publish(make_tracked_snapshot(first_alive));
+    ASSERT_TRUE(snapshot.update());
+    // handed back by the reader, but deleted by the writer only
+    EXPECT_FALSE(initial_alive.expired());
+    snapshot.reclaim();
+    EXPECT_TRUE(initial_alive.expired());
+
+    // a snapshot replaced before the reader took it is deleted right away
+    snapshot.publish(make_tracked_snapshot(replaced_alive));
+    snapshot.publish(make_tracked_snapshot(second_alive));
+    EXPECT_TRUE(replaced_alive.expired());
+    EXPECT_FALSE(first_alive.expired());
+  }
+  // all remaining snapshots are deleted with the buffer
+  EXPECT_TRUE(first_alive.expired());
+  EXPECT_TRUE(second_alive.expired());
+}
+
+TEST(TestParameterSnapshot, update_is_realtime_safe)
+{
+  ParameterSnapshot<std::vector<int>> snapshot(make_snapshot(0));
+  for (int i = 1; i < 10; ++i)
+  {
+    snapshot.publish(make_snapshot(i));
+
+    ScopedRealtimeSafetyCounter counter;
+    ASSERT_TRUE(snapshot.update());
+    EXPECT_EQ(snapshot.get()[0], i);
+    // the previous snapshot is freed by the next publish()
+    EXPECT_EQ(counter.get_allocations(), 0u);
+    EXPECT_EQ(counter.get_deallocations(), 0u);
+    EXPECT_EQ(counter.get_locks(), 0u);
+  }
+}
+
+TEST(TestParameterSnapshot, concurrent_snapshots_are_consistent)
+{
+  // every snapshot has the same number in all elements, a reclaimed one in use would break this
+  ParameterSnapshot<std::vector<int>> snapshot(make_snapshot(0));
+  std::atomic<bool> done{false};
+  std::thread writer(
+    [&]()
+    {
+      for (int i = 1; i <= 20000; ++i)
+      {
+        snapshot.publish(make_snapshot(i));
+      }
+      done.store(true);
+    });
+
+  int last_value = 0;
+  while (!done.load())
+  {
+    snapshot.update();
+    const auto & value = snapshot.get();
+    ASSERT_THAT(value, ::testing::Each(value[0]));
+    // snapshots never go backwards
+    ASSERT_GE(value[0], last_value);
+    last_value = value[0];
+  }
+  writer.join();
+  snapshot.reclaim();
+  snapshot.update();
+  EXPECT_THAT(snapshot.get(), ::testing::Each(20000));
+}
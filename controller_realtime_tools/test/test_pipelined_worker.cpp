@@ -0,0 +1,91 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "controller_realtime_tools/pipelined_worker.hpp"
+
+using controller_realtime_tools::PipelinedWorker;
+
+namespace
+{
+/// Wait for the result of a request after \p min_sequence
+template <typename WorkerT>
+auto wait_for_result(WorkerT & worker, std::uint64_t min_sequence, std::uint64_t * sequence)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  auto * result = worker.result(min_sequence, sequence);
+  while (!result && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    result = worker.result(min_sequence, sequence);
+  }
+  return result;
+}
+}  // namespace
+
+TEST(TestPipelinedWorker, results_follow_the_submitted_requests)
+{
+  PipelinedWorker<std::vector<double>, std::vector<double>> worker(
+    [](const std::vector<double> & request, std::vector<double> & result)
+    {
+      for (size_t i = 0; i < request.size(); ++i)
+      {
+        result[i] = 2.0 * request[i];
+      }
+    },
+    std::vector<double>(3, 0.0), std::vector<double>(3, 0.0), std::chrono::microseconds(10));
+  EXPECT_EQ(worker.result(), nullptr);
+  EXPECT_EQ(worker.submitted(), 0u);
+
+  std::uint64_t done = 0;
+  for (int cycle = 1; cycle <= 3; ++cycle)
+  {
+    auto & request = worker.request();
+    for (auto & value : request)
+    {
+      value = static_cast<double>(cycle);
+    }
+    const std::uint64_t sequence = worker.submit();
+    EXPECT_EQ(sequence, static_cast<std::uint64_t>(cycle));
+    EXPECT_EQ(worker.submitted(), sequence);
+
+    std::uint64_t result_sequence = 0;
+    const auto * result = wait_for_result(worker, done, &result_sequence);
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(result_sequence, sequence);
+    EXPECT_THAT(*result, testing::Each(2.0 * cycle));
+    done = result_sequence;
+  }
+  // the results of the requests up to done are not returned as new ones
+  EXPECT_EQ(worker.result(done), nullptr);
+}
+
+TEST(TestPipelinedWorker, busy_polling_worker_runs_the_job)
+{
+  PipelinedWorker<int, int> worker(
+    [](const int & request, int & result) { result = request + 1; }, 0, 0,
+    std::chrono::nanoseconds::zero());
+  worker.request() = 41;
+  worker.submit();
+  std::uint64_t sequence = 0;
+  const int * result = wait_for_result(worker, 0, &sequence);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(*result, 42);
+}
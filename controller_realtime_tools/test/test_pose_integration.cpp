@@ -0,0 +1,106 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <tuple>
+#include <vector>
+
+#include "controller_realtime_tools/pose_integration.hpp"
+
+using controller_realtime_tools::integrate_pose;
+using controller_realtime_tools::integrate_poses;
+
+TEST(TestPoseIntegration, straight_step)
+{
+  double x = 1.0, y = 2.0, heading = M_PI_2;
+  integrate_pose(0.5, 0.0, x, y, heading);
+  EXPECT_NEAR(x, 1.0, 1e-12);
+  EXPECT_NEAR(y, 2.5, 1e-12);
+  EXPECT_DOUBLE_EQ(heading, M_PI_2);
+}
+
+TEST(TestPoseIntegration, steps_follow_the_arc)
+{
+  // a quarter circle of radius 2 in 100 steps, and in a single one
+  double x = 0.0, y = 0.0, heading = 0.0;
+  for (int i = 0; i < 100; ++i)
+  {
+    integrate_pose(M_PI / 100.0, M_PI_2 / 100.0, x, y, heading);
+  }
+  double single_x = 0.0, single_y = 0.0, single_heading = 0.0;
+  integrate_pose(M_PI, M_PI_2, single_x, single_y, single_heading);
+  for (const auto & [px, py, ph] : {std::make_tuple(x, y, heading),
+                                     std::make_tuple(single_x, single_y, single_heading)})
+  {
+    EXPECT_NEAR(px, 2.0, 1e-9);
+    EXPECT_NEAR(py, 2.0, 1e-9);
+    EXPECT_NEAR(ph, M_PI_2, 1e-12);
+  }
+
+  // below the threshold the step is straight, and continuous with the arc
+  double straight_x = 0.0, straight_y = 0.0, straight_heading = 0.0;
+  integrate_pose(1.0, 0.9e-6, straight_x, straight_y, straight_heading);
+  double arc_x = 0.0, arc_y = 0.0, arc_heading = 0.0;
+  integrate_pose(1.0, 1.1e-6, arc_x, arc_y, arc_heading);
+  EXPECT_NEAR(straight_x, arc_x, 1e-9);
+  EXPECT_NEAR(straight_y, arc_y, 1e-6);
+}
+
+TEST(TestPoseIntegration, integrates_range_of_robots)
+{
+  const std::vector<double> linear = {1.0, 0.5, 2.0, -1.0};
+  const std::vector<double> angular = {0.0, 1.0, -0.5, 0.2};
+  std::vector<double> x(4, 0.0), y(4, 0.0), heading(4, 0.0);
+  // in two ranges, e.g. from two threads
+  integrate_poses(linear.data(), angular.data(), 0.1, x.data(), y.data(), heading.data(), 0, 1);
+  integrate_poses(linear.data(), angular.data(), 0.1, x.data(), y.data(), heading.data(), 1, 3);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    double expected_x = 0.0, expected_y = 0.0, expected_heading = 0.0;
+    integrate_pose(linear[i] * 0.1, angular[i] * 0.1, expected_x, expected_y, expected_heading);
+    EXPECT_EQ(x[i], expected_x);
+    EXPECT_EQ(y[i], expected_y);
+    EXPECT_EQ(heading[i], expected_heading);
+  }
+  // the robots outside of the ranges don't move
+  EXPECT_EQ(x[3], 0.0);
+  EXPECT_EQ(heading[3], 0.0);
+}
+
+TEST(TestPoseIntegration, integrator_matches_integrate_pose)
+{
+  controller_realtime_tools::PoseIntegrator integrator;
+  integrator.reset(1.0, -2.0, 3.0);
+  double x = 1.0, y = -2.0, heading = 3.0;
+  // small, straight and large steps, over several resynchronizations of the sine and cosine
+  for (int i = 0; i < 2000; ++i)
+  {
+    const double linear = 0.01 * std::sin(0.01 * i);
+    const double angular = i % 7 == 0 ? 0.0 : (i % 11 == 0 ? 0.3 : 0.002 * std::cos(0.02 * i));
+    integrator.integrate(linear, angular);
+    integrate_pose(linear, angular, x, y, heading);
+  }
+  EXPECT_NEAR(integrator.x(), x, 1e-9);
+  EXPECT_NEAR(integrator.y(), y, 1e-9);
+  EXPECT_NEAR(integrator.heading(), heading, 1e-12);
+  EXPECT_NEAR(integrator.sin_heading(), std::sin(heading), 1e-12);
+  EXPECT_NEAR(integrator.cos_heading(), std::cos(heading), 1e-12);
+
+  const double integrated_x = integrator.x();
+  integrator.set_heading(-1.0);
+  EXPECT_EQ(integrator.x(), integrated_x);
+  EXPECT_DOUBLE_EQ(integrator.sin_heading(), std::sin(-1.0));
+}
@@ -0,0 +1,251 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "controller_realtime_tools/realtime_goal_slot.hpp"
+
+using controller_realtime_tools::RealtimeGoalSlot;
+
+TEST(TestRealtimeGoalSlot, set_and_reset)
+{
+  RealtimeGoalSlot<int> slot;
+  EXPECT_FALSE(slot.get());
+  EXPECT_FALSE(slot.get_from_rt());
+  EXPECT_FALSE(slot.reset_from_rt());
+
+  auto goal = std::make_shared<int>(1);
+  slot.set(goal);
+  EXPECT_EQ(slot.get(), goal);
+  EXPECT_EQ(slot.get_from_rt(), goal);
+
+  auto other_goal = std::make_shared<int>(2);
+  slot.set(other_goal);
+  EXPECT_EQ(slot.get(), other_goal);
+  EXPECT_EQ(slot.get_from_rt(), other_goal);
+  // the slot doesn't keep a reference to a replaced goal
+  EXPECT_EQ(goal.use_count(), 1);
+
+  slot.reset();
+  EXPECT_FALSE(slot.get());
+  EXPECT_FALSE(slot.get_from_rt());
+  EXPECT_EQ(other_goal.use_count(), 1);
+
+  slot.set(goal);
+  slot.set(nullptr);
+  EXPECT_FALSE(slot.get());
+}
+
+TEST(TestRealtimeGoalSlot, reset_from_rt)
+{
+  RealtimeGoalSlot<int> slot;
+  auto goal = std::make_shared<int>(1);
+  slot.set(goal);
+
+  ASSERT_EQ(slot.get_from_rt(), goal);
+  EXPECT_TRUE(slot.reset_from_rt());
+  EXPECT_FALSE(slot.get());
+  EXPECT_FALSE(slot.get_from_rt());
+  EXPECT_FALSE(slot.reset_from_rt());
+
+  // setting the same goal again is a new update
+  slot.set(goal);
+  EXPECT_EQ(slot.get(), goal);
+  EXPECT_EQ(slot.get_from_rt(), goal);
+}
+
+TEST(TestRealtimeGoalSlot, reset_from_rt_keeps_newer_goal)
+{
+  RealtimeGoalSlot<int> slot;
+  auto goal = std::make_shared<int>(1);
+  auto other_goal = std::make_shared<int>(2);
+  slot.set(goal);
+  ASSERT_EQ(slot.get_from_rt(), goal);
+
+  // the non-realtime side replaces the goal while the realtime side finishes the old one
+  slot.set(other_goal);
+  EXPECT_FALSE(slot.reset_from_rt());
+  EXPECT_EQ(slot.get(), other_goal);
+  EXPECT_EQ(slot.get_from_rt(), other_goal);
+
+  // also if the cell of the old goal was reused in between
+  slot.set(goal);
+  slot.set(other_goal);
+  slot.set(goal);
+  EXPECT_FALSE(slot.reset_from_rt());
+  EXPECT_EQ(slot.get_from_rt(), goal);
+  EXPECT_TRUE(slot.reset_from_rt());
+  EXPECT_FALSE(slot.get());
+}
+
+TEST(TestRealtimeGoalSlot, set_next)
+{
+  RealtimeGoalSlot<int> slot;
+  auto goal = std::make_shared<int>(1);
+  auto next_goal = std::make_shared<int>(2);
+  auto other_next_goal = std::make_shared<int>(3);
+
+  // without a goal, the next goal becomes the goal
+  EXPECT_FALSE(slot.set_next(goal));
+  EXPECT_EQ(slot.get(), goal);
+  EXPECT_FALSE(slot.get_next());
+
+  EXPECT_FALSE(slot.set_next(next_goal));
+  EXPECT_EQ(slot.get(), goal);
+  EXPECT_EQ(slot.get_next(), next_goal);
+  EXPECT_EQ(slot.get_from_rt(), goal);
+  EXPECT_EQ(slot.get_next_from_rt(), next_goal);
+
+  // a newer next goal replaces the queued one
+  EXPECT_EQ(slot.set_next(other_next_goal), next_goal);
+  EXPECT_EQ(slot.get_next(), other_next_goal);
+  EXPECT_EQ(next_goal.use_count(), 1);
+
+  EXPECT_EQ(slot.reset_next(), other_next_goal);
+  EXPECT_FALSE(slot.get_next());
+  EXPECT_FALSE(slot.reset_next());
+  EXPECT_EQ(slot.get(), goal);
+
+  // setting the goal drops the next goal
+  slot.set_next(next_goal);
+  slot.set(other_next_goal);
+  EXPECT_EQ(slot.get(), other_next_goal);
+  EXPECT_FALSE(slot.get_next());
+  EXPECT_EQ(next_goal.use_count(), 1);
+  EXPECT_EQ(goal.use_count(), 1);
+}
+
+TEST(TestRealtimeGoalSlot, advance_from_rt)
+{
+  RealtimeGoalSlot<int> slot;
+  auto goal = std::make_shared<int>(1);
+  auto next_goal = std::make_shared<int>(2);
+  slot.set(goal);
+  slot.set_next(next_goal);
+
+  ASSERT_EQ(slot.get_from_rt(), goal);
+  ASSERT_EQ(slot.get_next_from_rt(), next_goal);
+  EXPECT_TRUE(slot.advance_from_rt());
+  EXPECT_EQ(slot.get(), next_goal);
+  EXPECT_FALSE(slot.get_next());
+  EXPECT_FALSE(slot.advance_from_rt());
+
+  // the advanced goal is the one the realtime side finishes next
+  EXPECT_TRUE(slot.reset_from_rt());
+  EXPECT_FALSE(slot.get());
+}
+
+TEST(TestRealtimeGoalSlot, advance_from_rt_keeps_newer_goals)
+{
+  RealtimeGoalSlot<int> slot;
+  auto goal = std::make_shared<int>(1);
+  auto next_goal = std::make_shared<int>(2);
+  auto other_next_goal = std::make_shared<int>(3);
+  slot.set(goal);
+  slot.set_next(next_goal);
+  ASSERT_EQ(slot.get_from_rt(), goal);
+  ASSERT_EQ(slot.get_next_from_rt(), next_goal);
+
+  // the non-realtime side replaces the next goal before the realtime side advances
+  slot.set_next(other_next_goal);
+  EXPECT_FALSE(slot.advance_from_rt());
+  EXPECT_EQ(slot.get(), goal);
+  ASSERT_EQ(slot.get_next_from_rt(), other_next_goal);
+  EXPECT_TRUE(slot.advance_from_rt());
+  EXPECT_EQ(slot.get(), other_next_goal);
+
+  // or the goal
+  slot.set_next(next_goal);
+  ASSERT_EQ(slot.get_next_from_rt(), next_goal);
+  slot.set(goal);
+  EXPECT_FALSE(slot.advance_from_rt());
+  EXPECT_EQ(slot.get(), goal);
+}
+
+TEST(TestRealtimeGoalSlot, reset_from_rt_keeps_next_goal)
+{
+  RealtimeGoalSlot<int> slot;
+  auto goal = std::make_shared<int>(1);
+  auto next_goal = std::make_shared<int>(2);
+  slot.set(goal);
+  slot.set_next(next_goal);
+
+  ASSERT_EQ(slot.get_from_rt(), goal);
+  EXPECT_TRUE(slot.reset_from_rt());
+  EXPECT_FALSE(slot.get());
+  EXPECT_EQ(slot.get_next(), next_goal);
+
+  // a next goal queued after the realtime side finished the goal becomes the goal
+  slot.reset_next();
+  slot.set(goal);
+  ASSERT_EQ(slot.get_from_rt(), goal);
+  EXPECT_TRUE(slot.reset_from_rt());
+  EXPECT_FALSE(slot.set_next(next_goal));
+  EXPECT_EQ(slot.get(), next_goal);
+}
+
+TEST(TestRealtimeGoalSlot, concurrent_access)
+{
+  RealtimeGoalSlot<int> slot;
+  std::atomic<bool> done{false};
+
+  std::thread rt_thread(
+    [&]()
+    {
+      while (!done)
+      {
+        const auto goal = slot.get_from_rt();
+        if (goal)
+        {
+          // every goal the realtime side reads is still alive
+          EXPECT_GE(*goal, 0);
+          const auto next_goal = slot.get_next_from_rt();
+          if (next_goal)
+          {
+            EXPECT_GE(*next_goal, 0);
+            slot.advance_from_rt();
+          }
+          else if (*goal % 2 == 0)
+          {
+            slot.reset_from_rt();
+          }
+        }
+      }
+    });
+
+  for (int i = 0; i < 10000; ++i)
+  {
+    if (i % 5 == 0)
+    {
+      slot.set_next(std::make_shared<int>(i));
+    }
+    else
+    {
+      slot.set(std::make_shared<int>(i));
+    }
+    if (i % 3 == 0)
+    {
+      slot.reset();
+    }
+  }
+  done = true;
+  rt_thread.join();
+
+  slot.set(std::make_shared<int>(7));
+  EXPECT_EQ(*slot.get_from_rt(), 7);
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+
+using controller_realtime_tools::ScopedRealtimeSafetyCounter;
+
+TEST(TestRealtimeSafetyCounter, counts_allocations)
+{
+  std::vector<double> preallocated(16);
+  ScopedRealtimeSafetyCounter counter;
+  // writing preallocated memory is realtime safe
+  for (size_t i = 0; i < preallocated.size(); ++i)
+  {
+    preallocated[i] = static_cast<double>(i);
+  }
+  EXPECT_EQ(counter.get_allocations(), 0u);
+  EXPECT_EQ(counter.get_deallocations(), 0u);
+
+  {
+    auto value = std::make_unique<double>(1.0);
+    std::vector<double> grown(preallocated);
+    grown.push_back(1.0);
+  }
+  EXPECT_GE(counter.get_allocations(), 3u);
+  EXPECT_EQ(counter.get_deallocations(), counter.get_allocations());
+}
+
+TEST(TestRealtimeSafetyCounter, counts_blocking_locks)
+{
+  std::mutex mutex;
+  ScopedRealtimeSafetyCounter counter;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+  }
+#if defined(__GLIBC__)
+  EXPECT_EQ(counter.get_locks(), 1u);
+#endif
+
+  // try_lock() doesn't block
+  if (mutex.try_lock())
+  {
+    mutex.unlock();
+  }
+#if defined(__GLIBC__)
+  EXPECT_EQ(counter.get_locks(), 1u);
+#endif
+  EXPECT_EQ(counter.get_allocations(), 0u);
+}
+
+TEST(TestRealtimeSafetyCounter, counts_only_current_thread_in_scope)
+{
+  std::mutex mutex;
+  {
+    ScopedRealtimeSafetyCounter counter;
+    std::thread other(
+      [&mutex]()
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string allocated(100, 'x');
+      });
+    other.join();
+    // starting the thread allocates its state, but the other thread isn't counted
+    EXPECT_EQ(counter.get_locks(), 0u);
+  }
+
+  // not counted out of scope
+  auto value = std::make_unique<double>(1.0);
+  ScopedRealtimeSafetyCounter counter;
+  EXPECT_EQ(counter.get_allocations(), 0u);
+}
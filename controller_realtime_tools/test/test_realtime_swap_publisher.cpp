@@ -0,0 +1,241 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+
+using controller_realtime_tools::RealtimeSwapPublisher;
+
+namespace
+{
+struct TestMessage
+{
+  std::vector<double> data;
+};
+
+/// Records the published messages, and the address of their data
+class FakePublisher
+{
+public:
+  class LoanedMessage
+  {
+  public:
+    TestMessage & get() { return msg_; }
+
+  private:
+    TestMessage msg_;
+  };
+
+  explicit FakePublisher(bool can_loan) : can_loan_(can_loan) {}
+
+  bool can_loan_messages() const { return can_loan_; }
+
+  LoanedMessage borrow_loaned_message() { return LoanedMessage(); }
+
+  void publish(const TestMessage & msg)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    published_.push_back(msg.data);
+    published_data_.push_back(msg.data.data());
+  }
+
+  void publish(LoanedMessage && msg)
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    published_.push_back(msg.get().data);
+    ++loaned_;
+  }
+
+  bool wait_for_messages(size_t count, double last_value = 0.0)
+  {
+    const auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < end_time)
+    {
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (
+          published_.size() >= count &&
+          (last_value == 0.0 || published_.back() == std::vector<double>({last_value})))
+        {
+          return true;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+
+  std::mutex mutex_;
+  std::vector<std::vector<double>> published_;
+  std::vector<const double *> published_data_;
+  size_t loaned_ = 0;
+
+private:
+  bool can_loan_;
+};
+}  // namespace
+
+TEST(TestRealtimeSwapPublisher, publish_by_swapping)
+{
+  auto publisher = std::make_shared<FakePublisher>(false);
+  RealtimeSwapPublisher<TestMessage, FakePublisher> rt_publisher(
+    publisher, TestMessage{std::vector<double>(3, 0.0)});
+
+  TestMessage msg{std::vector<double>(3, 0.0)};
+  for (size_t count = 1; count <= 3; ++count)
+  {
+    const double i = static_cast<double>(count);
+    const double * data = msg.data.data();
+    msg.data = {1.0 * i, 2.0 * i, 3.0 * i};
+    // the storage is reused
+    ASSERT_EQ(data, msg.data.data());
+    while (!rt_publisher.try_publish(msg))
+    {
+    }
+    ASSERT_TRUE(publisher->wait_for_messages(count));
+
+    std::lock_guard<std::mutex> guard(publisher->mutex_);
+    EXPECT_EQ(std::vector<double>({1.0 * i, 2.0 * i, 3.0 * i}), publisher->published_.back());
+    // the message was published without copying it
+    EXPECT_EQ(data, publisher->published_data_.back());
+    EXPECT_EQ(3u, msg.data.size());
+  }
+  EXPECT_EQ(0u, publisher->loaned_);
+}
+
+TEST(TestRealtimeSwapPublisher, publish_loaned_messages)
+{
+  auto publisher = std::make_shared<FakePublisher>(true);
+  RealtimeSwapPublisher<TestMessage, FakePublisher> rt_publisher(publisher, TestMessage{{0.0}});
+
+  TestMessage msg{{1.0}};
+  while (!rt_publisher.try_publish(msg))
+  {
+  }
+  ASSERT_TRUE(publisher->wait_for_messages(1));
+
+  std::lock_guard<std::mutex> guard(publisher->mutex_);
+  EXPECT_EQ(std::vector<double>({1.0}), publisher->published_.back());
+  EXPECT_EQ(1u, publisher->loaned_);
+}
+
+TEST(TestRealtimeSwapPublisher, keep_latest_message)
+{
+  auto publisher = std::make_shared<FakePublisher>(false);
+  {
+    RealtimeSwapPublisher<TestMessage, FakePublisher> rt_publisher(
+      publisher, TestMessage{{0.0}});
+    for (int i = 1; i <= 1000; ++i)
+    {
+      TestMessage msg{{static_cast<double>(i)}};
+      while (!rt_publisher.try_publish(msg))
+      {
+      }
+    }
+    ASSERT_TRUE(publisher->wait_for_messages(1, 1000.0));
+  }
+  // joined the publishing thread
+  std::lock_guard<std::mutex> guard(publisher->mutex_);
+  EXPECT_LE(publisher->published_.size(), 1000u);
+  EXPECT_EQ(std::vector<double>({1000.0}), publisher->published_.back());
+}
+
+TEST(TestRealtimeSwapPublisher, decimate_to_period)
+{
+  auto publisher = std::make_shared<FakePublisher>(false);
+  RealtimeSwapPublisher<TestMessage, FakePublisher> rt_publisher(
+    publisher, TestMessage{{0.0}}, std::chrono::nanoseconds(100));
+
+  // the first message is due immediately, then every 100 ns
+  std::vector<std::int64_t> due_times;
+  for (std::int64_t now = 1000; now < 1400; now += 10)
+  {
+    if (rt_publisher.is_due(now))
+    {
+      TestMessage msg{{static_cast<double>(now)}};
+      while (!rt_publisher.try_publish(msg, now))
+      {
+      }
+      due_times.push_back(now);
+    }
+  }
+  EXPECT_EQ(std::vector<std::int64_t>({1000, 1100, 1200, 1300}), due_times);
+
+  // don't catch up after a pause
+  EXPECT_TRUE(rt_publisher.is_due(2050));
+  TestMessage msg{{2050.0}};
+  while (!rt_publisher.try_publish(msg, 2050))
+  {
+  }
+  EXPECT_FALSE(rt_publisher.is_due(2100));
+  EXPECT_TRUE(rt_publisher.is_due(2150));
+
+  rt_publisher.reset_period();
+  EXPECT_TRUE(rt_publisher.is_due(2060));
+  ASSERT_TRUE(publisher->wait_for_messages(1, 2050.0));
+}
+
+TEST(TestRealtimeSwapPublisher, count_messages)
+{
+  auto publisher = std::make_shared<FakePublisher>(false);
+  {
+    RealtimeSwapPublisher<TestMessage, FakePublisher> rt_publisher(
+      publisher, TestMessage{{0.0}});
+    const int NUM_MESSAGES = 1000;
+    for (int i = 1; i <= NUM_MESSAGES; ++i)
+    {
+      TestMessage msg{{static_cast<double>(i)}};
+      rt_publisher.try_publish(msg);
+    }
+    ASSERT_TRUE(publisher->wait_for_messages(1, NUM_MESSAGES));
+    // every message is either published or dropped, once the last publication is counted
+    const auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (rt_publisher.published() + rt_publisher.dropped() <
+             static_cast<std::uint64_t>(NUM_MESSAGES) &&
+           std::chrono::steady_clock::now() < end_time)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(
+      static_cast<std::uint64_t>(NUM_MESSAGES), rt_publisher.published() + rt_publisher.dropped());
+    std::lock_guard<std::mutex> guard(publisher->mutex_);
+    EXPECT_EQ(publisher->published_.size(), rt_publisher.published());
+  }
+}
+
+TEST(TestRealtimeSwapPublisher, visit_the_held_messages)
+{
+  auto publisher = std::make_shared<FakePublisher>(false);
+  RealtimeSwapPublisher<TestMessage, FakePublisher> rt_publisher(
+    publisher, TestMessage{std::vector<double>(3, 0.0)});
+  TestMessage msg{{1.0, 2.0, 3.0}};
+  ASSERT_TRUE(rt_publisher.try_publish(msg));
+  ASSERT_TRUE(publisher->wait_for_messages(1));
+
+  std::vector<std::vector<double>> visited;
+  rt_publisher.visit_messages([&visited](TestMessage & held) { visited.push_back(held.data); });
+  // the prototype and the published message, which is reused
+  EXPECT_THAT(
+    visited, testing::UnorderedElementsAre(
+               std::vector<double>({0.0, 0.0, 0.0}), std::vector<double>({1.0, 2.0, 3.0})));
+}
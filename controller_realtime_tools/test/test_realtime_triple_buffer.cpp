@@ -0,0 +1,92 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+
+using controller_realtime_tools::RealtimeTripleBuffer;
+
+TEST(TestRealtimeTripleBuffer, read_latest_value)
+{
+  RealtimeTripleBuffer<std::vector<int>> buffer(std::vector<int>(3, 0));
+  // the prototype until something is published
+  EXPECT_THAT(buffer.read(), ::testing::ElementsAre(0, 0, 0));
+
+  buffer.write_buffer()[0] = 1;
+  buffer.publish();
+  EXPECT_THAT(buffer.read(), ::testing::ElementsAre(1, 0, 0));
+  // reading again gives the same value
+  EXPECT_THAT(buffer.read(), ::testing::ElementsAre(1, 0, 0));
+
+  // only the latest of several values is read
+  for (int i = 2; i < 5; ++i)
+  {
+    buffer.write_buffer().assign(3, i);
+    buffer.publish();
+  }
+  EXPECT_THAT(buffer.read(), ::testing::ElementsAre(4, 4, 4));
+}
+
+TEST(TestRealtimeTripleBuffer, write_buffer_keeps_storage)
+{
+  RealtimeTripleBuffer<std::vector<int>> buffer(std::vector<int>(100, 0));
+  std::set<const int *> storage;
+  for (int i = 0; i < 10; ++i)
+  {
+    auto & write_buffer = buffer.write_buffer();
+    write_buffer.assign(100, i);
+    storage.insert(write_buffer.data());
+    buffer.publish();
+    const auto & value = buffer.read();
+    storage.insert(value.data());
+    EXPECT_EQ(value[99], i);
+  }
+  // the buffers rotate, but filling one in place never reallocates
+  EXPECT_EQ(storage.size(), 3u);
+}
+
+TEST(TestRealtimeTripleBuffer, concurrent_values_are_consistent)
+{
+  // every published value has the same number in all elements, a torn read would mix them
+  RealtimeTripleBuffer<std::vector<int>> buffer(std::vector<int>(64, 0));
+  std::atomic<bool> done{false};
+  std::thread writer(
+    [&]()
+    {
+      for (int i = 1; i <= 100000; ++i)
+      {
+        buffer.write_buffer().assign(64, i);
+        buffer.publish();
+      }
+      done.store(true);
+    });
+
+  int last_value = 0;
+  while (!done.load())
+  {
+    const auto & value = buffer.read();
+    ASSERT_THAT(value, ::testing::Each(value[0]));
+    // values never go backwards
+    ASSERT_GE(value[0], last_value);
+    last_value = value[0];
+  }
+  writer.join();
+  EXPECT_THAT(buffer.read(), ::testing::Each(100000));
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "controller_realtime_tools/ring_buffer.hpp"
+
+using controller_realtime_tools::RingBuffer;
+
+TEST(TestRingBuffer, push_keeps_latest_values)
+{
+  RingBuffer<int, 3> buffer;
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.capacity(), 3u);
+
+  buffer.push(1);
+  buffer.push(2);
+  EXPECT_EQ(buffer.size(), 2u);
+  EXPECT_FALSE(buffer.full());
+  EXPECT_EQ(buffer.latest(), 2);
+  EXPECT_EQ(buffer.latest(1), 1);
+
+  // the oldest values are overwritten once full
+  for (int i = 3; i < 8; ++i)
+  {
+    buffer.push(i);
+  }
+  EXPECT_TRUE(buffer.full());
+  EXPECT_EQ(buffer.size(), 3u);
+  EXPECT_EQ(buffer.latest(0), 7);
+  EXPECT_EQ(buffer.latest(1), 6);
+  EXPECT_EQ(buffer.latest(2), 5);
+}
+
+TEST(TestRingBuffer, fill_and_clear)
+{
+  RingBuffer<double, 2> buffer(1.5);
+  EXPECT_TRUE(buffer.full());
+  EXPECT_EQ(buffer.latest(0), 1.5);
+  EXPECT_EQ(buffer.latest(1), 1.5);
+
+  buffer.push(2.5);
+  EXPECT_EQ(buffer.latest(0), 2.5);
+  EXPECT_EQ(buffer.latest(1), 1.5);
+
+  buffer.clear();
+  EXPECT_TRUE(buffer.empty());
+  buffer.fill(0.0);
+  EXPECT_EQ(buffer.latest(0), 0.0);
+  EXPECT_EQ(buffer.latest(1), 0.0);
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <string>
+
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+#include "controller_realtime_tools/rt_logging.hpp"
+
+namespace
+{
+int evaluations = 0;
+int logged = 0;
+
+int evaluate(int value)
+{
+  ++evaluations;
+  return value;
+}
+
+std::string name()
+{
+  ++evaluations;
+  return "joint1/position";
+}
+}  // namespace
+
+// stands in for rclcpp, which isn't a dependency of these tests
+#define RCLCPP_DEBUG(logger, ...) \
+  static_cast<void>((logger) + ++logged + std::snprintf(nullptr, 0, __VA_ARGS__))
+
+#if defined(CONTROLLER_REALTIME_TOOLS_RT_DEBUG)
+TEST(TestRtLogging, debug_output_is_compiled_in)
+{
+  evaluations = 0;
+  logged = 0;
+  CONTROLLER_RT_DEBUG(evaluate(0), "%s: %f", name().c_str(), 1.0);
+  EXPECT_EQ(evaluations, 2);
+  EXPECT_EQ(logged, 1);
+}
+#else
+TEST(TestRtLogging, debug_output_is_compiled_out)
+{
+  evaluations = 0;
+  logged = 0;
+  controller_realtime_tools::ScopedRealtimeSafetyCounter counter;
+  for (int i = 0; i < 100; ++i)
+  {
+    CONTROLLER_RT_DEBUG(evaluate(0), "%s: %f", name().c_str(), static_cast<double>(i));
+    CONTROLLER_RT_DEBUG(evaluate(0), "no arguments");
+  }
+  EXPECT_EQ(evaluations, 0);
+  EXPECT_EQ(logged, 0);
+  EXPECT_EQ(counter.get_allocations(), 0u);
+  EXPECT_EQ(counter.get_locks(), 0u);
+}
+#endif
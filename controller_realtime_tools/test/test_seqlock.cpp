@@ -0,0 +1,81 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <thread>
+
+#include "controller_realtime_tools/seqlock.hpp"
+
+using controller_realtime_tools::Seqlock;
+
+namespace
+{
+struct Pose
+{
+  double x;
+  double y;
+  double heading;
+};
+}  // namespace
+
+TEST(TestSeqlock, read_latest_value)
+{
+  Seqlock<Pose> seqlock(Pose{1.0, 2.0, 3.0});
+  Pose pose{};
+  EXPECT_EQ(0u, seqlock.read(pose));
+  EXPECT_EQ(1.0, pose.x);
+  EXPECT_EQ(3.0, pose.heading);
+
+  seqlock.write(Pose{4.0, 5.0, 6.0});
+  seqlock.write(Pose{7.0, 8.0, 9.0});
+  EXPECT_EQ(2u, seqlock.read(pose));
+  EXPECT_EQ(7.0, pose.x);
+  EXPECT_EQ(8.0, pose.y);
+  EXPECT_EQ(9.0, pose.heading);
+}
+
+TEST(TestSeqlock, never_read_torn_values)
+{
+  Seqlock<Pose> seqlock(Pose{0.0, 0.0, 0.0});
+  std::atomic<bool> done{false};
+  std::thread writer(
+    [&]
+    {
+      for (int i = 1; i <= 100000; ++i)
+      {
+        const double value = static_cast<double>(i);
+        seqlock.write(Pose{value, value, value});
+      }
+      done.store(true);
+    });
+
+  double last_value = 0.0;
+  while (!done.load())
+  {
+    Pose pose{};
+    seqlock.read(pose);
+    ASSERT_EQ(pose.x, pose.y);
+    ASSERT_EQ(pose.x, pose.heading);
+    // values are never older than the ones read before
+    ASSERT_GE(pose.x, last_value);
+    last_value = pose.x;
+  }
+  writer.join();
+
+  Pose pose{};
+  EXPECT_EQ(100000u, seqlock.read(pose));
+  EXPECT_EQ(100000.0, pose.x);
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "controller_realtime_tools/smoothing_filter.hpp"
+
+using controller_realtime_tools::SmoothingFilter;
+using controller_realtime_tools::SmoothingMode;
+
+TEST(TestSmoothingFilter, mean_of_the_last_window_values)
+{
+  SmoothingFilter<8> filter(3);
+  EXPECT_EQ(filter.window_size(), 3u);
+  EXPECT_EQ(filter.value(), 0.0);
+
+  // over the values so far until the window is full
+  EXPECT_DOUBLE_EQ(filter.filter(3.0), 3.0);
+  EXPECT_DOUBLE_EQ(filter.filter(6.0), 4.5);
+  EXPECT_DOUBLE_EQ(filter.filter(9.0), 6.0);
+  // then the oldest values drop out
+  EXPECT_DOUBLE_EQ(filter.filter(12.0), 9.0);
+  for (int i = 0; i < 1000; ++i)
+  {
+    filter.filter(0.1 * i);
+  }
+  EXPECT_NEAR(filter.value(), 0.1 * 998, 1e-9);
+
+  filter.reset();
+  EXPECT_EQ(filter.value(), 0.0);
+  EXPECT_DOUBLE_EQ(filter.filter(1.0), 1.0);
+}
+
+TEST(TestSmoothingFilter, exponential_moving_average)
+{
+  // smoothing factor 2 / (3 + 1)
+  SmoothingFilter<8> filter(3, SmoothingMode::EXPONENTIAL);
+  EXPECT_DOUBLE_EQ(filter.filter(4.0), 4.0);
+  EXPECT_DOUBLE_EQ(filter.filter(8.0), 6.0);
+  EXPECT_DOUBLE_EQ(filter.filter(8.0), 7.0);
+}
+
+TEST(TestSmoothingFilter, median_of_the_last_window_values)
+{
+  SmoothingFilter<8> filter(3, SmoothingMode::MEDIAN);
+  EXPECT_DOUBLE_EQ(filter.filter(1.0), 1.0);
+  EXPECT_DOUBLE_EQ(filter.filter(3.0), 2.0);
+  // outliers are rejected
+  EXPECT_DOUBLE_EQ(filter.filter(100.0), 3.0);
+  EXPECT_DOUBLE_EQ(filter.filter(2.0), 3.0);
+  EXPECT_DOUBLE_EQ(filter.filter(-100.0), 2.0);
+}
+
+TEST(TestSmoothingFilter, configure_clamps_the_window_size)
+{
+  SmoothingFilter<4> filter;
+  EXPECT_EQ(filter.window_size(), 4u);
+
+  filter.configure(0, SmoothingMode::MEAN);
+  EXPECT_EQ(filter.window_size(), 1u);
+  filter.filter(1.0);
+  EXPECT_DOUBLE_EQ(filter.filter(5.0), 5.0);
+
+  filter.configure(100, SmoothingMode::MEDIAN);
+  EXPECT_EQ(filter.window_size(), 4u);
+  EXPECT_EQ(filter.mode(), SmoothingMode::MEDIAN);
+  // configuring resets
+  EXPECT_EQ(filter.value(), 0.0);
+}
+
+TEST(TestSmoothingFilter, mode_from_string)
+{
+  SmoothingMode mode = SmoothingMode::MEAN;
+  EXPECT_TRUE(controller_realtime_tools::smoothing_mode_from_string("median", mode));
+  EXPECT_EQ(mode, SmoothingMode::MEDIAN);
+  EXPECT_TRUE(controller_realtime_tools::smoothing_mode_from_string("exponential", mode));
+  EXPECT_EQ(mode, SmoothingMode::EXPONENTIAL);
+  EXPECT_FALSE(controller_realtime_tools::smoothing_mode_from_string("average", mode));
+  EXPECT_EQ(mode, SmoothingMode::EXPONENTIAL);
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "controller_realtime_tools/action_monitor.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+
+using controller_realtime_tools::make_thread_scheduling;
+using controller_realtime_tools::set_thread_scheduling;
+using controller_realtime_tools::ThreadScheduling;
+
+TEST(TestThreadScheduling, make_from_parameters)
+{
+  const auto scheduling = make_thread_scheduling(10, std::vector<std::int64_t>{2, 3});
+  EXPECT_EQ(scheduling.priority, 10);
+  EXPECT_THAT(scheduling.cpu_affinity, ::testing::ElementsAre(2, 3));
+}
+
+#if defined(__linux__)
+TEST(TestThreadScheduling, set_thread_scheduling)
+{
+  std::atomic<bool> done{false};
+  std::thread thread(
+    [&done]()
+    {
+      while (!done.load())
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+
+  // the defaults leave the thread as it is
+  EXPECT_TRUE(set_thread_scheduling(thread, ThreadScheduling()));
+  EXPECT_TRUE(set_thread_scheduling(thread, make_thread_scheduling(0, {0})));
+  EXPECT_FALSE(set_thread_scheduling(thread, make_thread_scheduling(0, {-1})));
+
+  done.store(true);
+  thread.join();
+}
+
+TEST(TestThreadScheduling, action_monitor)
+{
+  controller_realtime_tools::ActionMonitor monitor(
+    std::chrono::milliseconds(1), []() { return false; });
+  EXPECT_TRUE(monitor.set_scheduling(make_thread_scheduling(0, {0})));
+}
+#endif
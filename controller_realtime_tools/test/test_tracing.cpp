@@ -0,0 +1,57 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+#include "controller_realtime_tools/tracing.hpp"
+
+namespace
+{
+int evaluations = 0;
+
+int evaluate(int value)
+{
+  ++evaluations;
+  return value;
+}
+}  // namespace
+
+TEST(TestTracing, tracepoints_are_realtime_safe)
+{
+  controller_realtime_tools::ScopedRealtimeSafetyCounter counter;
+  for (int i = 0; i < 100; ++i)
+  {
+    CONTROLLER_TRACEPOINT(TRAJECTORY_ACTIVATED, &counter, i);
+    CONTROLLER_TRACEPOINT(KINEMATICS_END, &counter, true);
+  }
+  EXPECT_EQ(counter.get_allocations(), 0u);
+  EXPECT_EQ(counter.get_locks(), 0u);
+}
+
+#if defined(CONTROLLER_REALTIME_TOOLS_TRACING)
+TEST(TestTracing, arguments_are_evaluated_once)
+{
+  evaluations = 0;
+  CONTROLLER_TRACEPOINT(ODOMETRY_INTEGRATED, &evaluations, evaluate(1));
+  EXPECT_EQ(evaluations, 1);
+}
+#else
+TEST(TestTracing, disabled_tracepoints_are_compiled_out)
+{
+  evaluations = 0;
+  CONTROLLER_TRACEPOINT(ODOMETRY_INTEGRATED, &evaluations, evaluate(1));
+  EXPECT_EQ(evaluations, 0);
+}
+#endif
@@ -0,0 +1,51 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <limits>
+
+#include "controller_realtime_tools/tracking_error_statistics.hpp"
+
+using controller_realtime_tools::TrackingErrorStatistics;
+
+TEST(TestTrackingErrorStatistics, rms_and_max_are_accumulated_per_joint)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  TrackingErrorStatistics statistics;
+  statistics.resize(2);
+  statistics.clear(10.0);
+
+  const double errors[][2] = {{0.1, nan}, {-0.3, 2.0}, {0.2, -1.0}};
+  for (size_t i = 0; i < 3; ++i)
+  {
+    statistics.add(errors[i], 10.0 + 0.01 * static_cast<double>(i));
+  }
+
+  EXPECT_EQ(statistics.count(0), 3u);
+  EXPECT_NEAR(statistics.rms(0), std::sqrt((0.01 + 0.09 + 0.04) / 3.0), 1e-12);
+  EXPECT_DOUBLE_EQ(statistics.max(0), 0.3);
+  EXPECT_NEAR(statistics.time_of_max(0), 0.01, 1e-12);
+  // NaN is not counted
+  EXPECT_EQ(statistics.count(1), 2u);
+  EXPECT_NEAR(statistics.rms(1), std::sqrt(2.5), 1e-12);
+  EXPECT_DOUBLE_EQ(statistics.max(1), 2.0);
+
+  statistics.clear(20.0);
+  EXPECT_DOUBLE_EQ(statistics.start_time(), 20.0);
+  EXPECT_EQ(statistics.count(0), 0u);
+  EXPECT_DOUBLE_EQ(statistics.rms(0), 0.0);
+  EXPECT_DOUBLE_EQ(statistics.max(1), 0.0);
+}
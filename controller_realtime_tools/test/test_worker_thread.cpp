@@ -0,0 +1,73 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "controller_realtime_tools/worker_thread.hpp"
+
+using controller_realtime_tools::WorkerThread;
+
+TEST(TestWorkerThread, runs_jobs_in_order)
+{
+  WorkerThread worker;
+  std::vector<int> order;
+  std::thread::id job_thread;
+  for (int i = 0; i < 100; ++i)
+  {
+    worker.post(
+      [&order, &job_thread, i]()
+      {
+        order.push_back(i);
+        job_thread = std::this_thread::get_id();
+      });
+  }
+  worker.wait_until_idle();
+
+  ASSERT_EQ(100u, order.size());
+  for (int i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(i, order[static_cast<size_t>(i)]);
+  }
+  EXPECT_NE(std::this_thread::get_id(), job_thread);
+}
+
+TEST(TestWorkerThread, drops_pending_jobs_when_destroyed)
+{
+  int runs = 0;
+  {
+    WorkerThread worker;
+    worker.post([]() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); });
+    for (int i = 0; i < 10; ++i)
+    {
+      worker.post([&runs]() { ++runs; });
+    }
+  }
+  EXPECT_LT(runs, 10);
+}
+
+TEST(TestWorkerThread, cpu_affinity)
+{
+  WorkerThread worker;
+  EXPECT_FALSE(worker.set_cpu_affinity({-1}));
+#if defined(__linux__)
+  EXPECT_TRUE(worker.set_cpu_affinity({0}));
+  EXPECT_TRUE(worker.set_cpu_affinity({}));
+  // the default policy doesn't need privileges
+  EXPECT_TRUE(worker.set_priority(0));
+#endif
+}
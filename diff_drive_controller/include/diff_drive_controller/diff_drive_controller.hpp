@@ -22,14 +22,24 @@
 #include <chrono>
 #include <cmath>
 #include <memory>
-#include <queue>
+#include <mutex>
 #include <string>
 #include <vector>
 
-#include "controller_interface/controller_interface.hpp"
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_realtime_tools/command_sequence.hpp"
+#include "controller_realtime_tools/cycle_budget.hpp"
+#include "controller_realtime_tools/input_recorder.hpp"
+#include "controller_realtime_tools/jitter_buffer.hpp"
+#include "controller_realtime_tools/latency_probe.hpp"
+#include "controller_realtime_tools/odometry_publisher.hpp"
+#include "controller_realtime_tools/parameter_snapshot.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
 #include "diff_drive_controller/odometry.hpp"
 #include "diff_drive_controller/speed_limiter.hpp"
 #include "diff_drive_controller/visibility_control.h"
+#include "diff_drive_controller/wheel_slip_detector.hpp"
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "hardware_interface/handle.hpp"
@@ -37,9 +47,7 @@
 #include "odometry.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_box.h"
-#include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
+#include "statistics_msgs/msg/metrics_message.hpp"
 #include "tf2_msgs/msg/tf_message.hpp"
 
 // auto-generated by generate_parameter_library
@@ -47,9 +55,12 @@
 
 namespace diff_drive_controller
 {
-class DiffDriveController : public controller_interface::ControllerInterface
+class DiffDriveController : public controller_interface::ChainableControllerInterface
 {
   using Twist = geometry_msgs::msg::TwistStamped;
+  using OdometrySnapshotPublisher = controller_realtime_tools::OdometryPublisher<
+    nav_msgs::msg::Odometry, rclcpp::Publisher<nav_msgs::msg::Odometry>, tf2_msgs::msg::TFMessage,
+    rclcpp::Publisher<tf2_msgs::msg::TFMessage>>;
 
 public:
   DIFF_DRIVE_CONTROLLER_PUBLIC
@@ -62,7 +73,11 @@ public:
   controller_interface::InterfaceConfiguration state_interface_configuration() const override;
 
   DIFF_DRIVE_CONTROLLER_PUBLIC
-  controller_interface::return_type update(
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  DIFF_DRIVE_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
   DIFF_DRIVE_CONTROLLER_PUBLIC
@@ -93,46 +108,127 @@ public:
     const rclcpp_lifecycle::State & previous_state) override;
 
 protected:
+  // linear/velocity and angular/velocity, written from ~/cmd_vel unless in chained mode
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  // odometry/x, odometry/y, odometry/heading, odometry/linear_velocity and
+  // odometry/angular_velocity, the odometry of the last update for the following controllers
+  std::vector<hardware_interface::StateInterface> on_export_state_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
   struct WheelHandle
   {
     std::reference_wrapper<const hardware_interface::LoanedStateInterface> feedback;
     std::reference_wrapper<hardware_interface::LoanedCommandInterface> velocity;
+    // sequence number of the velocity command, only with command_sequence_interfaces
+    hardware_interface::LoanedCommandInterface * velocity_sequence = nullptr;
+    // timestamped encoder samples of the last cycle, only with encoder_samples_per_cycle > 0
+    const hardware_interface::LoanedStateInterface * sample_count = nullptr;
+    std::vector<const hardware_interface::LoanedStateInterface *> sample_positions;
+    std::vector<const hardware_interface::LoanedStateInterface *> sample_times;
+  };
+
+  // wheel kinematics with the multipliers applied and the divisions of update() precomputed
+  struct WheelKinematics
+  {
+    double wheel_separation = 0.0;            // [m]
+    double left_wheel_radius = 0.0;           // [m]
+    double right_wheel_radius = 0.0;          // [m]
+    double half_wheel_separation = 0.0;       // [m]
+    double inverse_left_wheel_radius = 0.0;   // [1/m]
+    double inverse_right_wheel_radius = 0.0;  // [1/m]
+  };
+
+  // parameters which can be changed while the controller is active, built outside of update()
+  struct RuntimeParameters
+  {
+    WheelKinematics wheel_kinematics;
+    std::chrono::milliseconds cmd_vel_timeout{500};
+    SpeedLimiter limiter_linear;
+    SpeedLimiter limiter_angular;
   };
 
   const char * feedback_type() const;
+  bool use_encoder_samples() const;
+  bool update_odometry_from_encoder_samples();
+  static RuntimeParameters make_runtime_parameters(const Params & params);
+  // hand the parameters changed since the last call over to update(), called by a timer
+  void publish_parameters_update();
+  // take over the runtime parameters last taken from runtime_parameters_, realtime-safe
+  void use_runtime_parameters();
   controller_interface::CallbackReturn configure_side(
     const std::string & side, const std::vector<std::string> & wheel_names,
     std::vector<WheelHandle> & registered_handles);
 
   std::vector<WheelHandle> registered_left_wheel_handles_;
   std::vector<WheelHandle> registered_right_wheel_handles_;
+  // yaw rate of the IMU, only with imu_heading.enable
+  const hardware_interface::LoanedStateInterface * imu_yaw_rate_ = nullptr;
+  // non-essential stages of update(), skipped while over the cycle budget
+  enum ShedStage : size_t
+  {
+    SHED_LIMITED_VELOCITY,
+  };
+  // only with cycle_budget.enable
+  std::unique_ptr<controller_realtime_tools::CycleBudget> cycle_budget_;
+  rclcpp::TimerBase::SharedPtr cycle_budget_timer_;
+  // records the inputs of every update while active, only with input_recording.enable
+  std::unique_ptr<controller_realtime_tools::InputRecorder> input_recorder_;
+  // sequence numbers of the velocity commands of the left, then the right wheels, only with
+  // command_sequence_interfaces
+  std::unique_ptr<controller_realtime_tools::CommandSequence> command_sequence_;
 
   // Parameters from ROS for diff_drive_controller
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
 
+  // runtime parameters handed over to update(), and the parameters they were last built from
+  std::unique_ptr<controller_realtime_tools::ParameterSnapshot<RuntimeParameters>>
+    runtime_parameters_;
+  Params runtime_params_;
+  // guards runtime_parameters_ and runtime_params_ between the timer and lifecycle transitions
+  std::mutex parameters_mutex_;
+  rclcpp::TimerBase::SharedPtr parameter_update_timer_;
+
   Odometry odometry_;
+  // taken over from runtime_parameters_ by update()
+  WheelKinematics wheel_kinematics_;
+  // feedback of the wheels of each side, contiguous and preallocated for update()
+  std::vector<double> left_feedbacks_;
+  std::vector<double> right_feedbacks_;
+  WheelSlipDetector left_slip_detector_;
+  WheelSlipDetector right_slip_detector_;
+  // mean encoder samples of each side and their times, preallocated for update()
+  std::vector<double> left_encoder_samples_;
+  std::vector<double> right_encoder_samples_;
+  std::vector<double> encoder_sample_times_;
 
   // Timeout to consider cmd_vel commands old
   std::chrono::milliseconds cmd_vel_timeout_{500};
 
   std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odometry_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
-    realtime_odometry_publisher_ = nullptr;
-
   std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> odometry_transform_publisher_ =
     nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>
-    realtime_odometry_transform_publisher_ = nullptr;
+  // publishes the odometry and its transform at publish_rate from its own thread
+  std::unique_ptr<OdometrySnapshotPublisher> odometry_snapshot_publisher_;
 
   bool subscriber_is_active_ = false;
   rclcpp::Subscription<Twist>::SharedPtr velocity_command_subscriber_ = nullptr;
   rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr
     velocity_command_unstamped_subscriber_ = nullptr;
 
-  realtime_tools::RealtimeBox<std::shared_ptr<Twist>> received_velocity_msg_ptr_{nullptr};
+  // last received command, written by the subscriber callback and read by update()
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<Twist>> received_velocity_msg_;
+  // received commands played out in the order of their stamps, up to 32 waiting for their turn,
+  // nullptr unless jitter_buffer.enable is set
+  using CommandJitterBuffer =
+    controller_realtime_tools::JitterBuffer<geometry_msgs::msg::Twist, 32>;
+  std::unique_ptr<CommandJitterBuffer> command_jitter_buffer_;
 
-  std::queue<Twist> previous_commands_;  // last two commands
+  // last commands of the speed limiters
+  SpeedLimiter::History<> previous_linear_commands_;
+  SpeedLimiter::History<> previous_angular_commands_;
 
   // speed limiters
   SpeedLimiter limiter_linear_;
@@ -140,21 +236,28 @@ protected:
 
   bool publish_limited_velocity_ = false;
   std::shared_ptr<rclcpp::Publisher<Twist>> limited_velocity_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<Twist>> realtime_limited_velocity_publisher_ =
-    nullptr;
+  using LimitedVelocityPublisher =
+    controller_realtime_tools::RealtimeSwapPublisher<Twist, rclcpp::Publisher<Twist>>;
+  std::shared_ptr<LimitedVelocityPublisher> realtime_limited_velocity_publisher_ = nullptr;
+  Twist limited_velocity_msg_;
 
   rclcpp::Time previous_update_timestamp_{0};
 
-  // publish rate limiter
-  double publish_rate_ = 50.0;
-  rclcpp::Duration publish_period_ = rclcpp::Duration::from_nanoseconds(0);
-  rclcpp::Time previous_publish_timestamp_{0, 0, RCL_CLOCK_UNINITIALIZED};
+  // latency from publishing a velocity command to writing it, nullptr unless
+  // command_latency.enable is set
+  std::unique_ptr<controller_realtime_tools::LatencyProbe> command_latency_;
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr command_latency_publisher_;
+  rclcpp::TimerBase::SharedPtr command_latency_timer_;
+  rclcpp::Time command_latency_window_start_;
 
   bool is_halted = false;
   bool use_stamped_vel_ = true;
 
   bool reset();
   void halt();
+  void publish_command_latency();
+  // write the sequence numbers of the velocity commands written in this cycle, realtime-safe
+  void write_command_sequences();
 };
 }  // namespace diff_drive_controller
 #endif  // DIFF_DRIVE_CONTROLLER__DIFF_DRIVE_CONTROLLER_HPP_
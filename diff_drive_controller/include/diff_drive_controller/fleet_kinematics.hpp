@@ -0,0 +1,96 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIFF_DRIVE_CONTROLLER__FLEET_KINEMATICS_HPP_
+#define DIFF_DRIVE_CONTROLLER__FLEET_KINEMATICS_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "diff_drive_controller/speed_limiter.hpp"
+
+namespace diff_drive_controller
+{
+/**
+ * \brief Kinematics of a fleet of identical differential drive robots, stepped together without a
+ * controller per robot.
+ *
+ * Every step limits the commanded velocities of each robot with the speed limiters and the
+ * history of its previous commands, computes the wheel velocities like the controller, and
+ * integrates the motion of the wheels with the odometry of Odometry::updateFromVelocity(),
+ * assuming that the wheels reach their commands within the step. The state of the robots is
+ * stored per field for all robots, and disjoint ranges of robots can be stepped from different
+ * threads.
+ *
+ * All buffers are allocated by configure(), the other methods are realtime-safe.
+ */
+class FleetKinematics
+{
+public:
+  struct Parameters
+  {
+    double wheel_separation = 0.0;    // [m]
+    double left_wheel_radius = 0.0;   // [m]
+    double right_wheel_radius = 0.0;  // [m]
+    SpeedLimiter limiter_linear;
+    SpeedLimiter limiter_angular;
+  };
+
+  /// Set the number of robots and their parameters, and reset them.
+  void configure(size_t num_robots, const Parameters & parameters);
+
+  /// Put all robots at the origin, standing still and without previous commands.
+  void reset();
+
+  /**
+   * \brief Step the robots [begin, end) by \p dt
+   * \param [in]  linear_commands        Desired linear velocity of every robot [m/s]
+   * \param [in]  angular_commands       Desired angular velocity of every robot [rad/s]
+   * \param [in]  dt                     Duration of the step [s]
+   * \param [out] left_wheel_velocities  Velocity command of the left wheels of every robot [rad/s]
+   * \param [out] right_wheel_velocities Velocity command of the right wheels of every robot
+   *                                     [rad/s]
+   */
+  void step(
+    const double * linear_commands, const double * angular_commands, double dt,
+    double * left_wheel_velocities, double * right_wheel_velocities, size_t begin, size_t end);
+
+  size_t size() const { return x_.size(); }
+
+  // pose [m, m, rad] and velocities [m/s, rad/s] of every robot
+  const std::vector<double> & x() const { return x_; }
+  const std::vector<double> & y() const { return y_; }
+  const std::vector<double> & heading() const { return heading_; }
+  const std::vector<double> & linear() const { return linear_; }
+  const std::vector<double> & angular() const { return angular_; }
+
+private:
+  Parameters parameters_;
+  double half_wheel_separation_ = 0.0;
+  double inverse_left_wheel_radius_ = 0.0;
+  double inverse_right_wheel_radius_ = 0.0;
+
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> heading_;
+  std::vector<double> linear_;
+  std::vector<double> angular_;
+  // the last two limited commands of every robot, for the acceleration and jerk limits
+  std::vector<double> previous_linear_[SpeedLimiter::HISTORY_SIZE];
+  std::vector<double> previous_angular_[SpeedLimiter::HISTORY_SIZE];
+};
+
+}  // namespace diff_drive_controller
+
+#endif  // DIFF_DRIVE_CONTROLLER__FLEET_KINEMATICS_HPP_
@@ -22,47 +22,74 @@
 #ifndef DIFF_DRIVE_CONTROLLER__ODOMETRY_HPP_
 #define DIFF_DRIVE_CONTROLLER__ODOMETRY_HPP_
 
+#include <array>
 #include <cmath>
+#include <cstddef>
 
+#include "controller_realtime_tools/pose_integration.hpp"
+#include "controller_realtime_tools/smoothing_filter.hpp"
 #include "rclcpp/time.hpp"
-#include "rcpputils/rolling_mean_accumulator.hpp"
 
 namespace diff_drive_controller
 {
 class Odometry
 {
 public:
+  // Largest velocity rolling window, the filters are preallocated for it:
+  static constexpr size_t MAX_VELOCITY_ROLLING_WINDOW_SIZE = 256;
+
   explicit Odometry(size_t velocity_rolling_window_size = 10);
 
   void init(const rclcpp::Time & time);
   bool update(double left_pos, double right_pos, const rclcpp::Time & time);
   bool updateFromVelocity(double left_vel, double right_vel, const rclcpp::Time & time);
+  bool updateFromSamples(
+    const double * left_pos, const double * right_pos, const double * times, size_t count);
   void updateOpenLoop(double linear, double angular, const rclcpp::Time & time);
   void resetOdometry();
 
-  double getX() const { return x_; }
-  double getY() const { return y_; }
-  double getHeading() const { return heading_; }
+  double getX() const { return pose_.x(); }
+  double getY() const { return pose_.y(); }
+  double getHeading() const { return pose_.heading(); }
   double getLinear() const { return linear_; }
   double getAngular() const { return angular_; }
+  // Covariance of x, y and heading, row-major:
+  const std::array<double, 9> & getPoseCovariance() const { return pose_covariance_; }
 
   void setWheelParams(double wheel_separation, double left_wheel_radius, double right_wheel_radius);
   void setVelocityRollingWindowSize(size_t velocity_rolling_window_size);
+  void setVelocitySmoothingMode(controller_realtime_tools::SmoothingMode mode);
+  void setPoseCovarianceParams(
+    bool propagate, double x_variance, double y_variance, double heading_variance,
+    double linear_noise, double angular_noise);
+  // Weight in [0, 1] of the IMU yaw rate against the wheels in the heading increments, 0 disables:
+  void setImuWeight(double weight);
+  // Yaw rate [rad/s] measured by the IMU, blended into the following updates, ignored if NaN:
+  void setImuAngularVelocity(double angular_velocity) { imu_angular_velocity_ = angular_velocity; }
 
 private:
-  using RollingMeanAccumulator = rcpputils::RollingMeanAccumulator<double>;
+  using VelocityFilter =
+    controller_realtime_tools::SmoothingFilter<MAX_VELOCITY_ROLLING_WINDOW_SIZE>;
 
-  void integrateRungeKutta2(double linear, double angular);
+  // Integrate one step with controller_realtime_tools::PoseIntegrator:
   void integrateExact(double linear, double angular);
+  // Propagate the pose covariance over the step integrateExact() is about to integrate:
+  void propagateStepCovariance(double linear, double angular);
+  // Blend the angular displacement of the wheels over dt [s] with the IMU yaw rate:
+  double blendAngular(double wheel_angular, double dt) const;
   void resetAccumulators();
+  void propagatePoseCovariance(
+    double dx_dheading, double dy_dheading, const std::array<double, 4> & position_jacobian,
+    double linear, double angular);
 
   // Current timestamp:
   rclcpp::Time timestamp_;
 
-  // Current pose:
-  double x_;        //   [m]
-  double y_;        //   [m]
-  double heading_;  // [rad]
+  // Time of the last integrated encoder sample [s]:
+  double last_sample_time_;
+
+  // Current pose, x and y [m] and heading [rad]:
+  controller_realtime_tools::PoseIntegrator pose_;
 
   // Current velocity:
   double linear_;   //   [m/s]
@@ -77,10 +104,23 @@ private:
   double left_wheel_old_pos_;
   double right_wheel_old_pos_;
 
-  // Rolling mean accumulators for the linear and angular velocities:
+  // Pose covariance, propagated with each integration step if enabled:
+  bool propagate_pose_covariance_;
+  std::array<double, 9> pose_covariance_;
+  std::array<double, 9> initial_pose_covariance_;
+  // Variances of the linear [m^2/m] and angular [rad^2/rad] displacements per displacement:
+  double linear_noise_;
+  double angular_noise_;
+
+  // Complementary blend of the heading increments with the IMU yaw rate [rad/s]:
+  double imu_weight_;
+  double imu_angular_velocity_;
+
+  // Smoothing filters for the linear and angular velocities:
   size_t velocity_rolling_window_size_;
-  RollingMeanAccumulator linear_accumulator_;
-  RollingMeanAccumulator angular_accumulator_;
+  controller_realtime_tools::SmoothingMode velocity_smoothing_mode_;
+  VelocityFilter linear_accumulator_;
+  VelocityFilter angular_accumulator_;
 };
 
 }  // namespace diff_drive_controller
@@ -20,12 +20,23 @@
 #define DIFF_DRIVE_CONTROLLER__SPEED_LIMITER_HPP_
 
 #include <cmath>
+#include <cstddef>
+
+#include "controller_realtime_tools/limiter.hpp"
+#include "controller_realtime_tools/ring_buffer.hpp"
 
 namespace diff_drive_controller
 {
 class SpeedLimiter
 {
 public:
+  /// Number of previous velocities the limits depend on, i.e. two for the jerk limit
+  static constexpr std::size_t HISTORY_SIZE = 2;
+
+  /// Previous velocities, in place and without allocations
+  template <std::size_t Capacity = HISTORY_SIZE>
+  using History = controller_realtime_tools::RingBuffer<double, Capacity>;
+
   /**
    * \brief Constructor
    * \param [in] has_velocity_limits     if true, applies velocity limits
@@ -52,14 +63,29 @@ public:
    * \param [in]      dt Time step [s]
    * \return Limiting factor (1.0 if none)
    */
-  double limit(double & v, double v0, double v1, double dt);
+  double limit(double & v, double v0, double v1, double dt) const;
+
+  /**
+   * \brief Limit the velocity, acceleration and jerk given a history of previous velocities
+   * \param [in, out] v        Velocity [m/s]
+   * \param [in]      previous Previous velocities, previous.latest() is the one previous to v,
+   *                           it may hold more than the limits need [m/s]
+   * \param [in]      dt       Time step [s]
+   * \return Limiting factor (1.0 if none)
+   */
+  template <std::size_t Capacity>
+  double limit(double & v, const History<Capacity> & previous, double dt) const
+  {
+    static_assert(Capacity >= HISTORY_SIZE, "The history is too short for the jerk limit");
+    return limit(v, previous.latest(0), previous.latest(1), dt);
+  }
 
   /**
    * \brief Limit the velocity
    * \param [in, out] v Velocity [m/s]
    * \return Limiting factor (1.0 if none)
    */
-  double limit_velocity(double & v);
+  double limit_velocity(double & v) const;
 
   /**
    * \brief Limit the acceleration
@@ -68,7 +94,7 @@ public:
    * \param [in]      dt Time step [s]
    * \return Limiting factor (1.0 if none)
    */
-  double limit_acceleration(double & v, double v0, double dt);
+  double limit_acceleration(double & v, double v0, double dt) const;
 
   /**
    * \brief Limit the jerk
@@ -79,25 +105,11 @@ public:
    * \return Limiting factor (1.0 if none)
    * \see http://en.wikipedia.org/wiki/Jerk_%28physics%29#Motion_control
    */
-  double limit_jerk(double & v, double v0, double v1, double dt);
+  double limit_jerk(double & v, double v0, double v1, double dt) const;
 
 private:
-  // Enable/Disable velocity/acceleration/jerk limits:
-  bool has_velocity_limits_;
-  bool has_acceleration_limits_;
-  bool has_jerk_limits_;
-
-  // Velocity limits:
-  double min_velocity_;
-  double max_velocity_;
-
-  // Acceleration limits:
-  double min_acceleration_;
-  double max_acceleration_;
-
-  // Jerk limits:
-  double min_jerk_;
-  double max_jerk_;
+  // limits of the velocity, its acceleration and its jerk, those not enabled are NaN
+  controller_realtime_tools::Limiter<1> limiter_;
 };
 
 }  // namespace diff_drive_controller
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIFF_DRIVE_CONTROLLER__WHEEL_SLIP_DETECTOR_HPP_
+#define DIFF_DRIVE_CONTROLLER__WHEEL_SLIP_DETECTOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace diff_drive_controller
+{
+/**
+ * \brief Fusion of the feedbacks of the wheels of one side, without the slipping ones.
+ *
+ * A wheel slips if its velocity differs from the median velocity of its side by more than the
+ * slip threshold. Unlike the mean, the median isn't dragged along by the slipping wheels as long
+ * as less than half of them slip. The fused feedback is the mean of the wheels that don't slip,
+ * or of all wheels if they all slip.
+ *
+ * All buffers are allocated by configure(), the other methods are realtime-safe.
+ */
+class WheelSlipDetector
+{
+public:
+  /**
+   * \brief Allocate the buffers for \p wheel_count wheels and reset.
+   * \param [in] wheel_count    Number of wheels of the side
+   * \param [in] slip_threshold Largest difference of a wheel velocity from the median [rad/s]
+   */
+  void configure(size_t wheel_count, double slip_threshold);
+
+  /// Forget the previous positions, the next fusePositions() starts from their mean.
+  void reset();
+
+  /**
+   * \brief Fuse the wheel velocities
+   * \param [in] velocities Velocity of each wheel [rad/s]
+   * \return Mean velocity of the wheels that don't slip [rad/s]
+   */
+  double fuseVelocities(const double * velocities);
+
+  /**
+   * \brief Fuse the wheel positions
+   *
+   * The fused position starts at the mean of the first positions and then advances by the mean
+   * increment of the wheels that don't slip, so it stays continuous when wheels are excluded.
+   * \param [in] positions Position of each wheel [rad]
+   * \param [in] dt        Time since the previous positions [s]
+   * \return Fused position [rad]
+   */
+  double fusePositions(const double * positions, double dt);
+
+  /// If the wheel \p index slipped in the last fusion.
+  bool isSlipping(size_t index) const { return slipping_[index] != 0; }
+  size_t slippingCount() const { return slipping_count_; }
+
+private:
+  // mean of the values that differ from their median by at most the threshold
+  double meanWithoutSlip(const double * values, double threshold);
+
+  double slip_threshold_ = 0.0;
+  // uint8_t rather than bool, so the flags are stored contiguously
+  std::vector<uint8_t> slipping_;
+  size_t slipping_count_ = 0;
+
+  // scratch space for the median
+  std::vector<double> sorted_values_;
+
+  std::vector<double> previous_positions_;
+  std::vector<double> position_increments_;
+  bool has_previous_positions_ = false;
+  double fused_position_ = 0.0;
+};
+
+}  // namespace diff_drive_controller
+
+#endif  // DIFF_DRIVE_CONTROLLER__WHEEL_SLIP_DETECTOR_HPP_
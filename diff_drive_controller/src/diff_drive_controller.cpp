@@ -16,17 +16,22 @@
  * Author: Bence Magyar, Enrique Fernández, Manuel Meraz
  */
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
 #include <memory>
-#include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "controller_realtime_tools/metrics.hpp"
+#include "controller_realtime_tools/nan_scan.hpp"
+#include "controller_realtime_tools/tracing.hpp"
 #include "diff_drive_controller/diff_drive_controller.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/logging.hpp"
-#include "tf2/LinearMath/Quaternion.h"
 
 namespace
 {
@@ -35,6 +40,37 @@ constexpr auto DEFAULT_COMMAND_UNSTAMPED_TOPIC = "~/cmd_vel_unstamped";
 constexpr auto DEFAULT_COMMAND_OUT_TOPIC = "~/cmd_vel_out";
 constexpr auto DEFAULT_ODOMETRY_TOPIC = "~/odom";
 constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
+constexpr auto ENCODER_SAMPLE_COUNT_INTERFACE = "position_samples";
+// yaw rate of the IMU, named like the interfaces of semantic_components::IMUSensor
+constexpr auto IMU_YAW_RATE_INTERFACE = "angular_velocity.z";
+// exported odometry state interfaces, in the order of state_interfaces_values_
+constexpr std::array<const char *, 5> ODOMETRY_STATE_INTERFACES = {
+  "odometry/x", "odometry/y", "odometry/heading", "odometry/linear_velocity",
+  "odometry/angular_velocity"};
+
+std::string encoder_sample_interface(size_t index)
+{
+  return "position_sample_" + std::to_string(index);
+}
+
+std::string encoder_sample_time_interface(size_t index)
+{
+  return encoder_sample_interface(index) + "_time";
+}
+
+rclcpp::QoS command_qos(const std::string & history, int64_t depth)
+{
+  auto qos = rclcpp::SystemDefaultsQoS();
+  if (history == "keep_last")
+  {
+    qos.keep_last(static_cast<size_t>(depth));
+  }
+  else if (history == "keep_all")
+  {
+    qos.keep_all();
+  }
+  return qos;
+}
 }  // namespace
 
 namespace diff_drive_controller
@@ -46,13 +82,18 @@ using hardware_interface::HW_IF_POSITION;
 using hardware_interface::HW_IF_VELOCITY;
 using lifecycle_msgs::msg::State;
 
-DiffDriveController::DiffDriveController() : controller_interface::ControllerInterface() {}
+DiffDriveController::DiffDriveController() : controller_interface::ChainableControllerInterface() {}
 
 const char * DiffDriveController::feedback_type() const
 {
   return params_.position_feedback ? HW_IF_POSITION : HW_IF_VELOCITY;
 }
 
+bool DiffDriveController::use_encoder_samples() const
+{
+  return params_.position_feedback && params_.encoder_samples_per_cycle > 0;
+}
+
 controller_interface::CallbackReturn DiffDriveController::on_init()
 {
   try
@@ -81,24 +122,133 @@ InterfaceConfiguration DiffDriveController::command_interface_configuration() co
   {
     conf_names.push_back(joint_name + "/" + HW_IF_VELOCITY);
   }
+  if (params_.command_sequence_interfaces)
+  {
+    const size_t num_wheels = conf_names.size();
+    for (size_t index = 0; index < num_wheels; ++index)
+    {
+      conf_names.push_back(
+        controller_realtime_tools::CommandSequence::interface_name(conf_names[index]));
+    }
+  }
   return {interface_configuration_type::INDIVIDUAL, conf_names};
 }
 
 InterfaceConfiguration DiffDriveController::state_interface_configuration() const
 {
   std::vector<std::string> conf_names;
-  for (const auto & joint_name : params_.left_wheel_names)
+  const auto add_joint_interfaces = [this, &conf_names](const std::string & joint_name)
   {
     conf_names.push_back(joint_name + "/" + feedback_type());
+    if (use_encoder_samples())
+    {
+      conf_names.push_back(joint_name + "/" + ENCODER_SAMPLE_COUNT_INTERFACE);
+      for (size_t i = 0; i < static_cast<size_t>(params_.encoder_samples_per_cycle); ++i)
+      {
+        conf_names.push_back(joint_name + "/" + encoder_sample_interface(i));
+        conf_names.push_back(joint_name + "/" + encoder_sample_time_interface(i));
+      }
+    }
+  };
+  for (const auto & joint_name : params_.left_wheel_names)
+  {
+    add_joint_interfaces(joint_name);
   }
   for (const auto & joint_name : params_.right_wheel_names)
   {
-    conf_names.push_back(joint_name + "/" + feedback_type());
+    add_joint_interfaces(joint_name);
+  }
+  if (params_.imu_heading.enable)
+  {
+    conf_names.push_back(params_.imu_heading.sensor_name + "/" + IMU_YAW_RATE_INTERFACE);
   }
   return {interface_configuration_type::INDIVIDUAL, conf_names};
 }
 
-controller_interface::return_type DiffDriveController::update(
+std::vector<hardware_interface::CommandInterface>
+DiffDriveController::on_export_reference_interfaces()
+{
+  reference_interfaces_.resize(2, std::numeric_limits<double>::quiet_NaN());
+
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.reserve(reference_interfaces_.size());
+  reference_interfaces.push_back(hardware_interface::CommandInterface(
+    get_node()->get_name(), std::string("linear/") + HW_IF_VELOCITY, &reference_interfaces_[0]));
+  reference_interfaces.push_back(hardware_interface::CommandInterface(
+    get_node()->get_name(), std::string("angular/") + HW_IF_VELOCITY, &reference_interfaces_[1]));
+  return reference_interfaces;
+}
+
+std::vector<hardware_interface::StateInterface> DiffDriveController::on_export_state_interfaces()
+{
+  state_interfaces_values_.resize(ODOMETRY_STATE_INTERFACES.size(), 0.0);
+
+  std::vector<hardware_interface::StateInterface> state_interfaces;
+  state_interfaces.reserve(state_interfaces_values_.size());
+  for (size_t i = 0; i < ODOMETRY_STATE_INTERFACES.size(); ++i)
+  {
+    state_interfaces.push_back(hardware_interface::StateInterface(
+      get_node()->get_name(), ODOMETRY_STATE_INTERFACES[i], &state_interfaces_values_[i]));
+  }
+  return state_interfaces;
+}
+
+bool DiffDriveController::on_set_chained_mode(bool /*chained_mode*/)
+{
+  // Always accept switch to/from chained mode
+  return true;
+}
+
+controller_interface::return_type DiffDriveController::update_reference_from_subscribers(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+{
+  if (!received_velocity_msg_)
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(), "No velocity message buffer, the controller is not configured.");
+    return controller_interface::return_type::ERROR;
+  }
+
+  if (command_jitter_buffer_)
+  {
+    // the commands are played out the delay after their stamps, which the timeout applies to
+    const int64_t now_ns = time.nanoseconds();
+    if (
+      command_jitter_buffer_->play_out(now_ns) &&
+      std::chrono::nanoseconds(
+        now_ns - command_jitter_buffer_->delay() - command_jitter_buffer_->stamp()) <=
+        cmd_vel_timeout_)
+    {
+      reference_interfaces_[0] = command_jitter_buffer_->value().linear.x;
+      reference_interfaces_[1] = command_jitter_buffer_->value().angular.z;
+    }
+    else
+    {
+      reference_interfaces_[0] = 0.0;
+      reference_interfaces_[1] = 0.0;
+    }
+    return controller_interface::return_type::OK;
+  }
+
+  // the received twist command itself is kept, the reference may be limited further
+  const Twist & command = received_velocity_msg_->read();
+  CONTROLLER_TRACEPOINT(REFERENCE_RECEIVED, this, 0);
+  const auto age_of_last_command = time - command.header.stamp;
+  // Brake if cmd_vel has timeout
+  if (age_of_last_command > cmd_vel_timeout_)
+  {
+    reference_interfaces_[0] = 0.0;
+    reference_interfaces_[1] = 0.0;
+  }
+  else
+  {
+    reference_interfaces_[0] = command.twist.linear.x;
+    reference_interfaces_[1] = command.twist.angular.z;
+  }
+  return controller_interface::return_type::OK;
+}
+
+controller_interface::return_type DiffDriveController::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
   auto logger = get_node()->get_logger();
@@ -111,64 +261,90 @@ controller_interface::return_type DiffDriveController::update(
     }
     return controller_interface::return_type::OK;
   }
+  controller_realtime_tools::CycleBudget::Scope cycle_budget_scope(cycle_budget_.get());
 
-  std::shared_ptr<Twist> last_command_msg;
-  received_velocity_msg_ptr_.get(last_command_msg);
-
-  if (last_command_msg == nullptr)
+  if (input_recorder_)
   {
-    RCLCPP_WARN(logger, "Velocity message received was a nullptr.");
-    return controller_interface::return_type::ERROR;
+    input_recorder_->record(
+      time.nanoseconds(), period.nanoseconds(), state_interfaces_, reference_interfaces_);
   }
 
-  const auto age_of_last_command = time - last_command_msg->header.stamp;
-  // Brake if cmd_vel has timeout, override the stored command
-  if (age_of_last_command > cmd_vel_timeout_)
+  // take over the parameters changed while active
+  if (runtime_parameters_->update())
   {
-    last_command_msg->twist.linear.x = 0.0;
-    last_command_msg->twist.angular.z = 0.0;
+    use_runtime_parameters();
   }
 
-  // command may be limited further by SpeedLimit,
-  // without affecting the stored twist command
-  Twist command = *last_command_msg;
-  double & linear_command = command.twist.linear.x;
-  double & angular_command = command.twist.angular.z;
+  // Brake without a reference, i.e. if the preceding controller didn't write one this cycle
+  double linear_command = reference_interfaces_[0];
+  double angular_command = reference_interfaces_[1];
+  if (std::isnan(linear_command) || std::isnan(angular_command))
+  {
+    linear_command = 0.0;
+    angular_command = 0.0;
+  }
 
   previous_update_timestamp_ = time;
 
-  // Apply (possibly new) multipliers:
-  const double wheel_separation = params_.wheel_separation_multiplier * params_.wheel_separation;
-  const double left_wheel_radius = params_.left_wheel_radius_multiplier * params_.wheel_radius;
-  const double right_wheel_radius = params_.right_wheel_radius_multiplier * params_.wheel_radius;
+  const WheelKinematics & kinematics = wheel_kinematics_;
+
+  if (imu_yaw_rate_)
+  {
+    odometry_.setImuAngularVelocity(imu_yaw_rate_->get_value());
+  }
 
   if (params_.open_loop)
   {
     odometry_.updateOpenLoop(linear_command, angular_command, time);
   }
+  else if (use_encoder_samples())
+  {
+    if (!update_odometry_from_encoder_samples())
+    {
+      return controller_interface::return_type::ERROR;
+    }
+  }
   else
   {
-    double left_feedback_mean = 0.0;
-    double right_feedback_mean = 0.0;
-    for (size_t index = 0; index < static_cast<size_t>(params_.wheels_per_side); ++index)
+    const auto wheels_per_side = static_cast<size_t>(params_.wheels_per_side);
+    double left_feedback_sum = 0.0;
+    double right_feedback_sum = 0.0;
+    for (size_t index = 0; index < wheels_per_side; ++index)
     {
-      const double left_feedback = registered_left_wheel_handles_[index].feedback.get().get_value();
-      const double right_feedback =
-        registered_right_wheel_handles_[index].feedback.get().get_value();
+      left_feedbacks_[index] = registered_left_wheel_handles_[index].feedback.get().get_value();
+      right_feedbacks_[index] = registered_right_wheel_handles_[index].feedback.get().get_value();
+      left_feedback_sum += left_feedbacks_[index];
+      right_feedback_sum += right_feedbacks_[index];
+    }
 
-      if (std::isnan(left_feedback) || std::isnan(right_feedback))
+    // a NaN feedback makes its sum NaN, only look for it then
+    if (std::isnan(left_feedback_sum) || std::isnan(right_feedback_sum))
+    {
+      size_t index = 0;
+      while (!std::isnan(left_feedbacks_[index]) && !std::isnan(right_feedbacks_[index]))
       {
-        RCLCPP_ERROR(
-          logger, "Either the left or right wheel %s is invalid for index [%zu]", feedback_type(),
-          index);
-        return controller_interface::return_type::ERROR;
+        ++index;
       }
+      RCLCPP_ERROR(
+        logger, "Either the left or right wheel %s is invalid for index [%zu]", feedback_type(),
+        index);
+      return controller_interface::return_type::ERROR;
+    }
 
-      left_feedback_mean += left_feedback;
-      right_feedback_mean += right_feedback;
+    double left_feedback_mean = left_feedback_sum / static_cast<double>(wheels_per_side);
+    double right_feedback_mean = right_feedback_sum / static_cast<double>(wheels_per_side);
+    if (params_.wheel_slip_detection.enable && params_.position_feedback)
+    {
+      left_feedback_mean =
+        left_slip_detector_.fusePositions(left_feedbacks_.data(), period.seconds());
+      right_feedback_mean =
+        right_slip_detector_.fusePositions(right_feedbacks_.data(), period.seconds());
+    }
+    else if (params_.wheel_slip_detection.enable)
+    {
+      left_feedback_mean = left_slip_detector_.fuseVelocities(left_feedbacks_.data());
+      right_feedback_mean = right_slip_detector_.fuseVelocities(right_feedbacks_.data());
     }
-    left_feedback_mean /= static_cast<double>(params_.wheels_per_side);
-    right_feedback_mean /= static_cast<double>(params_.wheels_per_side);
 
     if (params_.position_feedback)
     {
@@ -177,85 +353,54 @@ controller_interface::return_type DiffDriveController::update(
     else
     {
       odometry_.updateFromVelocity(
-        left_feedback_mean * left_wheel_radius * period.seconds(),
-        right_feedback_mean * right_wheel_radius * period.seconds(), time);
-    }
-  }
-
-  tf2::Quaternion orientation;
-  orientation.setRPY(0.0, 0.0, odometry_.getHeading());
-
-  bool should_publish = false;
-  try
-  {
-    if (previous_publish_timestamp_ + publish_period_ < time)
-    {
-      previous_publish_timestamp_ += publish_period_;
-      should_publish = true;
+        left_feedback_mean * kinematics.left_wheel_radius * period.seconds(),
+        right_feedback_mean * kinematics.right_wheel_radius * period.seconds(), time);
     }
   }
-  catch (const std::runtime_error &)
+  CONTROLLER_TRACEPOINT(ODOMETRY_INTEGRATED, this, time.nanoseconds());
+
+  controller_realtime_tools::OdometrySnapshot odometry_snapshot;
+  odometry_snapshot.stamp_nanoseconds = time.nanoseconds();
+  odometry_snapshot.x = odometry_.getX();
+  odometry_snapshot.y = odometry_.getY();
+  odometry_snapshot.heading = odometry_.getHeading();
+  odometry_snapshot.linear = odometry_.getLinear();
+  odometry_snapshot.angular = odometry_.getAngular();
+  odometry_snapshot.has_pose_covariance = params_.pose_covariance_propagation.enable;
+  if (odometry_snapshot.has_pose_covariance)
   {
-    // Handle exceptions when the time source changes and initialize publish timestamp
-    previous_publish_timestamp_ = time;
-    should_publish = true;
+    odometry_snapshot.pose_covariance = odometry_.getPoseCovariance();
   }
+  odometry_snapshot_publisher_->update(odometry_snapshot);
+  // read by the following controllers in the same cycle
+  state_interfaces_values_[0] = odometry_snapshot.x;
+  state_interfaces_values_[1] = odometry_snapshot.y;
+  state_interfaces_values_[2] = odometry_snapshot.heading;
+  state_interfaces_values_[3] = odometry_snapshot.linear;
+  state_interfaces_values_[4] = odometry_snapshot.angular;
 
-  if (should_publish)
-  {
-    if (realtime_odometry_publisher_->trylock())
-    {
-      auto & odometry_message = realtime_odometry_publisher_->msg_;
-      odometry_message.header.stamp = time;
-      odometry_message.pose.pose.position.x = odometry_.getX();
-      odometry_message.pose.pose.position.y = odometry_.getY();
-      odometry_message.pose.pose.orientation.x = orientation.x();
-      odometry_message.pose.pose.orientation.y = orientation.y();
-      odometry_message.pose.pose.orientation.z = orientation.z();
-      odometry_message.pose.pose.orientation.w = orientation.w();
-      odometry_message.twist.twist.linear.x = odometry_.getLinear();
-      odometry_message.twist.twist.angular.z = odometry_.getAngular();
-      realtime_odometry_publisher_->unlockAndPublish();
-    }
+  limiter_linear_.limit(linear_command, previous_linear_commands_, period.seconds());
+  limiter_angular_.limit(angular_command, previous_angular_commands_, period.seconds());
 
-    if (params_.enable_odom_tf && realtime_odometry_transform_publisher_->trylock())
-    {
-      auto & transform = realtime_odometry_transform_publisher_->msg_.transforms.front();
-      transform.header.stamp = time;
-      transform.transform.translation.x = odometry_.getX();
-      transform.transform.translation.y = odometry_.getY();
-      transform.transform.rotation.x = orientation.x();
-      transform.transform.rotation.y = orientation.y();
-      transform.transform.rotation.z = orientation.z();
-      transform.transform.rotation.w = orientation.w();
-      realtime_odometry_transform_publisher_->unlockAndPublish();
-    }
-  }
-
-  auto & last_command = previous_commands_.back().twist;
-  auto & second_to_last_command = previous_commands_.front().twist;
-  limiter_linear_.limit(
-    linear_command, last_command.linear.x, second_to_last_command.linear.x, period.seconds());
-  limiter_angular_.limit(
-    angular_command, last_command.angular.z, second_to_last_command.angular.z, period.seconds());
-
-  previous_commands_.pop();
-  previous_commands_.emplace(command);
+  previous_linear_commands_.push(linear_command);
+  previous_angular_commands_.push(angular_command);
 
   //    Publish limited velocity
-  if (publish_limited_velocity_ && realtime_limited_velocity_publisher_->trylock())
+  if (publish_limited_velocity_ && !(cycle_budget_ && cycle_budget_->skip(SHED_LIMITED_VELOCITY)))
   {
-    auto & limited_velocity_command = realtime_limited_velocity_publisher_->msg_;
-    limited_velocity_command.header.stamp = time;
-    limited_velocity_command.twist = command.twist;
-    realtime_limited_velocity_publisher_->unlockAndPublish();
+    limited_velocity_msg_.header.stamp = time;
+    limited_velocity_msg_.twist.linear.x = linear_command;
+    limited_velocity_msg_.twist.angular.z = angular_command;
+    realtime_limited_velocity_publisher_->try_publish(limited_velocity_msg_);
   }
 
   // Compute wheels velocities:
   const double velocity_left =
-    (linear_command - angular_command * wheel_separation / 2.0) / left_wheel_radius;
+    (linear_command - angular_command * kinematics.half_wheel_separation) *
+    kinematics.inverse_left_wheel_radius;
   const double velocity_right =
-    (linear_command + angular_command * wheel_separation / 2.0) / right_wheel_radius;
+    (linear_command + angular_command * kinematics.half_wheel_separation) *
+    kinematics.inverse_right_wheel_radius;
 
   // Set wheels velocities:
   for (size_t index = 0; index < static_cast<size_t>(params_.wheels_per_side); ++index)
@@ -263,6 +408,19 @@ controller_interface::return_type DiffDriveController::update(
     registered_left_wheel_handles_[index].velocity.get().set_value(velocity_left);
     registered_right_wheel_handles_[index].velocity.get().set_value(velocity_right);
   }
+  if (command_sequence_)
+  {
+    write_command_sequences();
+  }
+  // the references of a preceding controller don't come from the subscribers
+  if (command_latency_ && !is_in_chained_mode())
+  {
+    command_latency_->command_written(time.nanoseconds());
+  }
+
+  // the reference of a preceding controller is only used in the cycle it was written
+  reference_interfaces_[0] = std::numeric_limits<double>::quiet_NaN();
+  reference_interfaces_[1] = std::numeric_limits<double>::quiet_NaN();
 
   return controller_interface::return_type::OK;
 }
@@ -293,58 +451,111 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  const double wheel_separation = params_.wheel_separation_multiplier * params_.wheel_separation;
-  const double left_wheel_radius = params_.left_wheel_radius_multiplier * params_.wheel_radius;
-  const double right_wheel_radius = params_.right_wheel_radius_multiplier * params_.wheel_radius;
+  if (params_.imu_heading.enable && params_.imu_heading.sensor_name.empty())
+  {
+    RCLCPP_ERROR(logger, "'imu_heading.sensor_name' is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  if (params_.input_recording.enable && params_.input_recording.path.empty())
+  {
+    RCLCPP_ERROR(logger, "'input_recording.path' is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  if (params_.cmd_vel_qos.intra_process && params_.cmd_vel_qos.history != "keep_last")
+  {
+    RCLCPP_ERROR(logger, "Intra-process communication of 'cmd_vel' requires the keep_last history");
+    return controller_interface::CallbackReturn::ERROR;
+  }
 
-  odometry_.setWheelParams(wheel_separation, left_wheel_radius, right_wheel_radius);
   odometry_.setVelocityRollingWindowSize(params_.velocity_rolling_window_size);
+  controller_realtime_tools::SmoothingMode velocity_smoothing_mode;
+  controller_realtime_tools::smoothing_mode_from_string(
+    params_.velocity_smoothing, velocity_smoothing_mode);
+  odometry_.setVelocitySmoothingMode(velocity_smoothing_mode);
+  odometry_.setPoseCovarianceParams(
+    params_.pose_covariance_propagation.enable, params_.pose_covariance_diagonal[0],
+    params_.pose_covariance_diagonal[1], params_.pose_covariance_diagonal[5],
+    params_.pose_covariance_propagation.linear_noise,
+    params_.pose_covariance_propagation.angular_noise);
+  odometry_.setImuWeight(params_.imu_heading.enable ? params_.imu_heading.gyro_weight : 0.0);
+  const auto max_encoder_samples = static_cast<size_t>(params_.encoder_samples_per_cycle);
+  left_encoder_samples_.assign(max_encoder_samples, 0.0);
+  right_encoder_samples_.assign(max_encoder_samples, 0.0);
+  encoder_sample_times_.assign(max_encoder_samples, 0.0);
 
-  cmd_vel_timeout_ = std::chrono::milliseconds{static_cast<int>(params_.cmd_vel_timeout * 1000.0)};
   publish_limited_velocity_ = params_.publish_limited_velocity;
   use_stamped_vel_ = params_.use_stamped_vel;
 
-  limiter_linear_ = SpeedLimiter(
-    params_.linear.x.has_velocity_limits, params_.linear.x.has_acceleration_limits,
-    params_.linear.x.has_jerk_limits, params_.linear.x.min_velocity, params_.linear.x.max_velocity,
-    params_.linear.x.min_acceleration, params_.linear.x.max_acceleration, params_.linear.x.min_jerk,
-    params_.linear.x.max_jerk);
-
-  limiter_angular_ = SpeedLimiter(
-    params_.angular.z.has_velocity_limits, params_.angular.z.has_acceleration_limits,
-    params_.angular.z.has_jerk_limits, params_.angular.z.min_velocity,
-    params_.angular.z.max_velocity, params_.angular.z.min_acceleration,
-    params_.angular.z.max_acceleration, params_.angular.z.min_jerk, params_.angular.z.max_jerk);
-
   if (!reset())
   {
     return controller_interface::CallbackReturn::ERROR;
   }
 
+  // the timer publishes the parameters changed from now on, see publish_parameters_update()
+  {
+    std::lock_guard<std::mutex> guard(parameters_mutex_);
+    runtime_params_ = params_;
+    runtime_parameters_ =
+      std::make_unique<controller_realtime_tools::ParameterSnapshot<RuntimeParameters>>(
+        std::make_unique<const RuntimeParameters>(make_runtime_parameters(params_)));
+  }
+  use_runtime_parameters();
+  parameter_update_timer_ = get_node()->create_wall_timer(
+    std::chrono::milliseconds(100), [this]() { publish_parameters_update(); });
+
   // left and right sides are both equal at this point
   params_.wheels_per_side = params_.left_wheel_names.size();
+  const auto wheels_per_side = static_cast<size_t>(params_.wheels_per_side);
+  left_feedbacks_.assign(wheels_per_side, 0.0);
+  right_feedbacks_.assign(wheels_per_side, 0.0);
+  left_slip_detector_.configure(wheels_per_side, params_.wheel_slip_detection.threshold);
+  right_slip_detector_.configure(wheels_per_side, params_.wheel_slip_detection.threshold);
 
   if (publish_limited_velocity_)
   {
     limited_velocity_publisher_ =
       get_node()->create_publisher<Twist>(DEFAULT_COMMAND_OUT_TOPIC, rclcpp::SystemDefaultsQoS());
-    realtime_limited_velocity_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<Twist>>(limited_velocity_publisher_);
+    realtime_limited_velocity_publisher_ = std::make_shared<LimitedVelocityPublisher>(
+      limited_velocity_publisher_, limited_velocity_msg_);
   }
 
+  // before exporting them, so update() also works if they are never claimed
+  reference_interfaces_.resize(2, std::numeric_limits<double>::quiet_NaN());
+  state_interfaces_values_.resize(ODOMETRY_STATE_INTERFACES.size(), 0.0);
+
   const Twist empty_twist;
-  received_velocity_msg_ptr_.set(std::make_shared<Twist>(empty_twist));
+  received_velocity_msg_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<Twist>>(empty_twist);
+
+  // Fill last commands with zero commands
+  previous_linear_commands_.fill(0.0);
+  previous_angular_commands_.fill(0.0);
 
-  // Fill last two commands with default constructed commands
-  previous_commands_.emplace(empty_twist);
-  previous_commands_.emplace(empty_twist);
+  if (params_.jitter_buffer.enable)
+  {
+    command_jitter_buffer_ = std::make_unique<CommandJitterBuffer>();
+    command_jitter_buffer_->set_delay(static_cast<int64_t>(params_.jitter_buffer.delay * 1e9));
+  }
+  else
+  {
+    command_jitter_buffer_.reset();
+  }
 
-  // initialize command subscriber
+  // initialize command subscriber, which takes ownership of the messages to move them into the
+  // buffer, without a copy if they are passed within the process
+  const auto subscriber_qos = command_qos(params_.cmd_vel_qos.history, params_.cmd_vel_qos.depth);
+  rclcpp::SubscriptionOptions subscriber_options;
+  if (params_.cmd_vel_qos.intra_process)
+  {
+    subscriber_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+  }
   if (use_stamped_vel_)
   {
     velocity_command_subscriber_ = get_node()->create_subscription<Twist>(
-      DEFAULT_COMMAND_TOPIC, rclcpp::SystemDefaultsQoS(),
-      [this](const std::shared_ptr<Twist> msg) -> void
+      DEFAULT_COMMAND_TOPIC, subscriber_qos,
+      [this](std::unique_ptr<Twist> msg) -> void
       {
         if (!subscriber_is_active_)
         {
@@ -352,23 +563,35 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
             get_node()->get_logger(), "Can't accept new commands. subscriber is inactive");
           return;
         }
+        const rclcpp::Time now = get_node()->get_clock()->now();
+        const int64_t stamp_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
         if ((msg->header.stamp.sec == 0) && (msg->header.stamp.nanosec == 0))
         {
           RCLCPP_WARN_ONCE(
             get_node()->get_logger(),
             "Received TwistStamped with zero timestamp, setting it to current "
             "time, this message will only be shown once");
-          msg->header.stamp = get_node()->get_clock()->now();
+          msg->header.stamp = now;
         }
-        received_velocity_msg_ptr_.set(std::move(msg));
-      });
+        if (command_jitter_buffer_)
+        {
+          command_jitter_buffer_->push(rclcpp::Time(msg->header.stamp).nanoseconds(), msg->twist);
+        }
+        received_velocity_msg_->write_buffer() = std::move(*msg);
+        received_velocity_msg_->publish();
+        if (command_latency_)
+        {
+          command_latency_->command_received(stamp_ns, now.nanoseconds());
+        }
+      },
+      subscriber_options);
   }
   else
   {
     velocity_command_unstamped_subscriber_ =
       get_node()->create_subscription<geometry_msgs::msg::Twist>(
-        DEFAULT_COMMAND_UNSTAMPED_TOPIC, rclcpp::SystemDefaultsQoS(),
-        [this](const std::shared_ptr<geometry_msgs::msg::Twist> msg) -> void
+        DEFAULT_COMMAND_UNSTAMPED_TOPIC, subscriber_qos,
+        [this](std::unique_ptr<geometry_msgs::msg::Twist> msg) -> void
         {
           if (!subscriber_is_active_)
           {
@@ -377,20 +600,28 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
             return;
           }
 
-          // Write fake header in the stored stamped command
-          std::shared_ptr<Twist> twist_stamped;
-          received_velocity_msg_ptr_.get(twist_stamped);
-          twist_stamped->twist = *msg;
-          twist_stamped->header.stamp = get_node()->get_clock()->now();
-        });
+          // Write fake header in the stamped command
+          auto & twist_stamped = received_velocity_msg_->write_buffer();
+          twist_stamped.twist = *msg;
+          twist_stamped.header.stamp = get_node()->get_clock()->now();
+          const int64_t receive_ns = rclcpp::Time(twist_stamped.header.stamp).nanoseconds();
+          received_velocity_msg_->publish();
+          // without a stamp, the commands are played out the delay after their arrival
+          if (command_jitter_buffer_)
+          {
+            command_jitter_buffer_->push(receive_ns, *msg);
+          }
+          if (command_latency_)
+          {
+            command_latency_->command_received(0, receive_ns);
+          }
+        },
+        subscriber_options);
   }
 
   // initialize odometry publisher and messasge
   odometry_publisher_ = get_node()->create_publisher<nav_msgs::msg::Odometry>(
     DEFAULT_ODOMETRY_TOPIC, rclcpp::SystemDefaultsQoS());
-  realtime_odometry_publisher_ =
-    std::make_shared<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(
-      odometry_publisher_);
 
   std::string controller_namespace = std::string(get_node()->get_namespace());
 
@@ -406,14 +637,10 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
   const auto odom_frame_id = controller_namespace + params_.odom_frame_id;
   const auto base_frame_id = controller_namespace + params_.base_frame_id;
 
-  auto & odometry_message = realtime_odometry_publisher_->msg_;
+  nav_msgs::msg::Odometry odometry_message;
   odometry_message.header.frame_id = controller_namespace + odom_frame_id;
   odometry_message.child_frame_id = controller_namespace + base_frame_id;
 
-  // limit the publication on the topics /odom and /tf
-  publish_rate_ = params_.publish_rate;
-  publish_period_ = rclcpp::Duration::from_seconds(1.0 / publish_rate_);
-
   // initialize odom values zeros
   odometry_message.twist =
     geometry_msgs::msg::TwistWithCovariance(rosidl_runtime_cpp::MessageInitialization::ALL);
@@ -430,16 +657,59 @@ controller_interface::CallbackReturn DiffDriveController::on_configure(
   // initialize transform publisher and message
   odometry_transform_publisher_ = get_node()->create_publisher<tf2_msgs::msg::TFMessage>(
     DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
-  realtime_odometry_transform_publisher_ =
-    std::make_shared<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
-      odometry_transform_publisher_);
 
   // keeping track of odom and base_link transforms only
-  auto & odometry_transform_message = realtime_odometry_transform_publisher_->msg_;
+  tf2_msgs::msg::TFMessage odometry_transform_message;
   odometry_transform_message.transforms.resize(1);
   odometry_transform_message.transforms.front().header.frame_id = odom_frame_id;
   odometry_transform_message.transforms.front().child_frame_id = base_frame_id;
 
+  // limit the publication on the topics /odom and /tf, built off the realtime thread
+  odometry_snapshot_publisher_ = std::make_unique<OdometrySnapshotPublisher>(
+    odometry_publisher_, odometry_message,
+    params_.enable_odom_tf ? odometry_transform_publisher_ : nullptr, odometry_transform_message,
+    std::chrono::nanoseconds(static_cast<int64_t>(1e9 / params_.publish_rate)));
+
+  if (params_.command_latency.enable)
+  {
+    command_latency_ = std::make_unique<controller_realtime_tools::LatencyProbe>();
+    command_latency_publisher_ =
+      get_node()->create_publisher<statistics_msgs::msg::MetricsMessage>(
+        "~/command_latency", rclcpp::SystemDefaultsQoS());
+    command_latency_window_start_ = get_node()->now();
+    command_latency_timer_ = get_node()->create_wall_timer(
+      std::chrono::duration<double>(1.0 / params_.command_latency.publish_rate),
+      [this]() { publish_command_latency(); });
+  }
+
+  if (params_.command_sequence_interfaces)
+  {
+    command_sequence_ = std::make_unique<controller_realtime_tools::CommandSequence>();
+    command_sequence_->reset(params_.left_wheel_names.size() + params_.right_wheel_names.size());
+  }
+  else
+  {
+    command_sequence_.reset();
+  }
+
+  if (params_.cycle_budget.enable)
+  {
+    cycle_budget_ = std::make_unique<controller_realtime_tools::CycleBudget>(
+      std::chrono::nanoseconds(static_cast<int64_t>(params_.cycle_budget.update_time * 1e9)),
+      static_cast<uint32_t>(params_.cycle_budget.recovery_cycles),
+      std::vector<std::string>{"limited_velocity"});
+    cycle_budget_timer_ = get_node()->create_wall_timer(
+      std::chrono::seconds(1),
+      [this]()
+      {
+        const auto report = cycle_budget_->get_report();
+        if (!report.empty())
+        {
+          RCLCPP_WARN(get_node()->get_logger(), "%s", report.c_str());
+        }
+      });
+  }
+
   previous_update_timestamp_ = get_node()->get_clock()->now();
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -466,6 +736,63 @@ controller_interface::CallbackReturn DiffDriveController::on_activate(
       "Either left wheel interfaces, right wheel interfaces are non existent");
     return controller_interface::CallbackReturn::ERROR;
   }
+  if (command_sequence_)
+  {
+    command_sequence_->restart();
+  }
+
+  imu_yaw_rate_ = nullptr;
+  if (params_.imu_heading.enable)
+  {
+    const auto imu_handle = std::find_if(
+      state_interfaces_.cbegin(), state_interfaces_.cend(),
+      [this](const auto & interface)
+      {
+        return interface.get_prefix_name() == params_.imu_heading.sensor_name &&
+               interface.get_interface_name() == IMU_YAW_RATE_INTERFACE;
+      });
+    if (imu_handle == state_interfaces_.cend())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Unable to obtain the yaw rate handle of the IMU %s",
+        params_.imu_heading.sensor_name.c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    imu_yaw_rate_ = &*imu_handle;
+  }
+
+  if (params_.input_recording.enable)
+  {
+    std::vector<std::string> state_names;
+    for (const auto & interface : state_interfaces_)
+    {
+      state_names.push_back(interface.get_name());
+    }
+    input_recorder_ = std::make_unique<controller_realtime_tools::InputRecorder>(
+      params_.input_recording.path, state_names, reference_interfaces_.size(),
+      static_cast<size_t>(params_.input_recording.capacity));
+    if (!input_recorder_->good())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Unable to record the inputs to '%s'",
+        params_.input_recording.path.c_str());
+      input_recorder_.reset();
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
+
+  std::fill(
+    reference_interfaces_.begin(), reference_interfaces_.end(),
+    std::numeric_limits<double>::quiet_NaN());
+
+  // the fused positions start again from the current wheel positions
+  left_slip_detector_.reset();
+  right_slip_detector_.reset();
+
+  if (command_jitter_buffer_)
+  {
+    command_jitter_buffer_->reset();
+  }
 
   is_halted = false;
   subscriber_is_active_ = true;
@@ -485,6 +812,9 @@ controller_interface::CallbackReturn DiffDriveController::on_deactivate(
   }
   registered_left_wheel_handles_.clear();
   registered_right_wheel_handles_.clear();
+  imu_yaw_rate_ = nullptr;
+  // writes the inputs left
+  input_recorder_.reset();
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -496,7 +826,8 @@ controller_interface::CallbackReturn DiffDriveController::on_cleanup(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  received_velocity_msg_ptr_.set(std::make_shared<Twist>());
+  received_velocity_msg_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<Twist>>(Twist());
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -512,10 +843,10 @@ controller_interface::CallbackReturn DiffDriveController::on_error(const rclcpp_
 bool DiffDriveController::reset()
 {
   odometry_.resetOdometry();
+  std::fill(state_interfaces_values_.begin(), state_interfaces_values_.end(), 0.0);
 
-  // release the old queue
-  std::queue<Twist> empty;
-  std::swap(previous_commands_, empty);
+  previous_linear_commands_.clear();
+  previous_angular_commands_.clear();
 
   registered_left_wheel_handles_.clear();
   registered_right_wheel_handles_.clear();
@@ -524,7 +855,15 @@ bool DiffDriveController::reset()
   velocity_command_subscriber_.reset();
   velocity_command_unstamped_subscriber_.reset();
 
-  received_velocity_msg_ptr_.set(nullptr);
+  received_velocity_msg_.reset();
+  command_jitter_buffer_.reset();
+  odometry_snapshot_publisher_.reset();
+  parameter_update_timer_.reset();
+  command_latency_timer_.reset();
+  command_latency_publisher_.reset();
+  command_latency_.reset();
+  cycle_budget_timer_.reset();
+  cycle_budget_.reset();
   is_halted = false;
   return true;
 }
@@ -535,6 +874,41 @@ controller_interface::CallbackReturn DiffDriveController::on_shutdown(
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
+void DiffDriveController::publish_command_latency()
+{
+  using controller_realtime_tools::LatencyProbe;
+  const rclcpp::Time now = get_node()->now();
+  const auto statistics = command_latency_->get_statistics();
+  for (size_t stage = 0; stage < LatencyProbe::NUM_STAGES; ++stage)
+  {
+    statistics_msgs::msg::MetricsMessage msg;
+    msg.measurement_source_name = get_node()->get_name();
+    msg.metrics_source = LatencyProbe::STAGE_NAMES[stage];
+    msg.window_start = command_latency_window_start_;
+    msg.window_stop = now;
+    controller_realtime_tools::fill_metrics<statistics_msgs::msg::StatisticDataType>(
+      statistics[stage], msg);
+    command_latency_publisher_->publish(msg);
+  }
+  command_latency_window_start_ = now;
+}
+
+void DiffDriveController::write_command_sequences()
+{
+  size_t index = 0;
+  const auto write_sequences = [this, &index](const auto & wheel_handles)
+  {
+    for (const auto & wheel_handle : wheel_handles)
+    {
+      wheel_handle.velocity_sequence->set_value(
+        command_sequence_->update(index++, wheel_handle.velocity.get().get_value()));
+    }
+  };
+
+  write_sequences(registered_left_wheel_handles_);
+  write_sequences(registered_right_wheel_handles_);
+}
+
 void DiffDriveController::halt()
 {
   const auto halt_wheels = [](auto & wheel_handles)
@@ -561,18 +935,23 @@ controller_interface::CallbackReturn DiffDriveController::configure_side(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  // register handles
-  registered_handles.reserve(wheel_names.size());
-  for (const auto & wheel_name : wheel_names)
+  const auto find_state_handle =
+    [this](const std::string & wheel_name, const std::string & interface_name)
   {
-    const auto interface_name = feedback_type();
-    const auto state_handle = std::find_if(
+    return std::find_if(
       state_interfaces_.cbegin(), state_interfaces_.cend(),
       [&wheel_name, &interface_name](const auto & interface)
       {
         return interface.get_prefix_name() == wheel_name &&
                interface.get_interface_name() == interface_name;
       });
+  };
+
+  // register handles
+  registered_handles.reserve(wheel_names.size());
+  for (const auto & wheel_name : wheel_names)
+  {
+    const auto state_handle = find_state_handle(wheel_name, feedback_type());
 
     if (state_handle == state_interfaces_.cend())
     {
@@ -594,15 +973,174 @@ controller_interface::CallbackReturn DiffDriveController::configure_side(
       return controller_interface::CallbackReturn::ERROR;
     }
 
-    registered_handles.emplace_back(
-      WheelHandle{std::ref(*state_handle), std::ref(*command_handle)});
+    WheelHandle handle{std::ref(*state_handle), std::ref(*command_handle)};
+    if (command_sequence_)
+    {
+      const auto sequence_name =
+        controller_realtime_tools::CommandSequence::interface_name(HW_IF_VELOCITY);
+      const auto sequence_handle = std::find_if(
+        command_interfaces_.begin(), command_interfaces_.end(),
+        [&wheel_name, &sequence_name](const auto & interface)
+        {
+          return interface.get_prefix_name() == wheel_name &&
+                 interface.get_interface_name() == sequence_name;
+        });
+      if (sequence_handle == command_interfaces_.end())
+      {
+        RCLCPP_ERROR(
+          logger, "Unable to obtain the command sequence handle for %s", wheel_name.c_str());
+        return controller_interface::CallbackReturn::ERROR;
+      }
+      handle.velocity_sequence = &(*sequence_handle);
+    }
+    if (use_encoder_samples())
+    {
+      const auto count_handle = find_state_handle(wheel_name, ENCODER_SAMPLE_COUNT_INTERFACE);
+      if (count_handle == state_interfaces_.cend())
+      {
+        RCLCPP_ERROR(
+          logger, "Unable to obtain encoder sample count handle for %s", wheel_name.c_str());
+        return controller_interface::CallbackReturn::ERROR;
+      }
+      handle.sample_count = &(*count_handle);
+      for (size_t i = 0; i < static_cast<size_t>(params_.encoder_samples_per_cycle); ++i)
+      {
+        const auto position_handle = find_state_handle(wheel_name, encoder_sample_interface(i));
+        const auto time_handle = find_state_handle(wheel_name, encoder_sample_time_interface(i));
+        if (position_handle == state_interfaces_.cend() || time_handle == state_interfaces_.cend())
+        {
+          RCLCPP_ERROR(
+            logger, "Unable to obtain encoder sample handles %zu for %s", i, wheel_name.c_str());
+          return controller_interface::CallbackReturn::ERROR;
+        }
+        handle.sample_positions.push_back(&(*position_handle));
+        handle.sample_times.push_back(&(*time_handle));
+      }
+    }
+    registered_handles.push_back(std::move(handle));
   }
 
   return controller_interface::CallbackReturn::SUCCESS;
 }
+
+DiffDriveController::RuntimeParameters DiffDriveController::make_runtime_parameters(
+  const Params & params)
+{
+  RuntimeParameters runtime;
+
+  // Apply the multipliers of the parameters:
+  WheelKinematics & kinematics = runtime.wheel_kinematics;
+  kinematics.wheel_separation = params.wheel_separation_multiplier * params.wheel_separation;
+  kinematics.left_wheel_radius = params.left_wheel_radius_multiplier * params.wheel_radius;
+  kinematics.right_wheel_radius = params.right_wheel_radius_multiplier * params.wheel_radius;
+  kinematics.half_wheel_separation = 0.5 * kinematics.wheel_separation;
+  kinematics.inverse_left_wheel_radius = 1.0 / kinematics.left_wheel_radius;
+  kinematics.inverse_right_wheel_radius = 1.0 / kinematics.right_wheel_radius;
+
+  runtime.cmd_vel_timeout =
+    std::chrono::milliseconds{static_cast<int>(params.cmd_vel_timeout * 1000.0)};
+
+  runtime.limiter_linear = SpeedLimiter(
+    params.linear.x.has_velocity_limits, params.linear.x.has_acceleration_limits,
+    params.linear.x.has_jerk_limits, params.linear.x.min_velocity, params.linear.x.max_velocity,
+    params.linear.x.min_acceleration, params.linear.x.max_acceleration, params.linear.x.min_jerk,
+    params.linear.x.max_jerk);
+
+  runtime.limiter_angular = SpeedLimiter(
+    params.angular.z.has_velocity_limits, params.angular.z.has_acceleration_limits,
+    params.angular.z.has_jerk_limits, params.angular.z.min_velocity, params.angular.z.max_velocity,
+    params.angular.z.min_acceleration, params.angular.z.max_acceleration, params.angular.z.min_jerk,
+    params.angular.z.max_jerk);
+
+  return runtime;
+}
+
+void DiffDriveController::publish_parameters_update()
+{
+  std::lock_guard<std::mutex> guard(parameters_mutex_);
+  if (!runtime_parameters_)
+  {
+    return;
+  }
+  // delete the parameters update() is done with
+  runtime_parameters_->reclaim();
+  if (!param_listener_->is_old(runtime_params_))
+  {
+    return;
+  }
+  runtime_params_ = param_listener_->get_params();
+  runtime_parameters_->publish(
+    std::make_unique<const RuntimeParameters>(make_runtime_parameters(runtime_params_)));
+}
+
+void DiffDriveController::use_runtime_parameters()
+{
+  const RuntimeParameters & runtime = runtime_parameters_->get();
+  wheel_kinematics_ = runtime.wheel_kinematics;
+  cmd_vel_timeout_ = runtime.cmd_vel_timeout;
+  limiter_linear_ = runtime.limiter_linear;
+  limiter_angular_ = runtime.limiter_angular;
+
+  // the odometry always uses the same kinematics as the wheel commands
+  odometry_.setWheelParams(
+    wheel_kinematics_.wheel_separation, wheel_kinematics_.left_wheel_radius,
+    wheel_kinematics_.right_wheel_radius);
+}
+
+bool DiffDriveController::update_odometry_from_encoder_samples()
+{
+  // only the samples all wheels provided, the sample times of the first left wheel are used
+  size_t count = left_encoder_samples_.size();
+  const auto limit_count = [&count](const WheelHandle & handle)
+  {
+    const double wheel_count = handle.sample_count->get_value();
+    count = wheel_count >= 0.0 ? std::min(count, static_cast<size_t>(wheel_count)) : 0;
+  };
+  std::for_each(
+    registered_left_wheel_handles_.cbegin(), registered_left_wheel_handles_.cend(), limit_count);
+  std::for_each(
+    registered_right_wheel_handles_.cbegin(), registered_right_wheel_handles_.cend(), limit_count);
+
+  const auto wheels_per_side = static_cast<size_t>(params_.wheels_per_side);
+  for (size_t i = 0; i < count; ++i)
+  {
+    double left_sample_mean = 0.0;
+    double right_sample_mean = 0.0;
+    for (size_t index = 0; index < wheels_per_side; ++index)
+    {
+      left_sample_mean += registered_left_wheel_handles_[index].sample_positions[i]->get_value();
+      right_sample_mean += registered_right_wheel_handles_[index].sample_positions[i]->get_value();
+    }
+    left_encoder_samples_[i] = left_sample_mean / static_cast<double>(wheels_per_side);
+    right_encoder_samples_[i] = right_sample_mean / static_cast<double>(wheels_per_side);
+    encoder_sample_times_[i] = registered_left_wheel_handles_[0].sample_times[i]->get_value();
+  }
+
+  // the samples are checked at once, and only searched for the invalid one then
+  if (
+    controller_realtime_tools::any_nan(left_encoder_samples_.data(), count) ||
+    controller_realtime_tools::any_nan(right_encoder_samples_.data(), count) ||
+    controller_realtime_tools::any_nan(encoder_sample_times_.data(), count))
+  {
+    size_t i = 0;
+    while (
+      !std::isnan(left_encoder_samples_[i]) && !std::isnan(right_encoder_samples_[i]) &&
+      !std::isnan(encoder_sample_times_[i]))
+    {
+      ++i;
+    }
+    RCLCPP_ERROR(get_node()->get_logger(), "Encoder sample %zu is invalid", i);
+    return false;
+  }
+
+  odometry_.updateFromSamples(
+    left_encoder_samples_.data(), right_encoder_samples_.data(), encoder_sample_times_.data(),
+    count);
+  return true;
+}
 }  // namespace diff_drive_controller
 
 #include "class_loader/register_macro.hpp"
 
 CLASS_LOADER_REGISTER_CLASS(
-  diff_drive_controller::DiffDriveController, controller_interface::ControllerInterface)
+  diff_drive_controller::DiffDriveController, controller_interface::ChainableControllerInterface)
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "diff_drive_controller/fleet_kinematics.hpp"
+
+#include <algorithm>
+
+#include "controller_realtime_tools/pose_integration.hpp"
+
+namespace diff_drive_controller
+{
+void FleetKinematics::configure(size_t num_robots, const Parameters & parameters)
+{
+  parameters_ = parameters;
+  // the divisions of the controller, precomputed the same way
+  half_wheel_separation_ = 0.5 * parameters.wheel_separation;
+  inverse_left_wheel_radius_ = 1.0 / parameters.left_wheel_radius;
+  inverse_right_wheel_radius_ = 1.0 / parameters.right_wheel_radius;
+
+  for (auto * values : {&x_, &y_, &heading_, &linear_, &angular_})
+  {
+    values->resize(num_robots);
+  }
+  for (size_t k = 0; k < SpeedLimiter::HISTORY_SIZE; ++k)
+  {
+    previous_linear_[k].resize(num_robots);
+    previous_angular_[k].resize(num_robots);
+  }
+  reset();
+}
+
+void FleetKinematics::reset()
+{
+  for (auto * values : {&x_, &y_, &heading_, &linear_, &angular_})
+  {
+    std::fill(values->begin(), values->end(), 0.0);
+  }
+  for (size_t k = 0; k < SpeedLimiter::HISTORY_SIZE; ++k)
+  {
+    std::fill(previous_linear_[k].begin(), previous_linear_[k].end(), 0.0);
+    std::fill(previous_angular_[k].begin(), previous_angular_[k].end(), 0.0);
+  }
+}
+
+void FleetKinematics::step(
+  const double * linear_commands, const double * angular_commands, double dt,
+  double * left_wheel_velocities, double * right_wheel_velocities, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    double linear_command = linear_commands[i];
+    double angular_command = angular_commands[i];
+    parameters_.limiter_linear.limit(
+      linear_command, previous_linear_[0][i], previous_linear_[1][i], dt);
+    parameters_.limiter_angular.limit(
+      angular_command, previous_angular_[0][i], previous_angular_[1][i], dt);
+    previous_linear_[1][i] = previous_linear_[0][i];
+    previous_linear_[0][i] = linear_command;
+    previous_angular_[1][i] = previous_angular_[0][i];
+    previous_angular_[0][i] = angular_command;
+
+    const double velocity_left =
+      (linear_command - angular_command * half_wheel_separation_) * inverse_left_wheel_radius_;
+    const double velocity_right =
+      (linear_command + angular_command * half_wheel_separation_) * inverse_right_wheel_radius_;
+    left_wheel_velocities[i] = velocity_left;
+    right_wheel_velocities[i] = velocity_right;
+
+    // odometry of the wheels at their commands, as in Odometry::updateFromVelocity()
+    const double left_displacement = velocity_left * parameters_.left_wheel_radius * dt;
+    const double right_displacement = velocity_right * parameters_.right_wheel_radius * dt;
+    const double linear = (left_displacement + right_displacement) * 0.5;
+    const double angular = (right_displacement - left_displacement) / parameters_.wheel_separation;
+    controller_realtime_tools::integrate_pose(linear, angular, x_[i], y_[i], heading_[i]);
+    linear_[i] = linear / dt;
+    angular_[i] = angular / dt;
+  }
+}
+
+}  // namespace diff_drive_controller
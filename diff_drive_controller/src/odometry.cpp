@@ -16,15 +16,16 @@
  * Author: Enrique Fernández
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "diff_drive_controller/odometry.hpp"
 
 namespace diff_drive_controller
 {
 Odometry::Odometry(size_t velocity_rolling_window_size)
 : timestamp_(0.0),
-  x_(0.0),
-  y_(0.0),
-  heading_(0.0),
+  last_sample_time_(0.0),
   linear_(0.0),
   angular_(0.0),
   wheel_separation_(0.0),
@@ -32,7 +33,15 @@ Odometry::Odometry(size_t velocity_rolling_window_size)
   right_wheel_radius_(0.0),
   left_wheel_old_pos_(0.0),
   right_wheel_old_pos_(0.0),
+  propagate_pose_covariance_(false),
+  pose_covariance_{},
+  initial_pose_covariance_{},
+  linear_noise_(0.0),
+  angular_noise_(0.0),
+  imu_weight_(0.0),
+  imu_angular_velocity_(std::numeric_limits<double>::quiet_NaN()),
   velocity_rolling_window_size_(velocity_rolling_window_size),
+  velocity_smoothing_mode_(controller_realtime_tools::SmoothingMode::MEAN),
   linear_accumulator_(velocity_rolling_window_size),
   angular_accumulator_(velocity_rolling_window_size)
 {
@@ -43,6 +52,7 @@ void Odometry::init(const rclcpp::Time & time)
   // Reset accumulators and timestamp:
   resetAccumulators();
   timestamp_ = time;
+  last_sample_time_ = time.seconds();
 }
 
 bool Odometry::update(double left_pos, double right_pos, const rclcpp::Time & time)
@@ -78,19 +88,71 @@ bool Odometry::updateFromVelocity(double left_vel, double right_vel, const rclcp
   // Compute linear and angular diff:
   const double linear = (left_vel + right_vel) * 0.5;
   // Now there is a bug about scout angular velocity
-  const double angular = (right_vel - left_vel) / wheel_separation_;
+  const double angular = blendAngular((right_vel - left_vel) / wheel_separation_, dt);
 
   // Integrate odometry:
   integrateExact(linear, angular);
 
   timestamp_ = time;
 
-  // Estimate speeds using a rolling mean to filter them out:
-  linear_accumulator_.accumulate(linear / dt);
-  angular_accumulator_.accumulate(angular / dt);
+  // Estimate speeds smoothed over the rolling window:
+  linear_ = linear_accumulator_.filter(linear / dt);
+  angular_ = angular_accumulator_.filter(angular / dt);
+
+  return true;
+}
 
-  linear_ = linear_accumulator_.getRollingMean();
-  angular_ = angular_accumulator_.getRollingMean();
+bool Odometry::updateFromSamples(
+  const double * left_pos, const double * right_pos, const double * times, size_t count)
+{
+  // Integrate exactly over each sample newer than the last update:
+  const double start_time = timestamp_.seconds();
+  double last_time = std::max(start_time, last_sample_time_);
+  double linear_sum = 0.0;
+  double angular_sum = 0.0;
+  size_t new_samples = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (times[i] <= last_time)
+    {
+      continue;  // Already integrated in an earlier update
+    }
+
+    const double left_wheel_cur_pos = left_pos[i] * left_wheel_radius_;
+    const double right_wheel_cur_pos = right_pos[i] * right_wheel_radius_;
+    const double left_wheel_est_vel = left_wheel_cur_pos - left_wheel_old_pos_;
+    const double right_wheel_est_vel = right_wheel_cur_pos - right_wheel_old_pos_;
+    left_wheel_old_pos_ = left_wheel_cur_pos;
+    right_wheel_old_pos_ = right_wheel_cur_pos;
+
+    const double linear = (left_wheel_est_vel + right_wheel_est_vel) * 0.5;
+    const double angular = blendAngular(
+      (right_wheel_est_vel - left_wheel_est_vel) / wheel_separation_, times[i] - last_time);
+    integrateExact(linear, angular);
+
+    linear_sum += linear;
+    angular_sum += angular;
+    last_time = times[i];
+    ++new_samples;
+  }
+
+  if (new_samples == 0)
+  {
+    return false;
+  }
+  const double dt = last_time - start_time;
+  last_sample_time_ = last_time;
+  timestamp_ = rclcpp::Time(std::llround(last_time * 1e9), timestamp_.get_clock_type());
+
+  // We cannot estimate the speed with very small time intervals:
+  if (dt < 0.0001)
+  {
+    return true;
+  }
+
+  // Estimate speeds over the whole batch smoothed over the rolling window:
+  linear_ = linear_accumulator_.filter(linear_sum / dt);
+  angular_ = angular_accumulator_.filter(angular_sum / dt);
 
   return true;
 }
@@ -109,9 +171,8 @@ void Odometry::updateOpenLoop(double linear, double angular, const rclcpp::Time
 
 void Odometry::resetOdometry()
 {
-  x_ = 0.0;
-  y_ = 0.0;
-  heading_ = 0.0;
+  pose_.reset(0.0, 0.0, 0.0);
+  pose_covariance_ = initial_pose_covariance_;
 }
 
 void Odometry::setWheelParams(
@@ -129,37 +190,118 @@ void Odometry::setVelocityRollingWindowSize(size_t velocity_rolling_window_size)
   resetAccumulators();
 }
 
-void Odometry::integrateRungeKutta2(double linear, double angular)
+void Odometry::setVelocitySmoothingMode(controller_realtime_tools::SmoothingMode mode)
+{
+  velocity_smoothing_mode_ = mode;
+
+  resetAccumulators();
+}
+
+void Odometry::setPoseCovarianceParams(
+  bool propagate, double x_variance, double y_variance, double heading_variance,
+  double linear_noise, double angular_noise)
 {
-  const double direction = heading_ + angular * 0.5;
+  propagate_pose_covariance_ = propagate;
+  initial_pose_covariance_ = {
+    x_variance, 0.0, 0.0, 0.0, y_variance, 0.0, 0.0, 0.0, heading_variance};
+  pose_covariance_ = initial_pose_covariance_;
+  linear_noise_ = linear_noise;
+  angular_noise_ = angular_noise;
+}
+
+void Odometry::setImuWeight(double weight) { imu_weight_ = std::clamp(weight, 0.0, 1.0); }
 
-  /// Runge-Kutta 2nd order integration:
-  x_ += linear * cos(direction);
-  y_ += linear * sin(direction);
-  heading_ += angular;
+double Odometry::blendAngular(double wheel_angular, double dt) const
+{
+  // without a valid yaw rate, e.g. before the first IMU sample, the wheels are integrated alone
+  if (imu_weight_ == 0.0 || std::isnan(imu_angular_velocity_))
+  {
+    return wheel_angular;
+  }
+  return imu_weight_ * imu_angular_velocity_ * dt + (1.0 - imu_weight_) * wheel_angular;
 }
 
 void Odometry::integrateExact(double linear, double angular)
 {
-  if (fabs(angular) < 1e-6)
+  if (propagate_pose_covariance_)
   {
-    integrateRungeKutta2(linear, angular);
+    propagateStepCovariance(linear, angular);
+  }
+  pose_.integrate(linear, angular);
+}
+
+void Odometry::propagateStepCovariance(double linear, double angular)
+{
+  // Jacobians of the step of PoseIntegrator::integrate() at the pose before it
+  const double sin_heading = pose_.sin_heading();
+  const double cos_heading = pose_.cos_heading();
+  if (fabs(angular) < controller_realtime_tools::STRAIGHT_STEP_ANGULAR_THRESHOLD)
+  {
+    const double cos_direction = cos_heading - sin_heading * angular * 0.5;
+    const double sin_direction = sin_heading + cos_heading * angular * 0.5;
+    propagatePoseCovariance(
+      -linear * sin_direction, linear * cos_direction,
+      {cos_direction, -0.5 * linear * sin_direction, sin_direction, 0.5 * linear * cos_direction},
+      linear, angular);
   }
   else
   {
-    /// Exact integration (should solve problems when angular is zero):
-    const double heading_old = heading_;
+    double sin_heading_new;
+    double cos_heading_new;
+    controller_realtime_tools::sin_cos(pose_.heading() + angular, sin_heading_new, cos_heading_new);
     const double r = linear / angular;
-    heading_ += angular;
-    x_ += r * (sin(heading_) - sin(heading_old));
-    y_ += -r * (cos(heading_) - cos(heading_old));
+    const double delta_sin = sin_heading_new - sin_heading;
+    const double delta_cos = cos_heading_new - cos_heading;
+    propagatePoseCovariance(
+      r * delta_cos, r * delta_sin,
+      {delta_sin / angular, r * (cos_heading_new - delta_sin / angular), -delta_cos / angular,
+       r * (sin_heading_new + delta_cos / angular)},
+      linear, angular);
+  }
+}
+
+void Odometry::propagatePoseCovariance(
+  double dx_dheading, double dy_dheading, const std::array<double, 4> & position_jacobian,
+  double linear, double angular)
+{
+  // P = F * P * F^T + G * Q * G^T, with the Jacobians of the step with respect to the pose (F)
+  // and to the linear and angular displacements (G), whose variances Q grow with their size
+  const double F[3][3] = {{1.0, 0.0, dx_dheading}, {0.0, 1.0, dy_dheading}, {0.0, 0.0, 1.0}};
+  const double G[3][2] = {
+    {position_jacobian[0], position_jacobian[1]},
+    {position_jacobian[2], position_jacobian[3]},
+    {0.0, 1.0}};
+  const double Q[2] = {linear_noise_ * fabs(linear), angular_noise_ * fabs(angular)};
+
+  std::array<double, 9> FP{};
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      for (size_t k = 0; k < 3; ++k)
+      {
+        FP[i * 3 + j] += F[i][k] * pose_covariance_[k * 3 + j];
+      }
+    }
+  }
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      double value = G[i][0] * G[j][0] * Q[0] + G[i][1] * G[j][1] * Q[1];
+      for (size_t k = 0; k < 3; ++k)
+      {
+        value += FP[i * 3 + k] * F[j][k];
+      }
+      pose_covariance_[i * 3 + j] = value;
+    }
   }
 }
 
 void Odometry::resetAccumulators()
 {
-  linear_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
-  angular_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
+  linear_accumulator_.configure(velocity_rolling_window_size_, velocity_smoothing_mode_);
+  angular_accumulator_.configure(velocity_rolling_window_size_, velocity_smoothing_mode_);
 }
 
 }  // namespace diff_drive_controller
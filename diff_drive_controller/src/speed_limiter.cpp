@@ -16,7 +16,7 @@
  * Author: Enrique Fernández
  */
 
-#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 #include "diff_drive_controller/speed_limiter.hpp"
@@ -27,111 +27,87 @@ SpeedLimiter::SpeedLimiter(
   bool has_velocity_limits, bool has_acceleration_limits, bool has_jerk_limits, double min_velocity,
   double max_velocity, double min_acceleration, double max_acceleration, double min_jerk,
   double max_jerk)
-: has_velocity_limits_(has_velocity_limits),
-  has_acceleration_limits_(has_acceleration_limits),
-  has_jerk_limits_(has_jerk_limits),
-  min_velocity_(min_velocity),
-  max_velocity_(max_velocity),
-  min_acceleration_(min_acceleration),
-  max_acceleration_(max_acceleration),
-  min_jerk_(min_jerk),
-  max_jerk_(max_jerk)
 {
   // Check if limits are valid, max must be specified, min defaults to -max if unspecified
-  if (has_velocity_limits_)
+  if (has_velocity_limits)
   {
-    if (std::isnan(max_velocity_))
+    if (std::isnan(max_velocity))
     {
       throw std::runtime_error("Cannot apply velocity limits if max_velocity is not specified");
     }
-    if (std::isnan(min_velocity_))
+    if (std::isnan(min_velocity))
     {
-      min_velocity_ = -max_velocity_;
+      min_velocity = -max_velocity;
     }
+    limiter_.set_value_limits(0, min_velocity, max_velocity);
   }
-  if (has_acceleration_limits_)
+  if (has_acceleration_limits)
   {
-    if (std::isnan(max_acceleration_))
+    if (std::isnan(max_acceleration))
     {
       throw std::runtime_error(
         "Cannot apply acceleration limits if max_acceleration is not specified");
     }
-    if (std::isnan(min_acceleration_))
+    if (std::isnan(min_acceleration))
     {
-      min_acceleration_ = -max_acceleration_;
+      min_acceleration = -max_acceleration;
     }
+    limiter_.set_rate_limits(0, min_acceleration, max_acceleration);
   }
-  if (has_jerk_limits_)
+  if (has_jerk_limits)
   {
-    if (std::isnan(max_jerk_))
+    if (std::isnan(max_jerk))
     {
       throw std::runtime_error("Cannot apply jerk limits if max_jerk is not specified");
     }
-    if (std::isnan(min_jerk_))
+    if (std::isnan(min_jerk))
     {
-      min_jerk_ = -max_jerk_;
+      min_jerk = -max_jerk;
     }
+    limiter_.set_second_rate_limits(0, min_jerk, max_jerk);
   }
 }
 
-double SpeedLimiter::limit(double & v, double v0, double v1, double dt)
+double SpeedLimiter::limit(double & v, double v0, double v1, double dt) const
 {
   const double tmp = v;
 
-  limit_jerk(v, v0, v1, dt);
-  limit_acceleration(v, v0, dt);
-  limit_velocity(v);
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit(values, {v0}, {v1}, dt);
+  v = values[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
 
-double SpeedLimiter::limit_velocity(double & v)
+double SpeedLimiter::limit_velocity(double & v) const
 {
   const double tmp = v;
 
-  if (has_velocity_limits_)
-  {
-    v = std::clamp(v, min_velocity_, max_velocity_);
-  }
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit_value(values);
+  v = values[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
 
-double SpeedLimiter::limit_acceleration(double & v, double v0, double dt)
+double SpeedLimiter::limit_acceleration(double & v, double v0, double dt) const
 {
   const double tmp = v;
 
-  if (has_acceleration_limits_)
-  {
-    const double dv_min = min_acceleration_ * dt;
-    const double dv_max = max_acceleration_ * dt;
-
-    const double dv = std::clamp(v - v0, dv_min, dv_max);
-
-    v = v0 + dv;
-  }
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit_rate(values, {v0}, dt);
+  v = values[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
 
-double SpeedLimiter::limit_jerk(double & v, double v0, double v1, double dt)
+double SpeedLimiter::limit_jerk(double & v, double v0, double v1, double dt) const
 {
   const double tmp = v;
 
-  if (has_jerk_limits_)
-  {
-    const double dv = v - v0;
-    const double dv0 = v0 - v1;
-
-    const double dt2 = 2. * dt * dt;
-
-    const double da_min = min_jerk_ * dt2;
-    const double da_max = max_jerk_ * dt2;
-
-    const double da = std::clamp(dv - dv0, da_min, da_max);
-
-    v = v0 + dv0 + da;
-  }
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit_second_rate(values, {v0}, {v1}, dt);
+  v = values[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
@@ -0,0 +1,103 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "diff_drive_controller/wheel_slip_detector.hpp"
+
+namespace diff_drive_controller
+{
+void WheelSlipDetector::configure(size_t wheel_count, double slip_threshold)
+{
+  slip_threshold_ = slip_threshold;
+  slipping_.assign(wheel_count, 0);
+  sorted_values_.assign(wheel_count, 0.0);
+  previous_positions_.assign(wheel_count, 0.0);
+  position_increments_.assign(wheel_count, 0.0);
+  reset();
+}
+
+void WheelSlipDetector::reset()
+{
+  std::fill(slipping_.begin(), slipping_.end(), 0);
+  slipping_count_ = 0;
+  has_previous_positions_ = false;
+  fused_position_ = 0.0;
+}
+
+double WheelSlipDetector::fuseVelocities(const double * velocities)
+{
+  return meanWithoutSlip(velocities, slip_threshold_);
+}
+
+double WheelSlipDetector::fusePositions(const double * positions, double dt)
+{
+  const size_t wheel_count = previous_positions_.size();
+  if (!has_previous_positions_)
+  {
+    double sum = 0.0;
+    for (size_t i = 0; i < wheel_count; ++i)
+    {
+      sum += positions[i];
+    }
+    fused_position_ = sum / static_cast<double>(wheel_count);
+    std::copy(positions, positions + wheel_count, previous_positions_.begin());
+    has_previous_positions_ = true;
+    return fused_position_;
+  }
+
+  for (size_t i = 0; i < wheel_count; ++i)
+  {
+    position_increments_[i] = positions[i] - previous_positions_[i];
+  }
+  std::copy(positions, positions + wheel_count, previous_positions_.begin());
+
+  // the same threshold on the increments, without dividing by dt
+  fused_position_ += meanWithoutSlip(position_increments_.data(), slip_threshold_ * dt);
+  return fused_position_;
+}
+
+double WheelSlipDetector::meanWithoutSlip(const double * values, double threshold)
+{
+  const size_t wheel_count = slipping_.size();
+  std::copy(values, values + wheel_count, sorted_values_.begin());
+  const auto middle = sorted_values_.begin() + static_cast<std::ptrdiff_t>(wheel_count / 2);
+  std::nth_element(sorted_values_.begin(), middle, sorted_values_.end());
+  double median = *middle;
+  if (wheel_count % 2 == 0)
+  {
+    median = 0.5 * (median + *std::max_element(sorted_values_.begin(), middle));
+  }
+
+  // a single branch-free pass, so the compiler can vectorize it
+  double sum = 0.0;
+  double kept_sum = 0.0;
+  size_t kept_count = 0;
+  for (size_t i = 0; i < wheel_count; ++i)
+  {
+    const bool slipping = std::fabs(values[i] - median) > threshold;
+    slipping_[i] = static_cast<uint8_t>(slipping);
+    sum += values[i];
+    kept_sum += slipping ? 0.0 : values[i];
+    kept_count += slipping ? 0 : 1;
+  }
+  slipping_count_ = wheel_count - kept_count;
+
+  return kept_count > 0 ? kept_sum / static_cast<double>(kept_count)
+                        : sum / static_cast<double>(wheel_count);
+}
+
+}  // namespace diff_drive_controller
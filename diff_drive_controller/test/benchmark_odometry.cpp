@@ -0,0 +1,380 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replay of wheel encoder recordings through diff_drive_controller::Odometry.
+//
+// The recording is read from the CSV file named by the environment variable ODOMETRY_RECORDING,
+// with the columns 'time,left_position,right_position' in s and rad, optionally followed by the
+// ground truth 'x,y,heading' and 'linear,angular'. Lines that don't start with a number are
+// skipped. The wheels are set with ODOMETRY_WHEEL_SEPARATION and ODOMETRY_WHEEL_RADIUS.
+// Without a file, a drive of ODOMETRY_SAMPLES samples (default 1000000) at 1 kHz along a winding
+// path is generated, with the exact pose as ground truth. ODOMETRY_ENCODER_TICKS quantizes the
+// generated wheel positions to that many ticks per revolution.
+//
+// The argument 'method' selects the update of the odometry: from positions (0), from velocities
+// integrated over the sample period (1), open loop from the body velocities (2), or from batches
+// of 10 timestamped samples (3). The argument 'window' sets the velocity rolling window size.
+//
+// Every benchmark replays the whole recording per iteration and reports the time per update
+// (ns_per_update) and per sample (ns_per_sample), which differ for batches. A replay before the
+// timed ones reports the drift from the ground truth at the end of the recording (position_error,
+// heading_error, drift_per_km) and the RMS error of the estimated velocities (linear_rms_error,
+// angular_rms_error).
+//
+// Like all performance tests, the benchmarks only run with ctest if AMENT_RUN_PERFORMANCE_TESTS is
+// set.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "diff_drive_controller/odometry.hpp"
+#include "rclcpp/time.hpp"
+
+namespace
+{
+enum Method : int64_t
+{
+  POSITION = 0,
+  VELOCITY = 1,
+  OPEN_LOOP = 2,
+  SAMPLES = 3,
+};
+constexpr size_t SAMPLES_PER_CYCLE = 10;
+constexpr double SAMPLE_PERIOD = 0.001;
+
+double get_env(const char * name, double default_value)
+{
+  const char * value = std::getenv(name);
+  return value ? std::strtod(value, nullptr) : default_value;
+}
+
+/// Wheel positions and velocities per sample, with the ground truth if known
+struct Recording
+{
+  double wheel_separation = 0.0;
+  double wheel_radius = 0.0;
+  std::vector<double> time;
+  std::vector<double> left_position;
+  std::vector<double> right_position;
+  std::vector<double> left_velocity;
+  std::vector<double> right_velocity;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> heading;
+  std::vector<double> linear;
+  std::vector<double> angular;
+  // travelled distance [m]
+  double distance = 0.0;
+
+  size_t size() const { return time.size(); }
+};
+
+/// Wheel velocities from the position differences, for recordings without velocities
+void derive_wheel_velocities(Recording & recording)
+{
+  double previous_time = 0.0;
+  double previous_left = 0.0;
+  double previous_right = 0.0;
+  for (size_t i = 0; i < recording.size(); ++i)
+  {
+    const double dt = recording.time[i] - previous_time;
+    recording.left_velocity.push_back(
+      dt > 0.0 ? (recording.left_position[i] - previous_left) / dt : 0.0);
+    recording.right_velocity.push_back(
+      dt > 0.0 ? (recording.right_position[i] - previous_right) / dt : 0.0);
+    previous_time = recording.time[i];
+    previous_left = recording.left_position[i];
+    previous_right = recording.right_position[i];
+  }
+}
+
+Recording read_recording(const std::string & file_name)
+{
+  Recording recording;
+  recording.wheel_separation = get_env("ODOMETRY_WHEEL_SEPARATION", 0.4);
+  recording.wheel_radius = get_env("ODOMETRY_WHEEL_RADIUS", 0.1);
+
+  std::ifstream file(file_name);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (
+      line.empty() ||
+      !(std::isdigit(static_cast<unsigned char>(line[0])) || line[0] == '-' || line[0] == '.'))
+    {
+      continue;
+    }
+    std::vector<double> values;
+    std::istringstream stream(line);
+    std::string value;
+    while (std::getline(stream, value, ','))
+    {
+      values.push_back(std::strtod(value.c_str(), nullptr));
+    }
+    if (values.size() < 3)
+    {
+      continue;
+    }
+    recording.time.push_back(values[0]);
+    recording.left_position.push_back(values[1]);
+    recording.right_position.push_back(values[2]);
+    if (values.size() >= 6)
+    {
+      if (!recording.x.empty())
+      {
+        recording.distance +=
+          std::hypot(values[3] - recording.x.back(), values[4] - recording.y.back());
+      }
+      recording.x.push_back(values[3]);
+      recording.y.push_back(values[4]);
+      recording.heading.push_back(values[5]);
+    }
+    if (values.size() >= 8)
+    {
+      recording.linear.push_back(values[6]);
+      recording.angular.push_back(values[7]);
+    }
+  }
+  derive_wheel_velocities(recording);
+  return recording;
+}
+
+/// Drive along a winding path, integrated exactly over 10 steps per sample
+Recording generate_recording()
+{
+  Recording recording;
+  recording.wheel_separation = 0.4;
+  recording.wheel_radius = 0.1;
+  const auto samples = static_cast<size_t>(get_env("ODOMETRY_SAMPLES", 1e6));
+  const double ticks = get_env("ODOMETRY_ENCODER_TICKS", 0.0);
+  auto quantize = [ticks](double position)
+  {
+    const double tick = 2.0 * M_PI / ticks;
+    return ticks > 0.0 ? std::round(position / tick) * tick : position;
+  };
+
+  constexpr size_t STEPS = 10;
+  const double step = SAMPLE_PERIOD / static_cast<double>(STEPS);
+  auto linear = [](double t) { return 1.0 + 0.5 * std::sin(0.1 * t); };
+  auto angular = [](double t) { return 0.5 * std::sin(0.05 * t) + 0.2 * std::sin(0.37 * t); };
+
+  double x = 0.0;
+  double y = 0.0;
+  double heading = 0.0;
+  double left_distance = 0.0;
+  double right_distance = 0.0;
+  for (size_t i = 0; i < samples; ++i)
+  {
+    for (size_t k = 0; k < STEPS; ++k)
+    {
+      const double t = (static_cast<double>(i * STEPS + k) + 0.5) * step;
+      const double v = linear(t);
+      const double w = angular(t);
+      const double heading_old = heading;
+      heading += w * step;
+      if (std::fabs(w) > 1e-12)
+      {
+        x += v / w * (std::sin(heading) - std::sin(heading_old));
+        y -= v / w * (std::cos(heading) - std::cos(heading_old));
+      }
+      else
+      {
+        x += v * step * std::cos(heading);
+        y += v * step * std::sin(heading);
+      }
+      left_distance += (v - 0.5 * w * recording.wheel_separation) * step;
+      right_distance += (v + 0.5 * w * recording.wheel_separation) * step;
+    }
+    const double t = static_cast<double>(i + 1) * SAMPLE_PERIOD;
+    recording.time.push_back(t);
+    recording.left_position.push_back(quantize(left_distance / recording.wheel_radius));
+    recording.right_position.push_back(quantize(right_distance / recording.wheel_radius));
+    recording.left_velocity.push_back(
+      (linear(t) - 0.5 * angular(t) * recording.wheel_separation) / recording.wheel_radius);
+    recording.right_velocity.push_back(
+      (linear(t) + 0.5 * angular(t) * recording.wheel_separation) / recording.wheel_radius);
+    recording.x.push_back(x);
+    recording.y.push_back(y);
+    recording.heading.push_back(heading);
+    recording.linear.push_back(linear(t));
+    recording.angular.push_back(angular(t));
+  }
+  recording.distance = 0.5 * (left_distance + right_distance);
+  return recording;
+}
+
+const Recording & get_recording()
+{
+  static const Recording recording = []()
+  {
+    const char * file_name = std::getenv("ODOMETRY_RECORDING");
+    return file_name ? read_recording(file_name) : generate_recording();
+  }();
+  return recording;
+}
+
+/// Replays a recording through the odometry with one of the update methods
+class Replay
+{
+public:
+  Replay(const Recording & recording, Method method, size_t window)
+  : recording_(recording), method_(method), odometry_(window)
+  {
+    odometry_.setWheelParams(
+      recording.wheel_separation, recording.wheel_radius, recording.wheel_radius);
+    odometry_.init(rclcpp::Time(0, 0, RCL_ROS_TIME));
+    stamps_.reserve(recording.size());
+    for (const double time : recording.time)
+    {
+      stamps_.emplace_back(static_cast<int64_t>(std::llround(time * 1e9)), RCL_ROS_TIME);
+    }
+  }
+
+  /// The number of samples consumed by the update from sample \p i, at least one
+  size_t update(size_t i)
+  {
+    switch (method_)
+    {
+      case POSITION:
+        odometry_.update(recording_.left_position[i], recording_.right_position[i], stamps_[i]);
+        return 1;
+      case VELOCITY:
+      {
+        const double dt = recording_.time[i] - (i > 0 ? recording_.time[i - 1] : 0.0);
+        odometry_.updateFromVelocity(
+          recording_.left_velocity[i] * recording_.wheel_radius * dt,
+          recording_.right_velocity[i] * recording_.wheel_radius * dt, stamps_[i]);
+        return 1;
+      }
+      case OPEN_LOOP:
+      {
+        const double left = recording_.left_velocity[i] * recording_.wheel_radius;
+        const double right = recording_.right_velocity[i] * recording_.wheel_radius;
+        odometry_.updateOpenLoop(
+          0.5 * (left + right), (right - left) / recording_.wheel_separation, stamps_[i]);
+        return 1;
+      }
+      case SAMPLES:
+      default:
+      {
+        const size_t count = std::min(SAMPLES_PER_CYCLE, recording_.size() - i);
+        odometry_.updateFromSamples(
+          &recording_.left_position[i], &recording_.right_position[i], &recording_.time[i],
+          count);
+        return count;
+      }
+    }
+  }
+
+  const diff_drive_controller::Odometry & odometry() const { return odometry_; }
+
+private:
+  const Recording & recording_;
+  const Method method_;
+  diff_drive_controller::Odometry odometry_;
+  std::vector<rclcpp::Time> stamps_;
+};
+
+/// Replay once and report the errors from the ground truth
+void report_errors(
+  benchmark::State & state, const Recording & recording, Method method, size_t window)
+{
+  Replay replay(recording, method, window);
+  double linear_squared_error = 0.0;
+  double angular_squared_error = 0.0;
+  size_t velocity_checks = 0;
+  for (size_t i = 0; i < recording.size();)
+  {
+    i += replay.update(i);
+    if (recording.linear.size() == recording.size())
+    {
+      linear_squared_error += std::pow(replay.odometry().getLinear() - recording.linear[i - 1], 2);
+      angular_squared_error +=
+        std::pow(replay.odometry().getAngular() - recording.angular[i - 1], 2);
+      ++velocity_checks;
+    }
+  }
+
+  if (recording.x.size() == recording.size() && !recording.x.empty())
+  {
+    const double position_error = std::hypot(
+      replay.odometry().getX() - recording.x.back(), replay.odometry().getY() - recording.y.back());
+    state.counters["position_error"] = position_error;
+    state.counters["heading_error"] = std::fabs(
+      std::remainder(replay.odometry().getHeading() - recording.heading.back(), 2.0 * M_PI));
+    state.counters["drift_per_km"] =
+      recording.distance > 0.0 ? 1000.0 * position_error / recording.distance : 0.0;
+  }
+  if (velocity_checks > 0)
+  {
+    state.counters["linear_rms_error"] =
+      std::sqrt(linear_squared_error / static_cast<double>(velocity_checks));
+    state.counters["angular_rms_error"] =
+      std::sqrt(angular_squared_error / static_cast<double>(velocity_checks));
+  }
+}
+}  // namespace
+
+static void replay(benchmark::State & state)
+{
+  const auto & recording = get_recording();
+  if (recording.size() == 0)
+  {
+    state.SkipWithError("Empty recording.");
+    return;
+  }
+  const auto method = static_cast<Method>(state.range(0));
+  const auto window = static_cast<size_t>(state.range(1));
+  report_errors(state, recording, method, window);
+
+  double total_ns = 0.0;
+  size_t updates = 0;
+  size_t samples = 0;
+  for (auto _ : state)
+  {
+    Replay replay(recording, method, window);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < recording.size();)
+    {
+      i += replay.update(i);
+      ++updates;
+    }
+    samples += recording.size();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    benchmark::DoNotOptimize(replay.odometry().getX());
+
+    const double elapsed_ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    total_ns += elapsed_ns;
+    state.SetIterationTime(elapsed_ns * 1e-9);
+  }
+  state.counters["ns_per_update"] = updates > 0 ? total_ns / static_cast<double>(updates) : 0.0;
+  state.counters["ns_per_sample"] = samples > 0 ? total_ns / static_cast<double>(samples) : 0.0;
+  state.counters["samples"] = static_cast<double>(recording.size());
+}
+
+BENCHMARK(replay)
+  ->ArgNames({"method", "window"})
+  ->ArgsProduct({{POSITION, VELOCITY, OPEN_LOOP, SAMPLES}, {1, 10, 100}})
+  ->UseManualTime()
+  ->Unit(benchmark::kMillisecond);
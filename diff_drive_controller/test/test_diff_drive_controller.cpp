@@ -15,13 +15,18 @@
 #include <gmock/gmock.h>
 
 #include <array>
+#include <cstdio>
+#include <limits>
 #include <memory>
 #include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
+#include "controller_realtime_tools/input_recorder.hpp"
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
 #include "diff_drive_controller/diff_drive_controller.hpp"
+#include "diff_drive_controller/fleet_kinematics.hpp"
 #include "hardware_interface/loaned_command_interface.hpp"
 #include "hardware_interface/loaned_state_interface.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
@@ -40,13 +45,17 @@ class TestableDiffDriveController : public diff_drive_controller::DiffDriveContr
 {
 public:
   using DiffDriveController::DiffDriveController;
-  std::shared_ptr<geometry_msgs::msg::TwistStamped> getLastReceivedTwist()
+  geometry_msgs::msg::TwistStamped getLastReceivedTwist()
   {
-    std::shared_ptr<geometry_msgs::msg::TwistStamped> ret;
-    received_velocity_msg_ptr_.get(ret);
-    return ret;
+    return received_velocity_msg_->read();
   }
 
+  controller_realtime_tools::LatencyProbe * getCommandLatency() { return command_latency_.get(); }
+
+  void publishParametersUpdate() { publish_parameters_update(); }
+
+  double * getReferenceValue(size_t index) { return &reference_interfaces_[index]; }
+
   /**
    * @brief wait_for_twist block until a new twist is received.
    * Requires that the executor is not spinned elsewhere between the
@@ -434,3 +443,782 @@ TEST_F(TestDiffDriveController, correct_initialization_using_parameters)
   ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
   executor.cancel();
 }
+
+TEST_F(TestDiffDriveController, timeout_brakes_without_overriding_received_command)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  publish(1.0, 0.0);
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  const auto received_command = controller_->getLastReceivedTwist();
+  EXPECT_EQ(1.0, received_command.twist.linear.x);
+
+  // the command is older than the timeout at this time
+  const rclcpp::Time late_time =
+    rclcpp::Time(received_command.header.stamp) + rclcpp::Duration::from_seconds(1.0);
+  ASSERT_EQ(
+    controller_->update(late_time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, left_wheel_vel_cmd_.get_value());
+  EXPECT_EQ(0.0, right_wheel_vel_cmd_.get_value());
+
+  // only the applied command brakes, the received one is left as it was
+  EXPECT_EQ(1.0, controller_->getLastReceivedTwist().twist.linear.x);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST_F(TestDiffDriveController, jitter_buffer_plays_out_commands_delayed)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("jitter_buffer.enable", true));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("jitter_buffer.delay", 0.1));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  publish(1.0, 0.5);
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  const rclcpp::Time stamp = controller_->getLastReceivedTwist().header.stamp;
+
+  // the command is held back until the delay after its stamp
+  ASSERT_EQ(
+    controller_->update(
+      stamp + rclcpp::Duration::from_seconds(0.05), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, *controller_->getReferenceValue(0));
+  EXPECT_EQ(0.0, left_wheel_vel_cmd_.get_value());
+
+  ASSERT_EQ(
+    controller_->update(
+      stamp + rclcpp::Duration::from_seconds(0.1), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(1.0, *controller_->getReferenceValue(0));
+  EXPECT_EQ(0.5, *controller_->getReferenceValue(1));
+
+  // the timeout counts from the play out of the command
+  ASSERT_EQ(
+    controller_->update(
+      stamp + rclcpp::Duration::from_seconds(0.55), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(1.0, *controller_->getReferenceValue(0));
+  ASSERT_EQ(
+    controller_->update(
+      stamp + rclcpp::Duration::from_seconds(0.65), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, *controller_->getReferenceValue(0));
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST_F(TestDiffDriveController, intra_process_command_subscription)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("cmd_vel_qos.intra_process", true));
+
+  // intra-process communication needs a bounded queue
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+  controller_->get_node()->set_parameter(rclcpp::Parameter("cmd_vel_qos.history", "keep_last"));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  // the message is moved from a publisher in the same process into the controller
+  auto intra_process_node = std::make_shared<rclcpp::Node>(
+    "intra_process_velocity_publisher", rclcpp::NodeOptions().use_intra_process_comms(true));
+  auto intra_process_publisher =
+    intra_process_node->create_publisher<geometry_msgs::msg::TwistStamped>(
+      controller_name + "/cmd_vel", rclcpp::QoS(1));
+  auto velocity_message = std::make_unique<geometry_msgs::msg::TwistStamped>();
+  velocity_message->header.stamp = intra_process_node->get_clock()->now();
+  velocity_message->twist.linear.x = 0.5;
+  intra_process_publisher->publish(std::move(velocity_message));
+
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  EXPECT_EQ(0.5, controller_->getLastReceivedTwist().twist.linear.x);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST_F(TestDiffDriveController, command_latency)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("command_latency.enable", true));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_NE(nullptr, controller_->getCommandLatency());
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  publish(1.0, 0.0);
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  const auto received_command = controller_->getLastReceivedTwist();
+
+  // written 50 ms after it was published, the next cycle doesn't count
+  const rclcpp::Time stamp(received_command.header.stamp);
+  for (const double delay : {0.05, 0.06})
+  {
+    ASSERT_EQ(
+      controller_->update(
+        stamp + rclcpp::Duration::from_seconds(delay), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  }
+
+  using controller_realtime_tools::LatencyProbe;
+  const auto statistics = controller_->getCommandLatency()->get_statistics();
+  EXPECT_EQ(1u, statistics[LatencyProbe::PUBLISH_TO_WRITE].count);
+  EXPECT_DOUBLE_EQ(50e6, statistics[LatencyProbe::PUBLISH_TO_WRITE].mean_ns);
+  EXPECT_EQ(1u, statistics[LatencyProbe::PUBLISH_TO_RECEIVE].count);
+  EXPECT_EQ(1u, statistics[LatencyProbe::RECEIVE_TO_WRITE].count);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST_F(TestDiffDriveController, update_is_realtime_safe)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("publish_limited_velocity", true));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  publish(1.0, 0.5);
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  const rclcpp::Time stamp(controller_->getLastReceivedTwist().header.stamp);
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  // the first update takes over the command
+  ASSERT_EQ(controller_->update(stamp, period), controller_interface::return_type::OK);
+
+  // within the timeout of the command, the odometry and the limited velocity are published
+  controller_realtime_tools::ScopedRealtimeSafetyCounter counter;
+  for (int i = 1; i <= 20; ++i)
+  {
+    controller_->update(stamp + rclcpp::Duration::from_seconds(0.01 * i), period);
+  }
+  EXPECT_EQ(0u, counter.get_allocations());
+  EXPECT_EQ(0u, counter.get_deallocations());
+  EXPECT_EQ(0u, counter.get_locks());
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST_F(TestDiffDriveController, parameters_are_updated_while_active)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  publish(1.0, 0.0);
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  const rclcpp::Time stamp(controller_->getLastReceivedTwist().header.stamp);
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  ASSERT_EQ(controller_->update(stamp, period), controller_interface::return_type::OK);
+  EXPECT_EQ(1.0, left_wheel_vel_cmd_.get_value());
+  EXPECT_EQ(1.0, right_wheel_vel_cmd_.get_value());
+
+  // handed over by the timer, without reconfiguring the controller
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 2.0));
+  controller_->publishParametersUpdate();
+
+  // taking the new parameters over neither allocates nor locks
+  controller_realtime_tools::ScopedRealtimeSafetyCounter counter;
+  ASSERT_EQ(
+    controller_->update(stamp + rclcpp::Duration::from_seconds(0.01), period),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0u, counter.get_allocations());
+  EXPECT_EQ(0u, counter.get_deallocations());
+  EXPECT_EQ(0u, counter.get_locks());
+  EXPECT_EQ(0.5, left_wheel_vel_cmd_.get_value());
+  EXPECT_EQ(0.5, right_wheel_vel_cmd_.get_value());
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST_F(TestDiffDriveController, chained_mode_uses_reference_interfaces)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_THAT(reference_interfaces, SizeIs(2));
+  EXPECT_EQ(reference_interfaces[0].get_name(), controller_name + "/linear/" + HW_IF_VELOCITY);
+  EXPECT_EQ(reference_interfaces[1].get_name(), controller_name + "/angular/" + HW_IF_VELOCITY);
+
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+  ASSERT_TRUE(controller_->is_in_chained_mode());
+
+  // the preceding controller writes the command in the same cycle
+  reference_interfaces[0].set_value(1.0);
+  reference_interfaces[1].set_value(0.5);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(1.0 - 0.5 * 0.2, left_wheel_vel_cmd_.get_value());
+  EXPECT_DOUBLE_EQ(1.0 + 0.5 * 0.2, right_wheel_vel_cmd_.get_value());
+
+  // without a new reference the robot brakes
+  ASSERT_EQ(
+    controller_->update(
+      rclcpp::Time(10000000, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, left_wheel_vel_cmd_.get_value());
+  EXPECT_EQ(0.0, right_wheel_vel_cmd_.get_value());
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+}
+
+TEST_F(TestDiffDriveController, command_sequences_count_changed_wheel_commands)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("command_sequence_interfaces", true));
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+  EXPECT_THAT(
+    controller_->command_interface_configuration().names,
+    testing::ElementsAre(
+      "left_wheel_joint/velocity", "right_wheel_joint/velocity",
+      "left_wheel_joint/velocity_sequence", "right_wheel_joint/velocity_sequence"));
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+
+  std::vector<double> sequences = {0.0, 0.0};
+  hardware_interface::CommandInterface left_wheel_sequence{
+    left_wheel_names[0], "velocity_sequence", &sequences[0]};
+  hardware_interface::CommandInterface right_wheel_sequence{
+    right_wheel_names[0], "velocity_sequence", &sequences[1]};
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(left_wheel_pos_state_);
+  state_ifs.emplace_back(right_wheel_pos_state_);
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(left_wheel_vel_cmd_);
+  command_ifs.emplace_back(right_wheel_vel_cmd_);
+  command_ifs.emplace_back(left_wheel_sequence);
+  command_ifs.emplace_back(right_wheel_sequence);
+  controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  const auto update = [&](int64_t nanoseconds)
+  {
+    ASSERT_EQ(
+      controller_->update(
+        rclcpp::Time(nanoseconds, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+  // the first commands after activation count as changed
+  reference_interfaces[0].set_value(1.0);
+  reference_interfaces[1].set_value(0.5);
+  update(0);
+  EXPECT_EQ(sequences, std::vector<double>({1.0, 1.0}));
+  // the same wheel velocities again
+  reference_interfaces[0].set_value(1.0);
+  reference_interfaces[1].set_value(0.5);
+  update(10000000);
+  EXPECT_EQ(sequences, std::vector<double>({1.0, 1.0}));
+  // braking without a reference
+  update(20000000);
+  EXPECT_EQ(sequences, std::vector<double>({2.0, 2.0}));
+  EXPECT_EQ(0.0, left_wheel_vel_cmd_.get_value());
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+}
+
+TEST_F(TestDiffDriveController, recorded_inputs_replay_the_same_commands)
+{
+  const std::string path = testing::TempDir() + "/diff_drive_controller.input_recording";
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  const auto start_controller = [&]()
+  {
+    controller_ = std::make_unique<TestableDiffDriveController>();
+    ASSERT_EQ(controller_->init(controller_name), controller_interface::return_type::OK);
+    auto node = controller_->get_node();
+    node->set_parameter(
+      rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+    node->set_parameter(
+      rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+    node->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+    node->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+    node->set_parameter(rclcpp::Parameter("linear.x.has_acceleration_limits", true));
+    node->set_parameter(rclcpp::Parameter("linear.x.max_acceleration", 2.0));
+    node->set_parameter(rclcpp::Parameter("linear.x.min_acceleration", -2.0));
+    node->set_parameter(rclcpp::Parameter("input_recording.enable", true));
+    node->set_parameter(rclcpp::Parameter("input_recording.path", path));
+    ASSERT_EQ(node->configure().id(), State::PRIMARY_STATE_INACTIVE);
+    reference_interfaces = controller_->export_reference_interfaces();
+    ASSERT_TRUE(controller_->set_chained_mode(true));
+    assignResourcesPosFeedback();
+    ASSERT_EQ(node->activate().id(), State::PRIMARY_STATE_ACTIVE);
+  };
+
+  start_controller();
+  std::vector<std::pair<double, double>> commands;
+  for (int i = 0; i < 20; ++i)
+  {
+    position_values_[0] += 0.01 * i;
+    position_values_[1] += 0.02 * i;
+    reference_interfaces[0].set_value(0.1 * i);
+    // without an angular reference in every other cycle the robot brakes
+    reference_interfaces[1].set_value(
+      i % 2 == 0 ? 0.5 : std::numeric_limits<double>::quiet_NaN());
+    ASSERT_EQ(
+      controller_->update(
+        rclcpp::Time(10000000 * i, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    commands.emplace_back(left_wheel_vel_cmd_.get_value(), right_wheel_vel_cmd_.get_value());
+  }
+  // writes the inputs left
+  ASSERT_EQ(controller_->get_node()->deactivate().id(), State::PRIMARY_STATE_INACTIVE);
+
+  controller_realtime_tools::InputRecording recording;
+  ASSERT_TRUE(controller_realtime_tools::read_input_recording(path, recording));
+  EXPECT_THAT(
+    recording.state_names, testing::ElementsAre(
+                             left_wheel_names[0] + "/" + HW_IF_POSITION,
+                             right_wheel_names[0] + "/" + HW_IF_POSITION));
+  ASSERT_EQ(recording.size(), commands.size());
+
+  // a new controller fed with the recording writes the same commands
+  start_controller();
+  size_t cycle = 0;
+  ASSERT_TRUE(controller_realtime_tools::replay_inputs(
+    recording, {&position_values_[0], &position_values_[1]},
+    {controller_->getReferenceValue(0), controller_->getReferenceValue(1)},
+    [&](int64_t time_ns, int64_t period_ns)
+    {
+      ASSERT_EQ(
+        controller_->update(
+          rclcpp::Time(time_ns, RCL_ROS_TIME), rclcpp::Duration::from_nanoseconds(period_ns)),
+        controller_interface::return_type::OK);
+      EXPECT_EQ(left_wheel_vel_cmd_.get_value(), commands[cycle].first) << cycle;
+      EXPECT_EQ(right_wheel_vel_cmd_.get_value(), commands[cycle].second) << cycle;
+      ++cycle;
+    }));
+  EXPECT_EQ(cycle, commands.size());
+  std::remove(path.c_str());
+}
+
+TEST_F(TestDiffDriveController, imu_heading_integrates_the_imu_yaw_rate)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("position_feedback", false));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("imu_heading.enable", true));
+
+  // the IMU has to be named
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::ERROR);
+  controller_->get_node()->set_parameter(rclcpp::Parameter("imu_heading.sensor_name", "imu"));
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+  EXPECT_THAT(
+    controller_->state_interface_configuration().names,
+    testing::Contains("imu/angular_velocity.z"));
+  auto state_interfaces = controller_->export_state_interfaces();
+
+  double imu_yaw_rate = 0.5;
+  hardware_interface::StateInterface imu_yaw_rate_state{"imu", "angular_velocity.z", &imu_yaw_rate};
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(left_wheel_vel_state_);
+  state_ifs.emplace_back(right_wheel_vel_state_);
+  state_ifs.emplace_back(imu_yaw_rate_state);
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(left_wheel_vel_cmd_);
+  command_ifs.emplace_back(right_wheel_vel_cmd_);
+  controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  // only the IMU is integrated with the default gyro_weight of 1
+  for (int i = 1; i <= 10; ++i)
+  {
+    ASSERT_EQ(
+      controller_->update(
+        rclcpp::Time(i * 10000000, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  }
+  EXPECT_NEAR(state_interfaces[2].get_value(), 0.05, 1e-9);
+  EXPECT_NEAR(state_interfaces[4].get_value(), 0.5, 1e-9);
+
+  // without a valid yaw rate the heading follows the wheels, which were braked without commands
+  imu_yaw_rate = std::numeric_limits<double>::quiet_NaN();
+  ASSERT_EQ(
+    controller_->update(
+      rclcpp::Time(110000000, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_NEAR(state_interfaces[2].get_value(), 0.05, 1e-9);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+}
+
+TEST_F(TestDiffDriveController, exports_odometry_state_interfaces)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("left_wheel_names", rclcpp::ParameterValue(left_wheel_names)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("right_wheel_names", rclcpp::ParameterValue(right_wheel_names)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_separation", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("open_loop", true));
+
+  auto state = controller_->get_node()->configure();
+  ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
+
+  auto state_interfaces = controller_->export_state_interfaces();
+  ASSERT_THAT(state_interfaces, SizeIs(5));
+  EXPECT_EQ(state_interfaces[0].get_name(), controller_name + "/odometry/x");
+  EXPECT_EQ(state_interfaces[1].get_name(), controller_name + "/odometry/y");
+  EXPECT_EQ(state_interfaces[2].get_name(), controller_name + "/odometry/heading");
+  EXPECT_EQ(state_interfaces[3].get_name(), controller_name + "/odometry/linear_velocity");
+  EXPECT_EQ(state_interfaces[4].get_name(), controller_name + "/odometry/angular_velocity");
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_THAT(reference_interfaces, SizeIs(2));
+
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  assignResourcesPosFeedback();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  // the following controller reads the odometry of the same cycle
+  for (int i = 0; i < 10; ++i)
+  {
+    reference_interfaces[0].set_value(1.0);
+    reference_interfaces[1].set_value(0.0);
+    ASSERT_EQ(
+      controller_->update(
+        rclcpp::Time(i * 10000000, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  }
+  EXPECT_NEAR(state_interfaces[0].get_value(), 0.09, 1e-9);
+  EXPECT_NEAR(state_interfaces[1].get_value(), 0.0, 1e-9);
+  EXPECT_NEAR(state_interfaces[2].get_value(), 0.0, 1e-9);
+  EXPECT_NEAR(state_interfaces[3].get_value(), 1.0, 1e-9);
+  EXPECT_NEAR(state_interfaces[4].get_value(), 0.0, 1e-9);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+}
+
+TEST(TestOdometry, update_from_samples_integrates_each_sample)
+{
+  diff_drive_controller::Odometry per_cycle_odometry;
+  diff_drive_controller::Odometry batch_odometry;
+  for (auto * odometry : {&per_cycle_odometry, &batch_odometry})
+  {
+    odometry->setWheelParams(0.4, 0.1, 0.1);
+    odometry->init(rclcpp::Time(0, 0, RCL_ROS_TIME));
+  }
+
+  // a turn sampled every millisecond
+  constexpr size_t count = 50;
+  std::array<double, count> left_pos;
+  std::array<double, count> right_pos;
+  std::array<double, count> times;
+  for (size_t i = 0; i < count; ++i)
+  {
+    times[i] = 0.001 * static_cast<double>(i + 1);
+    left_pos[i] = 1.0 * times[i];
+    right_pos[i] = 3.0 * times[i];
+    per_cycle_odometry.update(
+      left_pos[i], right_pos[i], rclcpp::Time(static_cast<int64_t>(i + 1) * 1000000, RCL_ROS_TIME));
+  }
+
+  ASSERT_TRUE(
+    batch_odometry.updateFromSamples(left_pos.data(), right_pos.data(), times.data(), count));
+  EXPECT_NEAR(batch_odometry.getX(), per_cycle_odometry.getX(), 1e-12);
+  EXPECT_NEAR(batch_odometry.getY(), per_cycle_odometry.getY(), 1e-12);
+  EXPECT_NEAR(batch_odometry.getHeading(), per_cycle_odometry.getHeading(), 1e-12);
+  EXPECT_NEAR(batch_odometry.getLinear(), 0.2, 1e-9);
+  EXPECT_NEAR(batch_odometry.getAngular(), 0.5, 1e-9);
+
+  // samples of the last batch are not integrated again
+  EXPECT_FALSE(
+    batch_odometry.updateFromSamples(left_pos.data(), right_pos.data(), times.data(), count));
+  EXPECT_NEAR(batch_odometry.getHeading(), per_cycle_odometry.getHeading(), 1e-12);
+}
+
+TEST(TestOdometry, pose_covariance_grows_with_travelled_distance)
+{
+  diff_drive_controller::Odometry odometry;
+  odometry.setWheelParams(0.4, 0.1, 0.1);
+  odometry.setPoseCovarianceParams(true, 0.001, 0.002, 0.003, 0.01, 0.02);
+  odometry.init(rclcpp::Time(0, 0, RCL_ROS_TIME));
+
+  // 1 m straight ahead: only the variance along the motion grows
+  for (int i = 1; i <= 100; ++i)
+  {
+    odometry.update(0.1 * i, 0.1 * i, rclcpp::Time(i * 10000000, RCL_ROS_TIME));
+  }
+  auto covariance = odometry.getPoseCovariance();
+  EXPECT_NEAR(covariance[0], 0.001 + 0.01 * 1.0, 1e-9);
+  EXPECT_NEAR(covariance[8], 0.003, 1e-9);
+
+  // then a turn: the heading variance grows with the turned angle and is carried into y
+  for (int i = 1; i <= 100; ++i)
+  {
+    odometry.update(
+      10.0 + 0.05 * i, 10.0 + 0.15 * i, rclcpp::Time((100 + i) * 10000000, RCL_ROS_TIME));
+  }
+  covariance = odometry.getPoseCovariance();
+  EXPECT_NEAR(covariance[8], 0.003 + 0.02 * 2.5, 1e-9);
+  EXPECT_GT(covariance[4], 0.002);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      EXPECT_NEAR(covariance[3 * i + j], covariance[3 * j + i], 1e-12);
+    }
+    EXPECT_GT(covariance[3 * i + i], 0.0);
+  }
+
+  odometry.resetOdometry();
+  EXPECT_DOUBLE_EQ(odometry.getPoseCovariance()[0], 0.001);
+  EXPECT_DOUBLE_EQ(odometry.getPoseCovariance()[4], 0.002);
+  EXPECT_DOUBLE_EQ(odometry.getPoseCovariance()[1], 0.0);
+}
+
+TEST(TestWheelSlipDetector, slipping_wheels_are_excluded)
+{
+  diff_drive_controller::WheelSlipDetector detector;
+  detector.configure(3, 1.0);
+
+  // wheels that agree are all kept
+  const std::array<double, 3> agreeing = {2.0, 2.2, 1.9};
+  EXPECT_NEAR(detector.fuseVelocities(agreeing.data()), 6.1 / 3.0, 1e-12);
+  EXPECT_EQ(detector.slippingCount(), 0u);
+
+  // a spinning wheel is excluded
+  const std::array<double, 3> spinning = {2.0, 8.0, 2.0};
+  EXPECT_NEAR(detector.fuseVelocities(spinning.data()), 2.0, 1e-12);
+  EXPECT_EQ(detector.slippingCount(), 1u);
+  EXPECT_FALSE(detector.isSlipping(0));
+  EXPECT_TRUE(detector.isSlipping(1));
+  EXPECT_FALSE(detector.isSlipping(2));
+
+  // the fused position advances with the wheels that don't slip
+  const std::array<double, 3> initial_positions = {1.0, 2.0, 3.0};
+  const std::array<double, 3> moved_positions = {1.2, 2.2, 3.2};
+  const std::array<double, 3> slipped_positions = {1.4, 3.2, 3.4};
+  EXPECT_NEAR(detector.fusePositions(initial_positions.data(), 0.1), 2.0, 1e-12);
+  EXPECT_NEAR(detector.fusePositions(moved_positions.data(), 0.1), 2.2, 1e-12);
+  EXPECT_NEAR(detector.fusePositions(slipped_positions.data(), 0.1), 2.4, 1e-12);
+  EXPECT_TRUE(detector.isSlipping(1));
+
+  // after a reset, it starts again from the mean position
+  detector.reset();
+  EXPECT_EQ(detector.slippingCount(), 0u);
+  EXPECT_NEAR(detector.fusePositions(slipped_positions.data(), 0.1), 8.0 / 3.0, 1e-12);
+}
+
+TEST(TestFleetKinematics, matches_limiters_and_odometry_of_each_robot)
+{
+  diff_drive_controller::FleetKinematics::Parameters parameters;
+  parameters.wheel_separation = 0.4;
+  parameters.left_wheel_radius = 0.1;
+  parameters.right_wheel_radius = 0.11;
+  parameters.limiter_linear =
+    diff_drive_controller::SpeedLimiter(true, true, true, NAN, 1.0, NAN, 2.0, NAN, 20.0);
+  parameters.limiter_angular =
+    diff_drive_controller::SpeedLimiter(true, true, false, NAN, 1.5, NAN, 3.0);
+
+  const std::vector<double> linear_commands = {0.5, 2.0, 0.0, -1.0};
+  const std::vector<double> angular_commands = {0.0, 0.5, 1.0, -2.0};
+  const size_t num_robots = linear_commands.size();
+  diff_drive_controller::FleetKinematics fleet;
+  fleet.configure(num_robots, parameters);
+  ASSERT_EQ(fleet.size(), num_robots);
+
+  // each robot on its own, with the limiters and the odometry of the controller
+  std::vector<diff_drive_controller::Odometry> odometries(
+    num_robots, diff_drive_controller::Odometry(1));
+  std::vector<diff_drive_controller::SpeedLimiter::History<>> previous_linear(num_robots);
+  std::vector<diff_drive_controller::SpeedLimiter::History<>> previous_angular(num_robots);
+  for (auto & odometry : odometries)
+  {
+    odometry.setWheelParams(
+      parameters.wheel_separation, parameters.left_wheel_radius, parameters.right_wheel_radius);
+    odometry.init(rclcpp::Time(0, 0, RCL_ROS_TIME));
+  }
+  for (size_t i = 0; i < num_robots; ++i)
+  {
+    previous_linear[i].push(0.0);
+    previous_linear[i].push(0.0);
+    previous_angular[i].push(0.0);
+    previous_angular[i].push(0.0);
+  }
+
+  constexpr double dt = 0.01;
+  std::vector<double> left_velocities(num_robots), right_velocities(num_robots);
+  for (int step = 1; step <= 200; ++step)
+  {
+    // in two ranges, e.g. from two threads
+    fleet.step(
+      linear_commands.data(), angular_commands.data(), dt, left_velocities.data(),
+      right_velocities.data(), 0, 1);
+    fleet.step(
+      linear_commands.data(), angular_commands.data(), dt, left_velocities.data(),
+      right_velocities.data(), 1, num_robots);
+
+    for (size_t i = 0; i < num_robots; ++i)
+    {
+      double linear = linear_commands[i];
+      double angular = angular_commands[i];
+      parameters.limiter_linear.limit(linear, previous_linear[i], dt);
+      parameters.limiter_angular.limit(angular, previous_angular[i], dt);
+      previous_linear[i].push(linear);
+      previous_angular[i].push(angular);
+      const double left = (linear - angular * 0.2) / parameters.left_wheel_radius;
+      const double right = (linear + angular * 0.2) / parameters.right_wheel_radius;
+      EXPECT_NEAR(left_velocities[i], left, 1e-12);
+      EXPECT_NEAR(right_velocities[i], right, 1e-12);
+      odometries[i].updateFromVelocity(
+        left * parameters.left_wheel_radius * dt, right * parameters.right_wheel_radius * dt,
+        rclcpp::Time(static_cast<int64_t>(step) * 10000000, RCL_ROS_TIME));
+    }
+  }
+  for (size_t i = 0; i < num_robots; ++i)
+  {
+    EXPECT_NEAR(fleet.x()[i], odometries[i].getX(), 1e-9);
+    EXPECT_NEAR(fleet.y()[i], odometries[i].getY(), 1e-9);
+    EXPECT_NEAR(fleet.heading()[i], odometries[i].getHeading(), 1e-9);
+    EXPECT_NEAR(fleet.linear()[i], odometries[i].getLinear(), 1e-9);
+    EXPECT_NEAR(fleet.angular()[i], odometries[i].getAngular(), 1e-9);
+  }
+  // the limits hold
+  EXPECT_NEAR(fleet.linear()[1], 1.0, 1e-9);
+  EXPECT_NEAR(fleet.angular()[3], -1.5, 1e-9);
+
+  fleet.reset();
+  EXPECT_EQ(fleet.x()[1], 0.0);
+  EXPECT_EQ(fleet.linear()[1], 0.0);
+}
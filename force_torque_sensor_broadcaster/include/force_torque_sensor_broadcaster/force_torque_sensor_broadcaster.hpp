@@ -19,22 +19,54 @@
 #ifndef FORCE_TORQUE_SENSOR_BROADCASTER__FORCE_TORQUE_SENSOR_BROADCASTER_HPP_
 #define FORCE_TORQUE_SENSOR_BROADCASTER__FORCE_TORQUE_SENSOR_BROADCASTER_HPP_
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/biquad_filter.hpp"
+#include "controller_realtime_tools/new_sample_detector.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+#include "controller_realtime_tools/seqlock.hpp"
+#include "controller_realtime_tools/smoothing_filter.hpp"
 #include "force_torque_sensor_broadcaster/visibility_control.h"
 // auto-generated by generate_parameter_library
 #include "force_torque_sensor_broadcaster_parameters.hpp"
+#include "geometry_msgs/msg/transform.hpp"
 #include "geometry_msgs/msg/wrench_stamped.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_publisher.h"
 #include "semantic_components/force_torque_sensor.hpp"
+#include "std_srvs/srv/trigger.hpp"
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
 
 namespace force_torque_sensor_broadcaster
 {
+/**
+ * \brief Broadcaster of the readings of a force/torque sensor.
+ *
+ * Every reading is filtered per axis, then the offset is subtracted. Axes without a value, NaN,
+ * are passed through and restart their filter. If target_frame is set, the wrench is then
+ * transformed from frame_id to it, with a transform looked up on a timer outside of the realtime
+ * loop.
+ *
+ * Publishes to:
+ * - \b wrench (geometry_msgs::msg::WrenchStamped): Reading of every decimation-th update.
+ *
+ * If reference_interfaces_prefix is set, the wrench of every update is also written to the
+ * reference interfaces of a following controller, e.g. the admittance controller, which uses it in
+ * the same control cycle.
+ *
+ * Service:
+ * - \b tare (std_srvs::srv::Trigger): Take the latest filtered reading as the offset, so the
+ * published wrench is zero in the current load.
+ */
 class ForceTorqueSensorBroadcaster : public controller_interface::ControllerInterface
 {
 public:
@@ -65,15 +97,80 @@ public:
   controller_interface::return_type update(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
+  // Largest moving average window, the filters are preallocated for it:
+  static constexpr size_t MAX_FILTER_WINDOW_SIZE = 256;
+
 protected:
+  using Wrench = std::array<double, 6>;
+  //  Row-major 6x6 matrix mapping a wrench to another frame
+  using Adjoint = std::array<double, 36>;
+
+  struct TargetTransform
+  {
+    bool valid = false;  // Whether the transform has been looked up
+    Adjoint adjoint{};   // Maps a wrench in frame_id to target_frame
+  };
+
+  enum class FilterType
+  {
+    NONE,
+    MOVING_AVERAGE,
+    BUTTERWORTH,
+  };
+
+  void tare(
+    const std::shared_ptr<std_srvs::srv::Trigger::Request> request,
+    std::shared_ptr<std_srvs::srv::Trigger::Response> response);
+
+  /// Filter \p wrench in place. Realtime-safe.
+  void filter(Wrench & wrench);
+
+  /// Adjoint mapping a wrench in the child frame of \p transform to its parent frame.
+  static Adjoint wrench_adjoint(const geometry_msgs::msg::Transform & transform);
+
+  /// Look up the transform from frame_id to target_frame for update(). Not realtime-safe.
+  void lookup_target_transform();
+
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
 
   std::unique_ptr<semantic_components::ForceTorqueSensor> force_torque_sensor_;
 
-  using StatePublisher = realtime_tools::RealtimePublisher<geometry_msgs::msg::WrenchStamped>;
+  using StatePublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    geometry_msgs::msg::WrenchStamped, rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>>;
   rclcpp::Publisher<geometry_msgs::msg::WrenchStamped>::SharedPtr sensor_state_publisher_;
   std::unique_ptr<StatePublisher> realtime_publisher_;
+  //  Written by update() and swapped into realtime_publisher_
+  geometry_msgs::msg::WrenchStamped wrench_msg_;
+  //  Updates since the last message
+  int64_t decimation_counter_ = 0;
+  controller_realtime_tools::NewSampleDetector new_sample_detector_;
+
+  FilterType filter_type_ = FilterType::NONE;
+  std::array<controller_realtime_tools::SmoothingFilter<MAX_FILTER_WINDOW_SIZE>, 6>
+    moving_average_filters_;
+  std::array<controller_realtime_tools::BiquadFilter, 6> butterworth_filters_;
+
+  //  Latest filtered reading, written by update() for tare()
+  controller_realtime_tools::Seqlock<Wrench> filtered_wrench_;
+  //  Offset subtracted by update(), written by on_configure() and tare()
+  controller_realtime_tools::Seqlock<Wrench> offset_;
+  //  serializes the writers of offset_
+  std::mutex offset_mutex_;
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr tare_service_;
+
+  std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
+  std::unique_ptr<tf2_ros::TransformListener> tf_listener_;
+  //  Transform applied by update(), written by on_configure() and lookup_target_transform()
+  controller_realtime_tools::Seqlock<TargetTransform> target_transform_;
+  //  serializes the writers of target_transform_
+  std::mutex target_transform_mutex_;
+  rclcpp::TimerBase::SharedPtr target_transform_timer_;
+
+  //  Reference interfaces <prefix>/force.x, ..., <prefix>/torque.z, in this order
+  std::vector<std::string> wrench_reference_names_;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>
+    wrench_reference_interfaces_;
 };
 
 }  // namespace force_torque_sensor_broadcaster
@@ -18,11 +18,25 @@
 
 #include "force_torque_sensor_broadcaster/force_torque_sensor_broadcaster.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <memory>
 #include <string>
+#include <tuple>
+
+#include "controller_interface/helpers.hpp"
+#include "tf2/exceptions.h"
 
 namespace force_torque_sensor_broadcaster
 {
+namespace
+{
+// seconds between lookups of a transform to the target frame, until it is available
+constexpr double kTargetTransformRetryPeriod = 1.0;
+}  // namespace
+
 ForceTorqueSensorBroadcaster::ForceTorqueSensorBroadcaster()
 : controller_interface::ControllerInterface()
 {
@@ -47,6 +61,8 @@ controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_init()
 controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_configure(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
+  // stop looking up the transform of the previous configuration before changing it
+  target_transform_timer_.reset();
   params_ = param_listener_->get_params();
 
   const bool no_interface_names_defined =
@@ -87,12 +103,94 @@ controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_configure(
         torque_names.z));
   }
 
+  if (params_.filter.type == "moving_average")
+  {
+    filter_type_ = FilterType::MOVING_AVERAGE;
+    for (auto & moving_average_filter : moving_average_filters_)
+    {
+      moving_average_filter.configure(
+        static_cast<size_t>(params_.filter.window_size),
+        controller_realtime_tools::SmoothingMode::MEAN);
+    }
+  }
+  else if (params_.filter.type == "butterworth")
+  {
+    filter_type_ = FilterType::BUTTERWORTH;
+    const double sampling_frequency = params_.filter.sampling_frequency > 0.0
+                                        ? params_.filter.sampling_frequency
+                                        : static_cast<double>(get_update_rate());
+    for (auto & butterworth_filter : butterworth_filters_)
+    {
+      if (!butterworth_filter.configure_butterworth_low_pass(
+            params_.filter.cutoff_frequency, sampling_frequency))
+      {
+        RCLCPP_ERROR(
+          get_node()->get_logger(),
+          "'filter.cutoff_frequency' (%f Hz) has to be below half of the sampling frequency (%f "
+          "Hz).",
+          params_.filter.cutoff_frequency, sampling_frequency);
+        return controller_interface::CallbackReturn::ERROR;
+      }
+    }
+  }
+  else
+  {
+    filter_type_ = FilterType::NONE;
+  }
+
+  wrench_reference_names_.clear();
+  if (!params_.reference_interfaces_prefix.empty())
+  {
+    for (const auto & interface :
+         {"force.x", "force.y", "force.z", "torque.x", "torque.y", "torque.z"})
+    {
+      wrench_reference_names_.push_back(params_.reference_interfaces_prefix + "/" + interface);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(offset_mutex_);
+    Wrench offset;
+    std::copy(params_.offset.begin(), params_.offset.end(), offset.begin());
+    offset_.write(offset);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(target_transform_mutex_);
+    target_transform_.write(TargetTransform());
+  }
+  if (!params_.target_frame.empty())
+  {
+    tf_buffer_ = std::make_unique<tf2_ros::Buffer>(get_node()->get_clock());
+    tf_listener_ = std::make_unique<tf2_ros::TransformListener>(*tf_buffer_, get_node());
+    // without a refresh period the lookup is retried until it succeeds once
+    const double lookup_period = params_.target_frame_refresh_period > 0.0
+                                   ? params_.target_frame_refresh_period
+                                   : kTargetTransformRetryPeriod;
+    target_transform_timer_ = get_node()->create_wall_timer(
+      rclcpp::Duration::from_seconds(lookup_period).to_chrono<std::chrono::nanoseconds>(),
+      std::bind(&ForceTorqueSensorBroadcaster::lookup_target_transform, this));
+  }
+  else
+  {
+    tf_listener_.reset();
+    tf_buffer_.reset();
+  }
+
   try
   {
     // register ft sensor data publisher
     sensor_state_publisher_ = get_node()->create_publisher<geometry_msgs::msg::WrenchStamped>(
       "~/wrench", rclcpp::SystemDefaultsQoS());
-    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_);
+    wrench_msg_ = geometry_msgs::msg::WrenchStamped();
+    wrench_msg_.header.frame_id =
+      params_.target_frame.empty() ? params_.frame_id : params_.target_frame;
+    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_, wrench_msg_);
+
+    tare_service_ = get_node()->create_service<std_srvs::srv::Trigger>(
+      "~/tare", std::bind(
+                  &ForceTorqueSensorBroadcaster::tare, this, std::placeholders::_1,
+                  std::placeholders::_2));
   }
   catch (const std::exception & e)
   {
@@ -102,9 +200,14 @@ controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_configure(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  realtime_publisher_->lock();
-  realtime_publisher_->msg_.header.frame_id = params_.frame_id;
-  realtime_publisher_->unlock();
+  // keep the publishing threads off the realtime CPUs
+  const auto scheduling = controller_realtime_tools::make_thread_scheduling(
+    params_.non_realtime_threads.priority, params_.non_realtime_threads.cpu_affinity);
+  if (!realtime_publisher_->set_scheduling(scheduling))
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(), "Could not set the scheduling of the publishing threads.");
+  }
 
   RCLCPP_DEBUG(get_node()->get_logger(), "configure successful");
   return controller_interface::CallbackReturn::SUCCESS;
@@ -114,7 +217,15 @@ controller_interface::InterfaceConfiguration
 ForceTorqueSensorBroadcaster::command_interface_configuration() const
 {
   controller_interface::InterfaceConfiguration command_interfaces_config;
-  command_interfaces_config.type = controller_interface::interface_configuration_type::NONE;
+  if (wrench_reference_names_.empty())
+  {
+    command_interfaces_config.type = controller_interface::interface_configuration_type::NONE;
+  }
+  else
+  {
+    command_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+    command_interfaces_config.names = wrench_reference_names_;
+  }
   return command_interfaces_config;
 }
 
@@ -124,6 +235,12 @@ ForceTorqueSensorBroadcaster::state_interface_configuration() const
   controller_interface::InterfaceConfiguration state_interfaces_config;
   state_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
   state_interfaces_config.names = force_torque_sensor_->get_state_interface_names();
+  const auto & detection = params_.new_sample_detection;
+  if (detection.enable && !detection.sequence_interface.empty())
+  {
+    // claimed last, the sensor reads the interfaces before it
+    state_interfaces_config.names.push_back(detection.sequence_interface);
+  }
   return state_interfaces_config;
 }
 
@@ -131,6 +248,29 @@ controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_activate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   force_torque_sensor_->assign_loaned_state_interfaces(state_interfaces_);
+  wrench_reference_interfaces_.clear();
+  if (
+    !wrench_reference_names_.empty() &&
+    !controller_interface::get_ordered_interfaces(
+      command_interfaces_, wrench_reference_names_, std::string(""), wrench_reference_interfaces_))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Expected the %zu reference interfaces with prefix '%s'.",
+      wrench_reference_names_.size(), params_.reference_interfaces_prefix.c_str());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  // the first update is published
+  decimation_counter_ = params_.decimation - 1;
+  for (auto & moving_average_filter : moving_average_filters_)
+  {
+    moving_average_filter.reset();
+  }
+  for (auto & butterworth_filter : butterworth_filters_)
+  {
+    butterworth_filter.reset();
+  }
+  new_sample_detector_.reset(
+    params_.new_sample_detection.sequence_interface.empty() ? std::tuple_size<Wrench>::value : 1);
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
@@ -138,22 +278,205 @@ controller_interface::CallbackReturn ForceTorqueSensorBroadcaster::on_deactivate
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   force_torque_sensor_->release_interfaces();
+  wrench_reference_interfaces_.clear();
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
 controller_interface::return_type ForceTorqueSensorBroadcaster::update(
   const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
 {
-  if (realtime_publisher_ && realtime_publisher_->trylock())
+  const auto forces = force_torque_sensor_->get_forces();
+  const auto torques = force_torque_sensor_->get_torques();
+  Wrench wrench{forces[0], forces[1], forces[2], torques[0], torques[1], torques[2]};
+  // the filters run at the sampling frequency of the sensor, a repeated sample is skipped
+  if (params_.new_sample_detection.enable)
+  {
+    const bool new_sample = params_.new_sample_detection.sequence_interface.empty()
+                              ? new_sample_detector_.is_new(wrench.data())
+                              : new_sample_detector_.is_new(state_interfaces_.back().get_value());
+    if (!new_sample)
+    {
+      return controller_interface::return_type::OK;
+    }
+  }
+  filter(wrench);
+  filtered_wrench_.write(wrench);
+
+  Wrench offset;
+  offset_.read(offset);
+  for (size_t i = 0; i < wrench.size(); ++i)
+  {
+    wrench[i] -= offset[i];
+  }
+
+  if (!params_.target_frame.empty())
+  {
+    TargetTransform target_transform;
+    target_transform_.read(target_transform);
+    // a wrench in the wrong frame is worse than none
+    if (!target_transform.valid)
+    {
+      return controller_interface::return_type::OK;
+    }
+    Wrench transformed{};
+    for (size_t i = 0; i < transformed.size(); ++i)
+    {
+      for (size_t j = 0; j < wrench.size(); ++j)
+      {
+        // a missing axis counts as zero, rather than turning every axis NaN
+        if (!std::isnan(wrench[j]))
+        {
+          transformed[i] += target_transform.adjoint[6 * i + j] * wrench[j];
+        }
+      }
+    }
+    wrench = transformed;
+  }
+
+  for (size_t i = 0; i < wrench_reference_interfaces_.size(); ++i)
+  {
+    wrench_reference_interfaces_[i].get().set_value(wrench[i]);
+  }
+
+  // a busy publisher delays the reading to the next update rather than a whole period
+  if (realtime_publisher_ && ++decimation_counter_ >= params_.decimation)
   {
-    realtime_publisher_->msg_.header.stamp = time;
-    force_torque_sensor_->get_values_as_message(realtime_publisher_->msg_.wrench);
-    realtime_publisher_->unlockAndPublish();
+    wrench_msg_.header.stamp = time;
+    wrench_msg_.wrench.force.x = wrench[0];
+    wrench_msg_.wrench.force.y = wrench[1];
+    wrench_msg_.wrench.force.z = wrench[2];
+    wrench_msg_.wrench.torque.x = wrench[3];
+    wrench_msg_.wrench.torque.y = wrench[4];
+    wrench_msg_.wrench.torque.z = wrench[5];
+    if (realtime_publisher_->try_publish(wrench_msg_))
+    {
+      decimation_counter_ = 0;
+    }
   }
 
   return controller_interface::return_type::OK;
 }
 
+void ForceTorqueSensorBroadcaster::filter(Wrench & wrench)
+{
+  for (size_t i = 0; i < wrench.size(); ++i)
+  {
+    if (std::isnan(wrench[i]))
+    {
+      // missing axis or reading, the filter starts again with the next one
+      moving_average_filters_[i].reset();
+      butterworth_filters_[i].reset();
+      continue;
+    }
+    switch (filter_type_)
+    {
+      case FilterType::MOVING_AVERAGE:
+        wrench[i] = moving_average_filters_[i].filter(wrench[i]);
+        break;
+      case FilterType::BUTTERWORTH:
+        wrench[i] = butterworth_filters_[i].filter(wrench[i]);
+        break;
+      case FilterType::NONE:
+        break;
+    }
+  }
+}
+
+void ForceTorqueSensorBroadcaster::tare(
+  const std::shared_ptr<std_srvs::srv::Trigger::Request> /*request*/,
+  std::shared_ptr<std_srvs::srv::Trigger::Response> response)
+{
+  Wrench offset;
+  if (filtered_wrench_.read(offset) == 0)
+  {
+    response->success = false;
+    response->message = "No reading to tare yet";
+    return;
+  }
+  for (auto & value : offset)
+  {
+    // keep the wrench of a missing axis NaN
+    if (std::isnan(value))
+    {
+      value = 0.0;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(offset_mutex_);
+    offset_.write(offset);
+  }
+  response->success = true;
+  response->message = "Offset set to the latest reading";
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Tared to force [%f, %f, %f] and torque [%f, %f, %f]", offset[0],
+    offset[1], offset[2], offset[3], offset[4], offset[5]);
+}
+
+ForceTorqueSensorBroadcaster::Adjoint ForceTorqueSensorBroadcaster::wrench_adjoint(
+  const geometry_msgs::msg::Transform & transform)
+{
+  const double x = transform.rotation.x;
+  const double y = transform.rotation.y;
+  const double z = transform.rotation.z;
+  const double w = transform.rotation.w;
+  const std::array<std::array<double, 3>, 3> rotation = {{
+    {1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - z * w), 2.0 * (x * z + y * w)},
+    {2.0 * (x * y + z * w), 1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - x * w)},
+    {2.0 * (x * z - y * w), 2.0 * (y * z + x * w), 1.0 - 2.0 * (x * x + y * y)},
+  }};
+  const std::array<std::array<double, 3>, 3> translation_cross = {{
+    {0.0, -transform.translation.z, transform.translation.y},
+    {transform.translation.z, 0.0, -transform.translation.x},
+    {-transform.translation.y, transform.translation.x, 0.0},
+  }};
+
+  // force' = R force, torque' = R torque + t x (R force)
+  Adjoint adjoint{};
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      adjoint[6 * i + j] = rotation[i][j];
+      adjoint[6 * (i + 3) + j + 3] = rotation[i][j];
+      for (size_t k = 0; k < 3; ++k)
+      {
+        adjoint[6 * (i + 3) + j] += translation_cross[i][k] * rotation[k][j];
+      }
+    }
+  }
+  return adjoint;
+}
+
+void ForceTorqueSensorBroadcaster::lookup_target_transform()
+{
+  geometry_msgs::msg::TransformStamped transform;
+  try
+  {
+    transform =
+      tf_buffer_->lookupTransform(params_.target_frame, params_.frame_id, tf2::TimePointZero);
+  }
+  catch (const tf2::TransformException & e)
+  {
+    RCLCPP_WARN_THROTTLE(
+      get_node()->get_logger(), *(get_node()->get_clock()), 5000,
+      "Waiting for the transform from '%s' to '%s': %s", params_.frame_id.c_str(),
+      params_.target_frame.c_str(), e.what());
+    return;
+  }
+
+  TargetTransform target_transform;
+  target_transform.valid = true;
+  target_transform.adjoint = wrench_adjoint(transform.transform);
+  {
+    std::lock_guard<std::mutex> guard(target_transform_mutex_);
+    target_transform_.write(target_transform);
+  }
+  if (params_.target_frame_refresh_period <= 0.0)
+  {
+    target_transform_timer_->cancel();
+  }
+}
+
 }  // namespace force_torque_sensor_broadcaster
 
 #include "pluginlib/class_list_macros.hpp"
@@ -18,18 +18,25 @@
 
 #include "test_force_torque_sensor_broadcaster.hpp"
 
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "force_torque_sensor_broadcaster/force_torque_sensor_broadcaster.hpp"
 #include "geometry_msgs/msg/wrench_stamped.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
 #include "hardware_interface/loaned_state_interface.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/utilities.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+#include "std_srvs/srv/trigger.hpp"
 
 using hardware_interface::LoanedStateInterface;
 
@@ -293,6 +300,308 @@ TEST_F(ForceTorqueSensorBroadcasterTest, All_InterfaceNames_Publish_Success)
   ASSERT_EQ(wrench_msg.wrench.torque.z, sensor_values_[5]);
 }
 
+TEST_F(ForceTorqueSensorBroadcasterTest, Offset_Publish_Success)
+{
+  SetUpFTSBroadcaster();
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  fts_broadcaster_->get_node()->set_parameter(
+    {"offset", std::vector<double>{0.1, 0.2, 0.3, 0.4, 0.5, 0.6}});
+
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  geometry_msgs::msg::WrenchStamped wrench_msg;
+  subscribe_and_get_message(wrench_msg);
+
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.force.x, sensor_values_[0] - 0.1);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.force.y, sensor_values_[1] - 0.2);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.force.z, sensor_values_[2] - 0.3);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.torque.x, sensor_values_[3] - 0.4);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.torque.y, sensor_values_[4] - 0.5);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.torque.z, sensor_values_[5] - 0.6);
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, MovingAverage_Filter_Success)
+{
+  SetUpFTSBroadcaster();
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  fts_broadcaster_->get_node()->set_parameter({"filter.type", "moving_average"});
+  fts_broadcaster_->get_node()->set_parameter({"filter.window_size", 2});
+
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  std::array<double, 6> wrench = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  fts_broadcaster_->filter(wrench);
+  EXPECT_THAT(wrench, ::testing::ElementsAre(1.0, 2.0, 3.0, 4.0, 5.0, 6.0));
+  wrench = {3.0, 4.0, 5.0, 6.0, 7.0, std::numeric_limits<double>::quiet_NaN()};
+  fts_broadcaster_->filter(wrench);
+  EXPECT_DOUBLE_EQ(wrench[0], 2.0);
+  EXPECT_DOUBLE_EQ(wrench[4], 6.0);
+  // a missing value is passed through and restarts the filter of its axis
+  EXPECT_TRUE(std::isnan(wrench[5]));
+  wrench = {3.0, 4.0, 5.0, 6.0, 7.0, 8.0};
+  fts_broadcaster_->filter(wrench);
+  EXPECT_DOUBLE_EQ(wrench[0], 3.0);
+  EXPECT_DOUBLE_EQ(wrench[5], 8.0);
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, Butterworth_Filter_Success)
+{
+  SetUpFTSBroadcaster();
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  fts_broadcaster_->get_node()->set_parameter({"filter.type", "butterworth"});
+  fts_broadcaster_->get_node()->set_parameter({"filter.cutoff_frequency", 600.0});
+  fts_broadcaster_->get_node()->set_parameter({"filter.sampling_frequency", 1000.0});
+
+  // the cutoff frequency has to be below half of the sampling frequency
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+
+  fts_broadcaster_->get_node()->set_parameter({"filter.cutoff_frequency", 10.0});
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // a constant reading passes, a step is smoothed
+  std::array<double, 6> wrench = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+  fts_broadcaster_->filter(wrench);
+  EXPECT_NEAR(wrench[0], 1.0, 1e-12);
+  wrench.fill(2.0);
+  fts_broadcaster_->filter(wrench);
+  EXPECT_GT(wrench[0], 1.0);
+  EXPECT_LT(wrench[0], 1.1);
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, Tare_Publish_Success)
+{
+  SetUpFTSBroadcaster();
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto request = std::make_shared<std_srvs::srv::Trigger::Request>();
+  auto response = std::make_shared<std_srvs::srv::Trigger::Response>();
+  // nothing to tare before the first reading
+  fts_broadcaster_->tare(request, response);
+  EXPECT_FALSE(response->success);
+
+  ASSERT_EQ(
+    fts_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  fts_broadcaster_->tare(request, response);
+  EXPECT_TRUE(response->success);
+
+  // the offset applies from the next update on
+  sensor_values_[0] += 1.0;
+  geometry_msgs::msg::WrenchStamped wrench_msg;
+  subscribe_and_get_message(wrench_msg);
+
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.force.x, 1.0);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.force.y, 0.0);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.force.z, 0.0);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.torque.x, 0.0);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.torque.y, 0.0);
+  EXPECT_DOUBLE_EQ(wrench_msg.wrench.torque.z, 0.0);
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, Decimation_Publish_Success)
+{
+  SetUpFTSBroadcaster();
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  fts_broadcaster_->get_node()->set_parameter({"decimation", 3});
+
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription = test_subscription_node.create_subscription<geometry_msgs::msg::WrenchStamped>(
+    "/test_force_torque_sensor_broadcaster/wrench", 10,
+    [](const geometry_msgs::msg::WrenchStamped::SharedPtr) {});
+
+  for (int64_t i = 0; i < 7; ++i)
+  {
+    ASSERT_EQ(
+      fts_broadcaster_->update(rclcpp::Time(i * 1000000), rclcpp::Duration::from_seconds(0.001)),
+      controller_interface::return_type::OK);
+    // let the realtime publisher send the message, so it isn't busy on the next update
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // the first of every three updates is published
+  std::vector<int64_t> stamps;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (wait_set.wait(std::chrono::milliseconds(100)).kind() == rclcpp::WaitResultKind::Ready)
+  {
+    geometry_msgs::msg::WrenchStamped wrench_msg;
+    rclcpp::MessageInfo msg_info;
+    if (!subscription->take(wrench_msg, msg_info))
+    {
+      break;
+    }
+    stamps.push_back(rclcpp::Time(wrench_msg.header.stamp).nanoseconds());
+  }
+  EXPECT_THAT(stamps, ::testing::ElementsAre(0, 3000000, 6000000));
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, NewSampleDetection_Publish_Success)
+{
+  SetUpFTSBroadcaster();
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  fts_broadcaster_->get_node()->set_parameter({"new_sample_detection.enable", true});
+
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription = test_subscription_node.create_subscription<geometry_msgs::msg::WrenchStamped>(
+    "/test_force_torque_sensor_broadcaster/wrench", 10,
+    [](const geometry_msgs::msg::WrenchStamped::SharedPtr) {});
+
+  // the sensor samples every third update
+  for (int64_t i = 0; i < 7; ++i)
+  {
+    sensor_values_[5] = static_cast<double>(i / 3);
+    ASSERT_EQ(
+      fts_broadcaster_->update(rclcpp::Time(i * 1000000), rclcpp::Duration::from_seconds(0.001)),
+      controller_interface::return_type::OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::vector<int64_t> stamps;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (wait_set.wait(std::chrono::milliseconds(100)).kind() == rclcpp::WaitResultKind::Ready)
+  {
+    geometry_msgs::msg::WrenchStamped wrench_msg;
+    rclcpp::MessageInfo msg_info;
+    if (!subscription->take(wrench_msg, msg_info))
+    {
+      break;
+    }
+    stamps.push_back(rclcpp::Time(wrench_msg.header.stamp).nanoseconds());
+  }
+  EXPECT_THAT(stamps, ::testing::ElementsAre(0, 3000000, 6000000));
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, WrenchReferences_Update_Success)
+{
+  const auto result = fts_broadcaster_->init("test_force_torque_sensor_broadcaster");
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  fts_broadcaster_->get_node()->set_parameter(
+    {"reference_interfaces_prefix", "admittance_controller/ft_sensor"});
+  fts_broadcaster_->get_node()->set_parameter(
+    {"offset", std::vector<double>{1.0, 1.0, 1.0, 1.0, 1.0, 1.0}});
+
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  const auto command_interfaces = fts_broadcaster_->command_interface_configuration();
+  ASSERT_EQ(
+    command_interfaces.type, controller_interface::interface_configuration_type::INDIVIDUAL);
+  ASSERT_EQ(command_interfaces.names.size(), 6u);
+  EXPECT_EQ(command_interfaces.names.front(), "admittance_controller/ft_sensor/force.x");
+  EXPECT_EQ(command_interfaces.names.back(), "admittance_controller/ft_sensor/torque.z");
+
+  // the reference interfaces of the following controller, loaned in any order
+  std::array<double, 6> references;
+  references.fill(0.0);
+  const std::vector<std::string> names = {"torque.z", "force.x",  "force.y",
+                                          "force.z",  "torque.x", "torque.y"};
+  const std::vector<size_t> indices = {5, 0, 1, 2, 3, 4};
+  std::vector<hardware_interface::CommandInterface> reference_itfs;
+  reference_itfs.reserve(names.size());
+  std::vector<hardware_interface::LoanedCommandInterface> command_ifs;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    reference_itfs.emplace_back(
+      "admittance_controller/ft_sensor", names[i], &references[indices[i]]);
+    command_ifs.emplace_back(reference_itfs.back());
+  }
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(fts_force_x_);
+  state_ifs.emplace_back(fts_force_y_);
+  state_ifs.emplace_back(fts_force_z_);
+  state_ifs.emplace_back(fts_torque_x_);
+  state_ifs.emplace_back(fts_torque_y_);
+  state_ifs.emplace_back(fts_torque_z_);
+  fts_broadcaster_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(
+    fts_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  // the tared wrench
+  for (size_t i = 0; i < references.size(); ++i)
+  {
+    EXPECT_DOUBLE_EQ(references[i], sensor_values_[i] - 1.0);
+  }
+}
+
+TEST_F(ForceTorqueSensorBroadcasterTest, TargetFrame_Publish_Success)
+{
+  SetUpFTSBroadcaster();
+
+  fts_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  fts_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  fts_broadcaster_->get_node()->set_parameter({"target_frame", "tool_frame"});
+
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // without a transform nothing is published
+  {
+    rclcpp::Node test_subscription_node("test_subscription_node");
+    auto subscription =
+      test_subscription_node.create_subscription<geometry_msgs::msg::WrenchStamped>(
+        "/test_force_torque_sensor_broadcaster/wrench", 10,
+        [](const geometry_msgs::msg::WrenchStamped::SharedPtr) {});
+    ASSERT_EQ(
+      fts_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    rclcpp::WaitSet wait_set;
+    wait_set.add_subscription(subscription);
+    EXPECT_NE(
+      wait_set.wait(std::chrono::milliseconds(50)).kind(), rclcpp::WaitResultKind::Ready);
+  }
+
+  // the sensor frame is rotated by 90 degrees around z and 1 m above the tool frame
+  geometry_msgs::msg::Transform transform;
+  transform.translation.z = 1.0;
+  transform.rotation.z = std::sin(M_PI / 4.0);
+  transform.rotation.w = std::cos(M_PI / 4.0);
+  FriendForceTorqueSensorBroadcaster::TargetTransform target_transform;
+  target_transform.valid = true;
+  target_transform.adjoint = FriendForceTorqueSensorBroadcaster::wrench_adjoint(transform);
+  fts_broadcaster_->target_transform_.write(target_transform);
+
+  geometry_msgs::msg::WrenchStamped wrench_msg;
+  subscribe_and_get_message(wrench_msg);
+
+  EXPECT_EQ(wrench_msg.header.frame_id, "tool_frame");
+  EXPECT_NEAR(wrench_msg.wrench.force.x, -sensor_values_[1], 1e-9);
+  EXPECT_NEAR(wrench_msg.wrench.force.y, sensor_values_[0], 1e-9);
+  EXPECT_NEAR(wrench_msg.wrench.force.z, sensor_values_[2], 1e-9);
+  // the torque of the force in the tool frame adds to the rotated torque
+  EXPECT_NEAR(wrench_msg.wrench.torque.x, -sensor_values_[4] - sensor_values_[0], 1e-9);
+  EXPECT_NEAR(wrench_msg.wrench.torque.y, sensor_values_[3] - sensor_values_[1], 1e-9);
+  EXPECT_NEAR(wrench_msg.wrench.torque.z, sensor_values_[5], 1e-9);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
@@ -39,6 +39,11 @@ class FriendForceTorqueSensorBroadcaster
   FRIEND_TEST(ForceTorqueSensorBroadcasterTest, ActivateSuccess);
   FRIEND_TEST(ForceTorqueSensorBroadcasterTest, UpdateTest);
   FRIEND_TEST(ForceTorqueSensorBroadcasterTest, SensorStatePublishTest);
+
+  FRIEND_TEST(ForceTorqueSensorBroadcasterTest, MovingAverage_Filter_Success);
+  FRIEND_TEST(ForceTorqueSensorBroadcasterTest, Butterworth_Filter_Success);
+  FRIEND_TEST(ForceTorqueSensorBroadcasterTest, Tare_Publish_Success);
+  FRIEND_TEST(ForceTorqueSensorBroadcasterTest, TargetFrame_Publish_Success);
 };
 
 class ForceTorqueSensorBroadcasterTest : public ::testing::Test
@@ -41,6 +41,11 @@ TEST(TestLoadForceTorqueSensorBroadcaster, load_controller)
       "test_force_torque_sensor_broadcaster",
       "force_torque_sensor_broadcaster/ForceTorqueSensorBroadcaster"),
     nullptr);
+  ASSERT_NE(
+    cm.load_controller(
+      "test_multi_force_torque_sensor_broadcaster",
+      "force_torque_sensor_broadcaster/MultiForceTorqueSensorBroadcaster"),
+    nullptr);
 }
 
 int main(int argc, char ** argv)
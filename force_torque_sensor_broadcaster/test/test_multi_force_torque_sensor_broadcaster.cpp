@@ -0,0 +1,143 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "force_torque_sensor_broadcaster/multi_force_torque_sensor_broadcaster.hpp"
+#include "rclcpp/utilities.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+using hardware_interface::LoanedStateInterface;
+
+namespace
+{
+constexpr auto NODE_SUCCESS = controller_interface::CallbackReturn::SUCCESS;
+
+const std::vector<std::string> kSensorNames = {"fts_sensor_1", "fts_sensor_2"};
+const std::vector<std::string> kInterfaceNames = {"force.x",  "force.y",  "force.z",
+                                                  "torque.x", "torque.y", "torque.z"};
+}  // namespace
+
+class MultiForceTorqueSensorBroadcasterTest : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    fts_broadcaster_ =
+      std::make_unique<force_torque_sensor_broadcaster::MultiForceTorqueSensorBroadcaster>();
+    for (size_t i = 0; i < kSensorNames.size(); ++i)
+    {
+      for (size_t j = 0; j < kInterfaceNames.size(); ++j)
+      {
+        sensor_values_[i][j] = 10.0 * static_cast<double>(i + 1) + static_cast<double>(j);
+        state_interfaces_.emplace_back(kSensorNames[i], kInterfaceNames[j], &sensor_values_[i][j]);
+      }
+    }
+  }
+
+  void TearDown() { fts_broadcaster_.reset(nullptr); }
+
+  void SetUpFTSBroadcaster()
+  {
+    const auto result = fts_broadcaster_->init("test_multi_force_torque_sensor_broadcaster");
+    ASSERT_EQ(result, controller_interface::return_type::OK);
+
+    std::vector<LoanedStateInterface> state_ifs;
+    for (auto & state_interface : state_interfaces_)
+    {
+      state_ifs.emplace_back(state_interface);
+    }
+    fts_broadcaster_->assign_interfaces({}, std::move(state_ifs));
+  }
+
+protected:
+  std::array<std::array<double, 6>, 2> sensor_values_;
+  std::vector<hardware_interface::StateInterface> state_interfaces_;
+
+  std::unique_ptr<force_torque_sensor_broadcaster::MultiForceTorqueSensorBroadcaster>
+    fts_broadcaster_;
+};
+
+TEST_F(MultiForceTorqueSensorBroadcasterTest, StateInterfaceConfiguration_Success)
+{
+  SetUpFTSBroadcaster();
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  const auto config = fts_broadcaster_->state_interface_configuration();
+  ASSERT_EQ(config.names.size(), kSensorNames.size() * kInterfaceNames.size());
+  EXPECT_EQ(config.names.front(), "fts_sensor_1/force.x");
+  EXPECT_EQ(config.names.back(), "fts_sensor_2/torque.z");
+}
+
+TEST_F(MultiForceTorqueSensorBroadcasterTest, SensorStates_Publish_Success)
+{
+  SetUpFTSBroadcaster();
+  ASSERT_EQ(fts_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(fts_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription =
+    test_subscription_node.create_subscription<control_msgs::msg::DynamicJointState>(
+      "/test_multi_force_torque_sensor_broadcaster/wrenches", 10,
+      [](const control_msgs::msg::DynamicJointState::SharedPtr) {});
+
+  // since update doesn't guarantee a published message, republish until received
+  int max_sub_check_loop_count = 5;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (max_sub_check_loop_count--)
+  {
+    fts_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01));
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0);
+
+  control_msgs::msg::DynamicJointState wrenches_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(wrenches_msg, msg_info));
+
+  ASSERT_EQ(wrenches_msg.joint_names, kSensorNames);
+  ASSERT_EQ(wrenches_msg.interface_values.size(), kSensorNames.size());
+  for (size_t i = 0; i < kSensorNames.size(); ++i)
+  {
+    EXPECT_EQ(wrenches_msg.interface_values[i].interface_names, kInterfaceNames);
+    ASSERT_EQ(wrenches_msg.interface_values[i].values.size(), kInterfaceNames.size());
+    for (size_t j = 0; j < kInterfaceNames.size(); ++j)
+    {
+      EXPECT_EQ(wrenches_msg.interface_values[i].values[j], sensor_values_[i][j]);
+    }
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  rclcpp::init(argc, argv);
+  int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
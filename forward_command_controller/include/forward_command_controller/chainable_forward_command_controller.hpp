@@ -0,0 +1,58 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FORWARD_COMMAND_CONTROLLER__CHAINABLE_FORWARD_COMMAND_CONTROLLER_HPP_
+#define FORWARD_COMMAND_CONTROLLER__CHAINABLE_FORWARD_COMMAND_CONTROLLER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "forward_command_controller/chainable_forward_controllers_base.hpp"
+#include "forward_command_controller/visibility_control.h"
+// auto-generated by generate_parameter_library
+#include "forward_command_controller_parameters.hpp"
+
+namespace forward_command_controller
+{
+/**
+ * \brief Chainable forward command controller for a set of joints.
+ *
+ * This class forwards the command signal down to a set of joints on the specified interface,
+ * from the topic or, in chained mode, from its reference interfaces
+ * `<controller_name>/<joint>/<interface_name>`.
+ *
+ * \param joints Names of the joints to control.
+ * \param interface_name Name of the interface to command.
+ *
+ * Subscribes to:
+ * - \b commands (std_msgs::msg::Float64MultiArray) : The commands to apply.
+ */
+class ChainableForwardCommandController : public ChainableForwardControllersBase
+{
+public:
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  ChainableForwardCommandController();
+
+protected:
+  void declare_parameters() override;
+  controller_interface::CallbackReturn read_parameters() override;
+
+  std::shared_ptr<ParamListener> param_listener_;
+  Params params_;
+};
+
+}  // namespace forward_command_controller
+
+#endif  // FORWARD_COMMAND_CONTROLLER__CHAINABLE_FORWARD_COMMAND_CONTROLLER_HPP_
@@ -0,0 +1,154 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FORWARD_COMMAND_CONTROLLER__CHAINABLE_FORWARD_CONTROLLERS_BASE_HPP_
+#define FORWARD_COMMAND_CONTROLLER__CHAINABLE_FORWARD_CONTROLLERS_BASE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_realtime_tools/interface_order.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "forward_command_controller/forward_controllers_base.hpp"
+#include "forward_command_controller/visibility_control.h"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/subscription.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+namespace forward_command_controller
+{
+/**
+ * \brief Chainable forward command controller for a set of joints and interfaces.
+ *
+ * This class forwards the command signal down to a set of joints or interfaces, like
+ * ForwardControllersBase. It also exports a reference interface per command interface, named
+ * `<controller_name>/<command_interface>`, so a preceding controller can write the commands in
+ * the same control cycle.
+ *
+ * Received commands are always copied into buffers preallocated for the command interfaces.
+ * References which are NaN, e.g. before the first command, are not forwarded. If
+ * command_timeout_ is positive and the controller isn't chained, the references are set to
+ * safe_values_ once no command was received for that long, until the next command.
+ *
+ * Subscribes to:
+ * - \b commands (std_msgs::msg::Float64MultiArray) : The commands to apply, if not in chained
+ *   mode.
+ */
+class ChainableForwardControllersBase : public controller_interface::ChainableControllerInterface
+{
+public:
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  ChainableForwardControllersBase();
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_init() override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_configure(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_activate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+protected:
+  /**
+   * Derived controllers have to declare parameters in this method.
+   * Error handling does not have to be done. It is done in `on_init`-method of this class.
+   */
+  virtual void declare_parameters() = 0;
+
+  /**
+   * Derived controllers have to read parameters in this method and set `command_interface_types_`
+   * variable. The variable is then used to propagate the command interface configuration to
+   * controller manager and to name the reference interfaces. The method is called from
+   * `on_configure`-method of this class.
+   *
+   * It is expected that error handling of exceptions is done.
+   *
+   * \returns controller_interface::CallbackReturn::SUCCESS if parameters are successfully read and
+   * their values are allowed, controller_interface::CallbackReturn::ERROR otherwise.
+   */
+  virtual controller_interface::CallbackReturn read_parameters() = 0;
+
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
+  /// Handle a command received on the topic. Not realtime-safe.
+  void command_callback(const std::shared_ptr<CmdType> msg);
+
+  /// Drop the received commands and references. Not realtime-safe.
+  void reset_commands();
+
+  std::vector<std::string> command_interface_types_;
+  /// Index in command_interfaces_ of each of command_interface_types_, set on activation
+  std::vector<size_t> command_interface_indices_;
+  /// Finds command_interface_indices_ on activation, configured with command_interface_types_
+  controller_realtime_tools::InterfaceOrder command_interface_order_;
+
+  /// Loaned interface of command_interface_types_[\p index]. Realtime-safe.
+  hardware_interface::LoanedCommandInterface & command_interface(size_t index)
+  {
+    return command_interfaces_[command_interface_indices_[index]];
+  }
+
+  struct ReceivedCommands
+  {
+    std::vector<double> data;  // Command of every interface
+    bool received = false;     // Whether data holds a received command
+  };
+  /// Latest command received on the topic
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<ReceivedCommands>>
+    received_commands_;
+  // serializes the writers of received_commands_
+  std::mutex received_commands_mutex_;
+
+  /// Age after which a command is replaced by safe_values_, disabled if zero. Set by
+  /// read_parameters().
+  rclcpp::Duration command_timeout_ = rclcpp::Duration(0, 0);
+  /// Reference of every interface after a timeout, set by read_parameters()
+  std::vector<double> safe_values_;
+  /// Reception time of the last command in nanoseconds, written by command_callback()
+  std::atomic<int64_t> last_command_time_ns_{0};
+
+  rclcpp::Subscription<CmdType>::SharedPtr joints_command_subscriber_;
+};
+
+}  // namespace forward_command_controller
+
+#endif  // FORWARD_COMMAND_CONTROLLER__CHAINABLE_FORWARD_CONTROLLERS_BASE_HPP_
@@ -15,16 +15,28 @@
 #ifndef FORWARD_COMMAND_CONTROLLER__FORWARD_CONTROLLERS_BASE_HPP_
 #define FORWARD_COMMAND_CONTROLLER__FORWARD_CONTROLLERS_BASE_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/command_sequence.hpp"
+#include "controller_realtime_tools/latency_probe.hpp"
+#include "controller_realtime_tools/interface_order.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
 #include "forward_command_controller/visibility_control.h"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/publisher.hpp"
 #include "rclcpp/subscription.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp/timer.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 #include "realtime_tools/realtime_buffer.h"
+#include "statistics_msgs/msg/metrics_message.hpp"
 #include "std_msgs/msg/float64_multi_array.hpp"
 
 namespace forward_command_controller
@@ -38,6 +50,30 @@ using CmdType = std_msgs::msg::Float64MultiArray;
  *
  * Subscribes to:
  * - \b commands (std_msgs::msg::Float64MultiArray) : The commands to apply.
+ *
+ * If preallocate_commands_ is set, received commands are copied into buffers sized for the
+ * command interfaces at configuration, and the realtime loop takes the latest one without a lock
+ * or a reference count. Commands of the wrong size are then rejected when they are received. The
+ * realtime loop then only writes the interfaces changed by a new command, and it also subscribes
+ * to:
+ * - \b sparse_commands (std_msgs::msg::Float64MultiArray) : Pairs of an interface index and its
+ *   command, `[index_0, value_0, index_1, value_1, ...]`, applied on top of the last commands.
+ *
+ * If interpolation_period_ is positive, which needs preallocate_commands_, the commands ramp
+ * linearly from their values at the arrival of a new command to it within that period, so a low
+ * rate command source gives smooth commands at the control rate.
+ *
+ * If command_timeout_ is positive, safe_values_ are commanded once no command was received for
+ * that long, until the next command.
+ *
+ * If command_latency_publish_rate_ is positive, the latency from receiving a command to writing
+ * it is measured, and its statistics are published on:
+ * - \b command_latency (statistics_msgs::msg::MetricsMessage) : One message per stage.
+ *
+ * If command_sequences_ is set, the controller also claims the command interface
+ * <tt>\<interface\>_sequence</tt> of every command interface, and writes the sequence number of
+ * its command there, which only changes with the command, see
+ * controller_realtime_tools::CommandSequence.
  */
 class ForwardControllersBase : public controller_interface::ControllerInterface
 {
@@ -92,13 +128,112 @@ protected:
    */
   virtual controller_interface::CallbackReturn read_parameters() = 0;
 
+  /// Handle a command received on the topic. Not realtime-safe.
+  void command_callback(const std::shared_ptr<CmdType> msg);
+
+  /// Handle a sparse command, if preallocate_commands_ is set. Not realtime-safe.
+  void sparse_command_callback(const std::shared_ptr<CmdType> msg);
+
+  /// Hand merged_commands_ to the realtime loop as the command \p version. Not realtime-safe.
+  void publish_merged_commands(std::uint64_t version);
+
+  /// Drop the received commands. Not realtime-safe.
+  void reset_commands();
+
+  /// Whether the last command is older than command_timeout_ at \p time. Realtime-safe.
+  bool command_timed_out(const rclcpp::Time & time) const;
+
+  /// Command safe_values_ to every interface. Realtime-safe.
+  void write_safe_values();
+
+  /// Publish the command latency statistics since the last call. Not realtime-safe.
+  void publish_command_latency();
+
+  /// Write the commands of this cycle. Realtime-safe.
+  controller_interface::return_type write_commands(const rclcpp::Time & time);
+
+  /// Write the sequence numbers of the commands written in this cycle. Realtime-safe.
+  void write_command_sequences();
+
   std::vector<std::string> joint_names_;
   std::string interface_name_;
 
   std::vector<std::string> command_interface_types_;
+  /// Index in command_interfaces_ of each of command_interface_types_, followed by their
+  /// sequence interfaces, set on activation
+  std::vector<size_t> command_interface_indices_;
+  /// Finds command_interface_indices_ on activation, configured with command_interface_types_
+  /// and their sequence interfaces
+  controller_realtime_tools::InterfaceOrder command_interface_order_;
+
+  /// Whether the sequence interfaces are claimed and written, set by read_parameters()
+  bool command_sequences_ = false;
+  /// nullptr unless command_sequences_ is set
+  std::unique_ptr<controller_realtime_tools::CommandSequence> command_sequence_;
+
+  /// Loaned interface of command_interface_types_[\p index], or of the sequence interface of
+  /// command \p index - size of command_interface_types_. Realtime-safe.
+  hardware_interface::LoanedCommandInterface & command_interface(size_t index)
+  {
+    return command_interfaces_[command_interface_indices_[index]];
+  }
 
   realtime_tools::RealtimeBuffer<std::shared_ptr<CmdType>> rt_command_ptr_;
+
+  /// Whether commands are copied into preallocated_commands_, set by read_parameters()
+  bool preallocate_commands_ = false;
+
+  struct PreallocatedCommands
+  {
+    std::vector<double> data;  // Command of every interface
+    bool received = false;     // Whether data holds a received command
+    // Commands are numbered from 1 on, each interface stores the last command which changed it,
+    // 0 if none did
+    std::uint64_t version = 0;
+    std::vector<std::uint64_t> versions;
+    std::int64_t stamp_ns = 0;  // Reception time of the command
+  };
+  /// Latest received command if preallocate_commands_ is set, nullptr otherwise
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<PreallocatedCommands>>
+    preallocated_commands_;
+  // serializes the writers of preallocated_commands_
+  std::mutex preallocated_commands_mutex_;
+  /// Full and sparse commands received so far, guarded by preallocated_commands_mutex_
+  PreallocatedCommands merged_commands_;
+  /// Version of the last command written to the interfaces, realtime
+  std::uint64_t applied_version_ = 0;
+
+  /// Time over which the commands ramp to a new command, disabled if zero. Set by
+  /// read_parameters().
+  rclcpp::Duration interpolation_period_ = rclcpp::Duration(0, 0);
+  // commands the ramp to the applied command starts from, and its start time, realtime
+  std::vector<double> interpolation_start_;
+  std::int64_t interpolation_start_ns_ = 0;
+  /// Commands of the last cycle, NaN if not commanded yet, realtime
+  std::vector<double> interpolated_commands_;
+
+  /// Command the ramp to \p commands at \p time. Realtime-safe.
+  void write_interpolated_commands(
+    const PreallocatedCommands & commands, const rclcpp::Time & time);
+
+  /// Age after which a command is replaced by safe_values_, disabled if zero. Set by
+  /// read_parameters().
+  rclcpp::Duration command_timeout_ = rclcpp::Duration(0, 0);
+  /// Command of every interface after a timeout, set by read_parameters()
+  std::vector<double> safe_values_;
+  /// Reception time of the last command in nanoseconds, written by command_callback()
+  std::atomic<int64_t> last_command_time_ns_{0};
   rclcpp::Subscription<CmdType>::SharedPtr joints_command_subscriber_;
+  rclcpp::Subscription<CmdType>::SharedPtr sparse_command_subscriber_;
+
+  /// Rate the command latency statistics are published with, disabled if zero. Set by
+  /// read_parameters().
+  double command_latency_publish_rate_ = 0.0;
+  /// nullptr if the command latency isn't measured
+  std::unique_ptr<controller_realtime_tools::LatencyProbe> command_latency_;
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr command_latency_publisher_;
+  rclcpp::TimerBase::SharedPtr command_latency_timer_;
+  rclcpp::Time command_latency_window_start_;
 };
 
 }  // namespace forward_command_controller
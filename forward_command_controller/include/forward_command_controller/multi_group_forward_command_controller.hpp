@@ -0,0 +1,126 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FORWARD_COMMAND_CONTROLLER__MULTI_GROUP_FORWARD_COMMAND_CONTROLLER_HPP_
+#define FORWARD_COMMAND_CONTROLLER__MULTI_GROUP_FORWARD_COMMAND_CONTROLLER_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/interface_order.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "forward_command_controller/forward_controllers_base.hpp"
+#include "forward_command_controller/visibility_control.h"
+#include "multi_group_forward_command_controller_parameters.hpp"
+#include "rclcpp/subscription.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+namespace forward_command_controller
+{
+/**
+ * \brief Forward command controller for several independent groups of joints.
+ *
+ * Each group is commanded on its own topic, like by a ForwardCommandController of its own. The
+ * commands of all groups are kept in one table, the groups one after another, which the control
+ * loop takes with a single lock-free read, and of which it writes the groups changed by a new
+ * command in one pass. This replaces many controllers of the same kind, each with its own update
+ * and buffer.
+ *
+ * \param group_names Names of the groups.
+ * \param groups.<group>.joints Names of the joints of a group, in the order of its commands.
+ * \param interface_name Name of the interface to command.
+ *
+ * Subscribes to:
+ * - \b <group>/commands (std_msgs::msg::Float64MultiArray) : The commands of a group.
+ */
+class MultiGroupForwardCommandController : public controller_interface::ControllerInterface
+{
+public:
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  MultiGroupForwardCommandController();
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_init() override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_configure(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_activate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  FORWARD_COMMAND_CONTROLLER_PUBLIC
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+protected:
+  using Params = multi_group_forward_command_controller::Params;
+  using ParamListener = multi_group_forward_command_controller::ParamListener;
+
+  /// Handle a command of the group \p group received on its topic. Not realtime-safe.
+  void command_callback(size_t group, const std::shared_ptr<CmdType> msg);
+
+  /// Drop the received commands. Not realtime-safe.
+  void reset_commands();
+
+  std::shared_ptr<ParamListener> param_listener_;
+  Params params_;
+
+  /// Names of the command interfaces in the order of the command table
+  std::vector<std::string> command_interface_types_;
+  /// First entry of each group in the command table, followed by the size of the table
+  std::vector<size_t> group_offsets_;
+  /// Index in command_interfaces_ of each entry of the command table, set on activation
+  std::vector<size_t> command_interface_indices_;
+  /// Finds command_interface_indices_ on activation, configured with command_interface_types_
+  controller_realtime_tools::InterfaceOrder command_interface_order_;
+
+  struct CommandTable
+  {
+    std::vector<double> data;  // Command of every interface, the groups one after another
+    // Commands are numbered from 1 on, each group stores the last command which changed it, 0 if
+    // none did
+    std::uint64_t version = 0;
+    std::vector<std::uint64_t> versions;
+  };
+  /// Latest commands of all groups
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<CommandTable>> commands_;
+  // serializes the writers of commands_, the callbacks of the groups may run concurrently
+  std::mutex commands_mutex_;
+  /// Commands received so far, guarded by commands_mutex_
+  CommandTable merged_commands_;
+  /// Version of the last commands written to the interfaces, realtime
+  std::uint64_t applied_version_ = 0;
+
+  std::vector<rclcpp::Subscription<CmdType>::SharedPtr> command_subscribers_;
+};
+
+}  // namespace forward_command_controller
+
+#endif  // FORWARD_COMMAND_CONTROLLER__MULTI_GROUP_FORWARD_COMMAND_CONTROLLER_HPP_
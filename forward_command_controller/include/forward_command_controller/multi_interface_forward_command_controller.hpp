@@ -28,9 +28,11 @@ namespace forward_command_controller
 /**
  * \brief Multi interface forward command controller for a set of interfaces.
  *
- * This class forwards the command signal down to a set of interfaces on the specified joint.
+ * This class forwards the command signal down to a set of interfaces on the specified joints.
  *
  * \param joint Name of the joint to control.
+ * \param joints Names of the joints to control, instead of \p joint. The commands are interleaved
+ * by joint, `[joint][interface]`.
  * \param interface_names Names of the interfaces to command.
  *
  * Subscribes to:
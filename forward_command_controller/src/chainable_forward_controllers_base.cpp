@@ -0,0 +1,229 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "forward_command_controller/chainable_forward_controllers_base.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "controller_realtime_tools/tracing.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "rclcpp/logging.hpp"
+#include "rclcpp/qos.hpp"
+
+namespace forward_command_controller
+{
+ChainableForwardControllersBase::ChainableForwardControllersBase()
+: controller_interface::ChainableControllerInterface(), joints_command_subscriber_(nullptr)
+{
+}
+
+controller_interface::CallbackReturn ChainableForwardControllersBase::on_init()
+{
+  try
+  {
+    declare_parameters();
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(stderr, "Exception thrown during init stage with message: %s \n", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn ChainableForwardControllersBase::on_configure(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  command_interface_types_.clear();
+  auto ret = this->read_parameters();
+  if (ret != controller_interface::CallbackReturn::SUCCESS)
+  {
+    return ret;
+  }
+  command_interface_indices_.resize(command_interface_types_.size());
+  std::iota(command_interface_indices_.begin(), command_interface_indices_.end(), 0);
+  command_interface_order_.configure(command_interface_types_);
+
+  if (
+    command_timeout_.nanoseconds() > 0 && safe_values_.size() != command_interface_types_.size())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "'safe_values' has %zu values, expected one per interface (%zu)",
+      safe_values_.size(), command_interface_types_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  ReceivedCommands prototype;
+  prototype.data.resize(command_interface_types_.size(), 0.0);
+  received_commands_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<ReceivedCommands>>(
+      prototype);
+
+  joints_command_subscriber_ = get_node()->create_subscription<CmdType>(
+    "~/commands", rclcpp::SystemDefaultsQoS(),
+    [this](const CmdType::SharedPtr msg) { command_callback(msg); });
+
+  RCLCPP_INFO(get_node()->get_logger(), "configure successful");
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::InterfaceConfiguration
+ChainableForwardControllersBase::command_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration command_interfaces_config;
+  command_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  command_interfaces_config.names = command_interface_types_;
+
+  return command_interfaces_config;
+}
+
+controller_interface::InterfaceConfiguration
+ChainableForwardControllersBase::state_interface_configuration() const
+{
+  return controller_interface::InterfaceConfiguration{
+    controller_interface::interface_configuration_type::NONE};
+}
+
+std::vector<hardware_interface::CommandInterface>
+ChainableForwardControllersBase::on_export_reference_interfaces()
+{
+  reference_interfaces_.assign(
+    command_interface_types_.size(), std::numeric_limits<double>::quiet_NaN());
+
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.reserve(command_interface_types_.size());
+  for (size_t i = 0; i < command_interface_types_.size(); ++i)
+  {
+    reference_interfaces.emplace_back(hardware_interface::CommandInterface(
+      get_node()->get_name(), command_interface_types_[i], &reference_interfaces_[i]));
+  }
+  return reference_interfaces;
+}
+
+bool ChainableForwardControllersBase::on_set_chained_mode(bool /*chained_mode*/)
+{
+  // Always accept switch to/from chained mode, on_activate() drops the old references anyway
+  return true;
+}
+
+controller_interface::CallbackReturn ChainableForwardControllersBase::on_activate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  // the loaned interfaces may be in any order, map them once instead of looking them up. They
+  // are usually loaned in the order of the last activation, which is checked with one comparison
+  // per interface.
+  if (!command_interface_order_.update(command_interfaces_))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Expected %zu command interfaces, got %zu",
+      command_interface_types_.size(), command_interfaces_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  command_interface_indices_.assign(
+    command_interface_order_.indices().begin(), command_interface_order_.indices().end());
+
+  // reset command buffer if a command came through callback when controller was inactive
+  reset_commands();
+
+  RCLCPP_INFO(get_node()->get_logger(), "activate successful");
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn ChainableForwardControllersBase::on_deactivate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  // reset command buffer
+  reset_commands();
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+void ChainableForwardControllersBase::command_callback(const std::shared_ptr<CmdType> msg)
+{
+  // stamped first, so the realtime loop never sees a new command with the previous stamp
+  last_command_time_ns_.store(get_node()->now().nanoseconds(), std::memory_order_relaxed);
+  std::lock_guard<std::mutex> guard(received_commands_mutex_);
+  auto & commands = received_commands_->write_buffer();
+  if (msg->data.size() != commands.data.size())
+  {
+    RCLCPP_ERROR_THROTTLE(
+      get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+      "command size (%zu) does not match number of interfaces (%zu), ignoring it",
+      msg->data.size(), commands.data.size());
+    return;
+  }
+  std::copy(msg->data.begin(), msg->data.end(), commands.data.begin());
+  commands.received = true;
+  received_commands_->publish();
+}
+
+void ChainableForwardControllersBase::reset_commands()
+{
+  std::fill(
+    reference_interfaces_.begin(), reference_interfaces_.end(),
+    std::numeric_limits<double>::quiet_NaN());
+  if (received_commands_)
+  {
+    std::lock_guard<std::mutex> guard(received_commands_mutex_);
+    received_commands_->write_buffer().received = false;
+    received_commands_->publish();
+  }
+}
+
+controller_interface::return_type
+ChainableForwardControllersBase::update_reference_from_subscribers(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+{
+  const auto & commands = received_commands_->read();
+  CONTROLLER_TRACEPOINT(REFERENCE_RECEIVED, this, 0);
+  // no command received yet, keep the NaN references
+  if (!commands.received)
+  {
+    return controller_interface::return_type::OK;
+  }
+  if (
+    command_timeout_.nanoseconds() > 0 &&
+    time.nanoseconds() - last_command_time_ns_.load(std::memory_order_relaxed) >
+      command_timeout_.nanoseconds())
+  {
+    std::copy(safe_values_.begin(), safe_values_.end(), reference_interfaces_.begin());
+  }
+  else
+  {
+    std::copy(commands.data.begin(), commands.data.end(), reference_interfaces_.begin());
+  }
+  return controller_interface::return_type::OK;
+}
+
+controller_interface::return_type ChainableForwardControllersBase::update_and_write_commands(
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+{
+  for (auto index = 0ul; index < command_interfaces_.size(); ++index)
+  {
+    if (!std::isnan(reference_interfaces_[index]))
+    {
+      command_interface(index).set_value(reference_interfaces_[index]);
+    }
+  }
+
+  return controller_interface::return_type::OK;
+}
+
+}  // namespace forward_command_controller
@@ -0,0 +1,83 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "forward_command_controller/chainable_multi_interface_forward_command_controller.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace forward_command_controller
+{
+ChainableMultiInterfaceForwardCommandController::ChainableMultiInterfaceForwardCommandController()
+: ChainableForwardControllersBase()
+{
+}
+
+void ChainableMultiInterfaceForwardCommandController::declare_parameters()
+{
+  param_listener_ = std::make_shared<ParamListener>(get_node());
+}
+
+controller_interface::CallbackReturn
+ChainableMultiInterfaceForwardCommandController::read_parameters()
+{
+  if (!param_listener_)
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Error encountered during init");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  params_ = param_listener_->get_params();
+
+  if (params_.joint.empty() && params_.joints.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'joint' parameter is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  if (!params_.joint.empty() && !params_.joints.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Only one of 'joint' and 'joints' can be set");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  if (params_.interface_names.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'interfaces' parameter is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  // interleaved by joint, [joint][interface]
+  const auto joints =
+    params_.joints.empty() ? std::vector<std::string>{params_.joint} : params_.joints;
+  for (const auto & joint : joints)
+  {
+    for (const auto & interface : params_.interface_names)
+    {
+      command_interface_types_.push_back(joint + "/" + interface);
+    }
+  }
+
+  command_timeout_ = rclcpp::Duration::from_seconds(params_.command_timeout);
+  safe_values_ = params_.safe_values;
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+}  // namespace forward_command_controller
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  forward_command_controller::ChainableMultiInterfaceForwardCommandController,
+  controller_interface::ChainableControllerInterface)
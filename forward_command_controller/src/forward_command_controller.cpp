@@ -58,6 +58,14 @@ controller_interface::CallbackReturn ForwardCommandController::read_parameters()
     command_interface_types_.push_back(joint + "/" + params_.interface_name);
   }
 
+  preallocate_commands_ = params_.preallocate_commands;
+  interpolation_period_ = rclcpp::Duration::from_seconds(params_.interpolation_period);
+  command_timeout_ = rclcpp::Duration::from_seconds(params_.command_timeout);
+  safe_values_ = params_.safe_values;
+  command_latency_publish_rate_ =
+    params_.command_latency.enable ? params_.command_latency.publish_rate : 0.0;
+  command_sequences_ = params_.command_sequence_interfaces;
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
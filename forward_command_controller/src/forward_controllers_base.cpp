@@ -15,12 +15,16 @@
 #include "forward_command_controller/forward_controllers_base.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "controller_interface/helpers.hpp"
+#include "controller_realtime_tools/metrics.hpp"
 #include "hardware_interface/loaned_command_interface.hpp"
 #include "rclcpp/logging.hpp"
 #include "rclcpp/qos.hpp"
@@ -52,15 +56,87 @@ controller_interface::CallbackReturn ForwardControllersBase::on_init()
 controller_interface::CallbackReturn ForwardControllersBase::on_configure(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
+  // read_parameters() appends the interfaces, reconfiguring must not duplicate them
+  command_interface_types_.clear();
   auto ret = this->read_parameters();
   if (ret != controller_interface::CallbackReturn::SUCCESS)
   {
     return ret;
   }
+  // the sequence interfaces are claimed after the command interfaces, in the same order
+  std::vector<std::string> claimed_interfaces = command_interface_types_;
+  if (command_sequences_)
+  {
+    command_sequence_ = std::make_unique<controller_realtime_tools::CommandSequence>();
+    command_sequence_->reset(command_interface_types_.size());
+    for (const auto & name : command_interface_types_)
+    {
+      claimed_interfaces.push_back(
+        controller_realtime_tools::CommandSequence::interface_name(name));
+    }
+  }
+  else
+  {
+    command_sequence_.reset();
+  }
+  command_interface_indices_.resize(claimed_interfaces.size());
+  std::iota(command_interface_indices_.begin(), command_interface_indices_.end(), 0);
+  command_interface_order_.configure(claimed_interfaces);
+
+  if (
+    command_timeout_.nanoseconds() > 0 && safe_values_.size() != command_interface_types_.size())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "'safe_values' has %zu values, expected one per interface (%zu)",
+      safe_values_.size(), command_interface_types_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  if (interpolation_period_.nanoseconds() > 0 && !preallocate_commands_)
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'interpolation_period' needs 'preallocate_commands'");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  preallocated_commands_.reset();
+  sparse_command_subscriber_.reset();
+  if (preallocate_commands_)
+  {
+    merged_commands_ = PreallocatedCommands();
+    merged_commands_.data.resize(command_interface_types_.size(), 0.0);
+    merged_commands_.versions.resize(command_interface_types_.size(), 0);
+    interpolation_start_.assign(command_interface_types_.size(), 0.0);
+    interpolated_commands_.assign(
+      command_interface_types_.size(), std::numeric_limits<double>::quiet_NaN());
+    preallocated_commands_ =
+      std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<PreallocatedCommands>>(
+        merged_commands_);
+    sparse_command_subscriber_ = get_node()->create_subscription<CmdType>(
+      "~/sparse_commands", rclcpp::SystemDefaultsQoS(),
+      [this](const CmdType::SharedPtr msg) { sparse_command_callback(msg); });
+  }
 
   joints_command_subscriber_ = get_node()->create_subscription<CmdType>(
     "~/commands", rclcpp::SystemDefaultsQoS(),
-    [this](const CmdType::SharedPtr msg) { rt_command_ptr_.writeFromNonRT(msg); });
+    [this](const CmdType::SharedPtr msg) { command_callback(msg); });
+
+  if (command_latency_publish_rate_ > 0.0)
+  {
+    command_latency_ = std::make_unique<controller_realtime_tools::LatencyProbe>();
+    command_latency_publisher_ =
+      get_node()->create_publisher<statistics_msgs::msg::MetricsMessage>(
+        "~/command_latency", rclcpp::SystemDefaultsQoS());
+    command_latency_window_start_ = get_node()->now();
+    command_latency_timer_ = get_node()->create_wall_timer(
+      std::chrono::duration<double>(1.0 / command_latency_publish_rate_),
+      [this]() { publish_command_latency(); });
+  }
+  else
+  {
+    command_latency_timer_.reset();
+    command_latency_publisher_.reset();
+    command_latency_.reset();
+  }
 
   RCLCPP_INFO(get_node()->get_logger(), "configure successful");
   return controller_interface::CallbackReturn::SUCCESS;
@@ -71,7 +147,7 @@ ForwardControllersBase::command_interface_configuration() const
 {
   controller_interface::InterfaceConfiguration command_interfaces_config;
   command_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
-  command_interfaces_config.names = command_interface_types_;
+  command_interfaces_config.names = command_interface_order_.names();
 
   return command_interfaces_config;
 }
@@ -86,24 +162,25 @@ controller_interface::InterfaceConfiguration ForwardControllersBase::state_inter
 controller_interface::CallbackReturn ForwardControllersBase::on_activate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
-  //  check if we have all resources defined in the "points" parameter
-  //  also verify that we *only* have the resources defined in the "points" parameter
-  // ATTENTION(destogl): Shouldn't we use ordered interface all the time?
-  std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>
-    ordered_interfaces;
-  if (
-    !controller_interface::get_ordered_interfaces(
-      command_interfaces_, command_interface_types_, std::string(""), ordered_interfaces) ||
-    command_interface_types_.size() != ordered_interfaces.size())
+  // the loaned interfaces may be in any order, map them once instead of looking them up. They
+  // are usually loaned in the order of the last activation, which is checked with one comparison
+  // per interface.
+  if (!command_interface_order_.update(command_interfaces_))
   {
     RCLCPP_ERROR(
       get_node()->get_logger(), "Expected %zu command interfaces, got %zu",
-      command_interface_types_.size(), ordered_interfaces.size());
+      command_interface_order_.names().size(), command_interfaces_.size());
     return controller_interface::CallbackReturn::ERROR;
   }
+  command_interface_indices_.assign(
+    command_interface_order_.indices().begin(), command_interface_order_.indices().end());
 
   // reset command buffer if a command came through callback when controller was inactive
-  rt_command_ptr_ = realtime_tools::RealtimeBuffer<std::shared_ptr<CmdType>>(nullptr);
+  reset_commands();
+  if (command_sequence_)
+  {
+    command_sequence_->restart();
+  }
 
   RCLCPP_INFO(get_node()->get_logger(), "activate successful");
   return controller_interface::CallbackReturn::SUCCESS;
@@ -113,13 +190,235 @@ controller_interface::CallbackReturn ForwardControllersBase::on_deactivate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   // reset command buffer
-  rt_command_ptr_ = realtime_tools::RealtimeBuffer<std::shared_ptr<CmdType>>(nullptr);
+  reset_commands();
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
+void ForwardControllersBase::command_callback(const std::shared_ptr<CmdType> msg)
+{
+  if (!preallocated_commands_)
+  {
+    // stamped first, so the realtime loop never sees a new command with the previous stamp
+    const int64_t now_ns = get_node()->now().nanoseconds();
+    last_command_time_ns_.store(now_ns, std::memory_order_relaxed);
+    rt_command_ptr_.writeFromNonRT(msg);
+    if (command_latency_)
+    {
+      // Float64MultiArray has no stamp
+      command_latency_->command_received(0, now_ns);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(preallocated_commands_mutex_);
+  if (msg->data.size() != merged_commands_.data.size())
+  {
+    RCLCPP_ERROR_THROTTLE(
+      get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+      "command size (%zu) does not match number of interfaces (%zu), ignoring it",
+      msg->data.size(), merged_commands_.data.size());
+    return;
+  }
+  const std::uint64_t version = merged_commands_.version + 1;
+  std::copy(msg->data.begin(), msg->data.end(), merged_commands_.data.begin());
+  std::fill(merged_commands_.versions.begin(), merged_commands_.versions.end(), version);
+  publish_merged_commands(version);
+}
+
+void ForwardControllersBase::sparse_command_callback(const std::shared_ptr<CmdType> msg)
+{
+  std::lock_guard<std::mutex> guard(preallocated_commands_mutex_);
+  const size_t num_interfaces = merged_commands_.data.size();
+  // pairs of an interface index and its command, all of them are checked before applying any
+  bool valid = msg->data.size() % 2 == 0;
+  for (size_t i = 0; valid && i < msg->data.size(); i += 2)
+  {
+    const double index = msg->data[i];
+    valid = index >= 0.0 && index < static_cast<double>(num_interfaces) &&
+            index == static_cast<double>(static_cast<size_t>(index));
+  }
+  if (!valid)
+  {
+    RCLCPP_ERROR_THROTTLE(
+      get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+      "sparse command needs pairs of an interface index below %zu and a value, ignoring it",
+      num_interfaces);
+    return;
+  }
+
+  const std::uint64_t version = merged_commands_.version + 1;
+  for (size_t i = 0; i < msg->data.size(); i += 2)
+  {
+    const auto index = static_cast<size_t>(msg->data[i]);
+    merged_commands_.data[index] = msg->data[i + 1];
+    merged_commands_.versions[index] = version;
+  }
+  publish_merged_commands(version);
+}
+
+void ForwardControllersBase::publish_merged_commands(std::uint64_t version)
+{
+  merged_commands_.stamp_ns = get_node()->now().nanoseconds();
+  last_command_time_ns_.store(merged_commands_.stamp_ns, std::memory_order_relaxed);
+  merged_commands_.version = version;
+  merged_commands_.received = true;
+  // the vectors keep their sizes, so copying them doesn't allocate
+  preallocated_commands_->write_buffer() = merged_commands_;
+  preallocated_commands_->publish();
+  if (command_latency_)
+  {
+    command_latency_->command_received(0, merged_commands_.stamp_ns);
+  }
+}
+
+void ForwardControllersBase::reset_commands()
+{
+  rt_command_ptr_ = realtime_tools::RealtimeBuffer<std::shared_ptr<CmdType>>(nullptr);
+  if (preallocated_commands_)
+  {
+    std::lock_guard<std::mutex> guard(preallocated_commands_mutex_);
+    merged_commands_.received = false;
+    std::fill(merged_commands_.versions.begin(), merged_commands_.versions.end(), 0);
+    preallocated_commands_->write_buffer() = merged_commands_;
+    preallocated_commands_->publish();
+    // only called while the realtime loop doesn't run
+    applied_version_ = 0;
+    std::fill(
+      interpolated_commands_.begin(), interpolated_commands_.end(),
+      std::numeric_limits<double>::quiet_NaN());
+  }
+}
+
+bool ForwardControllersBase::command_timed_out(const rclcpp::Time & time) const
+{
+  return command_timeout_.nanoseconds() > 0 &&
+         time.nanoseconds() - last_command_time_ns_.load(std::memory_order_relaxed) >
+           command_timeout_.nanoseconds();
+}
+
+void ForwardControllersBase::write_safe_values()
+{
+  for (auto index = 0ul; index < command_interface_types_.size(); ++index)
+  {
+    command_interface(index).set_value(safe_values_[index]);
+  }
+}
+
+void ForwardControllersBase::publish_command_latency()
+{
+  using controller_realtime_tools::LatencyProbe;
+  const rclcpp::Time now = get_node()->now();
+  const auto statistics = command_latency_->get_statistics();
+  for (size_t stage = 0; stage < LatencyProbe::NUM_STAGES; ++stage)
+  {
+    statistics_msgs::msg::MetricsMessage msg;
+    msg.measurement_source_name = get_node()->get_name();
+    msg.metrics_source = LatencyProbe::STAGE_NAMES[stage];
+    msg.window_start = command_latency_window_start_;
+    msg.window_stop = now;
+    controller_realtime_tools::fill_metrics<statistics_msgs::msg::StatisticDataType>(
+      statistics[stage], msg);
+    command_latency_publisher_->publish(msg);
+  }
+  command_latency_window_start_ = now;
+}
+
+void ForwardControllersBase::write_interpolated_commands(
+  const PreallocatedCommands & commands, const rclcpp::Time & time)
+{
+  // ramp from the commands of the last cycle to a new command, starting when it was received
+  if (commands.version != applied_version_)
+  {
+    for (auto index = 0ul; index < command_interface_types_.size(); ++index)
+    {
+      interpolation_start_[index] = std::isnan(interpolated_commands_[index])
+                                      ? commands.data[index]
+                                      : interpolated_commands_[index];
+    }
+    interpolation_start_ns_ = commands.stamp_ns;
+    applied_version_ = commands.version;
+  }
+
+  const double ratio = std::clamp(
+    static_cast<double>(time.nanoseconds() - interpolation_start_ns_) /
+      static_cast<double>(interpolation_period_.nanoseconds()),
+    0.0, 1.0);
+  for (auto index = 0ul; index < command_interface_types_.size(); ++index)
+  {
+    // interfaces which were never commanded aren't written
+    if (commands.versions[index] == 0)
+    {
+      continue;
+    }
+    interpolated_commands_[index] =
+      interpolation_start_[index] + ratio * (commands.data[index] - interpolation_start_[index]);
+    command_interface(index).set_value(interpolated_commands_[index]);
+  }
+}
+
+void ForwardControllersBase::write_command_sequences()
+{
+  const size_t num_commands = command_sequence_->size();
+  for (auto index = 0ul; index < num_commands; ++index)
+  {
+    command_interface(num_commands + index)
+      .set_value(command_sequence_->update(index, command_interface(index).get_value()));
+  }
+}
+
 controller_interface::return_type ForwardControllersBase::update(
-  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
 {
+  const auto ret = write_commands(time);
+  // after all commands of the cycle, whichever way they were written
+  if (command_sequence_)
+  {
+    write_command_sequences();
+  }
+  return ret;
+}
+
+controller_interface::return_type ForwardControllersBase::write_commands(const rclcpp::Time & time)
+{
+  if (preallocated_commands_)
+  {
+    const auto & commands = preallocated_commands_->read();
+    // no command received yet
+    if (!commands.received)
+    {
+      return controller_interface::return_type::OK;
+    }
+    if (command_timed_out(time))
+    {
+      write_safe_values();
+      // command all interfaces again with the next command, interpolating from the safe values
+      applied_version_ = 0;
+      std::copy(safe_values_.begin(), safe_values_.end(), interpolated_commands_.begin());
+      return controller_interface::return_type::OK;
+    }
+    if (interpolation_period_.nanoseconds() > 0)
+    {
+      write_interpolated_commands(commands, time);
+    }
+    // only write the interfaces changed since the last applied command
+    else if (commands.version != applied_version_)
+    {
+      for (auto index = 0ul; index < command_interface_types_.size(); ++index)
+      {
+        if (commands.versions[index] > applied_version_)
+        {
+          command_interface(index).set_value(commands.data[index]);
+        }
+      }
+      applied_version_ = commands.version;
+    }
+    if (command_latency_)
+    {
+      command_latency_->command_written(time.nanoseconds());
+    }
+    return controller_interface::return_type::OK;
+  }
+
   auto joint_commands = rt_command_ptr_.readFromRT();
 
   // no command received yet
@@ -128,18 +427,28 @@ controller_interface::return_type ForwardControllersBase::update(
     return controller_interface::return_type::OK;
   }
 
-  if ((*joint_commands)->data.size() != command_interfaces_.size())
+  if (command_timed_out(time))
+  {
+    write_safe_values();
+    return controller_interface::return_type::OK;
+  }
+
+  if ((*joint_commands)->data.size() != command_interface_types_.size())
   {
     RCLCPP_ERROR_THROTTLE(
       get_node()->get_logger(), *(get_node()->get_clock()), 1000,
       "command size (%zu) does not match number of interfaces (%zu)",
-      (*joint_commands)->data.size(), command_interfaces_.size());
+      (*joint_commands)->data.size(), command_interface_types_.size());
     return controller_interface::return_type::ERROR;
   }
 
-  for (auto index = 0ul; index < command_interfaces_.size(); ++index)
+  for (auto index = 0ul; index < command_interface_types_.size(); ++index)
+  {
+    command_interface(index).set_value((*joint_commands)->data[index]);
+  }
+  if (command_latency_)
   {
-    command_interfaces_[index].set_value((*joint_commands)->data[index]);
+    command_latency_->command_written(time.nanoseconds());
   }
 
   return controller_interface::return_type::OK;
@@ -0,0 +1,239 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "forward_command_controller/multi_group_forward_command_controller.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "rclcpp/logging.hpp"
+#include "rclcpp/qos.hpp"
+
+namespace forward_command_controller
+{
+MultiGroupForwardCommandController::MultiGroupForwardCommandController()
+: controller_interface::ControllerInterface()
+{
+}
+
+controller_interface::CallbackReturn MultiGroupForwardCommandController::on_init()
+{
+  try
+  {
+    param_listener_ = std::make_shared<ParamListener>(get_node());
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(stderr, "Exception thrown during init stage with message: %s \n", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn MultiGroupForwardCommandController::on_configure(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  params_ = param_listener_->get_params();
+
+  if (params_.group_names.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'group_names' parameter is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  if (params_.interface_name.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'interface_name' parameter is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  // the groups one after another, [group][joint]
+  command_interface_types_.clear();
+  group_offsets_.assign(1, 0);
+  std::unordered_set<std::string> joints;
+  for (const auto & group_name : params_.group_names)
+  {
+    const auto & group_joints = params_.groups.group_names_map.at(group_name).joints;
+    if (group_joints.empty())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "'groups.%s.joints' parameter is empty", group_name.c_str());
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    for (const auto & joint : group_joints)
+    {
+      // an interface can be commanded by only one group
+      if (!joints.insert(joint).second)
+      {
+        RCLCPP_ERROR(
+          get_node()->get_logger(), "Joint '%s' is in several groups or twice in group '%s'",
+          joint.c_str(), group_name.c_str());
+        return controller_interface::CallbackReturn::ERROR;
+      }
+      command_interface_types_.push_back(joint + "/" + params_.interface_name);
+    }
+    group_offsets_.push_back(command_interface_types_.size());
+  }
+  command_interface_indices_.resize(command_interface_types_.size());
+  std::iota(command_interface_indices_.begin(), command_interface_indices_.end(), 0);
+  command_interface_order_.configure(command_interface_types_);
+
+  const size_t num_groups = params_.group_names.size();
+  merged_commands_ = CommandTable();
+  merged_commands_.data.resize(command_interface_types_.size(), 0.0);
+  merged_commands_.versions.resize(num_groups, 0);
+  commands_ = std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<CommandTable>>(
+    merged_commands_);
+  applied_version_ = 0;
+
+  command_subscribers_.clear();
+  for (size_t group = 0; group < num_groups; ++group)
+  {
+    command_subscribers_.push_back(get_node()->create_subscription<CmdType>(
+      "~/" + params_.group_names[group] + "/commands", rclcpp::SystemDefaultsQoS(),
+      [this, group](const CmdType::SharedPtr msg) { command_callback(group, msg); }));
+  }
+
+  RCLCPP_INFO(get_node()->get_logger(), "configure successful");
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::InterfaceConfiguration
+MultiGroupForwardCommandController::command_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration command_interfaces_config;
+  command_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  command_interfaces_config.names = command_interface_types_;
+
+  return command_interfaces_config;
+}
+
+controller_interface::InterfaceConfiguration
+MultiGroupForwardCommandController::state_interface_configuration() const
+{
+  return controller_interface::InterfaceConfiguration{
+    controller_interface::interface_configuration_type::NONE};
+}
+
+controller_interface::CallbackReturn MultiGroupForwardCommandController::on_activate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  // the loaned interfaces may be in any order, map them once instead of looking them up. They
+  // are usually loaned in the order of the last activation, which is checked with one comparison
+  // per interface.
+  if (!command_interface_order_.update(command_interfaces_))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Expected %zu command interfaces, got %zu",
+      command_interface_types_.size(), command_interfaces_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  command_interface_indices_.assign(
+    command_interface_order_.indices().begin(), command_interface_order_.indices().end());
+
+  // drop the commands which came through the callbacks while the controller was inactive
+  reset_commands();
+
+  RCLCPP_INFO(get_node()->get_logger(), "activate successful");
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn MultiGroupForwardCommandController::on_deactivate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  reset_commands();
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+void MultiGroupForwardCommandController::command_callback(
+  size_t group, const std::shared_ptr<CmdType> msg)
+{
+  const size_t group_begin = group_offsets_[group];
+  const size_t group_size = group_offsets_[group + 1] - group_begin;
+  if (msg->data.size() != group_size)
+  {
+    RCLCPP_ERROR_THROTTLE(
+      get_node()->get_logger(), *(get_node()->get_clock()), 1000,
+      "command size (%zu) of group '%s' does not match its number of joints (%zu), ignoring it",
+      msg->data.size(), params_.group_names[group].c_str(), group_size);
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(commands_mutex_);
+  const std::uint64_t version = merged_commands_.version + 1;
+  std::copy(
+    msg->data.begin(), msg->data.end(),
+    merged_commands_.data.begin() + static_cast<std::ptrdiff_t>(group_begin));
+  merged_commands_.versions[group] = version;
+  merged_commands_.version = version;
+  // the vectors keep their sizes, so copying them doesn't allocate
+  commands_->write_buffer() = merged_commands_;
+  commands_->publish();
+}
+
+void MultiGroupForwardCommandController::reset_commands()
+{
+  if (!commands_)
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(commands_mutex_);
+  std::fill(merged_commands_.versions.begin(), merged_commands_.versions.end(), 0);
+  commands_->write_buffer() = merged_commands_;
+  commands_->publish();
+  // only called while the realtime loop doesn't run
+  applied_version_ = merged_commands_.version;
+}
+
+controller_interface::return_type MultiGroupForwardCommandController::update(
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+{
+  const auto & commands = commands_->read();
+  // no new command of any group
+  if (commands.version == applied_version_)
+  {
+    return controller_interface::return_type::OK;
+  }
+
+  // only write the groups changed since the last applied commands
+  for (size_t group = 0; group < commands.versions.size(); ++group)
+  {
+    if (commands.versions[group] <= applied_version_)
+    {
+      continue;
+    }
+    for (size_t index = group_offsets_[group]; index < group_offsets_[group + 1]; ++index)
+    {
+      command_interfaces_[command_interface_indices_[index]].set_value(commands.data[index]);
+    }
+  }
+  applied_version_ = commands.version;
+
+  return controller_interface::return_type::OK;
+}
+
+}  // namespace forward_command_controller
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  forward_command_controller::MultiGroupForwardCommandController,
+  controller_interface::ControllerInterface)
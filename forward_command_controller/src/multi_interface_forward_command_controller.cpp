@@ -39,11 +39,16 @@ controller_interface::CallbackReturn MultiInterfaceForwardCommandController::rea
   }
   params_ = param_listener_->get_params();
 
-  if (params_.joint.empty())
+  if (params_.joint.empty() && params_.joints.empty())
   {
     RCLCPP_ERROR(get_node()->get_logger(), "'joint' parameter is empty");
     return controller_interface::CallbackReturn::ERROR;
   }
+  if (!params_.joint.empty() && !params_.joints.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Only one of 'joint' and 'joints' can be set");
+    return controller_interface::CallbackReturn::ERROR;
+  }
 
   if (params_.interface_names.empty())
   {
@@ -51,11 +56,25 @@ controller_interface::CallbackReturn MultiInterfaceForwardCommandController::rea
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  for (const auto & interface : params_.interface_names)
+  // interleaved by joint, [joint][interface]
+  const auto joints =
+    params_.joints.empty() ? std::vector<std::string>{params_.joint} : params_.joints;
+  for (const auto & joint : joints)
   {
-    command_interface_types_.push_back(params_.joint + "/" + interface);
+    for (const auto & interface : params_.interface_names)
+    {
+      command_interface_types_.push_back(joint + "/" + interface);
+    }
   }
 
+  preallocate_commands_ = params_.preallocate_commands;
+  interpolation_period_ = rclcpp::Duration::from_seconds(params_.interpolation_period);
+  command_timeout_ = rclcpp::Duration::from_seconds(params_.command_timeout);
+  safe_values_ = params_.safe_values;
+  command_latency_publish_rate_ =
+    params_.command_latency.enable ? params_.command_latency.publish_rate : 0.0;
+  command_sequences_ = params_.command_sequence_interfaces;
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
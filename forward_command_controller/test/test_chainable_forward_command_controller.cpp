@@ -0,0 +1,156 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "test_chainable_forward_command_controller.hpp"
+
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/utilities.hpp"
+
+using hardware_interface::LoanedCommandInterface;
+
+void ChainableForwardCommandControllerTest::SetUpTestCase() { rclcpp::init(0, nullptr); }
+
+void ChainableForwardCommandControllerTest::TearDownTestCase() { rclcpp::shutdown(); }
+
+void ChainableForwardCommandControllerTest::SetUp()
+{
+  // initialize controller
+  controller_ = std::make_unique<FriendChainableForwardCommandController>();
+}
+
+void ChainableForwardCommandControllerTest::TearDown() { controller_.reset(nullptr); }
+
+void ChainableForwardCommandControllerTest::SetUpController()
+{
+  const auto result = controller_->init(controller_name_);
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(joint_1_pos_cmd_);
+  command_ifs.emplace_back(joint_2_pos_cmd_);
+  command_ifs.emplace_back(joint_3_pos_cmd_);
+  controller_->assign_interfaces(std::move(command_ifs), {});
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+}
+
+TEST_F(ChainableForwardCommandControllerTest, ExportsReferenceInterfaces)
+{
+  SetUpController();
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_EQ(reference_interfaces.size(), joint_names_.size());
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_EQ(
+      reference_interfaces[i].get_name(),
+      controller_name_ + "/" + joint_names_[i] + "/" + HW_IF_POSITION);
+  }
+}
+
+TEST_F(ChainableForwardCommandControllerTest, TopicCommandSuccessTest)
+{
+  SetUpController();
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  controller_->export_reference_interfaces();
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // no command received yet, the commands are unchanged
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 3.1);
+
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->command_callback(command_msg);
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+  // the command is dropped on deactivation
+  node_state = controller_->get_node()->deactivate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  ASSERT_FALSE(controller_->received_commands_->read().received);
+}
+
+TEST_F(ChainableForwardCommandControllerTest, WrongCommandIgnoredTest)
+{
+  SetUpController();
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  controller_->export_reference_interfaces();
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0};
+  controller_->command_callback(command_msg);
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 3.1);
+}
+
+TEST_F(ChainableForwardCommandControllerTest, ChainedModeReferencesSuccessTest)
+{
+  SetUpController();
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+  ASSERT_TRUE(controller_->is_in_chained_mode());
+
+  // commands on the topic are not used in chained mode
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->command_callback(command_msg);
+
+  // only the joints with a reference are commanded
+  reference_interfaces[0].set_value(5.5);
+  reference_interfaces[2].set_value(7.7);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 5.5);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 7.7);
+}
@@ -398,3 +398,386 @@ TEST_F(ForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess)
   ASSERT_EQ(joint_2_pos_cmd_.get_value(), 6.6);
   ASSERT_EQ(joint_3_pos_cmd_.get_value(), 7.7);
 }
+
+TEST_F(ForwardCommandControllerTest, PreallocatedCommandCallbackTest)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"preallocate_commands", true});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  ASSERT_TRUE(controller_->preallocated_commands_);
+
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // a command of the wrong size is ignored
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0};
+  controller_->command_callback(command_msg);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 3.1);
+
+  // send a new command
+  rclcpp::Node test_node("test_node");
+  auto command_pub = test_node.create_publisher<std_msgs::msg::Float64MultiArray>(
+    std::string(controller_->get_node()->get_name()) + "/commands", rclcpp::SystemDefaultsQoS());
+  command_msg->data = {10.0, 20.0, 30.0};
+  command_pub->publish(*command_msg);
+
+  // wait for command message to be passed
+  ASSERT_EQ(wait_for(controller_->joints_command_subscriber_), rclcpp::WaitResultKind::Ready);
+
+  // process callbacks
+  rclcpp::spin_some(controller_->get_node()->get_node_base_interface());
+
+  // the command is only copied into the preallocated buffers
+  ASSERT_FALSE(
+    controller_->rt_command_ptr_.readFromNonRT() &&
+    *(controller_->rt_command_ptr_.readFromNonRT()));
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+}
+
+TEST_F(ForwardCommandControllerTest, PreallocatedCommandsResetSuccess)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"preallocate_commands", true});
+
+  auto node_state = controller_->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+  // simulate a callback while the controller is inactive
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {5.5, 6.6, 7.7};
+  controller_->command_callback(command_msg);
+
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // the command received while inactive was dropped
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 3.1);
+
+  controller_->command_callback(command_msg);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 5.5);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 6.6);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 7.7);
+
+  // the command was copied, changing the message afterwards has no effect
+  command_msg->data = {1.0, 2.0, 3.0};
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 5.5);
+
+  node_state = controller_->get_node()->deactivate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  ASSERT_FALSE(controller_->preallocated_commands_->read().received);
+}
+
+TEST_F(ForwardCommandControllerTest, SafeValuesSizeMismatchFails)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"command_timeout", 0.1});
+  controller_->get_node()->set_parameter({"safe_values", std::vector<double>{0.0, 0.0}});
+
+  // configure failed, 'safe_values' needs a value per interface
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(ForwardCommandControllerTest, CommandTimeoutSafeValuesTest)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"command_timeout", 0.1});
+  controller_->get_node()->set_parameter({"safe_values", std::vector<double>{0.0, -1.0, 0.5}});
+
+  for (const bool preallocate_commands : {false, true})
+  {
+    controller_->get_node()->set_parameter({"preallocate_commands", preallocate_commands});
+    auto node_state = controller_->get_node()->configure();
+    ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+    node_state = controller_->get_node()->activate();
+    ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+    auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+    command_msg->data = {10.0, 20.0, 30.0};
+    controller_->command_callback(command_msg);
+    const rclcpp::Time received = controller_->get_node()->now();
+
+    // the command is forwarded until it times out
+    ASSERT_EQ(
+      controller_->update(received, rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+    ASSERT_EQ(joint_2_pos_cmd_.get_value(), 20.0);
+    ASSERT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+    ASSERT_EQ(
+      controller_->update(
+        received + rclcpp::Duration::from_seconds(0.2), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    ASSERT_EQ(joint_1_pos_cmd_.get_value(), 0.0);
+    ASSERT_EQ(joint_2_pos_cmd_.get_value(), -1.0);
+    ASSERT_EQ(joint_3_pos_cmd_.get_value(), 0.5);
+
+    // a new command is forwarded again
+    controller_->command_callback(command_msg);
+    ASSERT_EQ(
+      controller_->update(controller_->get_node()->now(), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+
+    node_state = controller_->get_node()->deactivate();
+    ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+    node_state = controller_->get_node()->cleanup();
+    ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_UNCONFIGURED);
+  }
+}
+
+TEST_F(ForwardCommandControllerTest, SparseCommandsTest)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"preallocate_commands", true});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  ASSERT_TRUE(controller_->sparse_command_subscriber_);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // a sparse command before any full one only commands its interfaces
+  auto sparse_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  sparse_msg->data = {2.0, 30.0};
+  controller_->sparse_command_callback(sparse_msg);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->command_callback(command_msg);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 20.0);
+
+  // only the interfaces of the sparse command are written
+  joint_1_pos_cmd_.set_value(0.0);
+  sparse_msg->data = {1.0, 25.0};
+  controller_->sparse_command_callback(sparse_msg);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 0.0);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 25.0);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+  // nothing is written without a new command
+  joint_2_pos_cmd_.set_value(0.0);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 0.0);
+
+  // invalid sparse commands are ignored as a whole
+  for (const auto & data : std::vector<std::vector<double>>{
+         {0.0, 1.0, 3.0, 1.0}, {0.5, 1.0}, {-1.0, 1.0}, {0.0, 1.0, 2.0}})
+  {
+    sparse_msg->data = data;
+    controller_->sparse_command_callback(sparse_msg);
+    ASSERT_EQ(
+      controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    ASSERT_EQ(joint_1_pos_cmd_.get_value(), 0.0);
+    ASSERT_EQ(joint_2_pos_cmd_.get_value(), 0.0);
+    ASSERT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+  }
+}
+
+TEST_F(ForwardCommandControllerTest, InterpolationNeedsPreallocatedCommands)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"interpolation_period", 0.1});
+
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(ForwardCommandControllerTest, InterpolatedCommandsTest)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"preallocate_commands", true});
+  controller_->get_node()->set_parameter({"interpolation_period", 0.1});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // the first command is applied at once
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->command_callback(command_msg);
+  rclcpp::Time received(controller_->merged_commands_.stamp_ns, RCL_ROS_TIME);
+  ASSERT_EQ(
+    controller_->update(received, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_pos_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+  // the next one is ramped to from its arrival on
+  command_msg->data = {20.0, 10.0, 30.0};
+  controller_->command_callback(command_msg);
+  received = rclcpp::Time(controller_->merged_commands_.stamp_ns, RCL_ROS_TIME);
+  ASSERT_EQ(
+    controller_->update(
+      received + rclcpp::Duration::from_seconds(0.05), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(joint_1_pos_cmd_.get_value(), 15.0);
+  EXPECT_DOUBLE_EQ(joint_2_pos_cmd_.get_value(), 15.0);
+  EXPECT_DOUBLE_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+
+  ASSERT_EQ(
+    controller_->update(
+      received + rclcpp::Duration::from_seconds(0.2), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_DOUBLE_EQ(joint_1_pos_cmd_.get_value(), 20.0);
+  EXPECT_DOUBLE_EQ(joint_2_pos_cmd_.get_value(), 10.0);
+  EXPECT_DOUBLE_EQ(joint_3_pos_cmd_.get_value(), 30.0);
+}
+
+TEST_F(ForwardCommandControllerTest, CommandLatencyTest)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"preallocate_commands", true});
+  controller_->get_node()->set_parameter({"command_latency.enable", true});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  ASSERT_TRUE(controller_->command_latency_);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  auto command_msg = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command_msg->data = {10.0, 20.0, 30.0};
+  controller_->command_callback(command_msg);
+  const rclcpp::Time received(controller_->merged_commands_.stamp_ns, RCL_ROS_TIME);
+
+  // written 20 ms after it was received, the cycles after don't count
+  for (const double delay : {0.02, 0.03, 0.04})
+  {
+    ASSERT_EQ(
+      controller_->update(
+        received + rclcpp::Duration::from_seconds(delay), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  }
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+
+  using controller_realtime_tools::LatencyProbe;
+  const auto statistics = controller_->command_latency_->get_statistics();
+  EXPECT_EQ(statistics[LatencyProbe::RECEIVE_TO_WRITE].count, 1u);
+  EXPECT_DOUBLE_EQ(statistics[LatencyProbe::RECEIVE_TO_WRITE].mean_ns, 20e6);
+  // the commands have no stamp
+  EXPECT_EQ(statistics[LatencyProbe::PUBLISH_TO_WRITE].count, 0u);
+}
+
+TEST_F(ForwardCommandControllerTest, CommandSequencesTest)
+{
+  ASSERT_EQ(controller_->init("forward_command_controller"), controller_interface::return_type::OK);
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+  controller_->get_node()->set_parameter({"interface_name", "position"});
+  controller_->get_node()->set_parameter({"command_sequence_interfaces", true});
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_THAT(
+    controller_->command_interface_configuration().names,
+    ::testing::ElementsAre(
+      "joint1/position", "joint2/position", "joint3/position", "joint1/position_sequence",
+      "joint2/position_sequence", "joint3/position_sequence"));
+
+  std::vector<double> sequences = {0.0, 0.0, 0.0};
+  CommandInterface joint_1_sequence{joint_names_[0], "position_sequence", &sequences[0]};
+  CommandInterface joint_2_sequence{joint_names_[1], "position_sequence", &sequences[1]};
+  CommandInterface joint_3_sequence{joint_names_[2], "position_sequence", &sequences[2]};
+  // in the order of the resource manager, sorted by name
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(joint_1_pos_cmd_);
+  command_ifs.emplace_back(joint_1_sequence);
+  command_ifs.emplace_back(joint_2_pos_cmd_);
+  command_ifs.emplace_back(joint_2_sequence);
+  command_ifs.emplace_back(joint_3_pos_cmd_);
+  command_ifs.emplace_back(joint_3_sequence);
+  controller_->assign_interfaces(std::move(command_ifs), {});
+  ASSERT_EQ(
+    controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  const auto update = [this](double joint_2_command)
+  {
+    auto command_ptr = std::make_shared<forward_command_controller::CmdType>();
+    command_ptr->data = {10.0, joint_2_command, 30.0};
+    controller_->rt_command_ptr_.writeFromNonRT(command_ptr);
+    ASSERT_EQ(
+      controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  // the first commands after activation count as changed
+  update(20.0);
+  EXPECT_EQ(sequences, std::vector<double>({1.0, 1.0, 1.0}));
+  update(20.0);
+  EXPECT_EQ(sequences, std::vector<double>({1.0, 1.0, 1.0}));
+  update(21.0);
+  EXPECT_EQ(sequences, std::vector<double>({1.0, 2.0, 1.0}));
+  EXPECT_EQ(joint_2_pos_cmd_.get_value(), 21.0);
+}
@@ -45,6 +45,15 @@ class FriendForwardCommandController : public forward_command_controller::Forwar
   FRIEND_TEST(ForwardCommandControllerTest, NoCommandCheckTest);
   FRIEND_TEST(ForwardCommandControllerTest, CommandCallbackTest);
   FRIEND_TEST(ForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess);
+  FRIEND_TEST(ForwardCommandControllerTest, PreallocatedCommandCallbackTest);
+  FRIEND_TEST(ForwardCommandControllerTest, PreallocatedCommandsResetSuccess);
+  FRIEND_TEST(ForwardCommandControllerTest, SafeValuesSizeMismatchFails);
+  FRIEND_TEST(ForwardCommandControllerTest, CommandTimeoutSafeValuesTest);
+  FRIEND_TEST(ForwardCommandControllerTest, SparseCommandsTest);
+  FRIEND_TEST(ForwardCommandControllerTest, InterpolationNeedsPreallocatedCommands);
+  FRIEND_TEST(ForwardCommandControllerTest, InterpolatedCommandsTest);
+  FRIEND_TEST(ForwardCommandControllerTest, CommandLatencyTest);
+  FRIEND_TEST(ForwardCommandControllerTest, CommandSequencesTest);
 };
 
 class ForwardCommandControllerTest : public ::testing::Test
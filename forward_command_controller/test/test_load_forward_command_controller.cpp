@@ -38,6 +38,16 @@ TEST(TestLoadForwardCommandController, load_controller)
     cm.load_controller(
       "test_forward_command_controller", "forward_command_controller/ForwardCommandController"),
     nullptr);
+  ASSERT_NE(
+    cm.load_controller(
+      "test_chainable_forward_command_controller",
+      "forward_command_controller/ChainableForwardCommandController"),
+    nullptr);
+  ASSERT_NE(
+    cm.load_controller(
+      "test_multi_group_forward_command_controller",
+      "forward_command_controller/MultiGroupForwardCommandController"),
+    nullptr);
 
   rclcpp::shutdown();
 }
@@ -40,4 +40,9 @@ TEST(TestLoadMultiInterfaceForwardController, load_controller)
       "test_forward_command_controller",
       "forward_command_controller/MultiInterfaceForwardCommandController"),
     nullptr);
+  ASSERT_NE(
+    cm.load_controller(
+      "test_chainable_forward_command_controller",
+      "forward_command_controller/ChainableMultiInterfaceForwardCommandController"),
+    nullptr);
 }
@@ -0,0 +1,303 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "test_multi_group_forward_command_controller.hpp"
+
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/node.hpp"
+#include "rclcpp/qos.hpp"
+#include "rclcpp/subscription.hpp"
+#include "rclcpp/utilities.hpp"
+#include "rclcpp/wait_set.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
+
+using hardware_interface::LoanedCommandInterface;
+
+namespace
+{
+rclcpp::WaitResultKind wait_for(rclcpp::SubscriptionBase::SharedPtr subscription)
+{
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  const auto timeout = std::chrono::seconds(10);
+  return wait_set.wait(timeout).kind();
+}
+
+std::shared_ptr<std_msgs::msg::Float64MultiArray> make_command(const std::vector<double> & data)
+{
+  auto command = std::make_shared<std_msgs::msg::Float64MultiArray>();
+  command->data = data;
+  return command;
+}
+}  // namespace
+
+void MultiGroupForwardCommandControllerTest::SetUpTestCase() { rclcpp::init(0, nullptr); }
+
+void MultiGroupForwardCommandControllerTest::TearDownTestCase() { rclcpp::shutdown(); }
+
+void MultiGroupForwardCommandControllerTest::SetUp()
+{
+  // initialize controller
+  controller_ = std::make_unique<FriendMultiGroupForwardCommandController>();
+}
+
+void MultiGroupForwardCommandControllerTest::TearDown() { controller_.reset(nullptr); }
+
+void MultiGroupForwardCommandControllerTest::SetUpController()
+{
+  const auto result = controller_->init("multi_group_forward_command_controller");
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+
+  // not in the order of the groups, to check the mapping of the interfaces
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(joint_3_vel_cmd_);
+  command_ifs.emplace_back(joint_1_vel_cmd_);
+  command_ifs.emplace_back(joint_4_vel_cmd_);
+  command_ifs.emplace_back(joint_2_vel_cmd_);
+  controller_->assign_interfaces(std::move(command_ifs), {});
+}
+
+void MultiGroupForwardCommandControllerTest::SetGroupParameters()
+{
+  auto node = controller_->get_node();
+  node->set_parameter({"group_names", std::vector<std::string>{"left", "right"}});
+  node->set_parameter({"groups.left.joints", std::vector<std::string>{"joint1", "joint2"}});
+  node->set_parameter({"groups.right.joints", std::vector<std::string>{"joint3", "joint4"}});
+  node->set_parameter({"interface_name", HW_IF_VELOCITY});
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, GroupNamesParameterEmpty)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"interface_name", HW_IF_VELOCITY});
+
+  // configure failed, 'group_names' is empty
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, InterfaceParameterEmpty)
+{
+  SetUpController();
+  SetGroupParameters();
+  controller_->get_node()->set_parameter({"interface_name", ""});
+
+  // configure failed, 'interface_name' is empty
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, GroupJointsEmpty)
+{
+  SetUpController();
+  SetGroupParameters();
+  controller_->get_node()->set_parameter({"groups.right.joints", std::vector<std::string>()});
+
+  // configure failed, the group 'right' has no joints
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, JointInSeveralGroups)
+{
+  SetUpController();
+  SetGroupParameters();
+  controller_->get_node()->set_parameter(
+    {"groups.right.joints", std::vector<std::string>{"joint2", "joint3"}});
+
+  // configure failed, 'joint2' would be commanded by both groups
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, ConfigureParamsSuccess)
+{
+  SetUpController();
+  SetGroupParameters();
+
+  // configure successful
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  // the interfaces of the groups one after another
+  EXPECT_THAT(
+    controller_->command_interface_configuration().names,
+    testing::ElementsAre(
+      "joint1/velocity", "joint2/velocity", "joint3/velocity", "joint4/velocity"));
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, ActivateWithWrongJointsNamesFails)
+{
+  SetUpController();
+  SetGroupParameters();
+  controller_->get_node()->set_parameter(
+    {"groups.right.joints", std::vector<std::string>{"joint3", "joint5"}});
+
+  // activate failed, 'joint5' is not a valid joint name for the hardware
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  ASSERT_EQ(
+    controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, CommandCallbackTest)
+{
+  SetUpController();
+  SetGroupParameters();
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // no command received yet, the interfaces are left as they are
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_vel_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_vel_cmd_.get_value(), 3.1);
+  ASSERT_EQ(joint_4_vel_cmd_.get_value(), 4.1);
+
+  // only the commanded group is written
+  controller_->command_callback(1, make_command({30.0, 40.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 1.1);
+  ASSERT_EQ(joint_2_vel_cmd_.get_value(), 2.1);
+  ASSERT_EQ(joint_3_vel_cmd_.get_value(), 30.0);
+  ASSERT_EQ(joint_4_vel_cmd_.get_value(), 40.0);
+
+  // a command not applied yet isn't overwritten by the one of another group
+  controller_->command_callback(0, make_command({10.0, 20.0}));
+  controller_->command_callback(1, make_command({31.0, 41.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_vel_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_3_vel_cmd_.get_value(), 31.0);
+  ASSERT_EQ(joint_4_vel_cmd_.get_value(), 41.0);
+
+  // a command of the wrong size is ignored
+  controller_->command_callback(0, make_command({11.0, 21.0, 99.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_vel_cmd_.get_value(), 20.0);
+
+  // the interfaces aren't written again without a new command
+  joint_3_vel_cmd_.set_value(3.3);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_3_vel_cmd_.get_value(), 3.3);
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, TopicCommandTest)
+{
+  SetUpController();
+  SetGroupParameters();
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  // send a new command to the group 'left'
+  rclcpp::Node test_node("test_node");
+  auto command_pub = test_node.create_publisher<std_msgs::msg::Float64MultiArray>(
+    std::string(controller_->get_node()->get_name()) + "/left/commands",
+    rclcpp::SystemDefaultsQoS());
+  std_msgs::msg::Float64MultiArray command_msg;
+  command_msg.data = {10.0, 20.0};
+  command_pub->publish(command_msg);
+
+  // wait for command message to be passed
+  ASSERT_EQ(wait_for(controller_->command_subscribers_[0]), rclcpp::WaitResultKind::Ready);
+
+  // process callbacks
+  rclcpp::spin_some(controller_->get_node()->get_node_base_interface());
+
+  // update successful
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  // check command in handle was set
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_vel_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_3_vel_cmd_.get_value(), 3.1);
+  ASSERT_EQ(joint_4_vel_cmd_.get_value(), 4.1);
+}
+
+TEST_F(MultiGroupForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess)
+{
+  SetUpController();
+  SetGroupParameters();
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  controller_->command_callback(0, make_command({10.0, 20.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_vel_cmd_.get_value(), 20.0);
+
+  node_state = controller_->get_node()->deactivate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+
+  // commands received while inactive are dropped on activation
+  controller_->command_callback(0, make_command({5.0, 6.0}));
+  controller_->command_callback(1, make_command({7.0, 8.0}));
+
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_2_vel_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_3_vel_cmd_.get_value(), 3.1);
+  ASSERT_EQ(joint_4_vel_cmd_.get_value(), 4.1);
+
+  // new commands are applied again
+  controller_->command_callback(1, make_command({7.0, 8.0}));
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  ASSERT_EQ(joint_3_vel_cmd_.get_value(), 7.0);
+  ASSERT_EQ(joint_4_vel_cmd_.get_value(), 8.0);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TEST_MULTI_GROUP_FORWARD_COMMAND_CONTROLLER_HPP_
+#define TEST_MULTI_GROUP_FORWARD_COMMAND_CONTROLLER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "forward_command_controller/multi_group_forward_command_controller.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+
+using hardware_interface::CommandInterface;
+using hardware_interface::HW_IF_VELOCITY;
+
+// subclassing and friending so we can access member variables
+class FriendMultiGroupForwardCommandController
+: public forward_command_controller::MultiGroupForwardCommandController
+{
+  FRIEND_TEST(MultiGroupForwardCommandControllerTest, CommandCallbackTest);
+  FRIEND_TEST(MultiGroupForwardCommandControllerTest, TopicCommandTest);
+  FRIEND_TEST(MultiGroupForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess);
+};
+
+class MultiGroupForwardCommandControllerTest : public ::testing::Test
+{
+public:
+  static void SetUpTestCase();
+  static void TearDownTestCase();
+
+  void SetUp();
+  void TearDown();
+
+  void SetUpController();
+  void SetGroupParameters();
+
+protected:
+  std::unique_ptr<FriendMultiGroupForwardCommandController> controller_;
+
+  // dummy joint command values used for tests
+  double joint_1_vel_ = 1.1;
+  double joint_2_vel_ = 2.1;
+  double joint_3_vel_ = 3.1;
+  double joint_4_vel_ = 4.1;
+
+  CommandInterface joint_1_vel_cmd_{"joint1", HW_IF_VELOCITY, &joint_1_vel_};
+  CommandInterface joint_2_vel_cmd_{"joint2", HW_IF_VELOCITY, &joint_2_vel_};
+  CommandInterface joint_3_vel_cmd_{"joint3", HW_IF_VELOCITY, &joint_3_vel_};
+  CommandInterface joint_4_vel_cmd_{"joint4", HW_IF_VELOCITY, &joint_4_vel_};
+};
+
+#endif  // TEST_MULTI_GROUP_FORWARD_COMMAND_CONTROLLER_HPP_
@@ -353,3 +353,61 @@ TEST_F(MultiInterfaceForwardCommandControllerTest, ActivateDeactivateCommandsRes
   ASSERT_EQ(joint_1_vel_cmd_.get_value(), 6.6);
   ASSERT_EQ(joint_1_eff_cmd_.get_value(), 7.7);
 }
+
+TEST_F(MultiInterfaceForwardCommandControllerTest, JointAndJointsParametersSetFails)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter({"joint", joint_name_});
+  controller_->get_node()->set_parameter({"joints", std::vector<std::string>{joint_name_}});
+  controller_->get_node()->set_parameter(
+    {"interface_names", std::vector<std::string>{HW_IF_POSITION}});
+
+  // configure failed, only one of 'joint' and 'joints' can be set
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiInterfaceForwardCommandControllerTest, MultipleJointsInterleavedCommandSuccess)
+{
+  const auto result = controller_->init("multi_interface_forward_command_controller");
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+
+  double joint_2_pos_cmd = 4.1;
+  double joint_2_vel_cmd = 5.1;
+  CommandInterface joint_2_pos_cmd_if{"joint2", HW_IF_POSITION, &joint_2_pos_cmd};
+  CommandInterface joint_2_vel_cmd_if{"joint2", HW_IF_VELOCITY, &joint_2_vel_cmd};
+
+  // the loaned interfaces aren't in the order of the commands
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(joint_2_vel_cmd_if);
+  command_ifs.emplace_back(joint_1_pos_cmd_);
+  command_ifs.emplace_back(joint_2_pos_cmd_if);
+  command_ifs.emplace_back(joint_1_vel_cmd_);
+  controller_->assign_interfaces(std::move(command_ifs), {});
+
+  controller_->get_node()->set_parameter(
+    {"joints", std::vector<std::string>{joint_name_, "joint2"}});
+  controller_->get_node()->set_parameter(
+    {"interface_names", std::vector<std::string>{HW_IF_POSITION, HW_IF_VELOCITY}});
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  // one command per joint and interface, [joint][interface]
+  auto command_ptr = std::make_shared<forward_command_controller::CmdType>();
+  command_ptr->data = {10.0, 20.0, 30.0, 40.0};
+  controller_->rt_command_ptr_.writeFromNonRT(command_ptr);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(100000000), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  ASSERT_EQ(joint_1_pos_cmd_.get_value(), 10.0);
+  ASSERT_EQ(joint_1_vel_cmd_.get_value(), 20.0);
+  ASSERT_EQ(joint_2_pos_cmd, 30.0);
+  ASSERT_EQ(joint_2_vel_cmd, 40.0);
+  ASSERT_EQ(joint_1_eff_cmd_.get_value(), 3.1);
+}
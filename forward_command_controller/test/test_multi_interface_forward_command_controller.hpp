@@ -50,6 +50,8 @@ class FriendMultiInterfaceForwardCommandController
   FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, NoCommandCheckTest);
   FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, CommandCallbackTest);
   FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, ActivateDeactivateCommandsResetSuccess);
+  FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, JointAndJointsParametersSetFails);
+  FRIEND_TEST(MultiInterfaceForwardCommandControllerTest, MultipleJointsInterleavedCommandSuccess);
 };
 
 class MultiInterfaceForwardCommandControllerTest : public ::testing::Test
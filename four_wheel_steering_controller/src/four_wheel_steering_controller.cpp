@@ -38,7 +38,7 @@ controller_interface::CallbackReturn FourWheelSteeringController::configure_odom
 
   odometry_.set_wheel_params(wheel_radius, wheelbase, wheel_track, y_steering_offset);
 
-  odometry_.set_odometry_type(steering_odometry::FOUR_STEERING_CONFIG);
+  odometry_.set_kinematic_model<steering_odometry::FourWheelSteerModel>();
 
   set_interface_numbers(NR_STATE_ITFS, NR_CMD_ITFS, NR_REF_ITFS);
 
@@ -52,46 +52,33 @@ bool FourWheelSteeringController::update_odometry(const rclcpp::Duration & perio
   {
     odometry_.update_open_loop(last_linear_velocity_, last_angular_velocity_, period.seconds());
   }
-  else
+  else if (state_values_valid_)
   {
-    const double front_right_wheel_value = state_interfaces_[STATE_TRACTION_FRONT_RIGHT_WHEEL].get_value();
-    const double front_left_wheel_value = state_interfaces_[STATE_TRACTION_FRONT_LEFT_WHEEL].get_value();
-    const double rear_right_wheel_value = state_interfaces_[STATE_TRACTION_REAR_RIGHT_WHEEL].get_value();
-    const double rear_left_wheel_value = state_interfaces_[STATE_TRACTION_REAR_LEFT_WHEEL].get_value();
+    const double front_right_wheel_value = state_values_[STATE_TRACTION_FRONT_RIGHT_WHEEL];
+    const double front_left_wheel_value = state_values_[STATE_TRACTION_FRONT_LEFT_WHEEL];
+    const double rear_right_wheel_value = state_values_[STATE_TRACTION_REAR_RIGHT_WHEEL];
+    const double rear_left_wheel_value = state_values_[STATE_TRACTION_REAR_LEFT_WHEEL];
 
-    const double front_right_steer_position = state_interfaces_[STATE_STEER_FRONT_RIGHT_WHEEL].get_value();
-    const double front_left_steer_position = state_interfaces_[STATE_STEER_FRONT_LEFT_WHEEL].get_value();
-    const double rear_right_steer_position = state_interfaces_[STATE_STEER_REAR_RIGHT_WHEEL].get_value();
-    const double rear_left_steer_position = state_interfaces_[STATE_STEER_REAR_LEFT_WHEEL].get_value();
-
-    if (
-      !std::isnan(front_right_wheel_value) && !std::isnan(front_left_wheel_value) &&
-      !std::isnan(rear_right_wheel_value) && !std::isnan(rear_left_wheel_value) &&
-      !std::isnan(front_right_steer_position) && !std::isnan(front_left_steer_position) &&
-      !std::isnan(rear_right_steer_position) && !std::isnan(rear_left_steer_position))
+    const double front_steer_position = steering_odometry::equivalent_steering_angle(
+      state_values_[STATE_STEER_FRONT_RIGHT_WHEEL], state_values_[STATE_STEER_FRONT_LEFT_WHEEL]);
+    const double rear_steer_position = steering_odometry::equivalent_steering_angle(
+      state_values_[STATE_STEER_REAR_RIGHT_WHEEL], state_values_[STATE_STEER_REAR_LEFT_WHEEL]);
+    if (params_.position_feedback)
+    {
+      // Estimate linear and angular velocity using joint information
+      odometry_.update_from_position(
+        front_right_wheel_value, front_left_wheel_value, rear_right_wheel_value,
+        rear_left_wheel_value, front_steer_position, rear_steer_position, period.seconds());
+    }
+    else
     {
-      if (params_.position_feedback)
-      {
-        double front_steer_position = 0.0;
-        if(fabs(front_right_steer_position) > 0.001 || fabs(front_left_steer_position) > 0.001)
-        {
-          front_steer_position = atan(2 * tan(front_right_steer_position) * tan(front_left_steer_position) /
-                                          (tan(front_right_steer_position) + tan(front_left_steer_position)));
-        }
-        double rear_steer_position = 0.0;
-        if(fabs(rear_right_steer_position) > 0.001 || fabs(rear_left_steer_position) > 0.001)
-        {
-          rear_steer_position = atan(2*tan(rear_right_steer_position)*tan(rear_left_steer_position)/
-                                        (tan(rear_right_steer_position) + tan(rear_left_steer_position)));
-        }
-        // Estimate linear and angular velocity using joint information
-        odometry_.update_four_steering(
-          front_right_wheel_value, front_left_wheel_value, rear_right_wheel_value,
-          rear_left_wheel_value, front_steer_position, rear_steer_position, period.seconds());
-      }
+      // Estimate linear and angular velocity using joint information
+      odometry_.update_from_velocity(
+        front_right_wheel_value, front_left_wheel_value, rear_right_wheel_value,
+        rear_left_wheel_value, front_steer_position, rear_steer_position, period.seconds());
     }
-    return true;
   }
+  return true;
 }
 }  // namespace four_wheel_steering_controller
 
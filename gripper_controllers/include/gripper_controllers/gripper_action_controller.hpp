@@ -19,9 +19,13 @@
 
 // C++ standard
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // ROS
 #include "rclcpp/rclcpp.hpp"
@@ -33,11 +37,14 @@
 #include "rclcpp_action/create_server.hpp"
 
 // ros_controls
-#include "controller_interface/controller_interface.hpp"
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_realtime_tools/action_monitor.hpp"
+#include "controller_realtime_tools/realtime_goal_slot.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
 #include "gripper_controllers/visibility_control.hpp"
 #include "hardware_interface/loaned_command_interface.hpp"
 #include "hardware_interface/loaned_state_interface.hpp"
-#include "realtime_tools/realtime_buffer.h"
 #include "realtime_tools/realtime_server_goal_handle.h"
 
 // Project
@@ -52,12 +59,16 @@ namespace gripper_action_controller
  * \brief Controller for executing a gripper command action for simple
  * single-dof grippers.
  *
+ * The controller is chainable: it exports the \p position and \p max_effort reference
+ * interfaces of its joint, so a preceding controller can command them on every update. In chained
+ * mode, the references of the preceding controller replace the action goals.
+ *
  * \tparam HardwareInterface Controller hardware interface. Currently \p
  * hardware_interface::HW_IF_POSITION and \p
  * hardware_interface::HW_IF_EFFORT are supported out-of-the-box.
  */
 template <const char * HardwareInterface>
-class GripperActionController : public controller_interface::ControllerInterface
+class GripperActionController : public controller_interface::ChainableControllerInterface
 {
 public:
   /**
@@ -66,8 +77,9 @@ public:
    */
   struct Commands
   {
-    double position_;    // Last commanded position
-    double max_effort_;  // Max allowed effort
+    double position_;        // Last commanded position
+    double max_effort_;      // Max allowed effort
+    std::uint64_t goal_id_;  // Action goal of the command, 0 when holding position
   };
 
   GRIPPER_ACTION_CONTROLLER_PUBLIC GripperActionController();
@@ -87,7 +99,11 @@ public:
   controller_interface::InterfaceConfiguration state_interface_configuration() const override;
 
   GRIPPER_ACTION_CONTROLLER_PUBLIC
-  controller_interface::return_type update(
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
   GRIPPER_ACTION_CONTROLLER_PUBLIC
@@ -105,9 +121,9 @@ public:
   controller_interface::CallbackReturn on_deactivate(
     const rclcpp_lifecycle::State & previous_state) override;
 
-  realtime_tools::RealtimeBuffer<Commands> command_;
-  // pre-allocated memory that is re-used to set the realtime buffer
-  Commands command_struct_, command_struct_rt_;
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<Commands>> command_;
+  // last command written to command_ by the non-realtime side
+  Commands command_struct_;
 
 protected:
   using GripperCommandAction = control_msgs::action::GripperCommand;
@@ -117,10 +133,35 @@ protected:
   using RealtimeGoalHandle =
     realtime_tools::RealtimeServerGoalHandle<control_msgs::action::GripperCommand>;
   using RealtimeGoalHandlePtr = std::shared_ptr<RealtimeGoalHandle>;
-  using RealtimeGoalHandleBuffer = realtime_tools::RealtimeBuffer<RealtimeGoalHandlePtr>;
+  using RealtimeGoalHandleSlot = controller_realtime_tools::RealtimeGoalSlot<RealtimeGoalHandle>;
 
   using HwIfaceAdapter = HardwareInterfaceAdapter<HardwareInterface>;
 
+  /// Indices of the references in reference_interfaces_
+  enum ReferenceIndex : std::size_t
+  {
+    POSITION_REFERENCE = 0,
+    MAX_EFFORT_REFERENCE = 1,
+  };
+
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
+  /**
+   * \brief Outcome of an action goal, handed by the realtime side to the non-realtime one which
+   * completes the goal
+   */
+  struct GoalCompletion
+  {
+    std::uint64_t goal_id_ = 0;  // Completed action goal, 0 for none
+    bool succeeded_ = false;     // Succeeded or aborted
+    bool reached_goal_ = false;
+    bool stalled_ = false;
+    double position_ = 0.0;
+    double effort_ = 0.0;
+  };
+
   bool update_hold_position_;
 
   bool verbose_ = false;  ///< Hard coded verbose flag to help in debugging
@@ -137,16 +178,26 @@ protected:
 
   HwIfaceAdapter hw_iface_adapter_;  ///< Adapts desired goal state to HW interface.
 
-  RealtimeGoalHandleBuffer
+  RealtimeGoalHandleSlot
     rt_active_goal_;  ///< Container for the currently active action goal, if any.
   control_msgs::action::GripperCommand::Result::SharedPtr pre_alloc_result_;
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<GoalCompletion>>
+    goal_completion_;  ///< Goal completed by the realtime side, if any.
+  std::uint64_t goal_id_ = 0;       ///< Id of the last accepted goal, non-realtime.
+  std::uint64_t rt_goal_id_ = 0;    ///< Id of the goal of the last command, realtime.
+  bool rt_goal_completed_ = false;  ///< Whether rt_goal_id_ was completed, realtime.
+  std::uint64_t reference_goal_id_ = 0;  ///< Goal of the references, realtime.
+  double position_reference_ = 0.0;      ///< Last valid position reference, realtime.
 
   rclcpp::Duration action_monitor_period_;
 
   // ROS API
   ActionServerPtr action_server_;
 
-  rclcpp::TimerBase::SharedPtr goal_handle_timer_;
+  std::mutex monitored_goal_mutex_;
+  // last accepted goal, serviced by action_monitor_ until it is done
+  RealtimeGoalHandlePtr monitored_goal_;
+  std::uint64_t monitored_goal_id_ = 0;
 
   rclcpp_action::GoalResponse goal_callback(
     const rclcpp_action::GoalUUID & uuid, std::shared_ptr<const GripperCommandAction::Goal> goal);
@@ -159,15 +210,35 @@ protected:
 
   void set_hold_position();
 
+  /// Write command_struct_ to the realtime side.
+  void write_command();
+
+  /**
+   * \brief Service of action_monitor_: complete the monitored goal if the realtime side did, then
+   * update its action status.
+   * \return true while the goal waits for a transition of the action server rather than for the
+   * realtime side
+   **/
+  bool monitor_goal();
+
   rclcpp::Time last_movement_time_ = rclcpp::Time(0, 0, RCL_ROS_TIME);  ///< Store stall time
   double computed_command_;                                             ///< Computed command
 
   /**
-   * \brief Check for success and publish appropriate result and feedback.
+   * \brief Check for success or stall of the goal \p goal_id and hand its result to the
+   * non-realtime side.
    **/
   void check_for_success(
-    const rclcpp::Time & time, double error_position, double current_position,
-    double current_velocity);
+    const rclcpp::Time & time, std::uint64_t goal_id, double error_position,
+    double current_position, double current_velocity);
+
+  /// Hand the completion of the goal \p goal_id to the non-realtime side, realtime.
+  void complete_goal(
+    std::uint64_t goal_id, bool succeeded, bool reached_goal, bool stalled,
+    double current_position);
+
+  /// Services the monitored goal, declared last to stop before the members it uses are destroyed.
+  std::unique_ptr<controller_realtime_tools::ActionMonitor> action_monitor_;
 };
 
 }  // namespace gripper_action_controller
@@ -19,8 +19,11 @@
 
 #include "gripper_controllers/gripper_action_controller.hpp"
 
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace gripper_action_controller
 {
@@ -28,12 +31,12 @@ template <const char * HardwareInterface>
 void GripperActionController<HardwareInterface>::preempt_active_goal()
 {
   // Cancels the currently active goal
-  const auto active_goal = *rt_active_goal_.readFromNonRT();
+  const auto active_goal = rt_active_goal_.get();
   if (active_goal)
   {
     // Marks the current goal as canceled
     active_goal->setCanceled(std::make_shared<GripperCommandAction::Result>());
-    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    rt_active_goal_.reset();
   }
 }
 
@@ -55,23 +58,65 @@ controller_interface::CallbackReturn GripperActionController<HardwareInterface>:
 }
 
 template <const char * HardwareInterface>
-controller_interface::return_type GripperActionController<HardwareInterface>::update(
+std::vector<hardware_interface::CommandInterface>
+GripperActionController<HardwareInterface>::on_export_reference_interfaces()
+{
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.emplace_back(
+    std::string(get_node()->get_name()), params_.joint + "/" + hardware_interface::HW_IF_POSITION,
+    &reference_interfaces_[POSITION_REFERENCE]);
+  reference_interfaces.emplace_back(
+    std::string(get_node()->get_name()), params_.joint + "/max_effort",
+    &reference_interfaces_[MAX_EFFORT_REFERENCE]);
+  return reference_interfaces;
+}
+
+template <const char * HardwareInterface>
+bool GripperActionController<HardwareInterface>::on_set_chained_mode(bool /*chained_mode*/)
+{
+  return true;
+}
+
+template <const char * HardwareInterface>
+controller_interface::return_type
+GripperActionController<HardwareInterface>::update_reference_from_subscribers(
   const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
 {
-  command_struct_rt_ = *(command_.readFromRT());
+  // the command of the action goal, or of holding position
+  const Commands & command = command_->read();
+  reference_interfaces_[POSITION_REFERENCE] = command.position_;
+  reference_interfaces_[MAX_EFFORT_REFERENCE] = command.max_effort_;
+  reference_goal_id_ = command.goal_id_;
+  return controller_interface::return_type::OK;
+}
+
+template <const char * HardwareInterface>
+controller_interface::return_type
+GripperActionController<HardwareInterface>::update_and_write_commands(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  // the references of a preceding controller don't belong to an action goal
+  const std::uint64_t goal_id = is_in_chained_mode() ? 0 : reference_goal_id_;
+  // a missing reference holds the last position, or limits the effort as configured
+  if (!std::isnan(reference_interfaces_[POSITION_REFERENCE]))
+  {
+    position_reference_ = reference_interfaces_[POSITION_REFERENCE];
+  }
+  const double max_effort = std::isnan(reference_interfaces_[MAX_EFFORT_REFERENCE])
+                              ? params_.max_effort
+                              : reference_interfaces_[MAX_EFFORT_REFERENCE];
 
   const double current_position = joint_position_state_interface_->get().get_value();
   const double current_velocity = joint_velocity_state_interface_->get().get_value();
 
-  const double error_position = command_struct_rt_.position_ - current_position;
+  const double error_position = position_reference_ - current_position;
   const double error_velocity = -current_velocity;
 
-  check_for_success(get_node()->now(), error_position, current_position, current_velocity);
+  check_for_success(time, goal_id, error_position, current_position, current_velocity);
 
   // Hardware interface adapter: Generate and send commands
   computed_command_ = hw_iface_adapter_.updateCommand(
-    command_struct_rt_.position_, 0.0, error_position, error_velocity,
-    command_struct_rt_.max_effort_);
+    position_reference_, 0.0, error_position, error_velocity, max_effort, period);
   return controller_interface::return_type::OK;
 }
 
@@ -79,6 +124,13 @@ template <const char * HardwareInterface>
 rclcpp_action::GoalResponse GripperActionController<HardwareInterface>::goal_callback(
   const rclcpp_action::GoalUUID &, std::shared_ptr<const GripperCommandAction::Goal>)
 {
+  if (is_in_chained_mode())
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(),
+      "Rejected action goal, the gripper is commanded by a preceding controller in chained mode");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
   RCLCPP_INFO(get_node()->get_logger(), "Received & accepted new action goal");
   return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
 }
@@ -96,22 +148,63 @@ void GripperActionController<HardwareInterface>::accepted_callback(
   // We use command_ for sharing
   command_struct_.position_ = goal_handle->get_goal()->command.position;
   command_struct_.max_effort_ = goal_handle->get_goal()->command.max_effort;
-  command_.writeFromNonRT(command_struct_);
+  command_struct_.goal_id_ = ++goal_id_;
+  write_command();
 
-  pre_alloc_result_->reached_goal = false;
-  pre_alloc_result_->stalled = false;
-
-  last_movement_time_ = get_node()->now();
   rt_goal->execute();
-  rt_active_goal_.writeFromNonRT(rt_goal);
+  rt_active_goal_.set(rt_goal);
 
-  // Set smartpointer to expire for create_wall_timer to delete previous entry from timer list
-  goal_handle_timer_.reset();
+  {
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    monitored_goal_ = rt_goal;
+    monitored_goal_id_ = goal_id_;
+  }
+  action_monitor_->notify();
+}
 
-  // Setup goal status checking timer
-  goal_handle_timer_ = get_node()->create_wall_timer(
-    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
-    std::bind(&RealtimeGoalHandle::runNonRealtime, rt_goal));
+template <const char * HardwareInterface>
+bool GripperActionController<HardwareInterface>::monitor_goal()
+{
+  std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+  if (!monitored_goal_)
+  {
+    return false;
+  }
+
+  const GoalCompletion & completion = goal_completion_->read();
+  // the goal may have been canceled or preempted since the realtime side completed it
+  if (completion.goal_id_ == monitored_goal_id_ && rt_active_goal_.get() == monitored_goal_)
+  {
+    pre_alloc_result_->effort = completion.effort_;
+    pre_alloc_result_->position = completion.position_;
+    pre_alloc_result_->reached_goal = completion.reached_goal_;
+    pre_alloc_result_->stalled = completion.stalled_;
+    if (completion.reached_goal_)
+    {
+      RCLCPP_DEBUG(get_node()->get_logger(), "Successfully moved to goal.");
+      monitored_goal_->setSucceeded(pre_alloc_result_);
+    }
+    else if (completion.succeeded_)
+    {
+      RCLCPP_DEBUG(get_node()->get_logger(), "Stall detected moving to goal. Returning success.");
+      monitored_goal_->setSucceeded(pre_alloc_result_);
+    }
+    else
+    {
+      RCLCPP_DEBUG(get_node()->get_logger(), "Stall detected moving to goal. Aborting action!");
+      monitored_goal_->setAborted(pre_alloc_result_);
+    }
+    rt_active_goal_.reset();
+  }
+
+  monitored_goal_->runNonRealtime();
+  if (!monitored_goal_->gh_->is_active())
+  {
+    monitored_goal_.reset();
+    return false;
+  }
+  // the active goal waits for the realtime side, a canceled one for the action server
+  return rt_active_goal_.get() != monitored_goal_;
 }
 
 template <const char * HardwareInterface>
@@ -121,7 +214,7 @@ rclcpp_action::CancelResponse GripperActionController<HardwareInterface>::cancel
   RCLCPP_INFO(get_node()->get_logger(), "Got request to cancel goal");
 
   // Check that cancel request refers to currently active goal (if any)
-  const auto active_goal = *rt_active_goal_.readFromNonRT();
+  const auto active_goal = rt_active_goal_.get();
   if (active_goal && active_goal->gh_ == goal_handle)
   {
     // Enter hold current position mode
@@ -134,7 +227,9 @@ rclcpp_action::CancelResponse GripperActionController<HardwareInterface>::cancel
     auto action_res = std::make_shared<GripperCommandAction::Result>();
     active_goal->setCanceled(action_res);
     // Reset current goal
-    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    rt_active_goal_.reset();
+    // the action server completes the cancel after this callback returned
+    action_monitor_->notify();
   }
   return rclcpp_action::CancelResponse::ACCEPT;
 }
@@ -144,29 +239,37 @@ void GripperActionController<HardwareInterface>::set_hold_position()
 {
   command_struct_.position_ = joint_position_state_interface_->get().get_value();
   command_struct_.max_effort_ = params_.max_effort;
-  command_.writeFromNonRT(command_struct_);
+  command_struct_.goal_id_ = 0;
+  write_command();
+}
+
+template <const char * HardwareInterface>
+void GripperActionController<HardwareInterface>::write_command()
+{
+  command_->write_buffer() = command_struct_;
+  command_->publish();
 }
 
 template <const char * HardwareInterface>
 void GripperActionController<HardwareInterface>::check_for_success(
-  const rclcpp::Time & time, double error_position, double current_position,
-  double current_velocity)
+  const rclcpp::Time & time, std::uint64_t goal_id, double error_position,
+  double current_position, double current_velocity)
 {
-  const auto active_goal = *rt_active_goal_.readFromNonRT();
-  if (!active_goal)
+  if (goal_id != rt_goal_id_)
+  {
+    // first command of a new goal, or holding position
+    rt_goal_id_ = goal_id;
+    rt_goal_completed_ = false;
+    last_movement_time_ = time;
+  }
+  if (goal_id == 0 || rt_goal_completed_)
   {
     return;
   }
 
   if (fabs(error_position) < params_.goal_tolerance)
   {
-    pre_alloc_result_->effort = computed_command_;
-    pre_alloc_result_->position = current_position;
-    pre_alloc_result_->reached_goal = true;
-    pre_alloc_result_->stalled = false;
-    RCLCPP_DEBUG(get_node()->get_logger(), "Successfully moved to goal.");
-    active_goal->setSucceeded(pre_alloc_result_);
-    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    complete_goal(goal_id, true, true, false, current_position);
   }
   else
   {
@@ -176,26 +279,27 @@ void GripperActionController<HardwareInterface>::check_for_success(
     }
     else if ((time - last_movement_time_).seconds() > params_.stall_timeout)
     {
-      pre_alloc_result_->effort = computed_command_;
-      pre_alloc_result_->position = current_position;
-      pre_alloc_result_->reached_goal = false;
-      pre_alloc_result_->stalled = true;
-
-      if (params_.allow_stalling)
-      {
-        RCLCPP_DEBUG(get_node()->get_logger(), "Stall detected moving to goal. Returning success.");
-        active_goal->setSucceeded(pre_alloc_result_);
-      }
-      else
-      {
-        RCLCPP_DEBUG(get_node()->get_logger(), "Stall detected moving to goal. Aborting action!");
-        active_goal->setAborted(pre_alloc_result_);
-      }
-      rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+      complete_goal(goal_id, params_.allow_stalling, false, true, current_position);
     }
   }
 }
 
+template <const char * HardwareInterface>
+void GripperActionController<HardwareInterface>::complete_goal(
+  std::uint64_t goal_id, bool succeeded, bool reached_goal, bool stalled, double current_position)
+{
+  GoalCompletion & completion = goal_completion_->write_buffer();
+  completion.goal_id_ = goal_id;
+  completion.succeeded_ = succeeded;
+  completion.reached_goal_ = reached_goal;
+  completion.stalled_ = stalled;
+  completion.position_ = current_position;
+  completion.effort_ = computed_command_;
+  goal_completion_->publish();
+  rt_goal_completed_ = true;
+  action_monitor_->notify();
+}
+
 template <const char * HardwareInterface>
 controller_interface::CallbackReturn GripperActionController<HardwareInterface>::on_configure(
   const rclcpp_lifecycle::State &)
@@ -212,6 +316,14 @@ controller_interface::CallbackReturn GripperActionController<HardwareInterface>:
   action_monitor_period_ = rclcpp::Duration::from_seconds(1.0 / params_.action_monitor_rate);
   RCLCPP_INFO_STREAM(
     logger, "Action status changes will be monitored at " << params_.action_monitor_rate << "Hz.");
+  action_monitor_ = std::make_unique<controller_realtime_tools::ActionMonitor>(
+    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
+    [this]() { return monitor_goal(); });
+  if (!action_monitor_->set_scheduling(controller_realtime_tools::make_thread_scheduling(
+        params_.non_realtime_threads.priority, params_.non_realtime_threads.cpu_affinity)))
+  {
+    RCLCPP_WARN(logger, "Could not set the scheduling of the action monitor thread.");
+  }
 
   // Controlled joint
   if (params_.joint.empty())
@@ -220,6 +332,9 @@ controller_interface::CallbackReturn GripperActionController<HardwareInterface>:
     return controller_interface::CallbackReturn::ERROR;
   }
 
+  // exported after configuration, the size stays the same so the exported interfaces stay valid
+  reference_interfaces_.assign(2, std::numeric_limits<double>::quiet_NaN());
+
   return controller_interface::CallbackReturn::SUCCESS;
 }
 template <const char * HardwareInterface>
@@ -288,7 +403,23 @@ controller_interface::CallbackReturn GripperActionController<HardwareInterface>:
   // Command - non RT version
   command_struct_.position_ = joint_position_state_interface_->get().get_value();
   command_struct_.max_effort_ = params_.max_effort;
-  command_.initRT(command_struct_);
+  command_struct_.goal_id_ = 0;
+  command_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<Commands>>(command_struct_);
+  {
+    // the monitor may still read the completions of the previous activation
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    goal_completion_ =
+      std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<GoalCompletion>>(
+        GoalCompletion());
+  }
+  rt_goal_id_ = 0;
+  rt_goal_completed_ = false;
+  // hold position until the first references
+  reference_interfaces_[POSITION_REFERENCE] = command_struct_.position_;
+  reference_interfaces_[MAX_EFFORT_REFERENCE] = command_struct_.max_effort_;
+  reference_goal_id_ = 0;
+  position_reference_ = command_struct_.position_;
 
   // Result
   pre_alloc_result_ = std::make_shared<control_msgs::action::GripperCommand::Result>();
@@ -339,7 +470,7 @@ GripperActionController<HardwareInterface>::state_interface_configuration() cons
 
 template <const char * HardwareInterface>
 GripperActionController<HardwareInterface>::GripperActionController()
-: controller_interface::ControllerInterface(),
+: controller_interface::ChainableControllerInterface(),
   action_monitor_period_(rclcpp::Duration::from_seconds(0))
 {
 }
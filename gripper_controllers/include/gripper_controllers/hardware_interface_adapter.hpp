@@ -24,8 +24,9 @@
 #include <string>
 #include <vector>
 
-#include "control_toolbox/pid.hpp"
+#include "controller_realtime_tools/batched_pid.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/duration.hpp"
 #include "rclcpp/time.hpp"
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
 
@@ -54,7 +55,8 @@ public:
 
   double updateCommand(
     double /* desired_position */, double /* desired_velocity */, double /* error_position */,
-    double /* error_velocity */, double /* max_allowed_effort */)
+    double /* error_velocity */, double /* max_allowed_effort */,
+    const rclcpp::Duration & /* period */)
   {
     return 0.0;
   }
@@ -81,7 +83,7 @@ public:
 
   double updateCommand(
     double desired_position, double /* desired_velocity */, double /* error_position */,
-    double /* error_velocity */, double max_allowed_effort)
+    double /* error_velocity */, double max_allowed_effort, const rclcpp::Duration & /* period */)
   {
     // Forward desired position to command
     joint_handle_->get().set_value(desired_position);
@@ -137,7 +139,7 @@ public:
     const auto k_d = auto_declare<double>(node, prefix + ".d", 0.0);
     const auto i_clamp = auto_declare<double>(node, prefix + ".i_clamp", 0.0);
     // Initialize PID
-    pid_ = std::make_shared<control_toolbox::Pid>(k_p, k_i, k_d, i_clamp, -i_clamp);
+    pid_.configure({{k_p, k_i, k_d, i_clamp}});
     return true;
   }
 
@@ -148,7 +150,7 @@ public:
       return;
     }
     // Reset PIDs, zero effort commands
-    pid_->reset();
+    pid_.reset();
     joint_handle_->get().set_value(0.0);
   }
 
@@ -156,29 +158,26 @@ public:
 
   double updateCommand(
     double /* desired_position */, double /* desired_velocity */, double error_position,
-    double error_velocity, double max_allowed_effort)
+    double error_velocity, double max_allowed_effort, const rclcpp::Duration & period)
   {
     // Preconditions
     if (!joint_handle_)
     {
       return 0.0;
     }
-    // Time since the last call to update
-    const auto period = std::chrono::steady_clock::now() - last_update_time_;
-    // Update PIDs
-    double command = pid_->computeCommand(error_position, error_velocity, period.count());
+    // Update PIDs over the period of the controller
+    double command = 0.0;
+    pid_.compute_commands(
+      &error_position, &error_velocity, static_cast<double>(period.nanoseconds()) / 1e9, &command);
     command = std::min<double>(
       fabs(max_allowed_effort), std::max<double>(-fabs(max_allowed_effort), command));
     joint_handle_->get().set_value(command);
-    last_update_time_ = std::chrono::steady_clock::now();
     return command;
   }
 
 private:
-  using PidPtr = std::shared_ptr<control_toolbox::Pid>;
-  PidPtr pid_;
+  controller_realtime_tools::BatchedPid pid_;
   std::optional<std::reference_wrapper<hardware_interface::LoanedCommandInterface>> joint_handle_;
-  std::chrono::steady_clock::time_point last_update_time_;
 };
 
 #endif  // GRIPPER_CONTROLLERS__HARDWARE_INTERFACE_ADAPTER_HPP_
@@ -0,0 +1,230 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GRIPPER_CONTROLLERS__MULTI_JOINT_GRIPPER_ACTION_CONTROLLER_HPP_
+#define GRIPPER_CONTROLLERS__MULTI_JOINT_GRIPPER_ACTION_CONTROLLER_HPP_
+
+// C++ standard
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ROS
+#include "rclcpp/rclcpp.hpp"
+
+// ROS messages
+#include "control_msgs/action/gripper_command.hpp"
+
+// rclcpp_action
+#include "rclcpp_action/create_server.hpp"
+
+// ros_controls
+#include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/action_monitor.hpp"
+#include "controller_realtime_tools/realtime_goal_slot.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+#include "gripper_controllers/visibility_control.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "realtime_tools/realtime_server_goal_handle.h"
+
+// Project
+#include "gripper_controllers/multi_joint_hardware_interface_adapter.hpp"
+
+// auto-generated by generate_parameter_library
+#include "multi_joint_gripper_action_controller_parameters.hpp"
+
+namespace gripper_action_controller
+{
+/**
+ * \brief Controller for executing a gripper command action for grippers with several joints,
+ * e.g. the fingers of a hand.
+ *
+ * All joints are commanded to the position of the goal, through one hardware interface adapter
+ * for all of them. The goal is reached when all joints are within the goal tolerance, and the
+ * gripper stalls when none of the joints moves. The result reports the mean position and effort
+ * of the joints. The PID gains of the effort variant are reloaded when a goal is accepted.
+ *
+ * \tparam HardwareInterface Controller hardware interface. Currently \p
+ * hardware_interface::HW_IF_POSITION and \p
+ * hardware_interface::HW_IF_EFFORT are supported out-of-the-box.
+ */
+template <const char * HardwareInterface>
+class MultiJointGripperActionController : public controller_interface::ControllerInterface
+{
+public:
+  /**
+   * \brief Store the positions and max effort in struct to allow easier realtime buffer usage
+   */
+  struct Commands
+  {
+    std::vector<double> positions_;  // Last commanded position of each joint
+    double max_effort_;              // Max allowed effort
+    std::uint64_t goal_id_;          // Action goal of the command, 0 when holding position
+  };
+
+  GRIPPER_ACTION_CONTROLLER_PUBLIC MultiJointGripperActionController();
+
+  /**
+   * @brief command_interface_configuration This controller requires the
+   * position command interfaces for the controlled joints
+   */
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+
+  /**
+   * @brief command_interface_configuration This controller requires the
+   * position and velocity state interfaces for the controlled joints
+   */
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_init() override;
+
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_configure(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_activate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  GRIPPER_ACTION_CONTROLLER_PUBLIC
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<Commands>> command_;
+  // last command written to command_ by the non-realtime side
+  Commands command_struct_;
+
+protected:
+  using GripperCommandAction = control_msgs::action::GripperCommand;
+  using ActionServer = rclcpp_action::Server<GripperCommandAction>;
+  using ActionServerPtr = ActionServer::SharedPtr;
+  using GoalHandle = rclcpp_action::ServerGoalHandle<GripperCommandAction>;
+  using RealtimeGoalHandle =
+    realtime_tools::RealtimeServerGoalHandle<control_msgs::action::GripperCommand>;
+  using RealtimeGoalHandlePtr = std::shared_ptr<RealtimeGoalHandle>;
+  using RealtimeGoalHandleSlot = controller_realtime_tools::RealtimeGoalSlot<RealtimeGoalHandle>;
+  using Params = multi_joint_gripper_action_controller::Params;
+  using ParamListener = multi_joint_gripper_action_controller::ParamListener;
+
+  using HwIfaceAdapter = MultiJointHardwareInterfaceAdapter<HardwareInterface>;
+
+  /**
+   * \brief Outcome of an action goal, handed by the realtime side to the non-realtime one which
+   * completes the goal
+   */
+  struct GoalCompletion
+  {
+    std::uint64_t goal_id_ = 0;  // Completed action goal, 0 for none
+    bool succeeded_ = false;     // Succeeded or aborted
+    bool reached_goal_ = false;
+    bool stalled_ = false;
+    double position_ = 0.0;
+    double effort_ = 0.0;
+  };
+
+  size_t dof_ = 0;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>
+    joint_position_command_interfaces_;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
+    joint_position_state_interfaces_;
+  std::vector<std::reference_wrapper<hardware_interface::LoanedStateInterface>>
+    joint_velocity_state_interfaces_;
+
+  std::shared_ptr<ParamListener> param_listener_;
+  Params params_;
+
+  HwIfaceAdapter hw_iface_adapter_;  ///< Adapts desired goal state to HW interface.
+
+  RealtimeGoalHandleSlot
+    rt_active_goal_;  ///< Container for the currently active action goal, if any.
+  control_msgs::action::GripperCommand::Result::SharedPtr pre_alloc_result_;
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<GoalCompletion>>
+    goal_completion_;  ///< Goal completed by the realtime side, if any.
+  std::uint64_t goal_id_ = 0;       ///< Id of the last accepted goal, non-realtime.
+  std::uint64_t rt_goal_id_ = 0;    ///< Id of the goal of the last command, realtime.
+  bool rt_goal_completed_ = false;  ///< Whether rt_goal_id_ was completed, realtime.
+
+  rclcpp::Duration action_monitor_period_;
+
+  // ROS API
+  ActionServerPtr action_server_;
+
+  std::mutex monitored_goal_mutex_;
+  // last accepted goal, serviced by action_monitor_ until it is done
+  RealtimeGoalHandlePtr monitored_goal_;
+  std::uint64_t monitored_goal_id_ = 0;
+
+  // pre-allocated per joint values of update()
+  std::vector<double> current_positions_;
+  std::vector<double> error_positions_;
+  std::vector<double> error_velocities_;
+  std::vector<double> computed_commands_;  ///< Computed command of each joint
+
+  rclcpp_action::GoalResponse goal_callback(
+    const rclcpp_action::GoalUUID & uuid, std::shared_ptr<const GripperCommandAction::Goal> goal);
+
+  rclcpp_action::CancelResponse cancel_callback(const std::shared_ptr<GoalHandle> goal_handle);
+
+  void accepted_callback(std::shared_ptr<GoalHandle> goal_handle);
+
+  void preempt_active_goal();
+
+  void set_hold_position();
+
+  /// PID gains of every joint from \p params, in the order of the joints.
+  std::vector<typename HwIfaceAdapter::Gains> get_gains(const Params & params) const;
+
+  /// Write command_struct_ to the realtime side.
+  void write_command();
+
+  /**
+   * \brief Service of action_monitor_: complete the monitored goal if the realtime side did, then
+   * update its action status.
+   * \return true while the goal waits for a transition of the action server rather than for the
+   * realtime side
+   **/
+  bool monitor_goal();
+
+  rclcpp::Time last_movement_time_ = rclcpp::Time(0, 0, RCL_ROS_TIME);  ///< Store stall time
+
+  /**
+   * \brief Check for success or stall of the goal \p goal_id from the values of all joints and
+   * hand its result to the non-realtime side.
+   **/
+  void check_for_success(const rclcpp::Time & time, std::uint64_t goal_id);
+
+  /// Hand the completion of the goal \p goal_id to the non-realtime side, realtime.
+  void complete_goal(std::uint64_t goal_id, bool succeeded, bool reached_goal, bool stalled);
+
+  /// Services the monitored goal, declared last to stop before the members it uses are destroyed.
+  std::unique_ptr<controller_realtime_tools::ActionMonitor> action_monitor_;
+};
+
+}  // namespace gripper_action_controller
+
+#include "gripper_controllers/multi_joint_gripper_action_controller_impl.hpp"
+
+#endif  // GRIPPER_CONTROLLERS__MULTI_JOINT_GRIPPER_ACTION_CONTROLLER_HPP_
@@ -0,0 +1,470 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GRIPPER_CONTROLLERS__MULTI_JOINT_GRIPPER_ACTION_CONTROLLER_IMPL_HPP_
+#define GRIPPER_CONTROLLERS__MULTI_JOINT_GRIPPER_ACTION_CONTROLLER_IMPL_HPP_
+
+#include "gripper_controllers/multi_joint_gripper_action_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller_interface/helpers.hpp"
+
+namespace gripper_action_controller
+{
+template <const char * HardwareInterface>
+void MultiJointGripperActionController<HardwareInterface>::preempt_active_goal()
+{
+  // Cancels the currently active goal
+  const auto active_goal = rt_active_goal_.get();
+  if (active_goal)
+  {
+    // Marks the current goal as canceled
+    active_goal->setCanceled(std::make_shared<GripperCommandAction::Result>());
+    rt_active_goal_.reset();
+  }
+}
+
+template <const char * HardwareInterface>
+controller_interface::CallbackReturn MultiJointGripperActionController<HardwareInterface>::on_init()
+{
+  try
+  {
+    param_listener_ = std::make_shared<ParamListener>(get_node());
+    params_ = param_listener_->get_params();
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(stderr, "Exception thrown during init stage with message: %s \n", e.what());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+template <const char * HardwareInterface>
+controller_interface::return_type MultiJointGripperActionController<HardwareInterface>::update(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  const Commands & command = command_->read();
+
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    current_positions_[i] = joint_position_state_interfaces_[i].get().get_value();
+    error_positions_[i] = command.positions_[i] - current_positions_[i];
+    error_velocities_[i] = -joint_velocity_state_interfaces_[i].get().get_value();
+  }
+
+  check_for_success(time, command.goal_id_);
+
+  // Hardware interface adapter: Generate and send commands of all joints
+  hw_iface_adapter_.updateCommand(
+    command.positions_, error_positions_, error_velocities_, command.max_effort_, period,
+    computed_commands_);
+  return controller_interface::return_type::OK;
+}
+
+template <const char * HardwareInterface>
+rclcpp_action::GoalResponse MultiJointGripperActionController<HardwareInterface>::goal_callback(
+  const rclcpp_action::GoalUUID &, std::shared_ptr<const GripperCommandAction::Goal>)
+{
+  RCLCPP_INFO(get_node()->get_logger(), "Received & accepted new action goal");
+  return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+}
+
+template <const char * HardwareInterface>
+void MultiJointGripperActionController<HardwareInterface>::accepted_callback(
+  std::shared_ptr<GoalHandle> goal_handle)  // Try to update goal
+{
+  auto rt_goal = std::make_shared<RealtimeGoalHandle>(goal_handle);
+
+  // Accept new goal
+  preempt_active_goal();
+
+  // The adapter applies the gains changed since the last goal in its next update
+  const auto params = param_listener_->get_params();
+  if (params.joints == params_.joints)
+  {
+    hw_iface_adapter_.set_gains(get_gains(params));
+  }
+
+  // All joints move to the position of the goal
+  std::fill(
+    command_struct_.positions_.begin(), command_struct_.positions_.end(),
+    goal_handle->get_goal()->command.position);
+  command_struct_.max_effort_ = goal_handle->get_goal()->command.max_effort;
+  command_struct_.goal_id_ = ++goal_id_;
+  write_command();
+
+  rt_goal->execute();
+  rt_active_goal_.set(rt_goal);
+
+  {
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    monitored_goal_ = rt_goal;
+    monitored_goal_id_ = goal_id_;
+  }
+  action_monitor_->notify();
+}
+
+template <const char * HardwareInterface>
+bool MultiJointGripperActionController<HardwareInterface>::monitor_goal()
+{
+  std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+  if (!monitored_goal_)
+  {
+    return false;
+  }
+
+  const GoalCompletion & completion = goal_completion_->read();
+  // the goal may have been canceled or preempted since the realtime side completed it
+  if (completion.goal_id_ == monitored_goal_id_ && rt_active_goal_.get() == monitored_goal_)
+  {
+    pre_alloc_result_->effort = completion.effort_;
+    pre_alloc_result_->position = completion.position_;
+    pre_alloc_result_->reached_goal = completion.reached_goal_;
+    pre_alloc_result_->stalled = completion.stalled_;
+    if (completion.reached_goal_)
+    {
+      RCLCPP_DEBUG(get_node()->get_logger(), "Successfully moved to goal.");
+      monitored_goal_->setSucceeded(pre_alloc_result_);
+    }
+    else if (completion.succeeded_)
+    {
+      RCLCPP_DEBUG(get_node()->get_logger(), "Stall detected moving to goal. Returning success.");
+      monitored_goal_->setSucceeded(pre_alloc_result_);
+    }
+    else
+    {
+      RCLCPP_DEBUG(get_node()->get_logger(), "Stall detected moving to goal. Aborting action!");
+      monitored_goal_->setAborted(pre_alloc_result_);
+    }
+    rt_active_goal_.reset();
+  }
+
+  monitored_goal_->runNonRealtime();
+  if (!monitored_goal_->gh_->is_active())
+  {
+    monitored_goal_.reset();
+    return false;
+  }
+  // the active goal waits for the realtime side, a canceled one for the action server
+  return rt_active_goal_.get() != monitored_goal_;
+}
+
+template <const char * HardwareInterface>
+rclcpp_action::CancelResponse MultiJointGripperActionController<HardwareInterface>::cancel_callback(
+  const std::shared_ptr<GoalHandle> goal_handle)
+{
+  RCLCPP_INFO(get_node()->get_logger(), "Got request to cancel goal");
+
+  // Check that cancel request refers to currently active goal (if any)
+  const auto active_goal = rt_active_goal_.get();
+  if (active_goal && active_goal->gh_ == goal_handle)
+  {
+    // Enter hold current position mode
+    set_hold_position();
+
+    RCLCPP_INFO(
+      get_node()->get_logger(), "Canceling active action goal because cancel callback received.");
+
+    // Mark the current goal as canceled
+    auto action_res = std::make_shared<GripperCommandAction::Result>();
+    active_goal->setCanceled(action_res);
+    // Reset current goal
+    rt_active_goal_.reset();
+    // the action server completes the cancel after this callback returned
+    action_monitor_->notify();
+  }
+  return rclcpp_action::CancelResponse::ACCEPT;
+}
+
+template <const char * HardwareInterface>
+void MultiJointGripperActionController<HardwareInterface>::set_hold_position()
+{
+  // Every joint holds its own position
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    command_struct_.positions_[i] = joint_position_state_interfaces_[i].get().get_value();
+  }
+  command_struct_.max_effort_ = params_.max_effort;
+  command_struct_.goal_id_ = 0;
+  write_command();
+}
+
+template <const char * HardwareInterface>
+std::vector<typename MultiJointHardwareInterfaceAdapter<HardwareInterface>::Gains>
+MultiJointGripperActionController<HardwareInterface>::get_gains(const Params & params) const
+{
+  std::vector<typename HwIfaceAdapter::Gains> gains(dof_);
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    const auto & joint_gains = params.gains.joints_map.at(params.joints[i]);
+    gains[i].p = joint_gains.p;
+    gains[i].i = joint_gains.i;
+    gains[i].d = joint_gains.d;
+    gains[i].i_clamp = joint_gains.i_clamp;
+  }
+  return gains;
+}
+
+template <const char * HardwareInterface>
+void MultiJointGripperActionController<HardwareInterface>::write_command()
+{
+  // the buffers hold as many positions as command_struct_, so copying them doesn't allocate
+  command_->write_buffer() = command_struct_;
+  command_->publish();
+}
+
+template <const char * HardwareInterface>
+void MultiJointGripperActionController<HardwareInterface>::check_for_success(
+  const rclcpp::Time & time, std::uint64_t goal_id)
+{
+  if (goal_id != rt_goal_id_)
+  {
+    // first command of a new goal, or holding position
+    rt_goal_id_ = goal_id;
+    rt_goal_completed_ = false;
+    last_movement_time_ = time;
+  }
+  if (goal_id == 0 || rt_goal_completed_)
+  {
+    return;
+  }
+
+  double max_error_position = 0.0;
+  double max_velocity = 0.0;
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    max_error_position = std::max(max_error_position, std::fabs(error_positions_[i]));
+    max_velocity = std::max(max_velocity, std::fabs(error_velocities_[i]));
+  }
+
+  if (max_error_position < params_.goal_tolerance)
+  {
+    complete_goal(goal_id, true, true, false);
+  }
+  else
+  {
+    if (max_velocity > params_.stall_velocity_threshold)
+    {
+      last_movement_time_ = time;
+    }
+    else if ((time - last_movement_time_).seconds() > params_.stall_timeout)
+    {
+      complete_goal(goal_id, params_.allow_stalling, false, true);
+    }
+  }
+}
+
+template <const char * HardwareInterface>
+void MultiJointGripperActionController<HardwareInterface>::complete_goal(
+  std::uint64_t goal_id, bool succeeded, bool reached_goal, bool stalled)
+{
+  double position_sum = 0.0;
+  double effort_sum = 0.0;
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    position_sum += current_positions_[i];
+    effort_sum += computed_commands_[i];
+  }
+
+  GoalCompletion & completion = goal_completion_->write_buffer();
+  completion.goal_id_ = goal_id;
+  completion.succeeded_ = succeeded;
+  completion.reached_goal_ = reached_goal;
+  completion.stalled_ = stalled;
+  completion.position_ = position_sum / static_cast<double>(dof_);
+  completion.effort_ = effort_sum / static_cast<double>(dof_);
+  goal_completion_->publish();
+  rt_goal_completed_ = true;
+  action_monitor_->notify();
+}
+
+template <const char * HardwareInterface>
+controller_interface::CallbackReturn
+MultiJointGripperActionController<HardwareInterface>::on_configure(const rclcpp_lifecycle::State &)
+{
+  const auto logger = get_node()->get_logger();
+  if (!param_listener_)
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Error encountered during init");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  params_ = param_listener_->get_params();
+
+  // Action status checking update rate
+  action_monitor_period_ = rclcpp::Duration::from_seconds(1.0 / params_.action_monitor_rate);
+  RCLCPP_INFO_STREAM(
+    logger, "Action status changes will be monitored at " << params_.action_monitor_rate << "Hz.");
+  action_monitor_ = std::make_unique<controller_realtime_tools::ActionMonitor>(
+    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
+    [this]() { return monitor_goal(); });
+  if (!action_monitor_->set_scheduling(controller_realtime_tools::make_thread_scheduling(
+        params_.non_realtime_threads.priority, params_.non_realtime_threads.cpu_affinity)))
+  {
+    RCLCPP_WARN(logger, "Could not set the scheduling of the action monitor thread.");
+  }
+
+  // Controlled joints
+  if (params_.joints.empty())
+  {
+    RCLCPP_ERROR(logger, "'joints' parameter is empty.");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  dof_ = params_.joints.size();
+
+  command_struct_.positions_.assign(dof_, 0.0);
+  current_positions_.assign(dof_, 0.0);
+  error_positions_.assign(dof_, 0.0);
+  error_velocities_.assign(dof_, 0.0);
+  computed_commands_.assign(dof_, 0.0);
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+template <const char * HardwareInterface>
+controller_interface::CallbackReturn
+MultiJointGripperActionController<HardwareInterface>::on_activate(const rclcpp_lifecycle::State &)
+{
+  if (!controller_interface::get_ordered_interfaces(
+        command_interfaces_, params_.joints, hardware_interface::HW_IF_POSITION,
+        joint_position_command_interfaces_))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Expected %zu position command interfaces, got %zu.", dof_,
+      joint_position_command_interfaces_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  if (!controller_interface::get_ordered_interfaces(
+        state_interfaces_, params_.joints, hardware_interface::HW_IF_POSITION,
+        joint_position_state_interfaces_))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Expected %zu position state interfaces, got %zu.", dof_,
+      joint_position_state_interfaces_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  if (!controller_interface::get_ordered_interfaces(
+        state_interfaces_, params_.joints, hardware_interface::HW_IF_VELOCITY,
+        joint_velocity_state_interfaces_))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Expected %zu velocity state interfaces, got %zu.", dof_,
+      joint_velocity_state_interfaces_.size());
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  // Hardware interface adapter
+  if (!hw_iface_adapter_.init(joint_position_command_interfaces_, get_gains(params_)))
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Failed to initialize the hardware interface adapter");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  hw_iface_adapter_.starting();
+
+  // Command - non RT version
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    command_struct_.positions_[i] = joint_position_state_interfaces_[i].get().get_value();
+  }
+  command_struct_.max_effort_ = params_.max_effort;
+  command_struct_.goal_id_ = 0;
+  command_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<Commands>>(command_struct_);
+  {
+    // the monitor may still read the completions of the previous activation
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    goal_completion_ =
+      std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<GoalCompletion>>(
+        GoalCompletion());
+  }
+  rt_goal_id_ = 0;
+  rt_goal_completed_ = false;
+  std::fill(computed_commands_.begin(), computed_commands_.end(), 0.0);
+
+  // Result
+  pre_alloc_result_ = std::make_shared<control_msgs::action::GripperCommand::Result>();
+  pre_alloc_result_->position = 0.0;
+  for (const double position : command_struct_.positions_)
+  {
+    pre_alloc_result_->position += position / static_cast<double>(dof_);
+  }
+  pre_alloc_result_->reached_goal = false;
+  pre_alloc_result_->stalled = false;
+
+  // Action interface
+  action_server_ = rclcpp_action::create_server<control_msgs::action::GripperCommand>(
+    get_node(), "~/gripper_cmd",
+    std::bind(
+      &MultiJointGripperActionController::goal_callback, this, std::placeholders::_1,
+      std::placeholders::_2),
+    std::bind(&MultiJointGripperActionController::cancel_callback, this, std::placeholders::_1),
+    std::bind(&MultiJointGripperActionController::accepted_callback, this, std::placeholders::_1));
+
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+template <const char * HardwareInterface>
+controller_interface::CallbackReturn
+MultiJointGripperActionController<HardwareInterface>::on_deactivate(const rclcpp_lifecycle::State &)
+{
+  joint_position_command_interfaces_.clear();
+  joint_position_state_interfaces_.clear();
+  joint_velocity_state_interfaces_.clear();
+  release_interfaces();
+  return controller_interface::CallbackReturn::SUCCESS;
+}
+
+template <const char * HardwareInterface>
+controller_interface::InterfaceConfiguration
+MultiJointGripperActionController<HardwareInterface>::command_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & joint : params_.joints)
+  {
+    config.names.push_back(joint + "/" + hardware_interface::HW_IF_POSITION);
+  }
+  return config;
+}
+
+template <const char * HardwareInterface>
+controller_interface::InterfaceConfiguration
+MultiJointGripperActionController<HardwareInterface>::state_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration config;
+  config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & joint : params_.joints)
+  {
+    config.names.push_back(joint + "/" + hardware_interface::HW_IF_POSITION);
+    config.names.push_back(joint + "/" + hardware_interface::HW_IF_VELOCITY);
+  }
+  return config;
+}
+
+template <const char * HardwareInterface>
+MultiJointGripperActionController<HardwareInterface>::MultiJointGripperActionController()
+: controller_interface::ControllerInterface(),
+  action_monitor_period_(rclcpp::Duration::from_seconds(0))
+{
+}
+
+}  // namespace gripper_action_controller
+
+#endif  // GRIPPER_CONTROLLERS__MULTI_JOINT_GRIPPER_ACTION_CONTROLLER_IMPL_HPP_
@@ -0,0 +1,199 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GRIPPER_CONTROLLERS__MULTI_JOINT_HARDWARE_INTERFACE_ADAPTER_HPP_
+#define GRIPPER_CONTROLLERS__MULTI_JOINT_HARDWARE_INTERFACE_ADAPTER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "controller_realtime_tools/batched_pid.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/duration.hpp"
+
+/**
+ * \brief Helper class to integrate the MultiJointGripperActionController with different
+ * hardware interfaces, for all joints of the gripper at once.
+ *
+ * The vectors of init(), set_gains() and updateCommand() hold a value per joint, in the order of
+ * the joint handles given to init(), so no call after init() allocates.
+ */
+template <const char * HardwareInterface>
+class MultiJointHardwareInterfaceAdapter
+{
+public:
+  using JointHandles =
+    std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>;
+  using Gains = controller_realtime_tools::BatchedPid::Gains;
+
+  bool init(const JointHandles & /* joint_handles */, const std::vector<Gains> & /* gains */)
+  {
+    return false;
+  }
+
+  void set_gains(const std::vector<Gains> & /* gains */) {}
+
+  void starting() {}
+
+  void updateCommand(
+    const std::vector<double> & /* desired_positions */,
+    const std::vector<double> & /* error_positions */,
+    const std::vector<double> & /* error_velocities */, double /* max_allowed_effort */,
+    const rclcpp::Duration & /* period */, std::vector<double> & /* efforts */)
+  {
+  }
+};
+
+/**
+ * \brief Adapter for position-controlled hardware interfaces. Forwards the desired positions as
+ * commands.
+ */
+template <>
+class MultiJointHardwareInterfaceAdapter<hardware_interface::HW_IF_POSITION>
+{
+public:
+  using JointHandles =
+    std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>;
+  using Gains = controller_realtime_tools::BatchedPid::Gains;
+
+  bool init(const JointHandles & joint_handles, const std::vector<Gains> & /* gains */)
+  {
+    joint_handles_ = joint_handles;
+    return true;
+  }
+
+  void set_gains(const std::vector<Gains> & /* gains */) {}
+
+  void starting() {}
+
+  void updateCommand(
+    const std::vector<double> & desired_positions,
+    const std::vector<double> & /* error_positions */,
+    const std::vector<double> & /* error_velocities */, double max_allowed_effort,
+    const rclcpp::Duration & /* period */, std::vector<double> & efforts)
+  {
+    for (size_t i = 0; i < joint_handles_.size(); ++i)
+    {
+      joint_handles_[i].get().set_value(desired_positions[i]);
+      efforts[i] = max_allowed_effort;
+    }
+  }
+
+private:
+  JointHandles joint_handles_;
+};
+
+/**
+ * \brief Adapter for effort-controlled hardware interfaces. Maps the position and velocity errors
+ * of every joint to its effort command through a position PID loop, evaluated for all joints
+ * together.
+ *
+ * The gains can be replaced while the controller runs: set_gains() publishes them from the
+ * non-realtime side, and the next updateCommand() applies them without a lock, keeping the
+ * integral states.
+ */
+template <>
+class MultiJointHardwareInterfaceAdapter<hardware_interface::HW_IF_EFFORT>
+{
+public:
+  using JointHandles =
+    std::vector<std::reference_wrapper<hardware_interface::LoanedCommandInterface>>;
+  using Gains = controller_realtime_tools::BatchedPid::Gains;
+
+  bool init(const JointHandles & joint_handles, const std::vector<Gains> & gains)
+  {
+    if (gains.size() != joint_handles.size())
+    {
+      return false;
+    }
+    joint_handles_ = joint_handles;
+    pids_.configure(gains);
+    gains_ = std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<GainsSnapshot>>(
+      GainsSnapshot{0, gains});
+    gains_version_ = 0;
+    applied_gains_version_ = 0;
+    return true;
+  }
+
+  /// Publish new gains to updateCommand(), non-realtime. Ignored unless there is one per joint.
+  void set_gains(const std::vector<Gains> & gains)
+  {
+    if (!gains_ || gains.size() != joint_handles_.size())
+    {
+      return;
+    }
+    GainsSnapshot & snapshot = gains_->write_buffer();
+    snapshot.version = ++gains_version_;
+    snapshot.gains = gains;
+    gains_->publish();
+  }
+
+  void starting()
+  {
+    // Reset PIDs, zero effort commands
+    pids_.reset();
+    for (auto & joint_handle : joint_handles_)
+    {
+      joint_handle.get().set_value(0.0);
+    }
+  }
+
+  void updateCommand(
+    const std::vector<double> & /* desired_positions */,
+    const std::vector<double> & error_positions, const std::vector<double> & error_velocities,
+    double max_allowed_effort, const rclcpp::Duration & period, std::vector<double> & efforts)
+  {
+    const GainsSnapshot & snapshot = gains_->read();
+    if (snapshot.version != applied_gains_version_)
+    {
+      pids_.set_gains(snapshot.gains);
+      applied_gains_version_ = snapshot.version;
+    }
+
+    pids_.compute_commands(
+      error_positions.data(), error_velocities.data(),
+      static_cast<double>(period.nanoseconds()) / 1e9, efforts.data());
+    // Limit the efforts of all joints together, then send them
+    const double max_effort = std::fabs(max_allowed_effort);
+    for (size_t i = 0; i < joint_handles_.size(); ++i)
+    {
+      efforts[i] = std::min(max_effort, std::max(-max_effort, efforts[i]));
+    }
+    for (size_t i = 0; i < joint_handles_.size(); ++i)
+    {
+      joint_handles_[i].get().set_value(efforts[i]);
+    }
+  }
+
+private:
+  struct GainsSnapshot
+  {
+    std::uint64_t version;
+    std::vector<Gains> gains;
+  };
+
+  controller_realtime_tools::BatchedPid pids_;
+  JointHandles joint_handles_;
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<GainsSnapshot>> gains_;
+  std::uint64_t gains_version_ = 0;          ///< Version of the last published gains, non-realtime.
+  std::uint64_t applied_gains_version_ = 0;  ///< Version of the gains of pids_, realtime.
+};
+
+#endif  // GRIPPER_CONTROLLERS__MULTI_JOINT_HARDWARE_INTERFACE_ADAPTER_HPP_
@@ -16,6 +16,7 @@
 
 // Project
 #include <gripper_controllers/gripper_action_controller.hpp>
+#include <gripper_controllers/multi_joint_gripper_action_controller.hpp>
 #include <hardware_interface/types/hardware_interface_type_values.hpp>
 namespace position_controllers
 {
@@ -25,6 +26,13 @@ namespace position_controllers
  */
 using GripperActionController =
   gripper_action_controller::GripperActionController<hardware_interface::HW_IF_POSITION>;
+
+/**
+ * \brief Gripper action controller that sends
+ * commands to the \b position interfaces of several joints.
+ */
+using MultiJointGripperActionController =
+  gripper_action_controller::MultiJointGripperActionController<hardware_interface::HW_IF_POSITION>;
 }  // namespace position_controllers
 
 namespace effort_controllers
@@ -35,11 +43,23 @@ namespace effort_controllers
  */
 using GripperActionController =
   gripper_action_controller::GripperActionController<hardware_interface::HW_IF_EFFORT>;
+
+/**
+ * \brief Gripper action controller that sends
+ * commands to the \b effort interfaces of several joints.
+ */
+using MultiJointGripperActionController =
+  gripper_action_controller::MultiJointGripperActionController<hardware_interface::HW_IF_EFFORT>;
 }  // namespace effort_controllers
 
 #include "pluginlib/class_list_macros.hpp"
 
 PLUGINLIB_EXPORT_CLASS(
-  position_controllers::GripperActionController, controller_interface::ControllerInterface)
+  position_controllers::GripperActionController, controller_interface::ChainableControllerInterface)
+PLUGINLIB_EXPORT_CLASS(
+  effort_controllers::GripperActionController, controller_interface::ChainableControllerInterface)
+PLUGINLIB_EXPORT_CLASS(
+  position_controllers::MultiJointGripperActionController,
+  controller_interface::ControllerInterface)
 PLUGINLIB_EXPORT_CLASS(
-  effort_controllers::GripperActionController, controller_interface::ControllerInterface)
+  effort_controllers::MultiJointGripperActionController, controller_interface::ControllerInterface)
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -152,3 +153,59 @@ TEST_F(GripperControllerTest, ActivateDeactivateActivateSuccess)
     controller_->on_activate(rclcpp_lifecycle::State()),
     controller_interface::CallbackReturn::SUCCESS);
 }
+
+TEST_F(GripperControllerTest, ChainedModeReferencesTest)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joint", "joint1"});
+  controller_->get_node()->set_parameter({"max_effort", 10.0});
+
+  auto node_state = controller_->get_node()->configure();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  auto reference_interfaces = controller_->export_reference_interfaces();
+  ASSERT_EQ(reference_interfaces.size(), 2u);
+  EXPECT_EQ(reference_interfaces[0].get_name(), "gripper_controller/joint1/position");
+  EXPECT_EQ(reference_interfaces[1].get_name(), "gripper_controller/joint1/max_effort");
+
+  // without chaining, the gripper holds its position on activation
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(joint_commands_[0], joint_states_[0]);
+  EXPECT_EQ(controller_->computed_command_, 10.0);
+
+  node_state = controller_->get_node()->deactivate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE);
+  ASSERT_TRUE(controller_->set_chained_mode(true));
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(joint_1_pos_cmd_);
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(joint_1_pos_state_);
+  state_ifs.emplace_back(joint_1_vel_state_);
+  controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+  node_state = controller_->get_node()->activate();
+  ASSERT_EQ(node_state.id(), lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+  ASSERT_TRUE(controller_->is_in_chained_mode());
+
+  // the references of the preceding controller are commanded on every update
+  reference_interfaces[0].set_value(0.5);
+  reference_interfaces[1].set_value(2.0);
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(joint_commands_[0], 0.5);
+  EXPECT_EQ(controller_->computed_command_, 2.0);
+
+  // missing references hold the position and use the configured max effort
+  reference_interfaces[0].set_value(std::numeric_limits<double>::quiet_NaN());
+  reference_interfaces[1].set_value(std::numeric_limits<double>::quiet_NaN());
+  joint_commands_[0] = 0.0;
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(joint_commands_[0], 0.5);
+  EXPECT_EQ(controller_->computed_command_, 10.0);
+}
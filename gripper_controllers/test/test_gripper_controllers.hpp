@@ -38,6 +38,7 @@ class FriendGripperController
 : public gripper_action_controller::GripperActionController<HW_IF_POSITION>
 {
   FRIEND_TEST(GripperControllerTest, CommandSuccessTest);
+  FRIEND_TEST(GripperControllerTest, ChainedModeReferencesTest);
 };
 
 class GripperControllerTest : public ::testing::Test
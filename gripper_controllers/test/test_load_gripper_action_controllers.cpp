@@ -40,6 +40,16 @@ TEST(TestLoadGripperActionControllers, load_controller)
     cm.load_controller(
       "test_gripper_action_effort_controller", "effort_controllers/GripperActionController"),
     nullptr);
+  ASSERT_NE(
+    cm.load_controller(
+      "test_multi_joint_gripper_action_position_controller",
+      "position_controllers/MultiJointGripperActionController"),
+    nullptr);
+  ASSERT_NE(
+    cm.load_controller(
+      "test_multi_joint_gripper_action_effort_controller",
+      "effort_controllers/MultiJointGripperActionController"),
+    nullptr);
 
   rclcpp::shutdown();
 }
@@ -0,0 +1,124 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "test_multi_joint_gripper_controllers.hpp"
+
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+
+using hardware_interface::LoanedCommandInterface;
+using hardware_interface::LoanedStateInterface;
+
+void MultiJointGripperControllerTest::SetUpTestCase() { rclcpp::init(0, nullptr); }
+
+void MultiJointGripperControllerTest::TearDownTestCase() { rclcpp::shutdown(); }
+
+void MultiJointGripperControllerTest::SetUp()
+{
+  // initialize controller
+  controller_ = std::make_unique<FriendMultiJointGripperController>();
+}
+
+void MultiJointGripperControllerTest::TearDown() { controller_.reset(nullptr); }
+
+void MultiJointGripperControllerTest::SetUpController()
+{
+  const auto result = controller_->init("multi_joint_gripper_controller");
+  ASSERT_EQ(result, controller_interface::return_type::OK);
+
+  std::vector<LoanedCommandInterface> command_ifs;
+  command_ifs.emplace_back(joint_1_pos_cmd_);
+  command_ifs.emplace_back(joint_2_pos_cmd_);
+  std::vector<LoanedStateInterface> state_ifs;
+  state_ifs.emplace_back(joint_1_pos_state_);
+  state_ifs.emplace_back(joint_1_vel_state_);
+  state_ifs.emplace_back(joint_2_pos_state_);
+  state_ifs.emplace_back(joint_2_vel_state_);
+  controller_->assign_interfaces(std::move(command_ifs), std::move(state_ifs));
+}
+
+TEST_F(MultiJointGripperControllerTest, ParametersNotSet)
+{
+  SetUpController();
+
+  // configure failed, 'joints' parameter not set
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiJointGripperControllerTest, ConfigureParamsSuccess)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+
+  // configure successful
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  const auto state_interfaces = controller_->state_interface_configuration();
+  EXPECT_THAT(
+    state_interfaces.names,
+    testing::ElementsAre(
+      "finger1/position", "finger1/velocity", "finger2/position", "finger2/velocity"));
+}
+
+TEST_F(MultiJointGripperControllerTest, ActivateWithWrongJointsNamesFails)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter(
+    {"joints", std::vector<std::string>{"finger1", "unicorn_joint"}});
+
+  // activate failed, 'unicorn_joint' is not a valid joint name for the hardware
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::ERROR);
+}
+
+TEST_F(MultiJointGripperControllerTest, UpdateHoldsPositionOfEveryJoint)
+{
+  SetUpController();
+
+  controller_->get_node()->set_parameter({"joints", joint_names_});
+
+  ASSERT_EQ(
+    controller_->on_configure(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+  ASSERT_EQ(
+    controller_->on_activate(rclcpp_lifecycle::State()),
+    controller_interface::CallbackReturn::SUCCESS);
+
+  // without a goal, every joint holds the position it had at activation
+  joint_states_[0] = 1.5;
+  ASSERT_EQ(
+    controller_->update(rclcpp::Time(0, 0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(joint_commands_[0], 1.1);
+  EXPECT_EQ(joint_commands_[1], 1.2);
+  EXPECT_EQ(controller_->command_struct_.goal_id_, 0u);
+}
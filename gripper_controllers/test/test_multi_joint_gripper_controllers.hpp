@@ -0,0 +1,72 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TEST_MULTI_JOINT_GRIPPER_CONTROLLERS_HPP_
+#define TEST_MULTI_JOINT_GRIPPER_CONTROLLERS_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "gripper_controllers/multi_joint_gripper_action_controller.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+
+using hardware_interface::CommandInterface;
+using hardware_interface::HW_IF_POSITION;
+using hardware_interface::HW_IF_VELOCITY;
+using hardware_interface::StateInterface;
+
+namespace
+{
+
+// subclassing and friending so we can access member variables
+class FriendMultiJointGripperController
+: public gripper_action_controller::MultiJointGripperActionController<HW_IF_POSITION>
+{
+  FRIEND_TEST(MultiJointGripperControllerTest, UpdateHoldsPositionOfEveryJoint);
+};
+
+class MultiJointGripperControllerTest : public ::testing::Test
+{
+public:
+  static void SetUpTestCase();
+  static void TearDownTestCase();
+
+  void SetUp();
+  void TearDown();
+
+  void SetUpController();
+
+protected:
+  std::unique_ptr<FriendMultiJointGripperController> controller_;
+
+  // dummy joint state values used for tests
+  const std::vector<std::string> joint_names_ = {"finger1", "finger2"};
+  std::vector<double> joint_states_ = {1.1, 2.1, 1.2, 2.2};
+  std::vector<double> joint_commands_ = {3.1, 3.2};
+
+  StateInterface joint_1_pos_state_{joint_names_[0], HW_IF_POSITION, &joint_states_[0]};
+  StateInterface joint_1_vel_state_{joint_names_[0], HW_IF_VELOCITY, &joint_states_[1]};
+  StateInterface joint_2_pos_state_{joint_names_[1], HW_IF_POSITION, &joint_states_[2]};
+  StateInterface joint_2_vel_state_{joint_names_[1], HW_IF_VELOCITY, &joint_states_[3]};
+  CommandInterface joint_1_pos_cmd_{joint_names_[0], HW_IF_POSITION, &joint_commands_[0]};
+  CommandInterface joint_2_pos_cmd_{joint_names_[1], HW_IF_POSITION, &joint_commands_[1]};
+};
+
+}  // anonymous namespace
+
+#endif  // TEST_MULTI_JOINT_GRIPPER_CONTROLLERS_HPP_
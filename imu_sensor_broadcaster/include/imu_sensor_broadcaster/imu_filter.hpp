@@ -0,0 +1,77 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IMU_SENSOR_BROADCASTER__IMU_FILTER_HPP_
+#define IMU_SENSOR_BROADCASTER__IMU_FILTER_HPP_
+
+#include <array>
+
+namespace imu_sensor_broadcaster
+{
+/**
+ * \brief Preprocessing of IMU readings: static bias subtraction, first-order low-pass of the
+ * angular velocity and linear acceleration, and optionally a complementary orientation filter.
+ *
+ * The orientation filter integrates the angular velocity and corrects roll and pitch towards the
+ * gravity measured by the accelerometer, while the norm of the acceleration is within 10 % of
+ * gravity. The yaw is only integrated. It starts from the tilt of the first accelerometer reading.
+ *
+ * Nothing is allocated, so filter() is realtime-safe. Not thread-safe.
+ */
+class ImuFilter
+{
+public:
+  using Vector3 = std::array<double, 3>;
+  // x, y, z, w, as in geometry_msgs::msg::Quaternion
+  using Quaternion = std::array<double, 4>;
+
+  /**
+   * \param cutoff_frequency of the low-pass in Hz, 0 to disable it.
+   * \param estimate_orientation Flag to replace the orientation of the sensor by the estimate.
+   * \param complementary_gain Fraction of the tilt error corrected per filtered reading, in [0, 1].
+   */
+  void configure(
+    const Vector3 & angular_velocity_bias, const Vector3 & linear_acceleration_bias,
+    double cutoff_frequency, bool estimate_orientation, double complementary_gain);
+
+  /// Forget the previous readings, the next one initializes the low-pass and the orientation.
+  void reset();
+
+  /// Filter a reading in place, \p period is the time since the previous one in seconds.
+  void filter(
+    double period, Quaternion & orientation, Vector3 & angular_velocity,
+    Vector3 & linear_acceleration);
+
+private:
+  void initialize_orientation(const Vector3 & linear_acceleration);
+  void integrate_angular_velocity(const Vector3 & angular_velocity, double period);
+  void correct_tilt(const Vector3 & linear_acceleration);
+  /// Rotate orientation_ by \p angle about \p axis of unit length, in the sensor frame.
+  void rotate(const Vector3 & axis, double angle);
+
+  Vector3 angular_velocity_bias_{};
+  Vector3 linear_acceleration_bias_{};
+  double cutoff_frequency_ = 0.0;
+  bool estimate_orientation_ = false;
+  double complementary_gain_ = 0.0;
+
+  bool initialized_ = false;
+  Vector3 angular_velocity_{};
+  Vector3 linear_acceleration_{};
+  Quaternion orientation_{0.0, 0.0, 0.0, 1.0};
+};
+
+}  // namespace imu_sensor_broadcaster
+
+#endif  // IMU_SENSOR_BROADCASTER__IMU_FILTER_HPP_
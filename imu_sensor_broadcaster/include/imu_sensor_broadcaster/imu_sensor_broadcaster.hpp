@@ -19,22 +19,51 @@
 #ifndef IMU_SENSOR_BROADCASTER__IMU_SENSOR_BROADCASTER_HPP_
 #define IMU_SENSOR_BROADCASTER__IMU_SENSOR_BROADCASTER_HPP_
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/new_sample_detector.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+#include "imu_sensor_broadcaster/imu_filter.hpp"
 #include "imu_sensor_broadcaster/visibility_control.h"
 // auto-generated by generate_parameter_library
 #include "imu_sensor_broadcaster_parameters.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_publisher.h"
 #include "semantic_components/imu_sensor.hpp"
 #include "sensor_msgs/msg/imu.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
 
 namespace imu_sensor_broadcaster
 {
+/**
+ * \brief Broadcaster of the readings of an IMU sensor.
+ *
+ * \param sensor_name Prefix of the state interfaces of the sensor.
+ * \param frame_id Frame of the published values.
+ * \param decimation Number of updates per Imu message.
+ * \param imu_batch.enable Flag to publish every sample in batches as well.
+ * \param imu_batch.batch_size Number of samples published in one batch.
+ * \param filter.angular_velocity_bias Static bias subtracted from the angular velocity.
+ * \param filter.linear_acceleration_bias Static bias subtracted from the linear acceleration.
+ * \param filter.cutoff_frequency Cutoff frequency of the low-pass, 0 to disable it.
+ * \param filter.estimate_orientation Flag to publish the orientation of a complementary filter.
+ * \param filter.complementary_gain Weight of the measured gravity in the orientation estimate.
+ *
+ * All published readings are preprocessed by an ImuFilter, which passes them through with the
+ * default parameters.
+ *
+ * Publishes to:
+ * - \b imu (sensor_msgs::msg::Imu): Reading of every decimation-th update.
+ * - \b imu_batch (std_msgs::msg::Float64MultiArray): Samples of batch_size updates, each one with
+ * the sequence number and stamp of the update followed by the orientation, angular velocity and
+ * linear acceleration.
+ */
 class IMUSensorBroadcaster : public controller_interface::ControllerInterface
 {
 public:
@@ -67,10 +96,42 @@ protected:
   Params params_;
 
   std::unique_ptr<semantic_components::IMUSensor> imu_sensor_;
-
-  using StatePublisher = realtime_tools::RealtimePublisher<sensor_msgs::msg::Imu>;
+  ImuFilter filter_;
+  //  Filtered reading of the current update
+  ImuFilter::Quaternion orientation_{};
+  ImuFilter::Vector3 angular_velocity_{};
+  ImuFilter::Vector3 linear_acceleration_{};
+  //  Raw reading of the current update, the key of new_sample_detector_ without a sequence
+  std::array<double, 10> raw_reading_{};
+  controller_realtime_tools::NewSampleDetector new_sample_detector_;
+
+  using StatePublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    sensor_msgs::msg::Imu, rclcpp::Publisher<sensor_msgs::msg::Imu>>;
   rclcpp::Publisher<sensor_msgs::msg::Imu>::SharedPtr sensor_state_publisher_;
   std::unique_ptr<StatePublisher> realtime_publisher_;
+  //  Written by update() and swapped into realtime_publisher_
+  sensor_msgs::msg::Imu imu_msg_;
+  //  Updates since the last Imu message
+  int64_t decimation_counter_ = 0;
+
+  using BatchPublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    std_msgs::msg::Float64MultiArray, rclcpp::Publisher<std_msgs::msg::Float64MultiArray>>;
+  rclcpp::Publisher<std_msgs::msg::Float64MultiArray>::SharedPtr batch_publisher_;
+  std::unique_ptr<BatchPublisher> realtime_batch_publisher_;
+  //  Written by update() and swapped into realtime_batch_publisher_
+  std_msgs::msg::Float64MultiArray batch_msg_;
+  //  Number of samples since activation, gaps in the stream show dropped samples
+  uint64_t batch_sequence_ = 0;
+  //  Ring buffer of the samples, filled by update() and published in batches
+  std::vector<double> batch_samples_;
+  //  Sequence number of the last published sample
+  uint64_t batch_published_sequence_ = 0;
+
+  //  Whether the reading of the current update is a new sample, before filtering it
+  bool is_new_sample();
+  void init_batch_msg();
+  void reset_batch_samples();
+  void add_batch_sample(const rclcpp::Time & time);
 };
 
 }  // namespace imu_sensor_broadcaster
@@ -0,0 +1,88 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IMU_SENSOR_BROADCASTER__MULTI_IMU_SENSOR_BROADCASTER_HPP_
+#define IMU_SENSOR_BROADCASTER__MULTI_IMU_SENSOR_BROADCASTER_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+#include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+#include "imu_sensor_broadcaster/visibility_control.h"
+// auto-generated by generate_parameter_library
+#include "multi_imu_sensor_broadcaster_parameters.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+#include "semantic_components/imu_sensor.hpp"
+
+namespace imu_sensor_broadcaster
+{
+/**
+ * \brief Broadcaster of the readings of several IMU sensors in one message, e.g. of a legged
+ * robot, instead of one IMUSensorBroadcaster per sensor.
+ *
+ * \param sensor_names Names of the sensors, used as prefixes of their interfaces.
+ *
+ * Publishes to:
+ * - \b imus (control_msgs::msg::DynamicJointState): Readings of all sensors on every update, an
+ * entry per sensor in the order of sensor_names, with the values orientation.x, ...,
+ * linear_acceleration.z.
+ */
+class MultiIMUSensorBroadcaster : public controller_interface::ControllerInterface
+{
+public:
+  IMU_SENSOR_BROADCASTER_PUBLIC
+  controller_interface::InterfaceConfiguration command_interface_configuration() const override;
+
+  IMU_SENSOR_BROADCASTER_PUBLIC
+  controller_interface::InterfaceConfiguration state_interface_configuration() const override;
+
+  IMU_SENSOR_BROADCASTER_PUBLIC controller_interface::CallbackReturn on_init() override;
+
+  IMU_SENSOR_BROADCASTER_PUBLIC
+  controller_interface::CallbackReturn on_configure(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  IMU_SENSOR_BROADCASTER_PUBLIC
+  controller_interface::CallbackReturn on_activate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  IMU_SENSOR_BROADCASTER_PUBLIC
+  controller_interface::CallbackReturn on_deactivate(
+    const rclcpp_lifecycle::State & previous_state) override;
+
+  IMU_SENSOR_BROADCASTER_PUBLIC
+  controller_interface::return_type update(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+protected:
+  std::shared_ptr<multi_imu_sensor_broadcaster::ParamListener> param_listener_;
+  multi_imu_sensor_broadcaster::Params params_;
+
+  std::vector<std::unique_ptr<semantic_components::IMUSensor>> imu_sensors_;
+
+  using StatePublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    control_msgs::msg::DynamicJointState, rclcpp::Publisher<control_msgs::msg::DynamicJointState>>;
+  rclcpp::Publisher<control_msgs::msg::DynamicJointState>::SharedPtr sensor_state_publisher_;
+  std::unique_ptr<StatePublisher> realtime_publisher_;
+  //  Written by update() and swapped into realtime_publisher_
+  control_msgs::msg::DynamicJointState imus_msg_;
+};
+
+}  // namespace imu_sensor_broadcaster
+
+#endif  // IMU_SENSOR_BROADCASTER__MULTI_IMU_SENSOR_BROADCASTER_HPP_
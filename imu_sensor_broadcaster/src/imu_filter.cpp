@@ -0,0 +1,192 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "imu_sensor_broadcaster/imu_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace imu_sensor_broadcaster
+{
+namespace
+{
+constexpr double kGravity = 9.80665;
+// the tilt is only corrected while the sensor doesn't accelerate much
+constexpr double kGravityTolerance = 0.1;
+
+double norm(const ImuFilter::Vector3 & v)
+{
+  return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+ImuFilter::Vector3 cross(const ImuFilter::Vector3 & a, const ImuFilter::Vector3 & b)
+{
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+}  // namespace
+
+void ImuFilter::configure(
+  const Vector3 & angular_velocity_bias, const Vector3 & linear_acceleration_bias,
+  double cutoff_frequency, bool estimate_orientation, double complementary_gain)
+{
+  angular_velocity_bias_ = angular_velocity_bias;
+  linear_acceleration_bias_ = linear_acceleration_bias;
+  cutoff_frequency_ = std::max(cutoff_frequency, 0.0);
+  estimate_orientation_ = estimate_orientation;
+  complementary_gain_ = std::clamp(complementary_gain, 0.0, 1.0);
+  reset();
+}
+
+void ImuFilter::reset()
+{
+  initialized_ = false;
+  angular_velocity_.fill(0.0);
+  linear_acceleration_.fill(0.0);
+  orientation_ = {0.0, 0.0, 0.0, 1.0};
+}
+
+void ImuFilter::filter(
+  double period, Quaternion & orientation, Vector3 & angular_velocity,
+  Vector3 & linear_acceleration)
+{
+  for (size_t i = 0; i < 3; ++i)
+  {
+    angular_velocity[i] -= angular_velocity_bias_[i];
+    linear_acceleration[i] -= linear_acceleration_bias_[i];
+  }
+
+  if (!initialized_)
+  {
+    angular_velocity_ = angular_velocity;
+    linear_acceleration_ = linear_acceleration;
+    initialize_orientation(linear_acceleration);
+    initialized_ = true;
+  }
+  else
+  {
+    // exact discretization of a first-order low-pass, for any period
+    double alpha = 1.0;
+    if (cutoff_frequency_ > 0.0)
+    {
+      alpha = 1.0 - std::exp(-2.0 * M_PI * cutoff_frequency_ * std::max(period, 0.0));
+    }
+    for (size_t i = 0; i < 3; ++i)
+    {
+      angular_velocity_[i] += alpha * (angular_velocity[i] - angular_velocity_[i]);
+      linear_acceleration_[i] += alpha * (linear_acceleration[i] - linear_acceleration_[i]);
+    }
+    if (estimate_orientation_ && period > 0.0)
+    {
+      // the unfiltered angular velocity, the low-pass would delay the orientation
+      integrate_angular_velocity(angular_velocity, period);
+      correct_tilt(linear_acceleration_);
+    }
+  }
+
+  angular_velocity = angular_velocity_;
+  linear_acceleration = linear_acceleration_;
+  if (estimate_orientation_)
+  {
+    orientation = orientation_;
+  }
+}
+
+void ImuFilter::initialize_orientation(const Vector3 & linear_acceleration)
+{
+  orientation_ = {0.0, 0.0, 0.0, 1.0};
+  const double acceleration = norm(linear_acceleration);
+  if (acceleration <= 0.0)
+  {
+    return;
+  }
+  // the orientation rotating the measured gravity onto the z axis
+  const Vector3 up{0.0, 0.0, 1.0};
+  const Vector3 gravity{
+    linear_acceleration[0] / acceleration, linear_acceleration[1] / acceleration,
+    linear_acceleration[2] / acceleration};
+  const Vector3 axis = cross(gravity, up);
+  const double sin_angle = norm(axis);
+  const double angle = std::atan2(sin_angle, gravity[2]);
+  if (sin_angle > 1e-9)
+  {
+    rotate({axis[0] / sin_angle, axis[1] / sin_angle, axis[2] / sin_angle}, angle);
+  }
+  else if (gravity[2] < 0.0)
+  {
+    // upside down, any horizontal axis
+    rotate({1.0, 0.0, 0.0}, M_PI);
+  }
+}
+
+void ImuFilter::integrate_angular_velocity(const Vector3 & angular_velocity, double period)
+{
+  const double rate = norm(angular_velocity);
+  if (rate <= 0.0)
+  {
+    return;
+  }
+  rotate(
+    {angular_velocity[0] / rate, angular_velocity[1] / rate, angular_velocity[2] / rate},
+    rate * period);
+}
+
+void ImuFilter::correct_tilt(const Vector3 & linear_acceleration)
+{
+  const double acceleration = norm(linear_acceleration);
+  if (std::abs(acceleration - kGravity) > kGravityTolerance * kGravity)
+  {
+    return;
+  }
+  // the z axis of the world in the sensor frame, which the accelerometer measures at rest
+  const auto & q = orientation_;
+  const Vector3 up{
+    2.0 * (q[0] * q[2] - q[3] * q[1]), 2.0 * (q[1] * q[2] + q[3] * q[0]),
+    1.0 - 2.0 * (q[0] * q[0] + q[1] * q[1])};
+  const Vector3 gravity{
+    linear_acceleration[0] / acceleration, linear_acceleration[1] / acceleration,
+    linear_acceleration[2] / acceleration};
+  // rotating the sensor frame about gravity x up turns the estimated up towards the measured one
+  const Vector3 axis = cross(gravity, up);
+  const double sin_angle = norm(axis);
+  if (sin_angle <= 1e-9)
+  {
+    return;
+  }
+  const double angle =
+    std::atan2(sin_angle, up[0] * gravity[0] + up[1] * gravity[1] + up[2] * gravity[2]);
+  rotate(
+    {axis[0] / sin_angle, axis[1] / sin_angle, axis[2] / sin_angle}, complementary_gain_ * angle);
+}
+
+void ImuFilter::rotate(const Vector3 & axis, double angle)
+{
+  const double s = std::sin(0.5 * angle);
+  const Quaternion r{axis[0] * s, axis[1] * s, axis[2] * s, std::cos(0.5 * angle)};
+  const auto q = orientation_;
+  orientation_ = {
+    q[3] * r[0] + q[0] * r[3] + q[1] * r[2] - q[2] * r[1],
+    q[3] * r[1] - q[0] * r[2] + q[1] * r[3] + q[2] * r[0],
+    q[3] * r[2] + q[0] * r[1] - q[1] * r[0] + q[2] * r[3],
+    q[3] * r[3] - q[0] * r[0] - q[1] * r[1] - q[2] * r[2]};
+  // normalize, so the rounding errors of the integration don't accumulate
+  const double length = std::sqrt(
+    orientation_[0] * orientation_[0] + orientation_[1] * orientation_[1] +
+    orientation_[2] * orientation_[2] + orientation_[3] * orientation_[3]);
+  for (auto & value : orientation_)
+  {
+    value /= length;
+  }
+}
+
+}  // namespace imu_sensor_broadcaster
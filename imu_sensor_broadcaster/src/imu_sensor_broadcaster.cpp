@@ -18,11 +18,22 @@
 
 #include "imu_sensor_broadcaster/imu_sensor_broadcaster.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
+#include "builtin_interfaces/msg/time.hpp"
+
 namespace imu_sensor_broadcaster
 {
+namespace
+{
+// sequence number, seconds and nanoseconds of the stamp precede the values
+constexpr size_t kBatchSampleHeaderSize = 3;
+// orientation, angular velocity and linear acceleration
+constexpr size_t kBatchSampleSize = kBatchSampleHeaderSize + 4 + 3 + 3;
+}  // namespace
+
 controller_interface::CallbackReturn IMUSensorBroadcaster::on_init()
 {
   try
@@ -47,12 +58,36 @@ controller_interface::CallbackReturn IMUSensorBroadcaster::on_configure(
 
   imu_sensor_ = std::make_unique<semantic_components::IMUSensor>(
     semantic_components::IMUSensor(params_.sensor_name));
+
+  imu_msg_ = sensor_msgs::msg::Imu();
+  imu_msg_.header.frame_id = params_.frame_id;
+  // convert double vector to fixed-size array in the message
+  for (size_t i = 0; i < 9; ++i)
+  {
+    imu_msg_.orientation_covariance[i] = params_.static_covariance_orientation[i];
+    imu_msg_.angular_velocity_covariance[i] = params_.static_covariance_angular_velocity[i];
+    imu_msg_.linear_acceleration_covariance[i] = params_.static_covariance_linear_acceleration[i];
+  }
+
   try
   {
     // register ft sensor data publisher
     sensor_state_publisher_ =
       get_node()->create_publisher<sensor_msgs::msg::Imu>("~/imu", rclcpp::SystemDefaultsQoS());
-    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_);
+    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_, imu_msg_);
+
+    if (params_.imu_batch.enable)
+    {
+      init_batch_msg();
+      batch_publisher_ = get_node()->create_publisher<std_msgs::msg::Float64MultiArray>(
+        "~/imu_batch", rclcpp::SystemDefaultsQoS());
+      realtime_batch_publisher_ = std::make_unique<BatchPublisher>(batch_publisher_, batch_msg_);
+    }
+    else
+    {
+      realtime_batch_publisher_.reset();
+      batch_publisher_.reset();
+    }
   }
   catch (const std::exception & e)
   {
@@ -62,18 +97,25 @@ controller_interface::CallbackReturn IMUSensorBroadcaster::on_configure(
     return CallbackReturn::ERROR;
   }
 
-  realtime_publisher_->lock();
-  realtime_publisher_->msg_.header.frame_id = params_.frame_id;
-  // convert double vector to fixed-size array in the message
-  for (size_t i = 0; i < 9; ++i)
+  // keep the publishing threads off the realtime CPUs
+  const auto scheduling = controller_realtime_tools::make_thread_scheduling(
+    params_.non_realtime_threads.priority, params_.non_realtime_threads.cpu_affinity);
+  if (
+    !realtime_publisher_->set_scheduling(scheduling) ||
+    (realtime_batch_publisher_ && !realtime_batch_publisher_->set_scheduling(scheduling)))
   {
-    realtime_publisher_->msg_.orientation_covariance[i] = params_.static_covariance_orientation[i];
-    realtime_publisher_->msg_.angular_velocity_covariance[i] =
-      params_.static_covariance_angular_velocity[i];
-    realtime_publisher_->msg_.linear_acceleration_covariance[i] =
-      params_.static_covariance_linear_acceleration[i];
+    RCLCPP_WARN(
+      get_node()->get_logger(), "Could not set the scheduling of the publishing threads.");
   }
-  realtime_publisher_->unlock();
+
+  const auto & filter_params = params_.filter;
+  filter_.configure(
+    {filter_params.angular_velocity_bias[0], filter_params.angular_velocity_bias[1],
+     filter_params.angular_velocity_bias[2]},
+    {filter_params.linear_acceleration_bias[0], filter_params.linear_acceleration_bias[1],
+     filter_params.linear_acceleration_bias[2]},
+    filter_params.cutoff_frequency, filter_params.estimate_orientation,
+    filter_params.complementary_gain);
 
   RCLCPP_DEBUG(get_node()->get_logger(), "configure successful");
   return CallbackReturn::SUCCESS;
@@ -93,6 +135,12 @@ controller_interface::InterfaceConfiguration IMUSensorBroadcaster::state_interfa
   controller_interface::InterfaceConfiguration state_interfaces_config;
   state_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
   state_interfaces_config.names = imu_sensor_->get_state_interface_names();
+  const auto & detection = params_.new_sample_detection;
+  if (detection.enable && !detection.sequence_interface.empty())
+  {
+    // claimed last, the IMU reads the interfaces before it
+    state_interfaces_config.names.push_back(detection.sequence_interface);
+  }
   return state_interfaces_config;
 }
 
@@ -100,6 +148,12 @@ controller_interface::CallbackReturn IMUSensorBroadcaster::on_activate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   imu_sensor_->assign_loaned_state_interfaces(state_interfaces_);
+  // the first update is published
+  decimation_counter_ = params_.decimation - 1;
+  filter_.reset();
+  reset_batch_samples();
+  new_sample_detector_.reset(
+    params_.new_sample_detection.sequence_interface.empty() ? raw_reading_.size() : 1);
   return CallbackReturn::SUCCESS;
 }
 
@@ -111,18 +165,130 @@ controller_interface::CallbackReturn IMUSensorBroadcaster::on_deactivate(
 }
 
 controller_interface::return_type IMUSensorBroadcaster::update(
-  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  if (realtime_publisher_ && realtime_publisher_->trylock())
+  // read once, all messages publish the same filtered reading
+  orientation_ = imu_sensor_->get_orientation();
+  angular_velocity_ = imu_sensor_->get_angular_velocity();
+  linear_acceleration_ = imu_sensor_->get_linear_acceleration();
+  const bool new_sample = !params_.new_sample_detection.enable || is_new_sample();
+  // the filter integrates over every update, a repeated sample is held for its period
+  filter_.filter(period.seconds(), orientation_, angular_velocity_, linear_acceleration_);
+  if (!new_sample)
+  {
+    return controller_interface::return_type::OK;
+  }
+
+  // a busy publisher delays the sample to the next update rather than a whole period
+  if (realtime_publisher_ && ++decimation_counter_ >= params_.decimation)
   {
-    realtime_publisher_->msg_.header.stamp = time;
-    imu_sensor_->get_values_as_message(realtime_publisher_->msg_);
-    realtime_publisher_->unlockAndPublish();
+    imu_msg_.header.stamp = time;
+    imu_msg_.orientation.x = orientation_[0];
+    imu_msg_.orientation.y = orientation_[1];
+    imu_msg_.orientation.z = orientation_[2];
+    imu_msg_.orientation.w = orientation_[3];
+    imu_msg_.angular_velocity.x = angular_velocity_[0];
+    imu_msg_.angular_velocity.y = angular_velocity_[1];
+    imu_msg_.angular_velocity.z = angular_velocity_[2];
+    imu_msg_.linear_acceleration.x = linear_acceleration_[0];
+    imu_msg_.linear_acceleration.y = linear_acceleration_[1];
+    imu_msg_.linear_acceleration.z = linear_acceleration_[2];
+    if (realtime_publisher_->try_publish(imu_msg_))
+    {
+      decimation_counter_ = 0;
+    }
+  }
+
+  if (realtime_batch_publisher_)
+  {
+    add_batch_sample(time);
   }
 
   return controller_interface::return_type::OK;
 }
 
+bool IMUSensorBroadcaster::is_new_sample()
+{
+  if (!params_.new_sample_detection.sequence_interface.empty())
+  {
+    return new_sample_detector_.is_new(state_interfaces_.back().get_value());
+  }
+  auto values = std::copy(orientation_.cbegin(), orientation_.cend(), raw_reading_.begin());
+  values = std::copy(angular_velocity_.cbegin(), angular_velocity_.cend(), values);
+  std::copy(linear_acceleration_.cbegin(), linear_acceleration_.cend(), values);
+  return new_sample_detector_.is_new(raw_reading_.data());
+}
+
+void IMUSensorBroadcaster::init_batch_msg()
+{
+  // a message holds batch_size samples, each one with a header and the values
+  const auto batch_size = static_cast<size_t>(params_.imu_batch.batch_size);
+  batch_msg_ = std_msgs::msg::Float64MultiArray();
+  batch_msg_.layout.dim.resize(2);
+  batch_msg_.layout.dim[0].label = "samples";
+  batch_msg_.layout.dim[0].size = static_cast<uint32_t>(batch_size);
+  batch_msg_.layout.dim[0].stride = static_cast<uint32_t>(batch_size * kBatchSampleSize);
+  batch_msg_.layout.dim[1].label = "sample";
+  batch_msg_.layout.dim[1].size = static_cast<uint32_t>(kBatchSampleSize);
+  batch_msg_.layout.dim[1].stride = static_cast<uint32_t>(kBatchSampleSize);
+  batch_msg_.layout.data_offset = 0;
+  batch_msg_.data.assign(batch_size * kBatchSampleSize, 0.0);
+}
+
+void IMUSensorBroadcaster::reset_batch_samples()
+{
+  if (!realtime_batch_publisher_)
+  {
+    return;
+  }
+
+  // the samples are collected in a ring buffer of two batches, so that a batch isn't lost
+  // if the realtime publisher is busy when it is complete
+  const auto batch_size = static_cast<size_t>(params_.imu_batch.batch_size);
+  batch_samples_.assign(2 * batch_size * kBatchSampleSize, 0.0);
+  batch_sequence_ = 0;
+  batch_published_sequence_ = 0;
+}
+
+void IMUSensorBroadcaster::add_batch_sample(const rclcpp::Time & time)
+{
+  const size_t capacity = batch_samples_.size() / kBatchSampleSize;
+  double * sample = &batch_samples_[(batch_sequence_ % capacity) * kBatchSampleSize];
+  ++batch_sequence_;
+
+  // all of them are exact in a double
+  const builtin_interfaces::msg::Time stamp = time;
+  sample[0] = static_cast<double>(batch_sequence_);
+  sample[1] = static_cast<double>(stamp.sec);
+  sample[2] = static_cast<double>(stamp.nanosec);
+  double * values =
+    std::copy(orientation_.cbegin(), orientation_.cend(), sample + kBatchSampleHeaderSize);
+  values = std::copy(angular_velocity_.cbegin(), angular_velocity_.cend(), values);
+  std::copy(linear_acceleration_.cbegin(), linear_acceleration_.cend(), values);
+
+  // the oldest samples are overwritten if the publisher stays busy
+  if (batch_sequence_ - batch_published_sequence_ > capacity)
+  {
+    batch_published_sequence_ = batch_sequence_ - capacity;
+  }
+
+  const auto batch_size = static_cast<size_t>(params_.imu_batch.batch_size);
+  if (batch_sequence_ - batch_published_sequence_ >= batch_size)
+  {
+    auto & data = batch_msg_.data;
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+      const size_t slot = (batch_published_sequence_ + i) % capacity;
+      std::copy_n(
+        &batch_samples_[slot * kBatchSampleSize], kBatchSampleSize, &data[i * kBatchSampleSize]);
+    }
+    if (realtime_batch_publisher_->try_publish(batch_msg_))
+    {
+      batch_published_sequence_ += batch_size;
+    }
+  }
+}
+
 }  // namespace imu_sensor_broadcaster
 
 #include "pluginlib/class_list_macros.hpp"
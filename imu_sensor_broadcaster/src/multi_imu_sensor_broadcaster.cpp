@@ -0,0 +1,168 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "imu_sensor_broadcaster/multi_imu_sensor_broadcaster.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace imu_sensor_broadcaster
+{
+namespace
+{
+// in the order of the values of the semantic component
+const std::vector<std::string> kImuValueNames = {
+  "orientation.x",         "orientation.y",         "orientation.z",
+  "orientation.w",         "angular_velocity.x",    "angular_velocity.y",
+  "angular_velocity.z",    "linear_acceleration.x", "linear_acceleration.y",
+  "linear_acceleration.z"};
+}  // namespace
+
+controller_interface::CallbackReturn MultiIMUSensorBroadcaster::on_init()
+{
+  try
+  {
+    param_listener_ = std::make_shared<multi_imu_sensor_broadcaster::ParamListener>(get_node());
+    params_ = param_listener_->get_params();
+  }
+  catch (const std::exception & e)
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Exception thrown during init stage with message: %s \n", e.what());
+    return CallbackReturn::ERROR;
+  }
+
+  return CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn MultiIMUSensorBroadcaster::on_configure(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  params_ = param_listener_->get_params();
+
+  imu_sensors_.clear();
+  for (const auto & sensor_name : params_.sensor_names)
+  {
+    imu_sensors_.push_back(std::make_unique<semantic_components::IMUSensor>(sensor_name));
+  }
+
+  // all entries are allocated once, update() only overwrites the values
+  imus_msg_ = control_msgs::msg::DynamicJointState();
+  imus_msg_.joint_names = params_.sensor_names;
+  imus_msg_.interface_values.resize(params_.sensor_names.size());
+  for (auto & interface_value : imus_msg_.interface_values)
+  {
+    interface_value.interface_names = kImuValueNames;
+    interface_value.values.assign(kImuValueNames.size(), 0.0);
+  }
+
+  try
+  {
+    sensor_state_publisher_ = get_node()->create_publisher<control_msgs::msg::DynamicJointState>(
+      "~/imus", rclcpp::SystemDefaultsQoS());
+    realtime_publisher_ = std::make_unique<StatePublisher>(sensor_state_publisher_, imus_msg_);
+  }
+  catch (const std::exception & e)
+  {
+    fprintf(
+      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
+      e.what());
+    return CallbackReturn::ERROR;
+  }
+
+  // keep the publishing threads off the realtime CPUs
+  const auto scheduling = controller_realtime_tools::make_thread_scheduling(
+    params_.non_realtime_threads.priority, params_.non_realtime_threads.cpu_affinity);
+  if (!realtime_publisher_->set_scheduling(scheduling))
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(), "Could not set the scheduling of the publishing threads.");
+  }
+
+  RCLCPP_DEBUG(get_node()->get_logger(), "configure successful");
+  return CallbackReturn::SUCCESS;
+}
+
+controller_interface::InterfaceConfiguration
+MultiIMUSensorBroadcaster::command_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration command_interfaces_config;
+  command_interfaces_config.type = controller_interface::interface_configuration_type::NONE;
+  return command_interfaces_config;
+}
+
+controller_interface::InterfaceConfiguration
+MultiIMUSensorBroadcaster::state_interface_configuration() const
+{
+  controller_interface::InterfaceConfiguration state_interfaces_config;
+  state_interfaces_config.type = controller_interface::interface_configuration_type::INDIVIDUAL;
+  for (const auto & imu_sensor : imu_sensors_)
+  {
+    const auto names = imu_sensor->get_state_interface_names();
+    state_interfaces_config.names.insert(
+      state_interfaces_config.names.end(), names.begin(), names.end());
+  }
+  return state_interfaces_config;
+}
+
+controller_interface::CallbackReturn MultiIMUSensorBroadcaster::on_activate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  for (auto & imu_sensor : imu_sensors_)
+  {
+    imu_sensor->assign_loaned_state_interfaces(state_interfaces_);
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+controller_interface::CallbackReturn MultiIMUSensorBroadcaster::on_deactivate(
+  const rclcpp_lifecycle::State & /*previous_state*/)
+{
+  for (auto & imu_sensor : imu_sensors_)
+  {
+    imu_sensor->release_interfaces();
+  }
+  return CallbackReturn::SUCCESS;
+}
+
+controller_interface::return_type MultiIMUSensorBroadcaster::update(
+  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+{
+  if (realtime_publisher_)
+  {
+    imus_msg_.header.stamp = time;
+    for (size_t i = 0; i < imu_sensors_.size(); ++i)
+    {
+      const auto orientation = imu_sensors_[i]->get_orientation();
+      const auto angular_velocity = imu_sensors_[i]->get_angular_velocity();
+      const auto linear_acceleration = imu_sensors_[i]->get_linear_acceleration();
+      auto values = imus_msg_.interface_values[i].values.begin();
+      values = std::copy(orientation.cbegin(), orientation.cend(), values);
+      values = std::copy(angular_velocity.cbegin(), angular_velocity.cend(), values);
+      std::copy(linear_acceleration.cbegin(), linear_acceleration.cend(), values);
+    }
+    realtime_publisher_->try_publish(imus_msg_);
+  }
+
+  return controller_interface::return_type::OK;
+}
+
+}  // namespace imu_sensor_broadcaster
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+  imu_sensor_broadcaster::MultiIMUSensorBroadcaster, controller_interface::ControllerInterface)
@@ -18,7 +18,10 @@
 
 #include "test_imu_sensor_broadcaster.hpp"
 
+#include <chrono>
+#include <cmath>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -30,6 +33,7 @@
 #include "rclcpp/utilities.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "sensor_msgs/msg/imu.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
 
 using hardware_interface::LoanedStateInterface;
 
@@ -179,6 +183,213 @@ TEST_F(IMUSensorBroadcasterTest, SensorName_Publish_Success)
   }
 }
 
+TEST_F(IMUSensorBroadcasterTest, Decimation_Publish_Success)
+{
+  SetUpIMUBroadcaster();
+
+  imu_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  imu_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  imu_broadcaster_->get_node()->set_parameter({"decimation", 3});
+
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription = test_subscription_node.create_subscription<sensor_msgs::msg::Imu>(
+    "/test_imu_sensor_broadcaster/imu", 10, [](const sensor_msgs::msg::Imu::SharedPtr) {});
+
+  for (int64_t i = 0; i < 7; ++i)
+  {
+    ASSERT_EQ(
+      imu_broadcaster_->update(rclcpp::Time(i * 1000000), rclcpp::Duration::from_seconds(0.001)),
+      controller_interface::return_type::OK);
+    // let the realtime publisher send the message, so it isn't busy on the next update
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // the first of every three updates is published
+  std::vector<int64_t> stamps;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (wait_set.wait(std::chrono::milliseconds(100)).kind() == rclcpp::WaitResultKind::Ready)
+  {
+    sensor_msgs::msg::Imu imu_msg;
+    rclcpp::MessageInfo msg_info;
+    if (!subscription->take(imu_msg, msg_info))
+    {
+      break;
+    }
+    stamps.push_back(rclcpp::Time(imu_msg.header.stamp).nanoseconds());
+  }
+  EXPECT_THAT(stamps, ::testing::ElementsAre(0, 3000000, 6000000));
+}
+
+TEST_F(IMUSensorBroadcasterTest, NewSampleDetection_Publish_Success)
+{
+  SetUpIMUBroadcaster();
+
+  imu_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  imu_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  imu_broadcaster_->get_node()->set_parameter({"new_sample_detection.enable", true});
+
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription = test_subscription_node.create_subscription<sensor_msgs::msg::Imu>(
+    "/test_imu_sensor_broadcaster/imu", 10, [](const sensor_msgs::msg::Imu::SharedPtr) {});
+
+  // the sensor samples every third update
+  for (int64_t i = 0; i < 7; ++i)
+  {
+    sensor_values_[4] = static_cast<double>(i / 3);
+    ASSERT_EQ(
+      imu_broadcaster_->update(rclcpp::Time(i * 1000000), rclcpp::Duration::from_seconds(0.001)),
+      controller_interface::return_type::OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::vector<int64_t> stamps;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (wait_set.wait(std::chrono::milliseconds(100)).kind() == rclcpp::WaitResultKind::Ready)
+  {
+    sensor_msgs::msg::Imu imu_msg;
+    rclcpp::MessageInfo msg_info;
+    if (!subscription->take(imu_msg, msg_info))
+    {
+      break;
+    }
+    stamps.push_back(rclcpp::Time(imu_msg.header.stamp).nanoseconds());
+  }
+  EXPECT_THAT(stamps, ::testing::ElementsAre(0, 3000000, 6000000));
+}
+
+TEST_F(IMUSensorBroadcasterTest, Batch_Publish_Success)
+{
+  SetUpIMUBroadcaster();
+
+  imu_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  imu_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  imu_broadcaster_->get_node()->set_parameter({"imu_batch.enable", true});
+  imu_broadcaster_->get_node()->set_parameter({"imu_batch.batch_size", 3});
+
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription =
+    test_subscription_node.create_subscription<std_msgs::msg::Float64MultiArray>(
+      "/test_imu_sensor_broadcaster/imu_batch", 10,
+      [](const std_msgs::msg::Float64MultiArray::SharedPtr) {});
+
+  for (int64_t i = 0; i < 6; ++i)
+  {
+    sensor_values_[0] = static_cast<double>(i);
+    ASSERT_EQ(
+      imu_broadcaster_->update(
+        rclcpp::Time(1, static_cast<uint32_t>(i * 1000000)),
+        rclcpp::Duration::from_seconds(0.001)),
+      controller_interface::return_type::OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::vector<std_msgs::msg::Float64MultiArray> batches;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (wait_set.wait(std::chrono::milliseconds(100)).kind() == rclcpp::WaitResultKind::Ready)
+  {
+    std_msgs::msg::Float64MultiArray batch_msg;
+    rclcpp::MessageInfo msg_info;
+    if (!subscription->take(batch_msg, msg_info))
+    {
+      break;
+    }
+    batches.push_back(batch_msg);
+  }
+
+  // every update is published, three per message
+  ASSERT_EQ(batches.size(), 2u);
+  const size_t sample_size = 13;
+  for (size_t batch = 0; batch < batches.size(); ++batch)
+  {
+    const auto & batch_msg = batches[batch];
+    ASSERT_EQ(batch_msg.layout.dim.size(), 2u);
+    EXPECT_EQ(batch_msg.layout.dim[0].size, 3u);
+    EXPECT_EQ(batch_msg.layout.dim[1].size, sample_size);
+    ASSERT_EQ(batch_msg.data.size(), 3 * sample_size);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      const double * sample = &batch_msg.data[i * sample_size];
+      const size_t update = batch * 3 + i;
+      EXPECT_EQ(sample[0], static_cast<double>(update + 1));
+      EXPECT_EQ(sample[1], 1.0);
+      EXPECT_EQ(sample[2], static_cast<double>(update * 1000000));
+      EXPECT_EQ(sample[3], static_cast<double>(update));
+      for (size_t value = 1; value < 10; ++value)
+      {
+        EXPECT_EQ(sample[3 + value], sensor_values_[value]);
+      }
+    }
+  }
+}
+
+TEST_F(IMUSensorBroadcasterTest, Filter_Publish_Success)
+{
+  SetUpIMUBroadcaster();
+
+  imu_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  imu_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  imu_broadcaster_->get_node()->set_parameter(
+    {"filter.angular_velocity_bias", std::vector<double>{0.5, 0.5, 0.5}});
+  imu_broadcaster_->get_node()->set_parameter(
+    {"filter.linear_acceleration_bias", std::vector<double>{1.0, 1.0, 1.0}});
+  imu_broadcaster_->get_node()->set_parameter({"filter.cutoff_frequency", 10.0});
+
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  sensor_msgs::msg::Imu imu_msg;
+  subscribe_and_get_message(imu_msg);
+
+  // the low-pass passes a constant reading without the bias, the orientation is the sensor's
+  EXPECT_EQ(imu_msg.orientation.x, sensor_values_[0]);
+  EXPECT_EQ(imu_msg.orientation.w, sensor_values_[3]);
+  EXPECT_DOUBLE_EQ(imu_msg.angular_velocity.x, sensor_values_[4] - 0.5);
+  EXPECT_DOUBLE_EQ(imu_msg.angular_velocity.y, sensor_values_[5] - 0.5);
+  EXPECT_DOUBLE_EQ(imu_msg.angular_velocity.z, sensor_values_[6] - 0.5);
+  EXPECT_DOUBLE_EQ(imu_msg.linear_acceleration.x, sensor_values_[7] - 1.0);
+  EXPECT_DOUBLE_EQ(imu_msg.linear_acceleration.y, sensor_values_[8] - 1.0);
+  EXPECT_DOUBLE_EQ(imu_msg.linear_acceleration.z, sensor_values_[9] - 1.0);
+}
+
+TEST_F(IMUSensorBroadcasterTest, EstimateOrientation_Publish_Success)
+{
+  SetUpIMUBroadcaster();
+
+  imu_broadcaster_->get_node()->set_parameter({"sensor_name", sensor_name_});
+  imu_broadcaster_->get_node()->set_parameter({"frame_id", frame_id_});
+  imu_broadcaster_->get_node()->set_parameter({"filter.estimate_orientation", true});
+
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // at rest, tilted about the x axis
+  const double tilt = 0.3;
+  sensor_values_[4] = sensor_values_[5] = sensor_values_[6] = 0.0;
+  sensor_values_[7] = 0.0;
+  sensor_values_[8] = 9.80665 * std::sin(tilt);
+  sensor_values_[9] = 9.80665 * std::cos(tilt);
+
+  sensor_msgs::msg::Imu imu_msg;
+  subscribe_and_get_message(imu_msg);
+
+  EXPECT_NEAR(imu_msg.orientation.x, std::sin(0.5 * tilt), 1e-9);
+  EXPECT_NEAR(imu_msg.orientation.y, 0.0, 1e-9);
+  EXPECT_NEAR(imu_msg.orientation.z, 0.0, 1e-9);
+  EXPECT_NEAR(imu_msg.orientation.w, std::cos(0.5 * tilt), 1e-9);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleMock(&argc, argv);
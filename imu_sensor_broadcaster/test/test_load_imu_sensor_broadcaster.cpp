@@ -40,6 +40,10 @@ TEST(TestLoadIMUSensorBroadcaster, load_controller)
     cm.load_controller(
       "test_imu_sensor_broadcaster", "imu_sensor_broadcaster/IMUSensorBroadcaster"),
     nullptr);
+  ASSERT_NE(
+    cm.load_controller(
+      "test_multi_imu_sensor_broadcaster", "imu_sensor_broadcaster/MultiIMUSensorBroadcaster"),
+    nullptr);
 }
 
 int main(int argc, char ** argv)
@@ -0,0 +1,144 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "control_msgs/msg/dynamic_joint_state.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "imu_sensor_broadcaster/multi_imu_sensor_broadcaster.hpp"
+#include "rclcpp/utilities.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+using hardware_interface::LoanedStateInterface;
+
+namespace
+{
+constexpr auto NODE_SUCCESS = controller_interface::CallbackReturn::SUCCESS;
+
+const std::vector<std::string> kSensorNames = {"imu_sensor_1", "imu_sensor_2"};
+const std::vector<std::string> kInterfaceNames = {
+  "orientation.x",         "orientation.y",         "orientation.z",
+  "orientation.w",         "angular_velocity.x",    "angular_velocity.y",
+  "angular_velocity.z",    "linear_acceleration.x", "linear_acceleration.y",
+  "linear_acceleration.z"};
+}  // namespace
+
+class MultiIMUSensorBroadcasterTest : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    imu_broadcaster_ = std::make_unique<imu_sensor_broadcaster::MultiIMUSensorBroadcaster>();
+    for (size_t i = 0; i < kSensorNames.size(); ++i)
+    {
+      for (size_t j = 0; j < kInterfaceNames.size(); ++j)
+      {
+        sensor_values_[i][j] = 10.0 * static_cast<double>(i + 1) + static_cast<double>(j);
+        state_interfaces_.emplace_back(kSensorNames[i], kInterfaceNames[j], &sensor_values_[i][j]);
+      }
+    }
+  }
+
+  void TearDown() { imu_broadcaster_.reset(nullptr); }
+
+  void SetUpIMUBroadcaster()
+  {
+    const auto result = imu_broadcaster_->init("test_multi_imu_sensor_broadcaster");
+    ASSERT_EQ(result, controller_interface::return_type::OK);
+
+    std::vector<LoanedStateInterface> state_ifs;
+    for (auto & state_interface : state_interfaces_)
+    {
+      state_ifs.emplace_back(state_interface);
+    }
+    imu_broadcaster_->assign_interfaces({}, std::move(state_ifs));
+  }
+
+protected:
+  std::array<std::array<double, 10>, 2> sensor_values_;
+  std::vector<hardware_interface::StateInterface> state_interfaces_;
+
+  std::unique_ptr<imu_sensor_broadcaster::MultiIMUSensorBroadcaster> imu_broadcaster_;
+};
+
+TEST_F(MultiIMUSensorBroadcasterTest, StateInterfaceConfiguration_Success)
+{
+  SetUpIMUBroadcaster();
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  const auto config = imu_broadcaster_->state_interface_configuration();
+  ASSERT_EQ(config.names.size(), kSensorNames.size() * kInterfaceNames.size());
+  EXPECT_EQ(config.names.front(), "imu_sensor_1/orientation.x");
+  EXPECT_EQ(config.names.back(), "imu_sensor_2/linear_acceleration.z");
+}
+
+TEST_F(MultiIMUSensorBroadcasterTest, SensorStates_Publish_Success)
+{
+  SetUpIMUBroadcaster();
+  ASSERT_EQ(imu_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(imu_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  rclcpp::Node test_subscription_node("test_subscription_node");
+  auto subscription =
+    test_subscription_node.create_subscription<control_msgs::msg::DynamicJointState>(
+      "/test_multi_imu_sensor_broadcaster/imus", 10,
+      [](const control_msgs::msg::DynamicJointState::SharedPtr) {});
+
+  // since update doesn't guarantee a published message, republish until received
+  int max_sub_check_loop_count = 5;
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  while (max_sub_check_loop_count--)
+  {
+    imu_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01));
+    if (wait_set.wait(std::chrono::milliseconds(2)).kind() == rclcpp::WaitResultKind::Ready)
+    {
+      break;
+    }
+  }
+  ASSERT_GE(max_sub_check_loop_count, 0);
+
+  control_msgs::msg::DynamicJointState imus_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(imus_msg, msg_info));
+
+  ASSERT_EQ(imus_msg.joint_names, kSensorNames);
+  ASSERT_EQ(imus_msg.interface_values.size(), kSensorNames.size());
+  for (size_t i = 0; i < kSensorNames.size(); ++i)
+  {
+    EXPECT_EQ(imus_msg.interface_values[i].interface_names, kInterfaceNames);
+    ASSERT_EQ(imus_msg.interface_values[i].values.size(), kInterfaceNames.size());
+    for (size_t j = 0; j < kInterfaceNames.size(); ++j)
+    {
+      EXPECT_EQ(imus_msg.interface_values[i].values[j], sensor_values_[i][j]);
+    }
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  ::testing::InitGoogleMock(&argc, argv);
+  rclcpp::init(argc, argv);
+  int result = RUN_ALL_TESTS();
+  rclcpp::shutdown();
+  return result;
+}
@@ -15,20 +15,34 @@
 #ifndef JOINT_STATE_BROADCASTER__JOINT_STATE_BROADCASTER_HPP_
 #define JOINT_STATE_BROADCASTER__JOINT_STATE_BROADCASTER_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "control_msgs/msg/dynamic_joint_state.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/biquad_filter.hpp"
+#include "controller_realtime_tools/cycle_budget.hpp"
+#include "controller_realtime_tools/memory_footprint.hpp"
+#include "controller_realtime_tools/memory_prefault.hpp"
+#include "controller_realtime_tools/new_sample_detector.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
 #include "joint_state_broadcaster/visibility_control.h"
 // auto-generated by generate_parameter_library
 #include "joint_state_broadcaster_parameters.hpp"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp/timer.hpp"
 #include "rclcpp_lifecycle/lifecycle_publisher.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
-#include "realtime_tools/realtime_publisher.h"
 #include "sensor_msgs/msg/joint_state.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
+#include "std_srvs/srv/trigger.hpp"
 
 namespace joint_state_broadcaster
 {
@@ -49,12 +63,40 @@ namespace joint_state_broadcaster
  * \param interfaces Names of interfaces to publish.
  * \param map_interface_to_joint_state.{HW_IF_POSITION|HW_IF_VELOCITY|HW_IF_EFFORT} mapping
  * between custom interface names and standard names in sensor_msgs::msg::JointState message.
+ * \param joint_states.publish_rate Rate of the JointState message, 0 for every update.
+ * \param dynamic_joint_states.publish_rate Rate of the DynamicJointState message, 0 for every
+ * update.
+ * \param dynamic_joint_states.publish_on_change Flag to publish the DynamicJointState message only
+ * if a value changed by more than dynamic_joint_states.deadband since it was last published.
+ * \param dynamic_joint_states.publish_only_with_subscribers Flag to neither fill nor publish the
+ * DynamicJointState message while nobody subscribes to it.
+ * \param compact_joint_states.enable Flag to publish the values of all interfaces in a compact
+ * stream.
+ * \param compact_joint_states.batch_size Number of updates published in one message of the compact
+ * stream.
+ * \param velocity_estimation.enable Flag to publish the velocity of joints without a velocity
+ * state interface, estimated from their positions.
+ * \param velocity_estimation.cutoff_frequency Cutoff frequency of the low-pass of the estimated
+ * velocities.
+ * \param velocity_estimation.sampling_frequency Rate at which the low-pass is designed, 0 for the
+ * update rate.
+ * \param joint_groups Names of groups of joints, which are published to separate topics.
+ * \param groups.<joint_group>.joints Names of the joints of a group.
+ * \param groups.<joint_group>.publish_rate Rate of the JointState message of a group, 0 for every
+ * update.
  *
  * Publishes to:
  * - \b joint_states (sensor_msgs::msg::JointState): Joint states related to movement
  * (position, velocity, effort).
  * - \b dynamic_joint_states (control_msgs::msg::DynamicJointState): Joint states regardless of
  * its interface type.
+ * - \b joint_states/<joint_group> (sensor_msgs::msg::JointState): Joint states of the joints of a
+ * group.
+ * - \b compact_joint_states (std_msgs::msg::Float64MultiArray): Samples of batch_size updates,
+ * each one with the sequence number and stamp of the update followed by the values of all
+ * interfaces.
+ * - \b compact_joint_states/names (control_msgs::msg::DynamicJointState): Names of the joints and
+ * interfaces of compact_joint_states, published once with transient local durability.
  */
 class JointStateBroadcaster : public controller_interface::ControllerInterface
 {
@@ -91,9 +133,29 @@ protected:
   bool init_joint_data();
   void init_joint_state_msg();
   void init_dynamic_joint_state_msg();
+  void init_interface_value_mapping();
+  void init_velocity_estimators();
+  void init_joint_group_msgs();
+  void init_compact_joint_state_msgs();
+  void init_realtime_publishers();
+  //  Fault in the pages of the messages and buffers filled by update(), and lock them if
+  //  lock_memory is set, and record the memory footprint
+  void prefault_memory();
+  //  Handler of ~/get_memory_footprint
+  void get_memory_footprint(
+    const std::shared_ptr<std_srvs::srv::Trigger::Request> request,
+    std::shared_ptr<std_srvs::srv::Trigger::Response> response);
   bool use_all_available_interfaces() const;
+  bool dynamic_joint_state_changed() const;
+  void update_dynamic_joint_state_subscription_count();
+  void estimate_velocities(double period);
 
 protected:
+  /// The messages are filled by update() and swapped into the realtime publishers
+  template <typename MessageT>
+  using RealtimePublisher =
+    controller_realtime_tools::RealtimeSwapPublisher<MessageT, rclcpp::Publisher<MessageT>>;
+
   // Optional parameters
   std::shared_ptr<ParamListener> param_listener_;
   Params params_;
@@ -103,16 +165,112 @@ protected:
   //  we store the name of joints with compatible interfaces
   std::vector<std::string> joint_names_;
   std::shared_ptr<rclcpp::Publisher<sensor_msgs::msg::JointState>> joint_state_publisher_;
-  std::shared_ptr<realtime_tools::RealtimePublisher<sensor_msgs::msg::JointState>>
-    realtime_joint_state_publisher_;
+  std::shared_ptr<RealtimePublisher<sensor_msgs::msg::JointState>> realtime_joint_state_publisher_;
+  sensor_msgs::msg::JointState joint_state_msg_;
 
-  //  For the DynamicJointState format, we use a map to buffer values in for easier lookup
-  //  This allows to preserve whatever order or names/interfaces were initialized.
+  //  For the DynamicJointState format, we use a map to collect the names and interfaces on
+  //  activation. This allows to preserve whatever order or names/interfaces were initialized.
   std::unordered_map<std::string, std::unordered_map<std::string, double>> name_if_value_mapping_;
   std::shared_ptr<rclcpp::Publisher<control_msgs::msg::DynamicJointState>>
     dynamic_joint_state_publisher_;
-  std::shared_ptr<realtime_tools::RealtimePublisher<control_msgs::msg::DynamicJointState>>
+  std::shared_ptr<RealtimePublisher<control_msgs::msg::DynamicJointState>>
     realtime_dynamic_joint_state_publisher_;
+  control_msgs::msg::DynamicJointState dynamic_joint_state_msg_;
+
+  /// Destination of the value of a state interface in one of the published messages
+  struct InterfaceValueMapping
+  {
+    size_t state_interface_index;
+    size_t joint_index;
+    /// index of the field (position, velocity, effort) in JointState,
+    /// index of the interface in DynamicJointState
+    size_t value_index;
+  };
+  //  Computed on activation, so that update() only copies values without lookups by name
+  //  All messages are filled from the values of the state interfaces, read once per update
+  std::vector<double> state_interface_values_;
+  std::vector<InterfaceValueMapping> joint_state_mapping_;
+  std::vector<InterfaceValueMapping> dynamic_joint_state_mapping_;
+
+  //  Velocity of a joint without a velocity state interface, estimated from its position
+  struct VelocityEstimator
+  {
+    size_t position_interface_index;
+    controller_realtime_tools::BiquadFilter filter;
+    double previous_position;
+  };
+  //  Low-pass configured on configure, copied into every estimator on activation
+  controller_realtime_tools::BiquadFilter velocity_filter_;
+  //  The estimate of estimator i is stored after the values of the state interfaces, at
+  //  state_interface_values_[state_interfaces_.size() + i], so the JointState messages take it
+  //  like the value of a velocity state interface
+  std::vector<VelocityEstimator> velocity_estimators_;
+
+  //  The key is the value of state_interfaces_[new_sample_sequence_index_], or the values of all
+  //  state interfaces if the index is past them
+  controller_realtime_tools::NewSampleDetector new_sample_detector_;
+  size_t new_sample_sequence_index_ = 0;
+  //  Seconds since the last new sample, the period of the velocity estimates
+  double new_sample_period_ = 0.0;
+
+  //  Bytes held per buffer, recorded on activation, and the allocations of update() since then,
+  //  reported by ~/get_memory_footprint
+  std::mutex memory_footprint_mutex_;
+  controller_realtime_tools::MemoryFootprint memory_footprint_;
+  controller_realtime_tools::AllocationCounter allocation_counter_;
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr memory_footprint_service_;
+
+  //  A period of 0 publishes on every update
+  rclcpp::Duration joint_state_publish_period_ = rclcpp::Duration::from_nanoseconds(0);
+  rclcpp::Duration dynamic_joint_state_publish_period_ = rclcpp::Duration::from_nanoseconds(0);
+  //  Values of the last published DynamicJointState message, in the order of its mapping
+  std::vector<double> dynamic_joint_state_published_values_;
+  bool dynamic_joint_state_published_ = false;
+  //  Sampled by a timer, the realtime update() must not query the middleware
+  std::atomic<bool> dynamic_joint_state_has_subscribers_{true};
+  rclcpp::TimerBase::SharedPtr subscription_count_timer_;
+
+  //  Non-essential stages of update(), skipped while over the cycle budget
+  enum ShedStage : size_t
+  {
+    SHED_DYNAMIC_JOINT_STATES,
+    SHED_JOINT_GROUPS,
+  };
+  //  nullptr if cycle_budget.enable isn't set
+  std::unique_ptr<controller_realtime_tools::CycleBudget> cycle_budget_;
+  rclcpp::TimerBase::SharedPtr cycle_budget_timer_;
+
+  //  A JointState message published to a separate topic, with a subset of the joints
+  struct JointGroup
+  {
+    std::string name;
+    std::vector<std::string> joint_names;
+    std::shared_ptr<rclcpp::Publisher<sensor_msgs::msg::JointState>> publisher;
+    std::shared_ptr<RealtimePublisher<sensor_msgs::msg::JointState>> realtime_publisher;
+    sensor_msgs::msg::JointState msg;
+    std::vector<InterfaceValueMapping> mapping;
+    rclcpp::Duration publish_period = rclcpp::Duration::from_nanoseconds(0);
+  };
+  std::vector<JointGroup> joint_groups_;
+
+  //  The compact stream has the values in the order of the DynamicJointState message,
+  //  but without the names
+  std::shared_ptr<rclcpp::Publisher<control_msgs::msg::DynamicJointState>>
+    compact_joint_state_names_publisher_;
+  std::shared_ptr<rclcpp::Publisher<std_msgs::msg::Float64MultiArray>>
+    compact_joint_state_publisher_;
+  std::shared_ptr<RealtimePublisher<std_msgs::msg::Float64MultiArray>>
+    realtime_compact_joint_state_publisher_;
+  std_msgs::msg::Float64MultiArray compact_joint_state_msg_;
+  //  Index of the first value of each joint of the DynamicJointState message in the stream
+  std::vector<size_t> compact_joint_state_offsets_;
+  //  Number of updates since activation, gaps in the stream show dropped samples
+  uint64_t compact_joint_state_sequence_ = 0;
+  //  Ring buffer of the samples, filled by update() and published in batches
+  std::vector<double> compact_joint_state_samples_;
+  size_t compact_joint_state_sample_size_ = 0;
+  //  Sequence number of the last published sample
+  uint64_t compact_joint_state_published_sequence_ = 0;
 };
 
 }  // namespace joint_state_broadcaster
@@ -15,16 +15,27 @@
 #include "joint_state_broadcaster/joint_state_broadcaster.hpp"
 
 #include <stddef.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "controller_realtime_tools/rt_logging.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "rclcpp/clock.hpp"
 #include "rclcpp/event_handler.hpp"
+#include "rclcpp/logging.hpp"
 #include "rclcpp/qos.hpp"
 #include "rclcpp/time.hpp"
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
@@ -40,6 +51,12 @@ class State;
 namespace joint_state_broadcaster
 {
 const auto kUninitializedValue = std::numeric_limits<double>::quiet_NaN();
+const auto kSubscriptionCountPeriod = std::chrono::milliseconds(100);
+// sequence number, seconds and nanoseconds of the stamp precede the values
+constexpr uint32_t kCompactJointStateHeaderSize = 3;
+// value_index of the position and velocity fields in the JointState mapping
+constexpr size_t kJointStatePositionField = 0;
+constexpr size_t kJointStateVelocityField = 1;
 using hardware_interface::HW_IF_EFFORT;
 using hardware_interface::HW_IF_POSITION;
 using hardware_interface::HW_IF_VELOCITY;
@@ -139,29 +156,111 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_configure(
     }
   };
 
+  joint_state_publish_period_ =
+    params_.joint_states.publish_rate > 0.0
+      ? rclcpp::Duration::from_seconds(1.0 / params_.joint_states.publish_rate)
+      : rclcpp::Duration::from_nanoseconds(0);
+  dynamic_joint_state_publish_period_ =
+    params_.dynamic_joint_states.publish_rate > 0.0
+      ? rclcpp::Duration::from_seconds(1.0 / params_.dynamic_joint_states.publish_rate)
+      : rclcpp::Duration::from_nanoseconds(0);
+
   map_interface_to_joint_state_ = {};
   get_map_interface_parameter(HW_IF_POSITION, params_.map_interface_to_joint_state.position);
   get_map_interface_parameter(HW_IF_VELOCITY, params_.map_interface_to_joint_state.velocity);
   get_map_interface_parameter(HW_IF_EFFORT, params_.map_interface_to_joint_state.effort);
 
+  if (params_.velocity_estimation.enable)
+  {
+    const double sampling_frequency = params_.velocity_estimation.sampling_frequency > 0.0
+                                        ? params_.velocity_estimation.sampling_frequency
+                                        : static_cast<double>(get_update_rate());
+    if (!velocity_filter_.configure_butterworth_low_pass(
+          params_.velocity_estimation.cutoff_frequency, sampling_frequency))
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "'velocity_estimation.cutoff_frequency' (%f Hz) has to be below half of the sampling "
+        "frequency (%f Hz).",
+        params_.velocity_estimation.cutoff_frequency, sampling_frequency);
+      return CallbackReturn::ERROR;
+    }
+  }
+
+  if (params_.cycle_budget.enable)
+  {
+    cycle_budget_ = std::make_unique<controller_realtime_tools::CycleBudget>(
+      std::chrono::nanoseconds(static_cast<int64_t>(params_.cycle_budget.update_time * 1e9)),
+      static_cast<uint32_t>(params_.cycle_budget.recovery_cycles),
+      std::vector<std::string>{"dynamic_joint_states", "joint_groups"});
+    cycle_budget_timer_ = get_node()->create_wall_timer(
+      std::chrono::seconds(1),
+      [this]()
+      {
+        const auto report = cycle_budget_->get_report();
+        if (!report.empty())
+        {
+          RCLCPP_WARN(get_node()->get_logger(), "%s", report.c_str());
+        }
+      });
+  }
+  else
+  {
+    cycle_budget_timer_.reset();
+    cycle_budget_.reset();
+  }
+
   try
   {
     const std::string topic_name_prefix = params_.use_local_topics ? "~/" : "";
 
+    // the realtime publishers are created on activation, with the layout of the messages
+    realtime_joint_state_publisher_.reset();
+    realtime_dynamic_joint_state_publisher_.reset();
+    realtime_compact_joint_state_publisher_.reset();
+
     joint_state_publisher_ = get_node()->create_publisher<sensor_msgs::msg::JointState>(
       topic_name_prefix + "joint_states", rclcpp::SystemDefaultsQoS());
 
-    realtime_joint_state_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<sensor_msgs::msg::JointState>>(
-        joint_state_publisher_);
-
     dynamic_joint_state_publisher_ =
       get_node()->create_publisher<control_msgs::msg::DynamicJointState>(
         topic_name_prefix + "dynamic_joint_states", rclcpp::SystemDefaultsQoS());
 
-    realtime_dynamic_joint_state_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<control_msgs::msg::DynamicJointState>>(
-        dynamic_joint_state_publisher_);
+    if (params_.compact_joint_states.enable)
+    {
+      compact_joint_state_names_publisher_ =
+        get_node()->create_publisher<control_msgs::msg::DynamicJointState>(
+          topic_name_prefix + "compact_joint_states/names", rclcpp::QoS(1).transient_local());
+      compact_joint_state_publisher_ =
+        get_node()->create_publisher<std_msgs::msg::Float64MultiArray>(
+          topic_name_prefix + "compact_joint_states", rclcpp::SystemDefaultsQoS());
+    }
+    else
+    {
+      compact_joint_state_publisher_.reset();
+      compact_joint_state_names_publisher_.reset();
+    }
+
+    joint_groups_.clear();
+    for (const auto & group_name : params_.joint_groups)
+    {
+      const auto & group_params = params_.groups.joint_groups_map.at(group_name);
+      JointGroup group;
+      group.name = group_name;
+      group.joint_names = group_params.joints;
+      group.publisher = get_node()->create_publisher<sensor_msgs::msg::JointState>(
+        topic_name_prefix + "joint_states/" + group_name, rclcpp::SystemDefaultsQoS());
+      if (group_params.publish_rate > 0.0)
+      {
+        group.publish_period = rclcpp::Duration::from_seconds(1.0 / group_params.publish_rate);
+      }
+      joint_groups_.push_back(std::move(group));
+    }
+
+    memory_footprint_service_ = get_node()->create_service<std_srvs::srv::Trigger>(
+      "~/get_memory_footprint", std::bind(
+                                  &JointStateBroadcaster::get_memory_footprint, this,
+                                  std::placeholders::_1, std::placeholders::_2));
   }
   catch (const std::exception & e)
   {
@@ -184,6 +283,58 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_activate(
 
   init_joint_state_msg();
   init_dynamic_joint_state_msg();
+  init_interface_value_mapping();
+  init_velocity_estimators();
+  init_joint_group_msgs();
+  init_compact_joint_state_msgs();
+  init_realtime_publishers();
+
+  state_interface_values_.assign(
+    state_interfaces_.size() + velocity_estimators_.size(), kUninitializedValue);
+  dynamic_joint_state_published_values_.assign(
+    dynamic_joint_state_mapping_.size(), kUninitializedValue);
+  dynamic_joint_state_published_ = false;
+
+  if (params_.dynamic_joint_states.publish_only_with_subscribers)
+  {
+    update_dynamic_joint_state_subscription_count();
+    subscription_count_timer_ = get_node()->create_wall_timer(
+      kSubscriptionCountPeriod,
+      std::bind(&JointStateBroadcaster::update_dynamic_joint_state_subscription_count, this));
+  }
+  else
+  {
+    subscription_count_timer_.reset();
+    dynamic_joint_state_has_subscribers_.store(true);
+  }
+
+  new_sample_sequence_index_ = state_interfaces_.size();
+  const auto & sequence_interface = params_.new_sample_detection.sequence_interface;
+  if (params_.new_sample_detection.enable && !sequence_interface.empty())
+  {
+    for (size_t i = 0; i < state_interfaces_.size(); ++i)
+    {
+      if (state_interfaces_[i].get_name() == sequence_interface)
+      {
+        new_sample_sequence_index_ = i;
+      }
+    }
+    if (new_sample_sequence_index_ == state_interfaces_.size())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "'new_sample_detection.sequence_interface' '%s' is not a state interface of the "
+        "broadcaster.",
+        sequence_interface.c_str());
+      return CallbackReturn::ERROR;
+    }
+  }
+  new_sample_detector_.reset(
+    new_sample_sequence_index_ < state_interfaces_.size() ? 1 : state_interfaces_.size());
+  new_sample_period_ = 0.0;
+
+  prefault_memory();
+  allocation_counter_.reset();
 
   if (
     !use_all_available_interfaces() &&
@@ -202,6 +353,10 @@ controller_interface::CallbackReturn JointStateBroadcaster::on_deactivate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
   joint_names_.clear();
+  joint_state_mapping_.clear();
+  dynamic_joint_state_mapping_.clear();
+  velocity_estimators_.clear();
+  subscription_count_timer_.reset();
 
   return CallbackReturn::SUCCESS;
 }
@@ -226,6 +381,7 @@ bool has_any_key(
 bool JointStateBroadcaster::init_joint_data()
 {
   joint_names_.clear();
+  name_if_value_mapping_.clear();
   if (state_interfaces_.empty())
   {
     return false;
@@ -279,6 +435,22 @@ bool JointStateBroadcaster::init_joint_data()
   return true;
 }
 
+double get_value(
+  const std::unordered_map<std::string, std::unordered_map<std::string, double>> & map,
+  const std::string & name, const std::string & interface_name)
+{
+  const auto & interfaces_and_values = map.at(name);
+  const auto interface_and_value = interfaces_and_values.find(interface_name);
+  if (interface_and_value != interfaces_and_values.cend())
+  {
+    return interface_and_value->second;
+  }
+  else
+  {
+    return kUninitializedValue;
+  }
+}
+
 void JointStateBroadcaster::init_joint_state_msg()
 {
   const size_t num_joints = joint_names_.size();
@@ -287,16 +459,27 @@ void JointStateBroadcaster::init_joint_state_msg()
   /// with at least one of these interfaces, the rest are omitted from this message
 
   // default initialization for joint state message
-  auto & joint_state_msg = realtime_joint_state_publisher_->msg_;
+  auto & joint_state_msg = joint_state_msg_;
   joint_state_msg.name = joint_names_;
   joint_state_msg.position.resize(num_joints, kUninitializedValue);
   joint_state_msg.velocity.resize(num_joints, kUninitializedValue);
   joint_state_msg.effort.resize(num_joints, kUninitializedValue);
+  // values without a state interface are never written by update(), e.g., of extra joints
+  for (size_t i = 0; i < num_joints; ++i)
+  {
+    joint_state_msg.position[i] =
+      get_value(name_if_value_mapping_, joint_names_[i], HW_IF_POSITION);
+    joint_state_msg.velocity[i] =
+      get_value(name_if_value_mapping_, joint_names_[i], HW_IF_VELOCITY);
+    joint_state_msg.effort[i] = get_value(name_if_value_mapping_, joint_names_[i], HW_IF_EFFORT);
+  }
 }
 
 void JointStateBroadcaster::init_dynamic_joint_state_msg()
 {
-  auto & dynamic_joint_state_msg = realtime_dynamic_joint_state_publisher_->msg_;
+  auto & dynamic_joint_state_msg = dynamic_joint_state_msg_;
+  dynamic_joint_state_msg.joint_names.clear();
+  dynamic_joint_state_msg.interface_values.clear();
   for (const auto & name_ifv : name_if_value_mapping_)
   {
     const auto & name = name_ifv.first;
@@ -306,88 +489,543 @@ void JointStateBroadcaster::init_dynamic_joint_state_msg()
     for (const auto & interface_and_value : interfaces_and_values)
     {
       if_value.interface_names.emplace_back(interface_and_value.first);
-      if_value.values.emplace_back(kUninitializedValue);
+      if_value.values.emplace_back(interface_and_value.second);
     }
     dynamic_joint_state_msg.interface_values.emplace_back(if_value);
   }
 }
 
+void JointStateBroadcaster::init_interface_value_mapping()
+{
+  const auto & dynamic_joint_state_msg = dynamic_joint_state_msg_;
+  const std::vector<std::string> joint_state_interfaces = {
+    HW_IF_POSITION, HW_IF_VELOCITY, HW_IF_EFFORT};
+
+  joint_state_mapping_.clear();
+  dynamic_joint_state_mapping_.clear();
+  for (size_t si = 0; si < state_interfaces_.size(); ++si)
+  {
+    const auto & state_interface = state_interfaces_[si];
+    const std::string joint_name = state_interface.get_prefix_name();
+    std::string interface_name = state_interface.get_interface_name();
+    if (map_interface_to_joint_state_.count(interface_name) > 0)
+    {
+      interface_name = map_interface_to_joint_state_[interface_name];
+    }
+
+    const auto joint_it = std::find(joint_names_.cbegin(), joint_names_.cend(), joint_name);
+    const auto field_it =
+      std::find(joint_state_interfaces.cbegin(), joint_state_interfaces.cend(), interface_name);
+    if (joint_it != joint_names_.cend() && field_it != joint_state_interfaces.cend())
+    {
+      joint_state_mapping_.push_back(
+        {si, static_cast<size_t>(std::distance(joint_names_.cbegin(), joint_it)),
+         static_cast<size_t>(std::distance(joint_state_interfaces.cbegin(), field_it))});
+    }
+
+    const auto & dynamic_names = dynamic_joint_state_msg.joint_names;
+    const auto dynamic_joint_it =
+      std::find(dynamic_names.cbegin(), dynamic_names.cend(), joint_name);
+    if (dynamic_joint_it != dynamic_names.cend())
+    {
+      const auto joint_index =
+        static_cast<size_t>(std::distance(dynamic_names.cbegin(), dynamic_joint_it));
+      const auto & interface_names =
+        dynamic_joint_state_msg.interface_values[joint_index].interface_names;
+      const auto interface_it =
+        std::find(interface_names.cbegin(), interface_names.cend(), interface_name);
+      if (interface_it != interface_names.cend())
+      {
+        dynamic_joint_state_mapping_.push_back(
+          {si, joint_index,
+           static_cast<size_t>(std::distance(interface_names.cbegin(), interface_it))});
+      }
+    }
+  }
+}
+
+void JointStateBroadcaster::init_velocity_estimators()
+{
+  velocity_estimators_.clear();
+  if (!params_.velocity_estimation.enable)
+  {
+    return;
+  }
+
+  std::vector<bool> has_velocity(joint_names_.size(), false);
+  for (const auto & mapping : joint_state_mapping_)
+  {
+    if (mapping.value_index == kJointStateVelocityField)
+    {
+      has_velocity[mapping.joint_index] = true;
+    }
+  }
+  // the estimates are mapped like the values of velocity state interfaces
+  const size_t num_mappings = joint_state_mapping_.size();
+  for (size_t i = 0; i < num_mappings; ++i)
+  {
+    const InterfaceValueMapping mapping = joint_state_mapping_[i];
+    if (mapping.value_index != kJointStatePositionField || has_velocity[mapping.joint_index])
+    {
+      continue;
+    }
+    joint_state_mapping_.push_back(
+      {state_interfaces_.size() + velocity_estimators_.size(), mapping.joint_index,
+       kJointStateVelocityField});
+    velocity_estimators_.push_back(
+      {mapping.state_interface_index, velocity_filter_, kUninitializedValue});
+    has_velocity[mapping.joint_index] = true;
+  }
+  if (!velocity_estimators_.empty())
+  {
+    RCLCPP_INFO(
+      get_node()->get_logger(), "Estimating the velocity of %zu joints from their positions.",
+      velocity_estimators_.size());
+  }
+}
+
+void JointStateBroadcaster::init_joint_group_msgs()
+{
+  const auto & joint_state_msg = joint_state_msg_;
+  for (auto & group : joint_groups_)
+  {
+    // the groups take the values of the joints from the JointState message
+    auto & group_msg = group.msg;
+    group_msg.name.clear();
+    group_msg.position.clear();
+    group_msg.velocity.clear();
+    group_msg.effort.clear();
+    std::vector<size_t> group_joint_indices(joint_names_.size(), joint_names_.size());
+    for (const auto & joint_name : group.joint_names)
+    {
+      const auto joint_it = std::find(joint_names_.cbegin(), joint_names_.cend(), joint_name);
+      if (joint_it == joint_names_.cend())
+      {
+        RCLCPP_WARN(
+          get_node()->get_logger(),
+          "Joint '%s' of group '%s' has no position, velocity or effort state interface, "
+          "it is omitted from the group.",
+          joint_name.c_str(), group.name.c_str());
+        continue;
+      }
+      const auto joint_index = static_cast<size_t>(std::distance(joint_names_.cbegin(), joint_it));
+      group_joint_indices[joint_index] = group_msg.name.size();
+      group_msg.name.push_back(joint_name);
+      group_msg.position.push_back(joint_state_msg.position[joint_index]);
+      group_msg.velocity.push_back(joint_state_msg.velocity[joint_index]);
+      group_msg.effort.push_back(joint_state_msg.effort[joint_index]);
+    }
+
+    group.mapping.clear();
+    for (const auto & mapping : joint_state_mapping_)
+    {
+      const size_t group_joint_index = group_joint_indices[mapping.joint_index];
+      if (group_joint_index < group_msg.name.size())
+      {
+        group.mapping.push_back(
+          {mapping.state_interface_index, group_joint_index, mapping.value_index});
+      }
+    }
+  }
+}
+
+void JointStateBroadcaster::init_compact_joint_state_msgs()
+{
+  if (!compact_joint_state_publisher_)
+  {
+    return;
+  }
+
+  // the names are published once, the stream carries only the values in the same order
+  control_msgs::msg::DynamicJointState names_msg = dynamic_joint_state_msg_;
+  compact_joint_state_offsets_.clear();
+  size_t num_values = 0;
+  for (const auto & interface_value : names_msg.interface_values)
+  {
+    compact_joint_state_offsets_.push_back(num_values);
+    num_values += interface_value.interface_names.size();
+  }
+
+  // a message holds batch_size samples, each one with a header and the values
+  const auto batch_size = static_cast<size_t>(params_.compact_joint_states.batch_size);
+  compact_joint_state_sample_size_ = kCompactJointStateHeaderSize + num_values;
+  auto & compact_msg = compact_joint_state_msg_;
+  compact_msg.layout.dim.resize(2);
+  compact_msg.layout.dim[0].label = "samples";
+  compact_msg.layout.dim[0].size = static_cast<uint32_t>(batch_size);
+  compact_msg.layout.dim[0].stride =
+    static_cast<uint32_t>(batch_size * compact_joint_state_sample_size_);
+  compact_msg.layout.dim[1].label = "sample";
+  compact_msg.layout.dim[1].size = static_cast<uint32_t>(compact_joint_state_sample_size_);
+  compact_msg.layout.dim[1].stride = static_cast<uint32_t>(compact_joint_state_sample_size_);
+  compact_msg.layout.data_offset = 0;
+  compact_msg.data.assign(batch_size * compact_joint_state_sample_size_, 0.0);
+
+  // the samples are collected in a ring buffer of two batches, so that a batch isn't lost
+  // if the realtime publisher is busy when it is complete
+  std::vector<double> initial_sample(compact_joint_state_sample_size_, 0.0);
+  for (size_t joint_index = 0; joint_index < names_msg.interface_values.size(); ++joint_index)
+  {
+    // initial values, e.g., of extra joints
+    auto & values = names_msg.interface_values[joint_index].values;
+    std::copy(
+      values.cbegin(), values.cend(),
+      &initial_sample[kCompactJointStateHeaderSize + compact_joint_state_offsets_[joint_index]]);
+    values.clear();
+  }
+  compact_joint_state_samples_.clear();
+  for (size_t i = 0; i < 2 * batch_size; ++i)
+  {
+    compact_joint_state_samples_.insert(
+      compact_joint_state_samples_.end(), initial_sample.cbegin(), initial_sample.cend());
+  }
+  compact_joint_state_sequence_ = 0;
+  compact_joint_state_published_sequence_ = 0;
+
+  names_msg.header.stamp = get_node()->now();
+  compact_joint_state_names_publisher_->publish(names_msg);
+}
+
+void JointStateBroadcaster::init_realtime_publishers()
+{
+  // the initialized messages are the prototypes of all messages of the realtime publishers,
+  // so update() only overwrites values
+  realtime_joint_state_publisher_ =
+    std::make_shared<RealtimePublisher<sensor_msgs::msg::JointState>>(
+      joint_state_publisher_, joint_state_msg_,
+      joint_state_publish_period_.to_chrono<std::chrono::nanoseconds>());
+  realtime_dynamic_joint_state_publisher_ =
+    std::make_shared<RealtimePublisher<control_msgs::msg::DynamicJointState>>(
+      dynamic_joint_state_publisher_, dynamic_joint_state_msg_,
+      dynamic_joint_state_publish_period_.to_chrono<std::chrono::nanoseconds>());
+  for (auto & group : joint_groups_)
+  {
+    group.realtime_publisher = std::make_shared<RealtimePublisher<sensor_msgs::msg::JointState>>(
+      group.publisher, group.msg, group.publish_period.to_chrono<std::chrono::nanoseconds>());
+  }
+  if (compact_joint_state_publisher_)
+  {
+    realtime_compact_joint_state_publisher_ =
+      std::make_shared<RealtimePublisher<std_msgs::msg::Float64MultiArray>>(
+        compact_joint_state_publisher_, compact_joint_state_msg_);
+  }
+
+  // keep the publishing threads off the realtime CPUs
+  const auto scheduling = controller_realtime_tools::make_thread_scheduling(
+    params_.non_realtime_threads.priority, params_.non_realtime_threads.cpu_affinity);
+  bool scheduling_set = realtime_joint_state_publisher_->set_scheduling(scheduling) &&
+                        realtime_dynamic_joint_state_publisher_->set_scheduling(scheduling);
+  for (auto & group : joint_groups_)
+  {
+    scheduling_set = group.realtime_publisher->set_scheduling(scheduling) && scheduling_set;
+  }
+  if (realtime_compact_joint_state_publisher_)
+  {
+    scheduling_set =
+      realtime_compact_joint_state_publisher_->set_scheduling(scheduling) && scheduling_set;
+  }
+  if (!scheduling_set)
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(), "Could not set the scheduling of the publishing threads.");
+  }
+}
+
+void JointStateBroadcaster::prefault_memory()
+{
+  controller_realtime_tools::MemoryPrefaulter prefaulter;
+  prefaulter.set_label("state_interface_values");
+  prefaulter.add(state_interface_values_);
+  prefaulter.set_label("interface_value_mappings");
+  prefaulter.add(joint_state_mapping_);
+  prefaulter.add(dynamic_joint_state_mapping_);
+  prefaulter.set_label("velocity_estimators");
+  prefaulter.add(velocity_estimators_);
+  prefaulter.set_label("dynamic_joint_state_published_values");
+  prefaulter.add(dynamic_joint_state_published_values_);
+  prefaulter.set_label("compact_joint_state_samples");
+  prefaulter.add(compact_joint_state_offsets_);
+  prefaulter.add(compact_joint_state_samples_);
+
+  const auto add_joint_state = [&prefaulter](sensor_msgs::msg::JointState & msg)
+  {
+    prefaulter.add(msg.name);
+    prefaulter.add(msg.position);
+    prefaulter.add(msg.velocity);
+    prefaulter.add(msg.effort);
+  };
+  const auto add_dynamic_joint_state = [&prefaulter](control_msgs::msg::DynamicJointState & msg)
+  {
+    prefaulter.add(msg.joint_names);
+    prefaulter.add(msg.interface_values);
+    for (auto & values : msg.interface_values)
+    {
+      prefaulter.add(values.interface_names);
+      prefaulter.add(values.values);
+    }
+  };
+  const auto add_compact_joint_state = [&prefaulter](std_msgs::msg::Float64MultiArray & msg)
+  { prefaulter.add(msg.data); };
+
+  prefaulter.set_label("joint_state_msgs");
+  add_joint_state(joint_state_msg_);
+  if (realtime_joint_state_publisher_)
+  {
+    realtime_joint_state_publisher_->visit_messages(add_joint_state);
+  }
+  prefaulter.set_label("dynamic_joint_state_msgs");
+  add_dynamic_joint_state(dynamic_joint_state_msg_);
+  if (realtime_dynamic_joint_state_publisher_)
+  {
+    realtime_dynamic_joint_state_publisher_->visit_messages(add_dynamic_joint_state);
+  }
+  prefaulter.set_label("compact_joint_state_msgs");
+  add_compact_joint_state(compact_joint_state_msg_);
+  if (realtime_compact_joint_state_publisher_)
+  {
+    realtime_compact_joint_state_publisher_->visit_messages(add_compact_joint_state);
+  }
+  prefaulter.set_label("joint_group_msgs");
+  for (auto & group : joint_groups_)
+  {
+    add_joint_state(group.msg);
+    prefaulter.add(group.mapping);
+    if (group.realtime_publisher)
+    {
+      group.realtime_publisher->visit_messages(add_joint_state);
+    }
+  }
+
+  const size_t pages = prefaulter.prefault();
+  RCLCPP_DEBUG(
+    get_node()->get_logger(), "Prefaulted %zu pages of %zu preallocated bytes", pages,
+    prefaulter.size());
+  if (params_.lock_memory && !prefaulter.lock())
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(),
+      "Unable to lock the preallocated memory, check the RLIMIT_MEMLOCK of the process");
+  }
+
+  // besides the buffers of update(), the lookups by name built on activation
+  auto footprint = prefaulter.footprint();
+  footprint.emplace_back(
+    "name_lookups", controller_realtime_tools::heap_bytes(joint_names_) +
+                      controller_realtime_tools::heap_bytes(name_if_value_mapping_) +
+                      controller_realtime_tools::heap_bytes(map_interface_to_joint_state_));
+  std::lock_guard<std::mutex> guard(memory_footprint_mutex_);
+  memory_footprint_ = std::move(footprint);
+}
+
+void JointStateBroadcaster::get_memory_footprint(
+  const std::shared_ptr<std_srvs::srv::Trigger::Request> /*request*/,
+  std::shared_ptr<std_srvs::srv::Trigger::Response> response)
+{
+  std::lock_guard<std::mutex> guard(memory_footprint_mutex_);
+  if (memory_footprint_.empty())
+  {
+    response->success = false;
+    response->message = "Not activated yet";
+    return;
+  }
+  // fails once update() allocated, if the allocations are counted
+  response->success = allocation_counter_.allocations() == 0;
+  response->message =
+    controller_realtime_tools::format_memory_report(memory_footprint_, allocation_counter_);
+}
+
 bool JointStateBroadcaster::use_all_available_interfaces() const
 {
   return params_.joints.empty() || params_.interfaces.empty();
 }
 
-double get_value(
-  const std::unordered_map<std::string, std::unordered_map<std::string, double>> & map,
-  const std::string & name, const std::string & interface_name)
+bool JointStateBroadcaster::dynamic_joint_state_changed() const
 {
-  const auto & interfaces_and_values = map.at(name);
-  const auto interface_and_value = interfaces_and_values.find(interface_name);
-  if (interface_and_value != interfaces_and_values.cend())
+  if (!dynamic_joint_state_published_)
   {
-    return interface_and_value->second;
+    return true;
   }
-  else
+  for (size_t i = 0; i < dynamic_joint_state_mapping_.size(); ++i)
   {
-    return kUninitializedValue;
+    const double value =
+      state_interface_values_[dynamic_joint_state_mapping_[i].state_interface_index];
+    const double published_value = dynamic_joint_state_published_values_[i];
+    if (
+      std::isnan(value) != std::isnan(published_value) ||
+      std::abs(value - published_value) > params_.dynamic_joint_states.deadband)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void JointStateBroadcaster::update_dynamic_joint_state_subscription_count()
+{
+  dynamic_joint_state_has_subscribers_.store(
+    dynamic_joint_state_publisher_->get_subscription_count() > 0 ||
+    dynamic_joint_state_publisher_->get_intra_process_subscription_count() > 0);
+}
+
+void JointStateBroadcaster::estimate_velocities(double period)
+{
+  double * estimates = state_interface_values_.data() + state_interfaces_.size();
+  for (size_t i = 0; i < velocity_estimators_.size(); ++i)
+  {
+    auto & estimator = velocity_estimators_[i];
+    const double position = state_interface_values_[estimator.position_interface_index];
+    if (std::isnan(position) || std::isnan(estimator.previous_position))
+    {
+      // the estimate starts again with the next difference of valid positions
+      estimator.filter.reset();
+      estimator.previous_position = position;
+      estimates[i] = kUninitializedValue;
+    }
+    else if (period > 0.0)
+    {
+      estimates[i] = estimator.filter.filter((position - estimator.previous_position) / period);
+      estimator.previous_position = position;
+    }
   }
 }
 
 controller_interface::return_type JointStateBroadcaster::update(
-  const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
+  const rclcpp::Time & time, const rclcpp::Duration & period)
 {
-  for (const auto & state_interface : state_interfaces_)
+  controller_realtime_tools::ScopedAllocationCounting allocation_counting(allocation_counter_);
+  controller_realtime_tools::CycleBudget::Scope cycle_budget_scope(cycle_budget_.get());
+  for (size_t i = 0; i < state_interfaces_.size(); ++i)
   {
-    std::string interface_name = state_interface.get_interface_name();
-    if (map_interface_to_joint_state_.count(interface_name) > 0)
+    state_interface_values_[i] = state_interfaces_[i].get_value();
+    CONTROLLER_RT_DEBUG(
+      get_node()->get_logger(), "%s: %f", state_interfaces_[i].get_name().c_str(),
+      state_interface_values_[i]);
+  }
+
+  double sample_period = period.seconds();
+  if (params_.new_sample_detection.enable)
+  {
+    // the updates between two samples of the hardware publish nothing
+    new_sample_period_ += sample_period;
+    const bool new_sample =
+      new_sample_sequence_index_ < state_interfaces_.size()
+        ? new_sample_detector_.is_new(state_interface_values_[new_sample_sequence_index_])
+        : new_sample_detector_.is_new(state_interface_values_.data());
+    if (!new_sample)
     {
-      interface_name = map_interface_to_joint_state_[interface_name];
+      return controller_interface::return_type::OK;
     }
-    name_if_value_mapping_[state_interface.get_prefix_name()][interface_name] =
-      state_interface.get_value();
-    RCLCPP_DEBUG(
-      get_node()->get_logger(), "%s: %f\n", state_interface.get_name().c_str(),
-      state_interface.get_value());
+    sample_period = new_sample_period_;
+    new_sample_period_ = 0.0;
+  }
+  if (!velocity_estimators_.empty())
+  {
+    estimate_velocities(sample_period);
   }
 
-  if (realtime_joint_state_publisher_ && realtime_joint_state_publisher_->trylock())
+  if (
+    realtime_joint_state_publisher_ && realtime_joint_state_publisher_->is_due(time.nanoseconds()))
   {
-    auto & joint_state_msg = realtime_joint_state_publisher_->msg_;
+    joint_state_msg_.header.stamp = time;
 
-    joint_state_msg.header.stamp = time;
+    // same order as the value_index of the mapping
+    std::vector<double> * fields[] = {
+      &joint_state_msg_.position, &joint_state_msg_.velocity, &joint_state_msg_.effort};
+    for (const auto & mapping : joint_state_mapping_)
+    {
+      (*fields[mapping.value_index])[mapping.joint_index] =
+        state_interface_values_[mapping.state_interface_index];
+    }
+    realtime_joint_state_publisher_->try_publish(joint_state_msg_, time.nanoseconds());
+  }
 
-    // update joint state message and dynamic joint state message
-    for (size_t i = 0; i < joint_names_.size(); ++i)
+  for (auto & group : joint_groups_)
+  {
+    if (
+      group.realtime_publisher && group.realtime_publisher->is_due(time.nanoseconds()) &&
+      !(cycle_budget_ && cycle_budget_->skip(SHED_JOINT_GROUPS)))
     {
-      joint_state_msg.position[i] =
-        get_value(name_if_value_mapping_, joint_names_[i], HW_IF_POSITION);
-      joint_state_msg.velocity[i] =
-        get_value(name_if_value_mapping_, joint_names_[i], HW_IF_VELOCITY);
-      joint_state_msg.effort[i] = get_value(name_if_value_mapping_, joint_names_[i], HW_IF_EFFORT);
+      auto & group_msg = group.msg;
+      group_msg.header.stamp = time;
+      std::vector<double> * fields[] = {
+        &group_msg.position, &group_msg.velocity, &group_msg.effort};
+      for (const auto & mapping : group.mapping)
+      {
+        (*fields[mapping.value_index])[mapping.joint_index] =
+          state_interface_values_[mapping.state_interface_index];
+      }
+      group.realtime_publisher->try_publish(group_msg, time.nanoseconds());
     }
-    realtime_joint_state_publisher_->unlockAndPublish();
   }
 
-  if (realtime_dynamic_joint_state_publisher_ && realtime_dynamic_joint_state_publisher_->trylock())
+  if (!dynamic_joint_state_has_subscribers_.load(std::memory_order_relaxed))
   {
-    auto & dynamic_joint_state_msg = realtime_dynamic_joint_state_publisher_->msg_;
+    // a new subscriber gets the current values, even if they didn't change
+    dynamic_joint_state_published_ = false;
+  }
+  else if (
+    realtime_dynamic_joint_state_publisher_ &&
+    realtime_dynamic_joint_state_publisher_->is_due(time.nanoseconds()) &&
+    (!params_.dynamic_joint_states.publish_on_change || dynamic_joint_state_changed()) &&
+    !(cycle_budget_ && cycle_budget_->skip(SHED_DYNAMIC_JOINT_STATES)))
+  {
+    auto & dynamic_joint_state_msg = dynamic_joint_state_msg_;
     dynamic_joint_state_msg.header.stamp = time;
-    for (size_t joint_index = 0; joint_index < dynamic_joint_state_msg.joint_names.size();
-         ++joint_index)
-    {
-      const auto & name = dynamic_joint_state_msg.joint_names[joint_index];
-      for (size_t interface_index = 0;
-           interface_index <
-           dynamic_joint_state_msg.interface_values[joint_index].interface_names.size();
-           ++interface_index)
+    for (size_t i = 0; i < dynamic_joint_state_mapping_.size(); ++i)
+    {
+      const auto & mapping = dynamic_joint_state_mapping_[i];
+      const double value = state_interface_values_[mapping.state_interface_index];
+      dynamic_joint_state_msg.interface_values[mapping.joint_index].values[mapping.value_index] =
+        value;
+      dynamic_joint_state_published_values_[i] = value;
+    }
+    // if the publisher is busy, the change is still there in the next update
+    dynamic_joint_state_published_ = realtime_dynamic_joint_state_publisher_->try_publish(
+      dynamic_joint_state_msg, time.nanoseconds());
+  }
+
+  if (realtime_compact_joint_state_publisher_)
+  {
+    const size_t sample_size = compact_joint_state_sample_size_;
+    const size_t capacity = compact_joint_state_samples_.size() / sample_size;
+    double * sample =
+      &compact_joint_state_samples_[(compact_joint_state_sequence_ % capacity) * sample_size];
+    ++compact_joint_state_sequence_;
+
+    // all of them are exact in a double
+    const builtin_interfaces::msg::Time stamp = time;
+    sample[0] = static_cast<double>(compact_joint_state_sequence_);
+    sample[1] = static_cast<double>(stamp.sec);
+    sample[2] = static_cast<double>(stamp.nanosec);
+    for (const auto & mapping : dynamic_joint_state_mapping_)
+    {
+      const size_t value_index = kCompactJointStateHeaderSize +
+                                 compact_joint_state_offsets_[mapping.joint_index] +
+                                 mapping.value_index;
+      sample[value_index] = state_interface_values_[mapping.state_interface_index];
+    }
+
+    // the oldest samples are overwritten if the publisher stays busy
+    if (compact_joint_state_sequence_ - compact_joint_state_published_sequence_ > capacity)
+    {
+      compact_joint_state_published_sequence_ = compact_joint_state_sequence_ - capacity;
+    }
+
+    const auto batch_size = static_cast<size_t>(params_.compact_joint_states.batch_size);
+    if (compact_joint_state_sequence_ - compact_joint_state_published_sequence_ >= batch_size)
+    {
+      auto & data = compact_joint_state_msg_.data;
+      for (size_t i = 0; i < batch_size; ++i)
+      {
+        const size_t slot = (compact_joint_state_published_sequence_ + i) % capacity;
+        std::copy_n(
+          &compact_joint_state_samples_[slot * sample_size], sample_size, &data[i * sample_size]);
+      }
+      if (realtime_compact_joint_state_publisher_->try_publish(compact_joint_state_msg_))
       {
-        const auto & interface_name =
-          dynamic_joint_state_msg.interface_values[joint_index].interface_names[interface_index];
-        dynamic_joint_state_msg.interface_values[joint_index].values[interface_index] =
-          name_if_value_mapping_[name][interface_name];
+        compact_joint_state_published_sequence_ += batch_size;
       }
     }
-    realtime_dynamic_joint_state_publisher_->unlockAndPublish();
   }
 
   return controller_interface::return_type::OK;
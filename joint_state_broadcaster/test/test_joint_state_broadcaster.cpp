@@ -14,9 +14,12 @@
 
 #include <stddef.h>
 
+#include <chrono>
+#include <cmath>
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -45,6 +48,52 @@ namespace
 {
 constexpr auto NODE_SUCCESS = controller_interface::CallbackReturn::SUCCESS;
 constexpr auto NODE_ERROR = controller_interface::CallbackReturn::ERROR;
+// long enough for a published message to arrive
+constexpr auto NO_MESSAGE_TIMEOUT = std::chrono::milliseconds(100);
+
+// Subscribes to a topic of the broadcaster, to check the messages it published
+template <typename MessageT>
+class TopicListener
+{
+public:
+  TopicListener(const std::string & topic, const rclcpp::PublisherBase & publisher)
+  : node_("test_listener_node")
+  {
+    subscription_ = node_.create_subscription<MessageT>(
+      topic, 10, [](const std::shared_ptr<MessageT>) {});
+    wait_set_.add_subscription(subscription_);
+    // messages published before the subscription is matched are lost
+    const auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (publisher.get_subscription_count() == 0 && std::chrono::steady_clock::now() < end_time)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  /// Take the latest of the messages received since the previous call, false if none is
+  /// received within \p timeout.
+  bool take_latest(
+    MessageT & msg, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000))
+  {
+    bool taken = false;
+    while (wait_set_.wait(taken ? std::chrono::milliseconds(10) : timeout).kind() ==
+           rclcpp::WaitResultKind::Ready)
+    {
+      rclcpp::MessageInfo msg_info;
+      if (!subscription_->take(msg, msg_info))
+      {
+        break;
+      }
+      taken = true;
+    }
+    return taken;
+  }
+
+private:
+  rclcpp::Node node_;
+  typename rclcpp::Subscription<MessageT>::SharedPtr subscription_;
+  rclcpp::WaitSet wait_set_;
+};
 }  // namespace
 
 void JointStateBroadcasterTest::SetUpTestCase() { rclcpp::init(0, nullptr); }
@@ -182,15 +231,14 @@ TEST_F(JointStateBroadcasterTest, ActivateTest)
   ASSERT_TRUE(state_broadcaster_->realtime_dynamic_joint_state_publisher_);
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(joint_names_));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.effort, SizeIs(NUM_JOINTS));
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(joint_names_));
@@ -223,15 +271,14 @@ TEST_F(JointStateBroadcasterTest, ActivateTestWithoutJointsParameter)
   ASSERT_TRUE(state_broadcaster_->realtime_dynamic_joint_state_publisher_);
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(joint_names_));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.effort, SizeIs(NUM_JOINTS));
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(joint_names_));
@@ -264,15 +311,14 @@ TEST_F(JointStateBroadcasterTest, ActivateTestWithoutInterfacesParameter)
   ASSERT_TRUE(state_broadcaster_->realtime_dynamic_joint_state_publisher_);
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(joint_names_));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.effort, SizeIs(NUM_JOINTS));
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(joint_names_));
@@ -305,7 +351,7 @@ TEST_F(JointStateBroadcasterTest, ActivateTestTwoJointsOneInterface)
   ASSERT_TRUE(state_broadcaster_->realtime_dynamic_joint_state_publisher_);
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(JOINT_NAMES));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
@@ -320,8 +366,7 @@ TEST_F(JointStateBroadcasterTest, ActivateTestTwoJointsOneInterface)
   }
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(JOINT_NAMES));
@@ -349,7 +394,7 @@ TEST_F(JointStateBroadcasterTest, ActivateTestOneJointTwoInterfaces)
   ASSERT_TRUE(state_broadcaster_->realtime_dynamic_joint_state_publisher_);
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(JOINT_NAMES));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
@@ -360,8 +405,7 @@ TEST_F(JointStateBroadcasterTest, ActivateTestOneJointTwoInterfaces)
   }
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(JOINT_NAMES));
@@ -417,7 +461,7 @@ TEST_F(JointStateBroadcasterTest, ActivateTestTwoJointTwoInterfacesOneMissing)
   ASSERT_TRUE(state_broadcaster_->realtime_dynamic_joint_state_publisher_);
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(JOINT_NAMES));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
@@ -430,8 +474,7 @@ TEST_F(JointStateBroadcasterTest, ActivateTestTwoJointTwoInterfacesOneMissing)
   }
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(JOINT_NAMES));
@@ -456,15 +499,14 @@ TEST_F(JointStateBroadcasterTest, TestCustomInterfaceWithoutMapping)
   const size_t NUM_JOINTS = JOINT_NAMES.size();
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, SizeIs(0));
   ASSERT_THAT(joint_state_msg.position, SizeIs(0));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(0));
   ASSERT_THAT(joint_state_msg.effort, SizeIs(0));
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(JOINT_NAMES));
@@ -493,7 +535,7 @@ TEST_F(JointStateBroadcasterTest, TestCustomInterfaceMapping)
   const size_t NUM_JOINTS = JOINT_NAMES.size();
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(JOINT_NAMES));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
@@ -508,8 +550,7 @@ TEST_F(JointStateBroadcasterTest, TestCustomInterfaceMapping)
   }
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(JOINT_NAMES));
@@ -536,14 +577,17 @@ TEST_F(JointStateBroadcasterTest, TestCustomInterfaceMappingUpdate)
 
   ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
 
+  TopicListener<sensor_msgs::msg::JointState> joint_states(
+    "joint_states", *state_broadcaster_->joint_state_publisher_);
   ASSERT_EQ(
     state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
     controller_interface::return_type::OK);
 
   const size_t NUM_JOINTS = JOINT_NAMES.size();
 
-  // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  // joint state published
+  sensor_msgs::msg::JointState joint_state_msg;
+  ASSERT_TRUE(joint_states.take_latest(joint_state_msg));
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(JOINT_NAMES));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_EQ(joint_state_msg.position[0], custom_joint_value_);
@@ -559,8 +603,7 @@ TEST_F(JointStateBroadcasterTest, TestCustomInterfaceMappingUpdate)
   }
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(JOINT_NAMES));
@@ -585,6 +628,50 @@ TEST_F(JointStateBroadcasterTest, UpdateTest)
     controller_interface::return_type::OK);
 }
 
+TEST_F(JointStateBroadcasterTest, UpdateCopiesValuesAfterReactivationTest)
+{
+  SetUpStateBroadcaster();
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_deactivate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  TopicListener<sensor_msgs::msg::JointState> joint_states(
+    "joint_states", *state_broadcaster_->joint_state_publisher_);
+  TopicListener<control_msgs::msg::DynamicJointState> dynamic_joint_states(
+    "dynamic_joint_states", *state_broadcaster_->dynamic_joint_state_publisher_);
+
+  // the state interfaces point to these values
+  for (auto & value : joint_values_)
+  {
+    value += 1.0;
+  }
+  ASSERT_EQ(
+    state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+
+  const size_t NUM_JOINTS = joint_names_.size();
+
+  // for test purposes all interfaces of a joint are mapped to the same double
+  sensor_msgs::msg::JointState joint_state_msg;
+  ASSERT_TRUE(joint_states.take_latest(joint_state_msg));
+  ASSERT_THAT(joint_state_msg.name, ElementsAreArray(joint_names_));
+  ASSERT_THAT(joint_state_msg.position, ElementsAreArray(joint_values_));
+  ASSERT_THAT(joint_state_msg.velocity, ElementsAreArray(joint_values_));
+  ASSERT_THAT(joint_state_msg.effort, ElementsAreArray(joint_values_));
+
+  // reactivation doesn't add the joints again
+  control_msgs::msg::DynamicJointState dynamic_joint_state_msg;
+  ASSERT_TRUE(dynamic_joint_states.take_latest(dynamic_joint_state_msg));
+  ASSERT_THAT(dynamic_joint_state_msg.joint_names, ElementsAreArray(joint_names_));
+  ASSERT_THAT(dynamic_joint_state_msg.interface_values, SizeIs(NUM_JOINTS));
+  for (size_t i = 0; i < NUM_JOINTS; ++i)
+  {
+    ASSERT_THAT(dynamic_joint_state_msg.interface_values[i].values, Each(joint_values_[i]));
+  }
+}
+
 void JointStateBroadcasterTest::test_published_joint_state_message(const std::string & topic)
 {
   auto node_state = state_broadcaster_->get_node()->configure();
@@ -741,14 +828,423 @@ TEST_F(JointStateBroadcasterTest, ExtraJointStatePublishTest)
   const size_t NUM_JOINTS = all_joint_names.size();
 
   // joint state initialized
-  const auto & joint_state_msg = state_broadcaster_->realtime_joint_state_publisher_->msg_;
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
   ASSERT_THAT(joint_state_msg.name, ElementsAreArray(all_joint_names));
   ASSERT_THAT(joint_state_msg.position, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.velocity, SizeIs(NUM_JOINTS));
   ASSERT_THAT(joint_state_msg.effort, SizeIs(NUM_JOINTS));
 
   // dynamic joint state initialized
-  const auto & dynamic_joint_state_msg =
-    state_broadcaster_->realtime_dynamic_joint_state_publisher_->msg_;
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
   ASSERT_THAT(dynamic_joint_state_msg.joint_names, SizeIs(NUM_JOINTS));
 }
+
+TEST_F(JointStateBroadcasterTest, PublishRateTest)
+{
+  SetUpStateBroadcaster();
+  state_broadcaster_->get_node()->set_parameter({"joint_states.publish_rate", 10.0});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  TopicListener<sensor_msgs::msg::JointState> joint_states(
+    "joint_states", *state_broadcaster_->joint_state_publisher_);
+  TopicListener<control_msgs::msg::DynamicJointState> dynamic_joint_states(
+    "dynamic_joint_states", *state_broadcaster_->dynamic_joint_state_publisher_);
+  sensor_msgs::msg::JointState joint_state_msg;
+  control_msgs::msg::DynamicJointState dynamic_joint_state_msg;
+  const auto update_at = [&](int64_t nanoseconds)
+  {
+    ASSERT_EQ(
+      state_broadcaster_->update(
+        rclcpp::Time(nanoseconds, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  update_at(100000000);
+  ASSERT_TRUE(joint_states.take_latest(joint_state_msg));
+  EXPECT_EQ(rclcpp::Time(joint_state_msg.header.stamp).nanoseconds(), 100000000);
+  ASSERT_TRUE(dynamic_joint_states.take_latest(dynamic_joint_state_msg));
+
+  // not due, only the dynamic joint states are published on every update
+  update_at(150000000);
+  ASSERT_TRUE(dynamic_joint_states.take_latest(dynamic_joint_state_msg));
+  EXPECT_EQ(rclcpp::Time(dynamic_joint_state_msg.header.stamp).nanoseconds(), 150000000);
+  EXPECT_FALSE(joint_states.take_latest(joint_state_msg, NO_MESSAGE_TIMEOUT));
+
+  update_at(200000000);
+  ASSERT_TRUE(joint_states.take_latest(joint_state_msg));
+  EXPECT_EQ(rclcpp::Time(joint_state_msg.header.stamp).nanoseconds(), 200000000);
+}
+
+TEST_F(JointStateBroadcasterTest, DynamicJointStatePublishOnChangeTest)
+{
+  SetUpStateBroadcaster();
+  state_broadcaster_->get_node()->set_parameter({"dynamic_joint_states.publish_on_change", true});
+  state_broadcaster_->get_node()->set_parameter({"dynamic_joint_states.deadband", 0.5});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  TopicListener<control_msgs::msg::DynamicJointState> dynamic_joint_states(
+    "dynamic_joint_states", *state_broadcaster_->dynamic_joint_state_publisher_);
+  control_msgs::msg::DynamicJointState dynamic_joint_state_msg;
+  const auto update_at = [&](int64_t nanoseconds)
+  {
+    ASSERT_EQ(
+      state_broadcaster_->update(
+        rclcpp::Time(nanoseconds, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  // the first message is always published
+  update_at(1);
+  ASSERT_TRUE(dynamic_joint_states.take_latest(dynamic_joint_state_msg));
+  EXPECT_EQ(rclcpp::Time(dynamic_joint_state_msg.header.stamp).nanoseconds(), 1);
+
+  // within the deadband
+  joint_values_[0] += 0.4;
+  update_at(2);
+  EXPECT_FALSE(dynamic_joint_states.take_latest(dynamic_joint_state_msg, NO_MESSAGE_TIMEOUT));
+
+  // the change is taken from the published value
+  joint_values_[0] += 0.4;
+  update_at(3);
+  ASSERT_TRUE(dynamic_joint_states.take_latest(dynamic_joint_state_msg));
+  EXPECT_EQ(rclcpp::Time(dynamic_joint_state_msg.header.stamp).nanoseconds(), 3);
+  ASSERT_THAT(dynamic_joint_state_msg.interface_values[0].values, Each(joint_values_[0]));
+}
+
+TEST_F(JointStateBroadcasterTest, JointGroupPublishTest)
+{
+  SetUpStateBroadcaster();
+  auto node = state_broadcaster_->get_node();
+  node->set_parameter({"joint_groups", std::vector<std::string>{"arm", "gripper"}});
+  state_broadcaster_->param_listener_->declare_params();
+  node->set_parameter(
+    {"groups.arm.joints", std::vector<std::string>{joint_names_[2], joint_names_[0], "unknown"}});
+  node->set_parameter({"groups.gripper.joints", std::vector<std::string>{joint_names_[1]}});
+  node->set_parameter({"groups.gripper.publish_rate", 10.0});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  ASSERT_THAT(state_broadcaster_->joint_groups_, SizeIs(2));
+  auto & arm = state_broadcaster_->joint_groups_[0];
+  auto & gripper = state_broadcaster_->joint_groups_[1];
+  EXPECT_EQ(arm.publisher->get_topic_name(), std::string("/joint_states/arm"));
+  EXPECT_EQ(gripper.publisher->get_topic_name(), std::string("/joint_states/gripper"));
+
+  // the group keeps its order of the joints, unknown joints are omitted
+  ASSERT_THAT(arm.msg.name, ElementsAreArray({joint_names_[2], joint_names_[0]}));
+
+  TopicListener<sensor_msgs::msg::JointState> arm_joint_states("joint_states/arm", *arm.publisher);
+  TopicListener<sensor_msgs::msg::JointState> gripper_joint_states(
+    "joint_states/gripper", *gripper.publisher);
+  sensor_msgs::msg::JointState arm_msg;
+  sensor_msgs::msg::JointState gripper_msg;
+  const auto update_at = [&](int64_t nanoseconds)
+  {
+    ASSERT_EQ(
+      state_broadcaster_->update(
+        rclcpp::Time(nanoseconds, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  update_at(100000000);
+  // for test purposes all interfaces of a joint are mapped to the same double
+  ASSERT_TRUE(arm_joint_states.take_latest(arm_msg));
+  ASSERT_THAT(arm_msg.name, ElementsAreArray({joint_names_[2], joint_names_[0]}));
+  ASSERT_THAT(arm_msg.position, ElementsAreArray({joint_values_[2], joint_values_[0]}));
+  ASSERT_THAT(arm_msg.velocity, ElementsAreArray(arm_msg.position));
+  ASSERT_THAT(arm_msg.effort, ElementsAreArray(arm_msg.position));
+  ASSERT_TRUE(gripper_joint_states.take_latest(gripper_msg));
+  ASSERT_THAT(gripper_msg.position, ElementsAreArray({joint_values_[1]}));
+
+  // only the arm is published on every update
+  joint_values_[1] += 1.0;
+  joint_values_[2] += 1.0;
+  update_at(150000000);
+  ASSERT_TRUE(arm_joint_states.take_latest(arm_msg));
+  EXPECT_EQ(rclcpp::Time(arm_msg.header.stamp).nanoseconds(), 150000000);
+  EXPECT_EQ(arm_msg.position[0], joint_values_[2]);
+  EXPECT_FALSE(gripper_joint_states.take_latest(gripper_msg, NO_MESSAGE_TIMEOUT));
+}
+
+TEST_F(JointStateBroadcasterTest, DynamicJointStatePublishOnlyWithSubscribersTest)
+{
+  SetUpStateBroadcaster();
+  state_broadcaster_->get_node()->set_parameter(
+    {"dynamic_joint_states.publish_only_with_subscribers", true});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  TopicListener<sensor_msgs::msg::JointState> joint_states(
+    "joint_states", *state_broadcaster_->joint_state_publisher_);
+  const auto update_at = [&](int64_t nanoseconds)
+  {
+    ASSERT_EQ(
+      state_broadcaster_->update(
+        rclcpp::Time(nanoseconds, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  // nobody subscribes, the message is not even filled
+  update_at(1);
+  const auto & unpublished_msg = state_broadcaster_->dynamic_joint_state_msg_;
+  EXPECT_EQ(rclcpp::Time(unpublished_msg.header.stamp).nanoseconds(), 0);
+  ASSERT_TRUE(std::isnan(unpublished_msg.interface_values[0].values[0]));
+  EXPECT_EQ(state_broadcaster_->realtime_dynamic_joint_state_publisher_->published(), 0u);
+
+  TopicListener<control_msgs::msg::DynamicJointState> dynamic_joint_states(
+    "dynamic_joint_states", *state_broadcaster_->dynamic_joint_state_publisher_);
+  // the count is sampled by a timer callback, which isn't spun by this test
+  state_broadcaster_->update_dynamic_joint_state_subscription_count();
+
+  update_at(2);
+  control_msgs::msg::DynamicJointState dynamic_joint_state_msg;
+  ASSERT_TRUE(dynamic_joint_states.take_latest(dynamic_joint_state_msg));
+  EXPECT_EQ(rclcpp::Time(dynamic_joint_state_msg.header.stamp).nanoseconds(), 2);
+  ASSERT_THAT(dynamic_joint_state_msg.interface_values[0].values, Each(joint_values_[0]));
+
+  // the joint states are published regardless
+  sensor_msgs::msg::JointState joint_state_msg;
+  ASSERT_TRUE(joint_states.take_latest(joint_state_msg));
+  EXPECT_EQ(rclcpp::Time(joint_state_msg.header.stamp).nanoseconds(), 2);
+}
+
+TEST_F(JointStateBroadcasterTest, CompactJointStatePublishTest)
+{
+  SetUpStateBroadcaster();
+  state_broadcaster_->get_node()->set_parameter({"compact_joint_states.enable", true});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  // the names are latched
+  rclcpp::Node test_node("test_node");
+  auto subscription = test_node.create_subscription<control_msgs::msg::DynamicJointState>(
+    "compact_joint_states/names", rclcpp::QoS(1).transient_local(),
+    [](const control_msgs::msg::DynamicJointState::SharedPtr) {});
+  rclcpp::WaitSet wait_set;
+  wait_set.add_subscription(subscription);
+  ASSERT_EQ(wait_set.wait(std::chrono::seconds(1)).kind(), rclcpp::WaitResultKind::Ready);
+  control_msgs::msg::DynamicJointState names_msg;
+  rclcpp::MessageInfo msg_info;
+  ASSERT_TRUE(subscription->take(names_msg, msg_info));
+
+  const auto & dynamic_joint_state_msg = state_broadcaster_->dynamic_joint_state_msg_;
+  ASSERT_THAT(names_msg.joint_names, ElementsAreArray(dynamic_joint_state_msg.joint_names));
+  ASSERT_THAT(names_msg.interface_values, SizeIs(joint_names_.size()));
+  for (const auto & interface_value : names_msg.interface_values)
+  {
+    ASSERT_THAT(interface_value.interface_names, ElementsAreArray(interface_names_));
+    ASSERT_THAT(interface_value.values, IsEmpty());
+  }
+
+  TopicListener<std_msgs::msg::Float64MultiArray> compact_joint_states(
+    "compact_joint_states", *state_broadcaster_->compact_joint_state_publisher_);
+  for (const int64_t nanoseconds : {int64_t{1500000000}, int64_t{2500000001}})
+  {
+    ASSERT_EQ(
+      state_broadcaster_->update(
+        rclcpp::Time(nanoseconds, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  }
+  std_msgs::msg::Float64MultiArray compact_msg;
+  ASSERT_TRUE(compact_joint_states.take_latest(compact_msg));
+
+  // sequence number and stamp, followed by the values in the order of the names
+  ASSERT_THAT(compact_msg.layout.dim, SizeIs(2));
+  ASSERT_EQ(compact_msg.layout.dim[0].size, 1u);
+  ASSERT_EQ(compact_msg.layout.dim[1].size, 3 + joint_names_.size() * interface_names_.size());
+  ASSERT_THAT(compact_msg.data, SizeIs(3 + joint_names_.size() * interface_names_.size()));
+  EXPECT_EQ(compact_msg.data[0], 2.0);
+  EXPECT_EQ(compact_msg.data[1], 2.0);
+  EXPECT_EQ(compact_msg.data[2], 500000001.0);
+  for (size_t joint = 0; joint < joint_names_.size(); ++joint)
+  {
+    for (size_t interface = 0; interface < interface_names_.size(); ++interface)
+    {
+      // for test purposes all interfaces of a joint are mapped to the same double
+      EXPECT_EQ(
+        compact_msg.data[3 + joint * interface_names_.size() + interface], joint_values_[joint]);
+    }
+  }
+}
+
+TEST_F(JointStateBroadcasterTest, CompactJointStateBatchTest)
+{
+  SetUpStateBroadcaster();
+  state_broadcaster_->get_node()->set_parameter({"compact_joint_states.enable", true});
+  state_broadcaster_->get_node()->set_parameter({"compact_joint_states.batch_size", 3});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  const auto & initial_msg = state_broadcaster_->compact_joint_state_msg_;
+  const size_t sample_size = 3 + joint_names_.size() * interface_names_.size();
+  ASSERT_THAT(initial_msg.layout.dim, SizeIs(2));
+  ASSERT_EQ(initial_msg.layout.dim[0].size, 3u);
+  ASSERT_EQ(initial_msg.layout.dim[1].size, sample_size);
+  ASSERT_THAT(initial_msg.data, SizeIs(3 * sample_size));
+
+  TopicListener<std_msgs::msg::Float64MultiArray> compact_joint_states(
+    "compact_joint_states", *state_broadcaster_->compact_joint_state_publisher_);
+  std_msgs::msg::Float64MultiArray compact_msg;
+  std::vector<double> sampled_values;
+  const auto update = [&]()
+  {
+    joint_values_[0] += 1.0;
+    sampled_values.push_back(joint_values_[0]);
+    ASSERT_EQ(
+      state_broadcaster_->update(
+        rclcpp::Time(0, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  };
+
+  for (int i = 0; i < 5; ++i)
+  {
+    update();
+  }
+  // the second batch isn't complete yet, the first batch has all samples of its updates
+  ASSERT_TRUE(compact_joint_states.take_latest(compact_msg));
+  for (size_t i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(compact_msg.data[i * sample_size], static_cast<double>(i + 1));
+    EXPECT_EQ(compact_msg.data[i * sample_size + 3], sampled_values[i]);
+  }
+
+  update();
+  ASSERT_TRUE(compact_joint_states.take_latest(compact_msg));
+  for (size_t i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(compact_msg.data[i * sample_size], static_cast<double>(i + 4));
+  }
+}
+
+TEST_F(JointStateBroadcasterTest, VelocityEstimationTest)
+{
+  const std::vector<std::string> joint_names = {joint_names_[0], joint_names_[1]};
+  const std::vector<std::string> interfaces = {HW_IF_POSITION};
+  SetUpStateBroadcaster(joint_names, interfaces);
+  auto node = state_broadcaster_->get_node();
+  node->set_parameter({"velocity_estimation.enable", true});
+  node->set_parameter({"velocity_estimation.cutoff_frequency", 600.0});
+  node->set_parameter({"velocity_estimation.sampling_frequency", 1000.0});
+
+  // the cutoff frequency has to be below half of the sampling frequency
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+
+  node->set_parameter({"velocity_estimation.cutoff_frequency", 10.0});
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_THAT(state_broadcaster_->velocity_estimators_, SizeIs(2));
+  // the dynamic joint states carry only the state interfaces
+  ASSERT_THAT(state_broadcaster_->dynamic_joint_state_mapping_, SizeIs(2));
+
+  const auto & joint_state_msg = state_broadcaster_->joint_state_msg_;
+  int64_t nanoseconds = 0;
+  const auto update = [&]()
+  {
+    nanoseconds += 1000000;
+    ASSERT_EQ(
+      state_broadcaster_->update(
+        rclcpp::Time(nanoseconds, RCL_ROS_TIME), rclcpp::Duration::from_seconds(0.001)),
+      controller_interface::return_type::OK);
+  };
+
+  // no difference of positions yet
+  update();
+  EXPECT_TRUE(std::isnan(joint_state_msg.velocity[0]));
+  EXPECT_TRUE(std::isnan(joint_state_msg.velocity[1]));
+  update();
+  EXPECT_DOUBLE_EQ(joint_state_msg.velocity[0], 0.0);
+
+  // a step of the velocity of joint 1 to 1.0 is smoothed
+  joint_values_[0] += 0.001;
+  update();
+  EXPECT_GT(joint_state_msg.velocity[0], 0.0);
+  EXPECT_LT(joint_state_msg.velocity[0], 0.1);
+  for (int i = 0; i < 1000; ++i)
+  {
+    joint_values_[0] += 0.001;
+    update();
+  }
+  EXPECT_NEAR(joint_state_msg.velocity[0], 1.0, 1e-6);
+  EXPECT_NEAR(joint_state_msg.velocity[1], 0.0, 1e-12);
+  EXPECT_DOUBLE_EQ(joint_state_msg.position[0], joint_values_[0]);
+}
+
+TEST_F(JointStateBroadcasterTest, NewSampleDetectionTest)
+{
+  SetUpStateBroadcaster({joint_names_[0], joint_names_[1]}, {HW_IF_POSITION});
+  auto node = state_broadcaster_->get_node();
+  node->set_parameter({"new_sample_detection.enable", true});
+  node->set_parameter({"new_sample_detection.sequence_interface", "unknown/sequence"});
+  // numbers the samples which are published
+  node->set_parameter({"compact_joint_states.enable", true});
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  // the sequence interface has to be claimed by the broadcaster
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_ERROR);
+
+  const auto update = [&]()
+  {
+    ASSERT_EQ(
+      state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.001)),
+      controller_interface::return_type::OK);
+  };
+
+  // without a sequence interface, any changed value is a new sample
+  node->set_parameter({"new_sample_detection.sequence_interface", ""});
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  update();
+  EXPECT_EQ(state_broadcaster_->compact_joint_state_sequence_, 1u);
+  update();
+  EXPECT_EQ(state_broadcaster_->compact_joint_state_sequence_, 1u);
+  joint_values_[0] += 0.1;
+  update();
+  EXPECT_EQ(state_broadcaster_->compact_joint_state_sequence_, 2u);
+
+  // with a sequence interface, only its changes are new samples
+  const std::string sequence_interface = joint_names_[1] + "/" + HW_IF_POSITION;
+  node->set_parameter({"new_sample_detection.sequence_interface", sequence_interface});
+  ASSERT_EQ(state_broadcaster_->on_deactivate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  update();
+  EXPECT_EQ(state_broadcaster_->compact_joint_state_sequence_, 1u);
+  joint_values_[0] += 0.1;
+  update();
+  EXPECT_EQ(state_broadcaster_->compact_joint_state_sequence_, 1u);
+  joint_values_[1] += 0.1;
+  update();
+  EXPECT_EQ(state_broadcaster_->compact_joint_state_sequence_, 2u);
+}
+
+TEST_F(JointStateBroadcasterTest, MemoryFootprintTest)
+{
+  SetUpStateBroadcaster({joint_names_[0], joint_names_[1]}, {HW_IF_POSITION, HW_IF_VELOCITY});
+  auto request = std::make_shared<std_srvs::srv::Trigger::Request>();
+  auto response = std::make_shared<std_srvs::srv::Trigger::Response>();
+
+  ASSERT_EQ(state_broadcaster_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  // recorded on activation
+  state_broadcaster_->get_memory_footprint(request, response);
+  EXPECT_FALSE(response->success);
+
+  ASSERT_EQ(state_broadcaster_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_EQ(
+    state_broadcaster_->update(rclcpp::Time(0), rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  state_broadcaster_->get_memory_footprint(request, response);
+  // the allocations aren't counted without the preloaded library
+  EXPECT_TRUE(response->success);
+  EXPECT_THAT(response->message, testing::HasSubstr("state_interface_values: "));
+  EXPECT_THAT(response->message, testing::HasSubstr("joint_state_msgs: "));
+  EXPECT_THAT(response->message, testing::HasSubstr("name_lookups: "));
+  EXPECT_THAT(response->message, testing::HasSubstr("total: "));
+}
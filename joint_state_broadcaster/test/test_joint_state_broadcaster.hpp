@@ -43,7 +43,17 @@ class FriendJointStateBroadcaster : public joint_state_broadcaster::JointStateBr
   FRIEND_TEST(JointStateBroadcasterTest, TestCustomInterfaceWithoutMapping);
   FRIEND_TEST(JointStateBroadcasterTest, TestCustomInterfaceMapping);
   FRIEND_TEST(JointStateBroadcasterTest, TestCustomInterfaceMappingUpdate);
+  FRIEND_TEST(JointStateBroadcasterTest, UpdateCopiesValuesAfterReactivationTest);
   FRIEND_TEST(JointStateBroadcasterTest, ExtraJointStatePublishTest);
+  FRIEND_TEST(JointStateBroadcasterTest, PublishRateTest);
+  FRIEND_TEST(JointStateBroadcasterTest, DynamicJointStatePublishOnChangeTest);
+  FRIEND_TEST(JointStateBroadcasterTest, JointGroupPublishTest);
+  FRIEND_TEST(JointStateBroadcasterTest, DynamicJointStatePublishOnlyWithSubscribersTest);
+  FRIEND_TEST(JointStateBroadcasterTest, CompactJointStatePublishTest);
+  FRIEND_TEST(JointStateBroadcasterTest, CompactJointStateBatchTest);
+  FRIEND_TEST(JointStateBroadcasterTest, VelocityEstimationTest);
+  FRIEND_TEST(JointStateBroadcasterTest, NewSampleDetectionTest);
+  FRIEND_TEST(JointStateBroadcasterTest, MemoryFootprintTest);
 };
 
 class JointStateBroadcasterTest : public ::testing::Test
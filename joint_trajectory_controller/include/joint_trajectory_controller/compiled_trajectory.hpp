@@ -0,0 +1,122 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__COMPILED_TRAJECTORY_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__COMPILED_TRAJECTORY_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "joint_trajectory_controller/visibility_control.h"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Contiguous storage of the points of a trajectory message.
+ *
+ * Instead of one allocation per point and field, the times of all points are stored in one array,
+ * and every field in one matrix ordered by point and joint, i.e. the value of joint \p j at point
+ * \p k is at index <tt>k * dof + j</tt>.
+ */
+struct CompiledTrajectory
+{
+  /**
+   * Fill the storage from the points of \p trajectory.
+   *
+   * Only trajectories where every point has positions, and the other fields are given either for
+   * all points or for none, can be represented.
+   *
+   * \return false if \p trajectory can't be represented, the storage is cleared in that case.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool compile(const trajectory_msgs::msg::JointTrajectory & trajectory);
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void clear();
+
+  /// Copy the point at \p index to \p output, fields not given are cleared.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void copy_point(size_t index, trajectory_msgs::msg::JointTrajectoryPoint & output) const;
+
+  /// Free the values of all points but the first, e.g. once a CompactCompiledTrajectory holds
+  /// them. The times of all points are kept.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void release_values_after_first_point();
+
+  /// Number of points
+  size_t size() const { return time_from_start.size(); }
+
+  bool empty() const { return time_from_start.empty(); }
+
+  bool has_velocities() const { return !velocities.empty(); }
+
+  bool has_accelerations() const { return !accelerations.empty(); }
+
+  bool has_effort() const { return !effort.empty(); }
+
+  /// Number of joints
+  size_t dof = 0;
+
+  /// Time from start of every point in nanoseconds
+  std::vector<int64_t> time_from_start;
+
+  /// Values of every point and joint, empty if the field is not given
+  std::vector<double> positions;
+  std::vector<double> velocities;
+  std::vector<double> accelerations;
+  std::vector<double> effort;
+
+  /// Joints which move between the points, in ascending order. The others, e.g. the joints a
+  /// partial goal was filled up with, hold the position of the first point at rest, so they are
+  /// not interpolated.
+  std::vector<size_t> moving_joints;
+  /// Joints which hold their position, in ascending order
+  std::vector<size_t> held_joints;
+};
+
+/**
+ * \brief Values of the points of a CompiledTrajectory in single precision, in the same layout.
+ *
+ * Halves the memory of the values of long trajectories, see Trajectory::set_single_precision().
+ * The times of the points stay with the CompiledTrajectory.
+ */
+struct CompactCompiledTrajectory
+{
+  /// Copy the values of \p compiled, rounded to single precision.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void assign(const CompiledTrajectory & compiled);
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void clear();
+
+  /// Copy the values of the point at \p index to \p output, fields not given are cleared. Its
+  /// time_from_start is left as it is.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void copy_point(size_t index, trajectory_msgs::msg::JointTrajectoryPoint & output) const;
+
+  /// Number of joints
+  size_t dof = 0;
+
+  /// Values of every point and joint, empty if the field is not given
+  std::vector<float> positions;
+  std::vector<float> velocities;
+  std::vector<float> accelerations;
+  std::vector<float> effort;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__COMPILED_TRAJECTORY_HPP_
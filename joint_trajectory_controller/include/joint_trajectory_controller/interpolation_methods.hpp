@@ -30,13 +30,20 @@ namespace interpolation_methods
 enum class InterpolationMethod
 {
   NONE,
-  VARIABLE_DEGREE_SPLINE
+  VARIABLE_DEGREE_SPLINE,
+  /// Stop at every waypoint, with a minimum-jerk profile between them
+  MINIMUM_JERK,
+  /// Stop at every waypoint, with a trapezoidal velocity profile between them
+  TRAPEZOIDAL
 };
 
 const InterpolationMethod DEFAULT_INTERPOLATION = InterpolationMethod::VARIABLE_DEGREE_SPLINE;
 
 const std::unordered_map<InterpolationMethod, std::string> InterpolationMethodMap(
-  {{InterpolationMethod::NONE, "none"}, {InterpolationMethod::VARIABLE_DEGREE_SPLINE, "splines"}});
+  {{InterpolationMethod::NONE, "none"},
+   {InterpolationMethod::VARIABLE_DEGREE_SPLINE, "splines"},
+   {InterpolationMethod::MINIMUM_JERK, "minimum_jerk"},
+   {InterpolationMethod::TRAPEZOIDAL, "trapezoidal"}});
 
 [[nodiscard]] inline InterpolationMethod from_string(const std::string & interpolation_method)
 {
@@ -50,6 +57,17 @@ const std::unordered_map<InterpolationMethod, std::string> InterpolationMethodMa
   {
     return InterpolationMethod::VARIABLE_DEGREE_SPLINE;
   }
+  else if (
+    interpolation_method.compare(InterpolationMethodMap.at(InterpolationMethod::MINIMUM_JERK)) ==
+    0)
+  {
+    return InterpolationMethod::MINIMUM_JERK;
+  }
+  else if (
+    interpolation_method.compare(InterpolationMethodMap.at(InterpolationMethod::TRAPEZOIDAL)) == 0)
+  {
+    return InterpolationMethod::TRAPEZOIDAL;
+  }
   // Default
   else
   {
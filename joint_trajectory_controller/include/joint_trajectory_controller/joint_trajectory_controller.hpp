@@ -15,23 +15,47 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__JOINT_TRAJECTORY_CONTROLLER_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__JOINT_TRAJECTORY_CONTROLLER_HPP_
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "control_msgs/action/follow_joint_trajectory.hpp"
+#include "control_msgs/msg/dynamic_joint_state.hpp"
 #include "control_msgs/msg/joint_trajectory_controller_state.hpp"
 #include "control_msgs/srv/query_trajectory_state.hpp"
-#include "control_toolbox/pid.hpp"
-#include "controller_interface/controller_interface.hpp"
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_realtime_tools/action_monitor.hpp"
+#include "controller_realtime_tools/batched_pid.hpp"
+#include "controller_realtime_tools/command_sequence.hpp"
+#include "controller_realtime_tools/cycle_budget.hpp"
+#include "controller_realtime_tools/cycle_timing.hpp"
+#include "controller_realtime_tools/input_recorder.hpp"
+#include "controller_realtime_tools/joint_vectors.hpp"
+#include "controller_realtime_tools/interface_order.hpp"
+#include "controller_realtime_tools/latency_probe.hpp"
+#include "controller_realtime_tools/memory_footprint.hpp"
+#include "controller_realtime_tools/memory_prefault.hpp"
+#include "controller_realtime_tools/realtime_goal_slot.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "controller_realtime_tools/thread_scheduling.hpp"
+#include "controller_realtime_tools/tracking_error_statistics.hpp"
+#include "controller_realtime_tools/worker_thread.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "joint_trajectory_controller/interpolation_methods.hpp"
 #include "joint_trajectory_controller/tolerances.hpp"
+#include "joint_trajectory_controller/trajectory_file.hpp"
+#include "joint_trajectory_controller/trajectory_pool.hpp"
 #include "joint_trajectory_controller/visibility_control.h"
 #include "rclcpp/duration.hpp"
+#include "rclcpp/publisher.hpp"
 #include "rclcpp/subscription.hpp"
 #include "rclcpp/time.hpp"
 #include "rclcpp/timer.hpp"
@@ -40,8 +64,9 @@
 #include "rclcpp_lifecycle/lifecycle_publisher.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
 #include "realtime_tools/realtime_server_goal_handle.h"
+#include "statistics_msgs/msg/metrics_message.hpp"
+#include "std_srvs/srv/trigger.hpp"
 #include "trajectory_msgs/msg/joint_trajectory.hpp"
 #include "trajectory_msgs/msg/joint_trajectory_point.hpp"
 
@@ -64,7 +89,7 @@ namespace joint_trajectory_controller
 {
 class Trajectory;
 
-class JointTrajectoryController : public controller_interface::ControllerInterface
+class JointTrajectoryController : public controller_interface::ChainableControllerInterface
 {
 public:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
@@ -85,7 +110,11 @@ public:
   controller_interface::InterfaceConfiguration state_interface_configuration() const override;
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
-  controller_interface::return_type update(
+  controller_interface::return_type update_reference_from_subscribers(
+    const rclcpp::Time & time, const rclcpp::Duration & period) override;
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  controller_interface::return_type update_and_write_commands(
     const rclcpp::Time & time, const rclcpp::Duration & period) override;
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
@@ -116,6 +145,11 @@ public:
     const rclcpp_lifecycle::State & previous_state) override;
 
 protected:
+  /// Export the position and then the velocity reference of every joint
+  std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
+
+  bool on_set_chained_mode(bool chained_mode) override;
+
   // To reduce number of variables and to make the code shorter the interfaces are ordered in types
   // as the following constants
   const std::vector<std::string> allowed_interface_types_ = {
@@ -126,13 +160,16 @@ protected:
   };
 
   // Preallocate variables used in the realtime update() function
-  trajectory_msgs::msg::JointTrajectoryPoint state_current_;
+  // the state read from the hardware and its error, only converted to messages when published
+  controller_realtime_tools::JointVectors state_current_;
   trajectory_msgs::msg::JointTrajectoryPoint command_current_;
   trajectory_msgs::msg::JointTrajectoryPoint state_desired_;
-  trajectory_msgs::msg::JointTrajectoryPoint state_error_;
+  controller_realtime_tools::JointVectors state_error_;
 
   // Degrees of freedom
   size_t dof_;
+  // Index of every joint in params_.joints, to map the joints of incoming trajectories
+  std::unordered_map<std::string, size_t> joint_indices_;
 
   // Storing command joint names for interfaces
   std::vector<std::string> command_joint_names_;
@@ -142,9 +179,22 @@ protected:
   Params params_;
 
   trajectory_msgs::msg::JointTrajectoryPoint last_commanded_state_;
+  /// State of the replaced trajectory when a new one is swapped in, see
+  /// blend_replaced_trajectories
+  trajectory_msgs::msg::JointTrajectoryPoint blend_state_;
+  bool blend_into_new_trajectory_ = false;
+  /// State the executed trajectory is in command_lookahead after the control cycle, written to the
+  /// command interfaces instead of state_desired_
+  trajectory_msgs::msg::JointTrajectoryPoint lookahead_state_;
   /// Specify interpolation method. Default to splines.
   interpolation_methods::InterpolationMethod interpolation_method_{
     interpolation_methods::DEFAULT_INTERPOLATION};
+  /// Limits of the time-parameterized interpolation methods, in the order of params_.joints
+  std::vector<MotionLimits> motion_limits_;
+  /// Whether received trajectories are simplified, with the tolerances in the order of
+  /// params_.joints
+  bool simplify_trajectories_ = false;
+  std::vector<double> simplification_tolerances_;
 
   // The interfaces are defined as the types in 'allowed_interface_types_' member.
   // For convenience, for each type the interfaces are ordered so that i-th position
@@ -154,6 +204,35 @@ protected:
 
   InterfaceReferences<hardware_interface::LoanedCommandInterface> joint_command_interface_;
   InterfaceReferences<hardware_interface::LoanedStateInterface> joint_state_interface_;
+  /// Positions of the interfaces of every type in command_interfaces_ and state_interfaces_, per
+  /// type of allowed_interface_types_. Configured with the names, and kept between activations.
+  std::vector<controller_realtime_tools::InterfaceOrder> command_interface_orders_;
+  std::vector<controller_realtime_tools::InterfaceOrder> state_interface_orders_;
+  // The same interfaces in one flat table per kind, [interface type][joint] with dof_ entries per
+  // type and null ones for the types not used, built on activation. The realtime loop reads and
+  // writes a whole type with a tight loop over it.
+  std::vector<hardware_interface::LoanedCommandInterface *> command_interface_table_;
+  std::vector<hardware_interface::LoanedStateInterface *> state_interface_table_;
+  /// Sequence numbers of the commands, nullptr unless params_.command_sequence_interfaces is set
+  std::unique_ptr<controller_realtime_tools::CommandSequence> command_sequence_;
+  /// Finds the sequence interfaces on activation, [command interface type][joint] for the types
+  /// of params_.command_interfaces
+  controller_realtime_tools::InterfaceOrder command_sequence_order_;
+  // The command interfaces and their sequence interfaces in the same order, built on activation
+  std::vector<hardware_interface::LoanedCommandInterface *> command_sequence_sources_;
+  std::vector<hardware_interface::LoanedCommandInterface *> command_sequence_interfaces_;
+
+  /// Command interfaces of the type at \p type_index of allowed_interface_types_, one per joint
+  hardware_interface::LoanedCommandInterface * const * command_interfaces_of(
+    size_t type_index) const
+  {
+    return command_interface_table_.data() + type_index * dof_;
+  }
+  /// State interfaces of the type at \p type_index of allowed_interface_types_, one per joint
+  hardware_interface::LoanedStateInterface * const * state_interfaces_of(size_t type_index) const
+  {
+    return state_interface_table_.data() + type_index * dof_;
+  }
 
   bool has_position_state_interface_ = false;
   bool has_velocity_state_interface_ = false;
@@ -165,8 +244,8 @@ protected:
 
   /// If true, a velocity feedforward term plus corrective PID term is used
   bool use_closed_loop_pid_adapter_ = false;
-  using PidPtr = std::shared_ptr<control_toolbox::Pid>;
-  std::vector<PidPtr> pids_;
+  /// PIDs of all joints, used by the closed loop pid adapter
+  controller_realtime_tools::BatchedPid pids_;
   // Feed-forward velocity weight factor when calculating closed loop pid adapter's command
   std::vector<double> ff_velocity_scale_;
   // Configuration for every joint, if position error is normalized
@@ -181,32 +260,199 @@ protected:
 
   rclcpp::Service<control_msgs::srv::QueryTrajectoryState>::SharedPtr query_state_srv_;
 
+  /// Bytes held per buffer, recorded on activation, and the allocations of the updates since
+  /// then, reported by ~/get_memory_footprint together with the stored trajectories
+  std::mutex memory_footprint_mutex_;
+  controller_realtime_tools::MemoryFootprint memory_footprint_;
+  controller_realtime_tools::AllocationCounter allocation_counter_;
+  rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr memory_footprint_srv_;
+
+  /// Receives the named trajectories to store, nullptr if stored_trajectories.max_count is 0
+  rclcpp::Subscription<trajectory_msgs::msg::JointTrajectory>::SharedPtr
+    store_trajectory_subscriber_ = nullptr;
+  /// Preprocessed and compiled trajectories by name, which are instantiated by reference
+  std::unordered_map<std::string, std::shared_ptr<const Trajectory>> stored_trajectories_;
+  /// Guards stored_trajectories_
+  mutable std::mutex stored_trajectories_mutex_;
+
   std::shared_ptr<Trajectory> * traj_point_active_ptr_ = nullptr;
   std::shared_ptr<Trajectory> traj_external_point_ptr_ = nullptr;
   std::shared_ptr<Trajectory> traj_home_point_ptr_ = nullptr;
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> traj_msg_home_ptr_ = nullptr;
-  realtime_tools::RealtimeBuffer<std::shared_ptr<trajectory_msgs::msg::JointTrajectory>>
-    traj_msg_external_point_ptr_;
+  /// New trajectories, preprocessed by the nonRT threads and ready to be executed
+  realtime_tools::RealtimeBuffer<std::shared_ptr<Trajectory>> traj_external_point_buffer_;
+  /// Trajectories handed to the realtime loop, which keeps them from being freed by it
+  TrajectoryPool trajectory_pool_;
+  /// Trajectory of traj_external_point_buffer_ the realtime loop swapped in last, realtime
+  const Trajectory * rt_buffered_trajectory_ = nullptr;
+  /// Copy of the msg last handed over while splicing topic trajectories, nullptr if the next one
+  /// starts a new stream
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> stream_msg_ = nullptr;
+  uint64_t stream_id_ = 0;
+  /// Guards stream_msg_ and stream_id_, and orders the hand-over of new trajectories
+  std::mutex stream_mutex_;
+  /// Trajectory file the stream is read from, nullptr if all its points are spliced in or the
+  /// stream isn't read from a file. Guarded by stream_mutex_.
+  std::shared_ptr<const TrajectoryFile> stream_file_ = nullptr;
+  /// First point of stream_file_ not spliced in yet
+  size_t stream_file_next_point_ = 0;
+  /// Stream of the last spliced trajectory executed by the realtime loop, and for how long
+  std::atomic<uint64_t> active_stream_id_{0};
+  std::atomic<int64_t> active_stream_elapsed_ns_{0};
+
+  /// State computed by the last update(), for the non-realtime threads
+  struct StateSnapshot
+  {
+    rclcpp::Time time;
+    trajectory_msgs::msg::JointTrajectoryPoint desired;
+    trajectory_msgs::msg::JointTrajectoryPoint current;
+    trajectory_msgs::msg::JointTrajectoryPoint error;
+    /// Active trajectory once it was sampled, nullptr if none
+    std::shared_ptr<Trajectory> trajectory;
+  };
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<StateSnapshot>> state_snapshot_;
+  /// Serializes the readers of state_snapshot_, update() doesn't take it
+  std::mutex state_snapshot_mutex_;
 
   using ControllerStateMsg = control_msgs::msg::JointTrajectoryControllerState;
-  using StatePublisher = realtime_tools::RealtimePublisher<ControllerStateMsg>;
+  using StatePublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    ControllerStateMsg, rclcpp::Publisher<ControllerStateMsg>>;
   using StatePublisherPtr = std::unique_ptr<StatePublisher>;
   rclcpp::Publisher<ControllerStateMsg>::SharedPtr publisher_;
   StatePublisherPtr state_publisher_;
+  /// Preallocated message the state is written to before it is swapped into state_publisher_.
+  ControllerStateMsg state_msg_;
+
+  /// Phases of update() measured if cycle_timing.enable is set
+  enum CyclePhase : size_t
+  {
+    READ_STATE,
+    SAMPLE,
+    TOLERANCES,
+    PID,
+    WRITE_COMMANDS,
+    PUBLISH_STATE,
+    NUM_CYCLE_PHASES
+  };
+  static constexpr std::array<const char *, NUM_CYCLE_PHASES> CYCLE_PHASE_NAMES = {
+    "read_state", "sample", "tolerances", "pid", "write_commands", "publish_state"};
+  /// nullptr if the cycle timing is disabled
+  std::unique_ptr<controller_realtime_tools::CycleTiming> cycle_timing_;
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr timing_publisher_;
+  rclcpp::TimerBase::SharedPtr timing_timer_;
+  rclcpp::Time timing_window_start_;
+
+  /// Non-essential stages of update(), skipped while over the cycle budget
+  enum ShedStage : size_t
+  {
+    SHED_PUBLISH_STATE,
+    SHED_ACTION_FEEDBACK,
+  };
+  /// nullptr if cycle_budget.enable isn't set
+  std::unique_ptr<controller_realtime_tools::CycleBudget> cycle_budget_;
+  /// logs the overruns of the cycle budget and the skipped stages every second
+  rclcpp::TimerBase::SharedPtr cycle_budget_timer_;
+
+  /// Records the inputs of every update while active, nullptr if input_recording.enable isn't set
+  std::unique_ptr<controller_realtime_tools::InputRecorder> input_recorder_;
+
+  /// nullptr if command_latency.enable isn't set
+  std::unique_ptr<controller_realtime_tools::LatencyProbe> command_latency_;
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr command_latency_publisher_;
+  rclcpp::TimerBase::SharedPtr command_latency_timer_;
+  rclcpp::Time command_latency_window_start_;
+  /// Whether the commands of the trajectory swapped in last weren't written yet, realtime
+  bool new_trajectory_unwritten_ = false;
 
   using FollowJTrajAction = control_msgs::action::FollowJointTrajectory;
   using RealtimeGoalHandle = realtime_tools::RealtimeServerGoalHandle<FollowJTrajAction>;
   using RealtimeGoalHandlePtr = std::shared_ptr<RealtimeGoalHandle>;
-  using RealtimeGoalHandleBuffer = realtime_tools::RealtimeBuffer<RealtimeGoalHandlePtr>;
+  using RealtimeGoalHandleSlot = controller_realtime_tools::RealtimeGoalSlot<RealtimeGoalHandle>;
 
   rclcpp_action::Server<FollowJTrajAction>::SharedPtr action_server_;
-  RealtimeGoalHandleBuffer rt_active_goal_;  ///< Currently active action goal, if any.
-  rclcpp::TimerBase::SharedPtr goal_handle_timer_;
+  /// Currently active action goal, if any, and the goal queued behind it if queue_goals is set
+  RealtimeGoalHandleSlot rt_active_goal_;
+  std::mutex monitored_goal_mutex_;
+  /// Accepted goals, serviced by action_monitor_ until they are done
+  std::vector<RealtimeGoalHandlePtr> monitored_goals_;
+
+  /// Tracking errors of the executed goal, nullptr if tracking_error_statistics.enable isn't set
+  std::unique_ptr<controller_realtime_tools::TrackingErrorStatistics> tracking_error_statistics_;
+  using TrackingErrorMsg = control_msgs::msg::DynamicJointState;
+  using TrackingErrorPublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    TrackingErrorMsg, rclcpp::Publisher<TrackingErrorMsg>>;
+  std::unique_ptr<TrackingErrorPublisher> tracking_error_publisher_;
+  /// Preallocated message the statistics of a goal are written to when it is done
+  TrackingErrorMsg tracking_error_msg_;
+  /// Goal the tracking errors are accumulated for, only identifies it, realtime
+  const RealtimeGoalHandle * tracked_goal_ = nullptr;
+  rclcpp::Time tracked_goal_start_;
+
+  /// Compiled trajectory of the goal queued in rt_active_goal_
+  struct QueuedTrajectory
+  {
+    const RealtimeGoalHandle * goal = nullptr;  // tells whether it belongs to the queued goal
+    std::shared_ptr<Trajectory> trajectory;
+  };
+  controller_realtime_tools::RealtimeTripleBuffer<QueuedTrajectory> queued_trajectory_{
+    QueuedTrajectory()};
+  /// Serializes the writers of queued_trajectory_ and the queuing of their goals
+  std::mutex queued_trajectory_mutex_;
   rclcpp::Duration action_monitor_period_ = rclcpp::Duration(50ms);
+  rclcpp::Duration action_feedback_period_ = rclcpp::Duration(0ms);
+  int64_t next_feedback_time_ns_ = std::numeric_limits<int64_t>::min();
+  /// Used instead of the preallocated feedback of the active goal while that one isn't published.
+  std::shared_ptr<FollowJTrajAction::Feedback> rt_feedback_;
+
+  /// Joints executing their own trajectories, see joint_groups
+  struct JointGroup
+  {
+    std::string name;
+    /// Indices in params_.joints of the joints of the group
+    std::vector<size_t> joints;
+    rclcpp_action::Server<FollowJTrajAction>::SharedPtr action_server;
+    /// Currently active action goal of the group, if any
+    RealtimeGoalHandleSlot rt_active_goal;
+    /// New trajectories of the group, preprocessed for all joints by the nonRT threads
+    realtime_tools::RealtimeBuffer<std::shared_ptr<Trajectory>> trajectory_buffer;
+    /// Executed trajectory, nullptr while the group holds its last command, realtime
+    std::shared_ptr<Trajectory> trajectory;
+    /// Trajectory of trajectory_buffer the realtime loop swapped in last, held so that the pool
+    /// doesn't hand it out again while it is compared with the buffer, realtime
+    std::shared_ptr<Trajectory> buffered_trajectory;
+    /// Point the trajectory is sampled at, of all joints, realtime
+    trajectory_msgs::msg::JointTrajectoryPoint desired;
+    /// Whether the last sample_joint_groups() sampled the trajectory, and how, realtime
+    bool sampled = false;
+    bool first_sample = false;
+    bool before_last_point = false;
+    /// Time of the point the trajectory was last sampled after, realtime
+    rclcpp::Time sampled_point_time;
+    /// The tolerances of default_tolerances_ for the joints of the group, the others have none
+    JointsStateTolerances state_tolerances;
+    JointsStateTolerances goal_state_tolerances;
+    int64_t next_feedback_time_ns = std::numeric_limits<int64_t>::min();
+    /// Like rt_feedback_, with the joints of the group
+    std::shared_ptr<FollowJTrajAction::Feedback> rt_feedback;
+  };
+  /// Empty unless joint_groups is set, the groups are constructed in place as they are not movable
+  std::vector<std::unique_ptr<JointGroup>> joint_groups_;
+
+  /// Runs the preprocessing of received trajectories if preprocessing.use_worker_thread is set,
+  /// nullptr if they are preprocessed in the callbacks
+  /**
+   * Declared after the members its jobs access, so that it is destroyed first.
+   */
+  std::unique_ptr<controller_realtime_tools::WorkerThread> preprocessing_worker_;
 
   // callback for topic interface
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void topic_callback(const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg);
+  // validates and preprocesses a msg received on the topic, then hands it over to the realtime
+  // loop. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void process_topic_trajectory_msg(
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & msg);
 
   // callbacks for action_server_
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
@@ -218,8 +464,53 @@ protected:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void goal_accepted_callback(
     std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle);
+  // preprocesses the trajectory of an accepted goal, then makes the goal the active one, or queues
+  // it behind the active one if queue_goals is set. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void activate_goal(const RealtimeGoalHandlePtr & rt_goal);
+  // preprocesses and compiles the trajectory of an accepted goal, nullptr if the goal is finished
+  // instead. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<Trajectory> compile_goal_trajectory(const RealtimeGoalHandlePtr & rt_goal);
+  // hands the compiled trajectory of a goal over to the realtime loop, which starts it once the
+  // active goal succeeds. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void queue_goal(
+    const RealtimeGoalHandlePtr & rt_goal, const std::shared_ptr<Trajectory> & trajectory);
+  // aborts the queued goal, if any, as the active goal won't be reached. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void abort_queued_goal();
 
-  // fill trajectory_msg so it matches joints controlled by this controller
+  // callbacks for the action servers of joint_groups_
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  rclcpp_action::GoalResponse group_goal_received_callback(
+    JointGroup & group, std::shared_ptr<const FollowJTrajAction::Goal> goal);
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  rclcpp_action::CancelResponse group_goal_cancelled_callback(
+    JointGroup & group,
+    const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle);
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void group_goal_accepted_callback(
+    JointGroup & group,
+    std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle);
+  // preprocesses the trajectory of an accepted goal of the group like activate_goal(), then makes
+  // the goal the active one of the group. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void activate_group_goal(JointGroup & group, const RealtimeGoalHandlePtr & rt_goal);
+  // cancels the active goal of the group, if any, and lets the group hold its position. Not
+  // realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void preempt_group_goal(JointGroup & group, const std::string & reason);
+  /// Swap in the new trajectories of the groups and sample them into state_desired_, for the
+  /// joints of each group. Realtime-safe.
+  void sample_joint_groups(const rclcpp::Time & time);
+  /// Check the tolerances of the groups sampled by sample_joint_groups() against state_error_,
+  /// and update their goals. Realtime-safe.
+  void check_joint_groups(const rclcpp::Time & time);
+  /// Let the group hold the positions of state_desired_ at zero velocity. Realtime-safe.
+  void hold_joint_group(JointGroup & group);
+
+  // fill trajectory_msg so it matches joints controlled by this controller, in the local order
   // positions set to current position, velocities, accelerations and efforts to 0.0
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void fill_partial_goal(
@@ -228,17 +519,116 @@ protected:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void sort_to_local_joint_order(
     std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg);
+  /// Check \p trajectory for all joints, or for the joints of \p group if not nullptr
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
-  bool validate_trajectory_msg(const trajectory_msgs::msg::JointTrajectory & trajectory) const;
+  bool validate_trajectory_msg(
+    const trajectory_msgs::msg::JointTrajectory & trajectory,
+    const JointGroup * group = nullptr) const;
+  // fills and sorts the msg, then hands it over to the realtime loop. Not realtime-safe.
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void add_new_trajectory_msg(
     const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg);
+  // fills, sorts and compiles the msg like add_new_trajectory_msg(). Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<Trajectory> compile_trajectory_msg(
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg);
+  // like add_new_trajectory_msg(), but splices the msg into the last one of the stream, see
+  // splice_topic_trajectories. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void splice_new_trajectory_msg(
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg);
+  // whether add_new_trajectory_msg() would not change the msg, so it can be used without a copy
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool is_executable_unchanged(const trajectory_msgs::msg::JointTrajectory & trajectory) const;
+  // a trajectory of the pool compiled from the msg, in the precision set by
+  // single_precision_trajectories. With preprocessing.progressive_compilation_segments, only its
+  // first segments are compiled, and the others by compile_remaining_segments(). Not
+  // realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<Trajectory> acquire_trajectory(
+    const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg);
+  // compiles the next chunk of segments of the trajectory on the preprocessing thread, and posts
+  // itself again until all are compiled or the trajectory isn't used anymore
+  void compile_remaining_segments(const std::shared_ptr<Trajectory> & trajectory);
+  // hands a preprocessed trajectory over to the realtime loop. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void add_new_trajectory(const std::shared_ptr<Trajectory> & trajectory);
+
+  // preprocesses the msg and stores it under the name in its header.frame_id, or removes the
+  // stored one if the msg has no points
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void store_trajectory_callback(const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg);
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void store_trajectory_msg(const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & msg);
+  /// True if \p trajectory refers to a stored one, i.e. it has no points but a header.frame_id
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  static bool is_stored_trajectory_reference(
+    const trajectory_msgs::msg::JointTrajectory & trajectory);
+  /// Find the stored trajectory \p reference refers to
+  /**
+   * \return nullptr if none is stored by that name, or it would end in the past if started at
+   * the stamp of \p reference.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<const Trajectory> find_stored_trajectory(
+    const trajectory_msgs::msg::JointTrajectory & reference) const;
+  // hands a new instance of the stored trajectory, starting at the stamp of the reference, over
+  // to the realtime loop. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void add_stored_trajectory(
+    const Trajectory & stored_trajectory, const trajectory_msgs::msg::JointTrajectory & reference);
+  // the instance of the stored trajectory add_stored_trajectory() hands over. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<Trajectory> instantiate_stored_trajectory(
+    const Trajectory & stored_trajectory, const trajectory_msgs::msg::JointTrajectory & reference);
+
+  /// True if \p trajectory refers to a trajectory file, i.e. it has no points but a
+  /// header.frame_id starting with "file:"
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  static bool is_trajectory_file_reference(
+    const trajectory_msgs::msg::JointTrajectory & trajectory);
+  /// Open the trajectory file in trajectory_files.directory \p reference refers to
+  /**
+   * \return nullptr if the file can't be opened, doesn't contain all joints, or would end in the
+   * past if started at the stamp of \p reference.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<const TrajectoryFile> open_trajectory_file(
+    const trajectory_msgs::msg::JointTrajectory & reference) const;
+  // starts a new stream with the first window of the file, nullptr if it is invalid. Not
+  // realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<Trajectory> compile_trajectory_file(
+    const std::shared_ptr<const TrajectoryFile> & file,
+    const trajectory_msgs::msg::JointTrajectory & reference, std::string & error);
+  // splices the next windows of stream_file_ into stream_msg_ until the points of
+  // trajectory_files.lookahead after keep_from are loaded, and compiles the spliced msg, nullptr if
+  // a window is invalid. Call with stream_mutex_ held. Not realtime-safe.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<Trajectory> compile_trajectory_file_windows(
+    const rclcpp::Duration & keep_from, std::string & error);
+  /**
+   * \brief Service of action_monitor_: splice the next windows of the trajectory file executed by
+   * the realtime loop in, once it comes close to the points loaded.
+   *
+   * The active goal is aborted if a window is invalid. Not realtime-safe.
+   * \return true while points of the file are left to splice in.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool advance_trajectory_file();
+
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool validate_trajectory_point_field(
     size_t joint_names_size, const std::vector<double> & vector_field,
     const std::string & string_for_vector_field, size_t i, bool allow_empty) const;
+  /// Log why point \p i of an invalid \p trajectory didn't pass validate_trajectory_msg()
+  void log_invalid_trajectory_point(
+    const trajectory_msgs::msg::JointTrajectory & trajectory, size_t i) const;
 
   SegmentTolerances default_tolerances_;
+  /// The tolerances of default_tolerances_ laid out for checking all joints at once
+  JointsStateTolerances state_tolerances_;
+  JointsStateTolerances goal_state_tolerances_;
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void preempt_active_goal();
@@ -252,23 +642,65 @@ protected:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void publish_state(
     const rclcpp::Time & time, const JointTrajectoryPoint & desired_state,
-    const JointTrajectoryPoint & current_state, const JointTrajectoryPoint & state_error);
+    const controller_realtime_tools::JointVectors & current_state,
+    const controller_realtime_tools::JointVectors & state_error);
+
+  /// Publish the statistics of the cycle phases since the last call, one msg per phase
+  void publish_cycle_timing();
+
+  /// Publish the command latency statistics since the last call, one msg per stage
+  void publish_command_latency();
+
+  /// Add the position errors of this update to the statistics of the executed \p goal, nullptr
+  /// if none. Once the tracked goal is done or replaced, its statistics are published. Realtime.
+  void update_tracking_error_statistics(const rclcpp::Time & time, const RealtimeGoalHandle * goal);
+
+  /// Fault in the pages of the buffers preallocated for update(), and lock them if lock_memory
+  /// is set, so that they don't fault in during the first updates after the activation. Records
+  /// the memory footprint of the buffers.
+  void prefault_memory();
 
-  void read_state_from_hardware(JointTrajectoryPoint & state);
+  void read_state_from_hardware(controller_realtime_tools::JointVectors & state);
 
   bool read_state_from_command_interfaces(JointTrajectoryPoint & state);
+  /// Fill the desired \p state from the references written by the preceding controller
+  /**
+   * Without a position reference, the velocity reference is integrated over \p period. Without a
+   * velocity reference, the velocity is 0.0.
+   */
+  void read_state_from_reference_interfaces(
+    JointTrajectoryPoint & state, const rclcpp::Duration & period);
   bool read_commands_from_command_interfaces(JointTrajectoryPoint & commands);
 
   void query_state_service(
     const std::shared_ptr<control_msgs::srv::QueryTrajectoryState::Request> request,
     std::shared_ptr<control_msgs::srv::QueryTrajectoryState::Response> response);
 
+  void get_memory_footprint(
+    const std::shared_ptr<std_srvs::srv::Trigger::Request> request,
+    std::shared_ptr<std_srvs::srv::Trigger::Response> response);
+
 private:
   bool contains_interface_type(
     const std::vector<std::string> & interface_type_list, const std::string & interface_type);
 
   void resize_joint_trajectory_point(
     trajectory_msgs::msg::JointTrajectoryPoint & point, size_t size);
+  void reserve_joint_trajectory_point(
+    trajectory_msgs::msg::JointTrajectoryPoint & point, size_t size);
+  /// Preallocate \p feedback for all joints, or for the joints of \p group if not nullptr
+  void preallocate_feedback(
+    FollowJTrajAction::Feedback & feedback, const JointGroup * group = nullptr);
+
+  /**
+   * \brief Service of action_monitor_: update the action status of the monitored goals.
+   * \return true while a goal waits for a transition of the action server or for its activation
+   * rather than for the realtime loop
+   */
+  bool monitor_goal();
+
+  /// Services the monitored goal, declared last to stop before the members it uses are destroyed.
+  std::unique_ptr<controller_realtime_tools::ActionMonitor> action_monitor_;
   void resize_joint_trajectory_point_command(
     trajectory_msgs::msg::JointTrajectoryPoint & point, size_t size);
 };
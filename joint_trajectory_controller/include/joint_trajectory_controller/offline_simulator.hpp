@@ -0,0 +1,146 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__OFFLINE_SIMULATOR_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__OFFLINE_SIMULATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/visibility_control.h"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/parameter.hpp"
+#include "rclcpp/time.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+namespace joint_trajectory_controller
+{
+/// Outcome of executing a trajectory with OfflineSimulator::execute()
+struct SimulationResult
+{
+  /// Error code of control_msgs::action::FollowJointTrajectory::Result the goal would end with:
+  /// SUCCESSFUL, INVALID_GOAL, PATH_TOLERANCE_VIOLATED or GOAL_TOLERANCE_VIOLATED
+  int32_t error_code = 0;
+  std::string error_string;
+  /// Simulated time from the first cycle until the outcome, in seconds
+  double duration = 0.0;
+  size_t cycles = 0;
+  /// Largest absolute position error of every joint, in the order of the joints of the simulator
+  std::vector<double> max_position_errors;
+  /// Joint violating a tolerance first, and the error of all joints then, if the trajectory
+  /// violated the path or goal tolerances
+  std::string violating_joint;
+  trajectory_msgs::msg::JointTrajectoryPoint violation_error;
+};
+
+/**
+ * \brief Executes trajectories with a JointTrajectoryController against simulated joints, in
+ * synthetic time.
+ *
+ * The controller is updated cycle after cycle without waiting, so a trajectory is executed as
+ * fast as the cycles are computed. The joints follow the position, velocity or acceleration
+ * commands with a first-order lag, and the outcome is decided with the tolerances of the
+ * controller like the action server would, see SimulationResult.
+ *
+ * A simulator has its own controller and node, so trajectories are validated in parallel with one
+ * simulator per thread. rclcpp has to be initialized before a simulator is created. Joint groups
+ * and chained mode are not simulated.
+ */
+class OfflineSimulator
+{
+public:
+  struct Options
+  {
+    std::vector<std::string> joints;
+    std::vector<std::string> command_interfaces = {"position"};
+    std::vector<std::string> state_interfaces = {"position", "velocity"};
+    /// Further parameters of the controller, like the constraints or the gains.
+    /// state_publish_rate defaults to 10.0 here, as the state is rarely of interest offline.
+    std::vector<rclcpp::Parameter> parameters;
+    /// Positions the joints start at, 0.0 if empty
+    std::vector<double> initial_positions;
+    /// Rate the controller is updated with, in Hz
+    double update_rate = 100.0;
+    /// Time constant of the lag the joints follow their commands with in seconds, 0.0 to follow
+    /// them within the cycle
+    double time_constant = 0.0;
+    /// How long a trajectory is executed past its last point at most, if constraints.goal_time
+    /// is 0.0 and the joints don't reach the goal tolerances
+    double settling_time = 1.0;
+  };
+
+  /**
+   * \brief Create the controller of the simulator, named \p name, and activate it.
+   * \param[out] error Why the controller can't be simulated, if nullptr is returned.
+   * \return nullptr if the options are invalid, or the controller can't be configured or
+   * activated with them.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  static std::unique_ptr<OfflineSimulator> create(
+    const std::string & name, const Options & options, std::string & error);
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  ~OfflineSimulator();
+
+  OfflineSimulator(const OfflineSimulator &) = delete;
+  OfflineSimulator & operator=(const OfflineSimulator &) = delete;
+
+  /**
+   * \brief Execute \p trajectory from the state the joints are in until its outcome is known.
+   *
+   * The trajectory starts in the first cycle, its stamp is ignored. The next trajectory starts
+   * from the state the joints are left in.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  SimulationResult execute(const trajectory_msgs::msg::JointTrajectory & trajectory);
+
+  /// Positions of the simulated joints
+  const std::vector<double> & positions() const { return state_positions_; }
+
+  /// Synthetic time of the next cycle
+  rclcpp::Time now() const { return time_; }
+
+private:
+  class Controller;
+
+  OfflineSimulator() = default;
+
+  /// Move the joints for one cycle, following the commands of the controller
+  void step_joints();
+
+  std::shared_ptr<Controller> controller_;
+  Options options_;
+  size_t dof_ = 0;
+  rclcpp::Time time_{1, 0, RCL_STEADY_TIME};
+  rclcpp::Duration period_{0, 0};
+  /// Index of the command interface type the joints follow: 0 for positions, 1 for velocities and
+  /// 2 for accelerations
+  size_t command_type_ = 0;
+  /// Fraction of the difference to the command a joint covers in one cycle
+  double lag_factor_ = 1.0;
+
+  /// Values of the interfaces of the controller, per interface type and then joint
+  std::vector<double> command_values_;
+  std::vector<double> state_positions_;
+  std::vector<double> state_velocities_;
+  std::vector<double> state_accelerations_;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__OFFLINE_SIMULATOR_HPP_
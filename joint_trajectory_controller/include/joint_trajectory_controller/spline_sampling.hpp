@@ -0,0 +1,68 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_HPP_
+
+#include <cstddef>
+
+#include "joint_trajectory_controller/visibility_control.h"
+
+namespace joint_trajectory_controller
+{
+/// Number of polynomial coefficients of the highest supported spline degree (quintic)
+constexpr size_t SPLINE_COEFFICIENTS = 6;
+
+/**
+ * \brief Evaluate the splines of \p dof joints and their first two derivatives at \p t.
+ *
+ * \p coefficients holds SPLINE_COEFFICIENTS * \p dof values ordered per coefficient, then joint,
+ * i.e. coefficient \p k of joint \p j is at <tt>k * dof + j</tt>, starting with the constant one.
+ * Cubic splines have zero coefficients 4 and 5.
+ *
+ * The joints are evaluated in the SIMD lanes of the widest instruction set the CPU supports, see
+ * get_spline_kernel_name(), chosen once when the library is loaded. Realtime-safe.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void evaluate_splines(
+  const double * coefficients, size_t dof, double t, double * positions, double * velocities,
+  double * accelerations);
+
+/// Portable kernel of evaluate_splines(), which the SIMD kernels match up to rounding.
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void evaluate_splines_portable(
+  const double * coefficients, size_t dof, double t, double * positions, double * velocities,
+  double * accelerations);
+
+/**
+ * \brief Evaluate splines with single precision \p coefficients like evaluate_splines().
+ *
+ * The polynomials are evaluated in single precision, so the result of a joint deviates from the
+ * double precision one of the rounded coefficients by at most 12 * 2^-24 * sum_k |c_k| t^k for the
+ * position, i.e. about 1e-6 of the magnitude of its terms, and the derivatives likewise. Rounding
+ * the coefficients adds 2^-24 of their terms, so a joint at 10 rad deviates by about 1e-5 rad.
+ * Realtime-safe.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void evaluate_compact_splines(
+  const float * coefficients, size_t dof, float t, double * positions, double * velocities,
+  double * accelerations);
+
+/// Name of the kernel used by evaluate_splines(): "avx2", "neon" or "portable".
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+const char * get_spline_kernel_name();
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_HPP_
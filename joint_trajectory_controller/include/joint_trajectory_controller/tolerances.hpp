@@ -30,8 +30,11 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__TOLERANCES_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__TOLERANCES_HPP_
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -39,6 +42,7 @@
 #include "joint_trajectory_controller_parameters.hpp"
 
 #include "rclcpp/node.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
 
 namespace joint_trajectory_controller
 {
@@ -71,6 +75,59 @@ struct SegmentTolerances
   double goal_time_tolerance = 0.0;
 };
 
+/**
+ * \brief State tolerances of all joints, stored contiguously per variable.
+ *
+ * Tolerances that are not enforced are stored as infinity, so they can be checked without
+ * branching on the tolerance value.
+ */
+struct JointsStateTolerances
+{
+  JointsStateTolerances() = default;
+
+  explicit JointsStateTolerances(const std::vector<StateTolerances> & state_tolerances)
+  {
+    const auto to_limit = [](double tolerance)
+    { return tolerance > 0.0 ? tolerance : std::numeric_limits<double>::infinity(); };
+
+    position.reserve(state_tolerances.size());
+    velocity.reserve(state_tolerances.size());
+    acceleration.reserve(state_tolerances.size());
+    for (const auto & tolerance : state_tolerances)
+    {
+      position.push_back(to_limit(tolerance.position));
+      velocity.push_back(to_limit(tolerance.velocity));
+      acceleration.push_back(to_limit(tolerance.acceleration));
+    }
+  }
+
+  std::vector<double> position;
+  std::vector<double> velocity;
+  std::vector<double> acceleration;
+};
+
+/**
+ * \brief Result of checking the state tolerances of all joints.
+ */
+struct ToleranceViolations
+{
+  enum : uint8_t
+  {
+    NONE = 0,
+    POSITION = 1 << 0,
+    VELOCITY = 1 << 1,
+    ACCELERATION = 1 << 2,
+  };
+
+  /** Bitmask of the variables violating their tolerance for at least one joint. */
+  uint8_t variables = NONE;
+
+  /** Lowest index of the joints violating a tolerance, only valid if any() is true. */
+  size_t first_joint = 0;
+
+  bool any() const { return variables != NONE; }
+};
+
 /**
  * \brief Populate trajectory segment tolerances using data from the ROS node.
  *
@@ -91,7 +148,7 @@ struct SegmentTolerances
  * \param params The ROS Parameters
  * \return Trajectory segment tolerances.
  */
-SegmentTolerances get_segment_tolerances(Params const & params)
+inline SegmentTolerances get_segment_tolerances(Params const & params)
 {
   auto const & constraints = params.constraints;
   auto const n_joints = params.joints.size();
@@ -175,6 +232,77 @@ inline bool check_state_tolerance_per_joint(
   return false;
 }
 
+namespace detail
+{
+/**
+ * \return Index of the first element violating its limit, or \p size if there is none.
+ */
+inline size_t find_first_violation(const double * error, const double * limit, size_t size)
+{
+  // count without branches, so the loop can be vectorized, and only search in case of a violation
+  size_t violations = 0;
+  for (size_t i = 0; i < size; ++i)
+  {
+    violations += static_cast<size_t>(std::abs(error[i]) > limit[i]);
+  }
+  if (violations == 0)
+  {
+    return size;
+  }
+  for (size_t i = 0; i < size; ++i)
+  {
+    if (std::abs(error[i]) > limit[i])
+    {
+      return i;
+    }
+  }
+  return size;
+}
+}  // namespace detail
+
+/**
+ * \brief Check the state error of all joints against their tolerances. Realtime-safe.
+ *
+ * \param state_error State error to check, a JointTrajectoryPoint or a JointVectors. Velocity and
+ * acceleration errors are optional.
+ * \param tolerances State tolerances of all joints, with the same size as the position error.
+ * \return The violated variables and the first joint violating a tolerance.
+ */
+template <typename StateErrorT>
+ToleranceViolations check_state_tolerance(
+  const StateErrorT & state_error,
+  const JointsStateTolerances & tolerances)
+{
+  const size_t size = tolerances.position.size();
+  assert(state_error.positions.size() == size);
+
+  ToleranceViolations result;
+  result.first_joint = size;
+  const auto check = [&](const std::vector<double> & error, const std::vector<double> & limit,
+                         uint8_t variable)
+  {
+    if (error.empty())
+    {
+      return;
+    }
+    const size_t joint = detail::find_first_violation(error.data(), limit.data(), size);
+    if (joint < size)
+    {
+      result.variables |= variable;
+      result.first_joint = std::min(result.first_joint, joint);
+    }
+  };
+  check(state_error.positions, tolerances.position, ToleranceViolations::POSITION);
+  check(state_error.velocities, tolerances.velocity, ToleranceViolations::VELOCITY);
+  check(state_error.accelerations, tolerances.acceleration, ToleranceViolations::ACCELERATION);
+
+  if (!result.any())
+  {
+    result.first_joint = 0;
+  }
+  return result;
+}
+
 }  // namespace joint_trajectory_controller
 
 #endif  // JOINT_TRAJECTORY_CONTROLLER__TOLERANCES_HPP_
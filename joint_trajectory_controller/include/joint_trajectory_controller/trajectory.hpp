@@ -15,11 +15,16 @@
 #ifndef JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_HPP_
 #define JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "controller_realtime_tools/joint_vectors.hpp"
+#include "joint_trajectory_controller/compiled_trajectory.hpp"
 #include "joint_trajectory_controller/interpolation_methods.hpp"
 #include "joint_trajectory_controller/visibility_control.h"
+#include "rclcpp/duration.hpp"
 #include "rclcpp/time.hpp"
 #include "trajectory_msgs/msg/joint_trajectory.hpp"
 #include "trajectory_msgs/msg/joint_trajectory_point.hpp"
@@ -52,10 +57,43 @@ public:
   void set_point_before_trajectory_msg(
     const rclcpp::Time & current_time,
     const trajectory_msgs::msg::JointTrajectoryPoint & current_point);
+  /// Like above, from the state the realtime loop works on. Realtime if the trajectory was set
+  /// up with a point of the same joints before.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_point_before_trajectory_msg(
+    const rclcpp::Time & current_time,
+    const controller_realtime_tools::JointVectors & current_point);
+
+  /// Like set_point_before_trajectory_msg(), but blend from \p current_point into the trajectory.
+  /**
+   * Used if this trajectory replaces one that \p current_point was sampled from. The segment to
+   * the first point is then a quintic joining the first segment of the trajectory with continuous
+   * position, velocity and acceleration, even if the points of the trajectory give fewer fields.
+   * Like the other segments, it is computed only once.
+   *
+   * If \p current_point lacks velocities or accelerations, or the trajectory can't be compiled,
+   * this behaves like set_point_before_trajectory_msg().
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_blend_before_trajectory_msg(
+    const rclcpp::Time & current_time,
+    const trajectory_msgs::msg::JointTrajectoryPoint & current_point);
 
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   void update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory);
 
+  /// Continue sampling where \p previous stands, instead of starting this trajectory anew.
+  /**
+   * Used if this trajectory was spliced from the msg of \p previous, see splice_trajectory_msg().
+   * The start time is taken from \p previous, and the state before the trajectory is swapped with
+   * the one of \p previous, so this does not allocate memory. \p previous must not be sampled
+   * anymore afterwards.
+   *
+   * \pre \p previous is sampled already.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void continue_from(Trajectory & previous);
+
   /// Find the segment (made up of 2 points) and its expected state from the
   /// containing trajectory.
   /**
@@ -78,6 +116,9 @@ public:
    * - Sampling empty msg or before the time given in set_point_before_trajectory_msg()
    *    return false
    *
+   * The fields of \p output_state are filled in place. If their capacity fits the number of
+   * joints, sampling does not allocate memory after the first sample of a trajectory.
+   *
    * \param[in] sample_time Time at which trajectory will be sampled.
    * \param[in] interpolation_method Specify whether splines, another method, or no interpolation at
    * all. \param[out] expected_state Calculated new at \p sample_time. \param[out] start_segment_itr
@@ -91,6 +132,24 @@ public:
     trajectory_msgs::msg::JointTrajectoryPoint & output_state,
     TrajectoryPointConstIter & start_segment_itr, TrajectoryPointConstIter & end_segment_itr);
 
+  /// Sample the trajectory at \p sample_time without changing it.
+  /**
+   * Unlike sample(), this may be called from another thread while the trajectory is sampled, as
+   * sample() only moves the segment cursor once the trajectory was sampled the first time. The
+   * segment is found by a binary search then.
+   *
+   * \param[out] after_last_point True if \p sample_time is after the last point.
+   * \return false if the trajectory was not sampled yet, its msg is empty or could not be
+   * compiled, or \p sample_time is before the time given in set_point_before_trajectory_msg().
+   * Also false before the first point if \p interpolation_method is NONE, as the state before the
+   * trajectory is handed over by continue_from().
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool sample_at(
+    const rclcpp::Time & sample_time,
+    const interpolation_methods::InterpolationMethod interpolation_method,
+    trajectory_msgs::msg::JointTrajectoryPoint & output_state, bool & after_last_point) const;
+
   /**
    * Do interpolation between 2 states given a time in between their respective timestamps
    *
@@ -139,24 +198,299 @@ public:
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   rclcpp::Time get_trajectory_start_time() const { return trajectory_start_time_; }
 
+  /// Start the trajectory at \p start_time instead of the stamp of its msg, 0 starts it when
+  /// sampled the first time.
+  /**
+   * \pre The trajectory was not sampled yet.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_trajectory_start_time(const rclcpp::Time & start_time)
+  {
+    trajectory_start_time_ = start_time;
+  }
+
   JOINT_TRAJECTORY_CONTROLLER_PUBLIC
   bool is_sampled_already() const { return sampled_already_; }
 
+  /// True if the msg was compiled, sampling doesn't change the msg then.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool is_compiled() const { return is_compiled_; }
+
+  /// Approximate bytes on the heap held by the trajectory: its msg, the compiled points and the
+  /// spline coefficients.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  size_t heap_bytes() const;
+
+  /// Identifier of the stream of spliced trajectories this one belongs to, 0 if none.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  uint64_t get_stream_id() const { return stream_id_; }
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_stream_id(uint64_t stream_id) { stream_id_ = stream_id; }
+
+  /// False while further points are to be spliced into the trajectory, e.g. the next window of a
+  /// trajectory file. Its goal is not finished at its last point then.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool is_final() const { return final_; }
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_final(bool is_final) { final_ = is_final; }
+
+  /**
+   * \brief Keep the compiled points and spline coefficients in single precision from the next
+   * update() on.
+   *
+   * Halves their memory for long trajectories. The segments are evaluated in single precision
+   * then, see evaluate_compact_splines() for the error. The times of the points, the first point
+   * and the segment to it stay in double precision.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_single_precision(bool single_precision) { single_precision_ = single_precision; }
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool is_single_precision() const { return single_precision_; }
+
+  /**
+   * \brief Compute the spline coefficients of only the first \p initial_segments segments in the
+   * next update(), 0 computes all of them.
+   *
+   * The other segments are computed by compile_segments(), which may run on another thread while
+   * the trajectory is sampled, so a long trajectory starts without waiting for all of them. If
+   * sampling reaches a segment which is not computed yet, the trajectory holds the point the
+   * segment starts from at rest, and continues from there once the segment is computed, see
+   * get_hold_duration(). Not applied in single precision, which converts all segments at once.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void set_progressive_compilation(size_t initial_segments)
+  {
+    initial_segments_ = initial_segments;
+  }
+
+  /// Compute the spline coefficients of up to \p count further segments after update().
+  /**
+   * Not realtime-safe. May be called from one other thread while the trajectory is sampled.
+   *
+   * \return true if the coefficients of all segments are computed.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool compile_segments(size_t count);
+
+  /// True if the coefficients of all segments are computed, or the msg could not be compiled.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool is_fully_compiled() const;
+
+  /// Time sampling was held at a segment which was not computed yet. The points are reached
+  /// this much later than their time_from_start.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  rclcpp::Duration get_hold_duration() const
+  {
+    return rclcpp::Duration::from_nanoseconds(hold_ns_.load(std::memory_order_relaxed));
+  }
+
 private:
+  /// std::atomic which copies its value, so the trajectory stays copyable
+  template <typename T>
+  struct CopyableAtomic : std::atomic<T>
+  {
+    CopyableAtomic() : std::atomic<T>(T()) {}
+    CopyableAtomic(const CopyableAtomic & other) : std::atomic<T>(other.load()) {}
+    CopyableAtomic & operator=(const CopyableAtomic & other)
+    {
+      this->store(other.load());
+      return *this;
+    }
+  };
+
   void deduce_from_derivatives(
     trajectory_msgs::msg::JointTrajectoryPoint & first_state,
     trajectory_msgs::msg::JointTrajectoryPoint & second_state, const size_t dim,
     const double delta_t);
 
+  /// Fill the absolute time of every point once the trajectory start time is known.
+  void update_point_times();
+
+  /// Find the index of the segment start point containing \p sample_time [ns].
+  /**
+   * The search resumes from the segment found in the previous call, so consecutive samples
+   * advancing through the trajectory are resolved in constant time. If \p sample_time jumped
+   * backwards or far ahead, a binary search over the absolute point times is used instead.
+   *
+   * \pre \p sample_time is not earlier than the first point of the trajectory.
+   * \return Index of the segment start point, or the index of the last point if
+   * \p sample_time is after the whole trajectory.
+   */
+  size_t find_segment_index(const int64_t sample_time);
+
+  /// interpolate_between_points() on the nanosecond timeline of the trajectory.
+  void interpolate_segment(
+    const int64_t time_a, const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
+    const int64_t time_b, const trajectory_msgs::msg::JointTrajectoryPoint & state_b,
+    const int64_t sample_time, trajectory_msgs::msg::JointTrajectoryPoint & output);
+
+  /// Compute the spline coefficients of all segments between the points of the trajectory msg.
+  /**
+   * This is skipped if the trajectory msg could not be compiled, e.g. any point lacks positions,
+   * because they are deduced from the derivatives while sampling. In that case the trajectory is
+   * interpolated from the msg on every sample instead.
+   */
+  void compute_segment_coefficients();
+
+  /// Compute the spline coefficients of the segments from \p first to before \p last in double
+  /// precision.
+  void compute_segments(size_t first, size_t last);
+
+  /// Fill blend_end_state_ with the state the first segment of the trajectory starts with.
+  void compute_blend_end_state();
+
+  /// Compute the spline coefficients of the segment from the state before the trajectory msg.
+  /**
+   * Skipped if the trajectory msg could not be compiled, or the state before it has a different
+   * number of joints.
+   */
+  void compute_first_segment_coefficients();
+
+  /// Evaluate the precomputed spline \p coefficients of a segment at \p t seconds into it.
+  /**
+   * \pre positions, velocities and accelerations of \p output have the size of the compiled
+   * trajectory.
+   */
+  void evaluate_segment(
+    const double * coefficients, const double t,
+    trajectory_msgs::msg::JointTrajectoryPoint & output) const;
+
+  /// Evaluate the segment starting at point \p index at \p t seconds into it, in the precision
+  /// the coefficients are kept in, with the same precondition as evaluate_segment().
+  void evaluate_compiled_segment(
+    size_t index, const double t, trajectory_msgs::msg::JointTrajectoryPoint & output) const;
+
+  /// Copy the compiled point at \p index to \p output, from where its values are kept.
+  void copy_compiled_point(
+    size_t index, trajectory_msgs::msg::JointTrajectoryPoint & output) const;
+
   std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg_;
   rclcpp::Time trajectory_start_time_;
 
-  rclcpp::Time time_before_traj_msg_;
+  /// Absolute time of every point in trajectory_msg_ [ns], i.e. start time + time_from_start.
+  /// Sampling compares and subtracts these as integers, without the clock type checks of
+  /// rclcpp::Time, and converts only the time into the segment to seconds.
+  std::vector<int64_t> point_times_;
+  /// Index of the segment start point found by the last call to sample()
+  size_t segment_cursor_ = 0;
+
+  /// Contiguous copy of trajectory_msg_, which is then kept only for introspection
+  CompiledTrajectory compiled_;
+  /// True if trajectory_msg_ could be compiled, the spline coefficients are valid then
+  bool is_compiled_ = false;
+  /// Spline coefficients, contiguous per segment, then coefficient and joint, starting with the
+  /// first point. Only those of the first segment if is_compact_.
+  std::vector<double> segment_coefficients_;
+  /// Requested by set_single_precision() for the next update()
+  bool single_precision_ = false;
+  /// Requested by set_progressive_compilation() for the next update()
+  size_t initial_segments_ = 0;
+  /// Number of segments from the first one whose coefficients are computed, published by
+  /// compile_segments() to the sampling thread
+  CopyableAtomic<size_t> compiled_segments_;
+  /// Time sampling was held at the first segment not computed yet [ns], written by sample()
+  CopyableAtomic<int64_t> hold_ns_;
+  /// Whether the compiled values after the first point are kept in compact_compiled_, and the
+  /// spline coefficients in compact_segment_coefficients_
+  bool is_compact_ = false;
+  CompactCompiledTrajectory compact_compiled_;
+  std::vector<float> compact_segment_coefficients_;
+  /// Spline coefficients of the segment between the state before the trajectory and its first
+  /// point, computed on the first sample after set_point_before_trajectory_msg()
+  /// and so not changed by sampling afterwards
+  std::vector<double> first_segment_coefficients_;
+  bool first_segment_coefficients_valid_ = false;
+  /// True if the segment to the first point blends into the trajectory, see
+  /// set_blend_before_trajectory_msg()
+  bool blend_into_first_segment_ = false;
+  /// Position, velocity and acceleration at the first point the blend ends in, preallocated
+  trajectory_msgs::msg::JointTrajectoryPoint blend_end_state_;
+
+  /// Time of state_before_traj_msg_ [ns], on the timeline of point_times_
+  int64_t time_before_traj_msg_ = 0;
   trajectory_msgs::msg::JointTrajectoryPoint state_before_traj_msg_;
 
   bool sampled_already_ = false;
+  uint64_t stream_id_ = 0;
+  bool final_ = true;
 };
 
+/// Limits of a joint for time-parameterizing trajectories, 0.0 if not limited
+struct MotionLimits
+{
+  double max_velocity = 0.0;
+  double max_acceleration = 0.0;
+};
+
+/**
+ * \brief Time-parameterize the waypoints of \p trajectory for \p interpolation_method.
+ *
+ * With MINIMUM_JERK and TRAPEZOIDAL, the trajectory stops at every waypoint and moves between them
+ * with the respective profile, synchronized for all joints. Every segment between two waypoints
+ * is stretched if a joint would exceed its \p limits within the time given by time_from_start,
+ * which delays the following waypoints. The velocities and accelerations of the waypoints are
+ * replaced. For TRAPEZOIDAL, the ends of the acceleration and the deceleration phase are inserted
+ * as points, so the profile is sampled exactly by the splines between the points.
+ *
+ * Other interpolation methods, and trajectories with points without positions, are left
+ * unchanged. The segment before the first waypoint is not changed either, as it starts from the
+ * state before the trajectory.
+ *
+ * \param[in,out] trajectory Trajectory msg in the local joint order.
+ * \param[in] interpolation_method Interpolation method the trajectory is sampled with.
+ * \param[in] limits Limits of every joint.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void time_parameterize_trajectory_msg(
+  trajectory_msgs::msg::JointTrajectory & trajectory,
+  const interpolation_methods::InterpolationMethod interpolation_method,
+  const std::vector<MotionLimits> & limits);
+
+/**
+ * \brief Remove the points of \p trajectory the splines through the remaining points reconstruct
+ * within \p tolerances.
+ *
+ * The points are removed by the Ramer-Douglas-Peucker algorithm on the splines the Trajectory
+ * interpolates with: the segment between two kept points replaces the points between them, if
+ * its positions at their time_from_start deviate from theirs by at most the tolerance of every
+ * joint. Otherwise the point deviating most relative to the tolerances is kept, and both halves are
+ * simplified the same way. The first and the last point are always kept. The velocities and
+ * accelerations of the removed points are not bounded, only given ones are interpolated.
+ *
+ * Trajectories whose points don't all have the same fields for all joints, or have efforts, are
+ * left as they are. This takes O(n log n) time for n points on typical trajectories, and O(n^2) at
+ * worst.
+ *
+ * \param[in,out] trajectory Trajectory msg with its joints in the order of \p tolerances.
+ * \param[in] tolerances Maximum position deviation of every joint, 0.0 to keep its positions.
+ * \return Number of points removed.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+size_t simplify_trajectory_msg(
+  trajectory_msgs::msg::JointTrajectory & trajectory, const std::vector<double> & tolerances);
+
+/**
+ * \brief Splice the points of \p chunk into \p trajectory.
+ *
+ * The points of \p trajectory from the first point of \p chunk on are replaced with the points of
+ * \p chunk, whose time_from_start is shifted by \p chunk_offset. The points of \p trajectory
+ * before \p keep_from are dropped, except the last one of them, which starts the segment
+ * containing \p keep_from. The header of \p trajectory is kept.
+ *
+ * \param[in,out] trajectory Trajectory msg to splice into.
+ * \param[in] chunk Trajectory msg with the same joints in the same order as \p trajectory.
+ * \param[in] chunk_offset Start of \p chunk relative to the start of \p trajectory.
+ * \param[in] keep_from Time from the start of \p trajectory, which was executed already.
+ */
+JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+void splice_trajectory_msg(
+  trajectory_msgs::msg::JointTrajectory & trajectory,
+  const trajectory_msgs::msg::JointTrajectory & chunk, const rclcpp::Duration & chunk_offset,
+  const rclcpp::Duration & keep_from);
+
 /**
  * \return The map between \p t1 indices (implicitly encoded in return vector indices) to \p t2
  * indices. If \p t1 is <tt>"{C, B}"</tt> and \p t2 is <tt>"{A, B, C, D}"</tt>, the associated
@@ -0,0 +1,120 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_FILE_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/visibility_control.h"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Trajectory stored in a binary file, which is memory-mapped and read in windows of points.
+ *
+ * Only the pages of the points read are loaded, so a trajectory of any length is executed with a
+ * bounded amount of memory, see the parameters trajectory_files.* of the controller. All values
+ * are in the byte order of the host, which is little-endian on all supported platforms:
+ *
+ * \code
+ * offset  type      content
+ * 0       char[8]   "JTCTRAJ1"
+ * 8       uint32    number of joints J
+ * 12      uint32    fields: bit 0 set if the points have velocities, bit 1 accelerations
+ * 16      uint64    number of points N
+ * 24      uint64    size S of the joint names, a multiple of 8
+ * 32      char[S]   names of the J joints, each terminated by '\0', padded with '\0'
+ * 32 + S  N points, each an int64 time_from_start in nanoseconds followed by the J positions and,
+ *         if given, the J velocities and the J accelerations, as double
+ * \endcode
+ *
+ * The points are checked when they are read, so opening a file takes constant time.
+ */
+class TrajectoryFile
+{
+public:
+  /**
+   * \brief Map the trajectory file at \p path.
+   * \param[out] error Why the file can't be used, if nullptr is returned.
+   * \return nullptr if the file can't be mapped, or its header or joint names are invalid.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  static std::shared_ptr<const TrajectoryFile> open(const std::string & path, std::string & error);
+
+  /**
+   * \brief Write \p trajectory to \p path in the format read by open().
+   *
+   * All points need positions, and either all or none of them velocities or accelerations.
+   * \param[out] error Why the file was not written, if false is returned.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  static bool write(
+    const std::string & path, const trajectory_msgs::msg::JointTrajectory & trajectory,
+    std::string & error);
+
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  ~TrajectoryFile();
+
+  TrajectoryFile(const TrajectoryFile &) = delete;
+  TrajectoryFile & operator=(const TrajectoryFile &) = delete;
+
+  const std::vector<std::string> & joint_names() const { return joint_names_; }
+
+  /// Number of points in the file
+  size_t size() const { return point_count_; }
+
+  bool has_velocities() const { return has_velocities_; }
+  bool has_accelerations() const { return has_accelerations_; }
+
+  /// time_from_start of point \p index < size() in nanoseconds, without checking it
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  int64_t time_from_start_ns(size_t index) const;
+
+  /**
+   * \brief Append the points [\p begin, \p end) to the points of \p trajectory.
+   *
+   * The joints of the points are in the order of joint_names().
+   * \param[out] error Why the points are invalid, if false is returned.
+   * \return false if a time_from_start doesn't increase from the point before \p begin on, or a
+   * value isn't finite. \p trajectory has the points before the invalid one then.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  bool read_points(
+    size_t begin, size_t end, trajectory_msgs::msg::JointTrajectory & trajectory,
+    std::string & error) const;
+
+private:
+  TrajectoryFile() = default;
+
+  const unsigned char * data_ = nullptr;
+  size_t mapped_size_ = 0;
+
+  std::vector<std::string> joint_names_;
+  size_t point_count_ = 0;
+  bool has_velocities_ = false;
+  bool has_accelerations_ = false;
+  /// First point, and the size of a point in bytes
+  const unsigned char * points_ = nullptr;
+  size_t point_size_ = 0;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_FILE_HPP_
@@ -0,0 +1,88 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_POOL_HPP_
+#define JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_POOL_HPP_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "controller_realtime_tools/memory_prefault.hpp"
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "joint_trajectory_controller/visibility_control.h"
+
+namespace joint_trajectory_controller
+{
+/**
+ * \brief Pool of trajectories reused for the trajectories handed to the realtime loop.
+ *
+ * The pool keeps a reference to every trajectory it hands out, so the realtime loop never drops
+ * the last reference of a trajectory and never frees its memory. A trajectory is free again once
+ * only the pool references it, and acquire() hands it out again. Its msg is only released when it is
+ * set up for its next use, and its compiled points and coefficients keep their storage, which a
+ * trajectory of the same size reuses without allocating.
+ *
+ * Up to the capacity, trajectories are preallocated and kept. If all of them are in use, further
+ * trajectories are allocated, and freed by acquire() once they aren't used anymore.
+ *
+ * All methods are thread-safe, but not realtime-safe.
+ */
+class TrajectoryPool
+{
+public:
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  explicit TrajectoryPool(size_t capacity = 0);
+
+  /// Set the number of kept trajectories to \p capacity, and preallocate them.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void reserve(size_t capacity);
+
+  /**
+   * \brief Get a trajectory nobody else references.
+   *
+   * Its members are left from its previous use, so it has to be set up with Trajectory::update()
+   * or a copy assignment before it is handed out.
+   */
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  std::shared_ptr<Trajectory> acquire();
+
+  /// Number of trajectories in the pool, in use or not.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  size_t size() const;
+
+  /// Number of trajectories of the pool nobody else references.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  size_t available() const;
+
+  size_t capacity() const { return capacity_; }
+
+  /// Add the memory of the trajectories of the pool to \p prefaulter.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void add_to(controller_realtime_tools::MemoryPrefaulter & prefaulter);
+
+  /// Drop the references of the pool, trajectories in use are freed by their last user then.
+  JOINT_TRAJECTORY_CONTROLLER_PUBLIC
+  void clear();
+
+private:
+  /// The first capacity_ entries are kept, the others are freed once unused
+  std::vector<std::shared_ptr<Trajectory>> trajectories_;
+  size_t capacity_ = 0;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace joint_trajectory_controller
+
+#endif  // JOINT_TRAJECTORY_CONTROLLER__TRAJECTORY_POOL_HPP_
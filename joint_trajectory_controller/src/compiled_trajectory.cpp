@@ -0,0 +1,194 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/compiled_trajectory.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "rclcpp/duration.hpp"
+
+namespace joint_trajectory_controller
+{
+bool CompiledTrajectory::compile(const trajectory_msgs::msg::JointTrajectory & trajectory)
+{
+  clear();
+
+  const auto & points = trajectory.points;
+  if (points.empty() || points[0].positions.empty())
+  {
+    return false;
+  }
+
+  // a field is either given with the full size for all points or for none of them
+  const size_t n_joints = points[0].positions.size();
+  auto is_consistent = [&points, n_joints](auto field)
+  {
+    const bool given = !(points[0].*field).empty();
+    return std::all_of(
+      points.begin(), points.end(),
+      [field, given, n_joints](const trajectory_msgs::msg::JointTrajectoryPoint & point)
+      { return (point.*field).size() == (given ? n_joints : 0); });
+  };
+  using Point = trajectory_msgs::msg::JointTrajectoryPoint;
+  if (
+    !is_consistent(&Point::positions) || !is_consistent(&Point::velocities) ||
+    !is_consistent(&Point::accelerations) || !is_consistent(&Point::effort))
+  {
+    return false;
+  }
+
+  dof = n_joints;
+  const size_t n_values = points.size() * dof;
+  time_from_start.resize(points.size());
+  positions.resize(n_values);
+  velocities.resize(points[0].velocities.empty() ? 0 : n_values);
+  accelerations.resize(points[0].accelerations.empty() ? 0 : n_values);
+  effort.resize(points[0].effort.empty() ? 0 : n_values);
+
+  auto copy_field =
+    [this](const std::vector<double> & field, std::vector<double> & storage, const size_t k)
+  {
+    const auto first = storage.begin() + static_cast<std::ptrdiff_t>(k * dof);
+    std::copy(field.begin(), field.end(), first);
+  };
+  for (size_t k = 0; k < points.size(); ++k)
+  {
+    time_from_start[k] = rclcpp::Duration(points[k].time_from_start).nanoseconds();
+    copy_field(points[k].positions, positions, k);
+    copy_field(points[k].velocities, velocities, k);
+    copy_field(points[k].accelerations, accelerations, k);
+    copy_field(points[k].effort, effort, k);
+  }
+
+  // a joint holds if its position is the same at all points, without velocity and acceleration
+  auto is_zero = [this](const std::vector<double> & field, const size_t joint)
+  {
+    for (size_t index = joint; index < field.size(); index += dof)
+    {
+      if (field[index] != 0.0)
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+  moving_joints.reserve(dof);
+  held_joints.reserve(dof);
+  for (size_t joint = 0; joint < dof; ++joint)
+  {
+    bool held = is_zero(velocities, joint) && is_zero(accelerations, joint);
+    for (size_t index = joint + dof; held && index < positions.size(); index += dof)
+    {
+      held = positions[index] == positions[joint];
+    }
+    (held ? held_joints : moving_joints).push_back(joint);
+  }
+  return true;
+}
+
+void CompiledTrajectory::clear()
+{
+  dof = 0;
+  time_from_start.clear();
+  positions.clear();
+  velocities.clear();
+  accelerations.clear();
+  effort.clear();
+  moving_joints.clear();
+  held_joints.clear();
+}
+
+void CompiledTrajectory::copy_point(
+  size_t index, trajectory_msgs::msg::JointTrajectoryPoint & output) const
+{
+  auto copy_field = [this, index](const std::vector<double> & storage, std::vector<double> & field)
+  {
+    if (storage.empty())
+    {
+      field.clear();
+      return;
+    }
+    const auto first = storage.begin() + static_cast<std::ptrdiff_t>(index * dof);
+    field.assign(first, first + static_cast<std::ptrdiff_t>(dof));
+  };
+  copy_field(positions, output.positions);
+  copy_field(velocities, output.velocities);
+  copy_field(accelerations, output.accelerations);
+  copy_field(effort, output.effort);
+  output.time_from_start = rclcpp::Duration::from_nanoseconds(time_from_start[index]);
+}
+
+void CompiledTrajectory::release_values_after_first_point()
+{
+  for (auto * field : {&positions, &velocities, &accelerations, &effort})
+  {
+    if (!field->empty())
+    {
+      field->resize(dof);
+      field->shrink_to_fit();
+    }
+  }
+}
+
+void CompactCompiledTrajectory::assign(const CompiledTrajectory & compiled)
+{
+  dof = compiled.dof;
+  auto round_field = [](const std::vector<double> & values, std::vector<float> & storage)
+  {
+    storage.resize(values.size());
+    for (size_t index = 0; index < values.size(); ++index)
+    {
+      storage[index] = static_cast<float>(values[index]);
+    }
+  };
+  round_field(compiled.positions, positions);
+  round_field(compiled.velocities, velocities);
+  round_field(compiled.accelerations, accelerations);
+  round_field(compiled.effort, effort);
+}
+
+void CompactCompiledTrajectory::clear()
+{
+  dof = 0;
+  positions.clear();
+  velocities.clear();
+  accelerations.clear();
+  effort.clear();
+}
+
+void CompactCompiledTrajectory::copy_point(
+  size_t index, trajectory_msgs::msg::JointTrajectoryPoint & output) const
+{
+  auto copy_field = [this, index](const std::vector<float> & storage, std::vector<double> & field)
+  {
+    if (storage.empty())
+    {
+      field.clear();
+      return;
+    }
+    // within the capacity of previous samples
+    field.resize(dof);
+    for (size_t joint = 0; joint < dof; ++joint)
+    {
+      field[joint] = static_cast<double>(storage[index * dof + joint]);
+    }
+  };
+  copy_field(positions, output.positions);
+  copy_field(velocities, output.velocities);
+  copy_field(accelerations, output.accelerations);
+  copy_field(effort, output.effort);
+}
+
+}  // namespace joint_trajectory_controller
@@ -15,18 +15,27 @@
 #include "joint_trajectory_controller/joint_trajectory_controller.hpp"
 
 #include <stddef.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <ostream>
 #include <ratio>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "angles/angles.h"
 #include "builtin_interfaces/msg/duration.hpp"
 #include "builtin_interfaces/msg/time.hpp"
-#include "controller_interface/helpers.hpp"
+#include "controller_realtime_tools/metrics.hpp"
+#include "controller_realtime_tools/nan_scan.hpp"
+#include "controller_realtime_tools/tracing.hpp"
 #include "hardware_interface/types/hardware_interface_return_values.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "joint_trajectory_controller/trajectory.hpp"
@@ -45,8 +54,98 @@
 
 namespace joint_trajectory_controller
 {
+namespace
+{
+/// Prefix of the header.frame_id of goals referring to a trajectory file
+constexpr char TRAJECTORY_FILE_PREFIX[] = "file:";
+
+/// Read the values of the first \p count \p interfaces into \p values
+template <typename InterfaceT>
+void gather_values(InterfaceT * const * interfaces, size_t count, double * values)
+{
+  for (size_t index = 0; index < count; ++index)
+  {
+    values[index] = interfaces[index]->get_value();
+  }
+}
+
+/// Write \p values to the first \p count \p interfaces
+void scatter_values(
+  const double * values, size_t count,
+  hardware_interface::LoanedCommandInterface * const * interfaces)
+{
+  for (size_t index = 0; index < count; ++index)
+  {
+    interfaces[index]->set_value(values[index]);
+  }
+}
+
+/// Read the values of the first \p count \p interfaces into \p values, resized to \p count
+/**
+ * The values are gathered first and then checked for NaN in one vectorized pass.
+ * \return false, with \p values cleared, if any of them is NaN
+ */
+template <typename InterfaceT>
+bool gather_valid_values(
+  InterfaceT * const * interfaces, size_t count, std::vector<double> & values)
+{
+  // within the capacity reserved on configure, also after having been cleared
+  values.resize(count);
+  gather_values(interfaces, count, values.data());
+  if (controller_realtime_tools::any_nan(values))
+  {
+    values.clear();
+    return false;
+  }
+  return true;
+}
+
+/// Add the buffers of \p point, a JointTrajectoryPoint or a JointVectors, to \p prefaulter
+template <typename PointT>
+void add_point(controller_realtime_tools::MemoryPrefaulter & prefaulter, PointT & point)
+{
+  prefaulter.add(point.positions);
+  prefaulter.add(point.velocities);
+  prefaulter.add(point.accelerations);
+  prefaulter.add(point.effort);
+}
+
+/// Add the buffers of \p feedback to \p prefaulter
+void add_feedback(
+  controller_realtime_tools::MemoryPrefaulter & prefaulter,
+  control_msgs::action::FollowJointTrajectory::Feedback & feedback)
+{
+  prefaulter.add(feedback.joint_names);
+  add_point(prefaulter, feedback.desired);
+  add_point(prefaulter, feedback.actual);
+  add_point(prefaulter, feedback.error);
+}
+
+/// Copy the values of the \p joints of \p point, a JointTrajectoryPoint or a JointVectors, to
+/// \p group_point, in the order of \p joints
+template <typename PointT>
+void gather_joints(
+  const PointT & point, const std::vector<size_t> & joints,
+  trajectory_msgs::msg::JointTrajectoryPoint & group_point)
+{
+  const auto gather = [&joints](const std::vector<double> & values, std::vector<double> & group)
+  {
+    // within the reserved capacity
+    group.resize(values.empty() ? 0 : joints.size());
+    for (size_t index = 0; index < group.size(); ++index)
+    {
+      group[index] = values[joints[index]];
+    }
+  };
+  gather(point.positions, group_point.positions);
+  gather(point.velocities, group_point.velocities);
+  gather(point.accelerations, group_point.accelerations);
+  gather(point.effort, group_point.effort);
+}
+}  // namespace
+
 JointTrajectoryController::JointTrajectoryController()
-: controller_interface::ControllerInterface(), dof_(0)
+: controller_interface::ChainableControllerInterface(), dof_(0)
 {
 }
 
@@ -89,6 +188,12 @@ JointTrajectoryController::command_interface_configuration() const
       conf.names.push_back(joint_name + "/" + interface_type);
     }
   }
+  if (command_sequence_)
+  {
+    conf.names.insert(
+      conf.names.end(), command_sequence_order_.names().begin(),
+      command_sequence_order_.names().end());
+  }
   return conf;
 }
 
@@ -108,17 +213,68 @@ JointTrajectoryController::state_interface_configuration() const
   return conf;
 }
 
-controller_interface::return_type JointTrajectoryController::update(
+std::vector<hardware_interface::CommandInterface>
+JointTrajectoryController::on_export_reference_interfaces()
+{
+  std::vector<hardware_interface::CommandInterface> reference_interfaces;
+  reference_interfaces.reserve(2 * dof_);
+  reference_interfaces_.assign(2 * dof_, std::numeric_limits<double>::quiet_NaN());
+  for (const auto & interface :
+       {hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY})
+  {
+    for (const auto & joint : params_.joints)
+    {
+      reference_interfaces.emplace_back(hardware_interface::CommandInterface(
+        get_node()->get_name(), joint + "/" + interface,
+        reference_interfaces_.data() + reference_interfaces.size()));
+    }
+  }
+  return reference_interfaces;
+}
+
+bool JointTrajectoryController::on_set_chained_mode(bool /*chained_mode*/)
+{
+  // the mode is only switched while inactive, on_activate() starts from the current state anyway
+  return true;
+}
+
+controller_interface::return_type JointTrajectoryController::update_reference_from_subscribers(
+  const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+{
+  // trajectories received are swapped in by update_and_write_commands(), the references are only
+  // used in chained mode
+  return controller_interface::return_type::OK;
+}
+
+controller_interface::return_type JointTrajectoryController::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
   if (get_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
   {
     return controller_interface::return_type::OK;
   }
+  controller_realtime_tools::ScopedAllocationCounting allocation_counting(allocation_counter_);
+  controller_realtime_tools::CycleBudget::Scope cycle_budget_scope(cycle_budget_.get());
+  if (cycle_timing_)
+  {
+    cycle_timing_->start_cycle();
+  }
+  if (input_recorder_)
+  {
+    input_recorder_->record(
+      time.nanoseconds(), period.nanoseconds(), state_interfaces_, reference_interfaces_);
+  }
+  auto end_phase = [this](CyclePhase phase)
+  {
+    if (cycle_timing_)
+    {
+      cycle_timing_->end_phase(phase);
+    }
+  };
 
   auto compute_error_for_joint = [&](
-                                   JointTrajectoryPoint & error, size_t index,
-                                   const JointTrajectoryPoint & current,
+                                   controller_realtime_tools::JointVectors & error, size_t index,
+                                   const controller_realtime_tools::JointVectors & current,
                                    const JointTrajectoryPoint & desired)
   {
     // error defined as the difference between current and desired
@@ -143,43 +299,165 @@ controller_interface::return_type JointTrajectoryController::update(
     }
   };
 
-  // Check if a new external message has been received from nonRT threads
-  auto current_external_msg = traj_external_point_ptr_->get_trajectory_msg();
-  auto new_external_msg = traj_msg_external_point_ptr_.readFromRT();
-  if (current_external_msg != *new_external_msg)
-  {
-    fill_partial_goal(*new_external_msg);
-    sort_to_local_joint_order(*new_external_msg);
+  // Check if a new external trajectory has been received from nonRT threads. It is already
+  // preprocessed, so it only has to be swapped in
+  const auto new_external_trajectory = *traj_external_point_buffer_.readFromRT();
+  // the executed trajectory differs from the buffered one after a queued goal was started
+  if (
+    new_external_trajectory && new_external_trajectory.get() != rt_buffered_trajectory_ &&
+    traj_external_point_ptr_ != new_external_trajectory)
+  {
+    blend_into_new_trajectory_ = false;
+    // a trajectory spliced into the executed one continues where that one stands
+    if (
+      traj_external_point_ptr_ && new_external_trajectory->get_stream_id() != 0 &&
+      new_external_trajectory->get_stream_id() == traj_external_point_ptr_->get_stream_id() &&
+      traj_external_point_ptr_->is_sampled_already())
+    {
+      new_external_trajectory->continue_from(*traj_external_point_ptr_);
+    }
+    // otherwise it may blend from the state the replaced trajectory would be in now
+    else if (
+      params_.blend_replaced_trajectories &&
+      interpolation_method_ != interpolation_methods::InterpolationMethod::NONE &&
+      traj_point_active_ptr_ && (*traj_point_active_ptr_) &&
+      (*traj_point_active_ptr_)->has_trajectory_msg() &&
+      (*traj_point_active_ptr_)->is_sampled_already())
+    {
+      TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+      blend_into_new_trajectory_ = (*traj_point_active_ptr_)->sample(
+        time, interpolation_method_, blend_state_, start_segment_itr, end_segment_itr);
+    }
     // TODO(denis): Add here integration of position and velocity
-    traj_external_point_ptr_->update(*new_external_msg);
+    traj_external_point_ptr_ = new_external_trajectory;
+    rt_buffered_trajectory_ = new_external_trajectory.get();
     // set the active trajectory pointer to the new goal
     traj_point_active_ptr_ = &traj_external_point_ptr_;
+    new_trajectory_unwritten_ = true;
+    CONTROLLER_TRACEPOINT(
+      TRAJECTORY_ACTIVATED, this,
+      traj_external_point_ptr_->end() - traj_external_point_ptr_->begin());
   }
 
-  // TODO(anyone): can I here also use const on joint_interface since the reference_wrapper is not
-  // changed, but its value only?
+  // write the values of one interface type of the point to its command interfaces
   auto assign_interface_from_point =
-    [&](auto & joint_interface, const std::vector<double> & trajectory_point_interface)
+    [&](size_t type_index, const std::vector<double> & trajectory_point_interface)
+  { scatter_values(trajectory_point_interface.data(), dof_, command_interfaces_of(type_index)); };
+
+  // state written to the command interfaces, ahead of state_desired_ with command_lookahead
+  const JointTrajectoryPoint * command_state = &state_desired_;
+
+  // set values for next hardware write(), with the command of the closed loop pid adapter if
+  // use_pid_command is set
+  auto write_commands = [&](bool use_pid_command)
   {
-    for (size_t index = 0; index < dof_; ++index)
+    if (use_closed_loop_pid_adapter_)
+    {
+      // Update PIDs
+      pids_.compute_commands(
+        state_error_.positions.data(), state_error_.velocities.data(),
+        static_cast<double>(period.nanoseconds()) / 1e9, tmp_command_.data());
+      for (auto i = 0ul; i < dof_; ++i)
+      {
+        tmp_command_[i] += command_state->velocities[i] * ff_velocity_scale_[i];
+      }
+      end_phase(PID);
+    }
+
+    if (has_position_command_interface_)
+    {
+      assign_interface_from_point(0, command_state->positions);
+    }
+    if (has_velocity_command_interface_)
+    {
+      if (use_pid_command && use_closed_loop_pid_adapter_)
+      {
+        assign_interface_from_point(1, tmp_command_);
+      }
+      else
+      {
+        assign_interface_from_point(1, command_state->velocities);
+      }
+    }
+    if (has_acceleration_command_interface_)
+    {
+      assign_interface_from_point(2, command_state->accelerations);
+    }
+    if (has_effort_command_interface_)
+    {
+      if (use_pid_command && use_closed_loop_pid_adapter_)
+      {
+        assign_interface_from_point(3, tmp_command_);
+      }
+      else
+      {
+        assign_interface_from_point(3, command_state->effort);
+      }
+    }
+
+    if (command_sequence_)
+    {
+      for (size_t index = 0; index < command_sequence_->size(); ++index)
+      {
+        command_sequence_interfaces_[index]->set_value(
+          command_sequence_->update(index, command_sequence_sources_[index]->get_value()));
+      }
+    }
+
+    // store the previous command. Used in open-loop control mode
+    last_commanded_state_ = state_desired_;
+    end_phase(WRITE_COMMANDS);
+
+    if (command_latency_ && new_trajectory_unwritten_)
     {
-      joint_interface[index].get().set_value(trajectory_point_interface[index]);
+      command_latency_->command_written(time.nanoseconds());
+      new_trajectory_unwritten_ = false;
     }
   };
 
   // current state update
-  state_current_.time_from_start.set__sec(0);
   read_state_from_hardware(state_current_);
+  end_phase(READ_STATE);
+  // goal whose trajectory is executed in this update, if any
+  const RealtimeGoalHandle * executed_goal = nullptr;
 
+  // the preceding controller gives the desired state, trajectories are not executed meanwhile
+  if (is_in_chained_mode())
+  {
+    read_state_from_reference_interfaces(state_desired_, period);
+    for (size_t index = 0; index < dof_; ++index)
+    {
+      compute_error_for_joint(state_error_, index, state_current_, state_desired_);
+    }
+    end_phase(SAMPLE);
+    write_commands(true);
+  }
+  // the groups execute their own trajectories, all joints are commanded in one pass
+  else if (!joint_groups_.empty())
+  {
+    sample_joint_groups(time);
+    for (size_t index = 0; index < dof_; ++index)
+    {
+      compute_error_for_joint(state_error_, index, state_current_, state_desired_);
+    }
+    end_phase(SAMPLE);
+    check_joint_groups(time);
+    end_phase(TOLERANCES);
+    write_commands(true);
+  }
   // currently carrying out a trajectory
-  if (traj_point_active_ptr_ && (*traj_point_active_ptr_)->has_trajectory_msg())
+  else if (traj_point_active_ptr_ && (*traj_point_active_ptr_)->has_trajectory_msg())
   {
     bool first_sample = false;
     // if sampling the first time, set the point before you sample
     if (!(*traj_point_active_ptr_)->is_sampled_already())
     {
       first_sample = true;
-      if (params_.open_loop_control)
+      if (blend_into_new_trajectory_)
+      {
+        (*traj_point_active_ptr_)->set_blend_before_trajectory_msg(time, blend_state_);
+      }
+      else if (params_.open_loop_control)
       {
         (*traj_point_active_ptr_)->set_point_before_trajectory_msg(time, last_commanded_state_);
       }
@@ -187,6 +465,7 @@ controller_interface::return_type JointTrajectoryController::update(
       {
         (*traj_point_active_ptr_)->set_point_before_trajectory_msg(time, state_current_);
       }
+      blend_into_new_trajectory_ = false;
     }
 
     // find segment for current timestamp
@@ -195,6 +474,30 @@ controller_interface::return_type JointTrajectoryController::update(
       (*traj_point_active_ptr_)
         ->sample(time, interpolation_method_, state_desired_, start_segment_itr, end_segment_itr);
 
+    // the hardware executes the commands late, so they are sampled ahead. Without a compiled
+    // trajectory, the desired state is commanded
+    bool lookahead_after_last_point = false;
+    if (
+      valid_point && params_.command_lookahead > 0.0 &&
+      (*traj_point_active_ptr_)
+        ->sample_at(
+          time + rclcpp::Duration::from_seconds(params_.command_lookahead), interpolation_method_,
+          lookahead_state_, lookahead_after_last_point))
+    {
+      command_state = &lookahead_state_;
+    }
+
+    const uint64_t stream_id = (*traj_point_active_ptr_)->get_stream_id();
+    if (stream_id != 0)
+    {
+      // the nonRT threads splice the next msg of the stream in at this time
+      active_stream_elapsed_ns_.store(
+        (time - (*traj_point_active_ptr_)->get_trajectory_start_time()).nanoseconds(),
+        std::memory_order_relaxed);
+      active_stream_id_.store(stream_id, std::memory_order_relaxed);
+    }
+    end_phase(SAMPLE);
+
     if (valid_point)
     {
       bool tolerance_violated_while_moving = false;
@@ -203,56 +506,68 @@ controller_interface::return_type JointTrajectoryController::update(
       double time_difference = 0.0;
       const bool before_last_point = end_segment_itr != (*traj_point_active_ptr_)->end();
 
-      // Check state/goal tolerance
       for (size_t index = 0; index < dof_; ++index)
       {
         compute_error_for_joint(state_error_, index, state_current_, state_desired_);
+      }
 
-        // Always check the state tolerance on the first sample in case the first sample
-        // is the last point
-        if (
-          (before_last_point || first_sample) &&
-          !check_state_tolerance_per_joint(
-            state_error_, index, default_tolerances_.state_tolerance[index], false))
-        {
-          tolerance_violated_while_moving = true;
-        }
-        // past the final point, check that we end up inside goal tolerance
-        if (
-          !before_last_point &&
-          !check_state_tolerance_per_joint(
-            state_error_, index, default_tolerances_.goal_state_tolerance[index], false))
-        {
-          outside_goal_tolerance = true;
+      // Check state/goal tolerance
+      // Always check the state tolerance on the first sample in case the first sample
+      // is the last point
+      ToleranceViolations state_violations;
+      if (before_last_point || first_sample)
+      {
+        state_violations = check_state_tolerance(state_error_, state_tolerances_);
+        tolerance_violated_while_moving = state_violations.any();
+      }
+      // past the final point, check that we end up inside goal tolerance
+      if (!before_last_point)
+      {
+        outside_goal_tolerance = check_state_tolerance(state_error_, goal_state_tolerances_).any();
+      }
 
-          if (default_tolerances_.goal_time_tolerance != 0.0)
-          {
-            // if we exceed goal_time_tolerance set it to aborted
-            const rclcpp::Time traj_start = (*traj_point_active_ptr_)->get_trajectory_start_time();
-            const rclcpp::Time traj_end = traj_start + start_segment_itr->time_from_start;
+      if (outside_goal_tolerance && default_tolerances_.goal_time_tolerance != 0.0)
+      {
+        // if we exceed goal_time_tolerance set it to aborted
+        const rclcpp::Time traj_start = (*traj_point_active_ptr_)->get_trajectory_start_time();
+        // reached later by the time the trajectory held for segments which were not compiled
+        const rclcpp::Time traj_end = traj_start + start_segment_itr->time_from_start +
+                                      (*traj_point_active_ptr_)->get_hold_duration();
 
-            time_difference = get_node()->now().seconds() - traj_end.seconds();
+        time_difference = time.seconds() - traj_end.seconds();
 
-            if (time_difference > default_tolerances_.goal_time_tolerance)
-            {
-              within_goal_time = false;
-            }
-          }
+        if (time_difference > default_tolerances_.goal_time_tolerance)
+        {
+          within_goal_time = false;
         }
       }
 
-      const auto active_goal = *rt_active_goal_.readFromRT();
+      const auto active_goal = rt_active_goal_.get_from_rt();
+      executed_goal = active_goal.get();
       if (active_goal)
       {
-        // send feedback
-        auto feedback = std::make_shared<FollowJTrajAction::Feedback>();
-        feedback->header.stamp = time;
-        feedback->joint_names = params_.joints;
-
-        feedback->actual = state_current_;
-        feedback->desired = state_desired_;
-        feedback->error = state_error_;
-        active_goal->setFeedback(feedback);
+        // send feedback, decimated to action_feedback_rate
+        if (
+          time.nanoseconds() >= next_feedback_time_ns_ &&
+          !(cycle_budget_ && cycle_budget_->skip(SHED_ACTION_FEEDBACK)))
+        {
+          // fill whichever preallocated feedback isn't waiting to be published
+          auto & feedback = active_goal->preallocated_feedback_.use_count() == 1
+                              ? active_goal->preallocated_feedback_
+                              : rt_feedback_;
+          if (feedback.use_count() == 1)
+          {
+            // synchronize with the release of the feedback after publishing it
+            std::atomic_thread_fence(std::memory_order_acquire);
+            next_feedback_time_ns_ = time.nanoseconds() + action_feedback_period_.nanoseconds();
+            feedback->header.stamp = time;
+            state_current_.to_msg(feedback->actual);
+            feedback->desired = state_desired_;
+            state_error_.to_msg(feedback->error);
+            active_goal->setFeedback(feedback);
+            action_monitor_->notify();
+          }
+        }
 
         // check abort
         if (tolerance_violated_while_moving)
@@ -260,31 +575,53 @@ controller_interface::return_type JointTrajectoryController::update(
           set_hold_position();
           auto result = std::make_shared<FollowJTrajAction::Result>();
 
-          RCLCPP_WARN(get_node()->get_logger(), "Aborted due to state tolerance violation");
+          RCLCPP_WARN(
+            get_node()->get_logger(), "Aborted due to state tolerance violation of joint '%s'",
+            params_.joints[state_violations.first_joint].c_str());
           result->set__error_code(FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
           active_goal->setAborted(result);
-          // TODO(matthew-reynolds): Need a lock-free write here
-          // See https://github.com/ros-controls/ros2_controllers/issues/168
-          rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+          rt_active_goal_.reset_from_rt();
+          action_monitor_->notify();
           // remove the active trajectory pointer so that we stop commanding the hardware
           traj_point_active_ptr_ = nullptr;
 
-          // check goal tolerance
+          // check goal tolerance, once no points are left to be spliced into the trajectory
         }
-        else if (!before_last_point)
+        else if (!before_last_point && (*traj_point_active_ptr_)->is_final())
         {
           if (!outside_goal_tolerance)
           {
-            auto res = std::make_shared<FollowJTrajAction::Result>();
-            res->set__error_code(FollowJTrajAction::Result::SUCCESSFUL);
-            active_goal->setSucceeded(res);
-            // TODO(matthew-reynolds): Need a lock-free write here
-            // See https://github.com/ros-controls/ros2_controllers/issues/168
-            rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
-            // remove the active trajectory pointer so that we stop commanding the hardware
-            traj_point_active_ptr_ = nullptr;
-
-            RCLCPP_INFO(get_node()->get_logger(), "Goal reached, success!");
+            const auto next_goal = rt_active_goal_.get_next_from_rt();
+            const auto & queued_trajectory = queued_trajectory_.read();
+            // if the queued goal is being replaced, finish the goal once the newer one is queued
+            if (
+              !next_goal ||
+              (queued_trajectory.goal == next_goal.get() && rt_active_goal_.advance_from_rt()))
+            {
+              auto res = std::make_shared<FollowJTrajAction::Result>();
+              res->set__error_code(FollowJTrajAction::Result::SUCCESSFUL);
+              active_goal->setSucceeded(res);
+              if (next_goal)
+              {
+                // start the queued goal right away, it is sampled first on the next cycle
+                traj_external_point_ptr_ = queued_trajectory.trajectory;
+                traj_point_active_ptr_ = &traj_external_point_ptr_;
+                blend_into_new_trajectory_ = false;
+                new_trajectory_unwritten_ = true;
+                CONTROLLER_TRACEPOINT(
+                  TRAJECTORY_ACTIVATED, this,
+                  traj_external_point_ptr_->end() - traj_external_point_ptr_->begin());
+              }
+              else
+              {
+                rt_active_goal_.reset_from_rt();
+                // remove the active trajectory pointer so that we stop commanding the hardware
+                traj_point_active_ptr_ = nullptr;
+              }
+              action_monitor_->notify();
+
+              RCLCPP_INFO(get_node()->get_logger(), "Goal reached, success!");
+            }
           }
           else if (!within_goal_time)
           {
@@ -292,9 +629,8 @@ controller_interface::return_type JointTrajectoryController::update(
             auto result = std::make_shared<FollowJTrajAction::Result>();
             result->set__error_code(FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
             active_goal->setAborted(result);
-            // TODO(matthew-reynolds): Need a lock-free write here
-            // See https://github.com/ros-controls/ros2_controllers/issues/168
-            rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+            rt_active_goal_.reset_from_rt();
+            action_monitor_->notify();
             RCLCPP_WARN(
               get_node()->get_logger(), "Aborted due goal_time_tolerance exceeding by %f seconds",
               time_difference);
@@ -306,241 +642,424 @@ controller_interface::return_type JointTrajectoryController::update(
       else if (tolerance_violated_while_moving)
       {
         set_hold_position();
-        RCLCPP_ERROR(get_node()->get_logger(), "Holding position due to state tolerance violation");
+        RCLCPP_ERROR(
+          get_node()->get_logger(),
+          "Holding position due to state tolerance violation of joint '%s'",
+          params_.joints[state_violations.first_joint].c_str());
       }
 
+      end_phase(TOLERANCES);
+
       // set values for next hardware write() if tolerance is met
       if (!tolerance_violated_while_moving && within_goal_time)
       {
-        if (use_closed_loop_pid_adapter_)
-        {
-          // Update PIDs
-          for (auto i = 0ul; i < dof_; ++i)
-          {
-            tmp_command_[i] = (state_desired_.velocities[i] * ff_velocity_scale_[i]) +
-                              pids_[i]->computeCommand(
-                                state_error_.positions[i], state_error_.velocities[i],
-                                (uint64_t)period.nanoseconds());
-          }
-        }
+        write_commands(traj_point_active_ptr_ != nullptr);
+      }
+    }
+  }
 
-        // set values for next hardware write()
-        if (has_position_command_interface_)
-        {
-          assign_interface_from_point(joint_command_interface_[0], state_desired_.positions);
-        }
-        if (has_velocity_command_interface_)
-        {
-          if (traj_point_active_ptr_ && use_closed_loop_pid_adapter_)
-          {
-            assign_interface_from_point(joint_command_interface_[1], tmp_command_);
-          }
-          else
-          {
-            assign_interface_from_point(joint_command_interface_[1], state_desired_.velocities);
-          }
-        }
-        if (has_acceleration_command_interface_)
-        {
-          assign_interface_from_point(joint_command_interface_[2], state_desired_.accelerations);
-        }
-        if (has_effort_command_interface_)
-        {
-          if (traj_point_active_ptr_ && use_closed_loop_pid_adapter_)
-          {
-            assign_interface_from_point(joint_command_interface_[3], tmp_command_);
-          }
-          else
-          {
-            assign_interface_from_point(joint_command_interface_[3], state_desired_.effort);
-          }
-        }
+  if (tracking_error_statistics_)
+  {
+    update_tracking_error_statistics(time, executed_goal);
+  }
 
-        // store the previous command. Used in open-loop control mode
-        last_commanded_state_ = state_desired_;
-      }
+  auto & snapshot = state_snapshot_->write_buffer();
+  snapshot.time = time;
+  snapshot.desired = state_desired_;
+  state_current_.to_msg(snapshot.current);
+  state_error_.to_msg(snapshot.error);
+  // the reference count is only touched if the trajectory changed
+  if (
+    traj_point_active_ptr_ && (*traj_point_active_ptr_) &&
+    (*traj_point_active_ptr_)->is_sampled_already())
+  {
+    if (snapshot.trajectory != *traj_point_active_ptr_)
+    {
+      snapshot.trajectory = *traj_point_active_ptr_;
     }
   }
+  else if (snapshot.trajectory)
+  {
+    snapshot.trajectory.reset();
+  }
+  state_snapshot_->publish();
 
   publish_state(time, state_desired_, state_current_, state_error_);
+  end_phase(PUBLISH_STATE);
   return controller_interface::return_type::OK;
 }
 
-void JointTrajectoryController::read_state_from_hardware(JointTrajectoryPoint & state)
+void JointTrajectoryController::sample_joint_groups(const rclcpp::Time & time)
 {
-  auto assign_point_from_interface =
-    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
+  for (auto & group_ptr : joint_groups_)
   {
-    for (size_t index = 0; index < dof_; ++index)
+    auto & group = *group_ptr;
+    group.sampled = false;
+
+    const auto new_trajectory = *group.trajectory_buffer.readFromRT();
+    if (new_trajectory && new_trajectory != group.buffered_trajectory)
+    {
+      group.buffered_trajectory = new_trajectory;
+      // a trajectory without msg lets the group hold its position
+      if (new_trajectory->has_trajectory_msg())
+      {
+        group.trajectory = new_trajectory;
+        new_trajectory_unwritten_ = true;
+        CONTROLLER_TRACEPOINT(
+          TRAJECTORY_ACTIVATED, this, new_trajectory->end() - new_trajectory->begin());
+      }
+      else
+      {
+        hold_joint_group(group);
+      }
+    }
+    if (!group.trajectory)
     {
-      trajectory_point_interface[index] = joint_interface[index].get().get_value();
+      continue;
     }
-  };
 
-  // Assign values from the hardware
-  // Position states always exist
-  assign_point_from_interface(state.positions, joint_state_interface_[0]);
-  // velocity and acceleration states are optional
-  if (has_velocity_state_interface_)
-  {
-    assign_point_from_interface(state.velocities, joint_state_interface_[1]);
-    // Acceleration is used only in combination with velocity
-    if (has_acceleration_state_interface_)
+    auto & trajectory = *group.trajectory;
+    group.first_sample = !trajectory.is_sampled_already();
+    if (group.first_sample)
     {
-      assign_point_from_interface(state.accelerations, joint_state_interface_[2]);
+      if (params_.open_loop_control)
+      {
+        trajectory.set_point_before_trajectory_msg(time, last_commanded_state_);
+      }
+      else
+      {
+        trajectory.set_point_before_trajectory_msg(time, state_current_);
+      }
     }
-    else
+    TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+    group.sampled = trajectory.sample(
+      time, interpolation_method_, group.desired, start_segment_itr, end_segment_itr);
+    if (!group.sampled)
     {
-      // Make empty so the property is ignored during interpolation
-      state.accelerations.clear();
+      continue;
+    }
+    group.before_last_point = end_segment_itr != trajectory.end();
+    group.sampled_point_time = trajectory.get_trajectory_start_time() +
+                               start_segment_itr->time_from_start +
+                               trajectory.get_hold_duration();
+    // the other joints of the trajectory only hold the positions they had when it was received
+    for (const size_t index : group.joints)
+    {
+      state_desired_.positions[index] = group.desired.positions[index];
+      state_desired_.velocities[index] = group.desired.velocities[index];
+      state_desired_.accelerations[index] = group.desired.accelerations[index];
     }
-  }
-  else
-  {
-    // Make empty so the property is ignored during interpolation
-    state.velocities.clear();
-    state.accelerations.clear();
   }
 }
 
-bool JointTrajectoryController::read_state_from_command_interfaces(JointTrajectoryPoint & state)
+void JointTrajectoryController::check_joint_groups(const rclcpp::Time & time)
 {
-  bool has_values = true;
-
-  auto assign_point_from_interface =
-    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
+  for (auto & group_ptr : joint_groups_)
   {
-    for (size_t index = 0; index < dof_; ++index)
+    auto & group = *group_ptr;
+    if (!group.sampled)
     {
-      trajectory_point_interface[index] = joint_interface[index].get().get_value();
+      continue;
     }
-  };
 
-  auto interface_has_values = [](const auto & joint_interface)
-  {
-    return std::find_if(
-             joint_interface.begin(), joint_interface.end(),
-             [](const auto & interface)
-             { return std::isnan(interface.get().get_value()); }) == joint_interface.end();
-  };
-
-  // Assign values from the command interfaces as state. Therefore needs check for both.
-  // Position state interface has to exist always
-  if (has_position_command_interface_ && interface_has_values(joint_command_interface_[0]))
-  {
-    assign_point_from_interface(state.positions, joint_command_interface_[0]);
-  }
-  else
-  {
-    state.positions.clear();
-    has_values = false;
-  }
-  // velocity and acceleration states are optional
-  if (has_velocity_state_interface_)
-  {
-    if (has_velocity_command_interface_ && interface_has_values(joint_command_interface_[1]))
+    // Always check the state tolerance on the first sample in case the first sample is the last
+    // point. The tolerances of the other joints are unbounded.
+    ToleranceViolations state_violations;
+    if (group.before_last_point || group.first_sample)
     {
-      assign_point_from_interface(state.velocities, joint_command_interface_[1]);
+      state_violations = check_state_tolerance(state_error_, group.state_tolerances);
     }
-    else
+    // past the final point, check that we end up inside goal tolerance
+    const bool outside_goal_tolerance =
+      !group.before_last_point &&
+      check_state_tolerance(state_error_, group.goal_state_tolerances).any();
+    const double time_difference = time.seconds() - group.sampled_point_time.seconds();
+    const bool within_goal_time = !outside_goal_tolerance ||
+                                  default_tolerances_.goal_time_tolerance == 0.0 ||
+                                  time_difference <= default_tolerances_.goal_time_tolerance;
+
+    const auto active_goal = group.rt_active_goal.get_from_rt();
+    if (state_violations.any())
     {
-      state.velocities.clear();
-      has_values = false;
+      hold_joint_group(group);
+      RCLCPP_WARN(
+        get_node()->get_logger(),
+        "Group '%s' holds its position due to state tolerance violation of joint '%s'",
+        group.name.c_str(), params_.joints[state_violations.first_joint].c_str());
+      if (active_goal)
+      {
+        auto result = std::make_shared<FollowJTrajAction::Result>();
+        result->set__error_code(FollowJTrajAction::Result::PATH_TOLERANCE_VIOLATED);
+        active_goal->setAborted(result);
+        group.rt_active_goal.reset_from_rt();
+        action_monitor_->notify();
+      }
+      continue;
     }
-  }
-  else
-  {
-    state.velocities.clear();
-  }
-  // Acceleration is used only in combination with velocity
-  if (has_acceleration_state_interface_)
-  {
-    if (has_acceleration_command_interface_ && interface_has_values(joint_command_interface_[2]))
+    if (!active_goal)
     {
-      assign_point_from_interface(state.accelerations, joint_command_interface_[2]);
+      continue;
     }
-    else
+
+    // send feedback of the joints of the group, decimated to action_feedback_rate
+    if (time.nanoseconds() >= group.next_feedback_time_ns)
     {
-      state.accelerations.clear();
-      has_values = false;
-    }
+      // fill whichever preallocated feedback isn't waiting to be published
+      auto & feedback = active_goal->preallocated_feedback_.use_count() == 1
+                          ? active_goal->preallocated_feedback_
+                          : group.rt_feedback;
+      if (feedback.use_count() == 1)
+      {
+        // synchronize with the release of the feedback after publishing it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        group.next_feedback_time_ns = time.nanoseconds() + action_feedback_period_.nanoseconds();
+        feedback->header.stamp = time;
+        gather_joints(state_current_, group.joints, feedback->actual);
+        gather_joints(state_desired_, group.joints, feedback->desired);
+        gather_joints(state_error_, group.joints, feedback->error);
+        active_goal->setFeedback(feedback);
+        action_monitor_->notify();
+      }
+    }
+
+    if (group.before_last_point)
+    {
+      continue;
+    }
+    if (!outside_goal_tolerance)
+    {
+      hold_joint_group(group);
+      auto result = std::make_shared<FollowJTrajAction::Result>();
+      result->set__error_code(FollowJTrajAction::Result::SUCCESSFUL);
+      active_goal->setSucceeded(result);
+      group.rt_active_goal.reset_from_rt();
+      action_monitor_->notify();
+      RCLCPP_INFO(
+        get_node()->get_logger(), "Goal of group '%s' reached, success!", group.name.c_str());
+    }
+    else if (!within_goal_time)
+    {
+      hold_joint_group(group);
+      auto result = std::make_shared<FollowJTrajAction::Result>();
+      result->set__error_code(FollowJTrajAction::Result::GOAL_TOLERANCE_VIOLATED);
+      active_goal->setAborted(result);
+      group.rt_active_goal.reset_from_rt();
+      action_monitor_->notify();
+      RCLCPP_WARN(
+        get_node()->get_logger(),
+        "Goal of group '%s' aborted due goal_time_tolerance exceeding by %f seconds",
+        group.name.c_str(), time_difference);
+    }
+    // else, run another cycle while waiting for outside_goal_tolerance
+    // to be satisfied or violated within the goal_time_tolerance
   }
-  else
+}
+
+void JointTrajectoryController::hold_joint_group(JointGroup & group)
+{
+  // the pool keeps the trajectory from being freed here
+  group.trajectory.reset();
+  for (const size_t index : group.joints)
   {
-    state.accelerations.clear();
+    state_desired_.velocities[index] = 0.0;
+    state_desired_.accelerations[index] = 0.0;
   }
+}
 
-  return has_values;
+void JointTrajectoryController::publish_cycle_timing()
+{
+  using statistics_msgs::msg::StatisticDataType;
+  const rclcpp::Time now = get_node()->now();
+  for (size_t phase = 0; phase < NUM_CYCLE_PHASES; ++phase)
+  {
+    const auto statistics = cycle_timing_->get_statistics(phase);
+    statistics_msgs::msg::MetricsMessage msg;
+    msg.measurement_source_name = get_node()->get_name();
+    msg.metrics_source = CYCLE_PHASE_NAMES[phase];
+    msg.window_start = timing_window_start_;
+    msg.window_stop = now;
+    controller_realtime_tools::fill_metrics<StatisticDataType>(statistics, msg);
+    timing_publisher_->publish(msg);
+  }
+  timing_window_start_ = now;
 }
 
-bool JointTrajectoryController::read_commands_from_command_interfaces(
-  JointTrajectoryPoint & commands)
+void JointTrajectoryController::publish_command_latency()
 {
-  bool has_values = true;
+  using controller_realtime_tools::LatencyProbe;
+  using statistics_msgs::msg::StatisticDataType;
+  const rclcpp::Time now = get_node()->now();
+  const auto statistics = command_latency_->get_statistics();
+  for (size_t stage = 0; stage < LatencyProbe::NUM_STAGES; ++stage)
+  {
+    statistics_msgs::msg::MetricsMessage msg;
+    msg.measurement_source_name = get_node()->get_name();
+    msg.metrics_source = LatencyProbe::STAGE_NAMES[stage];
+    msg.window_start = command_latency_window_start_;
+    msg.window_stop = now;
+    controller_realtime_tools::fill_metrics<StatisticDataType>(statistics[stage], msg);
+    command_latency_publisher_->publish(msg);
+  }
+  command_latency_window_start_ = now;
+}
 
-  auto assign_point_from_interface =
-    [&](std::vector<double> & trajectory_point_interface, const auto & joint_interface)
+void JointTrajectoryController::update_tracking_error_statistics(
+  const rclcpp::Time & time, const RealtimeGoalHandle * goal)
+{
+  auto & statistics = *tracking_error_statistics_;
+  if (goal != tracked_goal_)
   {
-    for (size_t index = 0; index < dof_; ++index)
+    if (tracked_goal_)
     {
-      trajectory_point_interface[index] = joint_interface[index].get().get_value();
+      tracking_error_msg_.header.stamp = tracked_goal_start_;
+      for (size_t index = 0; index < dof_; ++index)
+      {
+        auto & values = tracking_error_msg_.interface_values[index].values;
+        values[0] = static_cast<double>(statistics.count(index));
+        values[1] = statistics.rms(index);
+        values[2] = statistics.max(index);
+        values[3] = statistics.time_of_max(index);
+      }
+      tracking_error_publisher_->try_publish(tracking_error_msg_);
     }
-  };
-
-  auto interface_has_values = [](const auto & joint_interface)
+    tracked_goal_ = goal;
+    tracked_goal_start_ = time;
+    statistics.clear(time.seconds());
+  }
+  if (goal)
   {
-    return std::find_if(
-             joint_interface.begin(), joint_interface.end(),
-             [](const auto & interface)
-             { return std::isnan(interface.get().get_value()); }) == joint_interface.end();
-  };
+    statistics.add(state_error_.positions.data(), time.seconds());
+  }
+}
 
-  // Assign values from the command interfaces as command.
-  if (has_position_command_interface_)
+void JointTrajectoryController::read_state_from_hardware(
+  controller_realtime_tools::JointVectors & state)
+{
+  // Assign values from the hardware
+  // Position states always exist
+  gather_values(state_interfaces_of(0), dof_, state.positions.data());
+  // velocity and acceleration states are optional
+  if (has_velocity_state_interface_)
   {
-    if (interface_has_values(joint_command_interface_[0]))
+    gather_values(state_interfaces_of(1), dof_, state.velocities.data());
+    // Acceleration is used only in combination with velocity
+    if (has_acceleration_state_interface_)
     {
-      assign_point_from_interface(commands.positions, joint_command_interface_[0]);
+      gather_values(state_interfaces_of(2), dof_, state.accelerations.data());
     }
     else
     {
-      commands.positions.clear();
+      // Make empty so the property is ignored during interpolation
+      state.accelerations.clear();
+    }
+  }
+  else
+  {
+    // Make empty so the property is ignored during interpolation
+    state.velocities.clear();
+    state.accelerations.clear();
+  }
+}
+
+void JointTrajectoryController::read_state_from_reference_interfaces(
+  JointTrajectoryPoint & state, const rclcpp::Duration & period)
+{
+  const double dt = period.seconds();
+  for (size_t index = 0; index < dof_; ++index)
+  {
+    const double position = reference_interfaces_[index];
+    const double velocity = reference_interfaces_[dof_ + index];
+    state.velocities[index] = std::isnan(velocity) ? 0.0 : velocity;
+    state.positions[index] =
+      std::isnan(position) ? state.positions[index] + state.velocities[index] * dt : position;
+    state.accelerations[index] = 0.0;
+  }
+}
+
+bool JointTrajectoryController::read_state_from_command_interfaces(JointTrajectoryPoint & state)
+{
+  bool has_values = true;
+
+  // Assign values from the command interfaces as state. Therefore needs check for both.
+  // Position state interface has to exist always
+  if (!has_position_command_interface_)
+  {
+    state.positions.clear();
+    has_values = false;
+  }
+  else if (!gather_valid_values(command_interfaces_of(0), dof_, state.positions))
+  {
+    has_values = false;
+  }
+  // velocity and acceleration states are optional
+  if (has_velocity_state_interface_)
+  {
+    if (!has_velocity_command_interface_)
+    {
+      state.velocities.clear();
+      has_values = false;
+    }
+    else if (!gather_valid_values(command_interfaces_of(1), dof_, state.velocities))
+    {
       has_values = false;
     }
   }
-  if (has_velocity_command_interface_)
+  else
+  {
+    state.velocities.clear();
+  }
+  // Acceleration is used only in combination with velocity
+  if (has_acceleration_state_interface_)
   {
-    if (interface_has_values(joint_command_interface_[1]))
+    if (!has_acceleration_command_interface_)
     {
-      assign_point_from_interface(commands.velocities, joint_command_interface_[1]);
+      state.accelerations.clear();
+      has_values = false;
     }
-    else
+    else if (!gather_valid_values(command_interfaces_of(2), dof_, state.accelerations))
     {
-      commands.velocities.clear();
       has_values = false;
     }
   }
-  if (has_acceleration_command_interface_)
+  else
+  {
+    state.accelerations.clear();
+  }
+
+  return has_values;
+}
+
+bool JointTrajectoryController::read_commands_from_command_interfaces(
+  JointTrajectoryPoint & commands)
+{
+  bool has_values = true;
+
+  // Assign values from the command interfaces as command.
+  if (has_position_command_interface_)
   {
-    if (interface_has_values(joint_command_interface_[2]))
+    if (!gather_valid_values(command_interfaces_of(0), dof_, commands.positions))
     {
-      assign_point_from_interface(commands.accelerations, joint_command_interface_[2]);
+      has_values = false;
     }
-    else
+  }
+  if (has_velocity_command_interface_)
+  {
+    if (!gather_valid_values(command_interfaces_of(1), dof_, commands.velocities))
     {
-      commands.accelerations.clear();
       has_values = false;
     }
   }
-  if (has_effort_command_interface_)
+  if (has_acceleration_command_interface_)
   {
-    if (interface_has_values(joint_command_interface_[3]))
+    if (!gather_valid_values(command_interfaces_of(2), dof_, commands.accelerations))
     {
-      assign_point_from_interface(commands.effort, joint_command_interface_[3]);
+      has_values = false;
     }
-    else
+  }
+  if (has_effort_command_interface_)
+  {
+    if (!gather_valid_values(command_interfaces_of(3), dof_, commands.effort))
     {
-      commands.effort.clear();
       has_values = false;
     }
   }
@@ -560,20 +1079,21 @@ void JointTrajectoryController::query_state_service(
     response->success = false;
     return;
   }
-  const auto active_goal = *rt_active_goal_.readFromRT();
   response->name = params_.joints;
-  trajectory_msgs::msg::JointTrajectoryPoint state_requested = state_current_;
-  if ((traj_point_active_ptr_ && (*traj_point_active_ptr_)->has_trajectory_msg()))
-  {
-    TrajectoryPointConstIter start_segment_itr, end_segment_itr;
-    response->success = (*traj_point_active_ptr_)
-                          ->sample(
-                            static_cast<rclcpp::Time>(request->time), interpolation_method_,
-                            state_requested, start_segment_itr, end_segment_itr);
+  // sample the trajectory of the last update without touching the one sampled by update()
+  std::lock_guard<std::mutex> guard(state_snapshot_mutex_);
+  const StateSnapshot & snapshot = state_snapshot_->read();
+  trajectory_msgs::msg::JointTrajectoryPoint state_requested = snapshot.current;
+  if (snapshot.trajectory && snapshot.trajectory->has_trajectory_msg())
+  {
+    bool after_last_point = false;
+    response->success = snapshot.trajectory->sample_at(
+      static_cast<rclcpp::Time>(request->time), interpolation_method_, state_requested,
+      after_last_point);
     // If the requested sample time precedes the trajectory finish time respond as failure
     if (response->success)
     {
-      if (end_segment_itr == (*traj_point_active_ptr_)->end())
+      if (after_last_point)
       {
         RCLCPP_ERROR(logger, "Requested sample time precedes the current trajectory end time.");
         response->success = false;
@@ -582,7 +1102,9 @@ void JointTrajectoryController::query_state_service(
     else
     {
       RCLCPP_ERROR(
-        logger, "Requested sample time is earlier than the current trajectory start time.");
+        logger,
+        "Requested sample time is earlier than the current trajectory start time, or the "
+        "trajectory can't be sampled concurrently as it lacks positions.");
     }
   }
   else
@@ -624,6 +1146,18 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
   }
 
   dof_ = params_.joints.size();
+  joint_indices_.clear();
+  joint_indices_.reserve(dof_);
+  for (size_t index = 0; index < dof_; ++index)
+  {
+    joint_indices_.emplace(params_.joints[index], index);
+  }
+  motion_limits_.resize(dof_);
+  for (size_t index = 0; index < dof_; ++index)
+  {
+    const auto & limits = params_.limits.joints_map.at(params_.joints[index]);
+    motion_limits_[index] = {limits.max_velocity, limits.max_acceleration};
+  }
 
   // TODO(destogl): why is this here? Add comment or move
   if (!reset())
@@ -686,7 +1220,7 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
 
   if (use_closed_loop_pid_adapter_)
   {
-    pids_.resize(dof_);
+    std::vector<controller_realtime_tools::BatchedPid::Gains> pid_gains(dof_);
     ff_velocity_scale_.resize(dof_);
     tmp_command_.resize(dof_, 0.0);
 
@@ -694,11 +1228,14 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
     for (size_t i = 0; i < dof_; ++i)
     {
       const auto & gains = params_.gains.joints_map.at(params_.joints[i]);
-      pids_[i] = std::make_shared<control_toolbox::Pid>(
-        gains.p, gains.i, gains.d, gains.i_clamp, -gains.i_clamp);
+      pid_gains[i].p = gains.p;
+      pid_gains[i].i = gains.i;
+      pid_gains[i].d = gains.d;
+      pid_gains[i].i_clamp = gains.i_clamp;
 
       ff_velocity_scale_[i] = gains.ff_velocity_scale;
     }
+    pids_.configure(pid_gains);
   }
 
   // Configure joint position error normalization from ROS parameters
@@ -773,7 +1310,59 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
     get_interface_list(params_.command_interfaces).c_str(),
     get_interface_list(params_.state_interfaces).c_str());
 
+  // the interfaces are looked up once and only checked on the following activations
+  auto configure_interface_orders =
+    [this](
+      const std::vector<std::string> & interface_types, const std::vector<std::string> & joints,
+      std::vector<controller_realtime_tools::InterfaceOrder> & orders,
+      auto & ordered_interfaces)
+  {
+    orders.assign(allowed_interface_types_.size(), controller_realtime_tools::InterfaceOrder());
+    for (const auto & interface : interface_types)
+    {
+      const auto index = static_cast<size_t>(std::distance(
+        allowed_interface_types_.begin(),
+        std::find(allowed_interface_types_.begin(), allowed_interface_types_.end(), interface)));
+      std::vector<std::string> names;
+      names.reserve(joints.size());
+      for (const auto & joint : joints)
+      {
+        names.push_back(joint + "/" + interface);
+      }
+      orders[index].configure(std::move(names));
+      ordered_interfaces[index].reserve(dof_);
+    }
+  };
+  configure_interface_orders(
+    params_.command_interfaces, command_joint_names_, command_interface_orders_,
+    joint_command_interface_);
+  configure_interface_orders(
+    params_.state_interfaces, params_.joints, state_interface_orders_, joint_state_interface_);
+
+  if (params_.command_sequence_interfaces)
+  {
+    std::vector<std::string> names;
+    names.reserve(dof_ * params_.command_interfaces.size());
+    for (const auto & interface : params_.command_interfaces)
+    {
+      for (const auto & joint : command_joint_names_)
+      {
+        names.push_back(
+          controller_realtime_tools::CommandSequence::interface_name(joint + "/" + interface));
+      }
+    }
+    command_sequence_ = std::make_unique<controller_realtime_tools::CommandSequence>();
+    command_sequence_->reset(names.size());
+    command_sequence_order_.configure(std::move(names));
+  }
+  else
+  {
+    command_sequence_.reset();
+  }
+
   default_tolerances_ = get_segment_tolerances(params_);
+  state_tolerances_ = JointsStateTolerances(default_tolerances_.state_tolerance);
+  goal_state_tolerances_ = JointsStateTolerances(default_tolerances_.goal_state_tolerance);
 
   const std::string interpolation_string =
     get_node()->get_parameter("interpolation_method").as_string();
@@ -782,50 +1371,170 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
     logger, "Using '%s' interpolation method.",
     interpolation_methods::InterpolationMethodMap.at(interpolation_method_).c_str());
 
-  joint_command_subscriber_ =
-    get_node()->create_subscription<trajectory_msgs::msg::JointTrajectory>(
-      "~/joint_trajectory", rclcpp::SystemDefaultsQoS(),
-      std::bind(&JointTrajectoryController::topic_callback, this, std::placeholders::_1));
+  simplification_tolerances_.resize(dof_);
+  for (size_t index = 0; index < dof_; ++index)
+  {
+    simplification_tolerances_[index] =
+      params_.simplification.joints_map.at(params_.joints[index]).position_tolerance;
+  }
+  // the other methods don't interpolate between the waypoints, but stop at them
+  simplify_trajectories_ =
+    interpolation_method_ == interpolation_methods::InterpolationMethod::VARIABLE_DEGREE_SPLINE &&
+    std::any_of(
+      simplification_tolerances_.begin(), simplification_tolerances_.end(),
+      [](double tolerance) { return tolerance > 0.0; });
+
+  // the groups are only commanded through their own action servers
+  if (params_.joint_groups.empty())
+  {
+    joint_command_subscriber_ =
+      get_node()->create_subscription<trajectory_msgs::msg::JointTrajectory>(
+        "~/joint_trajectory", rclcpp::SystemDefaultsQoS(),
+        std::bind(&JointTrajectoryController::topic_callback, this, std::placeholders::_1));
+  }
+  else
+  {
+    joint_command_subscriber_.reset();
+  }
 
   publisher_ = get_node()->create_publisher<ControllerStateMsg>(
     "~/controller_state", rclcpp::SystemDefaultsQoS());
-  state_publisher_ = std::make_unique<StatePublisher>(publisher_);
-
-  state_publisher_->lock();
-  state_publisher_->msg_.joint_names = params_.joints;
-  state_publisher_->msg_.reference.positions.resize(dof_);
-  state_publisher_->msg_.reference.velocities.resize(dof_);
-  state_publisher_->msg_.reference.accelerations.resize(dof_);
-  state_publisher_->msg_.feedback.positions.resize(dof_);
-  state_publisher_->msg_.error.positions.resize(dof_);
+
+  // the state is filled into state_msg_ and swapped with the message of state_publisher_, so both
+  // have the same preallocated layout
+  state_msg_ = ControllerStateMsg();
+  state_msg_.joint_names = params_.joints;
+  state_msg_.reference.positions.resize(dof_);
+  state_msg_.reference.velocities.resize(dof_);
+  state_msg_.reference.accelerations.resize(dof_);
+  state_msg_.feedback.positions.resize(dof_);
+  state_msg_.error.positions.resize(dof_);
   if (has_velocity_state_interface_)
   {
-    state_publisher_->msg_.feedback.velocities.resize(dof_);
-    state_publisher_->msg_.error.velocities.resize(dof_);
+    state_msg_.feedback.velocities.resize(dof_);
+    state_msg_.error.velocities.resize(dof_);
   }
   if (has_acceleration_state_interface_)
   {
-    state_publisher_->msg_.feedback.accelerations.resize(dof_);
-    state_publisher_->msg_.error.accelerations.resize(dof_);
+    state_msg_.feedback.accelerations.resize(dof_);
+    state_msg_.error.accelerations.resize(dof_);
   }
   if (has_position_command_interface_)
   {
-    state_publisher_->msg_.output.positions.resize(dof_);
+    state_msg_.output.positions.resize(dof_);
   }
   if (has_velocity_command_interface_)
   {
-    state_publisher_->msg_.output.velocities.resize(dof_);
+    state_msg_.output.velocities.resize(dof_);
   }
   if (has_acceleration_command_interface_)
   {
-    state_publisher_->msg_.output.accelerations.resize(dof_);
+    state_msg_.output.accelerations.resize(dof_);
   }
   if (has_effort_command_interface_)
   {
-    state_publisher_->msg_.output.effort.resize(dof_);
+    state_msg_.output.effort.resize(dof_);
+  }
+
+  const auto state_publish_period =
+    params_.state_publish_rate > 0.0
+      ? std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::duration<double>(1.0 / params_.state_publish_rate))
+      : std::chrono::nanoseconds::zero();
+  state_publisher_ =
+    std::make_unique<StatePublisher>(publisher_, state_msg_, state_publish_period);
+
+  if (params_.cycle_timing.enable)
+  {
+    cycle_timing_ = std::make_unique<controller_realtime_tools::CycleTiming>(NUM_CYCLE_PHASES);
+    timing_publisher_ = get_node()->create_publisher<statistics_msgs::msg::MetricsMessage>(
+      "~/timing", rclcpp::SystemDefaultsQoS());
+    timing_window_start_ = get_node()->now();
+    timing_timer_ = get_node()->create_wall_timer(
+      std::chrono::duration<double>(1.0 / params_.cycle_timing.publish_rate),
+      std::bind(&JointTrajectoryController::publish_cycle_timing, this));
+  }
+  else
+  {
+    timing_timer_.reset();
+    timing_publisher_.reset();
+    cycle_timing_.reset();
+  }
+
+  if (params_.cycle_budget.enable)
+  {
+    cycle_budget_ = std::make_unique<controller_realtime_tools::CycleBudget>(
+      std::chrono::nanoseconds(static_cast<int64_t>(params_.cycle_budget.update_time * 1e9)),
+      static_cast<uint32_t>(params_.cycle_budget.recovery_cycles),
+      std::vector<std::string>{"publish_state", "action_feedback"});
+    cycle_budget_timer_ = get_node()->create_wall_timer(
+      std::chrono::seconds(1),
+      [this]()
+      {
+        const auto report = cycle_budget_->get_report();
+        if (!report.empty())
+        {
+          RCLCPP_WARN(get_node()->get_logger(), "%s", report.c_str());
+        }
+      });
+  }
+  else
+  {
+    cycle_budget_timer_.reset();
+    cycle_budget_.reset();
+  }
+
+  if (params_.input_recording.enable && params_.input_recording.path.empty())
+  {
+    RCLCPP_ERROR(logger, "'input_recording.path' is empty");
+    return CallbackReturn::FAILURE;
+  }
+
+  if (params_.command_latency.enable)
+  {
+    command_latency_ = std::make_unique<controller_realtime_tools::LatencyProbe>();
+    command_latency_publisher_ =
+      get_node()->create_publisher<statistics_msgs::msg::MetricsMessage>(
+        "~/command_latency", rclcpp::SystemDefaultsQoS());
+    command_latency_window_start_ = get_node()->now();
+    command_latency_timer_ = get_node()->create_wall_timer(
+      std::chrono::duration<double>(1.0 / params_.command_latency.publish_rate),
+      std::bind(&JointTrajectoryController::publish_command_latency, this));
+  }
+  else
+  {
+    command_latency_timer_.reset();
+    command_latency_publisher_.reset();
+    command_latency_.reset();
   }
 
-  state_publisher_->unlock();
+  if (params_.tracking_error_statistics.enable)
+  {
+    if (!params_.joint_groups.empty())
+    {
+      RCLCPP_WARN(
+        logger, "'tracking_error_statistics' is not supported with 'joint_groups', ignoring it");
+    }
+    tracking_error_statistics_ =
+      std::make_unique<controller_realtime_tools::TrackingErrorStatistics>();
+    tracking_error_statistics_->resize(dof_);
+    tracking_error_msg_.joint_names = params_.joints;
+    tracking_error_msg_.interface_values.resize(dof_);
+    for (auto & joint : tracking_error_msg_.interface_values)
+    {
+      joint.interface_names = {"samples", "rms_error", "max_error", "time_of_max_error"};
+      joint.values.assign(joint.interface_names.size(), 0.0);
+    }
+    tracking_error_publisher_ = std::make_unique<TrackingErrorPublisher>(
+      get_node()->create_publisher<TrackingErrorMsg>(
+        "~/tracking_error", rclcpp::SystemDefaultsQoS()),
+      tracking_error_msg_);
+  }
+  else
+  {
+    tracking_error_publisher_.reset();
+    tracking_error_statistics_.reset();
+  }
 
   // action server configuration
   if (params_.allow_partial_joints_goal)
@@ -836,25 +1545,156 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
   RCLCPP_INFO(
     logger, "Action status changes will be monitored at %.2f Hz.", params_.action_monitor_rate);
   action_monitor_period_ = rclcpp::Duration::from_seconds(1.0 / params_.action_monitor_rate);
+  action_monitor_ = std::make_unique<controller_realtime_tools::ActionMonitor>(
+    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
+    [this]() { return monitor_goal(); });
+  // keep the publishing and the goal housekeeping off the realtime CPUs
+  const auto scheduling = controller_realtime_tools::make_thread_scheduling(
+    params_.non_realtime_threads.priority, params_.non_realtime_threads.cpu_affinity);
+  if (!state_publisher_->set_scheduling(scheduling) || !action_monitor_->set_scheduling(scheduling))
+  {
+    RCLCPP_WARN(logger, "Could not set the scheduling of the non-realtime threads.");
+  }
+  action_feedback_period_ = params_.action_feedback_rate > 0.0
+                              ? rclcpp::Duration::from_seconds(1.0 / params_.action_feedback_rate)
+                              : rclcpp::Duration(0ms);
+  rt_feedback_ = std::make_shared<FollowJTrajAction::Feedback>();
+  preallocate_feedback(*rt_feedback_);
 
   using namespace std::placeholders;
-  action_server_ = rclcpp_action::create_server<FollowJTrajAction>(
-    get_node()->get_node_base_interface(), get_node()->get_node_clock_interface(),
-    get_node()->get_node_logging_interface(), get_node()->get_node_waitables_interface(),
-    std::string(get_node()->get_name()) + "/follow_joint_trajectory",
-    std::bind(&JointTrajectoryController::goal_received_callback, this, _1, _2),
-    std::bind(&JointTrajectoryController::goal_cancelled_callback, this, _1),
-    std::bind(&JointTrajectoryController::goal_accepted_callback, this, _1));
-
-  resize_joint_trajectory_point(state_current_, dof_);
+  if (params_.joint_groups.empty())
+  {
+    action_server_ = rclcpp_action::create_server<FollowJTrajAction>(
+      get_node()->get_node_base_interface(), get_node()->get_node_clock_interface(),
+      get_node()->get_node_logging_interface(), get_node()->get_node_waitables_interface(),
+      std::string(get_node()->get_name()) + "/follow_joint_trajectory",
+      std::bind(&JointTrajectoryController::goal_received_callback, this, _1, _2),
+      std::bind(&JointTrajectoryController::goal_cancelled_callback, this, _1),
+      std::bind(&JointTrajectoryController::goal_accepted_callback, this, _1));
+  }
+  else
+  {
+    action_server_.reset();
+  }
+
+  state_current_.resize(dof_, has_velocity_state_interface_, has_acceleration_state_interface_);
   resize_joint_trajectory_point_command(command_current_, dof_);
   resize_joint_trajectory_point(state_desired_, dof_);
-  resize_joint_trajectory_point(state_error_, dof_);
+  state_error_.resize(dof_, has_velocity_state_interface_, has_acceleration_state_interface_);
   resize_joint_trajectory_point(last_commanded_state_, dof_);
+  resize_joint_trajectory_point(blend_state_, dof_);
+  resize_joint_trajectory_point(lookahead_state_, dof_);
+  // sampled states have all fields, reserve them so that sampling in update() doesn't allocate
+  reserve_joint_trajectory_point(state_desired_, dof_);
+  reserve_joint_trajectory_point(last_commanded_state_, dof_);
+  reserve_joint_trajectory_point(blend_state_, dof_);
+  reserve_joint_trajectory_point(lookahead_state_, dof_);
+
+  // finish the jobs of a previous configuration first
+  preprocessing_worker_.reset();
+  if (params_.preprocessing.use_worker_thread)
+  {
+    preprocessing_worker_ = std::make_unique<controller_realtime_tools::WorkerThread>();
+    if (!preprocessing_worker_->set_scheduling(controller_realtime_tools::make_thread_scheduling(
+          params_.preprocessing.thread_priority, params_.preprocessing.cpu_affinity)))
+    {
+      RCLCPP_WARN(logger, "Could not set the scheduling of the preprocessing thread.");
+    }
+  }
+  trajectory_pool_.reserve(static_cast<size_t>(params_.preprocessing.trajectory_pool_size));
+
+  // after the preprocessing jobs of the previous groups are finished
+  joint_groups_.clear();
+  std::vector<bool> joint_in_group(dof_, false);
+  for (const auto & group_name : params_.joint_groups)
+  {
+    auto group = std::make_unique<JointGroup>();
+    group->name = group_name;
+    for (const auto & joint : params_.groups.joint_groups_map.at(group_name).joints)
+    {
+      const auto it = joint_indices_.find(joint);
+      if (it == joint_indices_.end())
+      {
+        RCLCPP_ERROR(
+          logger, "Joint '%s' of group '%s' is not in 'joints' parameter.", joint.c_str(),
+          group_name.c_str());
+        return CallbackReturn::FAILURE;
+      }
+      // a joint can be commanded by only one group
+      if (joint_in_group[it->second])
+      {
+        RCLCPP_ERROR(
+          logger, "Joint '%s' is in several groups or twice in group '%s'", joint.c_str(),
+          group_name.c_str());
+        return CallbackReturn::FAILURE;
+      }
+      joint_in_group[it->second] = true;
+      group->joints.push_back(it->second);
+    }
+    if (group->joints.empty())
+    {
+      RCLCPP_ERROR(logger, "'groups.%s.joints' parameter is empty.", group_name.c_str());
+      return CallbackReturn::FAILURE;
+    }
+
+    // all joints are checked at once, the tolerances of the other joints are unbounded
+    auto state_tolerance = default_tolerances_.state_tolerance;
+    auto goal_state_tolerance = default_tolerances_.goal_state_tolerance;
+    for (size_t index = 0; index < dof_; ++index)
+    {
+      if (std::find(group->joints.begin(), group->joints.end(), index) == group->joints.end())
+      {
+        state_tolerance[index] = StateTolerances();
+        goal_state_tolerance[index] = StateTolerances();
+      }
+    }
+    group->state_tolerances = JointsStateTolerances(state_tolerance);
+    group->goal_state_tolerances = JointsStateTolerances(goal_state_tolerance);
+
+    reserve_joint_trajectory_point(group->desired, dof_);
+    group->rt_feedback = std::make_shared<FollowJTrajAction::Feedback>();
+    preallocate_feedback(*group->rt_feedback, group.get());
+
+    // the group is not moved, only its pointer
+    JointGroup & group_ref = *group;
+    group->action_server = rclcpp_action::create_server<FollowJTrajAction>(
+      get_node()->get_node_base_interface(), get_node()->get_node_clock_interface(),
+      get_node()->get_node_logging_interface(), get_node()->get_node_waitables_interface(),
+      std::string(get_node()->get_name()) + "/" + group_name + "/follow_joint_trajectory",
+      [this, &group_ref](
+        const rclcpp_action::GoalUUID &, std::shared_ptr<const FollowJTrajAction::Goal> goal)
+      { return group_goal_received_callback(group_ref, goal); },
+      [this, &group_ref](
+        const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+      { return group_goal_cancelled_callback(group_ref, goal_handle); },
+      [this, &group_ref](
+        std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+      { group_goal_accepted_callback(group_ref, goal_handle); });
+    joint_groups_.push_back(std::move(group));
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(stored_trajectories_mutex_);
+    stored_trajectories_.clear();
+  }
+  if (params_.stored_trajectories.max_count > 0 && params_.joint_groups.empty())
+  {
+    store_trajectory_subscriber_ =
+      get_node()->create_subscription<trajectory_msgs::msg::JointTrajectory>(
+        "~/store_trajectory", rclcpp::SystemDefaultsQoS(),
+        std::bind(&JointTrajectoryController::store_trajectory_callback, this, _1));
+  }
+  else
+  {
+    store_trajectory_subscriber_.reset();
+  }
 
   query_state_srv_ = get_node()->create_service<control_msgs::srv::QueryTrajectoryState>(
     std::string(get_node()->get_name()) + "/query_state",
     std::bind(&JointTrajectoryController::query_state_service, this, _1, _2));
+  memory_footprint_srv_ = get_node()->create_service<std_srvs::srv::Trigger>(
+    std::string(get_node()->get_name()) + "/get_memory_footprint",
+    std::bind(&JointTrajectoryController::get_memory_footprint, this, _1, _2));
 
   return CallbackReturn::SUCCESS;
 }
@@ -862,43 +1702,97 @@ controller_interface::CallbackReturn JointTrajectoryController::on_configure(
 controller_interface::CallbackReturn JointTrajectoryController::on_activate(
   const rclcpp_lifecycle::State &)
 {
-  // order all joints in the storage
+  // order all joints in the storage, with the positions of the last activation if they still match
   for (const auto & interface : params_.command_interfaces)
   {
     auto it =
       std::find(allowed_interface_types_.begin(), allowed_interface_types_.end(), interface);
     auto index = std::distance(allowed_interface_types_.begin(), it);
-    if (!controller_interface::get_ordered_interfaces(
-          command_interfaces_, command_joint_names_, interface, joint_command_interface_[index]))
+    auto & order = command_interface_orders_[static_cast<size_t>(index)];
+    if (!order.update(command_interfaces_))
     {
       RCLCPP_ERROR(
-        get_node()->get_logger(), "Expected %zu '%s' command interfaces, got %zu.", dof_,
-        interface.c_str(), joint_command_interface_[index].size());
+        get_node()->get_logger(), "Expected %zu '%s' command interfaces, one is missing.", dof_,
+        interface.c_str());
       return CallbackReturn::ERROR;
     }
+    joint_command_interface_[index].clear();
+    for (const size_t position : order.indices())
+    {
+      joint_command_interface_[index].emplace_back(command_interfaces_[position]);
+    }
   }
   for (const auto & interface : params_.state_interfaces)
   {
     auto it =
       std::find(allowed_interface_types_.begin(), allowed_interface_types_.end(), interface);
     auto index = std::distance(allowed_interface_types_.begin(), it);
-    if (!controller_interface::get_ordered_interfaces(
-          state_interfaces_, params_.joints, interface, joint_state_interface_[index]))
+    auto & order = state_interface_orders_[static_cast<size_t>(index)];
+    if (!order.update(state_interfaces_))
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Expected %zu '%s' state interfaces, one is missing.", dof_,
+        interface.c_str());
+      return CallbackReturn::ERROR;
+    }
+    joint_state_interface_[index].clear();
+    for (const size_t position : order.indices())
+    {
+      joint_state_interface_[index].emplace_back(state_interfaces_[position]);
+    }
+  }
+  command_interface_table_.assign(allowed_interface_types_.size() * dof_, nullptr);
+  state_interface_table_.assign(allowed_interface_types_.size() * dof_, nullptr);
+  for (size_t type_index = 0; type_index < allowed_interface_types_.size(); ++type_index)
+  {
+    for (size_t index = 0; index < joint_command_interface_[type_index].size(); ++index)
+    {
+      command_interface_table_[type_index * dof_ + index] =
+        &joint_command_interface_[type_index][index].get();
+    }
+    for (size_t index = 0; index < joint_state_interface_[type_index].size(); ++index)
+    {
+      state_interface_table_[type_index * dof_ + index] =
+        &joint_state_interface_[type_index][index].get();
+    }
+  }
+  if (command_sequence_)
+  {
+    if (!command_sequence_order_.update(command_interfaces_))
     {
       RCLCPP_ERROR(
-        get_node()->get_logger(), "Expected %zu '%s' state interfaces, got %zu.", dof_,
-        interface.c_str(), joint_state_interface_[index].size());
+        get_node()->get_logger(), "Expected %zu command sequence interfaces, one is missing.",
+        command_sequence_->size());
       return CallbackReturn::ERROR;
     }
+    command_sequence_sources_.clear();
+    for (const auto & interface : params_.command_interfaces)
+    {
+      const auto type_index = static_cast<size_t>(std::distance(
+        allowed_interface_types_.begin(),
+        std::find(allowed_interface_types_.begin(), allowed_interface_types_.end(), interface)));
+      command_sequence_sources_.insert(
+        command_sequence_sources_.end(), command_interfaces_of(type_index),
+        command_interfaces_of(type_index) + dof_);
+    }
+    command_sequence_interfaces_.clear();
+    for (const size_t position : command_sequence_order_.indices())
+    {
+      command_sequence_interfaces_.push_back(&command_interfaces_[position]);
+    }
+    command_sequence_->restart();
   }
 
-  // Store 'home' pose
-  traj_msg_home_ptr_ = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
-  traj_msg_home_ptr_->header.stamp.sec = 0;
-  traj_msg_home_ptr_->header.stamp.nanosec = 0;
-  traj_msg_home_ptr_->points.resize(1);
-  traj_msg_home_ptr_->points[0].time_from_start.sec = 0;
-  traj_msg_home_ptr_->points[0].time_from_start.nanosec = 50000000;
+  // Store 'home' pose, in the msg of the previous activation if any
+  if (!traj_msg_home_ptr_)
+  {
+    traj_msg_home_ptr_ = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+    traj_msg_home_ptr_->header.stamp.sec = 0;
+    traj_msg_home_ptr_->header.stamp.nanosec = 0;
+    traj_msg_home_ptr_->points.resize(1);
+    traj_msg_home_ptr_->points[0].time_from_start.sec = 0;
+    traj_msg_home_ptr_->points[0].time_from_start.nanosec = 50000000;
+  }
   traj_msg_home_ptr_->points[0].positions.resize(joint_state_interface_[0].size());
   for (size_t index = 0; index < joint_state_interface_[0].size(); ++index)
   {
@@ -906,35 +1800,205 @@ controller_interface::CallbackReturn JointTrajectoryController::on_activate(
       joint_state_interface_[0][index].get().get_value();
   }
 
-  traj_external_point_ptr_ = std::make_shared<Trajectory>();
-  traj_home_point_ptr_ = std::make_shared<Trajectory>();
-  traj_msg_external_point_ptr_.writeFromNonRT(
-    std::shared_ptr<trajectory_msgs::msg::JointTrajectory>());
-
-  subscriber_is_active_ = true;
-  traj_point_active_ptr_ = &traj_external_point_ptr_;
-
-  // Initialize current state storage if hardware state has tracking offset
-  read_state_from_hardware(state_current_);
-  read_state_from_hardware(state_desired_);
-  read_state_from_hardware(last_commanded_state_);
+  // from the pool, so that the realtime loop doesn't free it when it swaps in the first trajectory
+  traj_external_point_ptr_ = trajectory_pool_.acquire();
+  *traj_external_point_ptr_ = Trajectory();
+  if (traj_home_point_ptr_)
+  {
+    *traj_home_point_ptr_ = Trajectory();
+  }
+  else
+  {
+    traj_home_point_ptr_ = std::make_shared<Trajectory>();
+  }
+  traj_external_point_buffer_.writeFromNonRT(std::shared_ptr<Trajectory>());
+  rt_buffered_trajectory_ = nullptr;
+  {
+    std::lock_guard<std::mutex> guard(stream_mutex_);
+    stream_msg_.reset();
+    stream_file_.reset();
+  }
+
+  subscriber_is_active_ = true;
+  traj_point_active_ptr_ = &traj_external_point_ptr_;
+  tracked_goal_ = nullptr;
+
+  // Initialize current state storage if hardware state has tracking offset
+  read_state_from_hardware(state_current_);
+  state_current_.to_msg(state_desired_);
+  state_current_.to_msg(last_commanded_state_);
   // Handle restart of controller by reading from commands if
   // those are not nan
   trajectory_msgs::msg::JointTrajectoryPoint state;
   resize_joint_trajectory_point(state, dof_);
   if (read_state_from_command_interfaces(state))
   {
-    state_current_ = state;
+    state_current_.from_msg(state);
     state_desired_ = state;
     last_commanded_state_ = state;
   }
 
+  for (auto & group : joint_groups_)
+  {
+    group->trajectory_buffer.writeFromNonRT(std::shared_ptr<Trajectory>());
+    group->trajectory.reset();
+    group->buffered_trajectory.reset();
+    group->sampled = false;
+    group->next_feedback_time_ns = std::numeric_limits<int64_t>::min();
+  }
+  if (!joint_groups_.empty())
+  {
+    // the groups hold the positions read above until they get a trajectory
+    state_desired_.velocities.assign(dof_, 0.0);
+    state_desired_.accelerations.assign(dof_, 0.0);
+  }
+
+  {
+    // the buffer of the previous activation is reused
+    std::lock_guard<std::mutex> guard(state_snapshot_mutex_);
+    if (!state_snapshot_)
+    {
+      state_snapshot_ =
+        std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<StateSnapshot>>(
+          StateSnapshot());
+    }
+    auto & snapshot = state_snapshot_->write_buffer();
+    snapshot.time = get_node()->now();
+    snapshot.desired = state_desired_;
+    state_current_.to_msg(snapshot.current);
+    state_error_.to_msg(snapshot.error);
+    snapshot.trajectory.reset();
+    state_snapshot_->publish();
+  }
+
+  if (params_.input_recording.enable)
+  {
+    std::vector<std::string> state_names;
+    for (const auto & interface : state_interfaces_)
+    {
+      state_names.push_back(interface.get_name());
+    }
+    input_recorder_ = std::make_unique<controller_realtime_tools::InputRecorder>(
+      params_.input_recording.path, state_names, reference_interfaces_.size(),
+      static_cast<size_t>(params_.input_recording.capacity));
+    if (!input_recorder_->good())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Unable to record the inputs to '%s'",
+        params_.input_recording.path.c_str());
+      input_recorder_.reset();
+      return CallbackReturn::ERROR;
+    }
+  }
+
+  prefault_memory();
+  allocation_counter_.reset();
+
+  // the preceding controller has to write the references again
+  std::fill(
+    reference_interfaces_.begin(), reference_interfaces_.end(),
+    std::numeric_limits<double>::quiet_NaN());
+
+  // publish the state and the feedback in the first update
+  state_publisher_->reset_period();
+  next_feedback_time_ns_ = std::numeric_limits<int64_t>::min();
+
   return CallbackReturn::SUCCESS;
 }
 
+void JointTrajectoryController::prefault_memory()
+{
+  controller_realtime_tools::MemoryPrefaulter prefaulter;
+  prefaulter.set_label("states");
+  add_point(prefaulter, state_current_);
+  add_point(prefaulter, state_error_);
+  for (auto * point :
+       {&command_current_, &state_desired_, &last_commanded_state_, &blend_state_,
+        &lookahead_state_})
+  {
+    add_point(prefaulter, *point);
+  }
+  prefaulter.set_label("interfaces");
+  prefaulter.add(tmp_command_);
+  prefaulter.add(ff_velocity_scale_);
+  prefaulter.add(reference_interfaces_);
+  prefaulter.add(command_interface_table_);
+  prefaulter.add(state_interface_table_);
+  prefaulter.set_label("trajectory_pool");
+  trajectory_pool_.add_to(prefaulter);
+
+  const auto add_state_msg = [&prefaulter](ControllerStateMsg & msg)
+  {
+    prefaulter.add(msg.joint_names);
+    add_point(prefaulter, msg.reference);
+    add_point(prefaulter, msg.feedback);
+    add_point(prefaulter, msg.error);
+    add_point(prefaulter, msg.output);
+  };
+  prefaulter.set_label("state_msgs");
+  add_state_msg(state_msg_);
+  state_publisher_->visit_messages(add_state_msg);
+  prefaulter.set_label("action_feedback");
+  add_feedback(prefaulter, *rt_feedback_);
+  prefaulter.set_label("joint_groups");
+  for (auto & group : joint_groups_)
+  {
+    add_point(prefaulter, group->desired);
+    add_feedback(prefaulter, *group->rt_feedback);
+  }
+
+  const size_t pages = prefaulter.prefault();
+  RCLCPP_DEBUG(
+    get_node()->get_logger(), "Prefaulted %zu pages of %zu preallocated bytes", pages,
+    prefaulter.size());
+  if (params_.lock_memory && !prefaulter.lock())
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(),
+      "Unable to lock the preallocated memory, check the RLIMIT_MEMLOCK of the process");
+  }
+
+  std::lock_guard<std::mutex> guard(memory_footprint_mutex_);
+  memory_footprint_ = prefaulter.footprint();
+}
+
+void JointTrajectoryController::get_memory_footprint(
+  const std::shared_ptr<std_srvs::srv::Trigger::Request> /*request*/,
+  std::shared_ptr<std_srvs::srv::Trigger::Response> response)
+{
+  std::lock_guard<std::mutex> guard(memory_footprint_mutex_);
+  if (memory_footprint_.empty())
+  {
+    response->success = false;
+    response->message = "Not activated yet";
+    return;
+  }
+  // stored trajectories come and go while active, they are immutable once stored
+  auto footprint = memory_footprint_;
+  {
+    std::lock_guard<std::mutex> stored_guard(stored_trajectories_mutex_);
+    size_t stored_bytes = controller_realtime_tools::heap_bytes(stored_trajectories_);
+    for (const auto & stored : stored_trajectories_)
+    {
+      stored_bytes += sizeof(Trajectory) + stored.second->heap_bytes();
+    }
+    footprint.emplace_back("stored_trajectories", stored_bytes);
+  }
+  // fails once an update allocated, if the allocations are counted
+  response->success = allocation_counter_.allocations() == 0;
+  response->message =
+    controller_realtime_tools::format_memory_report(footprint, allocation_counter_);
+}
+
 controller_interface::CallbackReturn JointTrajectoryController::on_deactivate(
   const rclcpp_lifecycle::State &)
 {
+  // trajectories preprocessed for this activation are dropped with the next one
+  if (preprocessing_worker_)
+  {
+    preprocessing_worker_->wait_until_idle();
+  }
+
   // TODO(anyone): How to halt when using effort commands?
   for (size_t index = 0; index < dof_; ++index)
   {
@@ -960,7 +2024,11 @@ controller_interface::CallbackReturn JointTrajectoryController::on_deactivate(
     joint_command_interface_[index].clear();
     joint_state_interface_[index].clear();
   }
+  command_interface_table_.clear();
+  state_interface_table_.clear();
   release_interfaces();
+  // writes the inputs left
+  input_recorder_.reset();
 
   subscriber_is_active_ = false;
 
@@ -995,13 +2063,7 @@ bool JointTrajectoryController::reset()
   subscriber_is_active_ = false;
   joint_command_subscriber_.reset();
 
-  for (const auto & pid : pids_)
-  {
-    if (pid)
-    {
-      pid->reset();
-    }
-  }
+  pids_.reset();
 
   // iterator has no default value
   // prev_traj_point_ptr_;
@@ -1023,47 +2085,95 @@ controller_interface::CallbackReturn JointTrajectoryController::on_shutdown(
 
 void JointTrajectoryController::publish_state(
   const rclcpp::Time & time, const JointTrajectoryPoint & desired_state,
-  const JointTrajectoryPoint & current_state, const JointTrajectoryPoint & state_error)
+  const controller_realtime_tools::JointVectors & current_state,
+  const controller_realtime_tools::JointVectors & state_error)
 {
-  if (state_publisher_->trylock())
+  // if the publisher is busy, or the update over its budget, the state is still due in the next
+  // cycle
+  if (
+    !state_publisher_->is_due(time.nanoseconds()) ||
+    (cycle_budget_ && cycle_budget_->skip(SHED_PUBLISH_STATE)))
   {
-    state_publisher_->msg_.header.stamp = time;
-    state_publisher_->msg_.reference.positions = desired_state.positions;
-    state_publisher_->msg_.reference.velocities = desired_state.velocities;
-    state_publisher_->msg_.reference.accelerations = desired_state.accelerations;
-    state_publisher_->msg_.feedback.positions = current_state.positions;
-    state_publisher_->msg_.error.positions = state_error.positions;
-    if (has_velocity_state_interface_)
-    {
-      state_publisher_->msg_.feedback.velocities = current_state.velocities;
-      state_publisher_->msg_.error.velocities = state_error.velocities;
-    }
-    if (has_acceleration_state_interface_)
-    {
-      state_publisher_->msg_.feedback.accelerations = current_state.accelerations;
-      state_publisher_->msg_.error.accelerations = state_error.accelerations;
-    }
-    if (read_commands_from_command_interfaces(command_current_))
-    {
-      state_publisher_->msg_.output = command_current_;
-    }
+    return;
+  }
 
-    state_publisher_->unlockAndPublish();
+  state_msg_.header.stamp = time;
+  state_msg_.reference.positions = desired_state.positions;
+  state_msg_.reference.velocities = desired_state.velocities;
+  state_msg_.reference.accelerations = desired_state.accelerations;
+  state_msg_.feedback.positions = current_state.positions;
+  state_msg_.error.positions = state_error.positions;
+  if (has_velocity_state_interface_)
+  {
+    state_msg_.feedback.velocities = current_state.velocities;
+    state_msg_.error.velocities = state_error.velocities;
+  }
+  if (has_acceleration_state_interface_)
+  {
+    state_msg_.feedback.accelerations = current_state.accelerations;
+    state_msg_.error.accelerations = state_error.accelerations;
+  }
+  if (read_commands_from_command_interfaces(command_current_))
+  {
+    state_msg_.output = command_current_;
   }
+  state_publisher_->try_publish(state_msg_, time.nanoseconds());
 }
 
 void JointTrajectoryController::topic_callback(
   const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg)
 {
+  CONTROLLER_TRACEPOINT(TRAJECTORY_RECEIVED, this, msg->points.size());
+  if (command_latency_)
+  {
+    // the header stamp of a trajectory is its start time, not the time it was published
+    command_latency_->command_received(0, get_node()->now().nanoseconds());
+  }
+  if (preprocessing_worker_)
+  {
+    preprocessing_worker_->post([this, msg]() { process_topic_trajectory_msg(msg); });
+  }
+  else
+  {
+    process_topic_trajectory_msg(msg);
+  }
+}
+
+void JointTrajectoryController::process_topic_trajectory_msg(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & msg)
+{
+  if (is_in_chained_mode())
+  {
+    RCLCPP_WARN(
+      get_node()->get_logger(),
+      "Ignoring the trajectory received in chained mode, the references of the preceding "
+      "controller are followed.");
+    return;
+  }
+  if (is_stored_trajectory_reference(*msg))
+  {
+    const auto stored_trajectory = find_stored_trajectory(*msg);
+    if (stored_trajectory && subscriber_is_active_)
+    {
+      add_stored_trajectory(*stored_trajectory, *msg);
+    }
+    return;
+  }
   if (!validate_trajectory_msg(*msg))
   {
     return;
   }
   // http://wiki.ros.org/joint_trajectory_controller/UnderstandingTrajectoryReplacement
-  // always replace old msg with new one for now
   if (subscriber_is_active_)
   {
-    add_new_trajectory_msg(msg);
+    if (params_.splice_topic_trajectories)
+    {
+      splice_new_trajectory_msg(msg);
+    }
+    else
+    {
+      add_new_trajectory_msg(msg);
+    }
   }
 };
 
@@ -1080,7 +2190,42 @@ rclcpp_action::GoalResponse JointTrajectoryController::goal_received_callback(
     return rclcpp_action::GoalResponse::REJECT;
   }
 
-  if (!validate_trajectory_msg(goal->trajectory))
+  if (is_in_chained_mode())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "Can't accept new action goals. Controller follows the references of the preceding "
+      "controller in chained mode.");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (is_trajectory_file_reference(goal->trajectory))
+  {
+    using interpolation_methods::InterpolationMethod;
+    // the points are spliced in while executing, they can't be queued or parameterized as a whole
+    if (
+      params_.queue_goals || interpolation_method_ == InterpolationMethod::MINIMUM_JERK ||
+      interpolation_method_ == InterpolationMethod::TRAPEZOIDAL)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "Can't execute trajectory files with queue_goals or the interpolation method '%s'.",
+        params_.interpolation_method.c_str());
+      return rclcpp_action::GoalResponse::REJECT;
+    }
+    if (!open_trajectory_file(goal->trajectory))
+    {
+      return rclcpp_action::GoalResponse::REJECT;
+    }
+  }
+  else if (is_stored_trajectory_reference(goal->trajectory))
+  {
+    if (!find_stored_trajectory(goal->trajectory))
+    {
+      return rclcpp_action::GoalResponse::REJECT;
+    }
+  }
+  else if (!validate_trajectory_msg(goal->trajectory))
   {
     return rclcpp_action::GoalResponse::REJECT;
   }
@@ -1094,10 +2239,21 @@ rclcpp_action::CancelResponse JointTrajectoryController::goal_cancelled_callback
 {
   RCLCPP_INFO(get_node()->get_logger(), "Got request to cancel goal");
 
+  // a queued goal is just dropped
+  const auto next_goal = rt_active_goal_.get_next();
+  if (next_goal && next_goal->gh_ == goal_handle && rt_active_goal_.reset_next() == next_goal)
+  {
+    next_goal->setCanceled(std::make_shared<FollowJTrajAction::Result>());
+    action_monitor_->notify();
+    return rclcpp_action::CancelResponse::ACCEPT;
+  }
+
   // Check that cancel request refers to currently active goal (if any)
-  const auto active_goal = *rt_active_goal_.readFromNonRT();
+  const auto active_goal = rt_active_goal_.get();
   if (active_goal && active_goal->gh_ == goal_handle)
   {
+    abort_queued_goal();
+
     // Controller uptime
     // Enter hold current position mode
     set_hold_position();
@@ -1108,7 +2264,8 @@ rclcpp_action::CancelResponse JointTrajectoryController::goal_cancelled_callback
     // Mark the current goal as canceled
     auto action_res = std::make_shared<FollowJTrajAction::Result>();
     active_goal->setCanceled(action_res);
-    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    rt_active_goal_.reset();
+    action_monitor_->notify();
   }
   return rclcpp_action::CancelResponse::ACCEPT;
 }
@@ -1116,185 +2273,470 @@ rclcpp_action::CancelResponse JointTrajectoryController::goal_cancelled_callback
 void JointTrajectoryController::goal_accepted_callback(
   std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
 {
-  // Update new trajectory
+  CONTROLLER_TRACEPOINT(
+    TRAJECTORY_RECEIVED, this, goal_handle->get_goal()->trajectory.points.size());
+  if (command_latency_)
+  {
+    command_latency_->command_received(0, get_node()->now().nanoseconds());
+  }
+  // a queued goal is started after the active one instead
+  if (!params_.queue_goals)
   {
     preempt_active_goal();
-    auto traj_msg =
-      std::make_shared<trajectory_msgs::msg::JointTrajectory>(goal_handle->get_goal()->trajectory);
-
-    add_new_trajectory_msg(traj_msg);
   }
 
-  // Update the active goal
   RealtimeGoalHandlePtr rt_goal = std::make_shared<RealtimeGoalHandle>(goal_handle);
-  rt_goal->preallocated_feedback_->joint_names = params_.joints;
+  preallocate_feedback(*rt_goal->preallocated_feedback_);
   rt_goal->execute();
-  rt_active_goal_.writeFromNonRT(rt_goal);
 
-  // Set smartpointer to expire for create_wall_timer to delete previous entry from timer list
-  goal_handle_timer_.reset();
+  {
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    monitored_goals_.push_back(rt_goal);
+  }
+  action_monitor_->notify();
 
-  // Setup goal status checking timer
-  goal_handle_timer_ = get_node()->create_wall_timer(
-    action_monitor_period_.to_chrono<std::chrono::nanoseconds>(),
-    std::bind(&RealtimeGoalHandle::runNonRealtime, rt_goal));
+  // Update new trajectory, then the active goal
+  if (preprocessing_worker_)
+  {
+    preprocessing_worker_->post([this, rt_goal]() { activate_goal(rt_goal); });
+  }
+  else
+  {
+    activate_goal(rt_goal);
+  }
 }
 
-void JointTrajectoryController::fill_partial_goal(
-  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg) const
+bool JointTrajectoryController::monitor_goal()
 {
-  // joint names in the goal are a subset of existing joints, as checked in goal_callback
-  // so if the size matches, the goal contains all controller joints
-  if (dof_ == trajectory_msg->joint_names.size())
+  // the realtime loop leaves the queued goal behind an aborted one
+  if (!rt_active_goal_.get())
   {
-    return;
+    abort_queued_goal();
   }
+  const bool reading_file = advance_trajectory_file();
 
-  trajectory_msg->joint_names.reserve(dof_);
-
-  for (size_t index = 0; index < dof_; ++index)
+  std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+  const auto active_goal = rt_active_goal_.get();
+  const auto next_goal = rt_active_goal_.get_next();
+  const auto in_realtime_loop = [&](const RealtimeGoalHandlePtr & goal)
+  {
+    return goal == active_goal || goal == next_goal ||
+           std::any_of(
+             joint_groups_.begin(), joint_groups_.end(),
+             [&goal](const auto & group) { return group->rt_active_goal.get() == goal; });
+  };
+  bool waiting = false;
+  for (auto it = monitored_goals_.begin(); it != monitored_goals_.end();)
   {
+    const auto & goal = *it;
+    goal->runNonRealtime();
+    if (!goal->gh_->is_active())
     {
-      if (
-        std::find(
-          trajectory_msg->joint_names.begin(), trajectory_msg->joint_names.end(),
-          params_.joints[index]) != trajectory_msg->joint_names.end())
-      {
-        // joint found on msg
-        continue;
-      }
-      trajectory_msg->joint_names.push_back(params_.joints[index]);
-
-      for (auto & it : trajectory_msg->points)
-      {
-        // Assume hold position with 0 velocity and acceleration for missing joints
-        if (!it.positions.empty())
-        {
-          if (
-            has_position_command_interface_ &&
-            !std::isnan(joint_command_interface_[0][index].get().get_value()))
-          {
-            // copy last command if cmd interface exists
-            it.positions.push_back(joint_command_interface_[0][index].get().get_value());
-          }
-          else if (has_position_state_interface_)
-          {
-            // copy current state if state interface exists
-            it.positions.push_back(joint_state_interface_[0][index].get().get_value());
-          }
-        }
-        if (!it.velocities.empty())
-        {
-          it.velocities.push_back(0.0);
-        }
-        if (!it.accelerations.empty())
-        {
-          it.accelerations.push_back(0.0);
-        }
-        if (!it.effort.empty())
-        {
-          it.effort.push_back(0.0);
-        }
-      }
+      it = monitored_goals_.erase(it);
+      continue;
     }
+    // a goal which isn't active or queued in the realtime loop is canceled or not activated yet
+    waiting = waiting || !in_realtime_loop(goal);
+    ++it;
   }
+  return waiting || reading_file;
 }
 
-void JointTrajectoryController::sort_to_local_joint_order(
-  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg)
+void JointTrajectoryController::activate_goal(const RealtimeGoalHandlePtr & rt_goal)
 {
-  // rearrange all points in the trajectory message based on mapping
-  std::vector<size_t> mapping_vector = mapping(trajectory_msg->joint_names, params_.joints);
-  auto remap = [this](
-                 const std::vector<double> & to_remap,
-                 const std::vector<size_t> & mapping) -> std::vector<double>
+  const auto trajectory = compile_goal_trajectory(rt_goal);
+  if (!trajectory)
   {
-    if (to_remap.empty())
-    {
-      return to_remap;
-    }
-    if (to_remap.size() != mapping.size())
+    return;
+  }
+  if (params_.queue_goals && rt_active_goal_.get())
+  {
+    queue_goal(rt_goal, trajectory);
+    return;
+  }
+  add_new_trajectory(trajectory);
+  rt_active_goal_.set(rt_goal);
+}
+
+std::shared_ptr<Trajectory> JointTrajectoryController::compile_goal_trajectory(
+  const RealtimeGoalHandlePtr & rt_goal)
+{
+  auto action_res = std::make_shared<FollowJTrajAction::Result>();
+  // the goal may have been canceled while waiting for the preprocessing worker
+  if (rt_goal->gh_->is_canceling())
+  {
+    rt_goal->setCanceled(action_res);
+    action_monitor_->notify();
+    return nullptr;
+  }
+
+  const auto & goal_trajectory = rt_goal->gh_->get_goal()->trajectory;
+  if (is_trajectory_file_reference(goal_trajectory))
+  {
+    std::string error = "Trajectory file of the goal can't be opened anymore.";
+    const auto file = open_trajectory_file(goal_trajectory);
+    auto trajectory = file ? compile_trajectory_file(file, goal_trajectory, error) : nullptr;
+    if (!trajectory)
     {
-      RCLCPP_WARN(
-        get_node()->get_logger(), "Invalid input size (%zu) for sorting", to_remap.size());
-      return to_remap;
+      action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+      action_res->set__error_string(error);
+      rt_goal->setAborted(action_res);
+      action_monitor_->notify();
     }
-    std::vector<double> output;
-    output.resize(mapping.size(), 0.0);
-    for (size_t index = 0; index < mapping.size(); ++index)
+    return trajectory;
+  }
+  if (is_stored_trajectory_reference(goal_trajectory))
+  {
+    const auto stored_trajectory = find_stored_trajectory(goal_trajectory);
+    // it may have been removed since the goal was received
+    if (!stored_trajectory)
     {
-      auto map_index = mapping[index];
-      output[map_index] = to_remap[index];
+      action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+      action_res->set__error_string("Stored trajectory of the goal was removed.");
+      rt_goal->setAborted(action_res);
+      action_monitor_->notify();
+      return nullptr;
     }
-    return output;
-  };
-
-  for (size_t index = 0; index < trajectory_msg->points.size(); ++index)
+    return instantiate_stored_trajectory(*stored_trajectory, goal_trajectory);
+  }
+  else if (is_executable_unchanged(goal_trajectory))
   {
-    trajectory_msg->points[index].positions =
-      remap(trajectory_msg->points[index].positions, mapping_vector);
-
-    trajectory_msg->points[index].velocities =
-      remap(trajectory_msg->points[index].velocities, mapping_vector);
-
-    trajectory_msg->points[index].accelerations =
-      remap(trajectory_msg->points[index].accelerations, mapping_vector);
-
-    trajectory_msg->points[index].effort =
-      remap(trajectory_msg->points[index].effort, mapping_vector);
+    // the trajectory is compiled from the goal itself, which the alias keeps alive. Neither the
+    // trajectory nor anything else changes the msg in that case.
+    std::shared_ptr<trajectory_msgs::msg::JointTrajectory> traj_msg(
+      rt_goal->gh_->get_goal(),
+      const_cast<trajectory_msgs::msg::JointTrajectory *>(&goal_trajectory));
+    return acquire_trajectory(traj_msg);
   }
+  auto traj_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(goal_trajectory);
+  return compile_trajectory_msg(traj_msg);
 }
 
-bool JointTrajectoryController::validate_trajectory_point_field(
-  size_t joint_names_size, const std::vector<double> & vector_field,
-  const std::string & string_for_vector_field, size_t i, bool allow_empty) const
+void JointTrajectoryController::queue_goal(
+  const RealtimeGoalHandlePtr & rt_goal, const std::shared_ptr<Trajectory> & trajectory)
 {
-  if (allow_empty && vector_field.empty())
+  CONTROLLER_TRACEPOINT(TRAJECTORY_COMPILED, this, trajectory->end() - trajectory->begin());
+  std::lock_guard<std::mutex> guard(queued_trajectory_mutex_);
+  // the trajectory is handed over first, the realtime loop only starts a queued goal with its own
+  auto & queued_trajectory = queued_trajectory_.write_buffer();
+  queued_trajectory.goal = rt_goal.get();
+  queued_trajectory.trajectory = trajectory;
+  queued_trajectory_.publish();
+
+  const auto replaced_goal = rt_active_goal_.set_next(rt_goal);
+  if (replaced_goal)
   {
-    return true;
+    auto action_res = std::make_shared<FollowJTrajAction::Result>();
+    action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+    action_res->set__error_string("Queued goal replaced by a newer goal.");
+    replaced_goal->setCanceled(action_res);
   }
-  if (joint_names_size != vector_field.size())
+  // the active goal may have finished in the meantime, the goal is active right away then
+  if (rt_active_goal_.get() == rt_goal)
   {
-    RCLCPP_ERROR(
-      get_node()->get_logger(), "Mismatch between joint_names (%zu) and %s (%zu) at point #%zu.",
-      joint_names_size, string_for_vector_field.c_str(), vector_field.size(), i);
-    return false;
+    add_new_trajectory(trajectory);
   }
-  return true;
+  action_monitor_->notify();
 }
 
-bool JointTrajectoryController::validate_trajectory_msg(
-  const trajectory_msgs::msg::JointTrajectory & trajectory) const
+void JointTrajectoryController::abort_queued_goal()
 {
-  // If partial joints goals are not allowed, goal should specify all controller joints
-  if (!params_.allow_partial_joints_goal)
+  const auto next_goal = rt_active_goal_.reset_next();
+  if (next_goal)
   {
-    if (trajectory.joint_names.size() != dof_)
-    {
-      RCLCPP_ERROR(
-        get_node()->get_logger(),
-        "Joints on incoming trajectory don't match the controller joints.");
-      return false;
-    }
+    auto action_res = std::make_shared<FollowJTrajAction::Result>();
+    action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+    action_res->set__error_string("The goal ahead of the queued goal was not reached.");
+    next_goal->setAborted(action_res);
+    action_monitor_->notify();
   }
+}
 
-  if (trajectory.joint_names.empty())
+rclcpp_action::GoalResponse JointTrajectoryController::group_goal_received_callback(
+  JointGroup & group, std::shared_ptr<const FollowJTrajAction::Goal> goal)
+{
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Received new action goal of group '%s'", group.name.c_str());
+
+  // Precondition: Running controller
+  if (get_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
   {
-    RCLCPP_ERROR(get_node()->get_logger(), "Empty joint names on incoming trajectory.");
-    return false;
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Can't accept new action goals. Controller is not running.");
+    return rclcpp_action::GoalResponse::REJECT;
   }
 
-  const auto trajectory_start_time = static_cast<rclcpp::Time>(trajectory.header.stamp);
-  // If the starting time it set to 0.0, it means the controller should start it now.
-  // Otherwise we check if the trajectory ends before the current time,
-  // in which case it can be ignored.
-  if (trajectory_start_time.seconds() != 0.0)
+  if (is_in_chained_mode())
   {
-    auto trajectory_end_time = trajectory_start_time;
-    for (const auto & p : trajectory.points)
-    {
-      trajectory_end_time += p.time_from_start;
-    }
+    RCLCPP_ERROR(
+      get_node()->get_logger(),
+      "Can't accept new action goals. Controller follows the references of the preceding "
+      "controller in chained mode.");
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  if (!validate_trajectory_msg(goal->trajectory, &group))
+  {
+    return rclcpp_action::GoalResponse::REJECT;
+  }
+
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Accepted new action goal of group '%s'", group.name.c_str());
+  return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+}
+
+rclcpp_action::CancelResponse JointTrajectoryController::group_goal_cancelled_callback(
+  JointGroup & group,
+  const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+{
+  RCLCPP_INFO(
+    get_node()->get_logger(), "Got request to cancel goal of group '%s'", group.name.c_str());
+
+  // Check that cancel request refers to the active goal of the group (if any)
+  const auto active_goal = group.rt_active_goal.get();
+  if (active_goal && active_goal->gh_ == goal_handle)
+  {
+    preempt_group_goal(group, "");
+  }
+  return rclcpp_action::CancelResponse::ACCEPT;
+}
+
+void JointTrajectoryController::group_goal_accepted_callback(
+  JointGroup & group,
+  std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowJTrajAction>> goal_handle)
+{
+  CONTROLLER_TRACEPOINT(
+    TRAJECTORY_RECEIVED, this, goal_handle->get_goal()->trajectory.points.size());
+  if (command_latency_)
+  {
+    command_latency_->command_received(0, get_node()->now().nanoseconds());
+  }
+  // only the goal of this group is preempted
+  preempt_group_goal(group, "Current goal cancelled due to new incoming action.");
+
+  RealtimeGoalHandlePtr rt_goal = std::make_shared<RealtimeGoalHandle>(goal_handle);
+  preallocate_feedback(*rt_goal->preallocated_feedback_, &group);
+  rt_goal->execute();
+
+  {
+    std::lock_guard<std::mutex> guard(monitored_goal_mutex_);
+    monitored_goals_.push_back(rt_goal);
+  }
+  action_monitor_->notify();
+
+  if (preprocessing_worker_)
+  {
+    preprocessing_worker_->post([this, &group, rt_goal]() { activate_group_goal(group, rt_goal); });
+  }
+  else
+  {
+    activate_group_goal(group, rt_goal);
+  }
+}
+
+void JointTrajectoryController::activate_group_goal(
+  JointGroup & group, const RealtimeGoalHandlePtr & rt_goal)
+{
+  // compiled for all joints, the realtime loop only takes the joints of the group
+  const auto trajectory = compile_goal_trajectory(rt_goal);
+  if (!trajectory)
+  {
+    return;
+  }
+  CONTROLLER_TRACEPOINT(TRAJECTORY_COMPILED, this, trajectory->end() - trajectory->begin());
+  group.trajectory_buffer.writeFromNonRT(trajectory);
+  group.rt_active_goal.set(rt_goal);
+}
+
+void JointTrajectoryController::preempt_group_goal(JointGroup & group, const std::string & reason)
+{
+  const auto active_goal = group.rt_active_goal.get();
+  if (!active_goal)
+  {
+    return;
+  }
+  // a trajectory without msg lets the realtime loop hold the positions of the group
+  auto hold_trajectory = trajectory_pool_.acquire();
+  *hold_trajectory = Trajectory();
+  group.trajectory_buffer.writeFromNonRT(hold_trajectory);
+
+  auto action_res = std::make_shared<FollowJTrajAction::Result>();
+  if (!reason.empty())
+  {
+    action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+    action_res->set__error_string(reason);
+  }
+  active_goal->setCanceled(action_res);
+  group.rt_active_goal.reset();
+  action_monitor_->notify();
+}
+
+void JointTrajectoryController::fill_partial_goal(
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg) const
+{
+  // joint names in the goal are a subset of existing joints, as checked in goal_callback
+  // so if the size matches, the goal contains all controller joints
+  if (dof_ == trajectory_msg->joint_names.size())
+  {
+    return;
+  }
+
+  // Assume hold position with 0 velocity and acceleration for missing joints. Their positions
+  // are captured once, and every field is rebuilt in the local joint order in one pass, so
+  // sort_to_local_joint_order() has nothing left to do.
+  std::vector<double> hold_positions(dof_, std::numeric_limits<double>::quiet_NaN());
+  for (size_t index = 0; index < dof_; ++index)
+  {
+    if (
+      has_position_command_interface_ &&
+      !std::isnan(joint_command_interface_[0][index].get().get_value()))
+    {
+      // copy last command if cmd interface exists
+      hold_positions[index] = joint_command_interface_[0][index].get().get_value();
+    }
+    else if (has_position_state_interface_)
+    {
+      // copy current state if state interface exists
+      hold_positions[index] = joint_state_interface_[0][index].get().get_value();
+    }
+  }
+  std::vector<size_t> mapping_vector(trajectory_msg->joint_names.size());
+  for (size_t index = 0; index < mapping_vector.size(); ++index)
+  {
+    mapping_vector[index] = joint_indices_.at(trajectory_msg->joint_names[index]);
+  }
+
+  std::vector<double> filled;
+  auto fill = [&filled, &mapping_vector](std::vector<double> & field, const auto & hold_value)
+  {
+    if (field.size() != mapping_vector.size())
+    {
+      return;
+    }
+    filled.assign(hold_value.begin(), hold_value.end());
+    for (size_t index = 0; index < mapping_vector.size(); ++index)
+    {
+      filled[mapping_vector[index]] = field[index];
+    }
+    field.swap(filled);
+  };
+  const std::vector<double> zeros(dof_, 0.0);
+  for (auto & point : trajectory_msg->points)
+  {
+    fill(point.positions, hold_positions);
+    fill(point.velocities, zeros);
+    fill(point.accelerations, zeros);
+    fill(point.effort, zeros);
+  }
+  trajectory_msg->joint_names = params_.joints;
+}
+
+void JointTrajectoryController::sort_to_local_joint_order(
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg)
+{
+  // nothing to rearrange, if the joints are in the local order already
+  if (trajectory_msg->joint_names == params_.joints)
+  {
+    return;
+  }
+
+  // rearrange all points in the trajectory message based on mapping
+  std::vector<size_t> mapping_vector(trajectory_msg->joint_names.size());
+  for (size_t index = 0; index < mapping_vector.size(); ++index)
+  {
+    mapping_vector[index] = joint_indices_.at(trajectory_msg->joint_names[index]);
+  }
+  auto remap = [this](
+                 const std::vector<double> & to_remap,
+                 const std::vector<size_t> & mapping) -> std::vector<double>
+  {
+    if (to_remap.empty())
+    {
+      return to_remap;
+    }
+    if (to_remap.size() != mapping.size())
+    {
+      RCLCPP_WARN(
+        get_node()->get_logger(), "Invalid input size (%zu) for sorting", to_remap.size());
+      return to_remap;
+    }
+    std::vector<double> output;
+    output.resize(mapping.size(), 0.0);
+    for (size_t index = 0; index < mapping.size(); ++index)
+    {
+      auto map_index = mapping[index];
+      output[map_index] = to_remap[index];
+    }
+    return output;
+  };
+
+  for (size_t index = 0; index < trajectory_msg->points.size(); ++index)
+  {
+    trajectory_msg->points[index].positions =
+      remap(trajectory_msg->points[index].positions, mapping_vector);
+
+    trajectory_msg->points[index].velocities =
+      remap(trajectory_msg->points[index].velocities, mapping_vector);
+
+    trajectory_msg->points[index].accelerations =
+      remap(trajectory_msg->points[index].accelerations, mapping_vector);
+
+    trajectory_msg->points[index].effort =
+      remap(trajectory_msg->points[index].effort, mapping_vector);
+  }
+}
+
+bool JointTrajectoryController::validate_trajectory_point_field(
+  size_t joint_names_size, const std::vector<double> & vector_field,
+  const std::string & string_for_vector_field, size_t i, bool allow_empty) const
+{
+  if (allow_empty && vector_field.empty())
+  {
+    return true;
+  }
+  if (joint_names_size != vector_field.size())
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "Mismatch between joint_names (%zu) and %s (%zu) at point #%zu.",
+      joint_names_size, string_for_vector_field.c_str(), vector_field.size(), i);
+    return false;
+  }
+  return true;
+}
+
+bool JointTrajectoryController::validate_trajectory_msg(
+  const trajectory_msgs::msg::JointTrajectory & trajectory, const JointGroup * group) const
+{
+  // If partial joints goals are not allowed, goal should specify all controller joints, or all
+  // joints of the group
+  if (!params_.allow_partial_joints_goal)
+  {
+    if (trajectory.joint_names.size() != (group ? group->joints.size() : dof_))
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "Joints on incoming trajectory don't match the controller joints.");
+      return false;
+    }
+  }
+
+  if (trajectory.joint_names.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Empty joint names on incoming trajectory.");
+    return false;
+  }
+
+  const auto trajectory_start_time = static_cast<rclcpp::Time>(trajectory.header.stamp);
+  // If the starting time it set to 0.0, it means the controller should start it now.
+  // Otherwise we check if the trajectory ends before the current time,
+  // in which case it can be ignored.
+  if (trajectory_start_time.seconds() != 0.0)
+  {
+    auto trajectory_end_time = trajectory_start_time;
+    if (!trajectory.points.empty())
+    {
+      trajectory_end_time += trajectory.points.back().time_from_start;
+    }
     if (trajectory_end_time < get_node()->now())
     {
       RCLCPP_ERROR(
@@ -1309,74 +2751,564 @@ bool JointTrajectoryController::validate_trajectory_msg(
   {
     const std::string & incoming_joint_name = trajectory.joint_names[i];
 
-    auto it = std::find(params_.joints.begin(), params_.joints.end(), incoming_joint_name);
-    if (it == params_.joints.end())
+    const auto it = joint_indices_.find(incoming_joint_name);
+    if (it == joint_indices_.end())
     {
       RCLCPP_ERROR(
         get_node()->get_logger(), "Incoming joint %s doesn't match the controller's joints.",
         incoming_joint_name.c_str());
       return false;
     }
-  }
-
-  rclcpp::Duration previous_traj_time(0ms);
-  for (size_t i = 0; i < trajectory.points.size(); ++i)
-  {
-    if ((i > 0) && (rclcpp::Duration(trajectory.points[i].time_from_start) <= previous_traj_time))
+    if (
+      group &&
+      std::find(group->joints.begin(), group->joints.end(), it->second) == group->joints.end())
     {
       RCLCPP_ERROR(
-        get_node()->get_logger(),
-        "Time between points %zu and %zu is not strictly increasing, it is %f and %f respectively",
-        i - 1, i, previous_traj_time.seconds(),
-        rclcpp::Duration(trajectory.points[i].time_from_start).seconds());
+        get_node()->get_logger(), "Incoming joint %s is not a joint of group '%s'.",
+        incoming_joint_name.c_str(), group->name.c_str());
       return false;
     }
-    previous_traj_time = trajectory.points[i].time_from_start;
+  }
 
-    const size_t joint_count = trajectory.joint_names.size();
-    const auto & points = trajectory.points;
+  // check all points with plain comparisons first, the diagnostics are only built for the first
+  // invalid point
+  const size_t joint_count = trajectory.joint_names.size();
+  auto valid_size = [joint_count](const std::vector<double> & field, bool allow_empty)
+  { return field.size() == joint_count || (allow_empty && field.empty()); };
+  auto to_nanoseconds = [](const builtin_interfaces::msg::Duration & duration)
+  { return static_cast<int64_t>(duration.sec) * 1000000000 + duration.nanosec; };
+
+  const auto & points = trajectory.points;
+  int64_t previous_time_ns = std::numeric_limits<int64_t>::min();
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    const auto & point = points[i];
+    const int64_t time_ns = to_nanoseconds(point.time_from_start);
+    bool valid = i == 0 || time_ns > previous_time_ns;
     // This currently supports only position, velocity and acceleration inputs
     if (params_.allow_integration_in_goal_trajectories)
     {
-      const bool all_empty = points[i].positions.empty() && points[i].velocities.empty() &&
-                             points[i].accelerations.empty();
-      const bool position_error =
-        !points[i].positions.empty() &&
-        !validate_trajectory_point_field(joint_count, points[i].positions, "positions", i, false);
-      const bool velocity_error =
-        !points[i].velocities.empty() &&
-        !validate_trajectory_point_field(joint_count, points[i].velocities, "velocities", i, false);
-      const bool acceleration_error =
-        !points[i].accelerations.empty() &&
-        !validate_trajectory_point_field(
-          joint_count, points[i].accelerations, "accelerations", i, false);
-      if (all_empty || position_error || velocity_error || acceleration_error)
-      {
-        return false;
-      }
+      valid = valid &&
+              !(point.positions.empty() && point.velocities.empty() &&
+                point.accelerations.empty()) &&
+              valid_size(point.positions, true) && valid_size(point.velocities, true) &&
+              valid_size(point.accelerations, true);
     }
-    else if (
-      !validate_trajectory_point_field(joint_count, points[i].positions, "positions", i, false) ||
-      !validate_trajectory_point_field(joint_count, points[i].velocities, "velocities", i, true) ||
-      !validate_trajectory_point_field(
-        joint_count, points[i].accelerations, "accelerations", i, true) ||
-      !validate_trajectory_point_field(joint_count, points[i].effort, "effort", i, true))
+    else
     {
+      valid = valid && valid_size(point.positions, false) && valid_size(point.velocities, true) &&
+              valid_size(point.accelerations, true) && valid_size(point.effort, true);
+    }
+    if (!valid)
+    {
+      log_invalid_trajectory_point(trajectory, i);
       return false;
     }
+    previous_time_ns = time_ns;
   }
   return true;
 }
 
+void JointTrajectoryController::log_invalid_trajectory_point(
+  const trajectory_msgs::msg::JointTrajectory & trajectory, size_t i) const
+{
+  const auto & points = trajectory.points;
+  if (i > 0)
+  {
+    const rclcpp::Duration previous_traj_time(points[i - 1].time_from_start);
+    const rclcpp::Duration traj_time(points[i].time_from_start);
+    if (traj_time <= previous_traj_time)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "Time between points %zu and %zu is not strictly increasing, it is %f and %f respectively",
+        i - 1, i, previous_traj_time.seconds(), traj_time.seconds());
+      return;
+    }
+  }
+
+  const size_t joint_count = trajectory.joint_names.size();
+  if (params_.allow_integration_in_goal_trajectories)
+  {
+    // only the fields given must match the joints
+    if (!points[i].positions.empty())
+    {
+      validate_trajectory_point_field(joint_count, points[i].positions, "positions", i, false);
+    }
+    if (!points[i].velocities.empty())
+    {
+      validate_trajectory_point_field(joint_count, points[i].velocities, "velocities", i, false);
+    }
+    if (!points[i].accelerations.empty())
+    {
+      validate_trajectory_point_field(
+        joint_count, points[i].accelerations, "accelerations", i, false);
+    }
+  }
+  else if (
+    validate_trajectory_point_field(joint_count, points[i].positions, "positions", i, false) &&
+    validate_trajectory_point_field(joint_count, points[i].velocities, "velocities", i, true) &&
+    validate_trajectory_point_field(
+      joint_count, points[i].accelerations, "accelerations", i, true))
+  {
+    validate_trajectory_point_field(joint_count, points[i].effort, "effort", i, true);
+  }
+}
+
 void JointTrajectoryController::add_new_trajectory_msg(
   const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg)
 {
-  traj_msg_external_point_ptr_.writeFromNonRT(traj_msg);
+  add_new_trajectory(compile_trajectory_msg(traj_msg));
+}
+
+std::shared_ptr<Trajectory> JointTrajectoryController::compile_trajectory_msg(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg)
+{
+  // Preprocess the msg here, so that the realtime loop only swaps the trajectory.
+  // The hold positions of missing joints are taken from the current command or state values.
+  fill_partial_goal(traj_msg);
+  sort_to_local_joint_order(traj_msg);
+  if (simplify_trajectories_)
+  {
+    simplify_trajectory_msg(*traj_msg, simplification_tolerances_);
+  }
+  time_parameterize_trajectory_msg(*traj_msg, interpolation_method_, motion_limits_);
+
+  return acquire_trajectory(traj_msg);
+}
+
+bool JointTrajectoryController::is_executable_unchanged(
+  const trajectory_msgs::msg::JointTrajectory & trajectory) const
+{
+  using interpolation_methods::InterpolationMethod;
+  // fill_partial_goal() and sort_to_local_joint_order() leave all joints in the local order as
+  // they are, simplify_trajectory_msg() removes points if enabled,
+  // time_parameterize_trajectory_msg() only changes the points for these methods, and the
+  // Trajectory only deduces missing positions in the msg
+  return trajectory.joint_names == params_.joints && !simplify_trajectories_ &&
+         interpolation_method_ != InterpolationMethod::MINIMUM_JERK &&
+         interpolation_method_ != InterpolationMethod::TRAPEZOIDAL &&
+         std::none_of(
+           trajectory.points.begin(), trajectory.points.end(),
+           [](const auto & point) { return point.positions.empty(); });
+}
+
+std::shared_ptr<Trajectory> JointTrajectoryController::acquire_trajectory(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg)
+{
+  auto trajectory = trajectory_pool_.acquire();
+  trajectory->set_single_precision(params_.single_precision_trajectories);
+  // the other segments are compiled on the preprocessing thread while the trajectory executes
+  const auto initial_segments =
+    preprocessing_worker_ ? params_.preprocessing.progressive_compilation_segments : 0;
+  trajectory->set_progressive_compilation(static_cast<size_t>(initial_segments));
+  trajectory->update(traj_msg);
+  if (!trajectory->is_fully_compiled())
+  {
+    preprocessing_worker_->post([this, trajectory]() { compile_remaining_segments(trajectory); });
+  }
+  return trajectory;
+}
+
+void JointTrajectoryController::compile_remaining_segments(
+  const std::shared_ptr<Trajectory> & trajectory)
+{
+  // only the pool and this job reference a trajectory which was replaced or dropped
+  if (trajectory.use_count() <= 2)
+  {
+    return;
+  }
+  // one chunk per job, so trajectories received meanwhile don't wait for the whole trajectory
+  const auto chunk = static_cast<size_t>(params_.preprocessing.progressive_compilation_segments);
+  if (!trajectory->compile_segments(chunk))
+  {
+    preprocessing_worker_->post([this, trajectory]() { compile_remaining_segments(trajectory); });
+  }
+}
+
+void JointTrajectoryController::add_new_trajectory(const std::shared_ptr<Trajectory> & trajectory)
+{
+  CONTROLLER_TRACEPOINT(TRAJECTORY_COMPILED, this, trajectory->end() - trajectory->begin());
+  std::lock_guard<std::mutex> guard(stream_mutex_);
+  // a msg spliced in next starts a new stream, unless the trajectory starts the stream of a file
+  if (trajectory->get_stream_id() == 0 || trajectory->get_stream_id() != stream_id_)
+  {
+    stream_msg_.reset();
+    stream_file_.reset();
+  }
+  traj_external_point_buffer_.writeFromNonRT(trajectory);
+}
+
+void JointTrajectoryController::store_trajectory_callback(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg)
+{
+  if (preprocessing_worker_)
+  {
+    preprocessing_worker_->post([this, msg]() { store_trajectory_msg(msg); });
+  }
+  else
+  {
+    store_trajectory_msg(msg);
+  }
+}
+
+void JointTrajectoryController::store_trajectory_msg(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & msg)
+{
+  const auto logger = get_node()->get_logger();
+  const std::string name = msg->header.frame_id;
+  if (name.empty())
+  {
+    RCLCPP_ERROR(logger, "Can't store a trajectory without a name in its header.frame_id.");
+    return;
+  }
+  if (msg->points.empty())
+  {
+    std::lock_guard<std::mutex> guard(stored_trajectories_mutex_);
+    if (stored_trajectories_.erase(name) > 0)
+    {
+      RCLCPP_INFO(logger, "Removed stored trajectory '%s'.", name.c_str());
+    }
+    return;
+  }
+  // missing joints would hold the position they have now, not when the trajectory is started
+  if (msg->joint_names.size() != dof_)
+  {
+    RCLCPP_ERROR(
+      logger, "Can't store trajectory '%s', it has to contain all joints of the controller.",
+      name.c_str());
+    return;
+  }
+  // the start time is given by the references
+  msg->header.stamp = rclcpp::Time(0);
+  if (!validate_trajectory_msg(*msg))
+  {
+    return;
+  }
+  sort_to_local_joint_order(msg);
+  if (simplify_trajectories_)
+  {
+    simplify_trajectory_msg(*msg, simplification_tolerances_);
+  }
+  time_parameterize_trajectory_msg(*msg, interpolation_method_, motion_limits_);
+
+  auto trajectory = std::make_shared<Trajectory>();
+  trajectory->set_single_precision(params_.single_precision_trajectories);
+  trajectory->update(msg);
+  // the instances share the msg, so it must not be changed while sampling
+  if (!trajectory->is_compiled())
+  {
+    RCLCPP_ERROR(
+      logger, "Can't store trajectory '%s', it has to give positions in all points.",
+      name.c_str());
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(stored_trajectories_mutex_);
+  const auto max_count = static_cast<size_t>(params_.stored_trajectories.max_count);
+  if (
+    stored_trajectories_.size() >= max_count &&
+    stored_trajectories_.find(name) == stored_trajectories_.end())
+  {
+    RCLCPP_ERROR(
+      logger, "Can't store trajectory '%s', %zu trajectories are stored already.", name.c_str(),
+      max_count);
+    return;
+  }
+  stored_trajectories_[name] = trajectory;
+  RCLCPP_INFO(logger, "Stored trajectory '%s' with %zu points.", name.c_str(), msg->points.size());
+}
+
+bool JointTrajectoryController::is_stored_trajectory_reference(
+  const trajectory_msgs::msg::JointTrajectory & trajectory)
+{
+  return trajectory.points.empty() && !trajectory.header.frame_id.empty();
+}
+
+std::shared_ptr<const Trajectory> JointTrajectoryController::find_stored_trajectory(
+  const trajectory_msgs::msg::JointTrajectory & reference) const
+{
+  const auto logger = get_node()->get_logger();
+  std::shared_ptr<const Trajectory> stored_trajectory;
+  {
+    std::lock_guard<std::mutex> guard(stored_trajectories_mutex_);
+    const auto it = stored_trajectories_.find(reference.header.frame_id);
+    if (it != stored_trajectories_.end())
+    {
+      stored_trajectory = it->second;
+    }
+  }
+  if (!stored_trajectory)
+  {
+    RCLCPP_ERROR(logger, "No trajectory is stored as '%s'.", reference.header.frame_id.c_str());
+    return nullptr;
+  }
+
+  const auto start_time = static_cast<rclcpp::Time>(reference.header.stamp);
+  if (start_time.seconds() != 0.0)
+  {
+    const auto end_time =
+      start_time + stored_trajectory->get_trajectory_msg()->points.back().time_from_start;
+    if (end_time < get_node()->now())
+    {
+      RCLCPP_ERROR(
+        logger, "Stored trajectory '%s' started at %f ends in the past (%f)",
+        reference.header.frame_id.c_str(), start_time.seconds(), end_time.seconds());
+      return nullptr;
+    }
+  }
+  return stored_trajectory;
+}
+
+void JointTrajectoryController::add_stored_trajectory(
+  const Trajectory & stored_trajectory, const trajectory_msgs::msg::JointTrajectory & reference)
+{
+  add_new_trajectory(instantiate_stored_trajectory(stored_trajectory, reference));
+}
+
+std::shared_ptr<Trajectory> JointTrajectoryController::instantiate_stored_trajectory(
+  const Trajectory & stored_trajectory, const trajectory_msgs::msg::JointTrajectory & reference)
+{
+  // copies the compiled points and coefficients, the msg is shared
+  auto trajectory = trajectory_pool_.acquire();
+  *trajectory = stored_trajectory;
+  trajectory->set_trajectory_start_time(static_cast<rclcpp::Time>(reference.header.stamp));
+  return trajectory;
+}
+
+bool JointTrajectoryController::is_trajectory_file_reference(
+  const trajectory_msgs::msg::JointTrajectory & trajectory)
+{
+  return trajectory.points.empty() &&
+         trajectory.header.frame_id.rfind(TRAJECTORY_FILE_PREFIX, 0) == 0;
+}
+
+std::shared_ptr<const TrajectoryFile> JointTrajectoryController::open_trajectory_file(
+  const trajectory_msgs::msg::JointTrajectory & reference) const
+{
+  const auto logger = get_node()->get_logger();
+  const std::string & directory = params_.trajectory_files.directory;
+  const std::string name = reference.header.frame_id.substr(std::strlen(TRAJECTORY_FILE_PREFIX));
+  if (directory.empty())
+  {
+    RCLCPP_ERROR(logger, "Can't execute trajectory files, trajectory_files.directory is not set.");
+    return nullptr;
+  }
+  // only the files in the directory are executed
+  if (name.empty() || name.front() == '/' || name.find("..") != std::string::npos)
+  {
+    RCLCPP_ERROR(logger, "Invalid name '%s' of a trajectory file.", name.c_str());
+    return nullptr;
+  }
+
+  std::string error;
+  const auto file = TrajectoryFile::open(directory + "/" + name, error);
+  if (!file)
+  {
+    RCLCPP_ERROR(logger, "Can't execute trajectory file: %s", error.c_str());
+    return nullptr;
+  }
+  // missing joints would hold the position they have now, not when the file gets to them
+  std::vector<bool> contained(dof_, false);
+  for (const auto & joint_name : file->joint_names())
+  {
+    const auto it = joint_indices_.find(joint_name);
+    if (it == joint_indices_.end() || contained[it->second])
+    {
+      break;
+    }
+    contained[it->second] = true;
+  }
+  if (
+    file->joint_names().size() != dof_ ||
+    std::find(contained.begin(), contained.end(), false) != contained.end())
+  {
+    RCLCPP_ERROR(
+      logger, "Can't execute trajectory file '%s', it has to contain all joints of the controller.",
+      name.c_str());
+    return nullptr;
+  }
+
+  const auto start_time = static_cast<rclcpp::Time>(reference.header.stamp);
+  if (start_time.seconds() != 0.0)
+  {
+    const auto end_time =
+      start_time + rclcpp::Duration::from_nanoseconds(file->time_from_start_ns(file->size() - 1));
+    if (end_time < get_node()->now())
+    {
+      RCLCPP_ERROR(
+        logger, "Trajectory file '%s' started at %f ends in the past (%f)", name.c_str(),
+        start_time.seconds(), end_time.seconds());
+      return nullptr;
+    }
+  }
+  return file;
+}
+
+std::shared_ptr<Trajectory> JointTrajectoryController::compile_trajectory_file(
+  const std::shared_ptr<const TrajectoryFile> & file,
+  const trajectory_msgs::msg::JointTrajectory & reference, std::string & error)
+{
+  auto traj_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  traj_msg->header.stamp = reference.header.stamp;
+  traj_msg->joint_names = params_.joints;
+
+  std::lock_guard<std::mutex> guard(stream_mutex_);
+  ++stream_id_;
+  stream_msg_ = traj_msg;
+  stream_file_ = file;
+  stream_file_next_point_ = 0;
+  auto trajectory = compile_trajectory_file_windows(rclcpp::Duration(0, 0), error);
+  if (!trajectory)
+  {
+    stream_msg_.reset();
+    stream_file_.reset();
+  }
+  return trajectory;
+}
+
+std::shared_ptr<Trajectory> JointTrajectoryController::compile_trajectory_file_windows(
+  const rclcpp::Duration & keep_from, std::string & error)
+{
+  const auto window_size = static_cast<size_t>(params_.trajectory_files.window_size);
+  const auto loaded_until =
+    keep_from + rclcpp::Duration::from_seconds(params_.trajectory_files.lookahead);
+  auto spliced_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*stream_msg_);
+  auto window = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  do
+  {
+    window->joint_names = stream_file_->joint_names();
+    window->points.clear();
+    const size_t end = std::min(stream_file_next_point_ + window_size, stream_file_->size());
+    if (!stream_file_->read_points(stream_file_next_point_, end, *window, error))
+    {
+      return nullptr;
+    }
+    stream_file_next_point_ = end;
+    sort_to_local_joint_order(window);
+    // the executed points are dropped, so the msg holds about lookahead and one window
+    splice_trajectory_msg(*spliced_msg, *window, rclcpp::Duration(0, 0), keep_from);
+  } while (stream_file_next_point_ < stream_file_->size() &&
+           rclcpp::Duration(spliced_msg->points.back().time_from_start) < loaded_until);
+
+  const bool is_final = stream_file_next_point_ == stream_file_->size();
+  if (is_final)
+  {
+    stream_file_.reset();
+  }
+  // the points have all positions, so the realtime loop doesn't change the msg and it is shared
+  stream_msg_ = spliced_msg;
+
+  auto trajectory = acquire_trajectory(spliced_msg);
+  trajectory->set_stream_id(stream_id_);
+  trajectory->set_final(is_final);
+  return trajectory;
+}
+
+bool JointTrajectoryController::advance_trajectory_file()
+{
+  std::string error;
+  {
+    std::lock_guard<std::mutex> guard(stream_mutex_);
+    if (!stream_file_)
+    {
+      return false;
+    }
+    // the realtime loop did not start the stream yet
+    if (active_stream_id_.load(std::memory_order_relaxed) != stream_id_)
+    {
+      return true;
+    }
+    const auto elapsed =
+      rclcpp::Duration::from_nanoseconds(active_stream_elapsed_ns_.load(std::memory_order_relaxed));
+    const auto loaded = rclcpp::Duration(stream_msg_->points.back().time_from_start) - elapsed;
+    if (loaded >= rclcpp::Duration::from_seconds(params_.trajectory_files.lookahead))
+    {
+      return true;
+    }
+    const auto trajectory = compile_trajectory_file_windows(elapsed, error);
+    if (trajectory)
+    {
+      CONTROLLER_TRACEPOINT(TRAJECTORY_COMPILED, this, trajectory->end() - trajectory->begin());
+      traj_external_point_buffer_.writeFromNonRT(trajectory);
+      return stream_file_ != nullptr;
+    }
+    stream_file_.reset();
+    stream_msg_.reset();
+  }
+
+  RCLCPP_ERROR(get_node()->get_logger(), "Invalid trajectory file: %s", error.c_str());
+  set_hold_position();
+  const auto active_goal = rt_active_goal_.get();
+  if (active_goal)
+  {
+    auto action_res = std::make_shared<FollowJTrajAction::Result>();
+    action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
+    action_res->set__error_string(error);
+    active_goal->setAborted(action_res);
+    rt_active_goal_.reset();
+  }
+  return false;
+}
+
+void JointTrajectoryController::splice_new_trajectory_msg(
+  const std::shared_ptr<trajectory_msgs::msg::JointTrajectory> & traj_msg)
+{
+  fill_partial_goal(traj_msg);
+  sort_to_local_joint_order(traj_msg);
+  if (simplify_trajectories_)
+  {
+    simplify_trajectory_msg(*traj_msg, simplification_tolerances_);
+  }
+  time_parameterize_trajectory_msg(*traj_msg, interpolation_method_, motion_limits_);
+
+  std::lock_guard<std::mutex> guard(stream_mutex_);
+  // the msg replaces a trajectory file being read
+  if (stream_file_)
+  {
+    stream_file_.reset();
+    stream_msg_.reset();
+  }
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> spliced_msg;
+  if (stream_msg_)
+  {
+    // the realtime loop did not start the stream yet, if another one is executed
+    const auto elapsed = rclcpp::Duration::from_nanoseconds(
+      active_stream_id_.load(std::memory_order_relaxed) == stream_id_
+        ? active_stream_elapsed_ns_.load(std::memory_order_relaxed)
+        : 0);
+    const rclcpp::Time stream_start(stream_msg_->header.stamp);
+    const rclcpp::Time msg_start(traj_msg->header.stamp);
+    if (msg_start.nanoseconds() == 0)
+    {
+      // start now
+      spliced_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*stream_msg_);
+      splice_trajectory_msg(*spliced_msg, *traj_msg, elapsed, elapsed);
+    }
+    else if (stream_start.nanoseconds() != 0)
+    {
+      spliced_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*stream_msg_);
+      splice_trajectory_msg(*spliced_msg, *traj_msg, msg_start - stream_start, elapsed);
+    }
+    // else the start of the msg can't be related to the stream started at its reception
+  }
+  if (!spliced_msg)
+  {
+    ++stream_id_;
+    spliced_msg = traj_msg;
+  }
+  // the realtime loop may deduce missing positions of the handed over msg in place, keep a copy
+  stream_msg_ = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*spliced_msg);
+
+  auto trajectory = acquire_trajectory(spliced_msg);
+  trajectory->set_stream_id(stream_id_);
+  traj_external_point_buffer_.writeFromNonRT(trajectory);
 }
 
 void JointTrajectoryController::preempt_active_goal()
 {
-  const auto active_goal = *rt_active_goal_.readFromNonRT();
+  abort_queued_goal();
+  const auto active_goal = rt_active_goal_.get();
   if (active_goal)
   {
     set_hold_position();
@@ -1384,7 +3316,7 @@ void JointTrajectoryController::preempt_active_goal()
     action_res->set__error_code(FollowJTrajAction::Result::INVALID_GOAL);
     action_res->set__error_string("Current goal cancelled due to new incoming action.");
     active_goal->setCanceled(action_res);
-    rt_active_goal_.writeFromNonRT(RealtimeGoalHandlePtr());
+    rt_active_goal_.reset();
   }
 }
 
@@ -1418,6 +3350,36 @@ void JointTrajectoryController::resize_joint_trajectory_point(
   }
 }
 
+void JointTrajectoryController::reserve_joint_trajectory_point(
+  trajectory_msgs::msg::JointTrajectoryPoint & point, size_t size)
+{
+  point.positions.reserve(size);
+  point.velocities.reserve(size);
+  point.accelerations.reserve(size);
+  point.effort.reserve(size);
+}
+
+void JointTrajectoryController::preallocate_feedback(
+  FollowJTrajAction::Feedback & feedback, const JointGroup * group)
+{
+  feedback.joint_names.clear();
+  if (group)
+  {
+    for (const size_t index : group->joints)
+    {
+      feedback.joint_names.push_back(params_.joints[index]);
+    }
+  }
+  else
+  {
+    feedback.joint_names = params_.joints;
+  }
+  const size_t size = feedback.joint_names.size();
+  reserve_joint_trajectory_point(feedback.actual, size);
+  reserve_joint_trajectory_point(feedback.desired, size);
+  reserve_joint_trajectory_point(feedback.error, size);
+}
+
 void JointTrajectoryController::resize_joint_trajectory_point_command(
   trajectory_msgs::msg::JointTrajectoryPoint & point, size_t size)
 {
@@ -1444,4 +3406,5 @@ void JointTrajectoryController::resize_joint_trajectory_point_command(
 #include "pluginlib/class_list_macros.hpp"
 
 PLUGINLIB_EXPORT_CLASS(
-  joint_trajectory_controller::JointTrajectoryController, controller_interface::ControllerInterface)
+  joint_trajectory_controller::JointTrajectoryController,
+  controller_interface::ChainableControllerInterface)
@@ -0,0 +1,341 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/offline_simulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "control_msgs/action/follow_joint_trajectory.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "joint_trajectory_controller/joint_trajectory_controller.hpp"
+#include "joint_trajectory_controller/tolerances.hpp"
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+using FollowJTrajResult = control_msgs::action::FollowJointTrajectory::Result;
+
+/// Interface types the simulated joints have, in the order of the types of the controller
+const std::vector<std::string> INTERFACE_TYPES = {
+  hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY,
+  hardware_interface::HW_IF_ACCELERATION, hardware_interface::HW_IF_EFFORT};
+}  // namespace
+
+/// The controller, with access to what the simulator checks after every cycle
+class OfflineSimulator::Controller : public JointTrajectoryController
+{
+public:
+  using JointTrajectoryController::add_new_trajectory;
+  using JointTrajectoryController::compile_trajectory_msg;
+  using JointTrajectoryController::validate_trajectory_msg;
+
+  void declare_parameters() { param_listener_->declare_params(); }
+
+  const Params & params() const { return params_; }
+  const controller_realtime_tools::JointVectors & state_error() const { return state_error_; }
+  const JointsStateTolerances & state_tolerances() const { return state_tolerances_; }
+  const JointsStateTolerances & goal_state_tolerances() const { return goal_state_tolerances_; }
+  double goal_time_tolerance() const { return default_tolerances_.goal_time_tolerance; }
+
+  /// Interfaces of the simulated joints, the loaned ones of the controller refer to them
+  std::vector<hardware_interface::CommandInterface> command_interfaces;
+  std::vector<hardware_interface::StateInterface> state_interfaces;
+};
+
+std::unique_ptr<OfflineSimulator> OfflineSimulator::create(
+  const std::string & name, const Options & options, std::string & error)
+{
+  const size_t dof = options.joints.size();
+  if (dof == 0)
+  {
+    error = "no joints are given";
+    return nullptr;
+  }
+  if (!options.initial_positions.empty() && options.initial_positions.size() != dof)
+  {
+    error = "initial_positions has to be empty or have a position per joint";
+    return nullptr;
+  }
+  if (!(options.update_rate > 0.0) || options.time_constant < 0.0 || options.settling_time < 0.0)
+  {
+    error = "update_rate has to be positive, time_constant and settling_time not negative";
+    return nullptr;
+  }
+  // the joints follow the first of these commands the controller writes
+  const auto command_type = std::find_if(
+    INTERFACE_TYPES.begin(), INTERFACE_TYPES.end() - 1,
+    [&options](const std::string & type)
+    {
+      return std::find(
+               options.command_interfaces.begin(), options.command_interfaces.end(), type) !=
+             options.command_interfaces.end();
+    });
+  if (command_type == INTERFACE_TYPES.end() - 1)
+  {
+    error = "only position, velocity and acceleration commands are simulated";
+    return nullptr;
+  }
+
+  std::unique_ptr<OfflineSimulator> simulator(new OfflineSimulator());
+  simulator->options_ = options;
+  simulator->dof_ = dof;
+  simulator->period_ = rclcpp::Duration::from_seconds(1.0 / options.update_rate);
+  simulator->command_type_ = static_cast<size_t>(command_type - INTERFACE_TYPES.begin());
+  simulator->lag_factor_ =
+    options.time_constant > 0.0
+      ? 1.0 - std::exp(-simulator->period_.seconds() / options.time_constant)
+      : 1.0;
+  simulator->state_positions_ = options.initial_positions;
+  simulator->state_positions_.resize(dof, 0.0);
+  simulator->state_velocities_.assign(dof, 0.0);
+  simulator->state_accelerations_.assign(dof, 0.0);
+  simulator->command_values_.assign(INTERFACE_TYPES.size() * dof, 0.0);
+  std::copy(
+    simulator->state_positions_.begin(), simulator->state_positions_.end(),
+    simulator->command_values_.begin());
+
+  auto controller = std::make_shared<Controller>();
+  if (controller->init(name) != controller_interface::return_type::OK)
+  {
+    error = "can't initialize the controller";
+    return nullptr;
+  }
+  simulator->controller_ = controller;
+  auto node = controller->get_node();
+  const auto set_parameters = [&node, &error](const std::vector<rclcpp::Parameter> & parameters)
+  {
+    const auto results = node->set_parameters(parameters);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+      if (!results[i].successful)
+      {
+        error = "can't set parameter '" + parameters[i].get_name() + "': " + results[i].reason;
+        return false;
+      }
+    }
+    return true;
+  };
+  if (!set_parameters(
+        {rclcpp::Parameter("joints", options.joints),
+         rclcpp::Parameter("command_interfaces", options.command_interfaces),
+         rclcpp::Parameter("state_interfaces", options.state_interfaces)}))
+  {
+    return nullptr;
+  }
+  // the parameters of the joints are declared once the joints are known
+  controller->declare_parameters();
+  if (
+    !set_parameters({rclcpp::Parameter("state_publish_rate", 10.0)}) ||
+    !set_parameters(options.parameters))
+  {
+    return nullptr;
+  }
+  if (node->configure().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+  {
+    error = "can't configure the controller, see its log";
+    return nullptr;
+  }
+  if (!controller->params().joint_groups.empty())
+  {
+    error = "joint groups are not simulated";
+    return nullptr;
+  }
+
+  // every joint has all interfaces, the controller claims those it is configured with
+  controller->command_interfaces.reserve(INTERFACE_TYPES.size() * dof);
+  controller->state_interfaces.reserve((INTERFACE_TYPES.size() - 1) * dof);
+  std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+  std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+  double * const state_values[] = {
+    simulator->state_positions_.data(), simulator->state_velocities_.data(),
+    simulator->state_accelerations_.data()};
+  for (size_t i = 0; i < dof; ++i)
+  {
+    for (size_t type = 0; type < INTERFACE_TYPES.size(); ++type)
+    {
+      controller->command_interfaces.emplace_back(
+        options.joints[i], INTERFACE_TYPES[type], &simulator->command_values_[type * dof + i]);
+      loaned_command_interfaces.emplace_back(controller->command_interfaces.back());
+      if (INTERFACE_TYPES[type] != hardware_interface::HW_IF_EFFORT)
+      {
+        controller->state_interfaces.emplace_back(
+          options.joints[i], INTERFACE_TYPES[type], state_values[type] + i);
+        loaned_state_interfaces.emplace_back(controller->state_interfaces.back());
+      }
+    }
+  }
+  controller->assign_interfaces(
+    std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+  if (node->activate().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+  {
+    error = "can't activate the controller, see its log";
+    return nullptr;
+  }
+  return simulator;
+}
+
+OfflineSimulator::~OfflineSimulator()
+{
+  // the controller refers to the values of the interfaces, which are destroyed before it
+  if (
+    controller_ &&
+    controller_->get_state().id() == lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+  {
+    controller_->get_node()->deactivate();
+  }
+  controller_.reset();
+}
+
+SimulationResult OfflineSimulator::execute(const trajectory_msgs::msg::JointTrajectory & trajectory)
+{
+  SimulationResult result;
+  result.max_position_errors.assign(dof_, 0.0);
+
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(trajectory);
+  // the synthetic time has nothing to do with the stamp, the trajectory starts when it is sampled
+  msg->header.stamp = rclcpp::Time(0);
+  if (msg->points.empty())
+  {
+    result.error_code = FollowJTrajResult::INVALID_GOAL;
+    result.error_string = "the trajectory has no points";
+    return result;
+  }
+  if (!controller_->validate_trajectory_msg(*msg))
+  {
+    result.error_code = FollowJTrajResult::INVALID_GOAL;
+    result.error_string = "the trajectory is invalid, see the log of the controller";
+    return result;
+  }
+  const auto executed = controller_->compile_trajectory_msg(msg);
+  controller_->add_new_trajectory(executed);
+
+  const auto finish = [this, &result](
+                        int32_t error_code, std::string error_string,
+                        const ToleranceViolations & violations)
+  {
+    result.error_code = error_code;
+    result.error_string = std::move(error_string);
+    if (violations.any())
+    {
+      result.violating_joint = options_.joints[violations.first_joint];
+      controller_->state_error().to_msg(result.violation_error);
+    }
+  };
+
+  const rclcpp::Time start_time = time_;
+  while (true)
+  {
+    const rclcpp::Time time = time_;
+    controller_->update(time, period_);
+    step_joints();
+    time_ += period_;
+    ++result.cycles;
+    result.duration = (time - start_time).seconds();
+
+    if (!executed->is_sampled_already())
+    {
+      finish(
+        FollowJTrajResult::INVALID_GOAL, "the controller didn't execute the trajectory",
+        ToleranceViolations());
+      break;
+    }
+    const auto & error = controller_->state_error();
+    for (size_t i = 0; i < dof_; ++i)
+    {
+      result.max_position_errors[i] =
+        std::max(result.max_position_errors[i], std::abs(error.positions[i]));
+    }
+
+    // the checks of the controller, where an action goal would be finished
+    const rclcpp::Time end_time =
+      executed->get_trajectory_start_time() +
+      rclcpp::Duration(executed->get_trajectory_msg()->points.back().time_from_start);
+    const bool before_last_point = time < end_time;
+    if (before_last_point || result.cycles == 1)
+    {
+      const auto violations = check_state_tolerance(error, controller_->state_tolerances());
+      if (violations.any())
+      {
+        finish(
+          FollowJTrajResult::PATH_TOLERANCE_VIOLATED, "state tolerance violated", violations);
+        break;
+      }
+    }
+    if (!before_last_point)
+    {
+      const auto violations = check_state_tolerance(error, controller_->goal_state_tolerances());
+      if (!violations.any())
+      {
+        finish(FollowJTrajResult::SUCCESSFUL, "", violations);
+        break;
+      }
+      // the controller waits for the goal tolerances forever without goal_time_tolerance
+      const double time_past_end = (time - end_time).seconds();
+      const double goal_time_tolerance = controller_->goal_time_tolerance();
+      if (goal_time_tolerance != 0.0 && time_past_end > goal_time_tolerance)
+      {
+        finish(
+          FollowJTrajResult::GOAL_TOLERANCE_VIOLATED, "goal_time_tolerance exceeded", violations);
+        break;
+      }
+      if (goal_time_tolerance == 0.0 && time_past_end > options_.settling_time)
+      {
+        finish(
+          FollowJTrajResult::GOAL_TOLERANCE_VIOLATED,
+          "goal tolerances not reached within settling_time", violations);
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+void OfflineSimulator::step_joints()
+{
+  const double dt = period_.seconds();
+  const double * commands = &command_values_[command_type_ * dof_];
+  for (size_t i = 0; i < dof_; ++i)
+  {
+    const double position = state_positions_[i];
+    const double velocity = state_velocities_[i];
+    double next_position = 0.0;
+    double next_velocity = 0.0;
+    if (command_type_ == 0)
+    {
+      next_position = position + lag_factor_ * (commands[i] - position);
+      next_velocity = (next_position - position) / dt;
+    }
+    else
+    {
+      next_velocity = command_type_ == 1 ? velocity + lag_factor_ * (commands[i] - velocity)
+                                         : velocity + commands[i] * dt;
+      next_position = position + next_velocity * dt;
+    }
+    state_positions_[i] = next_position;
+    state_velocities_[i] = next_velocity;
+    state_accelerations_[i] = (next_velocity - velocity) / dt;
+  }
+}
+
+}  // namespace joint_trajectory_controller
@@ -0,0 +1,213 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/spline_sampling.hpp"
+
+// the AVX2 kernel is compiled for its own target and only called if the CPU supports it, NEON is
+// part of every aarch64 CPU
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_AVX2
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_NEON
+#include <arm_neon.h>
+#endif
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+/// Evaluate the joints [\p begin, \p end) of evaluate_splines() one after another, using
+/// Horner's scheme.
+inline void evaluate_joints(
+  const double * coefficients, size_t dof, size_t begin, size_t end, double t, double * positions,
+  double * velocities, double * accelerations)
+{
+  const double * c0 = coefficients;
+  const double * c1 = c0 + dof;
+  const double * c2 = c1 + dof;
+  const double * c3 = c2 + dof;
+  const double * c4 = c3 + dof;
+  const double * c5 = c4 + dof;
+  for (size_t i = begin; i < end; ++i)
+  {
+    positions[i] = ((((c5[i] * t + c4[i]) * t + c3[i]) * t + c2[i]) * t + c1[i]) * t + c0[i];
+    velocities[i] =
+      (((5.0 * c5[i] * t + 4.0 * c4[i]) * t + 3.0 * c3[i]) * t + 2.0 * c2[i]) * t + c1[i];
+    accelerations[i] = ((20.0 * c5[i] * t + 12.0 * c4[i]) * t + 6.0 * c3[i]) * t + 2.0 * c2[i];
+  }
+}
+
+#if defined(JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_AVX2)
+/// Four joints at once, the operations are those of evaluate_joints() without fused multiply-adds
+__attribute__((target("avx2"))) void evaluate_splines_avx2(
+  const double * coefficients, size_t dof, double t, double * positions, double * velocities,
+  double * accelerations)
+{
+  const __m256d time = _mm256_set1_pd(t);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d three = _mm256_set1_pd(3.0);
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d five = _mm256_set1_pd(5.0);
+  const __m256d six = _mm256_set1_pd(6.0);
+  const __m256d twelve = _mm256_set1_pd(12.0);
+  const __m256d twenty = _mm256_set1_pd(20.0);
+
+  size_t i = 0;
+  for (; i + 4 <= dof; i += 4)
+  {
+    const __m256d c0 = _mm256_loadu_pd(coefficients + i);
+    const __m256d c1 = _mm256_loadu_pd(coefficients + dof + i);
+    const __m256d c2 = _mm256_loadu_pd(coefficients + 2 * dof + i);
+    const __m256d c3 = _mm256_loadu_pd(coefficients + 3 * dof + i);
+    const __m256d c4 = _mm256_loadu_pd(coefficients + 4 * dof + i);
+    const __m256d c5 = _mm256_loadu_pd(coefficients + 5 * dof + i);
+
+    __m256d position = _mm256_add_pd(_mm256_mul_pd(c5, time), c4);
+    position = _mm256_add_pd(_mm256_mul_pd(position, time), c3);
+    position = _mm256_add_pd(_mm256_mul_pd(position, time), c2);
+    position = _mm256_add_pd(_mm256_mul_pd(position, time), c1);
+    position = _mm256_add_pd(_mm256_mul_pd(position, time), c0);
+
+    __m256d velocity =
+      _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(five, c5), time), _mm256_mul_pd(four, c4));
+    velocity = _mm256_add_pd(_mm256_mul_pd(velocity, time), _mm256_mul_pd(three, c3));
+    velocity = _mm256_add_pd(_mm256_mul_pd(velocity, time), _mm256_mul_pd(two, c2));
+    velocity = _mm256_add_pd(_mm256_mul_pd(velocity, time), c1);
+
+    __m256d acceleration =
+      _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(twenty, c5), time), _mm256_mul_pd(twelve, c4));
+    acceleration = _mm256_add_pd(_mm256_mul_pd(acceleration, time), _mm256_mul_pd(six, c3));
+    acceleration = _mm256_add_pd(_mm256_mul_pd(acceleration, time), _mm256_mul_pd(two, c2));
+
+    _mm256_storeu_pd(positions + i, position);
+    _mm256_storeu_pd(velocities + i, velocity);
+    _mm256_storeu_pd(accelerations + i, acceleration);
+  }
+  evaluate_joints(coefficients, dof, i, dof, t, positions, velocities, accelerations);
+}
+#endif
+
+#if defined(JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_NEON)
+/// Two joints at once, the operations are those of evaluate_joints()
+void evaluate_splines_neon(
+  const double * coefficients, size_t dof, double t, double * positions, double * velocities,
+  double * accelerations)
+{
+  const float64x2_t time = vdupq_n_f64(t);
+  const float64x2_t two = vdupq_n_f64(2.0);
+  const float64x2_t three = vdupq_n_f64(3.0);
+  const float64x2_t four = vdupq_n_f64(4.0);
+  const float64x2_t five = vdupq_n_f64(5.0);
+  const float64x2_t six = vdupq_n_f64(6.0);
+  const float64x2_t twelve = vdupq_n_f64(12.0);
+  const float64x2_t twenty = vdupq_n_f64(20.0);
+
+  size_t i = 0;
+  for (; i + 2 <= dof; i += 2)
+  {
+    const float64x2_t c0 = vld1q_f64(coefficients + i);
+    const float64x2_t c1 = vld1q_f64(coefficients + dof + i);
+    const float64x2_t c2 = vld1q_f64(coefficients + 2 * dof + i);
+    const float64x2_t c3 = vld1q_f64(coefficients + 3 * dof + i);
+    const float64x2_t c4 = vld1q_f64(coefficients + 4 * dof + i);
+    const float64x2_t c5 = vld1q_f64(coefficients + 5 * dof + i);
+
+    float64x2_t position = vaddq_f64(vmulq_f64(c5, time), c4);
+    position = vaddq_f64(vmulq_f64(position, time), c3);
+    position = vaddq_f64(vmulq_f64(position, time), c2);
+    position = vaddq_f64(vmulq_f64(position, time), c1);
+    position = vaddq_f64(vmulq_f64(position, time), c0);
+
+    float64x2_t velocity = vaddq_f64(vmulq_f64(vmulq_f64(five, c5), time), vmulq_f64(four, c4));
+    velocity = vaddq_f64(vmulq_f64(velocity, time), vmulq_f64(three, c3));
+    velocity = vaddq_f64(vmulq_f64(velocity, time), vmulq_f64(two, c2));
+    velocity = vaddq_f64(vmulq_f64(velocity, time), c1);
+
+    float64x2_t acceleration =
+      vaddq_f64(vmulq_f64(vmulq_f64(twenty, c5), time), vmulq_f64(twelve, c4));
+    acceleration = vaddq_f64(vmulq_f64(acceleration, time), vmulq_f64(six, c3));
+    acceleration = vaddq_f64(vmulq_f64(acceleration, time), vmulq_f64(two, c2));
+
+    vst1q_f64(positions + i, position);
+    vst1q_f64(velocities + i, velocity);
+    vst1q_f64(accelerations + i, acceleration);
+  }
+  evaluate_joints(coefficients, dof, i, dof, t, positions, velocities, accelerations);
+}
+#endif
+
+using SplineKernel = void (*)(const double *, size_t, double, double *, double *, double *);
+
+struct SelectedKernel
+{
+  SplineKernel evaluate;
+  const char * name;
+};
+
+SelectedKernel select_kernel()
+{
+#if defined(JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_AVX2)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return {evaluate_splines_avx2, "avx2"};
+  }
+#elif defined(JOINT_TRAJECTORY_CONTROLLER__SPLINE_SAMPLING_NEON)
+  return {evaluate_splines_neon, "neon"};
+#endif
+  return {evaluate_splines_portable, "portable"};
+}
+
+// selected when the library is loaded, so the realtime loop never does it
+const SelectedKernel SELECTED_KERNEL = select_kernel();
+}  // namespace
+
+void evaluate_splines(
+  const double * coefficients, size_t dof, double t, double * positions, double * velocities,
+  double * accelerations)
+{
+  SELECTED_KERNEL.evaluate(coefficients, dof, t, positions, velocities, accelerations);
+}
+
+void evaluate_splines_portable(
+  const double * coefficients, size_t dof, double t, double * positions, double * velocities,
+  double * accelerations)
+{
+  evaluate_joints(coefficients, dof, 0, dof, t, positions, velocities, accelerations);
+}
+
+void evaluate_compact_splines(
+  const float * coefficients, size_t dof, float t, double * positions, double * velocities,
+  double * accelerations)
+{
+  const float * c0 = coefficients;
+  const float * c1 = c0 + dof;
+  const float * c2 = c1 + dof;
+  const float * c3 = c2 + dof;
+  const float * c4 = c3 + dof;
+  const float * c5 = c4 + dof;
+  for (size_t i = 0; i < dof; ++i)
+  {
+    positions[i] = ((((c5[i] * t + c4[i]) * t + c3[i]) * t + c2[i]) * t + c1[i]) * t + c0[i];
+    velocities[i] =
+      (((5.0f * c5[i] * t + 4.0f * c4[i]) * t + 3.0f * c3[i]) * t + 2.0f * c2[i]) * t + c1[i];
+    accelerations[i] =
+      ((20.0f * c5[i] * t + 12.0f * c4[i]) * t + 6.0f * c3[i]) * t + 2.0f * c2[i];
+  }
+}
+
+const char * get_spline_kernel_name() { return SELECTED_KERNEL.name; }
+
+}  // namespace joint_trajectory_controller
@@ -14,16 +14,187 @@
 
 #include "joint_trajectory_controller/trajectory.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <utility>
+#include <vector>
 
+#include "controller_realtime_tools/memory_footprint.hpp"
 #include "hardware_interface/macros.hpp"
+#include "joint_trajectory_controller/spline_sampling.hpp"
 #include "rclcpp/duration.hpp"
 #include "rclcpp/time.hpp"
 #include "std_msgs/msg/header.hpp"
 
 namespace joint_trajectory_controller
 {
-Trajectory::Trajectory() : trajectory_start_time_(0), time_before_traj_msg_(0) {}
+namespace
+{
+void generate_powers(int n, double x, double * powers)
+{
+  powers[0] = 1.0;
+  for (int i = 1; i <= n; ++i)
+  {
+    powers[i] = powers[i - 1] * x;
+  }
+}
+
+/// State of all joints at a segment boundary, fields not given are nullptr
+struct SegmentState
+{
+  const double * positions = nullptr;
+  const double * velocities = nullptr;
+  const double * accelerations = nullptr;
+};
+
+SegmentState to_segment_state(const trajectory_msgs::msg::JointTrajectoryPoint & point)
+{
+  SegmentState state;
+  state.positions = point.positions.empty() ? nullptr : point.positions.data();
+  state.velocities = point.velocities.empty() ? nullptr : point.velocities.data();
+  state.accelerations = point.accelerations.empty() ? nullptr : point.accelerations.data();
+  return state;
+}
+
+SegmentState to_segment_state(const CompiledTrajectory & compiled, const size_t index)
+{
+  const size_t offset = index * compiled.dof;
+  SegmentState state;
+  state.positions = compiled.positions.data() + offset;
+  if (compiled.has_velocities())
+  {
+    state.velocities = compiled.velocities.data() + offset;
+  }
+  if (compiled.has_accelerations())
+  {
+    state.accelerations = compiled.accelerations.data() + offset;
+  }
+  return state;
+}
+
+/**
+ * Compute the spline coefficients of joint \p i between \p state_a and \p state_b.
+ * Lower degree splines leave the higher order coefficients at zero, so every spline can be
+ * evaluated as a quintic polynomial.
+ *
+ * \param[in] T Powers of the segment duration, up to the fifth.
+ * \param[out] coefficients Storage for SPLINE_COEFFICIENTS values.
+ */
+void compute_spline_coefficients(
+  const SegmentState & state_a, const SegmentState & state_b, const size_t i,
+  const bool has_velocity, const bool has_accel, const double * T, double * coefficients)
+{
+  std::fill(coefficients, coefficients + SPLINE_COEFFICIENTS, 0.0);
+
+  const double start_pos = state_a.positions[i];
+  const double end_pos = state_b.positions[i];
+  coefficients[0] = start_pos;
+
+  if (!has_velocity)
+  {
+    // linear interpolation
+    if (T[1] != 0.0)
+    {
+      coefficients[1] = (end_pos - start_pos) / T[1];
+    }
+  }
+  else if (!has_accel)
+  {
+    // cubic interpolation
+    const double start_vel = state_a.velocities[i];
+    const double end_vel = state_b.velocities[i];
+
+    coefficients[1] = start_vel;
+    if (T[1] != 0.0)
+    {
+      coefficients[2] =
+        (-3.0 * start_pos + 3.0 * end_pos - 2.0 * start_vel * T[1] - end_vel * T[1]) / T[2];
+      coefficients[3] =
+        (2.0 * start_pos - 2.0 * end_pos + start_vel * T[1] + end_vel * T[1]) / T[3];
+    }
+  }
+  else
+  {
+    // quintic interpolation
+    const double start_vel = state_a.velocities[i];
+    const double start_acc = state_a.accelerations[i];
+    const double end_vel = state_b.velocities[i];
+    const double end_acc = state_b.accelerations[i];
+
+    coefficients[1] = start_vel;
+    coefficients[2] = 0.5 * start_acc;
+    if (T[1] != 0.0)
+    {
+      coefficients[3] = (-20.0 * start_pos + 20.0 * end_pos - 3.0 * start_acc * T[2] +
+                         end_acc * T[2] - 12.0 * start_vel * T[1] - 8.0 * end_vel * T[1]) /
+                        (2.0 * T[3]);
+      coefficients[4] = (30.0 * start_pos - 30.0 * end_pos + 3.0 * start_acc * T[2] -
+                         2.0 * end_acc * T[2] + 16.0 * start_vel * T[1] + 14.0 * end_vel * T[1]) /
+                        (2.0 * T[4]);
+      coefficients[5] = (-12.0 * start_pos + 12.0 * end_pos - start_acc * T[2] + end_acc * T[2] -
+                         6.0 * start_vel * T[1] - 6.0 * end_vel * T[1]) /
+                        (2.0 * T[5]);
+    }
+  }
+}
+
+/**
+ * Compute the spline coefficients of \p dim joints between \p state_a and \p state_b using the
+ * lowest common specification of both states.
+ *
+ * \param[in] joints Indices of the joints in the states, nullptr for the first \p dim joints.
+ * \param[out] coefficients Storage for dim * SPLINE_COEFFICIENTS values, ordered per coefficient,
+ * then joint, so that the joints are evaluated together by evaluate_splines().
+ */
+void compute_segment_spline_coefficients(
+  const SegmentState & state_a, const SegmentState & state_b, const size_t * joints,
+  const size_t dim, const double duration, double * coefficients)
+{
+  const bool has_velocity = state_a.velocities && state_b.velocities;
+  const bool has_accel = state_a.accelerations && state_b.accelerations;
+  double T[6];
+  generate_powers(5, duration, T);
+
+  double joint_coefficients[SPLINE_COEFFICIENTS];
+  for (size_t i = 0; i < dim; ++i)
+  {
+    compute_spline_coefficients(
+      state_a, state_b, joints ? joints[i] : i, has_velocity, has_accel, T, joint_coefficients);
+    for (size_t k = 0; k < SPLINE_COEFFICIENTS; ++k)
+    {
+      coefficients[k * dim + i] = joint_coefficients[k];
+    }
+  }
+}
+
+/// Seconds of a duration in nanoseconds
+double to_seconds(const int64_t nanoseconds) { return static_cast<double>(nanoseconds) * 1e-9; }
+
+/// Set positions, velocities and accelerations of \p point to zero, reusing the storage.
+void zero_fill(trajectory_msgs::msg::JointTrajectoryPoint & point, const size_t dim)
+{
+  point.positions.assign(dim, 0.0);
+  point.velocities.assign(dim, 0.0);
+  point.accelerations.assign(dim, 0.0);
+  point.effort.clear();
+  point.time_from_start.sec = 0;
+  point.time_from_start.nanosec = 0;
+}
+
+/// Evaluate the quintic polynomial and its derivatives at \p t using Horner's scheme.
+void evaluate_spline(
+  const double * c, const double t, double & position, double & velocity, double & acceleration)
+{
+  position = ((((c[5] * t + c[4]) * t + c[3]) * t + c[2]) * t + c[1]) * t + c[0];
+  velocity = (((5.0 * c[5] * t + 4.0 * c[4]) * t + 3.0 * c[3]) * t + 2.0 * c[2]) * t + c[1];
+  acceleration = ((20.0 * c[5] * t + 12.0 * c[4]) * t + 6.0 * c[3]) * t + 2.0 * c[2];
+}
+}  // namespace
+
+Trajectory::Trajectory() : trajectory_start_time_(0) {}
 
 Trajectory::Trajectory(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory)
 : trajectory_msg_(joint_trajectory),
@@ -46,8 +217,29 @@ void Trajectory::set_point_before_trajectory_msg(
   const rclcpp::Time & current_time,
   const trajectory_msgs::msg::JointTrajectoryPoint & current_point)
 {
-  time_before_traj_msg_ = current_time;
+  time_before_traj_msg_ = current_time.nanoseconds();
   state_before_traj_msg_ = current_point;
+  first_segment_coefficients_valid_ = false;
+  blend_into_first_segment_ = false;
+}
+
+void Trajectory::set_point_before_trajectory_msg(
+  const rclcpp::Time & current_time, const controller_realtime_tools::JointVectors & current_point)
+{
+  time_before_traj_msg_ = current_time.nanoseconds();
+  current_point.to_msg(state_before_traj_msg_);
+  first_segment_coefficients_valid_ = false;
+  blend_into_first_segment_ = false;
+}
+
+void Trajectory::set_blend_before_trajectory_msg(
+  const rclcpp::Time & current_time,
+  const trajectory_msgs::msg::JointTrajectoryPoint & current_point)
+{
+  set_point_before_trajectory_msg(current_time, current_point);
+  const size_t dim = current_point.positions.size();
+  blend_into_first_segment_ =
+    current_point.velocities.size() == dim && current_point.accelerations.size() == dim;
 }
 
 void Trajectory::update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> joint_trajectory)
@@ -55,6 +247,29 @@ void Trajectory::update(std::shared_ptr<trajectory_msgs::msg::JointTrajectory> j
   trajectory_msg_ = joint_trajectory;
   trajectory_start_time_ = static_cast<rclcpp::Time>(joint_trajectory->header.stamp);
   sampled_already_ = false;
+  // a reused trajectory doesn't continue the stream of its previous msg
+  stream_id_ = 0;
+  final_ = true;
+  // reserve storage here, the absolute times are filled once the start time is known
+  point_times_.resize(trajectory_msg_->points.size());
+  segment_cursor_ = 0;
+  hold_ns_.store(0, std::memory_order_relaxed);
+  is_compiled_ = compiled_.compile(*trajectory_msg_);
+  compute_segment_coefficients();
+}
+
+void Trajectory::continue_from(Trajectory & previous)
+{
+  trajectory_start_time_ = previous.trajectory_start_time_;
+  time_before_traj_msg_ = previous.time_before_traj_msg_;
+  std::swap(state_before_traj_msg_, previous.state_before_traj_msg_);
+  first_segment_coefficients_valid_ = false;
+  blend_into_first_segment_ = previous.blend_into_first_segment_;
+  hold_ns_.store(previous.hold_ns_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+  update_point_times();
+  compute_first_segment_coefficients();
+  sampled_already_ = true;
 }
 
 bool Trajectory::sample(
@@ -75,43 +290,59 @@ bool Trajectory::sample(
   // first sampling of this trajectory
   if (!sampled_already_)
   {
-    if (trajectory_start_time_.seconds() == 0.0)
+    if (trajectory_start_time_.nanoseconds() == 0)
     {
       trajectory_start_time_ = sample_time;
     }
 
+    update_point_times();
+    compute_first_segment_coefficients();
     sampled_already_ = true;
   }
 
-  // sampling before the current point
-  if (sample_time < time_before_traj_msg_)
+  // sampling before the current point, the points are reached later by the time held
+  const int64_t sample_ns = sample_time.nanoseconds() - hold_ns_.load(std::memory_order_relaxed);
+  if (sample_ns < time_before_traj_msg_)
   {
     return false;
   }
 
-  output_state = trajectory_msgs::msg::JointTrajectoryPoint();
+  // the output is filled in place, so its storage is reused on every sample
+  const size_t dim = state_before_traj_msg_.positions.size();
   auto & first_point_in_msg = trajectory_msg_->points[0];
-  const rclcpp::Time first_point_timestamp =
-    trajectory_start_time_ + first_point_in_msg.time_from_start;
+  const int64_t first_point_time = point_times_[0];
 
   // current time hasn't reached traj time of the first point in the msg yet
-  if (sample_time < first_point_timestamp)
+  if (sample_ns < first_point_time)
   {
     // If interpolation is disabled, just forward the next waypoint
     if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
     {
       output_state = state_before_traj_msg_;
     }
+    else if (is_compiled_ && dim == compiled_.dof)
+    {
+      zero_fill(output_state, dim);
+      // the state before the trajectory was set after its first sample
+      if (!first_segment_coefficients_valid_)
+      {
+        compute_first_segment_coefficients();
+      }
+      evaluate_segment(
+        first_segment_coefficients_.data(), to_seconds(sample_ns - time_before_traj_msg_),
+        output_state);
+    }
     else
     {
+      zero_fill(output_state, dim);
       // it changes points only if position and velocity do not exist, but their derivatives
       deduce_from_derivatives(
-        state_before_traj_msg_, first_point_in_msg, state_before_traj_msg_.positions.size(),
-        (first_point_timestamp - time_before_traj_msg_).seconds());
+        state_before_traj_msg_, first_point_in_msg, dim,
+        to_seconds(first_point_time - time_before_traj_msg_));
 
-      interpolate_between_points(
-        time_before_traj_msg_, state_before_traj_msg_, first_point_timestamp, first_point_in_msg,
-        sample_time, output_state);
+      interpolate_segment(
+        time_before_traj_msg_, state_before_traj_msg_, first_point_time, first_point_in_msg,
+        sample_ns, output_state);
     }
     start_segment_itr = begin();  // no segments before the first
     end_segment_itr = begin();
@@ -120,184 +351,458 @@ bool Trajectory::sample(
 
   // time_from_start + trajectory time is the expected arrival time of trajectory
   const auto last_idx = trajectory_msg_->points.size() - 1;
-  for (size_t i = 0; i < last_idx; ++i)
+  const size_t i = find_segment_index(sample_ns);
+  if (i < last_idx)
   {
     auto & point = trajectory_msg_->points[i];
     auto & next_point = trajectory_msg_->points[i + 1];
 
-    const rclcpp::Time t0 = trajectory_start_time_ + point.time_from_start;
-    const rclcpp::Time t1 = trajectory_start_time_ + next_point.time_from_start;
+    const int64_t t0 = point_times_[i];
+    const int64_t t1 = point_times_[i + 1];
 
-    if (sample_time >= t0 && sample_time < t1)
+    // If interpolation is disabled, just forward the next waypoint
+    if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
     {
-      // If interpolation is disabled, just forward the next waypoint
-      if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
+      if (is_compiled_)
       {
-        output_state = next_point;
+        copy_compiled_point(i + 1, output_state);
       }
-      // Do interpolation
       else
       {
-        // it changes points only if position and velocity do not exist, but their derivatives
-        deduce_from_derivatives(
-          point, next_point, state_before_traj_msg_.positions.size(), (t1 - t0).seconds());
-
-        interpolate_between_points(t0, point, t1, next_point, sample_time, output_state);
+        output_state = next_point;
+      }
+    }
+    // Evaluate the coefficients computed on update()
+    else if (is_compiled_)
+    {
+      const size_t compiled_segments = compiled_segments_.load(std::memory_order_acquire);
+      // the segment is not computed yet, hold the point the computed segments end in until it is
+      if (i >= compiled_segments)
+      {
+        hold_ns_.store(
+          hold_ns_.load(std::memory_order_relaxed) + sample_ns - point_times_[compiled_segments],
+          std::memory_order_relaxed);
+        copy_compiled_point(compiled_segments, output_state);
+        output_state.velocities.assign(output_state.positions.size(), 0.0);
+        output_state.accelerations.assign(output_state.positions.size(), 0.0);
+        start_segment_itr = begin() + compiled_segments;
+        end_segment_itr = begin() + (compiled_segments + 1);
+        return true;
       }
-      start_segment_itr = begin() + i;
-      end_segment_itr = begin() + (i + 1);
-      return true;
+      zero_fill(output_state, compiled_.dof);
+      evaluate_compiled_segment(i, to_seconds(sample_ns - t0), output_state);
     }
+    // Do interpolation
+    else
+    {
+      zero_fill(output_state, dim);
+      // it changes points only if position and velocity do not exist, but their derivatives
+      deduce_from_derivatives(point, next_point, dim, to_seconds(t1 - t0));
+
+      interpolate_segment(t0, point, t1, next_point, sample_ns, output_state);
+    }
+    start_segment_itr = begin() + i;
+    end_segment_itr = begin() + (i + 1);
+    return true;
   }
 
   // whole animation has played out
   start_segment_itr = --end();
   end_segment_itr = end();
-  output_state = (*start_segment_itr);
+  if (is_compiled_)
+  {
+    copy_compiled_point(last_idx, output_state);
+  }
+  else
+  {
+    output_state = (*start_segment_itr);
+  }
   // the trajectories in msg may have empty velocities/accel, so resize them
   if (output_state.velocities.empty())
   {
-    output_state.velocities.resize(output_state.positions.size(), 0.0);
+    output_state.velocities.assign(output_state.positions.size(), 0.0);
   }
   if (output_state.accelerations.empty())
   {
-    output_state.accelerations.resize(output_state.positions.size(), 0.0);
+    output_state.accelerations.assign(output_state.positions.size(), 0.0);
   }
   return true;
 }
 
+bool Trajectory::sample_at(
+  const rclcpp::Time & sample_time,
+  const interpolation_methods::InterpolationMethod interpolation_method,
+  trajectory_msgs::msg::JointTrajectoryPoint & output_state, bool & after_last_point) const
+{
+  after_last_point = false;
+  // the point times are only known after the first sample, and uncompiled points are changed
+  // while sampling
+  const int64_t sample_ns = sample_time.nanoseconds() - hold_ns_.load(std::memory_order_relaxed);
+  if (
+    !trajectory_msg_ || !sampled_already_ || !is_compiled_ || point_times_.empty() ||
+    sample_ns < time_before_traj_msg_)
+  {
+    return false;
+  }
+
+  if (sample_ns < point_times_[0])
+  {
+    // continue_from() takes the state before the trajectory over, so it isn't read here
+    if (
+      interpolation_method == interpolation_methods::InterpolationMethod::NONE ||
+      !first_segment_coefficients_valid_)
+    {
+      return false;
+    }
+    zero_fill(output_state, compiled_.dof);
+    evaluate_segment(
+      first_segment_coefficients_.data(), to_seconds(sample_ns - time_before_traj_msg_),
+      output_state);
+    return true;
+  }
+
+  const size_t last_idx = point_times_.size() - 1;
+  if (sample_ns < point_times_[last_idx])
+  {
+    const auto it = std::upper_bound(point_times_.begin(), point_times_.end(), sample_ns);
+    const size_t i = static_cast<size_t>(std::distance(point_times_.begin(), it)) - 1;
+    if (interpolation_method == interpolation_methods::InterpolationMethod::NONE)
+    {
+      copy_compiled_point(i + 1, output_state);
+    }
+    else if (i < compiled_segments_.load(std::memory_order_acquire))
+    {
+      zero_fill(output_state, compiled_.dof);
+      evaluate_compiled_segment(i, to_seconds(sample_ns - point_times_[i]), output_state);
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  after_last_point = true;
+  copy_compiled_point(last_idx, output_state);
+  if (output_state.velocities.empty())
+  {
+    output_state.velocities.assign(output_state.positions.size(), 0.0);
+  }
+  if (output_state.accelerations.empty())
+  {
+    output_state.accelerations.assign(output_state.positions.size(), 0.0);
+  }
+  return true;
+}
+
+void Trajectory::update_point_times()
+{
+  const auto & points = trajectory_msg_->points;
+  const int64_t start_time = trajectory_start_time_.nanoseconds();
+  point_times_.resize(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    point_times_[i] = start_time + rclcpp::Duration(points[i].time_from_start).nanoseconds();
+  }
+  segment_cursor_ = 0;
+}
+
+size_t Trajectory::find_segment_index(const int64_t sample_time)
+{
+  const size_t last_idx = point_times_.size() - 1;
+  auto in_segment = [&](size_t i)
+  { return i < last_idx && sample_time >= point_times_[i] && sample_time < point_times_[i + 1]; };
+
+  // most of the time we are still in the same segment or just moved to the next one
+  if (in_segment(segment_cursor_))
+  {
+    return segment_cursor_;
+  }
+  if (in_segment(segment_cursor_ + 1))
+  {
+    return ++segment_cursor_;
+  }
+
+  if (sample_time >= point_times_[last_idx])
+  {
+    segment_cursor_ = last_idx;
+    return last_idx;
+  }
+
+  // time jumped backwards or skipped several segments, fall back to binary search.
+  // upper_bound returns the first point later than sample_time, i.e. the segment end point
+  const auto it = std::upper_bound(point_times_.begin(), point_times_.end(), sample_time);
+  segment_cursor_ = static_cast<size_t>(std::distance(point_times_.begin(), it)) - 1;
+  return segment_cursor_;
+}
+
 void Trajectory::interpolate_between_points(
   const rclcpp::Time & time_a, const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
   const rclcpp::Time & time_b, const trajectory_msgs::msg::JointTrajectoryPoint & state_b,
   const rclcpp::Time & sample_time, trajectory_msgs::msg::JointTrajectoryPoint & output)
 {
-  rclcpp::Duration duration_so_far = sample_time - time_a;
-  rclcpp::Duration duration_btwn_points = time_b - time_a;
+  interpolate_segment(
+    time_a.nanoseconds(), state_a, time_b.nanoseconds(), state_b, sample_time.nanoseconds(),
+    output);
+}
+
+void Trajectory::interpolate_segment(
+  const int64_t time_a, const trajectory_msgs::msg::JointTrajectoryPoint & state_a,
+  const int64_t time_b, const trajectory_msgs::msg::JointTrajectoryPoint & state_b,
+  const int64_t sample_time, trajectory_msgs::msg::JointTrajectoryPoint & output)
+{
+  double duration_so_far = to_seconds(sample_time - time_a);
+  const double duration_btwn_points = to_seconds(time_b - time_a);
 
   const size_t dim = state_a.positions.size();
   output.positions.resize(dim, 0.0);
   output.velocities.resize(dim, 0.0);
   output.accelerations.resize(dim, 0.0);
 
-  auto generate_powers = [](int n, double x, double * powers)
-  {
-    powers[0] = 1.0;
-    for (int i = 1; i <= n; ++i)
-    {
-      powers[i] = powers[i - 1] * x;
-    }
-  };
-
   bool has_velocity = !state_a.velocities.empty() && !state_b.velocities.empty();
   bool has_accel = !state_a.accelerations.empty() && !state_b.accelerations.empty();
-  if (duration_so_far.seconds() < 0.0)
+  if (duration_so_far < 0.0)
   {
-    duration_so_far = rclcpp::Duration::from_seconds(0.0);
+    duration_so_far = 0.0;
     has_velocity = has_accel = false;
   }
-  if (duration_so_far.seconds() > duration_btwn_points.seconds())
+  if (duration_so_far > duration_btwn_points)
   {
     duration_so_far = duration_btwn_points;
     has_velocity = has_accel = false;
   }
 
-  double t[6];
-  generate_powers(5, duration_so_far.seconds(), t);
+  double T[6];
+  generate_powers(5, duration_btwn_points, T);
 
-  if (!has_velocity && !has_accel)
+  const SegmentState segment_state_a = to_segment_state(state_a);
+  const SegmentState segment_state_b = to_segment_state(state_b);
+  double coefficients[SPLINE_COEFFICIENTS];
+  for (size_t i = 0; i < dim; ++i)
   {
-    // do linear interpolation
-    for (size_t i = 0; i < dim; ++i)
-    {
-      double start_pos = state_a.positions[i];
-      double end_pos = state_b.positions[i];
+    compute_spline_coefficients(
+      segment_state_a, segment_state_b, i, has_velocity, has_accel, T, coefficients);
+    evaluate_spline(
+      coefficients, duration_so_far, output.positions[i], output.velocities[i],
+      output.accelerations[i]);
+  }
+}
 
-      double coefficients[2] = {0.0, 0.0};
-      coefficients[0] = start_pos;
-      if (duration_btwn_points.seconds() != 0.0)
-      {
-        coefficients[1] = (end_pos - start_pos) / duration_btwn_points.seconds();
-      }
+void Trajectory::compute_segment_coefficients()
+{
+  first_segment_coefficients_valid_ = false;
+  is_compact_ = false;
+  compiled_segments_.store(0, std::memory_order_relaxed);
+  // Positions have to be given for every point, otherwise they are deduced from the derivatives
+  // while sampling, which depends on the state before the trajectory
+  if (!is_compiled_)
+  {
+    return;
+  }
 
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1];
-      output.velocities[i] = t[0] * coefficients[1];
+  // the segments between the points only interpolate the moving joints
+  const auto & moving_joints = compiled_.moving_joints;
+  const size_t segment_size = moving_joints.size() * SPLINE_COEFFICIENTS;
+  const size_t segment_count = compiled_.size() - 1;
+  first_segment_coefficients_.resize(compiled_.dof * SPLINE_COEFFICIENTS);
+  blend_end_state_.positions.resize(compiled_.dof);
+  blend_end_state_.velocities.resize(compiled_.dof);
+  blend_end_state_.accelerations.resize(compiled_.dof);
+  if (!single_precision_)
+  {
+    compact_compiled_.clear();
+    compact_segment_coefficients_.clear();
+    segment_coefficients_.resize(segment_count * segment_size);
+    // the first segment is always computed, compute_blend_end_state() reads it
+    const size_t initial_segments =
+      initial_segments_ > 0 ? std::min(initial_segments_, segment_count) : segment_count;
+    compute_segments(0, initial_segments);
+    compiled_segments_.store(initial_segments, std::memory_order_release);
+    return;
+  }
+
+  // every segment is computed in double precision into segment_coefficients_, backwards, so that
+  // it is left with the first segment, which compute_blend_end_state() reads
+  segment_coefficients_.resize(segment_count > 0 ? segment_size : 0);
+  compact_segment_coefficients_.resize(segment_count * segment_size);
+  for (size_t i = segment_count; i-- > 0;)
+  {
+    const double duration =
+      static_cast<double>(compiled_.time_from_start[i + 1] - compiled_.time_from_start[i]) * 1e-9;
+    compute_segment_spline_coefficients(
+      to_segment_state(compiled_, i), to_segment_state(compiled_, i + 1), moving_joints.data(),
+      moving_joints.size(), duration, segment_coefficients_.data());
+    for (size_t k = 0; k < segment_size; ++k)
+    {
+      compact_segment_coefficients_[i * segment_size + k] =
+        static_cast<float>(segment_coefficients_[k]);
     }
   }
-  else if (has_velocity && !has_accel)
+  compact_compiled_.assign(compiled_);
+  is_compact_ = true;
+  compiled_segments_.store(segment_count, std::memory_order_release);
+  // the first point is still read from compiled_ for the segment to it
+  compiled_.release_values_after_first_point();
+}
+
+void Trajectory::compute_segments(const size_t first, const size_t last)
+{
+  const auto & moving_joints = compiled_.moving_joints;
+  const size_t segment_size = moving_joints.size() * SPLINE_COEFFICIENTS;
+  for (size_t i = first; i < last; ++i)
   {
-    // do cubic interpolation
-    double T[4];
-    generate_powers(3, duration_btwn_points.seconds(), T);
+    const double duration =
+      static_cast<double>(compiled_.time_from_start[i + 1] - compiled_.time_from_start[i]) * 1e-9;
+    compute_segment_spline_coefficients(
+      to_segment_state(compiled_, i), to_segment_state(compiled_, i + 1), moving_joints.data(),
+      moving_joints.size(), duration, segment_coefficients_.data() + i * segment_size);
+  }
+}
 
-    for (size_t i = 0; i < dim; ++i)
-    {
-      double start_pos = state_a.positions[i];
-      double start_vel = state_a.velocities[i];
-      double end_pos = state_b.positions[i];
-      double end_vel = state_b.velocities[i];
+bool Trajectory::compile_segments(const size_t count)
+{
+  if (is_fully_compiled())
+  {
+    return true;
+  }
+  const size_t segment_count = compiled_.size() - 1;
+  const size_t first = compiled_segments_.load(std::memory_order_relaxed);
+  const size_t last = first + std::min(count, segment_count - first);
+  compute_segments(first, last);
+  // the sampling thread reads the coefficients of a segment only after its count is published
+  compiled_segments_.store(last, std::memory_order_release);
+  return last == segment_count;
+}
 
-      double coefficients[4] = {0.0, 0.0, 0.0, 0.0};
-      coefficients[0] = start_pos;
-      coefficients[1] = start_vel;
-      if (duration_btwn_points.seconds() != 0.0)
-      {
-        coefficients[2] =
-          (-3.0 * start_pos + 3.0 * end_pos - 2.0 * start_vel * T[1] - end_vel * T[1]) / T[2];
-        coefficients[3] =
-          (2.0 * start_pos - 2.0 * end_pos + start_vel * T[1] + end_vel * T[1]) / T[3];
-      }
+bool Trajectory::is_fully_compiled() const
+{
+  return !is_compiled_ ||
+         compiled_segments_.load(std::memory_order_acquire) + 1 >= compiled_.size();
+}
 
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1] +
-                            t[2] * coefficients[2] + t[3] * coefficients[3];
-      output.velocities[i] =
-        t[0] * coefficients[1] + t[1] * 2.0 * coefficients[2] + t[2] * 3.0 * coefficients[3];
-      output.accelerations[i] = t[0] * 2.0 * coefficients[2] + t[1] * 6.0 * coefficients[3];
+void Trajectory::compute_blend_end_state()
+{
+  const size_t dof = compiled_.dof;
+  std::copy_n(compiled_.positions.begin(), dof, blend_end_state_.positions.begin());
+  if (compiled_.size() > 1)
+  {
+    // the derivatives of the first segment at its start, which are the given ones if any
+    const double * coefficients = segment_coefficients_.data();
+    const auto & moving_joints = compiled_.moving_joints;
+    const size_t moving = moving_joints.size();
+    for (size_t i = 0; i < moving; ++i)
+    {
+      blend_end_state_.velocities[moving_joints[i]] = coefficients[moving + i];
+      blend_end_state_.accelerations[moving_joints[i]] = 2.0 * coefficients[2 * moving + i];
+    }
+    for (const size_t joint : compiled_.held_joints)
+    {
+      blend_end_state_.velocities[joint] = 0.0;
+      blend_end_state_.accelerations[joint] = 0.0;
     }
+    return;
+  }
+  // a single point is reached at rest, unless given otherwise
+  if (compiled_.has_velocities())
+  {
+    std::copy_n(compiled_.velocities.begin(), dof, blend_end_state_.velocities.begin());
+  }
+  else
+  {
+    std::fill(blend_end_state_.velocities.begin(), blend_end_state_.velocities.end(), 0.0);
+  }
+  if (compiled_.has_accelerations())
+  {
+    std::copy_n(compiled_.accelerations.begin(), dof, blend_end_state_.accelerations.begin());
   }
-  else if (has_velocity && has_accel)
+  else
   {
-    // do quintic interpolation
-    double T[6];
-    generate_powers(5, duration_btwn_points.seconds(), T);
+    std::fill(blend_end_state_.accelerations.begin(), blend_end_state_.accelerations.end(), 0.0);
+  }
+}
 
-    for (size_t i = 0; i < dim; ++i)
-    {
-      double start_pos = state_a.positions[i];
-      double start_vel = state_a.velocities[i];
-      double start_acc = state_a.accelerations[i];
-      double end_pos = state_b.positions[i];
-      double end_vel = state_b.velocities[i];
-      double end_acc = state_b.accelerations[i];
-
-      double coefficients[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-      coefficients[0] = start_pos;
-      coefficients[1] = start_vel;
-      coefficients[2] = 0.5 * start_acc;
-      if (duration_btwn_points.seconds() != 0.0)
-      {
-        coefficients[3] = (-20.0 * start_pos + 20.0 * end_pos - 3.0 * start_acc * T[2] +
-                           end_acc * T[2] - 12.0 * start_vel * T[1] - 8.0 * end_vel * T[1]) /
-                          (2.0 * T[3]);
-        coefficients[4] = (30.0 * start_pos - 30.0 * end_pos + 3.0 * start_acc * T[2] -
-                           2.0 * end_acc * T[2] + 16.0 * start_vel * T[1] + 14.0 * end_vel * T[1]) /
-                          (2.0 * T[4]);
-        coefficients[5] = (-12.0 * start_pos + 12.0 * end_pos - start_acc * T[2] + end_acc * T[2] -
-                           6.0 * start_vel * T[1] - 6.0 * end_vel * T[1]) /
-                          (2.0 * T[5]);
-      }
+void Trajectory::compute_first_segment_coefficients()
+{
+  if (!is_compiled_ || state_before_traj_msg_.positions.size() != compiled_.dof)
+  {
+    return;
+  }
+  if (blend_into_first_segment_)
+  {
+    compute_blend_end_state();
+  }
+  compute_segment_spline_coefficients(
+    to_segment_state(state_before_traj_msg_),
+    blend_into_first_segment_ ? to_segment_state(blend_end_state_) : to_segment_state(compiled_, 0),
+    nullptr, compiled_.dof, to_seconds(point_times_[0] - time_before_traj_msg_),
+    first_segment_coefficients_.data());
+  first_segment_coefficients_valid_ = true;
+}
 
-      output.positions[i] = t[0] * coefficients[0] + t[1] * coefficients[1] +
-                            t[2] * coefficients[2] + t[3] * coefficients[3] +
-                            t[4] * coefficients[4] + t[5] * coefficients[5];
-      output.velocities[i] = t[0] * coefficients[1] + t[1] * 2.0 * coefficients[2] +
-                             t[2] * 3.0 * coefficients[3] + t[3] * 4.0 * coefficients[4] +
-                             t[4] * 5.0 * coefficients[5];
-      output.accelerations[i] = t[0] * 2.0 * coefficients[2] + t[1] * 6.0 * coefficients[3] +
-                                t[2] * 12.0 * coefficients[4] + t[3] * 20.0 * coefficients[5];
-    }
+void Trajectory::evaluate_segment(
+  const double * coefficients, const double t,
+  trajectory_msgs::msg::JointTrajectoryPoint & output) const
+{
+  evaluate_splines(
+    coefficients, compiled_.dof, t, output.positions.data(), output.velocities.data(),
+    output.accelerations.data());
+}
+
+void Trajectory::evaluate_compiled_segment(
+  size_t index, const double t, trajectory_msgs::msg::JointTrajectoryPoint & output) const
+{
+  // the moving joints are evaluated into the front of the output, and then moved to their place
+  const auto & moving_joints = compiled_.moving_joints;
+  const size_t moving = moving_joints.size();
+  const size_t segment_size = moving * SPLINE_COEFFICIENTS;
+  double * positions = output.positions.data();
+  double * velocities = output.velocities.data();
+  double * accelerations = output.accelerations.data();
+  if (is_compact_)
+  {
+    evaluate_compact_splines(
+      compact_segment_coefficients_.data() + index * segment_size, moving, static_cast<float>(t),
+      positions, velocities, accelerations);
+  }
+  else
+  {
+    evaluate_splines(
+      segment_coefficients_.data() + index * segment_size, moving, t, positions, velocities,
+      accelerations);
+  }
+  if (moving == compiled_.dof)
+  {
+    return;
+  }
+  // backwards, as every moving joint is at or after its place in the front
+  for (size_t i = moving; i-- > 0;)
+  {
+    const size_t joint = moving_joints[i];
+    positions[joint] = positions[i];
+    velocities[joint] = velocities[i];
+    accelerations[joint] = accelerations[i];
+  }
+  // the first point is kept in double precision even if compact
+  for (const size_t joint : compiled_.held_joints)
+  {
+    positions[joint] = compiled_.positions[joint];
+    velocities[joint] = 0.0;
+    accelerations[joint] = 0.0;
   }
 }
 
+void Trajectory::copy_compiled_point(
+  size_t index, trajectory_msgs::msg::JointTrajectoryPoint & output) const
+{
+  if (!is_compact_ || index == 0)
+  {
+    compiled_.copy_point(index, output);
+    return;
+  }
+  compact_compiled_.copy_point(index, output);
+  output.time_from_start = rclcpp::Duration::from_nanoseconds(compiled_.time_from_start[index]);
+}
+
 void Trajectory::deduce_from_derivatives(
   trajectory_msgs::msg::JointTrajectoryPoint & first_state,
   trajectory_msgs::msg::JointTrajectoryPoint & second_state, const size_t dim, const double delta_t)
@@ -351,4 +856,290 @@ rclcpp::Time Trajectory::time_from_start() const { return trajectory_start_time_
 
 bool Trajectory::has_trajectory_msg() const { return trajectory_msg_.get() != nullptr; }
 
+size_t Trajectory::heap_bytes() const
+{
+  using controller_realtime_tools::heap_bytes;
+  const auto point_bytes = [](const trajectory_msgs::msg::JointTrajectoryPoint & point)
+  {
+    return heap_bytes(point.positions) + heap_bytes(point.velocities) +
+           heap_bytes(point.accelerations) + heap_bytes(point.effort);
+  };
+
+  size_t bytes = heap_bytes(point_times_) + heap_bytes(segment_coefficients_) +
+                 heap_bytes(compact_segment_coefficients_) +
+                 heap_bytes(first_segment_coefficients_) + point_bytes(blend_end_state_) +
+                 point_bytes(state_before_traj_msg_);
+  bytes += heap_bytes(compiled_.time_from_start) + heap_bytes(compiled_.positions) +
+           heap_bytes(compiled_.velocities) + heap_bytes(compiled_.accelerations) +
+           heap_bytes(compiled_.effort) + heap_bytes(compiled_.moving_joints) +
+           heap_bytes(compiled_.held_joints);
+  bytes += heap_bytes(compact_compiled_.positions) + heap_bytes(compact_compiled_.velocities) +
+           heap_bytes(compact_compiled_.accelerations) + heap_bytes(compact_compiled_.effort);
+  if (trajectory_msg_)
+  {
+    const auto & points = trajectory_msg_->points;
+    bytes += sizeof(trajectory_msgs::msg::JointTrajectory) +
+             heap_bytes(trajectory_msg_->joint_names) +
+             points.capacity() * sizeof(trajectory_msgs::msg::JointTrajectoryPoint);
+    for (const auto & point : points)
+    {
+      bytes += point_bytes(point);
+    }
+  }
+  return bytes;
+}
+
+void time_parameterize_trajectory_msg(
+  trajectory_msgs::msg::JointTrajectory & trajectory,
+  const interpolation_methods::InterpolationMethod interpolation_method,
+  const std::vector<MotionLimits> & limits)
+{
+  using interpolation_methods::InterpolationMethod;
+  const bool trapezoidal = interpolation_method == InterpolationMethod::TRAPEZOIDAL;
+  auto & waypoints = trajectory.points;
+  if (
+    (interpolation_method != InterpolationMethod::MINIMUM_JERK && !trapezoidal) ||
+    waypoints.empty() ||
+    std::any_of(
+      waypoints.begin(), waypoints.end(), [](const auto & point) { return point.positions.empty(); }))
+  {
+    return;
+  }
+
+  const size_t dim = waypoints[0].positions.size();
+  // a rest-to-rest profile is a quintic with zero velocities and accelerations at the waypoints,
+  // a trapezoidal one is a cubic between the points with zero velocities at the waypoints
+  auto set_rest = [dim, trapezoidal](trajectory_msgs::msg::JointTrajectoryPoint & point)
+  {
+    point.velocities.assign(dim, 0.0);
+    if (trapezoidal)
+    {
+      point.accelerations.clear();
+    }
+    else
+    {
+      point.accelerations.assign(dim, 0.0);
+    }
+  };
+
+  std::vector<trajectory_msgs::msg::JointTrajectoryPoint> points;
+  points.reserve(trapezoidal ? 3 * waypoints.size() - 2 : waypoints.size());
+  points.push_back(waypoints[0]);
+  set_rest(points.back());
+  for (size_t k = 1; k < waypoints.size(); ++k)
+  {
+    const auto & start = waypoints[k - 1];
+    const auto & end = waypoints[k];
+
+    // the time needed by the slowest joint at its velocity and acceleration limit, per unit of the
+    // normalized profile
+    double velocity_time = 0.0;
+    double acceleration_time = 0.0;
+    for (size_t i = 0; i < dim; ++i)
+    {
+      const double distance = std::abs(end.positions[i] - start.positions[i]);
+      if (limits[i].max_velocity > 0.0)
+      {
+        velocity_time = std::max(velocity_time, distance / limits[i].max_velocity);
+      }
+      if (limits[i].max_acceleration > 0.0)
+      {
+        acceleration_time = std::max(acceleration_time, distance / limits[i].max_acceleration);
+      }
+    }
+
+    double min_duration = 0.0;
+    if (!trapezoidal)
+    {
+      // peak velocity 15/8 d/T and peak acceleration 10/sqrt(3) d/T^2 of the minimum-jerk profile
+      min_duration =
+        std::max(1.875 * velocity_time, std::sqrt(5.773502691896258 * acceleration_time));
+    }
+    else if (acceleration_time == 0.0)
+    {
+      // without acceleration limits, the triangular profile reaching the velocity limit
+      min_duration = 2.0 * velocity_time;
+    }
+    else if (velocity_time * velocity_time >= acceleration_time)
+    {
+      min_duration = velocity_time + acceleration_time / velocity_time;
+    }
+    else
+    {
+      // the maximum velocity is not reached
+      min_duration = 2.0 * std::sqrt(acceleration_time);
+    }
+
+    const double start_time = rclcpp::Duration(points.back().time_from_start).seconds();
+    const double duration = std::max(
+      (rclcpp::Duration(end.time_from_start) - rclcpp::Duration(start.time_from_start)).seconds(),
+      min_duration);
+
+    if (trapezoidal)
+    {
+      // normalized profile with the acceleration time ta, as long as possible to reduce the peak
+      // acceleration: s(ta) = 0.5 * ta / (T - ta), s'(ta) = 1 / (T - ta)
+      const double ta = std::min(0.5 * duration, duration - velocity_time);
+      auto add_point = [&](const double time, const double s, const double s_dot)
+      {
+        trajectory_msgs::msg::JointTrajectoryPoint point;
+        point.positions.resize(dim);
+        point.velocities.resize(dim);
+        for (size_t i = 0; i < dim; ++i)
+        {
+          const double distance = end.positions[i] - start.positions[i];
+          point.positions[i] = start.positions[i] + s * distance;
+          point.velocities[i] = s_dot * distance;
+        }
+        point.effort = end.effort;
+        point.time_from_start = rclcpp::Duration::from_seconds(start_time + time);
+        points.push_back(point);
+      };
+      if (ta > 0.0)
+      {
+        const double s_dot = 1.0 / (duration - ta);
+        const double s_ta = 0.5 * ta * s_dot;
+        add_point(ta, s_ta, s_dot);
+        if (duration - ta > ta)
+        {
+          add_point(duration - ta, 1.0 - s_ta, s_dot);
+        }
+      }
+    }
+
+    points.push_back(end);
+    set_rest(points.back());
+    points.back().time_from_start = rclcpp::Duration::from_seconds(start_time + duration);
+  }
+  waypoints = std::move(points);
+}
+
+size_t simplify_trajectory_msg(
+  trajectory_msgs::msg::JointTrajectory & trajectory, const std::vector<double> & tolerances)
+{
+  auto & points = trajectory.points;
+  const size_t dim = tolerances.size();
+  if (points.size() < 3)
+  {
+    return 0;
+  }
+  // every segment has to be interpolated the same way, with or without the removed points
+  const bool has_velocity = !points.front().velocities.empty();
+  const bool has_accel = has_velocity && !points.front().accelerations.empty();
+  for (const auto & point : points)
+  {
+    if (
+      point.positions.size() != dim || point.velocities.size() != (has_velocity ? dim : 0) ||
+      point.accelerations.size() != (has_accel ? dim : 0) || !point.effort.empty())
+    {
+      return 0;
+    }
+  }
+
+  std::vector<bool> keep(points.size(), false);
+  keep.front() = true;
+  keep.back() = true;
+  // the ranges of points still to simplify, without recursion for long trajectories
+  std::vector<std::pair<size_t, size_t>> ranges = {{0, points.size() - 1}};
+  std::vector<double> coefficients(SPLINE_COEFFICIENTS * dim);
+  double T[6];
+  while (!ranges.empty())
+  {
+    const auto [first, last] = ranges.back();
+    ranges.pop_back();
+
+    const double start = rclcpp::Duration(points[first].time_from_start).seconds();
+    generate_powers(5, rclcpp::Duration(points[last].time_from_start).seconds() - start, T);
+    const auto state_a = to_segment_state(points[first]);
+    const auto state_b = to_segment_state(points[last]);
+    for (size_t i = 0; i < dim; ++i)
+    {
+      compute_spline_coefficients(
+        state_a, state_b, i, has_velocity, has_accel, T,
+        coefficients.data() + i * SPLINE_COEFFICIENTS);
+    }
+
+    // the point deviating most relative to the tolerances, if any exceeds them
+    size_t worst = first;
+    double worst_ratio = 1.0;
+    for (size_t index = first + 1; index < last; ++index)
+    {
+      const double t = rclcpp::Duration(points[index].time_from_start).seconds() - start;
+      for (size_t i = 0; i < dim; ++i)
+      {
+        double position, velocity, acceleration;
+        evaluate_spline(
+          coefficients.data() + i * SPLINE_COEFFICIENTS, t, position, velocity, acceleration);
+        const double deviation = std::abs(position - points[index].positions[i]);
+        if (deviation > tolerances[i])
+        {
+          const double ratio = tolerances[i] > 0.0 ? deviation / tolerances[i]
+                                                   : std::numeric_limits<double>::infinity();
+          if (ratio > worst_ratio)
+          {
+            worst = index;
+            worst_ratio = ratio;
+          }
+        }
+      }
+    }
+    if (worst != first)
+    {
+      keep[worst] = true;
+      ranges.emplace_back(first, worst);
+      ranges.emplace_back(worst, last);
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t index = 0; index < points.size(); ++index)
+  {
+    if (keep[index])
+    {
+      if (kept != index)
+      {
+        points[kept] = std::move(points[index]);
+      }
+      ++kept;
+    }
+  }
+  const size_t removed = points.size() - kept;
+  points.erase(points.begin() + static_cast<std::ptrdiff_t>(kept), points.end());
+  return removed;
+}
+
+void splice_trajectory_msg(
+  trajectory_msgs::msg::JointTrajectory & trajectory,
+  const trajectory_msgs::msg::JointTrajectory & chunk, const rclcpp::Duration & chunk_offset,
+  const rclcpp::Duration & keep_from)
+{
+  auto & points = trajectory.points;
+  if (!chunk.points.empty())
+  {
+    const rclcpp::Duration chunk_start =
+      chunk_offset + rclcpp::Duration(chunk.points.front().time_from_start);
+    const auto replaced_itr = std::find_if(
+      points.begin(), points.end(), [&chunk_start](const auto & point)
+      { return rclcpp::Duration(point.time_from_start) >= chunk_start; });
+    points.erase(replaced_itr, points.end());
+  }
+
+  // keep the start point of the segment being executed
+  auto kept_itr = std::find_if(
+    points.begin(), points.end(), [&keep_from](const auto & point)
+    { return rclcpp::Duration(point.time_from_start) > keep_from; });
+  if (kept_itr != points.begin())
+  {
+    --kept_itr;
+  }
+  points.erase(points.begin(), kept_itr);
+
+  points.reserve(points.size() + chunk.points.size());
+  for (const auto & chunk_point : chunk.points)
+  {
+    points.push_back(chunk_point);
+    points.back().time_from_start = chunk_offset + rclcpp::Duration(chunk_point.time_from_start);
+  }
+}
+
 }  // namespace joint_trajectory_controller
@@ -0,0 +1,287 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/trajectory_file.hpp"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+constexpr char MAGIC[8] = {'J', 'T', 'C', 'T', 'R', 'A', 'J', '1'};
+constexpr size_t HEADER_SIZE = 32;
+constexpr uint32_t HAS_VELOCITIES = 1u << 0;
+constexpr uint32_t HAS_ACCELERATIONS = 1u << 1;
+
+template <typename T>
+T load(const unsigned char * data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void store(std::ofstream & file, const T & value)
+{
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+constexpr int64_t NANOSECONDS_PER_SECOND = 1000000000;
+}  // namespace
+
+std::shared_ptr<const TrajectoryFile> TrajectoryFile::open(
+  const std::string & path, std::string & error)
+{
+#ifdef _WIN32
+  (void)path;
+  error = "trajectory files are not supported on this platform";
+  return nullptr;
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    error = "can't open '" + path + "': " + std::strerror(errno);
+    return nullptr;
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(HEADER_SIZE))
+  {
+    ::close(fd);
+    error = "'" + path + "' is too short for a trajectory file";
+    return nullptr;
+  }
+  const auto mapped_size = static_cast<size_t>(status.st_size);
+  void * data = ::mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping keeps the file open
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    error = "can't map '" + path + "': " + std::strerror(errno);
+    return nullptr;
+  }
+  // the points are read front to back, once
+  ::madvise(data, mapped_size, MADV_SEQUENTIAL);
+
+  std::shared_ptr<TrajectoryFile> file(new TrajectoryFile());
+  file->data_ = static_cast<const unsigned char *>(data);
+  file->mapped_size_ = mapped_size;
+
+  const unsigned char * header = file->data_;
+  if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0)
+  {
+    error = "'" + path + "' is not a trajectory file of version 1";
+    return nullptr;
+  }
+  const auto joint_count = load<uint32_t>(header + 8);
+  const auto fields = load<uint32_t>(header + 12);
+  const auto point_count = load<uint64_t>(header + 16);
+  const auto names_size = load<uint64_t>(header + 24);
+  if (joint_count == 0 || (fields & ~(HAS_VELOCITIES | HAS_ACCELERATIONS)) != 0)
+  {
+    error = "'" + path + "' has no joints or unknown fields";
+    return nullptr;
+  }
+  if (names_size % 8 != 0 || names_size > mapped_size - HEADER_SIZE)
+  {
+    error = "'" + path + "' has an invalid size of the joint names";
+    return nullptr;
+  }
+  file->has_velocities_ = (fields & HAS_VELOCITIES) != 0;
+  file->has_accelerations_ = (fields & HAS_ACCELERATIONS) != 0;
+  const size_t value_count =
+    1 + static_cast<size_t>(file->has_velocities_) + static_cast<size_t>(file->has_accelerations_);
+  file->point_size_ = sizeof(int64_t) + value_count * joint_count * sizeof(double);
+
+  // the names are terminated, and all of them within the names block
+  const auto * names = reinterpret_cast<const char *>(header + HEADER_SIZE);
+  size_t offset = 0;
+  for (uint32_t joint = 0; joint < joint_count; ++joint)
+  {
+    const void * terminator =
+      offset < names_size ? std::memchr(names + offset, '\0', names_size - offset) : nullptr;
+    if (terminator == nullptr)
+    {
+      error = "'" + path + "' has fewer joint names than joints";
+      return nullptr;
+    }
+    const auto length =
+      static_cast<size_t>(static_cast<const char *>(terminator) - (names + offset));
+    file->joint_names_.emplace_back(names + offset, length);
+    offset += length + 1;
+  }
+
+  const size_t points_size = mapped_size - HEADER_SIZE - names_size;
+  if (
+    point_count == 0 || point_count != points_size / file->point_size_ ||
+    points_size % file->point_size_ != 0)
+  {
+    error = "'" + path + "' has no points, or its size doesn't match its number of points";
+    return nullptr;
+  }
+  file->point_count_ = static_cast<size_t>(point_count);
+  file->points_ = file->data_ + HEADER_SIZE + names_size;
+  return file;
+#endif
+}
+
+bool TrajectoryFile::write(
+  const std::string & path, const trajectory_msgs::msg::JointTrajectory & trajectory,
+  std::string & error)
+{
+  const size_t joint_count = trajectory.joint_names.size();
+  if (joint_count == 0 || trajectory.points.empty())
+  {
+    error = "the trajectory has no joints or no points";
+    return false;
+  }
+  const bool has_velocities = !trajectory.points.front().velocities.empty();
+  const bool has_accelerations = !trajectory.points.front().accelerations.empty();
+  for (const auto & point : trajectory.points)
+  {
+    if (
+      point.positions.size() != joint_count ||
+      point.velocities.size() != (has_velocities ? joint_count : 0) ||
+      point.accelerations.size() != (has_accelerations ? joint_count : 0))
+    {
+      error = "the points don't all have the same fields for all joints";
+      return false;
+    }
+  }
+
+  std::string names;
+  for (const auto & name : trajectory.joint_names)
+  {
+    names += name;
+    names.push_back('\0');
+  }
+  names.resize((names.size() + 7) / 8 * 8, '\0');
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    error = "can't open '" + path + "' for writing";
+    return false;
+  }
+  file.write(MAGIC, sizeof(MAGIC));
+  store(file, static_cast<uint32_t>(joint_count));
+  store(
+    file, (has_velocities ? HAS_VELOCITIES : 0u) | (has_accelerations ? HAS_ACCELERATIONS : 0u));
+  store(file, static_cast<uint64_t>(trajectory.points.size()));
+  store(file, static_cast<uint64_t>(names.size()));
+  file.write(names.data(), static_cast<std::streamsize>(names.size()));
+  for (const auto & point : trajectory.points)
+  {
+    store(
+      file, static_cast<int64_t>(point.time_from_start.sec) * NANOSECONDS_PER_SECOND +
+              point.time_from_start.nanosec);
+    for (const auto * values : {&point.positions, &point.velocities, &point.accelerations})
+    {
+      file.write(
+        reinterpret_cast<const char *>(values->data()),
+        static_cast<std::streamsize>(values->size() * sizeof(double)));
+    }
+  }
+  if (!file.flush())
+  {
+    error = "can't write '" + path + "'";
+    return false;
+  }
+  return true;
+}
+
+TrajectoryFile::~TrajectoryFile()
+{
+#ifndef _WIN32
+  if (data_)
+  {
+    ::munmap(const_cast<unsigned char *>(data_), mapped_size_);
+  }
+#endif
+}
+
+int64_t TrajectoryFile::time_from_start_ns(size_t index) const
+{
+  return load<int64_t>(points_ + index * point_size_);
+}
+
+bool TrajectoryFile::read_points(
+  size_t begin, size_t end, trajectory_msgs::msg::JointTrajectory & trajectory,
+  std::string & error) const
+{
+  const size_t joint_count = joint_names_.size();
+  int64_t previous_time_ns =
+    begin > 0 ? time_from_start_ns(begin - 1) : std::numeric_limits<int64_t>::min();
+  trajectory.points.reserve(trajectory.points.size() + (end - begin));
+  for (size_t index = begin; index < end; ++index)
+  {
+    const unsigned char * data = points_ + index * point_size_;
+    const int64_t time_ns = load<int64_t>(data);
+    if (time_ns <= previous_time_ns || time_ns < 0)
+    {
+      error = "time_from_start of point " + std::to_string(index) + " doesn't increase";
+      return false;
+    }
+    previous_time_ns = time_ns;
+
+    trajectory_msgs::msg::JointTrajectoryPoint point;
+    point.time_from_start.sec = static_cast<int32_t>(time_ns / NANOSECONDS_PER_SECOND);
+    point.time_from_start.nanosec = static_cast<uint32_t>(time_ns % NANOSECONDS_PER_SECOND);
+    const unsigned char * values = data + sizeof(int64_t);
+    bool finite = true;
+    const auto read_values = [&](std::vector<double> & field)
+    {
+      field.resize(joint_count);
+      std::memcpy(field.data(), values, joint_count * sizeof(double));
+      values += joint_count * sizeof(double);
+      for (const double value : field)
+      {
+        finite = finite && std::isfinite(value);
+      }
+    };
+    read_values(point.positions);
+    if (has_velocities_)
+    {
+      read_values(point.velocities);
+    }
+    if (has_accelerations_)
+    {
+      read_values(point.accelerations);
+    }
+    if (!finite)
+    {
+      error = "point " + std::to_string(index) + " has a value which isn't finite";
+      return false;
+    }
+    trajectory.points.push_back(std::move(point));
+  }
+  return true;
+}
+
+}  // namespace joint_trajectory_controller
@@ -0,0 +1,103 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "joint_trajectory_controller/trajectory_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace joint_trajectory_controller
+{
+namespace
+{
+/// Whether only the pool references \p trajectory. Nobody else can take a new reference then, as
+/// the pool only hands out trajectories under its lock.
+bool is_unused(const std::shared_ptr<Trajectory> & trajectory)
+{
+  if (trajectory.use_count() != 1)
+  {
+    return false;
+  }
+  // the release of the last other reference happens before the trajectory is reused
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return true;
+}
+}  // namespace
+
+TrajectoryPool::TrajectoryPool(size_t capacity) { reserve(capacity); }
+
+void TrajectoryPool::reserve(size_t capacity)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  capacity_ = capacity;
+  trajectories_.reserve(capacity_);
+  while (trajectories_.size() < capacity_)
+  {
+    trajectories_.push_back(std::make_shared<Trajectory>());
+  }
+}
+
+std::shared_ptr<Trajectory> TrajectoryPool::acquire()
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  // free the trajectories allocated beyond the capacity which aren't used anymore
+  if (trajectories_.size() > capacity_)
+  {
+    trajectories_.erase(
+      std::remove_if(
+        trajectories_.begin() + static_cast<std::ptrdiff_t>(capacity_), trajectories_.end(),
+        is_unused),
+      trajectories_.end());
+  }
+
+  const auto it = std::find_if(trajectories_.begin(), trajectories_.end(), is_unused);
+  if (it != trajectories_.end())
+  {
+    return *it;
+  }
+
+  trajectories_.push_back(std::make_shared<Trajectory>());
+  return trajectories_.back();
+}
+
+void TrajectoryPool::add_to(controller_realtime_tools::MemoryPrefaulter & prefaulter)
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  prefaulter.add(trajectories_);
+  for (const auto & trajectory : trajectories_)
+  {
+    prefaulter.add_object(*trajectory);
+  }
+}
+
+size_t TrajectoryPool::size() const
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  return trajectories_.size();
+}
+
+size_t TrajectoryPool::available() const
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  return static_cast<size_t>(
+    std::count_if(trajectories_.begin(), trajectories_.end(), is_unused));
+}
+
+void TrajectoryPool::clear()
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  trajectories_.clear();
+}
+
+}  // namespace joint_trajectory_controller
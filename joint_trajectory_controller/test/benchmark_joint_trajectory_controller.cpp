@@ -0,0 +1,313 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the realtime path of the joint_trajectory_controller.
+//
+// Every benchmark reports the time per cycle, the heap allocations per cycle and the tail latency
+// of single cycles (p50_ns, p99_ns, max_ns). The trajectories are sampled at 1 kHz, with waypoints
+// every 10 ms, or spread over at least 10 s for short trajectories.
+//
+// Arguments: number of joints, number of points, interpolation method (and interface combination
+// for the controller), see INTERPOLATION_METHODS and INTERFACE_COMBINATIONS.
+//
+// Like all performance tests, the benchmarks only run with ctest if AMENT_RUN_PERFORMANCE_TESTS is
+// set. Run a subset directly with, e.g.,
+//   benchmark_joint_trajectory_controller --benchmark_filter='update/dof:6/.*'
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "joint_trajectory_controller/joint_trajectory_controller.hpp"
+#include "joint_trajectory_controller/trajectory.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+const std::vector<std::string> INTERPOLATION_METHODS = {"none", "splines"};
+
+struct InterfaceCombination
+{
+  std::vector<std::string> command_interfaces;
+  std::vector<std::string> state_interfaces;
+};
+
+const std::vector<InterfaceCombination> INTERFACE_COMBINATIONS = {
+  {{hardware_interface::HW_IF_POSITION}, {hardware_interface::HW_IF_POSITION}},
+  {{hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY},
+   {hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY}},
+  // closed loop
+  {{hardware_interface::HW_IF_VELOCITY},
+   {hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY}},
+  {{hardware_interface::HW_IF_EFFORT},
+   {hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY}},
+};
+
+const rclcpp::Duration CYCLE_PERIOD = rclcpp::Duration::from_seconds(0.001);
+constexpr double POINT_PERIOD = 0.01;
+constexpr double MIN_DURATION = 10.0;
+
+std::vector<std::string> make_joint_names(size_t dof)
+{
+  std::vector<std::string> joint_names(dof);
+  for (size_t i = 0; i < dof; ++i)
+  {
+    joint_names[i] = "joint" + std::to_string(i + 1);
+  }
+  return joint_names;
+}
+
+/// Trajectory moving every joint on a sine, with positions, velocities and accelerations
+std::shared_ptr<trajectory_msgs::msg::JointTrajectory> make_trajectory_msg(
+  size_t dof, size_t num_points)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->joint_names = make_joint_names(dof);
+  msg->points.resize(num_points);
+  const double point_period =
+    std::max(POINT_PERIOD, MIN_DURATION / static_cast<double>(num_points - 1));
+  for (size_t k = 0; k < num_points; ++k)
+  {
+    auto & point = msg->points[k];
+    const double t = point_period * static_cast<double>(k + 1);
+    point.time_from_start = rclcpp::Duration::from_seconds(t);
+    point.positions.resize(dof);
+    point.velocities.resize(dof);
+    point.accelerations.resize(dof);
+    for (size_t i = 0; i < dof; ++i)
+    {
+      const double phase = t + 0.1 * static_cast<double>(i);
+      point.positions[i] = std::sin(phase);
+      point.velocities[i] = std::cos(phase);
+      point.accelerations[i] = -std::sin(phase);
+    }
+  }
+  return msg;
+}
+
+/// Times of single cycles, to report the tail latency
+class CycleTimes
+{
+public:
+  explicit CycleTimes(const benchmark::State & state)
+  {
+    times_ns_.reserve(static_cast<size_t>(state.max_iterations));
+  }
+
+  void add(std::chrono::steady_clock::duration cycle_time, benchmark::State & state)
+  {
+    const auto cycle_time_ns = std::chrono::duration<double, std::nano>(cycle_time).count();
+    times_ns_.push_back(cycle_time_ns);
+    state.SetIterationTime(cycle_time_ns * 1e-9);
+  }
+
+  void report(benchmark::State & state, size_t allocations)
+  {
+    std::sort(times_ns_.begin(), times_ns_.end());
+    auto percentile = [this](double p)
+    {
+      return times_ns_[static_cast<size_t>(p * static_cast<double>(times_ns_.size() - 1))];
+    };
+    if (!times_ns_.empty())
+    {
+      state.counters["p50_ns"] = percentile(0.5);
+      state.counters["p99_ns"] = percentile(0.99);
+      state.counters["max_ns"] = times_ns_.back();
+    }
+    state.counters["allocations"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  std::vector<double> times_ns_;
+};
+
+class BenchmarkJointTrajectoryController
+: public joint_trajectory_controller::JointTrajectoryController
+{
+public:
+  using joint_trajectory_controller::JointTrajectoryController::add_new_trajectory_msg;
+
+  void declare_parameters() { param_listener_->declare_params(); }
+};
+
+class TrajectoryControllerBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    rclcpp::init(0, nullptr);
+
+    dof_ = static_cast<size_t>(state.range(0));
+    joint_names_ = make_joint_names(dof_);
+    const auto interfaces = INTERFACE_COMBINATIONS[static_cast<size_t>(state.range(3))];
+
+    controller_ = std::make_shared<BenchmarkJointTrajectoryController>();
+    controller_->init("benchmark_joint_trajectory_controller");
+    auto node = controller_->get_node();
+    node->set_parameters(
+      {rclcpp::Parameter("joints", joint_names_),
+       rclcpp::Parameter("command_interfaces", interfaces.command_interfaces),
+       rclcpp::Parameter("state_interfaces", interfaces.state_interfaces),
+       rclcpp::Parameter(
+         "interpolation_method", INTERPOLATION_METHODS[static_cast<size_t>(state.range(2))])});
+    controller_->declare_parameters();
+    for (const auto & joint_name : joint_names_)
+    {
+      node->set_parameter(rclcpp::Parameter("gains." + joint_name + ".p", 1.0));
+    }
+    node->configure();
+
+    // the states follow the commands
+    values_.assign(4 * dof_, 0.0);
+    command_interfaces_.reserve(4 * dof_);
+    state_interfaces_.reserve(3 * dof_);
+    const std::vector<std::string> interface_types = {
+      hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY,
+      hardware_interface::HW_IF_ACCELERATION, hardware_interface::HW_IF_EFFORT};
+    std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+    std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+    for (size_t i = 0; i < dof_; ++i)
+    {
+      for (size_t type = 0; type < interface_types.size(); ++type)
+      {
+        double * value = &values_[type * dof_ + i];
+        command_interfaces_.emplace_back(joint_names_[i], interface_types[type], value);
+        loaned_command_interfaces.emplace_back(command_interfaces_.back());
+        if (interface_types[type] != hardware_interface::HW_IF_EFFORT)
+        {
+          state_interfaces_.emplace_back(joint_names_[i], interface_types[type], value);
+          loaned_state_interfaces.emplace_back(state_interfaces_.back());
+        }
+      }
+    }
+    controller_->assign_interfaces(
+      std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+    node->activate();
+
+    trajectory_msg_ = make_trajectory_msg(dof_, static_cast<size_t>(state.range(1)));
+    trajectory_duration_ = rclcpp::Duration(trajectory_msg_->points.back().time_from_start);
+  }
+
+  void TearDown(benchmark::State &) override
+  {
+    controller_->get_node()->deactivate();
+    controller_.reset();
+    rclcpp::shutdown();
+  }
+
+protected:
+  /// Hand over a copy of the trajectory, the controller preprocesses the msg in place
+  void add_trajectory()
+  {
+    controller_->add_new_trajectory_msg(
+      std::make_shared<trajectory_msgs::msg::JointTrajectory>(*trajectory_msg_));
+  }
+
+  size_t dof_;
+  std::vector<std::string> joint_names_;
+  std::shared_ptr<BenchmarkJointTrajectoryController> controller_;
+  std::vector<double> values_;
+  std::vector<hardware_interface::CommandInterface> command_interfaces_;
+  std::vector<hardware_interface::StateInterface> state_interfaces_;
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> trajectory_msg_;
+  rclcpp::Duration trajectory_duration_{0, 0};
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(TrajectoryControllerBenchmark, update)(benchmark::State & state)
+{
+  add_trajectory();
+  rclcpp::Time time(1, 0, RCL_STEADY_TIME);
+  rclcpp::Time trajectory_start = time;
+
+  CycleTimes cycle_times(state);
+  controller_realtime_tools::ScopedRealtimeSafetyCounter allocation_counter;
+  for (auto _ : state)
+  {
+    if (time - trajectory_start > trajectory_duration_)
+    {
+      // restart the trajectory, the preprocessing of the msg happens outside of the realtime loop
+      controller_realtime_tools::realtime_safety::counting = false;
+      add_trajectory();
+      controller_realtime_tools::realtime_safety::counting = true;
+      trajectory_start = time;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    controller_->update(time, CYCLE_PERIOD);
+    cycle_times.add(std::chrono::steady_clock::now() - start, state);
+    time += CYCLE_PERIOD;
+  }
+  cycle_times.report(state, allocation_counter.get_allocations());
+}
+
+BENCHMARK_REGISTER_F(TrajectoryControllerBenchmark, update)
+  ->ArgNames({"dof", "points", "interpolation", "interfaces"})
+  ->ArgsProduct(
+    {{1, 6, 50},
+     {2, 1000, 100000},
+     benchmark::CreateDenseRange(0, static_cast<int64_t>(INTERPOLATION_METHODS.size()) - 1, 1),
+     benchmark::CreateDenseRange(0, static_cast<int64_t>(INTERFACE_COMBINATIONS.size()) - 1, 1)})
+  ->UseManualTime();
+
+static void BM_TrajectorySample(benchmark::State & state)
+{
+  const auto dof = static_cast<size_t>(state.range(0));
+  const auto msg = make_trajectory_msg(dof, static_cast<size_t>(state.range(1)));
+  const auto interpolation_method = joint_trajectory_controller::interpolation_methods::from_string(
+    INTERPOLATION_METHODS[static_cast<size_t>(state.range(2))]);
+  const rclcpp::Duration duration(msg->points.back().time_from_start);
+
+  const rclcpp::Time start_time(1, 0, RCL_STEADY_TIME);
+  trajectory_msgs::msg::JointTrajectoryPoint state_before = msg->points.front();
+  joint_trajectory_controller::Trajectory trajectory(start_time, state_before, msg);
+  trajectory_msgs::msg::JointTrajectoryPoint output;
+  joint_trajectory_controller::TrajectoryPointConstIter start_segment_itr, end_segment_itr;
+
+  rclcpp::Time time = start_time;
+  CycleTimes cycle_times(state);
+  controller_realtime_tools::ScopedRealtimeSafetyCounter allocation_counter;
+  for (auto _ : state)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    trajectory.sample(time, interpolation_method, output, start_segment_itr, end_segment_itr);
+    cycle_times.add(std::chrono::steady_clock::now() - start, state);
+    benchmark::DoNotOptimize(output);
+
+    time += CYCLE_PERIOD;
+    if (time - start_time > duration)
+    {
+      time = start_time;
+    }
+  }
+  cycle_times.report(state, allocation_counter.get_allocations());
+}
+
+BENCHMARK(BM_TrajectorySample)
+  ->ArgNames({"dof", "points", "interpolation"})
+  ->ArgsProduct(
+    {{1, 6, 50},
+     {2, 1000, 100000},
+     benchmark::CreateDenseRange(0, static_cast<int64_t>(INTERPOLATION_METHODS.size()) - 1, 1)})
+  ->UseManualTime();
@@ -0,0 +1,148 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "control_msgs/action/follow_joint_trajectory.hpp"
+#include "joint_trajectory_controller/offline_simulator.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+using joint_trajectory_controller::OfflineSimulator;
+using FollowJTrajResult = control_msgs::action::FollowJointTrajectory::Result;
+
+namespace
+{
+/// Move joint2 by 1.0 within 1 s, joint1 stays where it is
+trajectory_msgs::msg::JointTrajectory make_trajectory()
+{
+  trajectory_msgs::msg::JointTrajectory trajectory;
+  trajectory.joint_names = {"joint1", "joint2"};
+  trajectory_msgs::msg::JointTrajectoryPoint point;
+  point.positions = {0.0, 1.0};
+  point.velocities = {0.0, 0.0};
+  point.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  trajectory.points.push_back(point);
+  return trajectory;
+}
+
+class TestOfflineSimulator : public testing::Test
+{
+public:
+  static void SetUpTestCase() { rclcpp::init(0, nullptr); }
+  static void TearDownTestCase() { rclcpp::shutdown(); }
+
+protected:
+  void SetUp() override { options_.joints = {"joint1", "joint2"}; }
+
+  std::unique_ptr<OfflineSimulator> create()
+  {
+    auto simulator = OfflineSimulator::create("test_offline_simulator", options_, error_);
+    EXPECT_TRUE(simulator) << error_;
+    return simulator;
+  }
+
+  OfflineSimulator::Options options_;
+  std::string error_;
+};
+}  // namespace
+
+TEST_F(TestOfflineSimulator, executes_trajectory_in_synthetic_time)
+{
+  options_.update_rate = 1000.0;
+  auto simulator = create();
+  ASSERT_TRUE(simulator);
+
+  const auto result = simulator->execute(make_trajectory());
+  EXPECT_EQ(result.error_code, FollowJTrajResult::SUCCESSFUL) << result.error_string;
+  EXPECT_NEAR(result.duration, 1.0, 0.01);
+  EXPECT_NEAR(static_cast<double>(result.cycles), 1000.0, 10.0);
+  EXPECT_THAT(simulator->positions(), testing::Pointwise(testing::DoubleNear(1e-6), {0.0, 1.0}));
+  EXPECT_TRUE(result.violating_joint.empty());
+
+  // the next trajectory starts where the last one ended
+  auto trajectory = make_trajectory();
+  trajectory.points[0].positions = {-1.0, 0.0};
+  EXPECT_EQ(simulator->execute(trajectory).error_code, FollowJTrajResult::SUCCESSFUL);
+  EXPECT_THAT(simulator->positions(), testing::Pointwise(testing::DoubleNear(1e-6), {-1.0, 0.0}));
+}
+
+TEST_F(TestOfflineSimulator, reports_path_tolerance_violation)
+{
+  options_.time_constant = 0.2;
+  options_.parameters = {rclcpp::Parameter("constraints.joint2.trajectory", 0.05)};
+  auto simulator = create();
+  ASSERT_TRUE(simulator);
+
+  const auto result = simulator->execute(make_trajectory());
+  EXPECT_EQ(result.error_code, FollowJTrajResult::PATH_TOLERANCE_VIOLATED);
+  EXPECT_EQ(result.violating_joint, "joint2");
+  ASSERT_EQ(result.violation_error.positions.size(), 2u);
+  EXPECT_GT(result.violation_error.positions[1], 0.05);
+  EXPECT_LT(result.duration, 1.0);
+  EXPECT_GT(result.max_position_errors[1], 0.05);
+}
+
+TEST_F(TestOfflineSimulator, reports_goal_tolerance_violation)
+{
+  options_.time_constant = 0.5;
+  options_.parameters = {
+    rclcpp::Parameter("constraints.goal_time", 0.1),
+    rclcpp::Parameter("constraints.joint2.goal", 0.001)};
+  auto simulator = create();
+  ASSERT_TRUE(simulator);
+
+  const auto result = simulator->execute(make_trajectory());
+  EXPECT_EQ(result.error_code, FollowJTrajResult::GOAL_TOLERANCE_VIOLATED);
+  EXPECT_EQ(result.violating_joint, "joint2");
+  EXPECT_NEAR(result.duration, 1.1, 0.02);
+}
+
+TEST_F(TestOfflineSimulator, waits_for_goal_tolerances_within_settling_time)
+{
+  options_.time_constant = 0.5;
+  options_.settling_time = 5.0;
+  options_.parameters = {rclcpp::Parameter("constraints.joint2.goal", 0.001)};
+  auto simulator = create();
+  ASSERT_TRUE(simulator);
+
+  const auto result = simulator->execute(make_trajectory());
+  EXPECT_EQ(result.error_code, FollowJTrajResult::SUCCESSFUL) << result.error_string;
+  EXPECT_GT(result.duration, 1.5);
+  EXPECT_LT(result.duration, 6.0);
+}
+
+TEST_F(TestOfflineSimulator, rejects_invalid_options_and_trajectories)
+{
+  options_.command_interfaces = {"effort"};
+  EXPECT_FALSE(OfflineSimulator::create("test_offline_simulator", options_, error_));
+  EXPECT_FALSE(error_.empty());
+  options_.command_interfaces = {"position"};
+  options_.initial_positions = {0.0};
+  EXPECT_FALSE(OfflineSimulator::create("test_offline_simulator", options_, error_));
+
+  options_.initial_positions = {0.5, 0.5};
+  auto simulator = create();
+  ASSERT_TRUE(simulator);
+  auto trajectory = make_trajectory();
+  trajectory.joint_names = {"joint1", "unknown_joint"};
+  EXPECT_EQ(simulator->execute(trajectory).error_code, FollowJTrajResult::INVALID_GOAL);
+  trajectory.points.clear();
+  EXPECT_EQ(simulator->execute(trajectory).error_code, FollowJTrajResult::INVALID_GOAL);
+  // the joints don't move meanwhile
+  EXPECT_THAT(simulator->positions(), testing::ElementsAre(0.5, 0.5));
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/spline_sampling.hpp"
+
+using joint_trajectory_controller::evaluate_splines;
+using joint_trajectory_controller::evaluate_splines_portable;
+using joint_trajectory_controller::SPLINE_COEFFICIENTS;
+
+namespace
+{
+/// Coefficients of \p dof joints ordered per coefficient, then joint
+std::vector<double> make_coefficients(size_t dof, size_t degree)
+{
+  std::vector<double> coefficients(SPLINE_COEFFICIENTS * dof, 0.0);
+  for (size_t k = 0; k <= degree; ++k)
+  {
+    for (size_t j = 0; j < dof; ++j)
+    {
+      coefficients[k * dof + j] = std::sin(static_cast<double>(7 * k + j + 1));
+    }
+  }
+  return coefficients;
+}
+}  // namespace
+
+TEST(TestSplineSampling, kernel_is_selected)
+{
+  const std::string name = joint_trajectory_controller::get_spline_kernel_name();
+  EXPECT_THAT(name, ::testing::AnyOf("avx2", "neon", "portable"));
+}
+
+TEST(TestSplineSampling, portable_kernel_evaluates_polynomials)
+{
+  // p(t) = 1 + 2 t + 3 t^2 + 4 t^3 + 5 t^4 + 6 t^5 for the single joint
+  const std::vector<double> coefficients = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  double position = 0.0;
+  double velocity = 0.0;
+  double acceleration = 0.0;
+  evaluate_splines_portable(coefficients.data(), 1, 0.5, &position, &velocity, &acceleration);
+  EXPECT_DOUBLE_EQ(position, 1.0 + 1.0 + 0.75 + 0.5 + 0.3125 + 0.1875);
+  EXPECT_DOUBLE_EQ(velocity, 2.0 + 3.0 + 3.0 + 2.5 + 1.875);
+  EXPECT_DOUBLE_EQ(acceleration, 6.0 + 12.0 + 15.0 + 15.0);
+}
+
+TEST(TestSplineSampling, selected_kernel_matches_portable_one)
+{
+  // full SIMD lanes, remainders, and the sizes of arms and humanoids
+  for (const size_t dof : {1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 30u, 50u})
+  {
+    for (const size_t degree : {3u, 5u})
+    {
+      const auto coefficients = make_coefficients(dof, degree);
+      std::vector<double> positions(dof), velocities(dof), accelerations(dof);
+      std::vector<double> expected_positions(dof), expected_velocities(dof),
+        expected_accelerations(dof);
+      for (const double t : {0.0, 0.01, 0.37, 1.5})
+      {
+        evaluate_splines(
+          coefficients.data(), dof, t, positions.data(), velocities.data(), accelerations.data());
+        evaluate_splines_portable(
+          coefficients.data(), dof, t, expected_positions.data(), expected_velocities.data(),
+          expected_accelerations.data());
+        for (size_t j = 0; j < dof; ++j)
+        {
+          SCOPED_TRACE("dof " + std::to_string(dof) + ", joint " + std::to_string(j));
+          // the kernels only differ in rounding, e.g. if the compiler fuses operations of one
+          EXPECT_NEAR(positions[j], expected_positions[j], 1e-12);
+          EXPECT_NEAR(velocities[j], expected_velocities[j], 1e-12);
+          EXPECT_NEAR(accelerations[j], expected_accelerations[j], 1e-12);
+        }
+      }
+    }
+  }
+}
+
+TEST(TestSplineSampling, compact_kernel_within_error_bound)
+{
+  const size_t dof = 7;
+  // positions of joints up to 10 rad
+  auto coefficients = make_coefficients(dof, 5);
+  for (size_t j = 0; j < dof; ++j)
+  {
+    coefficients[j] *= 10.0;
+  }
+  const std::vector<float> compact_coefficients(coefficients.begin(), coefficients.end());
+  std::vector<double> positions(dof), velocities(dof), accelerations(dof);
+  std::vector<double> expected_positions(dof), expected_velocities(dof),
+    expected_accelerations(dof);
+  for (const double t : {0.0, 0.01, 0.37, 1.5})
+  {
+    joint_trajectory_controller::evaluate_compact_splines(
+      compact_coefficients.data(), dof, static_cast<float>(t), positions.data(),
+      velocities.data(), accelerations.data());
+    evaluate_splines_portable(
+      coefficients.data(), dof, t, expected_positions.data(), expected_velocities.data(),
+      expected_accelerations.data());
+    for (size_t j = 0; j < dof; ++j)
+    {
+      SCOPED_TRACE("joint " + std::to_string(j) + ", t " + std::to_string(t));
+      // the bound of the documentation, including the rounding of the coefficients and t
+      double magnitude = 0.0;
+      double power = 1.0;
+      for (size_t k = 0; k < SPLINE_COEFFICIENTS; ++k)
+      {
+        magnitude += std::abs(coefficients[k * dof + j]) * power;
+        power *= t;
+      }
+      EXPECT_NEAR(positions[j], expected_positions[j], 13.0 * std::ldexp(magnitude, -24));
+    }
+  }
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <limits>
+#include <vector>
+
+#include "joint_trajectory_controller/tolerances.hpp"
+#include "trajectory_msgs/msg/joint_trajectory_point.hpp"
+
+using joint_trajectory_controller::check_state_tolerance;
+using joint_trajectory_controller::check_state_tolerance_per_joint;
+using joint_trajectory_controller::JointsStateTolerances;
+using joint_trajectory_controller::StateTolerances;
+using joint_trajectory_controller::ToleranceViolations;
+using trajectory_msgs::msg::JointTrajectoryPoint;
+
+namespace
+{
+std::vector<StateTolerances> make_tolerances()
+{
+  std::vector<StateTolerances> tolerances(4);
+  tolerances[0] = {0.1, 0.0, 0.0};
+  tolerances[1] = {0.0, 0.2, 0.0};
+  tolerances[2] = {0.1, 0.2, 0.3};
+  // joint 3 is not checked
+  return tolerances;
+}
+}  // namespace
+
+TEST(TestTolerances, check_state_tolerance_within)
+{
+  const JointsStateTolerances tolerances(make_tolerances());
+
+  JointTrajectoryPoint error;
+  error.positions = {0.1, 10.0, -0.05, 100.0};
+  error.velocities = {10.0, -0.2, 0.1, 100.0};
+  error.accelerations = {10.0, 10.0, 0.3, 100.0};
+
+  const auto result = check_state_tolerance(error, tolerances);
+  EXPECT_FALSE(result.any());
+  EXPECT_EQ(ToleranceViolations::NONE, result.variables);
+}
+
+TEST(TestTolerances, check_state_tolerance_violated)
+{
+  const JointsStateTolerances tolerances(make_tolerances());
+
+  JointTrajectoryPoint error;
+  error.positions = {0.0, 0.0, -0.11, 0.0};
+  error.velocities = {0.0, 0.21, 0.0, 0.0};
+  error.accelerations = {0.0, 0.0, 0.0, 0.0};
+
+  auto result = check_state_tolerance(error, tolerances);
+  EXPECT_TRUE(result.any());
+  EXPECT_EQ(ToleranceViolations::POSITION | ToleranceViolations::VELOCITY, result.variables);
+  EXPECT_EQ(1u, result.first_joint);
+
+  // velocity and acceleration errors are optional
+  error.velocities.clear();
+  error.accelerations.clear();
+  result = check_state_tolerance(error, tolerances);
+  EXPECT_EQ(ToleranceViolations::POSITION, result.variables);
+  EXPECT_EQ(2u, result.first_joint);
+}
+
+TEST(TestTolerances, check_state_tolerance_matches_per_joint_check)
+{
+  const auto state_tolerances = make_tolerances();
+  const JointsStateTolerances tolerances(state_tolerances);
+
+  const std::vector<double> values = {-0.35, -0.15, -0.05, 0.0, 0.05, 0.15, 0.25, 0.35};
+  JointTrajectoryPoint error;
+  error.positions.resize(4);
+  error.velocities.resize(4);
+  error.accelerations.resize(4);
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    for (size_t joint = 0; joint < 4; ++joint)
+    {
+      error.positions[joint] = values[(i + joint) % values.size()];
+      error.velocities[joint] = values[(i + 2 * joint + 1) % values.size()];
+      error.accelerations[joint] = values[(i + 3 * joint + 2) % values.size()];
+    }
+
+    bool per_joint_valid = true;
+    size_t first_joint = 0;
+    for (size_t joint = 4; joint-- > 0;)
+    {
+      if (!check_state_tolerance_per_joint(error, joint, state_tolerances[joint]))
+      {
+        per_joint_valid = false;
+        first_joint = joint;
+      }
+    }
+
+    const auto result = check_state_tolerance(error, tolerances);
+    EXPECT_EQ(per_joint_valid, !result.any());
+    EXPECT_EQ(first_joint, result.first_joint);
+  }
+}
@@ -12,15 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "gmock/gmock.h"
 
 #include "builtin_interfaces/msg/duration.hpp"
 #include "builtin_interfaces/msg/time.hpp"
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+#include "joint_trajectory_controller/compiled_trajectory.hpp"
 #include "joint_trajectory_controller/trajectory.hpp"
 #include "rclcpp/clock.hpp"
 #include "rclcpp/duration.hpp"
@@ -821,3 +825,865 @@ TEST(TestTrajectory, skip_interpolation)
     }
   }
 }
+
+TEST(TestTrajectory, sample_trajectory_out_of_order)
+{
+  // linear ramp, the position of each point equals its time_from_start in seconds
+  const size_t n_points = 100;
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+  for (size_t i = 1; i <= n_points; ++i)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions.push_back(static_cast<double>(i));
+    p.time_from_start = rclcpp::Duration::from_seconds(static_cast<double>(i));
+    full_msg->points.push_back(p);
+  }
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.time_from_start = rclcpp::Duration::from_seconds(0.0);
+  point_before_msg.positions.push_back(0.0);
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+
+  // sample at trajectory starting time
+  ASSERT_TRUE(traj.sample(time_now, DEFAULT_INTERPOLATION, expected_state, start, end));
+
+  // sample forward, then jump backwards and far ahead again
+  for (const double t : {1.5, 2.5, 3.25, 50.5, 4.75, 1.0, 99.5, 98.25, 10.0})
+  {
+    ASSERT_TRUE(traj.sample(
+      time_now + rclcpp::Duration::from_seconds(t), DEFAULT_INTERPOLATION, expected_state, start,
+      end));
+    const auto start_idx = static_cast<std::ptrdiff_t>(std::floor(t)) - 1;
+    EXPECT_EQ(traj.begin() + start_idx, start);
+    EXPECT_EQ(traj.begin() + start_idx + 1, end);
+    EXPECT_NEAR(t, expected_state.positions[0], EPS);
+  }
+
+  // sample past given points and back inside again
+  ASSERT_TRUE(traj.sample(
+    time_now + rclcpp::Duration::from_seconds(120.0), DEFAULT_INTERPOLATION, expected_state, start,
+    end));
+  EXPECT_EQ((--traj.end()), start);
+  EXPECT_EQ(traj.end(), end);
+  ASSERT_TRUE(traj.sample(
+    time_now + rclcpp::Duration::from_seconds(20.5), DEFAULT_INTERPOLATION, expected_state, start,
+    end));
+  EXPECT_EQ(traj.begin() + 19, start);
+  EXPECT_NEAR(20.5, expected_state.positions[0], EPS);
+}
+
+TEST(TestTrajectory, sample_precomputed_segments_match_interpolation)
+{
+  // the runtime-sized and the fixed-size kernels
+  for (const size_t dof : {2u, 6u, 7u})
+  {
+    SCOPED_TRACE("DOF " + std::to_string(dof));
+    auto joint_position = [](size_t j, double t)
+    { return static_cast<double>(j + 1) * std::sin(t + 0.5 * static_cast<double>(j)); };
+    auto joint_velocity = [](size_t j, double t)
+    { return static_cast<double>(j + 1) * std::cos(t + 0.5 * static_cast<double>(j)); };
+
+    auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+    full_msg->header.stamp = rclcpp::Time(0);
+    for (size_t i = 1; i <= 4; ++i)
+    {
+      const double t = static_cast<double>(i);
+      trajectory_msgs::msg::JointTrajectoryPoint p;
+      for (size_t j = 0; j < dof; ++j)
+      {
+        p.positions.push_back(joint_position(j, t));
+        p.velocities.push_back(joint_velocity(j, t));
+        p.accelerations.push_back(-joint_position(j, t));
+      }
+      p.time_from_start = rclcpp::Duration::from_seconds(t);
+      full_msg->points.push_back(p);
+    }
+
+    trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+    point_before_msg.time_from_start = rclcpp::Duration::from_seconds(0.0);
+    for (size_t j = 0; j < dof; ++j)
+    {
+      point_before_msg.positions.push_back(joint_position(j, 0.0));
+      point_before_msg.velocities.push_back(joint_velocity(j, 0.0));
+      point_before_msg.accelerations.push_back(-joint_position(j, 0.0));
+    }
+
+    const rclcpp::Time time_now = rclcpp::Clock().now();
+    auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+    trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+    trajectory_msgs::msg::JointTrajectoryPoint interpolated_state;
+    joint_trajectory_controller::TrajectoryPointConstIter start, end;
+
+    ASSERT_TRUE(traj.sample(time_now, DEFAULT_INTERPOLATION, expected_state, start, end));
+    for (double t = 0.05; t < 4.0; t += 0.1)
+    {
+      const rclcpp::Time sample_time = time_now + rclcpp::Duration::from_seconds(t);
+      ASSERT_TRUE(traj.sample(sample_time, DEFAULT_INTERPOLATION, expected_state, start, end));
+
+      // interpolate the same segment without precomputed coefficients
+      if (start == end)
+      {
+        traj.interpolate_between_points(
+          time_now, point_before_msg, time_now + start->time_from_start, *start, sample_time,
+          interpolated_state);
+      }
+      else
+      {
+        traj.interpolate_between_points(
+          time_now + start->time_from_start, *start, time_now + end->time_from_start, *end,
+          sample_time, interpolated_state);
+      }
+      for (size_t j = 0; j < dof; ++j)
+      {
+        EXPECT_NEAR(interpolated_state.positions[j], expected_state.positions[j], EPS);
+        EXPECT_NEAR(interpolated_state.velocities[j], expected_state.velocities[j], EPS);
+        EXPECT_NEAR(interpolated_state.accelerations[j], expected_state.accelerations[j], EPS);
+      }
+    }
+  }
+}
+
+TEST(TestTrajectory, compile_trajectory)
+{
+  trajectory_msgs::msg::JointTrajectory msg;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const double t = static_cast<double>(i + 1);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {t, 10.0 * t};
+    p.velocities = {-t, -10.0 * t};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    msg.points.push_back(p);
+  }
+
+  joint_trajectory_controller::CompiledTrajectory compiled;
+  ASSERT_TRUE(compiled.compile(msg));
+  EXPECT_EQ(3u, compiled.size());
+  EXPECT_EQ(2u, compiled.dof);
+  EXPECT_TRUE(compiled.has_velocities());
+  EXPECT_FALSE(compiled.has_accelerations());
+  EXPECT_FALSE(compiled.has_effort());
+  // values are ordered by point and joint
+  EXPECT_EQ(2000000000, compiled.time_from_start[1]);
+  EXPECT_NEAR(20.0, compiled.positions[1 * 2 + 1], EPS);
+  EXPECT_NEAR(-3.0, compiled.velocities[2 * 2 + 0], EPS);
+
+  trajectory_msgs::msg::JointTrajectoryPoint point;
+  point.effort = {1.0};
+  compiled.copy_point(2, point);
+  EXPECT_EQ(msg.points[2].positions, point.positions);
+  EXPECT_EQ(msg.points[2].velocities, point.velocities);
+  EXPECT_TRUE(point.accelerations.empty());
+  EXPECT_TRUE(point.effort.empty());
+  EXPECT_EQ(3, point.time_from_start.sec);
+
+  // velocities given only for some points can't be represented
+  msg.points[1].velocities.clear();
+  EXPECT_FALSE(compiled.compile(msg));
+  EXPECT_TRUE(compiled.empty());
+  // missing positions are deduced while sampling
+  msg.points[1].velocities = {-2.0, -20.0};
+  msg.points[1].positions.clear();
+  EXPECT_FALSE(compiled.compile(msg));
+}
+
+TEST(TestTrajectory, held_joints_are_not_interpolated)
+{
+  // joints 0 and 2 hold, as those a partial goal is filled up with
+  const rclcpp::Time start = rclcpp::Clock().now();
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->header.stamp = start;
+  for (size_t i = 1; i <= 4; ++i)
+  {
+    const double t = static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {0.5, std::sin(t), -1.5, t * t};
+    p.velocities = {0.0, std::cos(t), 0.0, 2.0 * t};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    msg->points.push_back(p);
+  }
+
+  joint_trajectory_controller::CompiledTrajectory compiled;
+  ASSERT_TRUE(compiled.compile(*msg));
+  EXPECT_EQ(std::vector<size_t>({1, 3}), compiled.moving_joints);
+  EXPECT_EQ(std::vector<size_t>({0, 2}), compiled.held_joints);
+
+  // the moving joints are sampled as a trajectory of their own, and the held joints hold after
+  // the first point
+  auto moving_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*msg);
+  for (auto & p : moving_msg->points)
+  {
+    p.positions = {p.positions[1], p.positions[3]};
+    p.velocities = {p.velocities[1], p.velocities[3]};
+  }
+  trajectory_msgs::msg::JointTrajectoryPoint state_before, moving_state_before;
+  state_before.positions = {0.0, 0.0, -1.0, 0.0};
+  state_before.velocities = {0.0, 1.0, 0.0, 0.0};
+  moving_state_before.positions = {0.0, 0.0};
+  moving_state_before.velocities = {1.0, 0.0};
+  for (const bool single_precision : {false, true})
+  {
+    SCOPED_TRACE(single_precision ? "single precision" : "double precision");
+    joint_trajectory_controller::Trajectory traj, moving_traj;
+    traj.set_single_precision(single_precision);
+    traj.update(msg);
+    traj.set_point_before_trajectory_msg(start, state_before);
+    moving_traj.set_single_precision(single_precision);
+    moving_traj.update(moving_msg);
+    moving_traj.set_point_before_trajectory_msg(start, moving_state_before);
+
+    trajectory_msgs::msg::JointTrajectoryPoint expected, output;
+    joint_trajectory_controller::TrajectoryPointConstIter start_itr, end_itr;
+    for (double t = 1.25; t < 4.0; t += 0.5)
+    {
+      const auto time = start + rclcpp::Duration::from_seconds(t);
+      ASSERT_TRUE(traj.sample(time, DEFAULT_INTERPOLATION, output, start_itr, end_itr));
+      ASSERT_TRUE(moving_traj.sample(time, DEFAULT_INTERPOLATION, expected, start_itr, end_itr));
+      EXPECT_NEAR(expected.positions[0], output.positions[1], 1e-6) << "t " << t;
+      EXPECT_NEAR(expected.positions[1], output.positions[3], 1e-6) << "t " << t;
+      EXPECT_NEAR(expected.velocities[0], output.velocities[1], 1e-6) << "t " << t;
+      EXPECT_NEAR(expected.velocities[1], output.velocities[3], 1e-6) << "t " << t;
+      EXPECT_EQ(0.5, output.positions[0]) << "t " << t;
+      EXPECT_EQ(-1.5, output.positions[2]) << "t " << t;
+      EXPECT_EQ(0.0, output.velocities[0]) << "t " << t;
+      EXPECT_EQ(0.0, output.velocities[2]) << "t " << t;
+      EXPECT_EQ(0.0, output.accelerations[0]) << "t " << t;
+      EXPECT_EQ(0.0, output.accelerations[2]) << "t " << t;
+    }
+  }
+}
+
+TEST(TestTrajectory, sample_does_not_allocate)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+  for (size_t i = 1; i <= 3; ++i)
+  {
+    const double t = static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {t, -t, 2.0 * t};
+    p.velocities = {1.0, -1.0, 2.0};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    full_msg->points.push_back(p);
+  }
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 0.0, 0.0};
+  point_before_msg.velocities = {0.0, 0.0, 0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  // preallocated output, as done by the controller on configure
+  trajectory_msgs::msg::JointTrajectoryPoint output;
+  output.positions.reserve(3);
+  output.velocities.reserve(3);
+  output.accelerations.reserve(3);
+  output.effort.reserve(3);
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+
+  ASSERT_TRUE(traj.sample(time_now, DEFAULT_INTERPOLATION, output, start, end));
+  for (const auto method : {DEFAULT_INTERPOLATION, InterpolationMethod::NONE})
+  {
+    controller_realtime_tools::ScopedRealtimeSafetyCounter counter;
+    // before the first point, on the segments and after the trajectory
+    for (double t = 0.0; t < 4.0; t += 0.01)
+    {
+      traj.sample(
+        time_now + rclcpp::Duration::from_seconds(t), method, output, start, end);
+    }
+    EXPECT_EQ(0u, counter.get_allocations());
+  }
+}
+
+TEST(TestTrajectory, sample_at_matches_sample)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+  for (size_t i = 1; i <= 3; ++i)
+  {
+    const double t = static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {t, -t * t};
+    p.velocities = {1.0, -2.0 * t};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    full_msg->points.push_back(p);
+  }
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0, 0.0};
+  point_before_msg.velocities = {0.0, 0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected_state;
+  trajectory_msgs::msg::JointTrajectoryPoint state;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  bool after_last_point = false;
+
+  // the point times are only known after the first sample
+  EXPECT_FALSE(traj.sample_at(time_now, DEFAULT_INTERPOLATION, state, after_last_point));
+  ASSERT_TRUE(traj.sample(time_now, DEFAULT_INTERPOLATION, expected_state, start, end));
+  EXPECT_FALSE(traj.sample_at(
+    time_now - rclcpp::Duration::from_seconds(0.1), DEFAULT_INTERPOLATION, state,
+    after_last_point));
+
+  for (const auto method : {DEFAULT_INTERPOLATION, InterpolationMethod::NONE})
+  {
+    // before the first point, on the segments and after the trajectory
+    for (double t = 0.05; t < 4.0; t += 0.1)
+    {
+      const rclcpp::Time sample_time = time_now + rclcpp::Duration::from_seconds(t);
+      if (method == InterpolationMethod::NONE && t < 1.0)
+      {
+        EXPECT_FALSE(traj.sample_at(sample_time, method, state, after_last_point));
+        continue;
+      }
+      ASSERT_TRUE(traj.sample_at(sample_time, method, state, after_last_point));
+      ASSERT_TRUE(traj.sample(sample_time, method, expected_state, start, end));
+      EXPECT_EQ(end == traj.end(), after_last_point);
+      for (size_t j = 0; j < 2; ++j)
+      {
+        EXPECT_NEAR(expected_state.positions[j], state.positions[j], EPS);
+        EXPECT_NEAR(expected_state.velocities[j], state.velocities[j], EPS);
+      }
+    }
+  }
+
+  // missing positions are deduced while sampling, which changes the points
+  full_msg->points[1].positions.clear();
+  traj.update(full_msg);
+  ASSERT_TRUE(traj.sample(time_now, DEFAULT_INTERPOLATION, expected_state, start, end));
+  EXPECT_FALSE(traj.sample_at(time_now, DEFAULT_INTERPOLATION, state, after_last_point));
+}
+
+TEST(TestTrajectory, splice_trajectory_msg)
+{
+  auto make_point = [](double position, double time)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {position};
+    p.time_from_start = rclcpp::Duration::from_seconds(time);
+    return p;
+  };
+
+  trajectory_msgs::msg::JointTrajectory msg;
+  for (size_t i = 1; i <= 5; ++i)
+  {
+    const double t = static_cast<double>(i);
+    msg.points.push_back(make_point(t, t));
+  }
+
+  trajectory_msgs::msg::JointTrajectory chunk;
+  chunk.points.push_back(make_point(10.0, 0.5));
+  chunk.points.push_back(make_point(11.0, 1.5));
+
+  // the chunk starts at 3.5s, while the segment between 2s and 3s is executed
+  joint_trajectory_controller::splice_trajectory_msg(
+    msg, chunk, rclcpp::Duration::from_seconds(3.0), rclcpp::Duration::from_seconds(2.5));
+
+  ASSERT_EQ(4u, msg.points.size());
+  const std::vector<double> expected_positions = {2.0, 3.0, 10.0, 11.0};
+  const std::vector<double> expected_times = {2.0, 3.0, 3.5, 4.5};
+  for (size_t i = 0; i < msg.points.size(); ++i)
+  {
+    EXPECT_EQ(expected_positions[i], msg.points[i].positions[0]);
+    EXPECT_NEAR(
+      expected_times[i], rclcpp::Duration(msg.points[i].time_from_start).seconds(), EPS);
+  }
+
+  // a chunk starting before all points replaces them
+  joint_trajectory_controller::splice_trajectory_msg(
+    msg, chunk, rclcpp::Duration::from_seconds(0.0), rclcpp::Duration::from_seconds(0.0));
+  ASSERT_EQ(2u, msg.points.size());
+  EXPECT_EQ(10.0, msg.points[0].positions[0]);
+  EXPECT_EQ(11.0, msg.points[1].positions[0]);
+}
+
+TEST(TestTrajectory, simplify_trajectory_msg)
+{
+  // a ramp and a ramp twice as steep, both ending at 1s, sampled every millisecond
+  trajectory_msgs::msg::JointTrajectory msg;
+  for (size_t i = 1; i <= 2000; ++i)
+  {
+    const double t = 0.001 * static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {std::min(t, 1.0), 2.0 * std::min(t, 1.0)};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    msg.points.push_back(p);
+  }
+  auto with_effort = msg;
+  with_effort.points[1].effort = {0.0, 0.0};
+
+  // the segments are linear, only the corner is kept
+  EXPECT_EQ(1997u, joint_trajectory_controller::simplify_trajectory_msg(msg, {1e-9, 1e-9}));
+  ASSERT_EQ(3u, msg.points.size());
+  const std::vector<double> expected_times = {0.001, 1.0, 2.0};
+  for (size_t i = 0; i < msg.points.size(); ++i)
+  {
+    EXPECT_NEAR(
+      expected_times[i], rclcpp::Duration(msg.points[i].time_from_start).seconds(), EPS);
+  }
+
+  // the efforts would not be interpolated anymore
+  EXPECT_EQ(0u, joint_trajectory_controller::simplify_trajectory_msg(with_effort, {1.0, 1.0}));
+  EXPECT_EQ(2000u, with_effort.points.size());
+}
+
+TEST(TestTrajectory, simplify_trajectory_msg_within_tolerances)
+{
+  // a sine with its velocities, sampled every millisecond
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->header.stamp = rclcpp::Clock().now();
+  for (size_t i = 1; i <= 2000; ++i)
+  {
+    const double t = 0.001 * static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {std::sin(M_PI * t)};
+    p.velocities = {M_PI * std::cos(M_PI * t)};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    msg->points.push_back(p);
+  }
+  const auto original = *msg;
+  const double tolerance = 1e-4;
+  EXPECT_GT(joint_trajectory_controller::simplify_trajectory_msg(*msg, {tolerance}), 1900u);
+
+  // the splines through the kept points pass all points within the tolerance
+  const rclcpp::Time start = msg->header.stamp;
+  trajectory_msgs::msg::JointTrajectoryPoint state_before;
+  state_before.positions = {0.0};
+  state_before.velocities = {M_PI};
+  joint_trajectory_controller::Trajectory traj(start, state_before, msg);
+  trajectory_msgs::msg::JointTrajectoryPoint output;
+  joint_trajectory_controller::TrajectoryPointConstIter start_itr, end_itr;
+  for (const auto & point : original.points)
+  {
+    ASSERT_TRUE(traj.sample(
+      start + point.time_from_start, DEFAULT_INTERPOLATION, output, start_itr, end_itr));
+    EXPECT_NEAR(point.positions[0], output.positions[0], tolerance + EPS);
+  }
+}
+
+TEST(TestTrajectory, single_precision_samples_close_to_double_precision)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->header.stamp = rclcpp::Clock().now();
+  for (size_t i = 1; i <= 20; ++i)
+  {
+    const double t = 0.1 * static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {10.0 * std::sin(t), -3.0 + t};
+    p.velocities = {10.0 * std::cos(t), 1.0};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    msg->points.push_back(p);
+  }
+  const rclcpp::Time start = msg->header.stamp;
+  trajectory_msgs::msg::JointTrajectoryPoint state_before;
+  state_before.positions = {0.0, -3.0};
+  state_before.velocities = {10.0, 1.0};
+  joint_trajectory_controller::Trajectory traj(start, state_before, msg);
+  joint_trajectory_controller::Trajectory single_traj;
+  single_traj.set_single_precision(true);
+  single_traj.update(msg);
+  single_traj.set_point_before_trajectory_msg(start, state_before);
+  ASSERT_TRUE(single_traj.is_single_precision());
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected, output;
+  joint_trajectory_controller::TrajectoryPointConstIter start_itr, end_itr;
+  // within the first segment, the others, at the points and after the last point
+  for (const double t : {0.05, 0.1, 0.55, 1.0, 1.37, 1.99, 2.0, 2.5})
+  {
+    SCOPED_TRACE("t " + std::to_string(t));
+    const auto time = start + rclcpp::Duration::from_seconds(t);
+    ASSERT_TRUE(traj.sample(time, DEFAULT_INTERPOLATION, expected, start_itr, end_itr));
+    ASSERT_TRUE(single_traj.sample(time, DEFAULT_INTERPOLATION, output, start_itr, end_itr));
+    for (size_t j = 0; j < 2; ++j)
+    {
+      EXPECT_NEAR(expected.positions[j], output.positions[j], 1e-5);
+      EXPECT_NEAR(expected.velocities[j], output.velocities[j], 1e-4);
+    }
+  }
+}
+
+TEST(TestTrajectory, progressive_compilation_holds_at_segments_not_compiled)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->header.stamp = rclcpp::Time(0);
+  for (size_t i = 1; i <= 5; ++i)
+  {
+    const double t = static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {t, -t * t};
+    p.velocities = {1.0, -2.0 * t};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    msg->points.push_back(p);
+  }
+  trajectory_msgs::msg::JointTrajectoryPoint state_before;
+  state_before.positions = {0.0, 0.0};
+  state_before.velocities = {0.0, 0.0};
+
+  const rclcpp::Time start = rclcpp::Clock().now();
+  joint_trajectory_controller::Trajectory full_traj(start, state_before, msg);
+  ASSERT_TRUE(full_traj.is_fully_compiled());
+  joint_trajectory_controller::Trajectory traj;
+  traj.set_progressive_compilation(2);
+  traj.update(msg);
+  traj.set_point_before_trajectory_msg(start, state_before);
+  EXPECT_FALSE(traj.is_fully_compiled());
+
+  trajectory_msgs::msg::JointTrajectoryPoint expected, output;
+  joint_trajectory_controller::TrajectoryPointConstIter start_itr, end_itr;
+  auto expect_near = [&expected, &output]()
+  {
+    for (size_t j = 0; j < 2; ++j)
+    {
+      EXPECT_NEAR(expected.positions[j], output.positions[j], EPS);
+      EXPECT_NEAR(expected.velocities[j], output.velocities[j], EPS);
+    }
+  };
+  // before the first point and on the segments compiled by update()
+  for (const double t : {0.5, 1.5, 2.5})
+  {
+    SCOPED_TRACE("t " + std::to_string(t));
+    const auto time = start + rclcpp::Duration::from_seconds(t);
+    ASSERT_TRUE(full_traj.sample(time, DEFAULT_INTERPOLATION, expected, start_itr, end_itr));
+    ASSERT_TRUE(traj.sample(time, DEFAULT_INTERPOLATION, output, start_itr, end_itr));
+    expect_near();
+  }
+
+  // the third segment is not compiled, the point it starts from is held at rest
+  ASSERT_TRUE(traj.sample(
+    start + rclcpp::Duration::from_seconds(3.5), DEFAULT_INTERPOLATION, output, start_itr,
+    end_itr));
+  EXPECT_EQ(start_itr, traj.begin() + 2);
+  EXPECT_NEAR(output.positions[0], 3.0, EPS);
+  EXPECT_NEAR(output.positions[1], -9.0, EPS);
+  EXPECT_EQ(output.velocities[0], 0.0);
+  EXPECT_EQ(output.velocities[1], 0.0);
+  EXPECT_EQ(traj.get_hold_duration(), rclcpp::Duration::from_seconds(0.5));
+  bool after_last_point = false;
+  EXPECT_FALSE(traj.sample_at(
+    start + rclcpp::Duration::from_seconds(3.6), DEFAULT_INTERPOLATION, output,
+    after_last_point));
+
+  EXPECT_FALSE(traj.compile_segments(1));
+  EXPECT_TRUE(traj.compile_segments(10));
+  EXPECT_TRUE(traj.is_fully_compiled());
+
+  // it continues from the held point, and reaches the other points later by the time held
+  const auto held = rclcpp::Duration::from_seconds(0.5);
+  for (const double t : {3.5, 4.25, 6.0})
+  {
+    SCOPED_TRACE("t " + std::to_string(t));
+    const auto time = start + rclcpp::Duration::from_seconds(t);
+    ASSERT_TRUE(full_traj.sample(time, DEFAULT_INTERPOLATION, expected, start_itr, end_itr));
+    ASSERT_TRUE(traj.sample(time + held, DEFAULT_INTERPOLATION, output, start_itr, end_itr));
+    expect_near();
+  }
+  EXPECT_EQ(end_itr, traj.end());
+}
+
+TEST(TestTrajectory, continue_spliced_trajectory)
+{
+  auto full_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  full_msg->header.stamp = rclcpp::Time(0);
+  for (size_t i = 1; i <= 3; ++i)
+  {
+    const double t = static_cast<double>(i);
+    trajectory_msgs::msg::JointTrajectoryPoint p;
+    p.positions = {t};
+    p.velocities = {1.0};
+    p.time_from_start = rclcpp::Duration::from_seconds(t);
+    full_msg->points.push_back(p);
+  }
+
+  trajectory_msgs::msg::JointTrajectoryPoint point_before_msg;
+  point_before_msg.positions = {0.0};
+  point_before_msg.velocities = {0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, point_before_msg, full_msg);
+
+  trajectory_msgs::msg::JointTrajectoryPoint output, spliced_output;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  const rclcpp::Time sample_time = time_now + rclcpp::Duration::from_seconds(1.5);
+  ASSERT_TRUE(traj.sample(time_now, DEFAULT_INTERPOLATION, output, start, end));
+  ASSERT_TRUE(traj.sample(sample_time, DEFAULT_INTERPOLATION, output, start, end));
+
+  // a chunk continuing after the last point
+  trajectory_msgs::msg::JointTrajectory chunk;
+  trajectory_msgs::msg::JointTrajectoryPoint p;
+  p.positions = {4.0};
+  p.velocities = {1.0};
+  p.time_from_start = rclcpp::Duration::from_seconds(1.0);
+  chunk.points.push_back(p);
+
+  auto spliced_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*full_msg);
+  joint_trajectory_controller::splice_trajectory_msg(
+    *spliced_msg, chunk, rclcpp::Duration::from_seconds(3.0),
+    rclcpp::Duration::from_seconds(1.5));
+  ASSERT_EQ(4u, spliced_msg->points.size());
+
+  joint_trajectory_controller::Trajectory spliced_traj;
+  spliced_traj.update(spliced_msg);
+  spliced_traj.continue_from(traj);
+  EXPECT_TRUE(spliced_traj.is_sampled_already());
+  EXPECT_EQ(time_now, spliced_traj.get_trajectory_start_time());
+
+  // the spliced trajectory continues from the same state, without sampling the start again
+  ASSERT_TRUE(spliced_traj.sample(
+    sample_time, DEFAULT_INTERPOLATION, spliced_output, start, end));
+  EXPECT_NEAR(output.positions[0], spliced_output.positions[0], EPS);
+  EXPECT_NEAR(output.velocities[0], spliced_output.velocities[0], EPS);
+  EXPECT_EQ(spliced_traj.begin(), start);
+
+  ASSERT_TRUE(spliced_traj.sample(
+    time_now + rclcpp::Duration::from_seconds(4.0), DEFAULT_INTERPOLATION, spliced_output, start,
+    end));
+  EXPECT_NEAR(4.0, spliced_output.positions[0], EPS);
+}
+
+namespace
+{
+/// Sample \p msg after time-parameterizing it and check the velocity and acceleration limits
+void expect_within_limits(
+  std::shared_ptr<trajectory_msgs::msg::JointTrajectory> msg,
+  const std::vector<joint_trajectory_controller::MotionLimits> & limits, double end_time)
+{
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  auto traj = joint_trajectory_controller::Trajectory(time_now, msg->points[0], msg);
+  trajectory_msgs::msg::JointTrajectoryPoint output;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  for (double t = 0.0; t < end_time + 0.5; t += 0.01)
+  {
+    ASSERT_TRUE(traj.sample(
+      time_now + rclcpp::Duration::from_seconds(t), DEFAULT_INTERPOLATION, output, start, end));
+    for (size_t i = 0; i < limits.size(); ++i)
+    {
+      EXPECT_LE(std::abs(output.velocities[i]), limits[i].max_velocity + 1e-6) << "at " << t;
+      EXPECT_LE(std::abs(output.accelerations[i]), limits[i].max_acceleration + 1e-6)
+        << "at " << t;
+    }
+  }
+  const auto & last_point = msg->points.back();
+  for (size_t i = 0; i < limits.size(); ++i)
+  {
+    EXPECT_NEAR(last_point.positions[i], output.positions[i], EPS);
+    EXPECT_NEAR(0.0, output.velocities[i], EPS);
+  }
+}
+}  // namespace
+
+TEST(TestTrajectory, time_parameterize_minimum_jerk)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->points.resize(2);
+  msg->points[0].positions = {0.0, 0.0};
+  msg->points[0].velocities = {0.5, 0.5};
+  msg->points[0].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  msg->points[1].positions = {1.0, 2.0};
+  msg->points[1].time_from_start = rclcpp::Duration::from_seconds(2.0);
+
+  // the second joint needs 15/8 * 2.0 / 1.0 seconds at its velocity limit
+  const std::vector<joint_trajectory_controller::MotionLimits> limits = {{1.0, 10.0}, {1.0, 10.0}};
+  joint_trajectory_controller::time_parameterize_trajectory_msg(
+    *msg, InterpolationMethod::MINIMUM_JERK, limits);
+
+  ASSERT_EQ(2u, msg->points.size());
+  EXPECT_NEAR(1.0, rclcpp::Duration(msg->points[0].time_from_start).seconds(), EPS);
+  EXPECT_NEAR(4.75, rclcpp::Duration(msg->points[1].time_from_start).seconds(), EPS);
+  for (const auto & point : msg->points)
+  {
+    EXPECT_EQ(std::vector<double>({0.0, 0.0}), point.velocities);
+    EXPECT_EQ(std::vector<double>({0.0, 0.0}), point.accelerations);
+  }
+  expect_within_limits(msg, limits, 4.75);
+
+  // the segments are not shortened, if the limits allow it
+  msg->points[1].time_from_start = rclcpp::Duration::from_seconds(6.0);
+  joint_trajectory_controller::time_parameterize_trajectory_msg(
+    *msg, InterpolationMethod::MINIMUM_JERK, limits);
+  EXPECT_NEAR(6.0, rclcpp::Duration(msg->points[1].time_from_start).seconds(), EPS);
+}
+
+TEST(TestTrajectory, time_parameterize_trapezoidal)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->points.resize(3);
+  msg->points[0].positions = {0.0};
+  msg->points[0].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  msg->points[1].positions = {2.0};
+  msg->points[1].time_from_start = rclcpp::Duration::from_seconds(1.5);
+  // the maximum velocity is not reached on short segments
+  msg->points[2].positions = {1.5};
+  msg->points[2].time_from_start = rclcpp::Duration::from_seconds(1.6);
+
+  const std::vector<joint_trajectory_controller::MotionLimits> limits = {{1.0, 1.0}};
+  joint_trajectory_controller::time_parameterize_trajectory_msg(
+    *msg, InterpolationMethod::TRAPEZOIDAL, limits);
+
+  // ends of the acceleration and deceleration phase of the first segment, and the middle of the
+  // second one
+  const std::vector<double> expected_positions = {0.0, 0.5, 1.5, 2.0, 1.75, 1.5};
+  const std::vector<double> expected_velocities = {0.0, 1.0, 1.0, 0.0, -std::sqrt(0.5), 0.0};
+  const std::vector<double> expected_times = {
+    1.0, 2.0, 3.0, 4.0, 4.0 + std::sqrt(0.5), 4.0 + 2.0 * std::sqrt(0.5)};
+  ASSERT_EQ(expected_positions.size(), msg->points.size());
+  for (size_t k = 0; k < msg->points.size(); ++k)
+  {
+    SCOPED_TRACE("Point " + std::to_string(k));
+    EXPECT_NEAR(expected_positions[k], msg->points[k].positions[0], EPS);
+    EXPECT_NEAR(expected_velocities[k], msg->points[k].velocities[0], EPS);
+    EXPECT_TRUE(msg->points[k].accelerations.empty());
+    EXPECT_NEAR(
+      expected_times[k], rclcpp::Duration(msg->points[k].time_from_start).seconds(), 1e-6);
+  }
+  expect_within_limits(msg, limits, expected_times.back());
+}
+
+TEST(TestTrajectory, time_parameterize_keeps_splines)
+{
+  trajectory_msgs::msg::JointTrajectory msg;
+  msg.points.resize(2);
+  msg.points[0].positions = {0.0};
+  msg.points[0].velocities = {1.0};
+  msg.points[0].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  msg.points[1].positions = {10.0};
+  msg.points[1].velocities = {1.0};
+  msg.points[1].time_from_start = rclcpp::Duration::from_seconds(2.0);
+  const auto original_msg = msg;
+
+  joint_trajectory_controller::time_parameterize_trajectory_msg(
+    msg, DEFAULT_INTERPOLATION, {{1.0, 1.0}});
+  ASSERT_EQ(original_msg.points.size(), msg.points.size());
+  for (size_t k = 0; k < msg.points.size(); ++k)
+  {
+    EXPECT_EQ(original_msg.points[k].positions, msg.points[k].positions);
+    EXPECT_EQ(original_msg.points[k].velocities, msg.points[k].velocities);
+    EXPECT_EQ(
+      rclcpp::Duration(original_msg.points[k].time_from_start),
+      rclcpp::Duration(msg.points[k].time_from_start));
+  }
+}
+
+TEST(TestTrajectory, blend_into_first_segment)
+{
+  // positions only, i.e. linear segments
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->points.resize(2);
+  msg->points[0].positions = {1.0};
+  msg->points[0].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  msg->points[1].positions = {3.0};
+  msg->points[1].time_from_start = rclcpp::Duration::from_seconds(2.0);
+
+  // the state of the replaced trajectory
+  trajectory_msgs::msg::JointTrajectoryPoint state_before;
+  state_before.positions = {0.0};
+  state_before.velocities = {-0.5};
+  state_before.accelerations = {0.2};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  joint_trajectory_controller::Trajectory traj;
+  traj.update(msg);
+  traj.set_blend_before_trajectory_msg(time_now, state_before);
+
+  trajectory_msgs::msg::JointTrajectoryPoint output;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  auto sample = [&](double t)
+  {
+    EXPECT_TRUE(traj.sample(
+      time_now + rclcpp::Duration::from_seconds(t), DEFAULT_INTERPOLATION, output, start, end));
+  };
+
+  // starts with the state before
+  sample(0.0);
+  EXPECT_NEAR(0.0, output.positions[0], EPS);
+  EXPECT_NEAR(-0.5, output.velocities[0], EPS);
+  EXPECT_NEAR(0.2, output.accelerations[0], EPS);
+
+  // and joins the linear segment with its velocity and no acceleration
+  const double dt = 1e-6;
+  sample(1.0 - dt);
+  EXPECT_NEAR(1.0, output.positions[0], 1e-5);
+  EXPECT_NEAR(2.0, output.velocities[0], 1e-4);
+  EXPECT_NEAR(0.0, output.accelerations[0], 1e-3);
+  sample(1.0 + dt);
+  EXPECT_NEAR(2.0, output.velocities[0], EPS);
+  EXPECT_NEAR(0.0, output.accelerations[0], EPS);
+
+  // without blending, the linear segment to the first point ignores the velocity before
+  traj.set_point_before_trajectory_msg(time_now, state_before);
+  sample(0.0);
+  EXPECT_NEAR(1.0, output.velocities[0], EPS);
+
+  // a state without derivatives can't be blended from
+  state_before.accelerations.clear();
+  traj.set_blend_before_trajectory_msg(time_now, state_before);
+  sample(0.0);
+  EXPECT_NEAR(1.0, output.velocities[0], EPS);
+}
+
+TEST(TestTrajectory, blend_into_single_point)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->points.resize(1);
+  msg->points[0].positions = {1.0, -1.0};
+  msg->points[0].time_from_start = rclcpp::Duration::from_seconds(1.0);
+
+  trajectory_msgs::msg::JointTrajectoryPoint state_before;
+  state_before.positions = {0.0, 0.0};
+  state_before.velocities = {1.0, 1.0};
+  state_before.accelerations = {0.0, 0.0};
+
+  const rclcpp::Time time_now = rclcpp::Clock().now();
+  joint_trajectory_controller::Trajectory traj;
+  traj.update(msg);
+  traj.set_blend_before_trajectory_msg(time_now, state_before);
+
+  trajectory_msgs::msg::JointTrajectoryPoint output;
+  joint_trajectory_controller::TrajectoryPointConstIter start, end;
+  ASSERT_TRUE(traj.sample(time_now, DEFAULT_INTERPOLATION, output, start, end));
+  EXPECT_NEAR(1.0, output.velocities[1], EPS);
+
+  // the single point is reached at rest
+  ASSERT_TRUE(traj.sample(
+    time_now + rclcpp::Duration::from_seconds(1.0 - 1e-6), DEFAULT_INTERPOLATION, output, start,
+    end));
+  for (size_t i = 0; i < 2; ++i)
+  {
+    EXPECT_NEAR(msg->points[0].positions[i], output.positions[i], 1e-5);
+    EXPECT_NEAR(0.0, output.velocities[i], 1e-4);
+  }
+}
+
+TEST(TestTrajectory, heap_bytes_grow_with_the_points)
+{
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->joint_names = {"joint1", "joint2"};
+  msg->points.resize(2);
+  msg->points[0].positions = {0.0, 0.0};
+  msg->points[0].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  msg->points[1].positions = {1.0, 1.0};
+  msg->points[1].time_from_start = rclcpp::Duration::from_seconds(2.0);
+  joint_trajectory_controller::Trajectory trajectory(msg);
+  const size_t two_points_bytes = trajectory.heap_bytes();
+  // the msg with the positions of its points, besides the compiled points and coefficients
+  EXPECT_GE(
+    two_points_bytes, sizeof(trajectory_msgs::msg::JointTrajectory) +
+                        2 * sizeof(trajectory_msgs::msg::JointTrajectoryPoint) +
+                        4 * sizeof(double));
+
+  auto longer_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*msg);
+  longer_msg->points.push_back(msg->points[1]);
+  longer_msg->points[2].time_from_start = rclcpp::Duration::from_seconds(3.0);
+  joint_trajectory_controller::Trajectory longer_trajectory(longer_msg);
+  EXPECT_GT(longer_trajectory.heap_bytes(), two_points_bytes);
+}
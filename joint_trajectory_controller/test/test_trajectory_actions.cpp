@@ -16,6 +16,7 @@
 #include <cxxabi.h>
 #endif
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <future>
@@ -29,6 +30,7 @@
 
 #include "action_msgs/msg/goal_status_array.hpp"
 #include "control_msgs/action/detail/follow_joint_trajectory__struct.hpp"
+#include "control_msgs/msg/dynamic_joint_state.hpp"
 #include "controller_interface/controller_interface.hpp"
 #include "gtest/gtest.h"
 #include "hardware_interface/resource_manager.hpp"
@@ -66,13 +68,19 @@ protected:
     goal_options_.feedback_callback = nullptr;
   }
 
-  void SetUpExecutor(const std::vector<rclcpp::Parameter> & parameters = {})
+  void SetUpExecutor(
+    const std::vector<rclcpp::Parameter> & parameters = {},
+    bool separate_cmd_and_state_values = false, bool set_up_action_client = true)
   {
     setup_executor_ = true;
 
-    SetUpAndActivateTrajectoryController(executor_, true, parameters);
+    SetUpAndActivateTrajectoryController(
+      executor_, true, parameters, separate_cmd_and_state_values);
 
-    SetUpActionClient();
+    if (set_up_action_client)
+    {
+      SetUpActionClient();
+    }
 
     executor_.add_node(node_->get_node_base_interface());
 
@@ -101,18 +109,22 @@ protected:
     std::this_thread::sleep_for(std::chrono::milliseconds(300));
   }
 
-  void SetUpActionClient()
+  void SetUpActionClient() { action_client_ = CreateActionClient("follow_joint_trajectory"); }
+
+  rclcpp_action::Client<control_msgs::action::FollowJointTrajectory>::SharedPtr
+  CreateActionClient(const std::string & action_name)
   {
-    action_client_ = rclcpp_action::create_client<control_msgs::action::FollowJointTrajectory>(
+    auto action_client = rclcpp_action::create_client<control_msgs::action::FollowJointTrajectory>(
       node_->get_node_base_interface(), node_->get_node_graph_interface(),
       node_->get_node_logging_interface(), node_->get_node_waitables_interface(),
-      controller_name_ + "/follow_joint_trajectory");
+      controller_name_ + "/" + action_name);
 
-    bool response = action_client_->wait_for_action_server(std::chrono::seconds(1));
+    bool response = action_client->wait_for_action_server(std::chrono::seconds(1));
     if (!response)
     {
       throw std::runtime_error("could not get action server");
     }
+    return action_client;
   }
 
   static void TearDownTestCase() { rclcpp::shutdown(); }
@@ -368,6 +380,49 @@ TEST_F(TestTrajectoryActions, test_goal_tolerances_multi_point_success)
   EXPECT_NEAR(9.0, joint_pos_[2], COMMON_THRESHOLD);
 }
 
+TEST_F(TestTrajectoryActions, test_feedback_decimated)
+{
+  // update the feedback much slower than the actions are monitored
+  std::vector<rclcpp::Parameter> params = {rclcpp::Parameter("action_feedback_rate", 2.0)};
+
+  SetUpExecutor(params);
+  SetUpControllerHardware();
+
+  std::atomic<int> feedback_count{0};
+  goal_options_.feedback_callback =
+    [&](
+      rclcpp_action::ClientGoalHandle<FollowJointTrajectoryMsg>::SharedPtr,
+      const std::shared_ptr<const FollowJointTrajectoryMsg::Feedback> feedback)
+  {
+    EXPECT_EQ(joint_names_, feedback->joint_names);
+    EXPECT_EQ(joint_names_.size(), feedback->desired.positions.size());
+    ++feedback_count;
+  };
+
+  std::shared_future<typename GoalHandle::SharedPtr> gh_future;
+  // send goal
+  {
+    std::vector<JointTrajectoryPoint> points;
+    JointTrajectoryPoint point;
+    point.time_from_start = rclcpp::Duration::from_seconds(1.0);
+    point.positions.resize(joint_names_.size());
+
+    point.positions[0] = 1.0;
+    point.positions[1] = 2.0;
+    point.positions[2] = 3.0;
+    points.push_back(point);
+
+    gh_future = sendActionGoal(points, 1.0, goal_options_);
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, common_resultcode_);
+  // the goal was executed for about one second, monitoring at 20 Hz would publish ~20 feedbacks
+  EXPECT_GE(feedback_count, 1);
+  EXPECT_LE(feedback_count, 4);
+}
+
 TEST_F(TestTrajectoryActions, test_state_tolerances_fail)
 {
   // set joint tolerance parameters
@@ -432,7 +487,8 @@ TEST_F(TestTrajectoryActions, test_goal_tolerances_fail)
     rclcpp::Parameter("constraints.joint3.goal", goal_tol),
     rclcpp::Parameter("constraints.goal_time", goal_time)};
 
-  SetUpExecutor(params);
+  // the joints don't follow the commands, so the goal can't be reached in time
+  SetUpExecutor(params, true);
   SetUpControllerHardware();
 
   const double init_pos1 = joint_pos_[0];
@@ -565,3 +621,175 @@ TEST_F(TestTrajectoryActions, test_cancel_hold_position)
   EXPECT_EQ(prev_pos2, joint_pos_[1]);
   EXPECT_EQ(prev_pos3, joint_pos_[2]);
 }
+
+TEST_F(TestTrajectoryActions, test_queued_goal_starts_after_active_goal)
+{
+  rclcpp::Parameter queue_goals("queue_goals", true);
+  SetUpExecutor({queue_goals});
+  SetUpControllerHardware();
+
+  std::vector<rclcpp_action::ResultCode> resultcodes(2, rclcpp_action::ResultCode::UNKNOWN);
+  std::vector<std::shared_future<typename GoalHandle::SharedPtr>> gh_futures;
+  for (size_t goal = 0; goal < 2; ++goal)
+  {
+    std::vector<JointTrajectoryPoint> points;
+    JointTrajectoryPoint point;
+    point.time_from_start = rclcpp::Duration::from_seconds(0.3);
+    point.positions.resize(joint_names_.size());
+
+    point.positions[0] = 1.0 + 3.0 * static_cast<double>(goal);
+    point.positions[1] = 2.0 + 3.0 * static_cast<double>(goal);
+    point.positions[2] = 3.0 + 3.0 * static_cast<double>(goal);
+    points.push_back(point);
+
+    GoalOptions goal_options;
+    goal_options.result_callback = [&resultcodes, goal](const GoalHandle::WrappedResult & result)
+    { resultcodes[goal] = result.code; };
+    // the second goal is queued behind the first one instead of preempting it
+    gh_futures.push_back(sendActionGoal(points, 1.0, goal_options));
+    gh_futures.back().wait();
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_futures[0].get());
+  EXPECT_TRUE(gh_futures[1].get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, resultcodes[0]);
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, resultcodes[1]);
+
+  EXPECT_NEAR(4.0, joint_pos_[0], COMMON_THRESHOLD);
+  EXPECT_NEAR(5.0, joint_pos_[1], COMMON_THRESHOLD);
+  EXPECT_NEAR(6.0, joint_pos_[2], COMMON_THRESHOLD);
+}
+
+TEST_F(TestTrajectoryActions, test_joint_groups_execute_goals_independently)
+{
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("joint_groups", std::vector<std::string>{"arm", "wrist"}),
+    rclcpp::Parameter("groups.arm.joints", std::vector<std::string>{"joint1", "joint2"}),
+    rclcpp::Parameter("groups.wrist.joints", std::vector<std::string>{"joint3"})};
+  SetUpExecutor(params, false, false);
+  const std::vector<std::vector<std::string>> group_joints = {
+    {joint_names_[0], joint_names_[1]}, {joint_names_[2]}};
+  const std::vector<rclcpp_action::Client<FollowJointTrajectoryMsg>::SharedPtr> clients = {
+    CreateActionClient("arm/follow_joint_trajectory"),
+    CreateActionClient("wrist/follow_joint_trajectory")};
+  SetUpControllerHardware();
+
+  std::vector<rclcpp_action::ResultCode> resultcodes(2, rclcpp_action::ResultCode::UNKNOWN);
+  std::vector<std::shared_future<typename GoalHandle::SharedPtr>> gh_futures;
+  for (size_t group = 0; group < 2; ++group)
+  {
+    FollowJointTrajectoryMsg::Goal goal_msg;
+    goal_msg.trajectory.joint_names = group_joints[group];
+    JointTrajectoryPoint point;
+    // the goals overlap, neither preempts the other
+    point.time_from_start = rclcpp::Duration::from_seconds(0.2 + 0.2 * static_cast<double>(group));
+    for (size_t joint = 0; joint < group_joints[group].size(); ++joint)
+    {
+      point.positions.push_back(1.0 + static_cast<double>(2 * group + joint));
+    }
+    goal_msg.trajectory.points.push_back(point);
+
+    GoalOptions goal_options;
+    goal_options.result_callback = [&resultcodes, group](const GoalHandle::WrappedResult & result)
+    { resultcodes[group] = result.code; };
+    gh_futures.push_back(clients[group]->async_send_goal(goal_msg, goal_options));
+    gh_futures.back().wait();
+  }
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_futures[0].get());
+  EXPECT_TRUE(gh_futures[1].get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, resultcodes[0]);
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, resultcodes[1]);
+
+  EXPECT_NEAR(1.0, joint_pos_[0], COMMON_THRESHOLD);
+  EXPECT_NEAR(2.0, joint_pos_[1], COMMON_THRESHOLD);
+  EXPECT_NEAR(3.0, joint_pos_[2], COMMON_THRESHOLD);
+}
+
+TEST_F(TestTrajectoryActions, test_trajectory_file_executed_in_windows)
+{
+  // the joints of the file are in another order than those of the controller
+  trajectory_msgs::msg::JointTrajectory file_trajectory;
+  file_trajectory.joint_names = {joint_names_[2], joint_names_[1], joint_names_[0]};
+  for (size_t index = 1; index <= 20; ++index)
+  {
+    const double ratio = static_cast<double>(index) / 20.0;
+    JointTrajectoryPoint point;
+    point.time_from_start = rclcpp::Duration::from_seconds(ratio);
+    point.positions = {3.0 * ratio, 2.0 * ratio, 1.0 * ratio};
+    file_trajectory.points.push_back(point);
+  }
+  std::string error;
+  const std::string directory = testing::TempDir();
+  ASSERT_TRUE(joint_trajectory_controller::TrajectoryFile::write(
+    directory + "/test_trajectory_file_executed_in_windows.jtctraj", file_trajectory, error))
+    << error;
+
+  const std::vector<rclcpp::Parameter> params = {
+    rclcpp::Parameter("trajectory_files.directory", directory),
+    rclcpp::Parameter("trajectory_files.window_size", 2),
+    rclcpp::Parameter("trajectory_files.lookahead", 0.2)};
+  SetUpExecutor(params);
+  SetUpControllerHardware();
+
+  FollowJointTrajectoryMsg::Goal goal_msg;
+  goal_msg.trajectory.header.frame_id = "file:test_trajectory_file_executed_in_windows.jtctraj";
+  auto gh_future = action_client_->async_send_goal(goal_msg, goal_options_);
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, common_resultcode_);
+
+  EXPECT_NEAR(1.0, joint_pos_[0], COMMON_THRESHOLD);
+  EXPECT_NEAR(2.0, joint_pos_[1], COMMON_THRESHOLD);
+  EXPECT_NEAR(3.0, joint_pos_[2], COMMON_THRESHOLD);
+}
+
+TEST_F(TestTrajectoryActions, test_tracking_error_statistics_published_per_goal)
+{
+  SetUpExecutor({rclcpp::Parameter("tracking_error_statistics.enable", true)});
+
+  std::promise<control_msgs::msg::DynamicJointState> statistics_promise;
+  auto statistics_future = statistics_promise.get_future();
+  std::atomic<bool> received{false};
+  auto subscription = node_->create_subscription<control_msgs::msg::DynamicJointState>(
+    controller_name_ + "/tracking_error", rclcpp::SystemDefaultsQoS(),
+    [&](const control_msgs::msg::DynamicJointState::SharedPtr msg)
+    {
+      if (!received.exchange(true))
+      {
+        statistics_promise.set_value(*msg);
+      }
+    });
+  SetUpControllerHardware();
+
+  std::vector<JointTrajectoryPoint> points;
+  JointTrajectoryPoint point;
+  point.time_from_start = rclcpp::Duration::from_seconds(0.5);
+  point.positions = {1.0, 2.0, 3.0};
+  points.push_back(point);
+  auto gh_future = sendActionGoal(points, 1.0, goal_options_);
+  controller_hw_thread_.join();
+
+  EXPECT_TRUE(gh_future.get());
+  EXPECT_EQ(rclcpp_action::ResultCode::SUCCEEDED, common_resultcode_);
+
+  // published once the goal is done
+  ASSERT_EQ(statistics_future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  const auto statistics = statistics_future.get();
+  EXPECT_EQ(statistics.joint_names, joint_names_);
+  ASSERT_EQ(statistics.interface_values.size(), joint_names_.size());
+  for (const auto & joint : statistics.interface_values)
+  {
+    const std::vector<std::string> names = {
+      "samples", "rms_error", "max_error", "time_of_max_error"};
+    EXPECT_EQ(joint.interface_names, names);
+    ASSERT_EQ(joint.values.size(), 4u);
+    EXPECT_GT(joint.values[0], 0.0);
+    EXPECT_GE(joint.values[1], 0.0);
+    EXPECT_GE(joint.values[2], joint.values[1]);
+    EXPECT_GE(joint.values[3], 0.0);
+  }
+}
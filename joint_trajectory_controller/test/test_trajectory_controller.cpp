@@ -14,11 +14,14 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <future>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <system_error>
@@ -30,6 +33,7 @@
 #include "builtin_interfaces/msg/duration.hpp"
 #include "builtin_interfaces/msg/time.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
 #include "hardware_interface/resource_manager.hpp"
 #include "joint_trajectory_controller/joint_trajectory_controller.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
@@ -47,6 +51,7 @@
 #include "rclcpp/utilities.hpp"
 #include "rclcpp_lifecycle/lifecycle_node.hpp"
 #include "rclcpp_lifecycle/state.hpp"
+#include "statistics_msgs/msg/metrics_message.hpp"
 #include "std_msgs/msg/header.hpp"
 #include "trajectory_msgs/msg/joint_trajectory.hpp"
 #include "trajectory_msgs/msg/joint_trajectory_point.hpp"
@@ -548,6 +553,683 @@ TEST_P(TrajectoryControllerTestParameterized, state_topic_consistency)
   }
 }
 
+/**
+ * @brief check that the controller state is published with state_publish_rate
+ */
+TEST_P(TrajectoryControllerTestParameterized, state_publish_rate)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("state_publish_rate", 10.0)});
+  subscribeToState();
+
+  auto spin_for_state = [&]()
+  {
+    {
+      std::lock_guard<std::mutex> guard(state_mutex_);
+      state_msg_.reset();
+    }
+    const auto end_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (!getState() && std::chrono::steady_clock::now() < end_time)
+    {
+      executor.spin_some();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return getState();
+  };
+
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  const rclcpp::Time start_time = rclcpp::Clock(RCL_STEADY_TIME).now();
+
+  // the first update publishes the state
+  traj_controller_->update(start_time, period);
+  auto state = spin_for_state();
+  ASSERT_TRUE(state);
+  EXPECT_EQ(start_time.nanoseconds(), rclcpp::Time(state->header.stamp).nanoseconds());
+
+  // no state in between
+  rclcpp::Time time = start_time;
+  for (size_t i = 1; i < 10; ++i)
+  {
+    time += period;
+    traj_controller_->update(time, period);
+  }
+  EXPECT_FALSE(spin_for_state());
+
+  // and the next one after the publish period
+  time += period;
+  traj_controller_->update(time, period);
+  state = spin_for_state();
+  ASSERT_TRUE(state);
+  EXPECT_EQ(time.nanoseconds(), rclcpp::Time(state->header.stamp).nanoseconds());
+}
+
+/**
+ * @brief check that the time of the cycle phases is published if enabled
+ */
+TEST_P(TrajectoryControllerTestParameterized, cycle_timing)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true,
+    {rclcpp::Parameter("cycle_timing.enable", true),
+     rclcpp::Parameter("cycle_timing.publish_rate", 20.0)});
+
+  std::mutex timing_mutex;
+  std::map<std::string, statistics_msgs::msg::MetricsMessage> timing_msgs;
+  auto timing_subscriber =
+    traj_controller_->get_node()->create_subscription<statistics_msgs::msg::MetricsMessage>(
+      controller_name_ + "/timing", rclcpp::SystemDefaultsQoS(),
+      [&](std::shared_ptr<statistics_msgs::msg::MetricsMessage> msg)
+      {
+        std::lock_guard<std::mutex> guard(timing_mutex);
+        // keep the first window, it covers all updates
+        timing_msgs.emplace(msg->metrics_source, *msg);
+      });
+
+  // executes the hold position trajectory
+  updateController(rclcpp::Duration::from_seconds(0.1));
+
+  const auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  auto received = [&]()
+  {
+    std::lock_guard<std::mutex> guard(timing_mutex);
+    return timing_msgs.count("read_state") > 0 && timing_msgs.count("publish_state") > 0;
+  };
+  while (!received() && std::chrono::steady_clock::now() < end_time)
+  {
+    executor.spin_some();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(received());
+
+  std::lock_guard<std::mutex> guard(timing_mutex);
+  for (const auto & phase : {"read_state", "sample", "write_commands", "publish_state"})
+  {
+    SCOPED_TRACE(phase);
+    ASSERT_EQ(1u, timing_msgs.count(phase));
+    const auto & msg = timing_msgs.at(phase);
+    EXPECT_EQ("ns", msg.unit);
+    ASSERT_FALSE(msg.statistics.empty());
+    EXPECT_EQ(
+      statistics_msgs::msg::StatisticDataType::STATISTICS_DATA_TYPE_SAMPLE_COUNT,
+      msg.statistics[0].data_type);
+  }
+  EXPECT_GT(timing_msgs.at("read_state").statistics[0].data, 0.0);
+}
+
+/**
+ * @brief check that the latency of a received trajectory is published if enabled
+ */
+TEST_P(TrajectoryControllerTestParameterized, command_latency)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true,
+    {rclcpp::Parameter("command_latency.enable", true),
+     rclcpp::Parameter("command_latency.publish_rate", 20.0)});
+
+  std::mutex latency_mutex;
+  std::map<std::string, statistics_msgs::msg::MetricsMessage> latency_msgs;
+  auto latency_subscriber =
+    traj_controller_->get_node()->create_subscription<statistics_msgs::msg::MetricsMessage>(
+      controller_name_ + "/command_latency", rclcpp::SystemDefaultsQoS(),
+      [&](std::shared_ptr<statistics_msgs::msg::MetricsMessage> msg)
+      {
+        std::lock_guard<std::mutex> guard(latency_mutex);
+        // keep the first window with a sample
+        if (!msg->statistics.empty() && msg->statistics[0].data > 0.0)
+        {
+          latency_msgs.emplace(msg->metrics_source, *msg);
+        }
+      });
+
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.25)};
+  std::vector<std::vector<double>> points{{{3.3, 4.4, 5.5}}};
+  publish(time_from_start, points, rclcpp::Time());
+  traj_controller_->wait_for_trajectory(executor);
+  updateController(rclcpp::Duration::from_seconds(0.1));
+
+  const auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  auto received = [&]()
+  {
+    std::lock_guard<std::mutex> guard(latency_mutex);
+    return latency_msgs.count("receive_to_write") > 0;
+  };
+  while (!received() && std::chrono::steady_clock::now() < end_time)
+  {
+    executor.spin_some();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_TRUE(received());
+
+  std::lock_guard<std::mutex> guard(latency_mutex);
+  const auto & msg = latency_msgs.at("receive_to_write");
+  EXPECT_EQ("ns", msg.unit);
+  // only the first cycle writing the trajectory is sampled
+  EXPECT_EQ(1.0, msg.statistics[0].data);
+  // trajectories have no publish stamp
+  EXPECT_EQ(0u, latency_msgs.count("publish_to_receive"));
+}
+
+/**
+ * @brief check that update() doesn't allocate or free memory and doesn't block on a lock while
+ * executing a trajectory
+ */
+TEST_P(TrajectoryControllerTestParameterized, update_is_realtime_safe)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(executor, true, {});
+
+  constexpr auto FIRST_POINT_TIME = std::chrono::milliseconds(250);
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration(FIRST_POINT_TIME)};
+  // *INDENT-OFF*
+  std::vector<std::vector<double>> points{
+    {{3.3, 4.4, 5.5}}, {{7.7, 8.8, 9.9}}, {{10.10, 11.11, 12.12}}};
+  std::vector<std::vector<double>> points_velocities{
+    {{0.01, 0.01, 0.01}}, {{0.05, 0.05, 0.05}}, {{0.0, 0.0, 0.0}}};
+  // *INDENT-ON*
+  publish(time_from_start, points, rclcpp::Time(), {}, points_velocities);
+  traj_controller_->wait_for_trajectory(executor);
+
+  // the first update takes over the new trajectory
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time = rclcpp::Clock(RCL_STEADY_TIME).now();
+  traj_controller_->update(time, period);
+
+  // sample the segments and after the end of the trajectory
+  controller_realtime_tools::ScopedRealtimeSafetyCounter counter;
+  for (size_t i = 0; i < 100; ++i)
+  {
+    time += period;
+    traj_controller_->update(time, period);
+  }
+  EXPECT_EQ(0u, counter.get_allocations());
+  EXPECT_EQ(0u, counter.get_deallocations());
+  EXPECT_EQ(0u, counter.get_locks());
+}
+
+/**
+ * @brief check that the memory footprint of the buffers and of the stored trajectories is
+ * reported
+ */
+TEST_P(TrajectoryControllerTestParameterized, memory_footprint_is_reported)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("stored_trajectories.max_count", 1)});
+  auto request = std::make_shared<std_srvs::srv::Trigger::Request>();
+  auto response = std::make_shared<std_srvs::srv::Trigger::Response>();
+
+  traj_controller_->get_memory_footprint(request, response);
+  // the allocations aren't counted without the preloaded library
+  EXPECT_TRUE(response->success);
+  EXPECT_THAT(response->message, testing::HasSubstr("states: "));
+  EXPECT_THAT(response->message, testing::HasSubstr("trajectory_pool: "));
+  EXPECT_THAT(response->message, testing::HasSubstr("stored_trajectories: 0 bytes"));
+
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->header.frame_id = "stored";
+  msg->joint_names = joint_names_;
+  msg->points.resize(2);
+  msg->points[0].positions = {1.0, 2.0, 3.0};
+  msg->points[0].time_from_start = rclcpp::Duration::from_seconds(0.5);
+  msg->points[1].positions = {2.0, 3.0, 4.0};
+  msg->points[1].time_from_start = rclcpp::Duration::from_seconds(1.0);
+  traj_controller_->store_trajectory_callback(msg);
+  trajectory_msgs::msg::JointTrajectory reference;
+  reference.header.frame_id = "stored";
+  ASSERT_TRUE(traj_controller_->find_stored_trajectory(reference));
+
+  traj_controller_->get_memory_footprint(request, response);
+  EXPECT_THAT(response->message, testing::HasSubstr("stored_trajectories: "));
+  EXPECT_THAT(
+    response->message, testing::Not(testing::HasSubstr("stored_trajectories: 0 bytes")));
+}
+
+/**
+ * @brief check that trajectories received on the topic are spliced into the executed one
+ */
+TEST_P(TrajectoryControllerTestParameterized, splice_topic_trajectories)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("splice_topic_trajectories", true)});
+
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.25)};
+  // *INDENT-OFF*
+  std::vector<std::vector<double>> points{
+    {{3.3, 4.4, 5.5}}, {{7.7, 8.8, 9.9}}, {{10.10, 11.11, 12.12}}};
+  // *INDENT-ON*
+  publish(time_from_start, points, rclcpp::Time());
+  traj_controller_->wait_for_trajectory(executor);
+
+  // execute the segment between the first and the second point
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  const rclcpp::Time start_time = rclcpp::Clock(RCL_STEADY_TIME).now();
+  rclcpp::Time time = start_time;
+  traj_controller_->update(time, period);
+  for (size_t i = 0; i < 30; ++i)
+  {
+    time += period;
+    traj_controller_->update(time, period);
+  }
+  const auto executed_trajectory = traj_controller_->get_traj_external_point_ptr();
+  const auto desired_before_splice = traj_controller_->get_state_desired();
+
+  // the chunk starts when it is received, replacing the third point
+  // *INDENT-OFF*
+  std::vector<std::vector<double>> chunk{{{1.0, 2.0, 3.0}}, {{4.0, 5.0, 6.0}}};
+  // *INDENT-ON*
+  publish(time_from_start, chunk, rclcpp::Time());
+  traj_controller_->wait_for_trajectory(executor);
+
+  // the spliced trajectory continues from the same state at the same time
+  traj_controller_->update(time, period);
+  const auto spliced_trajectory = traj_controller_->get_traj_external_point_ptr();
+  ASSERT_NE(executed_trajectory, spliced_trajectory);
+  EXPECT_EQ(start_time, spliced_trajectory->get_trajectory_start_time());
+  ASSERT_EQ(4u, spliced_trajectory->get_trajectory_msg()->points.size());
+  const auto desired_after_splice = traj_controller_->get_state_desired();
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(
+      desired_before_splice.positions[i], desired_after_splice.positions[i], COMMON_THRESHOLD);
+  }
+
+  // and ends at the last point of the chunk
+  traj_controller_->update(time + rclcpp::Duration::from_seconds(0.6), period);
+  const auto desired_at_end = traj_controller_->get_state_desired();
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(chunk[1][i], desired_at_end.positions[i], COMMON_THRESHOLD);
+  }
+}
+
+/**
+ * @brief check that the commands are sampled ahead of the desired state with command_lookahead
+ */
+TEST_P(TrajectoryControllerTestParameterized, command_lookahead)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("command_lookahead", 0.1)}, true);
+  if (!traj_controller_->has_position_command_interface())
+  {
+    return;
+  }
+
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.25)};
+  // *INDENT-OFF*
+  std::vector<std::vector<double>> points{
+    {{3.3, 4.4, 5.5}}, {{7.7, 8.8, 9.9}}, {{10.10, 11.11, 12.12}}};
+  // *INDENT-ON*
+  publish(time_from_start, points, rclcpp::Time());
+  traj_controller_->wait_for_trajectory(executor);
+
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time = rclcpp::Clock(RCL_STEADY_TIME).now();
+  traj_controller_->update(time, period);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    time += period;
+    traj_controller_->update(time, period);
+  }
+  const std::vector<double> commanded_positions = joint_pos_;
+  const auto desired_now = traj_controller_->get_state_desired();
+
+  // the commands are the desired state of 0.1 s later, the desired state isn't shifted
+  traj_controller_->update(time + rclcpp::Duration::from_seconds(0.1), period);
+  const auto desired_ahead = traj_controller_->get_state_desired();
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(desired_ahead.positions[i], commanded_positions[i], COMMON_THRESHOLD);
+    EXPECT_GT(desired_ahead.positions[i] - desired_now.positions[i], 0.1);
+  }
+}
+
+/**
+ * @brief check that stored trajectories are executed by reference
+ */
+TEST_P(TrajectoryControllerTestParameterized, execute_stored_trajectory)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("stored_trajectories.max_count", 1)});
+
+  // the joints are sorted when stored
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  msg->header.frame_id = "pick";
+  msg->joint_names = {joint_names_[2], joint_names_[0], joint_names_[1]};
+  msg->points.resize(2);
+  msg->points[0].positions = {3.3, 1.1, 2.2};
+  msg->points[0].time_from_start = rclcpp::Duration::from_seconds(0.25);
+  msg->points[1].positions = {6.6, 4.4, 5.5};
+  msg->points[1].time_from_start = rclcpp::Duration::from_seconds(0.5);
+  traj_controller_->store_trajectory_callback(msg);
+
+  // only one trajectory can be stored
+  auto other_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>(*msg);
+  other_msg->header.frame_id = "place";
+  traj_controller_->store_trajectory_callback(other_msg);
+  trajectory_msgs::msg::JointTrajectory reference;
+  reference.header.frame_id = "place";
+  EXPECT_FALSE(traj_controller_->find_stored_trajectory(reference));
+  reference.header.frame_id = "pick";
+  const auto stored_trajectory = traj_controller_->find_stored_trajectory(reference);
+  ASSERT_TRUE(stored_trajectory);
+
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time = rclcpp::Clock(RCL_STEADY_TIME).now();
+  for (size_t execution = 0; execution < 2; ++execution)
+  {
+    SCOPED_TRACE("Execution " + std::to_string(execution));
+    traj_controller_->topic_callback(
+      std::make_shared<trajectory_msgs::msg::JointTrajectory>(reference));
+    traj_controller_->update(time, period);
+    // a new instance sharing the stored msg
+    const auto executed_trajectory = traj_controller_->get_traj_external_point_ptr();
+    ASSERT_NE(stored_trajectory.get(), executed_trajectory.get());
+    EXPECT_EQ(stored_trajectory->get_trajectory_msg(), executed_trajectory->get_trajectory_msg());
+    EXPECT_EQ(time, executed_trajectory->get_trajectory_start_time());
+
+    time += rclcpp::Duration::from_seconds(0.6);
+    traj_controller_->update(time, period);
+    const auto desired_at_end = traj_controller_->get_state_desired();
+    for (size_t i = 0; i < joint_names_.size(); ++i)
+    {
+      EXPECT_NEAR(
+        4.4 + 1.1 * static_cast<double>(i), desired_at_end.positions[i], COMMON_THRESHOLD);
+    }
+  }
+
+  // a msg without points removes the stored trajectory
+  auto remove_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  remove_msg->header.frame_id = "pick";
+  traj_controller_->store_trajectory_callback(remove_msg);
+  EXPECT_FALSE(traj_controller_->find_stored_trajectory(reference));
+}
+
+/**
+ * @brief check that trajectories are preprocessed on the worker thread if enabled
+ */
+TEST_P(TrajectoryControllerTestParameterized, preprocessing_worker_thread)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("preprocessing.use_worker_thread", true)});
+
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.25)};
+  // the joints in a different order
+  // *INDENT-OFF*
+  std::vector<std::vector<double>> points{{{2.2, 1.1, 3.3}}, {{5.5, 4.4, 6.6}}};
+  // *INDENT-ON*
+  publish(
+    time_from_start, points, rclcpp::Time(), {joint_names_[1], joint_names_[0], joint_names_[2]});
+  traj_controller_->wait_for_trajectory(executor);
+  traj_controller_->wait_for_preprocessing();
+
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  const rclcpp::Time time = rclcpp::Clock(RCL_STEADY_TIME).now();
+  traj_controller_->update(time, period);
+  const auto trajectory = traj_controller_->get_traj_external_point_ptr();
+  ASSERT_TRUE(trajectory && trajectory->has_trajectory_msg());
+  const auto msg = trajectory->get_trajectory_msg();
+  EXPECT_EQ(joint_names_, msg->joint_names);
+  ASSERT_EQ(2u, msg->points.size());
+
+  traj_controller_->update(time + rclcpp::Duration::from_seconds(0.6), period);
+  const auto desired_at_end = traj_controller_->get_state_desired();
+  EXPECT_NEAR(4.4, desired_at_end.positions[0], COMMON_THRESHOLD);
+  EXPECT_NEAR(5.5, desired_at_end.positions[1], COMMON_THRESHOLD);
+  EXPECT_NEAR(6.6, desired_at_end.positions[2], COMMON_THRESHOLD);
+}
+
+/**
+ * @brief check that the sequence numbers of the commands are only counted up when they change
+ */
+TEST_P(TrajectoryControllerTestParameterized, command_sequences_count_changed_commands)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("command_sequence_interfaces", true)});
+  ASSERT_EQ(
+    traj_controller_->get_node()->get_current_state().id(),
+    lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE);
+  // the sequences of the first command interface type
+  const std::vector<std::string> types = {"position", "velocity", "acceleration", "effort"};
+  const auto type = std::find(types.begin(), types.end(), command_interface_types_[0]);
+  const size_t offset = static_cast<size_t>(type - types.begin()) * joint_names_.size();
+  auto sequence = [&](size_t joint) { return joint_cmd_sequences_[offset + joint]; };
+
+  // holding the position, the commands don't change after the first ones
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time = rclcpp::Clock(RCL_STEADY_TIME).now();
+  traj_controller_->update(time, period);
+  traj_controller_->update(time + period, period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_EQ(1.0, sequence(i));
+  }
+
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.25)};
+  std::vector<std::vector<double>> points{{{3.3, 4.4, 5.5}}};
+  publish(time_from_start, points, rclcpp::Time());
+  traj_controller_->wait_for_trajectory(executor);
+  time += rclcpp::Duration::from_seconds(0.1);
+  traj_controller_->update(time, period);
+  traj_controller_->update(time + period, period);
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_LT(1.0, sequence(i));
+  }
+}
+
+/**
+ * @brief check that the references of a preceding controller are followed in chained mode
+ */
+TEST_P(TrajectoryControllerTestParameterized, chained_mode_follows_references)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpTrajectoryController(executor);
+  SetPidParameters();
+  traj_controller_->get_node()->configure();
+
+  auto reference_interfaces = traj_controller_->export_reference_interfaces();
+  ASSERT_EQ(2 * joint_names_.size(), reference_interfaces.size());
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_EQ(
+      controller_name_ + "/" + joint_names_[i] + "/position",
+      reference_interfaces[i].get_name());
+    EXPECT_EQ(
+      controller_name_ + "/" + joint_names_[i] + "/velocity",
+      reference_interfaces[joint_names_.size() + i].get_name());
+  }
+  ASSERT_TRUE(traj_controller_->set_chained_mode(true));
+  ActivateTrajectoryController();
+  ASSERT_TRUE(traj_controller_->is_in_chained_mode());
+  const auto trajectory_before = traj_controller_->get_traj_external_point_ptr();
+
+  const rclcpp::Duration period = rclcpp::Duration::from_seconds(0.01);
+  rclcpp::Time time = rclcpp::Clock(RCL_STEADY_TIME).now();
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    reference_interfaces[i].set_value(1.0 + static_cast<double>(i));
+    reference_interfaces[joint_names_.size() + i].set_value(0.5);
+  }
+  traj_controller_->update(time, period);
+  auto desired = traj_controller_->get_state_desired();
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(1.0 + static_cast<double>(i), desired.positions[i], COMMON_THRESHOLD);
+    EXPECT_NEAR(0.5, desired.velocities[i], COMMON_THRESHOLD);
+    if (traj_controller_->has_position_command_interface())
+    {
+      EXPECT_NEAR(1.0 + static_cast<double>(i), joint_pos_[i], COMMON_THRESHOLD);
+    }
+  }
+
+  // without position references the velocity references are integrated
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    reference_interfaces[i].set_value(std::numeric_limits<double>::quiet_NaN());
+  }
+  time += period;
+  traj_controller_->update(time, period);
+  desired = traj_controller_->get_state_desired();
+  for (size_t i = 0; i < joint_names_.size(); ++i)
+  {
+    EXPECT_NEAR(1.005 + static_cast<double>(i), desired.positions[i], COMMON_THRESHOLD);
+  }
+
+  // trajectories are ignored meanwhile
+  builtin_interfaces::msg::Duration time_from_start{rclcpp::Duration::from_seconds(0.25)};
+  // *INDENT-OFF*
+  std::vector<std::vector<double>> points{{{3.3, 4.4, 5.5}}};
+  // *INDENT-ON*
+  publish(time_from_start, points, rclcpp::Time());
+  traj_controller_->wait_for_trajectory(executor);
+  traj_controller_->update(time + period, period);
+  EXPECT_EQ(trajectory_before, traj_controller_->get_traj_external_point_ptr());
+}
+
+/**
+ * @brief check that partial trajectories with a different joint order are mapped to the local one
+ */
+TEST_P(TrajectoryControllerTestParameterized, fill_and_sort_partial_jumbled_goal)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("allow_partial_joints_goal", true)});
+
+  auto traj_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  traj_msg->joint_names = {joint_names_[2], joint_names_[0]};
+  traj_msg->points.resize(1);
+  traj_msg->points[0].positions = {3.0, 1.0};
+  traj_msg->points[0].velocities = {0.3, 0.1};
+  ASSERT_TRUE(traj_controller_->validate_trajectory_msg(*traj_msg));
+
+  traj_controller_->fill_partial_goal(traj_msg);
+  traj_controller_->sort_to_local_joint_order(traj_msg);
+  const auto & point = traj_msg->points[0];
+  ASSERT_EQ(3u, point.positions.size());
+  EXPECT_EQ(1.0, point.positions[0]);
+  EXPECT_NEAR(INITIAL_POS_JOINT2, point.positions[1], COMMON_THRESHOLD);
+  EXPECT_EQ(3.0, point.positions[2]);
+  ASSERT_EQ(3u, point.velocities.size());
+  EXPECT_EQ(0.1, point.velocities[0]);
+  EXPECT_EQ(0.0, point.velocities[1]);
+  EXPECT_EQ(0.3, point.velocities[2]);
+
+  // a msg in the local joint order is kept as it is
+  auto ordered_msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  ordered_msg->joint_names = joint_names_;
+  ordered_msg->points.resize(1);
+  ordered_msg->points[0].positions = {1.0, 2.0, 3.0};
+  traj_controller_->fill_partial_goal(ordered_msg);
+  traj_controller_->sort_to_local_joint_order(ordered_msg);
+  EXPECT_EQ(joint_names_, ordered_msg->joint_names);
+  EXPECT_EQ(std::vector<double>({1.0, 2.0, 3.0}), ordered_msg->points[0].positions);
+
+  // joints unknown to the controller are rejected
+  ordered_msg->joint_names[1] = "unknown_joint";
+  EXPECT_FALSE(traj_controller_->validate_trajectory_msg(*ordered_msg));
+}
+
+/**
+ * @brief check that only goals which need no changes are executed without a copy
+ */
+TEST_P(TrajectoryControllerTestParameterized, goal_executed_unchanged)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("allow_partial_joints_goal", true)});
+
+  trajectory_msgs::msg::JointTrajectory traj_msg;
+  traj_msg.joint_names = joint_names_;
+  traj_msg.points.resize(2);
+  traj_msg.points[0].positions = {1.0, 2.0, 3.0};
+  traj_msg.points[1].positions = {2.0, 3.0, 4.0};
+  EXPECT_TRUE(traj_controller_->is_executable_unchanged(traj_msg));
+
+  // positions deduced from the derivatives
+  traj_msg.points[1].positions.clear();
+  traj_msg.points[1].velocities = {0.1, 0.1, 0.1};
+  EXPECT_FALSE(traj_controller_->is_executable_unchanged(traj_msg));
+
+  // joints to sort or to fill
+  traj_msg.points[1].positions = {2.0, 3.0, 4.0};
+  std::swap(traj_msg.joint_names[0], traj_msg.joint_names[2]);
+  EXPECT_FALSE(traj_controller_->is_executable_unchanged(traj_msg));
+  traj_msg.joint_names = {joint_names_[0], joint_names_[1]};
+  EXPECT_FALSE(traj_controller_->is_executable_unchanged(traj_msg));
+}
+
+/**
+ * @brief check that goals with waypoints to time-parameterize are copied
+ */
+TEST_P(TrajectoryControllerTestParameterized, goal_to_time_parameterize_is_changed)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(
+    executor, true, {rclcpp::Parameter("interpolation_method", "minimum_jerk")});
+
+  trajectory_msgs::msg::JointTrajectory traj_msg;
+  traj_msg.joint_names = joint_names_;
+  traj_msg.points.resize(1);
+  traj_msg.points[0].positions = {1.0, 2.0, 3.0};
+  EXPECT_FALSE(traj_controller_->is_executable_unchanged(traj_msg));
+}
+
+/**
+ * @brief check that an invalid point is found in a long trajectory
+ */
+TEST_P(TrajectoryControllerTestParameterized, validate_long_trajectory_msg)
+{
+  rclcpp::executors::SingleThreadedExecutor executor;
+  SetUpAndActivateTrajectoryController(executor, true, {});
+
+  trajectory_msgs::msg::JointTrajectory good_traj_msg;
+  good_traj_msg.joint_names = joint_names_;
+  good_traj_msg.points.resize(50000);
+  for (size_t k = 0; k < good_traj_msg.points.size(); ++k)
+  {
+    auto & point = good_traj_msg.points[k];
+    point.time_from_start = rclcpp::Duration::from_seconds(0.001 * static_cast<double>(k + 1));
+    point.positions = {1.0, 2.0, 3.0};
+    point.velocities = {0.0, 0.0, 0.0};
+  }
+  EXPECT_TRUE(traj_controller_->validate_trajectory_msg(good_traj_msg));
+
+  const size_t last = good_traj_msg.points.size() - 1;
+  auto traj_msg = good_traj_msg;
+  traj_msg.points[last].velocities = {0.0, 0.0};
+  EXPECT_FALSE(traj_controller_->validate_trajectory_msg(traj_msg));
+
+  traj_msg = good_traj_msg;
+  traj_msg.points[last].positions.clear();
+  EXPECT_FALSE(traj_controller_->validate_trajectory_msg(traj_msg));
+
+  traj_msg = good_traj_msg;
+  traj_msg.points[last].effort = {1.0, 2.0, 3.0, 4.0};
+  EXPECT_FALSE(traj_controller_->validate_trajectory_msg(traj_msg));
+
+  // Non-strictly increasing waypoint times
+  traj_msg = good_traj_msg;
+  traj_msg.points[last].time_from_start = traj_msg.points[last - 1].time_from_start;
+  EXPECT_FALSE(traj_controller_->validate_trajectory_msg(traj_msg));
+
+  // a start time in the past is fine, as long as the trajectory ends in the future
+  traj_msg = good_traj_msg;
+  traj_msg.header.stamp =
+    traj_controller_->get_node()->now() - rclcpp::Duration::from_seconds(10.0);
+  EXPECT_TRUE(traj_controller_->validate_trajectory_msg(traj_msg));
+  traj_msg.header.stamp =
+    traj_controller_->get_node()->now() - rclcpp::Duration::from_seconds(60.0);
+  EXPECT_FALSE(traj_controller_->validate_trajectory_msg(traj_msg));
+}
+
 // Floating-point value comparison threshold
 const double EPS = 1e-6;
 /**
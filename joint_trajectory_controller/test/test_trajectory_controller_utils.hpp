@@ -47,6 +47,13 @@ class TestableJointTrajectoryController
 public:
   using joint_trajectory_controller::JointTrajectoryController::JointTrajectoryController;
   using joint_trajectory_controller::JointTrajectoryController::validate_trajectory_msg;
+  using joint_trajectory_controller::JointTrajectoryController::fill_partial_goal;
+  using joint_trajectory_controller::JointTrajectoryController::sort_to_local_joint_order;
+  using joint_trajectory_controller::JointTrajectoryController::is_executable_unchanged;
+  using joint_trajectory_controller::JointTrajectoryController::find_stored_trajectory;
+  using joint_trajectory_controller::JointTrajectoryController::store_trajectory_callback;
+  using joint_trajectory_controller::JointTrajectoryController::topic_callback;
+  using joint_trajectory_controller::JointTrajectoryController::get_memory_footprint;
 
   controller_interface::CallbackReturn on_configure(
     const rclcpp_lifecycle::State & previous_state) override
@@ -114,6 +121,21 @@ public:
 
   bool use_closed_loop_pid_adapter() { return use_closed_loop_pid_adapter_; }
 
+  std::shared_ptr<joint_trajectory_controller::Trajectory> get_traj_external_point_ptr()
+  {
+    return traj_external_point_ptr_;
+  }
+
+  trajectory_msgs::msg::JointTrajectoryPoint get_state_desired() { return state_desired_; }
+
+  void wait_for_preprocessing()
+  {
+    if (preprocessing_worker_)
+    {
+      preprocessing_worker_->wait_until_idle();
+    }
+  }
+
   rclcpp::WaitSet joint_cmd_sub_wait_set_;
 };
 
@@ -263,6 +285,25 @@ public:
       state_interfaces.emplace_back(vel_state_interfaces_.back());
       state_interfaces.emplace_back(acc_state_interfaces_.back());
     }
+    // the sequence interfaces of all command interfaces, if claimed
+    if (traj_controller_->get_node()->get_parameter("command_sequence_interfaces").as_bool())
+    {
+      const std::vector<std::string> types = {
+        hardware_interface::HW_IF_POSITION, hardware_interface::HW_IF_VELOCITY,
+        hardware_interface::HW_IF_ACCELERATION, hardware_interface::HW_IF_EFFORT};
+      joint_cmd_sequences_.assign(types.size() * joint_names_.size(), 0.0);
+      cmd_sequence_interfaces_.reserve(joint_cmd_sequences_.size());
+      for (size_t t = 0; t < types.size(); ++t)
+      {
+        for (size_t i = 0; i < joint_names_.size(); ++i)
+        {
+          cmd_sequence_interfaces_.emplace_back(hardware_interface::CommandInterface(
+            joint_names_[i], types[t] + "_sequence",
+            &joint_cmd_sequences_[t * joint_names_.size() + i]));
+          cmd_interfaces.emplace_back(cmd_sequence_interfaces_.back());
+        }
+      }
+    }
 
     traj_controller_->assign_interfaces(std::move(cmd_interfaces), std::move(state_interfaces));
     traj_controller_->get_node()->activate();
@@ -441,6 +482,9 @@ public:
   std::vector<hardware_interface::StateInterface> pos_state_interfaces_;
   std::vector<hardware_interface::StateInterface> vel_state_interfaces_;
   std::vector<hardware_interface::StateInterface> acc_state_interfaces_;
+  // [interface type][joint] for position, velocity, acceleration and effort
+  std::vector<double> joint_cmd_sequences_;
+  std::vector<hardware_interface::CommandInterface> cmd_sequence_interfaces_;
 };
 
 // From the tutorial: https://www.sandordargo.com/blog/2019/04/24/parameterized-testing-with-gtest
@@ -0,0 +1,132 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "joint_trajectory_controller/trajectory_file.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+using joint_trajectory_controller::TrajectoryFile;
+using testing::ElementsAre;
+
+namespace
+{
+trajectory_msgs::msg::JointTrajectory make_trajectory(size_t point_count)
+{
+  trajectory_msgs::msg::JointTrajectory trajectory;
+  trajectory.joint_names = {"joint1", "joint_with_a_long_name"};
+  for (size_t index = 0; index < point_count; ++index)
+  {
+    trajectory_msgs::msg::JointTrajectoryPoint point;
+    const auto value = static_cast<double>(index);
+    point.positions = {value, -value};
+    point.velocities = {1.0, -1.0};
+    point.time_from_start.sec = static_cast<int32_t>(index / 2);
+    point.time_from_start.nanosec = index % 2 == 0 ? 0u : 500000000u;
+    trajectory.points.push_back(point);
+  }
+  return trajectory;
+}
+
+class TestTrajectoryFile : public testing::Test
+{
+protected:
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  const std::string path_ = testing::TempDir() + "test_trajectory_file.jtctraj";
+  std::string error_;
+};
+}  // namespace
+
+TEST_F(TestTrajectoryFile, reads_written_points_in_windows)
+{
+  ASSERT_TRUE(TrajectoryFile::write(path_, make_trajectory(5), error_)) << error_;
+  const auto file = TrajectoryFile::open(path_, error_);
+  ASSERT_TRUE(file) << error_;
+  EXPECT_THAT(file->joint_names(), ElementsAre("joint1", "joint_with_a_long_name"));
+  EXPECT_EQ(file->size(), 5u);
+  EXPECT_TRUE(file->has_velocities());
+  EXPECT_FALSE(file->has_accelerations());
+  EXPECT_EQ(file->time_from_start_ns(3), 1500000000);
+
+  trajectory_msgs::msg::JointTrajectory trajectory;
+  ASSERT_TRUE(file->read_points(0, 2, trajectory, error_)) << error_;
+  ASSERT_TRUE(file->read_points(2, 5, trajectory, error_)) << error_;
+  ASSERT_EQ(trajectory.points.size(), 5u);
+  const auto & point = trajectory.points[3];
+  EXPECT_THAT(point.positions, ElementsAre(3.0, -3.0));
+  EXPECT_THAT(point.velocities, ElementsAre(1.0, -1.0));
+  EXPECT_TRUE(point.accelerations.empty());
+  EXPECT_EQ(point.time_from_start.sec, 1);
+  EXPECT_EQ(point.time_from_start.nanosec, 500000000u);
+}
+
+TEST_F(TestTrajectoryFile, rejects_other_files)
+{
+  EXPECT_FALSE(TrajectoryFile::open(path_, error_));
+  {
+    std::ofstream file(path_, std::ios::binary);
+    file << "not a trajectory file, but longer than a header";
+  }
+  EXPECT_FALSE(TrajectoryFile::open(path_, error_));
+  EXPECT_FALSE(error_.empty());
+}
+
+TEST_F(TestTrajectoryFile, rejects_truncated_file)
+{
+  ASSERT_TRUE(TrajectoryFile::write(path_, make_trajectory(5), error_)) << error_;
+  std::string content;
+  {
+    std::ifstream file(path_, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size() - 8));
+  }
+  EXPECT_FALSE(TrajectoryFile::open(path_, error_));
+}
+
+TEST_F(TestTrajectoryFile, checks_points_when_reading_them)
+{
+  auto trajectory = make_trajectory(4);
+  trajectory.points[3].time_from_start = trajectory.points[1].time_from_start;
+  trajectory.points[2].positions[1] = std::numeric_limits<double>::quiet_NaN();
+  ASSERT_TRUE(TrajectoryFile::write(path_, trajectory, error_)) << error_;
+  // opening doesn't read the points
+  const auto file = TrajectoryFile::open(path_, error_);
+  ASSERT_TRUE(file) << error_;
+
+  trajectory_msgs::msg::JointTrajectory read;
+  EXPECT_TRUE(file->read_points(0, 2, read, error_));
+  EXPECT_FALSE(file->read_points(2, 4, read, error_));
+  EXPECT_EQ(read.points.size(), 2u);
+  read.points.clear();
+  EXPECT_FALSE(file->read_points(3, 4, read, error_));
+}
+
+TEST_F(TestTrajectoryFile, writes_only_consistent_points)
+{
+  auto trajectory = make_trajectory(3);
+  trajectory.points[1].velocities.clear();
+  EXPECT_FALSE(TrajectoryFile::write(path_, trajectory, error_));
+  EXPECT_FALSE(TrajectoryFile::write(path_, make_trajectory(0), error_));
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <vector>
+
+#include "joint_trajectory_controller/trajectory_pool.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+using joint_trajectory_controller::Trajectory;
+using joint_trajectory_controller::TrajectoryPool;
+
+TEST(TestTrajectoryPool, preallocates_capacity)
+{
+  TrajectoryPool pool(3);
+  EXPECT_EQ(pool.capacity(), 3u);
+  EXPECT_EQ(pool.size(), 3u);
+  EXPECT_EQ(pool.available(), 3u);
+}
+
+TEST(TestTrajectoryPool, hands_out_unused_trajectories)
+{
+  TrajectoryPool pool(2);
+  const auto first = pool.acquire();
+  const auto second = pool.acquire();
+  ASSERT_TRUE(first);
+  ASSERT_TRUE(second);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(pool.available(), 0u);
+}
+
+TEST(TestTrajectoryPool, reuses_released_trajectory)
+{
+  TrajectoryPool pool(2);
+  auto trajectory = pool.acquire();
+  const Trajectory * const address = trajectory.get();
+  auto msg = std::make_shared<trajectory_msgs::msg::JointTrajectory>();
+  trajectory->update(msg);
+
+  // the last user drops its reference, the pool still holds one
+  trajectory.reset();
+  EXPECT_EQ(msg.use_count(), 2);
+  EXPECT_EQ(pool.available(), 2u);
+
+  EXPECT_EQ(pool.acquire().get(), address);
+  EXPECT_EQ(pool.size(), 2u);
+}
+
+TEST(TestTrajectoryPool, frees_trajectories_beyond_capacity_once_unused)
+{
+  TrajectoryPool pool(1);
+  std::vector<std::shared_ptr<Trajectory>> in_use;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    in_use.push_back(pool.acquire());
+  }
+  EXPECT_EQ(pool.size(), 3u);
+
+  const std::weak_ptr<Trajectory> additional = in_use.back();
+  in_use.clear();
+  // still referenced by the pool, so not freed by the user
+  EXPECT_FALSE(additional.expired());
+
+  pool.acquire();
+  EXPECT_TRUE(additional.expired());
+  EXPECT_EQ(pool.size(), 1u);
+}
+
+TEST(TestTrajectoryPool, clear_leaves_trajectories_in_use_to_their_users)
+{
+  TrajectoryPool pool(2);
+  const auto trajectory = pool.acquire();
+  pool.clear();
+  EXPECT_EQ(pool.size(), 0u);
+  EXPECT_EQ(trajectory.use_count(), 1);
+}
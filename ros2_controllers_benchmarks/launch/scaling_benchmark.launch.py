@@ -0,0 +1,146 @@
+# Copyright (c) 2024 ros2_control Development Team
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# One configuration of the scaling benchmark: a controller manager with mock hardware and a mix of
+# controllers, measured by the scaling monitor, which shuts the launch down once it is done.
+
+import os
+import tempfile
+
+from launch import LaunchDescription
+from launch.actions import (
+    DeclareLaunchArgument,
+    EmitEvent,
+    OpaqueFunction,
+    RegisterEventHandler,
+)
+from launch.event_handlers import OnProcessExit
+from launch.events import Shutdown
+from launch.substitutions import LaunchConfiguration
+from launch_ros.actions import Node
+
+from ros2_controllers_benchmarks.scaling_config import (
+    controller_names,
+    generate_urdf,
+    write_parameters,
+)
+
+# launch argument with the number of instances, controller type
+CONTROLLER_ARGUMENTS = {
+    "joint_state_broadcasters": "joint_state_broadcaster",
+    "joint_trajectory_controllers": "joint_trajectory_controller",
+    "forward_command_controllers": "forward_command_controller",
+    "diff_drive_controllers": "diff_drive_controller",
+}
+
+
+def launch_setup(context):
+    def argument(name):
+        return LaunchConfiguration(name).perform(context)
+
+    joints = int(argument("joints"))
+    update_rate = int(argument("update_rate"))
+    mix = {
+        controller_type: int(argument(name))
+        for name, controller_type in CONTROLLER_ARGUMENTS.items()
+    }
+    names = controller_names(mix)
+
+    robot_description = generate_urdf(mix, joints)
+    config_directory = tempfile.mkdtemp(prefix="scaling_benchmark_")
+    parameters_file = os.path.join(config_directory, "controllers.yaml")
+    write_parameters(parameters_file, mix, joints, update_rate)
+
+    robot_state_publisher = Node(
+        package="robot_state_publisher",
+        executable="robot_state_publisher",
+        parameters=[{"robot_description": robot_description}],
+    )
+    control_node = Node(
+        package="controller_manager",
+        executable="ros2_control_node",
+        parameters=[{"robot_description": robot_description}, parameters_file],
+        remappings=[("~/robot_description", "/robot_description")],
+        output="both",
+    )
+    spawners = [
+        Node(
+            package="controller_manager",
+            executable="spawner",
+            arguments=[name, "--controller-manager", "/controller_manager"],
+        )
+        for instances in names.values()
+        for name in instances
+    ]
+    monitor = Node(
+        package="ros2_controllers_benchmarks",
+        executable="scaling_monitor",
+        output="screen",
+        parameters=[
+            {
+                "label": argument("label"),
+                "joints": joints,
+                "update_rate": update_rate,
+                "settle_time": float(argument("settle_time")),
+                "duration": float(argument("duration")),
+                "command_rate": float(argument("command_rate")),
+                "output_file": argument("output_file"),
+            },
+            {
+                name: names[controller_type] or [""]
+                for name, controller_type in CONTROLLER_ARGUMENTS.items()
+            },
+        ],
+    )
+    shutdown_when_done = RegisterEventHandler(
+        OnProcessExit(target_action=monitor, on_exit=[EmitEvent(event=Shutdown())])
+    )
+    return [robot_state_publisher, control_node, *spawners, monitor, shutdown_when_done]
+
+
+def generate_launch_description():
+    arguments = [
+        DeclareLaunchArgument("joints", default_value="6", description="Joints per controller."),
+        DeclareLaunchArgument(
+            "update_rate", default_value="1000", description="Update rate of the controllers."
+        ),
+        DeclareLaunchArgument(
+            "settle_time",
+            default_value="5.0",
+            description="Time after the start until the measurement starts [s].",
+        ),
+        DeclareLaunchArgument(
+            "duration", default_value="30.0", description="Duration of the measurement [s]."
+        ),
+        DeclareLaunchArgument(
+            "command_rate",
+            default_value="100.0",
+            description="Rate of the commands sent to the controllers, 0 to let them idle.",
+        ),
+        DeclareLaunchArgument(
+            "output_file",
+            default_value="",
+            description="CSV file the results are appended to, empty to only log them.",
+        ),
+        DeclareLaunchArgument(
+            "label", default_value="", description="Label of the results in the CSV file."
+        ),
+    ]
+    arguments += [
+        DeclareLaunchArgument(
+            name, default_value="1", description=f"Number of {controller_type} instances."
+        )
+        for name, controller_type in CONTROLLER_ARGUMENTS.items()
+    ]
+    return LaunchDescription(arguments + [OpaqueFunction(function=launch_setup)])
@@ -0,0 +1,137 @@
+# Copyright (c) 2024 ros2_control Development Team
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Configuration of the scaling benchmark: a mock hardware system and a mix of controllers.
+
+Every controller instance gets joints of its own, so the system has N * M joints for N controllers
+with M joints each. The joints mirror their commands to their states (mock_components).
+"""
+
+import yaml
+
+# short name of the instances, plugin type
+CONTROLLER_TYPES = {
+    "joint_state_broadcaster": ("jsb", "joint_state_broadcaster/JointStateBroadcaster"),
+    "joint_trajectory_controller": (
+        "jtc",
+        "joint_trajectory_controller/JointTrajectoryController",
+    ),
+    "forward_command_controller": ("fcc", "forward_command_controller/ForwardCommandController"),
+    "diff_drive_controller": ("ddc", "diff_drive_controller/DiffDriveController"),
+}
+
+
+def controller_names(mix):
+    """Names of the controller instances of mix, a dict of counts by controller type."""
+    names = {}
+    for controller_type, count in mix.items():
+        prefix = CONTROLLER_TYPES[controller_type][0]
+        names[controller_type] = [f"{prefix}_{i}" for i in range(count)]
+    return names
+
+
+def joint_names(controller_name, joints):
+    return [f"{controller_name}_joint{j}" for j in range(joints)]
+
+
+def _joint_urdf(name, command_interface):
+    return (
+        f'    <joint name="{name}">\n'
+        f'      <command_interface name="{command_interface}"/>\n'
+        '      <state_interface name="position"><param name="initial_value">0.0</param>'
+        "</state_interface>\n"
+        '      <state_interface name="velocity"/>\n'
+        "    </joint>\n"
+    )
+
+
+def generate_urdf(mix, joints):
+    """URDF of one mock system with the joints of all controllers of mix."""
+    ros2_control = ""
+    links = '  <link name="base_link"/>\n'
+    names = controller_names(mix)
+    for controller_type, instances in names.items():
+        # the wheels of the diff drive controllers are velocity commanded, all others position
+        is_diff_drive = controller_type == "diff_drive_controller"
+        command_interface = "velocity" if is_diff_drive else "position"
+        joint_count = max(joints, 2) if is_diff_drive else joints
+        for instance in instances:
+            for joint in joint_names(instance, joint_count):
+                ros2_control += _joint_urdf(joint, command_interface)
+                links += (
+                    f'  <link name="{joint}_link"/>\n'
+                    f'  <joint name="{joint}" type="continuous">\n'
+                    '    <parent link="base_link"/>\n'
+                    f'    <child link="{joint}_link"/>\n'
+                    "  </joint>\n"
+                )
+    return (
+        '<?xml version="1.0"?>\n'
+        '<robot name="scaling_benchmark">\n'
+        f"{links}"
+        '  <ros2_control name="ScalingBenchmarkSystem" type="system">\n'
+        "    <hardware>\n"
+        "      <plugin>mock_components/GenericSystem</plugin>\n"
+        "    </hardware>\n"
+        f"{ros2_control}"
+        "  </ros2_control>\n"
+        "</robot>\n"
+    )
+
+
+def generate_parameters(mix, joints, update_rate):
+    """Parameters of the controller manager and all controllers of mix."""
+    names = controller_names(mix)
+    manager = {"update_rate": update_rate}
+    parameters = {"controller_manager": {"ros__parameters": manager}}
+    for controller_type, instances in names.items():
+        for instance in instances:
+            manager[instance] = {"type": CONTROLLER_TYPES[controller_type][1]}
+            if controller_type == "joint_state_broadcaster":
+                # the joint states of all instances are published, every update
+                controller = {
+                    "joints": joint_names(instance, joints),
+                    "interfaces": ["position", "velocity"],
+                    "use_local_topics": True,
+                }
+            elif controller_type == "joint_trajectory_controller":
+                controller = {
+                    "joints": joint_names(instance, joints),
+                    "command_interfaces": ["position"],
+                    "state_interfaces": ["position", "velocity"],
+                }
+            elif controller_type == "forward_command_controller":
+                controller = {
+                    "joints": joint_names(instance, joints),
+                    "interface_name": "position",
+                }
+            else:
+                wheels = joint_names(instance, max(joints, 2))
+                half = len(wheels) // 2
+                controller = {
+                    "left_wheel_names": wheels[:half],
+                    "right_wheel_names": wheels[half : 2 * half],
+                    "wheel_separation": 0.5,
+                    "wheel_radius": 0.1,
+                    "odom_frame_id": f"{instance}/odom",
+                    "base_frame_id": f"{instance}/base_link",
+                }
+            parameters[instance] = {"ros__parameters": controller}
+    return parameters
+
+
+def write_parameters(path, mix, joints, update_rate):
+    with open(path, "w") as parameters_file:
+        yaml.safe_dump(generate_parameters(mix, joints, update_rate), parameters_file)
@@ -0,0 +1,313 @@
+# Copyright (c) 2024 ros2_control Development Team
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Monitor of the scaling benchmark.
+
+Commands the controllers of the benchmark and measures, after a settle time, for a duration:
+
+* the loop jitter of the controller manager, from the stamps of the joint states of the joint
+  state broadcasters, which are the times of the updates,
+* the CPU usage of the controller manager process,
+* the bandwidth of all topics, from the size of their serialized messages.
+
+The results are logged and appended as a row to a CSV file.
+"""
+
+import math
+import os
+import time
+
+import rclpy
+from rclpy.node import Node
+from rclpy.serialization import deserialize_message
+from rosidl_runtime_py.utilities import get_message
+
+from geometry_msgs.msg import TwistStamped
+from sensor_msgs.msg import JointState
+from std_msgs.msg import Float64MultiArray
+from trajectory_msgs.msg import JointTrajectory, JointTrajectoryPoint
+
+from ros2_controllers_benchmarks.scaling_config import joint_names
+
+CSV_COLUMNS = [
+    "label",
+    "controllers",
+    "joints",
+    "update_rate",
+    "duration",
+    "samples",
+    "period_mean_us",
+    "jitter_p50_us",
+    "jitter_p99_us",
+    "jitter_max_us",
+    "gaps",
+    "cpu_percent",
+    "topics",
+    "messages_per_s",
+    "bandwidth_kib_per_s",
+]
+# topics of the ROS infrastructure, not of the controllers
+IGNORED_TOPICS = ("/rosout", "/parameter_events")
+# period of the trajectories sent to the joint trajectory controllers
+TRAJECTORY_PERIOD = 5.0
+
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return math.nan
+    return sorted_values[min(len(sorted_values) - 1, int(fraction * len(sorted_values)))]
+
+
+def find_process(name):
+    """Pid of the first process whose command line contains name, None if there is none."""
+    for pid in os.listdir("/proc"):
+        if not pid.isdigit() or int(pid) == os.getpid():
+            continue
+        try:
+            with open(f"/proc/{pid}/cmdline", "rb") as cmdline:
+                if name.encode() in cmdline.read():
+                    return int(pid)
+        except OSError:
+            continue
+    return None
+
+
+def cpu_seconds(pid):
+    """User and system CPU time of process pid in seconds, None if it is gone."""
+    try:
+        with open(f"/proc/{pid}/stat") as stat:
+            # the fields after the command name, which may contain spaces
+            fields = stat.read().rsplit(")", 1)[1].split()
+    except OSError:
+        return None
+    # utime and stime are the 14th and 15th field, the first after the command name is the 3rd
+    return (int(fields[11]) + int(fields[12])) / os.sysconf("SC_CLK_TCK")
+
+
+class ScalingMonitor(Node):
+    def __init__(self):
+        super().__init__("scaling_monitor")
+        self.declare_parameter("label", "")
+        self.declare_parameter("joints", 1)
+        self.declare_parameter("update_rate", 1000)
+        self.declare_parameter("settle_time", 5.0)
+        self.declare_parameter("duration", 30.0)
+        self.declare_parameter("command_rate", 100.0)
+        self.declare_parameter("process_name", "ros2_control_node")
+        self.declare_parameter("output_file", "")
+        self.declare_parameter("joint_state_broadcasters", [""])
+        self.declare_parameter("joint_trajectory_controllers", [""])
+        self.declare_parameter("forward_command_controllers", [""])
+        self.declare_parameter("diff_drive_controllers", [""])
+
+        def names(parameter):
+            return [name for name in self.get_parameter(parameter).value if name]
+
+        self.joints = self.get_parameter("joints").value
+        self.update_rate = self.get_parameter("update_rate").value
+        self.duration = self.get_parameter("duration").value
+        self.broadcasters = names("joint_state_broadcasters")
+        self.controllers = (
+            self.broadcasters
+            + names("joint_trajectory_controllers")
+            + names("forward_command_controllers")
+            + names("diff_drive_controllers")
+        )
+
+        # commands, so that the controllers don't idle
+        self.command_publishers = [
+            self.create_publisher(Float64MultiArray, f"/{name}/commands", 10)
+            for name in names("forward_command_controllers")
+        ]
+        self.cmd_vel_publishers = [
+            self.create_publisher(TwistStamped, f"/{name}/cmd_vel", 10)
+            for name in names("diff_drive_controllers")
+        ]
+        self.trajectory_publishers = [
+            (self.create_publisher(JointTrajectory, f"/{name}/joint_trajectory", 10), name)
+            for name in names("joint_trajectory_controllers")
+        ]
+        self.start_time = time.monotonic()
+        self.next_trajectory_time = self.start_time
+        command_rate = self.get_parameter("command_rate").value
+        if command_rate > 0.0:
+            self.command_timer = self.create_timer(1.0 / command_rate, self.publish_commands)
+
+        self.subscriptions_by_topic = {}
+        self.stamps = {}
+        self.messages = 0
+        self.bytes = 0
+        self.measuring = False
+        self.done = False
+        self.settle_timer = self.create_timer(
+            self.get_parameter("settle_time").value, self.start_measurement
+        )
+
+    def publish_commands(self):
+        now = time.monotonic()
+        value = 0.5 * math.sin(2.0 * math.pi * 0.5 * (now - self.start_time))
+        commands = Float64MultiArray()
+        commands.data = [value] * self.joints
+        for publisher in self.command_publishers:
+            publisher.publish(commands)
+        cmd_vel = TwistStamped()
+        cmd_vel.header.stamp = self.get_clock().now().to_msg()
+        cmd_vel.twist.linear.x = value
+        cmd_vel.twist.angular.z = value
+        for publisher in self.cmd_vel_publishers:
+            publisher.publish(cmd_vel)
+
+        if self.trajectory_publishers and now >= self.next_trajectory_time:
+            self.next_trajectory_time = now + TRAJECTORY_PERIOD
+            for publisher, name in self.trajectory_publishers:
+                publisher.publish(self.make_trajectory(name))
+
+    def make_trajectory(self, name):
+        """Sine of the positions of all joints of controller name over the trajectory period."""
+        trajectory = JointTrajectory()
+        trajectory.joint_names = joint_names(name, self.joints)
+        points = 10
+        for i in range(1, points + 1):
+            t = TRAJECTORY_PERIOD * i / points
+            point = JointTrajectoryPoint()
+            point.positions = [0.5 * math.sin(2.0 * math.pi * t / TRAJECTORY_PERIOD)] * self.joints
+            point.time_from_start.sec = int(t)
+            point.time_from_start.nanosec = int((t - int(t)) * 1e9)
+            trajectory.points.append(point)
+        return trajectory
+
+    def start_measurement(self):
+        self.settle_timer.cancel()
+        expected_broadcasters = {f"/{name}/joint_states" for name in self.broadcasters}
+        topics = {
+            topic: types[0]
+            for topic, types in self.get_topic_names_and_types()
+            if topic not in IGNORED_TOPICS and types
+        }
+        missing = expected_broadcasters - topics.keys()
+        if missing:
+            self.get_logger().warn(f"Waiting for the joint states of {sorted(missing)}")
+            self.settle_timer = self.create_timer(1.0, self.start_measurement)
+            return
+
+        for topic, type_name in topics.items():
+            self.stamps[topic] = [] if topic in expected_broadcasters else None
+            self.subscriptions_by_topic[topic] = self.create_subscription(
+                get_message(type_name),
+                topic,
+                lambda msg, topic=topic: self.on_message(topic, msg),
+                100,
+                raw=True,
+            )
+        self.process = find_process(self.get_parameter("process_name").value)
+        if self.process is None:
+            self.get_logger().warn("Controller manager process not found, CPU is not measured")
+        self.cpu_start = cpu_seconds(self.process) if self.process else None
+        self.measurement_start = time.monotonic()
+        self.measuring = True
+        self.get_logger().info(
+            f"Measuring {len(topics)} topics of {len(self.controllers)} controllers for "
+            f"{self.duration} s"
+        )
+        self.measurement_timer = self.create_timer(self.duration, self.finish_measurement)
+
+    def on_message(self, topic, serialized_msg):
+        if not self.measuring:
+            return
+        self.messages += 1
+        self.bytes += len(serialized_msg)
+        stamps = self.stamps[topic]
+        if stamps is not None:
+            stamp = deserialize_message(serialized_msg, JointState).header.stamp
+            stamps.append(stamp.sec * 1000000000 + stamp.nanosec)
+
+    def finish_measurement(self):
+        self.measurement_timer.cancel()
+        self.measuring = False
+        wall_time = time.monotonic() - self.measurement_start
+        cpu_end = cpu_seconds(self.process) if self.process else None
+
+        # the joint states are published on every update, so their stamps are the update times
+        expected_period = 1e9 / self.update_rate
+        periods = []
+        gaps = 0
+        for stamps in self.stamps.values():
+            for previous, current in zip(stamps or [], (stamps or [])[1:]):
+                period = current - previous
+                if period > 1.5 * expected_period:
+                    # missed updates, or messages the broadcaster or the middleware dropped
+                    gaps += round(period / expected_period) - 1
+                else:
+                    periods.append(period)
+        jitter = sorted(abs(period - expected_period) for period in periods)
+
+        results = {
+            "label": self.get_parameter("label").value,
+            "controllers": len(self.controllers),
+            "joints": self.joints,
+            "update_rate": self.update_rate,
+            "duration": round(wall_time, 3),
+            "samples": len(periods),
+            "period_mean_us": sum(periods) / len(periods) / 1e3 if periods else math.nan,
+            "jitter_p50_us": percentile(jitter, 0.5) / 1e3,
+            "jitter_p99_us": percentile(jitter, 0.99) / 1e3,
+            "jitter_max_us": jitter[-1] / 1e3 if jitter else math.nan,
+            "gaps": gaps,
+            "cpu_percent": (
+                100.0 * (cpu_end - self.cpu_start) / wall_time
+                if self.cpu_start is not None and cpu_end is not None
+                else math.nan
+            ),
+            "topics": len(self.subscriptions_by_topic),
+            "messages_per_s": self.messages / wall_time,
+            "bandwidth_kib_per_s": self.bytes / 1024.0 / wall_time,
+        }
+        self.get_logger().info(
+            ", ".join(
+                f"{key}: {value:.3f}" if isinstance(value, float) else f"{key}: {value}"
+                for key, value in results.items()
+            )
+        )
+
+        output_file = self.get_parameter("output_file").value
+        if output_file:
+            write_header = not os.path.exists(output_file)
+            with open(output_file, "a") as csv:
+                if write_header:
+                    csv.write(",".join(CSV_COLUMNS) + "\n")
+                csv.write(
+                    ",".join(
+                        f"{results[column]:.3f}"
+                        if isinstance(results[column], float)
+                        else str(results[column])
+                        for column in CSV_COLUMNS
+                    )
+                    + "\n"
+                )
+        self.done = True
+
+
+def main(args=None):
+    rclpy.init(args=args)
+
+    monitor = ScalingMonitor()
+    while rclpy.ok() and not monitor.done:
+        rclpy.spin_once(monitor, timeout_sec=0.1)
+    monitor.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == "__main__":
+    main()
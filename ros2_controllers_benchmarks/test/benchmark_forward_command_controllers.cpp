@@ -0,0 +1,127 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the update() of the forward_command_controller family, see
+// controller_benchmark.hpp. A new command is received before every cycle.
+//
+// Arguments: number of joints, and whether the commands are preallocated (preallocate_commands).
+// The multi interface controller commands position, velocity and effort of every joint.
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "forward_command_controller/forward_command_controller.hpp"
+#include "forward_command_controller/multi_interface_forward_command_controller.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+using ros2_controllers_benchmarks::make_names;
+
+template <typename ControllerT>
+class BenchmarkForwardController : public ControllerT
+{
+public:
+  using ControllerT::command_callback;
+};
+
+template <typename ControllerT>
+class ForwardControllerBenchmark
+: public ControllerBenchmark<BenchmarkForwardController<ControllerT>>
+{
+protected:
+  using Base = ControllerBenchmark<BenchmarkForwardController<ControllerT>>;
+
+  void start(const std::vector<rclcpp::Parameter> & parameters)
+  {
+    Base::start("benchmark_forward_command_controller", parameters);
+    command_size_ = this->controller_->command_interface_configuration().names.size();
+  }
+
+  void run_with_commands(benchmark::State & state)
+  {
+    this->run(
+      state,
+      [this](const rclcpp::Time & time)
+      {
+        // a new msg, like the ones of the subscription
+        auto msg = std::make_shared<forward_command_controller::CmdType>();
+        msg->data.resize(command_size_);
+        for (size_t i = 0; i < command_size_; ++i)
+        {
+          msg->data[i] = std::sin(time.seconds() + 0.1 * static_cast<double>(i));
+        }
+        this->controller_->command_callback(msg);
+      });
+  }
+
+  size_t command_size_ = 0;
+};
+
+class ForwardCommandControllerBenchmark
+: public ForwardControllerBenchmark<forward_command_controller::ForwardCommandController>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    start(
+      {rclcpp::Parameter("joints", make_names("joint", static_cast<size_t>(state.range(0)))),
+       rclcpp::Parameter("interface_name", std::string(hardware_interface::HW_IF_POSITION)),
+       rclcpp::Parameter("preallocate_commands", state.range(1) != 0)});
+  }
+};
+
+using forward_command_controller::MultiInterfaceForwardCommandController;
+
+class MultiInterfaceForwardCommandControllerBenchmark
+: public ForwardControllerBenchmark<MultiInterfaceForwardCommandController>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    start(
+      {rclcpp::Parameter("joints", make_names("joint", static_cast<size_t>(state.range(0)))),
+       rclcpp::Parameter(
+         "interface_names", std::vector<std::string>{hardware_interface::HW_IF_POSITION,
+                                                     hardware_interface::HW_IF_VELOCITY,
+                                                     hardware_interface::HW_IF_EFFORT}),
+       rclcpp::Parameter("preallocate_commands", state.range(1) != 0)});
+  }
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(ForwardCommandControllerBenchmark, update)(benchmark::State & state)
+{
+  run_with_commands(state);
+}
+
+BENCHMARK_REGISTER_F(ForwardCommandControllerBenchmark, update)
+  ->ArgNames({"dof", "preallocate"})
+  ->ArgsProduct({{1, 6, 50, 500}, {0, 1}})
+  ->UseManualTime();
+
+BENCHMARK_DEFINE_F(MultiInterfaceForwardCommandControllerBenchmark, update)
+(benchmark::State & state)
+{
+  run_with_commands(state);
+}
+
+BENCHMARK_REGISTER_F(MultiInterfaceForwardCommandControllerBenchmark, update)
+  ->ArgNames({"dof", "preallocate"})
+  ->ArgsProduct({{1, 6, 50, 500}, {0, 1}})
+  ->UseManualTime();
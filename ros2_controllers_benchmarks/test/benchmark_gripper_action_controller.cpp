@@ -0,0 +1,79 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the update() of the gripper_action_controller, on a position and on an effort
+// interface, see controller_benchmark.hpp. The held position is moved before every cycle.
+
+#include <cmath>
+#include <string>
+
+#include "controller_benchmark.hpp"
+#include "gripper_controllers/gripper_action_controller.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+
+namespace
+{
+template <typename ControllerT>
+class GripperActionControllerBenchmark
+: public ros2_controllers_benchmarks::ControllerBenchmark<ControllerT>
+{
+public:
+  void SetUp(benchmark::State &) override
+  {
+    this->start(
+      "benchmark_gripper_action_controller",
+      {rclcpp::Parameter("joint", std::string("gripper_joint")),
+       rclcpp::Parameter("max_effort", 10.0)});
+  }
+
+protected:
+  void run_with_commands(benchmark::State & state)
+  {
+    this->run(
+      state,
+      [this](const rclcpp::Time & time)
+      {
+        // hold a moving position without an action goal, written like accepted_callback() does
+        auto & command = this->controller_->command_->write_buffer();
+        command.position_ = 0.05 * std::sin(time.seconds());
+        command.max_effort_ = 10.0;
+        command.goal_id_ = 0;
+        this->controller_->command_->publish();
+      });
+  }
+};
+
+using PositionGripperActionController =
+  gripper_action_controller::GripperActionController<hardware_interface::HW_IF_POSITION>;
+using EffortGripperActionController =
+  gripper_action_controller::GripperActionController<hardware_interface::HW_IF_EFFORT>;
+}  // namespace
+
+BENCHMARK_TEMPLATE_DEFINE_F(
+  GripperActionControllerBenchmark, position, PositionGripperActionController)
+(benchmark::State & state)
+{
+  run_with_commands(state);
+}
+
+BENCHMARK_REGISTER_F(GripperActionControllerBenchmark, position)->UseManualTime();
+
+BENCHMARK_TEMPLATE_DEFINE_F(
+  GripperActionControllerBenchmark, effort, EffortGripperActionController)
+(benchmark::State & state)
+{
+  run_with_commands(state);
+}
+
+BENCHMARK_REGISTER_F(GripperActionControllerBenchmark, effort)->UseManualTime();
@@ -0,0 +1,85 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the update() of the joint_state_broadcaster, see controller_benchmark.hpp.
+//
+// Arguments: number of joints, and the publish rate of joint_states and dynamic_joint_states in
+// Hz, 0 to publish in every cycle.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "joint_state_broadcaster/joint_state_broadcaster.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+using ros2_controllers_benchmarks::make_names;
+
+class JointStateBroadcasterBenchmark
+: public ControllerBenchmark<joint_state_broadcaster::JointStateBroadcaster>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    const auto joint_names = make_names("joint", static_cast<size_t>(state.range(0)));
+    const auto publish_rate = static_cast<double>(state.range(1));
+    start(
+      "benchmark_joint_state_broadcaster",
+      {rclcpp::Parameter("joints", joint_names),
+       rclcpp::Parameter(
+         "interfaces", std::vector<std::string>{hardware_interface::HW_IF_POSITION,
+                                                hardware_interface::HW_IF_VELOCITY,
+                                                hardware_interface::HW_IF_EFFORT}),
+       rclcpp::Parameter("joint_states.publish_rate", publish_rate),
+       rclcpp::Parameter("dynamic_joint_states.publish_rate", publish_rate)});
+    positions_.clear();
+    velocities_.clear();
+    for (const auto & joint_name : joint_names)
+    {
+      positions_.push_back(&hardware_.value(joint_name + "/" + hardware_interface::HW_IF_POSITION));
+      velocities_.push_back(
+        &hardware_.value(joint_name + "/" + hardware_interface::HW_IF_VELOCITY));
+    }
+  }
+
+protected:
+  std::vector<double *> positions_;
+  std::vector<double *> velocities_;
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(JointStateBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  run(
+    state,
+    [this](const rclcpp::Time & time)
+    {
+      // new readings in every cycle
+      for (size_t i = 0; i < positions_.size(); ++i)
+      {
+        const double phase = time.seconds() + 0.1 * static_cast<double>(i);
+        *positions_[i] = std::sin(phase);
+        *velocities_[i] = std::cos(phase);
+      }
+    });
+}
+
+BENCHMARK_REGISTER_F(JointStateBroadcasterBenchmark, update)
+  ->ArgNames({"dof", "publish_rate"})
+  ->ArgsProduct({{1, 6, 50, 500}, {0, 100}})
+  ->UseManualTime();
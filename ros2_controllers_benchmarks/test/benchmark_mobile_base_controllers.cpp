@@ -0,0 +1,130 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the update() of the diff_drive_controller and the tricycle_controller, see
+// controller_benchmark.hpp. A new velocity command is received before every cycle, and the wheels
+// follow their commands.
+//
+// Arguments: number of wheels per side of the diff drive, and whether the odometry integrates the
+// wheel positions (position_feedback) instead of their velocities.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "diff_drive_controller/diff_drive_controller.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "tricycle_controller/tricycle_controller.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::CYCLE_PERIOD;
+using ros2_controllers_benchmarks::ControllerBenchmark;
+using ros2_controllers_benchmarks::make_names;
+
+/// Write a velocity command, like the callback of the subscription does
+template <typename ControllerT>
+class BenchmarkVelocityController : public ControllerT
+{
+public:
+  void set_velocity_command(const rclcpp::Time & time)
+  {
+    auto & msg = this->received_velocity_msg_->write_buffer();
+    msg.header.stamp = time;
+    msg.twist.linear.x = 1.0 + 0.5 * std::sin(time.seconds());
+    msg.twist.angular.z = 0.5 * std::cos(time.seconds());
+    this->received_velocity_msg_->publish();
+  }
+};
+
+using BenchmarkDiffDriveController =
+  BenchmarkVelocityController<diff_drive_controller::DiffDriveController>;
+using BenchmarkTricycleController =
+  BenchmarkVelocityController<tricycle_controller::TricycleController>;
+
+class DiffDriveControllerBenchmark : public ControllerBenchmark<BenchmarkDiffDriveController>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    const auto wheels_per_side = static_cast<size_t>(state.range(0));
+    const auto left_wheel_names = make_names("left_wheel", wheels_per_side);
+    const auto right_wheel_names = make_names("right_wheel", wheels_per_side);
+    start(
+      "benchmark_diff_drive_controller",
+      {rclcpp::Parameter("left_wheel_names", left_wheel_names),
+       rclcpp::Parameter("right_wheel_names", right_wheel_names),
+       rclcpp::Parameter("wheel_separation", 0.5), rclcpp::Parameter("wheel_radius", 0.1),
+       rclcpp::Parameter("position_feedback", state.range(1) != 0)});
+
+    // the velocities follow the commands, the positions are integrated from them
+    wheel_positions_.clear();
+    wheel_velocities_.clear();
+    for (const auto * wheel_names : {&left_wheel_names, &right_wheel_names})
+    {
+      for (const auto & wheel_name : *wheel_names)
+      {
+        wheel_positions_.push_back(
+          &hardware_.value(wheel_name + "/" + hardware_interface::HW_IF_POSITION));
+        wheel_velocities_.push_back(
+          &hardware_.value(wheel_name + "/" + hardware_interface::HW_IF_VELOCITY));
+      }
+    }
+  }
+
+protected:
+  std::vector<double *> wheel_positions_;
+  std::vector<double *> wheel_velocities_;
+};
+
+class TricycleControllerBenchmark : public ControllerBenchmark<BenchmarkTricycleController>
+{
+public:
+  void SetUp(benchmark::State &) override
+  {
+    start(
+      "benchmark_tricycle_controller",
+      {rclcpp::Parameter("traction_joint_name", std::string("traction_joint")),
+       rclcpp::Parameter("steering_joint_name", std::string("steering_joint")),
+       rclcpp::Parameter("wheelbase", 1.0), rclcpp::Parameter("wheel_radius", 0.1)});
+  }
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(DiffDriveControllerBenchmark, update)(benchmark::State & state)
+{
+  run(
+    state,
+    [this](const rclcpp::Time & time)
+    {
+      for (size_t i = 0; i < wheel_positions_.size(); ++i)
+      {
+        *wheel_positions_[i] += *wheel_velocities_[i] * CYCLE_PERIOD.seconds();
+      }
+      controller_->set_velocity_command(time);
+    });
+}
+
+BENCHMARK_REGISTER_F(DiffDriveControllerBenchmark, update)
+  ->ArgNames({"wheels_per_side", "position_feedback"})
+  ->ArgsProduct({{1, 2, 4}, {0, 1}})
+  ->UseManualTime();
+
+BENCHMARK_DEFINE_F(TricycleControllerBenchmark, update)(benchmark::State & state)
+{
+  run(state, [this](const rclcpp::Time & time) { controller_->set_velocity_command(time); });
+}
+
+BENCHMARK_REGISTER_F(TricycleControllerBenchmark, update)->UseManualTime();
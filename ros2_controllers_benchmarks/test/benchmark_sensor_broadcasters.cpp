@@ -0,0 +1,182 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the update() of the imu_sensor_broadcaster and the
+// force_torque_sensor_broadcaster, see controller_benchmark.hpp. Every sensor has new readings in
+// every cycle.
+//
+// Arguments: whether the IMU readings are filtered and the orientation is estimated, the filter of
+// the force torque sensor (see FT_FILTER_TYPES), and the number of sensors of the multi sensor
+// broadcasters.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "controller_benchmark.hpp"
+#include "force_torque_sensor_broadcaster/force_torque_sensor_broadcaster.hpp"
+#include "force_torque_sensor_broadcaster/multi_force_torque_sensor_broadcaster.hpp"
+#include "imu_sensor_broadcaster/imu_sensor_broadcaster.hpp"
+#include "imu_sensor_broadcaster/multi_imu_sensor_broadcaster.hpp"
+
+namespace
+{
+using ros2_controllers_benchmarks::ControllerBenchmark;
+using ros2_controllers_benchmarks::make_names;
+
+const std::vector<std::string> FT_FILTER_TYPES = {"none", "moving_average", "butterworth"};
+
+const std::vector<std::string> IMU_INTERFACES = {
+  "orientation.x",         "orientation.y",         "orientation.z",
+  "orientation.w",         "angular_velocity.x",    "angular_velocity.y",
+  "angular_velocity.z",    "linear_acceleration.x", "linear_acceleration.y",
+  "linear_acceleration.z"};
+
+const std::vector<std::string> FT_INTERFACES = {"force.x",  "force.y",  "force.z",
+                                                "torque.x", "torque.y", "torque.z"};
+
+/// Fixture writing new readings of all interfaces of the sensors before every cycle
+template <typename ControllerT>
+class SensorBroadcasterBenchmark : public ControllerBenchmark<ControllerT>
+{
+protected:
+  void start(
+    const std::vector<rclcpp::Parameter> & parameters,
+    const std::vector<std::string> & sensor_names, const std::vector<std::string> & interfaces)
+  {
+    ControllerBenchmark<ControllerT>::start("benchmark_sensor_broadcaster", parameters);
+    readings_.clear();
+    for (const auto & sensor_name : sensor_names)
+    {
+      for (const auto & interface : interfaces)
+      {
+        readings_.push_back(&this->hardware_.value(sensor_name + "/" + interface));
+      }
+    }
+  }
+
+  void run_with_readings(benchmark::State & state)
+  {
+    this->run(
+      state,
+      [this](const rclcpp::Time & time)
+      {
+        for (size_t i = 0; i < readings_.size(); ++i)
+        {
+          *readings_[i] = 0.1 * std::sin(time.seconds() + 0.1 * static_cast<double>(i));
+        }
+      });
+  }
+
+  std::vector<double *> readings_;
+};
+
+class IMUSensorBroadcasterBenchmark
+: public SensorBroadcasterBenchmark<imu_sensor_broadcaster::IMUSensorBroadcaster>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    const bool filtered = state.range(0) != 0;
+    start(
+      {rclcpp::Parameter("sensor_name", std::string("imu_sensor")),
+       rclcpp::Parameter("frame_id", std::string("imu_link")),
+       rclcpp::Parameter("filter.cutoff_frequency", filtered ? 50.0 : 0.0),
+       rclcpp::Parameter("filter.estimate_orientation", filtered)},
+      {"imu_sensor"}, IMU_INTERFACES);
+  }
+};
+
+class ForceTorqueSensorBroadcasterBenchmark
+: public SensorBroadcasterBenchmark<force_torque_sensor_broadcaster::ForceTorqueSensorBroadcaster>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    start(
+      {rclcpp::Parameter("sensor_name", std::string("ft_sensor")),
+       rclcpp::Parameter("frame_id", std::string("ft_sensor_link")),
+       rclcpp::Parameter("filter.type", FT_FILTER_TYPES[static_cast<size_t>(state.range(0))])},
+      {"ft_sensor"}, FT_INTERFACES);
+  }
+};
+
+class MultiIMUSensorBroadcasterBenchmark
+: public SensorBroadcasterBenchmark<imu_sensor_broadcaster::MultiIMUSensorBroadcaster>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    const auto sensor_names = make_names("imu_sensor", static_cast<size_t>(state.range(0)));
+    start({rclcpp::Parameter("sensor_names", sensor_names)}, sensor_names, IMU_INTERFACES);
+  }
+};
+
+using force_torque_sensor_broadcaster::MultiForceTorqueSensorBroadcaster;
+
+class MultiForceTorqueSensorBroadcasterBenchmark
+: public SensorBroadcasterBenchmark<MultiForceTorqueSensorBroadcaster>
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    const auto sensor_names = make_names("ft_sensor", static_cast<size_t>(state.range(0)));
+    start({rclcpp::Parameter("sensor_names", sensor_names)}, sensor_names, FT_INTERFACES);
+  }
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(IMUSensorBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  run_with_readings(state);
+}
+
+BENCHMARK_REGISTER_F(IMUSensorBroadcasterBenchmark, update)
+  ->ArgNames({"filtered"})
+  ->DenseRange(0, 1)
+  ->UseManualTime();
+
+BENCHMARK_DEFINE_F(ForceTorqueSensorBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  run_with_readings(state);
+}
+
+BENCHMARK_REGISTER_F(ForceTorqueSensorBroadcasterBenchmark, update)
+  ->ArgNames({"filter"})
+  ->DenseRange(0, static_cast<int64_t>(FT_FILTER_TYPES.size()) - 1)
+  ->UseManualTime();
+
+BENCHMARK_DEFINE_F(MultiIMUSensorBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  run_with_readings(state);
+}
+
+BENCHMARK_REGISTER_F(MultiIMUSensorBroadcasterBenchmark, update)
+  ->ArgNames({"sensors"})
+  ->Arg(1)
+  ->Arg(4)
+  ->Arg(16)
+  ->UseManualTime();
+
+BENCHMARK_DEFINE_F(MultiForceTorqueSensorBroadcasterBenchmark, update)(benchmark::State & state)
+{
+  run_with_readings(state);
+}
+
+BENCHMARK_REGISTER_F(MultiForceTorqueSensorBroadcasterBenchmark, update)
+  ->ArgNames({"sensors"})
+  ->Arg(1)
+  ->Arg(4)
+  ->Arg(16)
+  ->UseManualTime();
@@ -0,0 +1,250 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONTROLLER_BENCHMARK_HPP_
+#define CONTROLLER_BENCHMARK_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_interface/controller_interface_base.hpp"
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+// Shared parts of the benchmarks of the update() of the controllers.
+//
+// Every benchmark reports the time per cycle, the heap allocations per cycle and the tail latency
+// of single cycles (p50_ns, p99_ns, max_ns). The controllers run at 1 kHz on a mock hardware.
+//
+// Include this header in only one translation unit of a benchmark executable, it replaces the
+// allocation functions to count the allocations.
+
+namespace ros2_controllers_benchmarks
+{
+const rclcpp::Duration CYCLE_PERIOD = rclcpp::Duration::from_seconds(0.001);
+
+/// Names prefix1, ..., prefixN
+inline std::vector<std::string> make_names(const std::string & prefix, size_t count)
+{
+  std::vector<std::string> names(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    names[i] = prefix + std::to_string(i + 1);
+  }
+  return names;
+}
+
+/// Interfaces of a mock hardware, created for the interfaces a controller claims.
+/**
+ * A state interface with the name of a command interface shares its value, so the states follow
+ * the commands like those of an ideal system. The values keep their addresses until clear().
+ */
+class MockHardware
+{
+public:
+  /// Create the interfaces claimed by the configured controller, and assign them in the order of
+  /// its interface configurations, like the controller manager does.
+  void assign_interfaces(controller_interface::ControllerInterfaceBase & controller)
+  {
+    std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+    std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+    for (const auto & name : get_names(controller.command_interface_configuration()))
+    {
+      command_interfaces_.emplace_back(prefix_of(name), interface_of(name), &value(name));
+      loaned_command_interfaces.emplace_back(command_interfaces_.back());
+    }
+    for (const auto & name : get_names(controller.state_interface_configuration()))
+    {
+      state_interfaces_.emplace_back(prefix_of(name), interface_of(name), &value(name));
+      loaned_state_interfaces.emplace_back(state_interfaces_.back());
+    }
+    controller.assign_interfaces(
+      std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+  }
+
+  /// Value of the interface with the full name, e.g. joint1/position, created if it is new
+  double & value(const std::string & name)
+  {
+    auto it = values_by_name_.find(name);
+    if (it == values_by_name_.end())
+    {
+      values_.push_back(0.0);
+      it = values_by_name_.emplace(name, &values_.back()).first;
+    }
+    return *it->second;
+  }
+
+  void clear()
+  {
+    command_interfaces_.clear();
+    state_interfaces_.clear();
+    values_by_name_.clear();
+    values_.clear();
+  }
+
+private:
+  static const std::vector<std::string> & get_names(
+    const controller_interface::InterfaceConfiguration & configuration)
+  {
+    if (configuration.type == controller_interface::interface_configuration_type::ALL)
+    {
+      throw std::invalid_argument(
+        "the mock hardware only assigns individually claimed interfaces");
+    }
+    return configuration.names;
+  }
+
+  static std::string prefix_of(const std::string & name)
+  {
+    return name.substr(0, name.rfind('/'));
+  }
+
+  static std::string interface_of(const std::string & name)
+  {
+    return name.substr(name.rfind('/') + 1);
+  }
+
+  // deques, which keep the addresses of their elements when they grow
+  std::deque<double> values_;
+  std::unordered_map<std::string, double *> values_by_name_;
+  std::deque<hardware_interface::CommandInterface> command_interfaces_;
+  std::deque<hardware_interface::StateInterface> state_interfaces_;
+};
+
+/// Times of single cycles, to report the tail latency
+class CycleTimes
+{
+public:
+  explicit CycleTimes(const benchmark::State & state)
+  {
+    times_ns_.reserve(static_cast<size_t>(state.max_iterations));
+  }
+
+  void add(std::chrono::steady_clock::duration cycle_time, benchmark::State & state)
+  {
+    const auto cycle_time_ns = std::chrono::duration<double, std::nano>(cycle_time).count();
+    times_ns_.push_back(cycle_time_ns);
+    state.SetIterationTime(cycle_time_ns * 1e-9);
+  }
+
+  void report(benchmark::State & state, size_t allocations)
+  {
+    std::sort(times_ns_.begin(), times_ns_.end());
+    auto percentile = [this](double p)
+    {
+      return times_ns_[static_cast<size_t>(p * static_cast<double>(times_ns_.size() - 1))];
+    };
+    if (!times_ns_.empty())
+    {
+      state.counters["p50_ns"] = percentile(0.5);
+      state.counters["p99_ns"] = percentile(0.99);
+      state.counters["max_ns"] = times_ns_.back();
+    }
+    state.counters["allocations"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  std::vector<double> times_ns_;
+};
+
+/// Fixture running a controller of type ControllerT on the mock hardware
+template <typename ControllerT>
+class ControllerBenchmark : public benchmark::Fixture
+{
+public:
+  void TearDown(benchmark::State &) override
+  {
+    if (controller_)
+    {
+      controller_->get_node()->deactivate();
+      controller_.reset();
+    }
+    hardware_.clear();
+    rclcpp::shutdown();
+  }
+
+protected:
+  /// Initialize the controller with the parameters, configure it, export its reference interfaces
+  /// if it is chainable, assign it the interfaces of the mock hardware and activate it.
+  void start(const std::string & name, const std::vector<rclcpp::Parameter> & parameters)
+  {
+    rclcpp::init(0, nullptr);
+    controller_ = std::make_shared<ControllerT>();
+    const auto options = rclcpp::NodeOptions()
+                           .allow_undeclared_parameters(false)
+                           .parameter_overrides(parameters)
+                           .automatically_declare_parameters_from_overrides(false);
+    controller_->init(name, "", options);
+    controller_->get_node()->configure();
+    if constexpr (std::is_base_of_v<
+                    controller_interface::ChainableControllerInterface, ControllerT>)
+    {
+      // the references are written from the subscribers, but they are sized on export
+      controller_->export_reference_interfaces();
+    }
+    hardware_.assign_interfaces(*controller_);
+    controller_->get_node()->activate();
+  }
+
+  /// Time update() in every iteration of the benchmark.
+  /**
+   * prepare_cycle(time) is called before every cycle, outside of the timing and the counting of
+   * the allocations, e.g. to hand over a command like the callbacks of the subscriptions would.
+   */
+  template <typename PrepareCycle>
+  void run(benchmark::State & state, PrepareCycle && prepare_cycle)
+  {
+    rclcpp::Time time(1, 0, RCL_ROS_TIME);
+    CycleTimes cycle_times(state);
+    controller_realtime_tools::ScopedRealtimeSafetyCounter allocation_counter;
+    for (auto _ : state)
+    {
+      controller_realtime_tools::realtime_safety::counting = false;
+      prepare_cycle(time);
+      controller_realtime_tools::realtime_safety::counting = true;
+      const auto start = std::chrono::steady_clock::now();
+      controller_->update(time, CYCLE_PERIOD);
+      cycle_times.add(std::chrono::steady_clock::now() - start, state);
+      time += CYCLE_PERIOD;
+    }
+    cycle_times.report(state, allocation_counter.get_allocations());
+  }
+
+  void run(benchmark::State & state)
+  {
+    run(state, [](const rclcpp::Time &) {});
+  }
+
+  std::shared_ptr<ControllerT> controller_;
+  MockHardware hardware_;
+};
+
+}  // namespace ros2_controllers_benchmarks
+
+#endif  // CONTROLLER_BENCHMARK_HPP_
@@ -0,0 +1,53 @@
+// Copyright 2020 PAL Robotics SL.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+
+#include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_interface/controller_interface.hpp"
+#include "pluginlib/class_loader.hpp"
+
+namespace
+{
+/// Create every class of the bundle which derives from BaseT, return how many
+template <typename BaseT>
+size_t create_bundled_classes(const std::string & base_class)
+{
+  pluginlib::ClassLoader<BaseT> loader("controller_interface", base_class);
+  size_t created = 0;
+  for (const auto & class_name : loader.getDeclaredClasses())
+  {
+    if (loader.getClassPackage(class_name) != "ros2_controllers_bundle")
+    {
+      continue;
+    }
+    EXPECT_NE(loader.createSharedInstance(class_name), nullptr) << class_name;
+    ++created;
+  }
+  return created;
+}
+}  // namespace
+
+TEST(TestLoadRos2ControllersBundle, all_controllers_load_from_the_bundle)
+{
+  const size_t controllers = create_bundled_classes<controller_interface::ControllerInterface>(
+    "controller_interface::ControllerInterface");
+  const size_t chainable_controllers =
+    create_bundled_classes<controller_interface::ChainableControllerInterface>(
+      "controller_interface::ChainableControllerInterface");
+  EXPECT_GT(controllers, 0u);
+  EXPECT_GT(chainable_controllers, 0u);
+}
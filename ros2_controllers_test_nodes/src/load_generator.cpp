@@ -0,0 +1,443 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Load generator for stress tests of controllers: publishes commands, trajectories and velocity
+ * commands at up to 10 kHz, each stream from its own thread, and measures the latency from
+ * publishing a command until the commanded value shows up in the joint states.
+ *
+ * Publishes to:
+ * - ~/commands (std_msgs/Float64MultiArray), e.g. remapped to a forward command controller
+ * - ~/joint_trajectory (trajectory_msgs/JointTrajectory), e.g. remapped to a joint trajectory
+ *   controller
+ * - cmd_vel (geometry_msgs/TwistStamped, or geometry_msgs/Twist if cmd_vel.stamped is false),
+ *   e.g. remapped to a diff drive controller
+ *
+ * Subscribes to:
+ * - ~/joint_states (sensor_msgs/JointState), e.g. remapped to /joint_states, for the latency of
+ *   ~/commands: the position of the first joint is matched against its last commands, which is
+ *   exact for hardware which mirrors the command to the state, e.g. mock components. The latency
+ *   includes the period of the joint state broadcaster.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "geometry_msgs/msg/twist.hpp"
+#include "geometry_msgs/msg/twist_stamped.hpp"
+#include "rcl_interfaces/msg/parameter_descriptor.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "std_msgs/msg/float64_multi_array.hpp"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
+
+namespace ros2_controllers_test_nodes
+{
+namespace
+{
+// highest rate of a stream in Hz
+constexpr double kMaxRate = 10000.0;
+// commands kept for matching the joint states, a few periods of the joint state broadcaster
+constexpr size_t kSentCommandsCapacity = 4096;
+// latencies kept for latency_file, older ones are still reported
+constexpr size_t kMaxLatencySamples = 1000000;
+constexpr double kTwoPi = 2.0 * M_PI;
+
+using Clock = std::chrono::steady_clock;
+}  // namespace
+
+class LoadGenerator : public rclcpp::Node
+{
+public:
+  LoadGenerator();
+  ~LoadGenerator() override;
+
+private:
+  struct Stream
+  {
+    std::string name;
+    double rate = 0.0;       // Messages per second on average, 0 disables the stream
+    int64_t burst_size = 1;  // Messages published back-to-back
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> overruns{0};  // Bursts published more than a period late
+  };
+
+  struct SentCommand
+  {
+    uint64_t sequence = 0;
+    double value = 0.0;
+    Clock::time_point time;
+  };
+
+  void declare_stream(Stream & stream);
+  void start_stream(Stream & stream, std::function<void(double)> publish);
+  void run_stream(Stream & stream, const std::function<void(double)> & publish);
+
+  /// Position of joint \p index at \p t seconds since the start.
+  double position(size_t index, double t) const;
+
+  void publish_commands(double t);
+  void publish_trajectory(double t);
+  void publish_cmd_vel(double t);
+
+  void joint_state_callback(const sensor_msgs::msg::JointState::SharedPtr msg);
+  void report();
+  void write_latencies() const;
+
+  std::vector<std::string> joint_names_;
+  double amplitude_ = 0.0;
+  double frequency_ = 0.0;
+  int64_t trajectory_points_ = 0;
+  double trajectory_duration_ = 0.0;
+  bool cmd_vel_stamped_ = true;
+  std::string latency_file_;
+  const Clock::time_point start_time_ = Clock::now();
+
+  Stream commands_stream_;
+  Stream trajectory_stream_;
+  Stream cmd_vel_stream_;
+
+  rclcpp::Publisher<std_msgs::msg::Float64MultiArray>::SharedPtr commands_publisher_;
+  rclcpp::Publisher<trajectory_msgs::msg::JointTrajectory>::SharedPtr trajectory_publisher_;
+  rclcpp::Publisher<geometry_msgs::msg::TwistStamped>::SharedPtr cmd_vel_stamped_publisher_;
+  rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_publisher_;
+  // allocated once, only used by the thread of their stream
+  std_msgs::msg::Float64MultiArray commands_msg_;
+  trajectory_msgs::msg::JointTrajectory trajectory_msg_;
+  geometry_msgs::msg::TwistStamped cmd_vel_msg_;
+
+  rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr joint_state_subscriber_;
+  rclcpp::TimerBase::SharedPtr report_timer_;
+
+  std::mutex latency_mutex_;
+  // ring of the last commands, by sequence number
+  std::vector<SentCommand> sent_commands_;
+  uint64_t sent_sequence_ = 0;
+  uint64_t matched_sequence_ = 0;
+  // latencies in seconds, all and since the last report
+  std::vector<double> latencies_;
+  std::vector<double> report_latencies_;
+
+  std::atomic<bool> keep_running_{true};
+  std::vector<std::thread> threads_;
+};
+
+LoadGenerator::LoadGenerator() : rclcpp::Node("load_generator")
+{
+  joint_names_ = declare_parameter<std::vector<std::string>>("joint_names", {});
+  const auto joint_count = declare_parameter<int64_t>("joint_count", 6);
+  if (joint_names_.empty())
+  {
+    for (int64_t i = 1; i <= joint_count; ++i)
+    {
+      joint_names_.push_back("joint" + std::to_string(i));
+    }
+  }
+  amplitude_ = declare_parameter<double>("amplitude", 0.5);
+  frequency_ = declare_parameter<double>("frequency", 0.5);
+  trajectory_points_ =
+    std::max<int64_t>(1, declare_parameter<int64_t>("joint_trajectory.points", 10));
+  trajectory_duration_ = declare_parameter<double>("joint_trajectory.duration", 1.0);
+  cmd_vel_stamped_ = declare_parameter<bool>("cmd_vel.stamped", true);
+  latency_file_ = declare_parameter<std::string>("latency_file", "");
+  const double report_period = declare_parameter<double>("report_period", 1.0);
+
+  commands_stream_.name = "commands";
+  commands_stream_.rate = 100.0;
+  declare_stream(commands_stream_);
+  trajectory_stream_.name = "joint_trajectory";
+  declare_stream(trajectory_stream_);
+  cmd_vel_stream_.name = "cmd_vel";
+  declare_stream(cmd_vel_stream_);
+
+  commands_publisher_ =
+    create_publisher<std_msgs::msg::Float64MultiArray>("~/commands", rclcpp::SystemDefaultsQoS());
+  trajectory_publisher_ = create_publisher<trajectory_msgs::msg::JointTrajectory>(
+    "~/joint_trajectory", rclcpp::SystemDefaultsQoS());
+  if (cmd_vel_stamped_)
+  {
+    cmd_vel_stamped_publisher_ =
+      create_publisher<geometry_msgs::msg::TwistStamped>("cmd_vel", rclcpp::SystemDefaultsQoS());
+  }
+  else
+  {
+    cmd_vel_publisher_ =
+      create_publisher<geometry_msgs::msg::Twist>("cmd_vel", rclcpp::SystemDefaultsQoS());
+  }
+
+  commands_msg_.data.resize(joint_names_.size(), 0.0);
+  trajectory_msg_.joint_names = joint_names_;
+  trajectory_msg_.points.resize(static_cast<size_t>(trajectory_points_));
+  for (auto & point : trajectory_msg_.points)
+  {
+    point.positions.resize(joint_names_.size(), 0.0);
+  }
+
+  sent_commands_.resize(kSentCommandsCapacity);
+  latencies_.reserve(kMaxLatencySamples);
+  joint_state_subscriber_ = create_subscription<sensor_msgs::msg::JointState>(
+    "~/joint_states", rclcpp::SensorDataQoS(),
+    [this](const sensor_msgs::msg::JointState::SharedPtr msg) { joint_state_callback(msg); });
+  if (report_period > 0.0)
+  {
+    report_timer_ = create_wall_timer(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(report_period)),
+      [this]() { report(); });
+  }
+
+  start_stream(commands_stream_, [this](double t) { publish_commands(t); });
+  start_stream(trajectory_stream_, [this](double t) { publish_trajectory(t); });
+  start_stream(cmd_vel_stream_, [this](double t) { publish_cmd_vel(t); });
+}
+
+LoadGenerator::~LoadGenerator()
+{
+  keep_running_.store(false);
+  for (auto & thread : threads_)
+  {
+    thread.join();
+  }
+  write_latencies();
+}
+
+void LoadGenerator::declare_stream(Stream & stream)
+{
+  rcl_interfaces::msg::ParameterDescriptor rate_descriptor;
+  rate_descriptor.description = "Messages per second on ~/" + stream.name + ", 0 to disable it";
+  rate_descriptor.floating_point_range.resize(1);
+  rate_descriptor.floating_point_range[0].from_value = 0.0;
+  rate_descriptor.floating_point_range[0].to_value = kMaxRate;
+  stream.rate = declare_parameter<double>(stream.name + ".rate", stream.rate, rate_descriptor);
+
+  rcl_interfaces::msg::ParameterDescriptor burst_descriptor;
+  burst_descriptor.description =
+    "Messages published back-to-back, the bursts keep the average rate";
+  burst_descriptor.integer_range.resize(1);
+  burst_descriptor.integer_range[0].from_value = 1;
+  burst_descriptor.integer_range[0].to_value = 10000;
+  stream.burst_size =
+    declare_parameter<int64_t>(stream.name + ".burst_size", stream.burst_size, burst_descriptor);
+}
+
+void LoadGenerator::start_stream(Stream & stream, std::function<void(double)> publish)
+{
+  if (stream.rate <= 0.0)
+  {
+    return;
+  }
+  RCLCPP_INFO(
+    get_logger(), "Publishing %s at %.1f Hz in bursts of %zu", stream.name.c_str(), stream.rate,
+    static_cast<size_t>(stream.burst_size));
+  threads_.emplace_back(
+    [this, &stream, publish = std::move(publish)]() { run_stream(stream, publish); });
+}
+
+void LoadGenerator::run_stream(Stream & stream, const std::function<void(double)> & publish)
+{
+  const auto period = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(static_cast<double>(stream.burst_size) / stream.rate));
+  auto next_burst = Clock::now();
+  while (keep_running_.load() && rclcpp::ok())
+  {
+    std::this_thread::sleep_until(next_burst);
+    for (int64_t i = 0; i < stream.burst_size; ++i)
+    {
+      publish(std::chrono::duration<double>(Clock::now() - start_time_).count());
+    }
+    stream.published.fetch_add(static_cast<uint64_t>(stream.burst_size));
+
+    next_burst += period;
+    // don't catch up on missed bursts, that would exceed the rate
+    const auto now = Clock::now();
+    if (now > next_burst + period)
+    {
+      stream.overruns.fetch_add(1);
+      next_burst = now;
+    }
+  }
+}
+
+double LoadGenerator::position(size_t index, double t) const
+{
+  const double phase =
+    kTwoPi * static_cast<double>(index) / static_cast<double>(joint_names_.size());
+  return amplitude_ * std::sin(kTwoPi * frequency_ * t + phase);
+}
+
+void LoadGenerator::publish_commands(double t)
+{
+  for (size_t i = 0; i < commands_msg_.data.size(); ++i)
+  {
+    commands_msg_.data[i] = position(i, t);
+  }
+  if (!commands_msg_.data.empty())
+  {
+    std::lock_guard<std::mutex> guard(latency_mutex_);
+    ++sent_sequence_;
+    auto & sent = sent_commands_[sent_sequence_ % sent_commands_.size()];
+    sent.sequence = sent_sequence_;
+    sent.value = commands_msg_.data[0];
+    sent.time = Clock::now();
+  }
+  commands_publisher_->publish(commands_msg_);
+}
+
+void LoadGenerator::publish_trajectory(double t)
+{
+  for (size_t k = 0; k < trajectory_msg_.points.size(); ++k)
+  {
+    auto & point = trajectory_msg_.points[k];
+    const double time_from_start = trajectory_duration_ * static_cast<double>(k + 1) /
+                                   static_cast<double>(trajectory_msg_.points.size());
+    point.time_from_start = rclcpp::Duration::from_seconds(time_from_start);
+    for (size_t i = 0; i < point.positions.size(); ++i)
+    {
+      point.positions[i] = position(i, t + time_from_start);
+    }
+  }
+  trajectory_publisher_->publish(trajectory_msg_);
+}
+
+void LoadGenerator::publish_cmd_vel(double t)
+{
+  cmd_vel_msg_.twist.linear.x = amplitude_ * std::sin(kTwoPi * frequency_ * t);
+  cmd_vel_msg_.twist.angular.z = amplitude_ * std::cos(kTwoPi * frequency_ * t);
+  if (cmd_vel_stamped_publisher_)
+  {
+    cmd_vel_msg_.header.stamp = now();
+    cmd_vel_stamped_publisher_->publish(cmd_vel_msg_);
+  }
+  else
+  {
+    cmd_vel_publisher_->publish(cmd_vel_msg_.twist);
+  }
+}
+
+void LoadGenerator::joint_state_callback(const sensor_msgs::msg::JointState::SharedPtr msg)
+{
+  const auto received = Clock::now();
+  if (joint_names_.empty())
+  {
+    return;
+  }
+  const auto name = std::find(msg->name.begin(), msg->name.end(), joint_names_[0]);
+  const auto index = static_cast<size_t>(std::distance(msg->name.begin(), name));
+  if (name == msg->name.end() || index >= msg->position.size())
+  {
+    return;
+  }
+  const double value = msg->position[index];
+
+  std::lock_guard<std::mutex> guard(latency_mutex_);
+  // newest first, a command is matched once
+  uint64_t oldest = matched_sequence_;
+  if (sent_sequence_ > sent_commands_.size())
+  {
+    oldest = std::max<uint64_t>(oldest, sent_sequence_ - sent_commands_.size());
+  }
+  for (uint64_t sequence = sent_sequence_; sequence > oldest; --sequence)
+  {
+    const auto & sent = sent_commands_[sequence % sent_commands_.size()];
+    if (sent.value == value)
+    {
+      const double latency = std::chrono::duration<double>(received - sent.time).count();
+      if (latencies_.size() < kMaxLatencySamples)
+      {
+        latencies_.push_back(latency);
+      }
+      report_latencies_.push_back(latency);
+      matched_sequence_ = sequence;
+      return;
+    }
+  }
+}
+
+void LoadGenerator::report()
+{
+  std::vector<double> latencies;
+  {
+    std::lock_guard<std::mutex> guard(latency_mutex_);
+    latencies.swap(report_latencies_);
+  }
+  for (const auto * stream : {&commands_stream_, &trajectory_stream_, &cmd_vel_stream_})
+  {
+    if (stream->rate > 0.0)
+    {
+      RCLCPP_INFO(
+        get_logger(), "%s: %zu published, %zu overruns", stream->name.c_str(),
+        static_cast<size_t>(stream->published.load()),
+        static_cast<size_t>(stream->overruns.load()));
+    }
+  }
+  if (latencies.empty())
+  {
+    return;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0.0;
+  for (const double latency : latencies)
+  {
+    sum += latency;
+  }
+  const auto percentile = [&latencies](double p)
+  { return latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))]; };
+  RCLCPP_INFO(
+    get_logger(),
+    "command-to-interface latency of %zu commands [ms]: min %.3f, mean %.3f, median %.3f, "
+    "99%% %.3f, max %.3f",
+    latencies.size(), 1e3 * latencies.front(), 1e3 * sum / static_cast<double>(latencies.size()),
+    1e3 * percentile(0.5), 1e3 * percentile(0.99), 1e3 * latencies.back());
+}
+
+void LoadGenerator::write_latencies() const
+{
+  if (latency_file_.empty())
+  {
+    return;
+  }
+  std::ofstream file(latency_file_);
+  if (!file)
+  {
+    RCLCPP_ERROR(get_logger(), "Can't write the latencies to '%s'", latency_file_.c_str());
+    return;
+  }
+  file << "latency_s\n";
+  for (const double latency : latencies_)
+  {
+    file << latency << "\n";
+  }
+}
+
+}  // namespace ros2_controllers_test_nodes
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<ros2_controllers_test_nodes::LoadGenerator>();
+  rclcpp::spin(node);
+  node.reset();
+  rclcpp::shutdown();
+  return 0;
+}
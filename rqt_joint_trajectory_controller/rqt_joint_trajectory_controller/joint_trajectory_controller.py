@@ -21,9 +21,12 @@ from ament_index_python.packages import get_package_share_directory
 
 from qt_gui.plugin import Plugin
 from python_qt_binding import loadUi
-from python_qt_binding.QtCore import QTimer, Signal
+from python_qt_binding.QtCore import QTimer
 from python_qt_binding.QtWidgets import QWidget, QFormLayout
 
+from rclpy.qos import QoSProfile, ReliabilityPolicy
+from rclpy.serialization import deserialize_message
+
 from control_msgs.msg import JointTrajectoryControllerState
 from trajectory_msgs.msg import JointTrajectory, JointTrajectoryPoint
 
@@ -95,8 +98,6 @@ class JointTrajectoryController(Plugin):
     _ctrlrs_update_freq = 1  # Hz
     _min_traj_dur = 5.0 / _cmd_pub_freq  # Minimum trajectory duration
 
-    jointStateChanged = Signal([dict])
-
     def __init__(self, context):
         super().__init__(context)
         self.setObjectName("JointTrajectoryController")
@@ -145,9 +146,13 @@ class JointTrajectoryController(Plugin):
         self._cm_ns = []  # Namespace of the selected controller manager
         self._joint_pos = {}  # name->pos map for joints of selected controller
         self._joint_names = []  # Ordered list of selected controller joints
+        self._joint_widget_list = []  # Joint widgets, in the order of _joint_names
+        self._latest_state = None  # Serialized state, deserialized when the widgets refresh
+        self._last_cmd = None  # Commanded positions and speed scale last sent to the controller
         self._robot_joint_limits = {}  # Lazily evaluated on first use
 
-        # Timer for sending commands to active controller
+        # Timer for sending commands to active controller: the slider changes in between are
+        # coalesced into one trajectory, which is only sent if the command changed
         self._update_cmd_timer = QTimer(self)
         self._update_cmd_timer.setInterval(int(1000.0 / self._cmd_pub_freq))
         self._update_cmd_timer.timeout.connect(self._update_cmd_cb)
@@ -252,11 +257,6 @@ class JointTrajectoryController(Plugin):
     def _on_speed_scaling_change(self, val):
         self._speed_scale = val / self._speed_scaling_widget.slider.maximum()
 
-    def _on_joint_state_change(self, current_pos):
-        assert len(current_pos) == len(self._joint_pos)
-        for name in current_pos.keys():
-            self._joint_pos[name]["position"] = current_pos[name]
-
     def _on_cm_change(self, cm_ns):
         self._cm_ns = cm_ns
         if cm_ns:
@@ -290,6 +290,7 @@ class JointTrajectoryController(Plugin):
 
         if val:
             # Widgets send reference position commands to controller
+            self._last_cmd = None
             self._update_act_pos_timer.stop()
             self._update_cmd_timer.start()
         else:
@@ -313,6 +314,7 @@ class JointTrajectoryController(Plugin):
                 limits = self._robot_joint_limits[name]
                 joint_widget = DoubleEditor(limits["min_position"], limits["max_position"])
                 layout.addRow(name, joint_widget)
+                self._joint_widget_list.append(joint_widget)
                 # NOTE: Using partial instead of a lambda because lambdas
                 # "will not evaluate/look up the argument values before it is
                 # effectively called, breaking situations like using a loop
@@ -334,25 +336,20 @@ class JointTrajectoryController(Plugin):
         jtc_ns = _resolve_controller_ns(self._cm_ns, self._jtc_name)
         state_topic = jtc_ns + "/controller_state"
         cmd_topic = jtc_ns + "/joint_trajectory"
+        # The state is often published in every control cycle: only keep the latest message,
+        # without acknowledging it, and defer deserializing it to the refresh timers
+        state_qos = QoSProfile(depth=1, reliability=ReliabilityPolicy.BEST_EFFORT)
         self._state_sub = self._node.create_subscription(
-            JointTrajectoryControllerState, state_topic, self._state_cb, 1
+            JointTrajectoryControllerState, state_topic, self._state_cb, state_qos, raw=True
         )
         self._cmd_pub = self._node.create_publisher(JointTrajectory, cmd_topic, 1)
 
-        self.jointStateChanged.connect(self._on_joint_state_change)
-
         self._executor = rclpy.executors.SingleThreadedExecutor()
         self._executor.add_node(self._node)
         self._executor_thread = threading.Thread(target=self._executor.spin, daemon=True)
         self._executor_thread.start()
 
     def _unload_jtc(self):
-        # Stop updating the joint positions
-        try:
-            self.jointStateChanged.disconnect(self._on_joint_state_change)
-        except Exception:
-            pass
-
         # Reset ROS interfaces
         self._unregister_state_sub()
         self._unregister_cmd_pub()
@@ -372,7 +369,9 @@ class JointTrajectoryController(Plugin):
 
         # Reset joint data
         self._joint_names = []
+        self._joint_widget_list = []
         self._joint_pos = {}
+        self._latest_state = None
 
         # Enforce monitor mode (sending commands disabled)
         self._widget.enable_button.setChecked(False)
@@ -404,31 +403,43 @@ class JointTrajectoryController(Plugin):
             self._executor = None
 
     def _state_cb(self, msg):
-        current_pos = {}
-        for i in range(len(msg.joint_names)):
-            joint_name = msg.joint_names[i]
-            joint_pos = msg.feedback.positions[i]
-            current_pos[joint_name] = joint_pos
-        self.jointStateChanged.emit(current_pos)
+        # Runs in the executor thread, possibly at the control rate: only replace the latest
+        # message, it is processed at the refresh rate of the GUI
+        self._latest_state = msg
+
+    def _update_joint_pos(self):
+        # Take the latest state received since the previous update, if any
+        msg, self._latest_state = self._latest_state, None
+        if msg is None:
+            return
+        msg = deserialize_message(msg, JointTrajectoryControllerState)
+        for joint_name, joint_pos in zip(msg.joint_names, msg.feedback.positions):
+            if joint_name in self._joint_pos:
+                self._joint_pos[joint_name]["position"] = joint_pos
 
     def _update_single_cmd_cb(self, val, name):
         self._joint_pos[name]["command"] = val
 
     def _update_cmd_cb(self):
+        self._update_joint_pos()
         dur = []
         traj = JointTrajectory()
         traj.joint_names = self._joint_names
         point = JointTrajectoryPoint()
         for name in traj.joint_names:
             pos = self._joint_pos[name]["position"]
-            cmd = pos
-            try:
-                cmd = self._joint_pos[name]["command"]
-            except (KeyError):
-                pass
+            # joints without a command hold the position they had when the first one was sent
+            cmd = self._joint_pos[name].setdefault("command", pos)
             max_vel = self._robot_joint_limits[name]["max_velocity"]
             dur.append(max(abs(cmd - pos) / max_vel, self._min_traj_dur))
             point.positions.append(cmd)
+
+        # every trajectory replaces the executed one in the controller, don't resend it
+        cmd = (tuple(point.positions), self._speed_scale)
+        if cmd == self._last_cmd:
+            return
+        self._last_cmd = cmd
+
         duration = rclpy.duration.Duration(seconds=(max(dur) / self._speed_scale))
         point.time_from_start = duration.to_msg()
         traj.points.append(point)
@@ -436,21 +447,17 @@ class JointTrajectoryController(Plugin):
         self._cmd_pub.publish(traj)
 
     def _update_joint_widgets(self):
-        joint_widgets = self._joint_widgets()
-        for id in range(len(joint_widgets)):
-            joint_name = self._joint_names[id]
+        self._update_joint_pos()
+        for joint_name, joint_widget in zip(self._joint_names, self._joint_widgets()):
             try:
                 joint_pos = self._joint_pos[joint_name]["position"]
-                joint_widgets[id].setValue(joint_pos)
+                joint_widget.setValue(joint_pos)
             except (KeyError):
                 pass  # Can happen when first connected to controller
 
-    def _joint_widgets(self):  # TODO: Cache instead of compute every time?
-        widgets = []
-        layout = self._widget.joint_group.layout()
-        for row_id in range(layout.rowCount()):
-            widgets.append(layout.itemAt(row_id, QFormLayout.FieldRole).widget())
-        return widgets
+    def _joint_widgets(self):
+        # Cached when the controller is loaded, the layout does not change until it is unloaded
+        return self._joint_widget_list
 
 
 def _jtc_joint_names(jtc_info):
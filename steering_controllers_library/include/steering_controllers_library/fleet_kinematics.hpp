@@ -0,0 +1,123 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STEERING_CONTROLLERS_LIBRARY__FLEET_KINEMATICS_HPP_
+#define STEERING_CONTROLLERS_LIBRARY__FLEET_KINEMATICS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "controller_realtime_tools/pose_integration.hpp"
+#include "steering_controllers_library/steering_kinematics.hpp"
+
+namespace steering_odometry
+{
+/**
+ * \brief Kinematics of a fleet of identical steered robots, stepped together without a controller
+ * per robot.
+ *
+ * Every step computes the joint commands of each robot for its commanded velocities with the
+ * inverse kinematics of SteeringOdometry::get_commands<Model>(). The robot then moves like the
+ * bicycle these are computed for, with the steered wheel turning at the wheel velocity Ws and the
+ * steering at the angle alpha within the step, and its pose is integrated like the odometry of the
+ * controllers. The state of the robots is stored per field for all robots, and disjoint ranges of
+ * robots can be stepped from different threads.
+ *
+ * \tparam Model BicycleModel, TricycleModel, AckermannModel or FourWheelSteerModel
+ */
+template <typename Model>
+class FleetKinematics
+{
+public:
+  /**
+   * \brief Set the number of robots and their geometry, and reset them. Not realtime-safe.
+   * \param geometry Wheel geometry of all robots, its steer_pos is ignored
+   */
+  void configure(size_t num_robots, const KinematicState & geometry)
+  {
+    geometry_ = geometry;
+    x_.resize(num_robots);
+    y_.resize(num_robots);
+    heading_.resize(num_robots);
+    linear_.resize(num_robots);
+    angular_.resize(num_robots);
+    steer_pos_.resize(num_robots);
+    reset();
+  }
+
+  /// Put all robots at the origin, standing still with straight steering.
+  void reset()
+  {
+    for (auto * values : {&x_, &y_, &heading_, &linear_, &angular_, &steer_pos_})
+    {
+      std::fill(values->begin(), values->end(), 0.0);
+    }
+  }
+
+  /**
+   * \brief Step the robots [begin, end) by \p dt.
+   * \param[in] linear_commands Desired linear velocity of every robot [m/s].
+   * \param[in] angular_commands Desired angular velocity of every robot [rad/s].
+   * \param[in] dt Duration of the step [s].
+   * \param[out] joint_commands Joint commands of every robot.
+   */
+  void step(
+    const double * linear_commands, const double * angular_commands, double dt,
+    JointCommands * joint_commands, size_t begin, size_t end)
+  {
+    KinematicState state = geometry_;
+    for (size_t i = begin; i < end; ++i)
+    {
+      state.steer_pos = steer_pos_[i];
+      double Ws, alpha;
+      get_wheel_command(state, linear_commands[i], angular_commands[i], Ws, alpha);
+      Model::get_commands(state, Ws, alpha, joint_commands[i]);
+      joint_commands[i].traction_count = Model::TRACTION_JOINTS;
+      joint_commands[i].steering_count = Model::STEERING_JOINTS;
+
+      // velocity of the steered wheel, split along and across the vehicle
+      const double wheel_velocity = Ws * geometry_.wheel_radius;
+      steer_pos_[i] = alpha;
+      linear_[i] = wheel_velocity * std::cos(alpha);
+      angular_[i] = wheel_velocity * std::sin(alpha) / geometry_.wheelbase;
+    }
+    controller_realtime_tools::integrate_poses(
+      linear_.data(), angular_.data(), dt, x_.data(), y_.data(), heading_.data(), begin, end);
+  }
+
+  size_t size() const { return x_.size(); }
+
+  // pose [m, m, rad], velocities [m/s, rad/s] and steering angle [rad] of every robot
+  const std::vector<double> & x() const { return x_; }
+  const std::vector<double> & y() const { return y_; }
+  const std::vector<double> & heading() const { return heading_; }
+  const std::vector<double> & linear() const { return linear_; }
+  const std::vector<double> & angular() const { return angular_; }
+  const std::vector<double> & steer_pos() const { return steer_pos_; }
+
+private:
+  KinematicState geometry_{};
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> heading_;
+  std::vector<double> linear_;
+  std::vector<double> angular_;
+  std::vector<double> steer_pos_;
+};
+
+}  // namespace steering_odometry
+
+#endif  // STEERING_CONTROLLERS_LIBRARY__FLEET_KINEMATICS_HPP_
@@ -0,0 +1,93 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STEERING_CONTROLLERS_LIBRARY__MULTI_WHEEL_KINEMATICS_HPP_
+#define STEERING_CONTROLLERS_LIBRARY__MULTI_WHEEL_KINEMATICS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace steering_odometry
+{
+/**
+ * \brief Kinematics of a vehicle with any number of traction wheels, each steered or not
+ *
+ * Every wheel is described by its position (x_i, y_i) in the base frame. The velocity of its
+ * contact point follows from the twist [vx, vy, wz] of the base,
+ *   v_i = [1, 0, -y_i; 0, 1, x_i] * twist,
+ * and is the wheel velocity times the wheel radius along the steering angle of the wheel, 0 for
+ * the wheels which aren't steered. The twist is estimated from the contact velocities of all
+ * wheels in the least-squares sense, with the pseudo-inverse of the 2N x 3 matrix of the
+ * positions, computed once per set_wheels().
+ *
+ * All wheels have the same radius. The vectors of get_twist() and get_commands() hold a value per
+ * wheel, in the order of set_wheels(), so neither allocates.
+ */
+class MultiWheelKinematics
+{
+public:
+  /**
+   * \brief Sets the wheels and computes the pseudo-inverse of their layout
+   * \param x Positions of the wheels along the x axis of the base [m]
+   * \param y Positions of the wheels along the y axis of the base [m]
+   * \param steered Whether each wheel is steered
+   * \return false, leaving the wheels unchanged, if the sizes differ, there are no wheels, or all
+   * wheels are at the same position
+   */
+  bool set_wheels(
+    const std::vector<double> & x, const std::vector<double> & y,
+    const std::vector<bool> & steered);
+
+  /// Number of wheels, 0 until set_wheels() succeeded
+  size_t size() const { return x_.size(); }
+
+  /**
+   * \brief Estimates the twist of the base from the measured wheel velocities and steering angles
+   * \param wheel_velocities Velocity of each wheel [rad/s]
+   * \param steering_angles Steering angle of each wheel [rad], ignored for wheels not steered
+   * \param wheel_radius Wheel radius [m]
+   * \param twist [vx, vy, wz] of the base [m/s, m/s, rad/s]
+   */
+  void get_twist(
+    const std::vector<double> & wheel_velocities, const std::vector<double> & steering_angles,
+    double wheel_radius, std::array<double, 3> & twist) const;
+
+  /**
+   * \brief Calculates inverse kinematics for the desired twist of the base
+   *
+   * The steering angles are kept within [-pi/2, pi/2], reversing the wheel instead. Wheels whose
+   * contact point stands still keep their steering angle from \p steering_angles.
+   * \param twist Desired [vx, vy, wz] of the base [m/s, m/s, rad/s]
+   * \param wheel_radius Wheel radius [m]
+   * \param wheel_velocities Velocity command of each wheel [rad/s]
+   * \param steering_angles Steering command of each wheel [rad], 0 for wheels not steered
+   */
+  void get_commands(
+    const std::array<double, 3> & twist, double wheel_radius,
+    std::vector<double> & wheel_velocities, std::vector<double> & steering_angles) const;
+
+private:
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<bool> steered_;
+  // rows of the pseudo-inverse for vx, vy and wz, split into the columns of the contact
+  // velocities along the x and along the y axis, one value per wheel
+  std::array<std::vector<double>, 3> pseudo_inverse_x_;
+  std::array<std::vector<double>, 3> pseudo_inverse_y_;
+};
+
+}  // namespace steering_odometry
+
+#endif  // STEERING_CONTROLLERS_LIBRARY__MULTI_WHEEL_KINEMATICS_HPP_
@@ -15,20 +15,32 @@
 #ifndef STEERING_CONTROLLERS_LIBRARY__STEERING_CONTROLLERS_LIBRARY_HPP_
 #define STEERING_CONTROLLERS_LIBRARY__STEERING_CONTROLLERS_LIBRARY_HPP_
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "controller_interface/chainable_controller_interface.hpp"
+#include "controller_realtime_tools/cycle_budget.hpp"
+#include "controller_realtime_tools/input_recorder.hpp"
+#include "controller_realtime_tools/jitter_buffer.hpp"
+#include "controller_realtime_tools/latency_probe.hpp"
+#include "controller_realtime_tools/limiter.hpp"
+#include "controller_realtime_tools/odometry_publisher.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
 #include "hardware_interface/handle.hpp"
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
+#include "statistics_msgs/msg/metrics_message.hpp"
 #include "std_srvs/srv/set_bool.hpp"
 #include "steering_controllers_library/steering_odometry.hpp"
 #include "steering_controllers_library/visibility_control.h"
@@ -93,38 +105,127 @@ protected:
   controller_interface::CallbackReturn set_interface_numbers(
     size_t nr_state_itfs, size_t nr_cmd_itfs, size_t nr_ref_itfs);
 
+  /// Copy the values of all state interfaces into state_values_, in one pass.
+  /**
+   * \return false if any of the values is NaN.
+   */
+  bool read_state_values();
+
+  /// Make \p msg the latest reference, moved into the buffer. Non-realtime.
+  void write_reference(ControllerTwistReferenceMsg msg);
+
+  /// Make \p msg the latest reference, with use_ackermann_reference. Non-realtime.
+  void write_reference(ControllerAckermannReferenceMsg msg);
+
+  /// Latest twist reference written, nullptr if it was consumed. Wait-free, from the control loop.
+  const ControllerTwistReferenceMsg * read_reference();
+
+  /// Apply the reference due from reference_jitter_buffer_ at \p time. Realtime.
+  controller_interface::return_type update_reference_from_jitter_buffer(const rclcpp::Time & time);
+
   std::shared_ptr<steering_controllers_library::ParamListener> param_listener_;
   steering_controllers_library::Params params_;
 
   // Command subscribers and Controller State publisher
   rclcpp::Subscription<ControllerTwistReferenceMsg>::SharedPtr ref_subscriber_twist_ = nullptr;
-  rclcpp::Subscription<ControllerTwistReferenceMsg>::SharedPtr ref_subscriber_ackermann_ = nullptr;
+  rclcpp::Subscription<ControllerAckermannReferenceMsg>::SharedPtr ref_subscriber_ackermann_ =
+    nullptr;
   rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr ref_subscriber_unstamped_ = nullptr;
-  realtime_tools::RealtimeBuffer<std::shared_ptr<ControllerTwistReferenceMsg>> input_ref_;
+  // latest reference of the subscribers, with its number of written references
+  struct ReferenceSlot
+  {
+    ControllerTwistReferenceMsg msg;
+    // reference with use_ackermann_reference, instead of msg
+    ControllerAckermannReferenceMsg ackermann_msg;
+    uint64_t sequence = 0;
+  };
+  // wait-free for the control loop, which never writes into it
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<ReferenceSlot>> input_ref_;
+  std::atomic<uint64_t> written_references_{0};
+  // serializes the writers of input_ref_, never taken by the control loop
+  std::mutex reference_write_mutex_;
+  // references up to this sequence were consumed, by a timeout or the activation, and are not
+  // applied anymore, only accessed by the control loop or while it doesn't run
+  uint64_t consumed_reference_ = 0;
   rclcpp::Duration ref_timeout_ = rclcpp::Duration::from_seconds(0.0);  // 0ms
-
-  using ControllerStatePublisherOdom = realtime_tools::RealtimePublisher<ControllerStateMsgOdom>;
-  using ControllerStatePublisherTf = realtime_tools::RealtimePublisher<ControllerStateMsgTf>;
+  // linear and angular reference of a received message
+  struct ReferenceValues
+  {
+    double linear = 0.0;
+    double angular = 0.0;
+  };
+  // received references played out in the order of their stamps, up to 32 waiting for their
+  // turn, nullptr unless jitter_buffer.enable is set; pushed under reference_write_mutex_
+  using ReferenceJitterBuffer = controller_realtime_tools::JitterBuffer<ReferenceValues, 32>;
+  std::unique_ptr<ReferenceJitterBuffer> reference_jitter_buffer_;
+
+  // publishes the odometry and its transform at odom_publish_rate from its own thread
+  using OdometryStatePublisher = controller_realtime_tools::OdometryPublisher<
+    ControllerStateMsgOdom, rclcpp::Publisher<ControllerStateMsgOdom>, ControllerStateMsgTf,
+    rclcpp::Publisher<ControllerStateMsgTf>>;
 
   rclcpp::Publisher<ControllerStateMsgOdom>::SharedPtr odom_s_publisher_;
   rclcpp::Publisher<ControllerStateMsgTf>::SharedPtr tf_odom_s_publisher_;
 
-  std::unique_ptr<ControllerStatePublisherOdom> rt_odom_state_publisher_;
-  std::unique_ptr<ControllerStatePublisherTf> rt_tf_odom_state_publisher_;
+  std::unique_ptr<OdometryStatePublisher> odom_state_publisher_;
+
+  // values of state_interfaces_, read once per update before update_odometry(), sized at
+  // activation
+  std::vector<double> state_values_;
+  // no value of state_values_ is NaN
+  bool state_values_valid_ = false;
 
   // override methods from ChainableControllerInterface
   std::vector<hardware_interface::CommandInterface> on_export_reference_interfaces() override;
 
+  // odometry/x, odometry/y, odometry/heading, odometry/linear_velocity and
+  // odometry/angular_velocity, the odometry of the last update for the following controllers
+  std::vector<hardware_interface::StateInterface> on_export_state_interfaces() override;
+
   bool on_set_chained_mode(bool chained_mode) override;
 
   /// Odometry:
   steering_odometry::SteeringOdometry odometry_;
+  // commands of the last update, computed in place
+  steering_odometry::JointCommands joint_commands_;
+
+  // limits of the traction and steering commands, one channel per joint, the NaN ones not applied
+  using JointLimiter = controller_realtime_tools::Limiter<steering_odometry::MAX_COMMANDED_JOINTS>;
+  JointLimiter traction_limiter_;
+  JointLimiter steering_limiter_;
+  // limited commands of the last two updates, the latest first, cleared at activation
+  std::array<steering_odometry::JointCommands, 2> previous_commands_{};
 
   AckermanControllerState published_state_;
 
-  using ControllerStatePublisher = realtime_tools::RealtimePublisher<AckermanControllerState>;
+  using ControllerStatePublisher = controller_realtime_tools::RealtimeSwapPublisher<
+    AckermanControllerState, rclcpp::Publisher<AckermanControllerState>>;
   rclcpp::Publisher<AckermanControllerState>::SharedPtr controller_s_publisher_;
   std::unique_ptr<ControllerStatePublisher> controller_state_publisher_;
+  AckermanControllerState controller_state_msg_;
+
+  // latency from publishing a reference to writing its commands, nullptr unless
+  // command_latency.enable is set
+  std::unique_ptr<controller_realtime_tools::LatencyProbe> command_latency_;
+  rclcpp::Publisher<statistics_msgs::msg::MetricsMessage>::SharedPtr command_latency_publisher_;
+  rclcpp::TimerBase::SharedPtr command_latency_timer_;
+  rclcpp::Time command_latency_window_start_;
+
+  // non-essential stages of update(), skipped while over the cycle budget
+  enum ShedStage : size_t
+  {
+    SHED_CONTROLLER_STATE,
+  };
+  // nullptr unless cycle_budget.enable is set
+  std::unique_ptr<controller_realtime_tools::CycleBudget> cycle_budget_;
+  rclcpp::TimerBase::SharedPtr cycle_budget_timer_;
+
+  // records the inputs of every update while active, nullptr unless input_recording.enable is set
+  std::unique_ptr<controller_realtime_tools::InputRecorder> input_recorder_;
+
+  // traction and steering wheels of the controller state, its arrays are sized at configure
+  size_t nr_traction_wheels_ = 0;
+  size_t nr_steering_wheels_ = 0;
 
   // name constants for state interfaces
   size_t nr_state_itfs_;
@@ -145,8 +246,18 @@ protected:
 private:
   // callback for topic interface
   STEERING_CONTROLLERS__VISIBILITY_LOCAL void reference_callback(
-    const std::shared_ptr<ControllerTwistReferenceMsg> msg);
-  void reference_callback_unstamped(const std::shared_ptr<geometry_msgs::msg::Twist> msg);
+    std::unique_ptr<ControllerTwistReferenceMsg> msg);
+  void reference_callback_unstamped(std::unique_ptr<geometry_msgs::msg::Twist> msg);
+  void reference_callback_ackermann(std::unique_ptr<ControllerAckermannReferenceMsg> msg);
+  // sets the limiters from the traction and steering parameters, false if they are invalid
+  bool configure_limiters();
+  // limits joint_commands_ by the commands of the last two updates and remembers them
+  void limit_joint_commands(double dt);
+  // sets a missing stamp of a received reference to now, false if the reference timed out
+  bool is_reference_stamp_valid(std_msgs::msg::Header & header);
+  // notes a reference received with the original \p stamp_ns, 0 if unstamped, for the latency
+  void note_reference_received(int64_t stamp_ns);
+  void publish_command_latency();
 };
 
 }  // namespace steering_controllers_library
@@ -0,0 +1,234 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STEERING_CONTROLLERS_LIBRARY__STEERING_KINEMATICS_HPP_
+#define STEERING_CONTROLLERS_LIBRARY__STEERING_KINEMATICS_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace steering_odometry
+{
+const unsigned int BICYCLE_CONFIG = 0;
+const unsigned int TRICYCLE_CONFIG = 1;
+const unsigned int ACKERMANN_CONFIG = 2;
+const unsigned int FOUR_STEERING_CONFIG = 3;
+
+/// Most traction or steering joints of a configuration, the four of FOUR_STEERING_CONFIG
+const size_t MAX_COMMANDED_JOINTS = 4;
+
+/**
+ * \brief Commands of the traction and steering joints, in place and without allocations
+ */
+struct JointCommands
+{
+  std::array<double, MAX_COMMANDED_JOINTS> traction{};  // [rad/s]
+  std::array<double, MAX_COMMANDED_JOINTS> steering{};  // [rad]
+  // number of commands set in traction and steering
+  size_t traction_count = 0;
+  size_t steering_count = 0;
+};
+
+/**
+ * \brief Wheel geometry and state the inverse kinematics of the models depend on
+ */
+struct KinematicState
+{
+  double wheel_radius;       // [m]
+  double wheelbase;          // [m]
+  double wheel_track;        // [m]
+  double y_steering_offset;  // [m]
+  // measured steering angle [rad]
+  double steer_pos;
+};
+
+/*
+ * Inverse kinematics of the vehicle models, from the desired velocity Ws [rad/s] of the wheel and
+ * the desired steering angle alpha [rad] at the middle of the traction and steering axes.
+ *
+ * Each model has its numbers of joints and its configuration known at compile time, so
+ * SteeringOdometry::get_commands<Model>() is inlined without branching on the configuration.
+ */
+
+/**
+ * \brief Steering angle of the bicycle equivalent to a right and a left steering wheel
+ *
+ * The tangent of the equivalent angle is the harmonic mean of the tangents of the wheels, so that
+ * all wheels turn around the same point.
+ * \param right_steer_pos Right steer wheel position [rad]
+ * \param left_steer_pos Left steer wheel position [rad]
+ * \return equivalent steering angle [rad], 0 if both wheels are within 1 mrad of straight
+ */
+inline double equivalent_steering_angle(double right_steer_pos, double left_steer_pos)
+{
+  if (std::fabs(right_steer_pos) <= 0.001 && std::fabs(left_steer_pos) <= 0.001)
+  {
+    return 0.0;
+  }
+  const double tan_right = std::tan(right_steer_pos);
+  const double tan_left = std::tan(left_steer_pos);
+  return std::atan(2 * tan_right * tan_left / (tan_right + tan_left));
+}
+
+/**
+ * \brief Desired velocity and steering angle of the middle of the traction and steering axes,
+ * shared by the kinematic models
+ * \param state Wheel geometry and measured steering angle
+ * \param Vx Desired linear velocity [m/s]
+ * \param theta_dot Desired angular velocity [rad/s]
+ * \param Ws Desired wheel velocity [rad/s]
+ * \param alpha Desired steering angle [rad]
+ */
+inline void get_wheel_command(
+  const KinematicState & state, double Vx, double theta_dot, double & Ws, double & alpha)
+{
+  if (Vx == 0 && theta_dot != 0)
+  {
+    alpha = theta_dot > 0 ? M_PI_2 : -M_PI_2;
+    Ws = std::fabs(theta_dot) * state.wheelbase / state.wheel_radius;
+  }
+  else
+  {
+    alpha = (theta_dot == 0 || Vx == 0) ? 0 : std::atan(theta_dot * state.wheelbase / Vx);
+    Ws = Vx / (state.wheel_radius * std::cos(state.steer_pos));
+  }
+}
+
+/// Single traction and single steering wheel
+struct BicycleModel
+{
+  static constexpr unsigned int CONFIG = BICYCLE_CONFIG;
+  static constexpr size_t TRACTION_JOINTS = 1;
+  static constexpr size_t STEERING_JOINTS = 1;
+
+  static void get_commands(
+    const KinematicState &, double Ws, double alpha, JointCommands & commands)
+  {
+    commands.traction[0] = Ws;
+    commands.steering[0] = alpha;
+  }
+};
+
+/// Right and left traction wheels and a single steering wheel
+struct TricycleModel
+{
+  static constexpr unsigned int CONFIG = TRICYCLE_CONFIG;
+  static constexpr size_t TRACTION_JOINTS = 2;
+  static constexpr size_t STEERING_JOINTS = 1;
+
+  static void get_commands(
+    const KinematicState & state, double Ws, double alpha, JointCommands & commands)
+  {
+    if (std::fabs(state.steer_pos) < 1e-6)
+    {
+      commands.traction[0] = Ws;
+      commands.traction[1] = Ws;
+    }
+    else
+    {
+      // Ws * (turning_radius +- wheel_track / 2) / turning_radius,
+      // with turning_radius = wheelbase / tan(steer_pos)
+      const double track_ratio =
+        0.5 * state.wheel_track * std::tan(state.steer_pos) / state.wheelbase;
+      commands.traction[0] = Ws * (1.0 + track_ratio);
+      commands.traction[1] = Ws * (1.0 - track_ratio);
+    }
+    commands.steering[0] = alpha;
+  }
+};
+
+/// Right and left traction wheels and right and left steering wheels
+struct AckermannModel
+{
+  static constexpr unsigned int CONFIG = ACKERMANN_CONFIG;
+  static constexpr size_t TRACTION_JOINTS = 2;
+  static constexpr size_t STEERING_JOINTS = 2;
+
+  static void get_commands(
+    const KinematicState & state, double Ws, double alpha, JointCommands & commands)
+  {
+    if (std::fabs(state.steer_pos) < 1e-6)
+    {
+      commands.traction[0] = Ws;
+      commands.traction[1] = Ws;
+      commands.steering[0] = alpha;
+      commands.steering[1] = alpha;
+      return;
+    }
+    // see TricycleModel
+    const double track_ratio =
+      0.5 * state.wheel_track * std::tan(state.steer_pos) / state.wheelbase;
+    commands.traction[0] = Ws * (1.0 + track_ratio);
+    commands.traction[1] = Ws * (1.0 - track_ratio);
+
+    // sin and cos of the same angle, computed together by the compilers
+    const double sin_alpha = std::sin(alpha);
+    const double cos_alpha = std::cos(alpha);
+    const double numerator = 2 * state.wheelbase * sin_alpha;
+    const double denominator_first_member = 2 * state.wheelbase * cos_alpha;
+    const double denominator_second_member = state.wheel_track * sin_alpha;
+    commands.steering[0] =
+      std::atan2(numerator, denominator_first_member - denominator_second_member);
+    commands.steering[1] =
+      std::atan2(numerator, denominator_first_member + denominator_second_member);
+  }
+};
+
+/// Four traction and four steering wheels, ordered front left, front right, rear left, rear right
+struct FourWheelSteerModel
+{
+  static constexpr unsigned int CONFIG = FOUR_STEERING_CONFIG;
+  static constexpr size_t TRACTION_JOINTS = 4;
+  static constexpr size_t STEERING_JOINTS = 4;
+
+  static void get_commands(
+    const KinematicState & state, double Ws, double alpha, JointCommands & commands)
+  {
+    const double steering_track = state.wheel_track - 2 * state.y_steering_offset;
+    const double vel_steering_offset = (alpha * state.y_steering_offset) / state.wheel_radius;
+    const double sign = std::copysign(1.0, Ws);
+    // the front and rear wheels of a side turn at the same velocity
+    const double vel_left =
+      sign * std::hypot((Ws - alpha * steering_track / 2), (state.wheelbase * alpha / 2.0)) /
+        state.wheel_radius -
+      vel_steering_offset;
+    const double vel_right =
+      sign * std::hypot((Ws + alpha * steering_track / 2), (state.wheelbase * alpha / 2.0)) /
+        state.wheel_radius +
+      vel_steering_offset;
+    commands.traction = {vel_left, vel_right, vel_left, vel_right};
+
+    double front_left_steering = 0.0;
+    double front_right_steering = 0.0;
+    if (std::fabs(2.0 * Ws) > std::fabs(alpha * steering_track))
+    {
+      front_left_steering =
+        std::atan(alpha * state.wheelbase / (2.0 * Ws - alpha * steering_track));
+      front_right_steering =
+        std::atan(alpha * state.wheelbase / (2.0 * Ws + alpha * steering_track));
+    }
+    else if (std::fabs(Ws) > 0.001)
+    {
+      front_left_steering = std::copysign(M_PI_2, alpha);
+      front_right_steering = std::copysign(M_PI_2, alpha);
+    }
+    commands.steering = {
+      front_left_steering, front_right_steering, -front_left_steering, -front_right_steering};
+  }
+};
+
+}  // namespace steering_odometry
+
+#endif  // STEERING_CONTROLLERS_LIBRARY__STEERING_KINEMATICS_HPP_
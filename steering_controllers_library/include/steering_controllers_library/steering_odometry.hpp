@@ -18,20 +18,22 @@
 #ifndef STEERING_CONTROLLERS_LIBRARY__STEERING_ODOMETRY_HPP_
 #define STEERING_CONTROLLERS_LIBRARY__STEERING_ODOMETRY_HPP_
 
+#include <array>
 #include <tuple>
 #include <vector>
 
 #include "realtime_tools/realtime_buffer.h"
 #include "realtime_tools/realtime_publisher.h"
 
-#include "rcpputils/rolling_mean_accumulator.hpp"
+#include "controller_realtime_tools/pose_integration.hpp"
+#include "controller_realtime_tools/smoothing_filter.hpp"
+#include "steering_controllers_library/multi_wheel_kinematics.hpp"
+#include "steering_controllers_library/steering_kinematics.hpp"
 
 namespace steering_odometry
 {
-const unsigned int BICYCLE_CONFIG = 0;
-const unsigned int TRICYCLE_CONFIG = 1;
-const unsigned int ACKERMANN_CONFIG = 2;
-const unsigned int FOUR_STEERING_CONFIG = 3;
+/// Largest velocity rolling window, the filters are preallocated for it
+const size_t MAX_VELOCITY_ROLLING_WINDOW_SIZE = 256;
 
 /**
  * \brief The Odometry class handles odometry readings
@@ -91,19 +93,26 @@ public:
     const double right_steer_pos, const double left_steer_pos, const double dt);
 
   /**
-   * \brief Updates the odometry class with latest wheels position
-   * \param fr_speed Traction wheel velocity [rad/s]
-   * \param fl_speed Steer wheel position [rad]
-   * \param rr_speed time difference to last call
-   * \param rl_speed Traction wheel velocity [rad/s]
-   * \param front_steering Steer wheel position [rad]
-   * \param rear_steering time difference to last call
-   * \param dt Steer wheel position [rad]
+   * \brief Updates the odometry class with latest wheels position of a four wheel steering
+   * \param fr_pos Front right traction wheel position [rad]
+   * \param fl_pos Front left traction wheel position [rad]
+   * \param rr_pos Rear right traction wheel position [rad]
+   * \param rl_pos Rear left traction wheel position [rad]
+   * \param front_steering Equivalent steering angle of the front wheels [rad]
+   * \param rear_steering Equivalent steering angle of the rear wheels [rad]
+   * \param dt time difference to last call
    * \return true if the odometry is actually updated
    */
+  bool update_from_position(
+    const double fr_pos, const double fl_pos, const double rr_pos, const double rl_pos,
+    const double front_steering, const double rear_steering, const double dt);
+
+  /**
+   * \brief Same as the update_from_velocity() of a four wheel steering
+   */
   bool update_four_steering(
-    const double fr_speed, const double fl_speed, const double rr_speed,
-    const double rl_speed, const double front_steering, const double rear_steering, const double dt);
+    const double fr_speed, const double fl_speed, const double rr_speed, const double rl_speed,
+    const double front_steering, const double rear_steering, const double dt);
 
   /**
    * \brief Updates the odometry class with latest wheels position
@@ -140,6 +149,21 @@ public:
     const double right_traction_wheel_vel, const double left_traction_wheel_vel,
     const double right_steer_pos, const double left_steer_pos, const double dt);
 
+  /**
+   * \brief Updates the odometry class with latest wheels velocity of a four wheel steering
+   * \param fr_speed Front right traction wheel velocity [rad/s]
+   * \param fl_speed Front left traction wheel velocity [rad/s]
+   * \param rr_speed Rear right traction wheel velocity [rad/s]
+   * \param rl_speed Rear left traction wheel velocity [rad/s]
+   * \param front_steering Equivalent steering angle of the front wheels [rad]
+   * \param rear_steering Equivalent steering angle of the rear wheels [rad]
+   * \param dt time difference to last call
+   * \return true if the odometry is actually updated
+   */
+  bool update_from_velocity(
+    const double fr_speed, const double fl_speed, const double rr_speed, const double rl_speed,
+    const double front_steering, const double rear_steering, const double dt);
+
   /**
    * \brief Updates the odometry class with latest velocity command
    * \param linear  Linear velocity [m/s]
@@ -148,29 +172,67 @@ public:
    */
   void update_open_loop(const double linear, const double angular, const double dt);
 
+  /**
+   * \brief Updates the odometry with the latest velocities and steering angles of all wheels of
+   * the layout set with set_wheel_positions(), in the least-squares sense
+   * \param wheel_velocities Velocity of each wheel [rad/s]
+   * \param steering_angles  Steering angle of each wheel [rad], ignored for wheels not steered
+   * \param dt               time difference to last call
+   * \return true if the odometry is actually updated, false without a layout or if the sizes
+   * don't match it
+   */
+  bool update_from_wheel_velocities(
+    const std::vector<double> & wheel_velocities, const std::vector<double> & steering_angles,
+    const double dt);
+
   /**
    * \brief Set odometry type
-   * \param type odometry type
+   * \param type odometry type, one of the CONFIG of the kinematic models
    */
   void set_odometry_type(const unsigned int type);
 
+  /**
+   * \brief Set the kinematic model used by get_commands(), and its odometry type
+   * \tparam Model BicycleModel, TricycleModel, AckermannModel or FourWheelSteerModel
+   */
+  template <typename Model>
+  void set_kinematic_model()
+  {
+    config_type_ = static_cast<int>(Model::CONFIG);
+    commands_function_ = &SteeringOdometry::get_model_commands<Model>;
+  }
+
+  /**
+   * \brief Sets the wheel layout of update_from_wheel_velocities() and get_wheel_commands(), for
+   * vehicles with any number of wheels. The least-squares solution of the layout is computed
+   * here, once per change of the wheels.
+   * \param x Positions of the wheels along the x axis of the base [m]
+   * \param y Positions of the wheels along the y axis of the base [m]
+   * \param steered Whether each wheel is steered
+   * \return false, leaving the layout unchanged, if the sizes differ, there are no wheels, or all
+   * wheels are at the same position
+   */
+  bool set_wheel_positions(
+    const std::vector<double> & x, const std::vector<double> & y,
+    const std::vector<bool> & steered);
+
   /**
    * \brief heading getter
    * \return heading [rad]
    */
-  double get_heading() const { return heading_; }
+  double get_heading() const { return pose_.heading(); }
 
   /**
    * \brief x position getter
    * \return x position [m]
    */
-  double get_x() const { return x_; }
+  double get_x() const { return pose_.x(); }
 
   /**
    * \brief y position getter
    * \return y position [m]
    */
-  double get_y() const { return y_; }
+  double get_y() const { return pose_.y(); }
 
   /**
    * \brief linear velocity getter
@@ -184,6 +246,12 @@ public:
    */
   double get_angular() const { return angular_; }
 
+  /**
+   * \brief pose covariance getter
+   * \return covariance of x, y and heading, row-major
+   */
+  const std::array<double, 9> & get_pose_covariance() const { return pose_covariance_; }
+
   /**
    * \brief Sets the wheel parameters: radius, separation and wheelbase
    */
@@ -201,6 +269,41 @@ public:
    */
   void set_velocity_rolling_window_size(size_t velocity_rolling_window_size);
 
+  /**
+   * \brief Velocity smoothing mode setter
+   * \param mode Filter applied over the velocity rolling window
+   */
+  void set_velocity_smoothing_mode(controller_realtime_tools::SmoothingMode mode);
+
+  /**
+   * \brief Sets the parameters of the pose covariance propagation
+   * \param propagate If the pose covariance is propagated with each integration step
+   * \param x_variance Initial variance of x [m^2]
+   * \param y_variance Initial variance of y [m^2]
+   * \param heading_variance Initial variance of the heading [rad^2]
+   * \param linear_noise Variance of the linear displacement per travelled distance [m^2/m]
+   * \param angular_noise Variance of the angular displacement per turned angle [rad^2/rad]
+   */
+  void set_pose_covariance_params(
+    bool propagate, double x_variance, double y_variance, double heading_variance,
+    double linear_noise, double angular_noise);
+
+  /**
+   * \brief Sets the weight of the IMU yaw rate in the complementary blend of the heading
+   * \param weight Weight in [0, 1] of the IMU yaw rate against the yaw rate of the wheels, 0
+   * integrates the wheels only
+   */
+  void set_imu_weight(double weight);
+
+  /**
+   * \brief Sets the yaw rate measured by the IMU, blended into the following odometry updates
+   * \param angular_velocity Yaw rate [rad/s], ignored if NaN
+   */
+  void set_imu_angular_velocity(double angular_velocity)
+  {
+    imu_angular_velocity_ = angular_velocity;
+  }
+
   /**
    * \brief Calculates inverse kinematics for the desired linear and angular velocities
    * \param Vx  Desired linear velocity [m/s]
@@ -209,6 +312,65 @@ public:
    */
   std::tuple<std::vector<double>, std::vector<double>> get_commands(double Vx, double theta_dot);
 
+  /**
+   * \brief Calculates inverse kinematics for the desired linear and angular velocities,
+   * without allocating
+   * \param Vx  Desired linear velocity [m/s]
+   * \param theta_dot Desired angular velocity [rad/s]
+   * \param commands Velocity commands and steering commands of the configuration
+   * \return false if the configuration is not implemented
+   */
+  bool get_commands(double Vx, double theta_dot, JointCommands & commands);
+
+  /**
+   * \brief Calculates inverse kinematics of \p Model for the desired linear and angular
+   * velocities, without allocating
+   * \param Vx  Desired linear velocity [m/s]
+   * \param theta_dot Desired angular velocity [rad/s]
+   * \param commands Velocity commands and steering commands of the model
+   */
+  template <typename Model>
+  void get_commands(double Vx, double theta_dot, JointCommands & commands) const
+  {
+    double Ws, alpha;
+    get_wheel_command(Vx, theta_dot, Ws, alpha);
+    get_model_commands<Model>(Ws, alpha, commands);
+  }
+
+  /**
+   * \brief Calculates inverse kinematics for the desired speed and steering angle of the middle
+   * of the traction and steering axes, e.g. of an ackermann_msgs::msg::AckermannDrive, without
+   * converting them to velocities and back
+   * \param speed  Desired linear velocity [m/s]
+   * \param steering_angle Desired steering angle [rad]
+   * \param commands Velocity commands and steering commands of the configuration
+   * \return false if the configuration is not implemented
+   */
+  bool get_commands_from_steering_angle(
+    double speed, double steering_angle, JointCommands & commands);
+
+  /**
+   * \brief Calculates the angular velocity of a speed and a steering angle
+   * \param speed  Linear velocity [m/s]
+   * \param steering_angle Steering angle [rad]
+   * \return angular velocity [rad/s]
+   */
+  double convert_steering_angle_to_rot_vel(double speed, double steering_angle) const;
+
+  /**
+   * \brief Calculates inverse kinematics of the wheel layout set with set_wheel_positions()
+   * \param Vx  Desired linear velocity [m/s]
+   * \param Vy  Desired lateral velocity [m/s], only followed with enough steered wheels
+   * \param theta_dot Desired angular velocity [rad/s]
+   * \param wheel_velocities Velocity command of each wheel [rad/s], sized to the layout
+   * \param steering_angles Steering command of each wheel [rad], sized to the layout. Wheels
+   * whose contact point stands still keep their previous command.
+   * \return false without a layout or if the sizes don't match it
+   */
+  bool get_wheel_commands(
+    double Vx, double Vy, double theta_dot, std::vector<double> & wheel_velocities,
+    std::vector<double> & steering_angles) const;
+
   /**
    *  \brief Reset poses, heading, and accumulators
    */
@@ -216,49 +378,93 @@ public:
 
 private:
   /**
-   * \brief Uses precomputed linear and angular velocities to compute dometry and update
-   * accumulators \param linear  Linear  velocity   [m] (linear  displacement, i.e. m/s * dt)
-   * computed by previous odometry method \param angular Angular velocity [rad] (angular
-   * displacement, i.e. m/s * dt) computed by previous odometry method
+   * \brief Uses precomputed linear and angular velocities to compute odometry and update
+   * accumulators, with the angular velocity blended with the IMU yaw rate if set
+   * \param linear_velocity  Linear velocity [m/s] computed by previous odometry method
+   * \param wheel_angular_velocity Angular velocity [rad/s] computed by previous odometry method
+   * \param dt time difference to last call
    */
-  bool update_odometry(const double linear_velocity, const double angular, const double dt);
+  bool update_odometry(
+    const double linear_velocity, const double wheel_angular_velocity, const double dt);
 
   /**
-   * \brief Integrates the velocities (linear and angular) using 2nd order Runge-Kutta
+   * \brief Integrates the displacements of one step with
+   * controller_realtime_tools::PoseIntegrator
    * \param linear  Linear  velocity   [m] (linear  displacement, i.e. m/s * dt) computed by
    * encoders \param angular Angular velocity [rad] (angular displacement, i.e. m/s * dt) computed
    * by encoders
    */
-  void integrate_runge_kutta_2(double linear, double angular);
+  void integrate_exact(double linear, double angular);
 
   /**
-   * \brief Integrates the velocities (linear and angular) using exact method
-   * \param linear  Linear  velocity   [m] (linear  displacement, i.e. m/s * dt) computed by
-   * encoders \param angular Angular velocity [rad] (angular displacement, i.e. m/s * dt) computed
-   * by encoders
+   * \brief Propagates the pose covariance over the step integrate_exact() is about to integrate
+   * \param linear Linear displacement [m]
+   * \param angular Angular displacement [rad]
    */
-  void integrate_exact(double linear, double angular);
+  void propagate_step_covariance(double linear, double angular);
 
   /**
    * \brief Calculates steering angle from the desired translational and rotational velocity
    * \param Vx   Linear  velocity   [m]
    * \param theta_dot Angular velocity [rad]
    */
-  double convert_trans_rot_vel_to_steering_angle(double Vx, double theta_dot);
+  double convert_trans_rot_vel_to_steering_angle(double Vx, double theta_dot) const;
+
+  /**
+   * \brief Calculates the desired velocity and steering angle of the middle of the traction and
+   * steering axes, shared by the kinematic models
+   * \param Vx  Desired linear velocity [m/s]
+   * \param theta_dot Desired angular velocity [rad/s]
+   * \param Ws Desired wheel velocity [rad/s]
+   * \param alpha Desired steering angle [rad]
+   */
+  void get_wheel_command(double Vx, double theta_dot, double & Ws, double & alpha) const;
+
+  /**
+   * \brief Calculates inverse kinematics of \p Model for the desired wheel velocity and steering
+   * angle of the middle of the traction and steering axes
+   * \param Ws Desired wheel velocity [rad/s]
+   * \param alpha Desired steering angle [rad]
+   * \param commands Velocity commands and steering commands of the model
+   */
+  template <typename Model>
+  void get_model_commands(double Ws, double alpha, JointCommands & commands) const
+  {
+    static_assert(
+      Model::TRACTION_JOINTS <= MAX_COMMANDED_JOINTS &&
+        Model::STEERING_JOINTS <= MAX_COMMANDED_JOINTS,
+      "The kinematic model has more joints than JointCommands");
+    Model::get_commands(
+      {wheel_radius_, wheelbase_, wheel_track_, y_steering_offset_, steer_pos_}, Ws, alpha,
+      commands);
+    commands.traction_count = Model::TRACTION_JOINTS;
+    commands.steering_count = Model::STEERING_JOINTS;
+  }
 
   /**
    *  \brief Reset linear and angular accumulators
    */
   void reset_accumulators();
 
+  /**
+   * \brief Propagates the pose covariance over an integration step
+   * \param dx_dheading Derivative of the new x with respect to the old heading
+   * \param dy_dheading Derivative of the new y with respect to the old heading
+   * \param position_jacobian Derivatives of the new x and y with respect to the linear and
+   * angular displacements, row-major
+   * \param linear Linear displacement [m]
+   * \param angular Angular displacement [rad]
+   */
+  void propagate_pose_covariance(
+    double dx_dheading, double dy_dheading, const std::array<double, 4> & position_jacobian,
+    double linear, double angular);
+
   /// Current timestamp:
   rclcpp::Time timestamp_;
 
-  /// Current pose:
-  double x_;          //   [m]
-  double y_;          //   [m]
+  /// Current pose, x and y [m] and heading [rad]:
+  controller_realtime_tools::PoseIntegrator pose_;
   double steer_pos_;  // [rad]
-  double heading_;    // [rad]
 
   /// Current velocity:
   double linear_;   //   [m/s]
@@ -272,15 +478,31 @@ private:
 
   /// Configuration type used for the forward kinematics
   int config_type_ = -1;
+  /// get_model_commands() of the kinematic model of the configuration, nullptr if none is set
+  void (SteeringOdometry::*commands_function_)(double, double, JointCommands &) const = nullptr;
+  /// Wheel layout of any number of wheels
+  MultiWheelKinematics multi_wheel_kinematics_;
 
   /// Previous wheel position/state [rad]:
   double traction_wheel_old_pos_;
   double traction_right_wheel_old_pos_;
   double traction_left_wheel_old_pos_;
-  /// Rolling mean accumulators for the linear and angular velocities:
+  // front right, front left, rear right and rear left of a four wheel steering
+  std::array<double, 4> four_steering_old_pos_{};
+  /// Pose covariance, propagated with each integration step if enabled:
+  bool propagate_pose_covariance_;
+  std::array<double, 9> pose_covariance_;
+  std::array<double, 9> initial_pose_covariance_;
+  double linear_noise_;   // [m^2/m]
+  double angular_noise_;  // [rad^2/rad]
+  /// Complementary blend of the yaw rate with the IMU:
+  double imu_weight_;
+  double imu_angular_velocity_;  // [rad/s]
+  /// Smoothing filters for the linear and angular velocities:
   size_t velocity_rolling_window_size_;
-  rcpputils::RollingMeanAccumulator<double> linear_acc_;
-  rcpputils::RollingMeanAccumulator<double> angular_acc_;
+  controller_realtime_tools::SmoothingMode velocity_smoothing_mode_;
+  controller_realtime_tools::SmoothingFilter<MAX_VELOCITY_ROLLING_WINDOW_SIZE> linear_acc_;
+  controller_realtime_tools::SmoothingFilter<MAX_VELOCITY_ROLLING_WINDOW_SIZE> angular_acc_;
 };
 }  // namespace steering_odometry
 
@@ -0,0 +1,136 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "steering_controllers_library/multi_wheel_kinematics.hpp"
+
+#include <cmath>
+
+namespace steering_odometry
+{
+bool MultiWheelKinematics::set_wheels(
+  const std::vector<double> & x, const std::vector<double> & y, const std::vector<bool> & steered)
+{
+  const size_t wheels = x.size();
+  if (wheels == 0 || y.size() != wheels || steered.size() != wheels)
+  {
+    return false;
+  }
+
+  // A^T * A of the 2N x 3 matrix A with the rows [1, 0, -y_i] and [0, 1, x_i]
+  double sum_x = 0.0;
+  double sum_y = 0.0;
+  double sum_squares = 0.0;
+  for (size_t i = 0; i < wheels; ++i)
+  {
+    sum_x += x[i];
+    sum_y += y[i];
+    sum_squares += x[i] * x[i] + y[i] * y[i];
+  }
+  const double n = static_cast<double>(wheels);
+  // n times the spread of the wheels around their center, 0 if they are all at the same position
+  const double spread = n * sum_squares - sum_x * sum_x - sum_y * sum_y;
+  if (spread <= 1e-9 * n * n)
+  {
+    return false;
+  }
+
+  // inverse of A^T * A = [n, 0, -sum_y; 0, n, sum_x; -sum_y, sum_x, sum_squares]
+  const double determinant = n * spread;
+  const double inverse[3][3] = {
+    {(n * sum_squares - sum_x * sum_x) / determinant, -sum_x * sum_y / determinant,
+     n * sum_y / determinant},
+    {-sum_x * sum_y / determinant, (n * sum_squares - sum_y * sum_y) / determinant,
+     -n * sum_x / determinant},
+    {n * sum_y / determinant, -n * sum_x / determinant, n * n / determinant}};
+
+  x_ = x;
+  y_ = y;
+  steered_ = steered;
+  // (A^T * A)^-1 * A^T, the columns of A^T for wheel i are [1, 0, -y_i] and [0, 1, x_i]
+  for (size_t row = 0; row < 3; ++row)
+  {
+    pseudo_inverse_x_[row].resize(wheels);
+    pseudo_inverse_y_[row].resize(wheels);
+    for (size_t i = 0; i < wheels; ++i)
+    {
+      pseudo_inverse_x_[row][i] = inverse[row][0] - y[i] * inverse[row][2];
+      pseudo_inverse_y_[row][i] = inverse[row][1] + x[i] * inverse[row][2];
+    }
+  }
+  return true;
+}
+
+void MultiWheelKinematics::get_twist(
+  const std::vector<double> & wheel_velocities, const std::vector<double> & steering_angles,
+  double wheel_radius, std::array<double, 3> & twist) const
+{
+  twist = {0.0, 0.0, 0.0};
+  for (size_t i = 0; i < x_.size(); ++i)
+  {
+    const double speed = wheel_velocities[i] * wheel_radius;
+    double contact_x = speed;
+    double contact_y = 0.0;
+    if (steered_[i])
+    {
+      contact_x = speed * std::cos(steering_angles[i]);
+      contact_y = speed * std::sin(steering_angles[i]);
+    }
+    for (size_t row = 0; row < 3; ++row)
+    {
+      twist[row] += pseudo_inverse_x_[row][i] * contact_x + pseudo_inverse_y_[row][i] * contact_y;
+    }
+  }
+}
+
+void MultiWheelKinematics::get_commands(
+  const std::array<double, 3> & twist, double wheel_radius, std::vector<double> & wheel_velocities,
+  std::vector<double> & steering_angles) const
+{
+  const double vx = twist[0];
+  const double vy = twist[1];
+  const double wz = twist[2];
+  for (size_t i = 0; i < x_.size(); ++i)
+  {
+    const double contact_x = vx - wz * y_[i];
+    const double contact_y = vy + wz * x_[i];
+    if (!steered_[i])
+    {
+      // the wheel can only follow the contact velocity along its axis
+      wheel_velocities[i] = contact_x / wheel_radius;
+      steering_angles[i] = 0.0;
+      continue;
+    }
+    double speed = std::hypot(contact_x, contact_y);
+    if (speed < 1e-6)
+    {
+      wheel_velocities[i] = 0.0;
+      continue;
+    }
+    double angle = std::atan2(contact_y, contact_x);
+    if (angle > M_PI_2)
+    {
+      angle -= M_PI;
+      speed = -speed;
+    }
+    else if (angle < -M_PI_2)
+    {
+      angle += M_PI;
+      speed = -speed;
+    }
+    wheel_velocities[i] = speed / wheel_radius;
+    steering_angles[i] = angle;
+  }
+}
+
+}  // namespace steering_odometry
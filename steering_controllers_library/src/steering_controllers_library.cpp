@@ -14,6 +14,8 @@
 
 #include "steering_controllers_library/steering_controllers_library.hpp"
 
+#include <array>
+#include <chrono>
 #include <limits>
 #include <memory>
 #include <queue>
@@ -22,10 +24,11 @@
 #include <vector>
 
 #include "controller_interface/helpers.hpp"
+#include "controller_realtime_tools/metrics.hpp"
+#include "controller_realtime_tools/nan_scan.hpp"
+#include "controller_realtime_tools/tracing.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
-#include "tf2/transform_datatypes.h"
-#include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
 
 namespace
 {  // utility
@@ -33,20 +36,26 @@ namespace
 using ControllerTwistReferenceMsg =
   steering_controllers_library::SteeringControllersLibrary::ControllerTwistReferenceMsg;
 
-// called from RT control loop
 void reset_controller_reference_msg(
-  const std::shared_ptr<ControllerTwistReferenceMsg> & msg,
-  const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node)
+  ControllerTwistReferenceMsg & msg, const std::shared_ptr<rclcpp_lifecycle::LifecycleNode> & node)
 {
-  msg->header.stamp = node->now();
-  msg->twist.linear.x = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.linear.y = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.linear.z = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.angular.x = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.angular.y = std::numeric_limits<double>::quiet_NaN();
-  msg->twist.angular.z = std::numeric_limits<double>::quiet_NaN();
+  msg.header.stamp = node->now();
+  msg.twist.linear.x = std::numeric_limits<double>::quiet_NaN();
+  msg.twist.linear.y = std::numeric_limits<double>::quiet_NaN();
+  msg.twist.linear.z = std::numeric_limits<double>::quiet_NaN();
+  msg.twist.angular.x = std::numeric_limits<double>::quiet_NaN();
+  msg.twist.angular.y = std::numeric_limits<double>::quiet_NaN();
+  msg.twist.angular.z = std::numeric_limits<double>::quiet_NaN();
 }
 
+// exported odometry state interfaces, in the order of state_interfaces_values_
+constexpr std::array<const char *, 5> ODOMETRY_STATE_INTERFACES = {
+  "odometry/x", "odometry/y", "odometry/heading", "odometry/linear_velocity",
+  "odometry/angular_velocity"};
+
+// yaw rate of the IMU, named like the interfaces of semantic_components::IMUSensor
+constexpr auto IMU_YAW_RATE_INTERFACE = "angular_velocity.z";
+
 }  // namespace
 
 namespace steering_controllers_library
@@ -86,9 +95,47 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
 {
   params_ = param_listener_->get_params();
   odometry_.set_velocity_rolling_window_size(params_.velocity_rolling_window_size);
+  controller_realtime_tools::SmoothingMode velocity_smoothing_mode;
+  controller_realtime_tools::smoothing_mode_from_string(
+    params_.velocity_smoothing, velocity_smoothing_mode);
+  odometry_.set_velocity_smoothing_mode(velocity_smoothing_mode);
+  odometry_.set_pose_covariance_params(
+    params_.pose_covariance_propagation.enable, params_.pose_covariance_diagonal[0],
+    params_.pose_covariance_diagonal[1], params_.pose_covariance_diagonal[5],
+    params_.pose_covariance_propagation.linear_noise,
+    params_.pose_covariance_propagation.angular_noise);
+  if (params_.imu_heading.enable && params_.imu_heading.sensor_name.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'imu_heading.sensor_name' is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
+  odometry_.set_imu_weight(params_.imu_heading.enable ? params_.imu_heading.gyro_weight : 0.0);
+  if (params_.input_recording.enable && params_.input_recording.path.empty())
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "'input_recording.path' is empty");
+    return controller_interface::CallbackReturn::ERROR;
+  }
 
   configure_odometry();
 
+  // the commands of update() are computed in place for at most MAX_COMMANDED_JOINTS joints
+  const auto too_many_joints = [](const std::vector<std::string> & names)
+  { return names.size() > steering_odometry::MAX_COMMANDED_JOINTS; };
+  if (
+    too_many_joints(params_.rear_wheels_names) || too_many_joints(params_.front_wheels_names) ||
+    too_many_joints(params_.wheels_names) || too_many_joints(params_.steers_names))
+  {
+    RCLCPP_ERROR(
+      get_node()->get_logger(), "At most %zu traction and %zu steering joints are supported",
+      steering_odometry::MAX_COMMANDED_JOINTS, steering_odometry::MAX_COMMANDED_JOINTS);
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
+  if (!configure_limiters())
+  {
+    return controller_interface::CallbackReturn::ERROR;
+  }
+
   if (!params_.rear_wheels_state_names.empty())
   {
     rear_wheels_state_names_ = params_.rear_wheels_state_names;
@@ -109,36 +156,85 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
 
   // topics QoS
   auto subscribers_qos = rclcpp::SystemDefaultsQoS();
-  subscribers_qos.keep_last(1);
+  if (params_.reference_qos.history == "keep_last")
+  {
+    subscribers_qos.keep_last(static_cast<size_t>(params_.reference_qos.depth));
+  }
+  else if (params_.reference_qos.history == "keep_all")
+  {
+    subscribers_qos.keep_all();
+  }
   subscribers_qos.best_effort();
+  // the subscribers take ownership of the messages to move them into the buffer, without a copy if
+  // they are passed within the process
+  rclcpp::SubscriptionOptions subscribers_options;
+  if (params_.reference_qos.intra_process)
+  {
+    if (params_.reference_qos.history != "keep_last")
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "Intra-process communication of the references requires the keep_last history");
+      return controller_interface::CallbackReturn::ERROR;
+    }
+    subscribers_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+  }
+
+  // before the first reference is written, the control loop reads the consumed prototype
+  ReferenceSlot reference_prototype;
+  reset_controller_reference_msg(reference_prototype.msg, get_node());
+  {
+    std::lock_guard<std::mutex> guard(reference_write_mutex_);
+    reference_prototype.sequence = written_references_.load();
+    consumed_reference_ = reference_prototype.sequence;
+    input_ref_ = std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<ReferenceSlot>>(
+      reference_prototype);
+    if (params_.jitter_buffer.enable)
+    {
+      reference_jitter_buffer_ = std::make_unique<ReferenceJitterBuffer>();
+      reference_jitter_buffer_->set_delay(
+        static_cast<int64_t>(params_.jitter_buffer.delay * 1e9));
+    }
+    else
+    {
+      reference_jitter_buffer_.reset();
+    }
+  }
 
   // Reference Subscriber
   ref_timeout_ = rclcpp::Duration::from_seconds(params_.reference_timeout);
-  if (params_.use_stamped_vel)
+  if (params_.use_ackermann_reference)
+  {
+    ref_subscriber_ackermann_ = get_node()->create_subscription<ControllerAckermannReferenceMsg>(
+      "~/reference_ackermann", subscribers_qos,
+      std::bind(
+        &SteeringControllersLibrary::reference_callback_ackermann, this, std::placeholders::_1),
+      subscribers_options);
+  }
+  else if (params_.use_stamped_vel)
   {
     ref_subscriber_twist_ = get_node()->create_subscription<ControllerTwistReferenceMsg>(
       "~/reference", subscribers_qos,
-      std::bind(&SteeringControllersLibrary::reference_callback, this, std::placeholders::_1));
+      std::bind(&SteeringControllersLibrary::reference_callback, this, std::placeholders::_1),
+      subscribers_options);
   }
   else
   {
     ref_subscriber_unstamped_ = get_node()->create_subscription<geometry_msgs::msg::Twist>(
       "~/reference_unstamped", subscribers_qos,
       std::bind(
-        &SteeringControllersLibrary::reference_callback_unstamped, this, std::placeholders::_1));
+        &SteeringControllersLibrary::reference_callback_unstamped, this, std::placeholders::_1),
+      subscribers_options);
   }
 
-  std::shared_ptr<ControllerTwistReferenceMsg> msg =
-    std::make_shared<ControllerTwistReferenceMsg>();
-  reset_controller_reference_msg(msg, get_node());
-  input_ref_.writeFromNonRT(msg);
-
   try
   {
     // Odom state publisher
     odom_s_publisher_ = get_node()->create_publisher<ControllerStateMsgOdom>(
       "~/odometry", rclcpp::SystemDefaultsQoS());
-    rt_odom_state_publisher_ = std::make_unique<ControllerStatePublisherOdom>(odom_s_publisher_);
+    // Tf State publisher
+    tf_odom_s_publisher_ = get_node()->create_publisher<ControllerStateMsgTf>(
+      "~/tf_odometry", rclcpp::SystemDefaultsQoS());
   }
   catch (const std::exception & e)
   {
@@ -148,30 +244,40 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  rt_odom_state_publisher_->lock();
-  rt_odom_state_publisher_->msg_.header.stamp = get_node()->now();
-  rt_odom_state_publisher_->msg_.header.frame_id = params_.odom_frame_id;
-  rt_odom_state_publisher_->msg_.child_frame_id = params_.base_frame_id;
-  rt_odom_state_publisher_->msg_.pose.pose.position.z = 0;
+  ControllerStateMsgOdom odom_state_msg;
+  odom_state_msg.header.stamp = get_node()->now();
+  odom_state_msg.header.frame_id = params_.odom_frame_id;
+  odom_state_msg.child_frame_id = params_.base_frame_id;
+  odom_state_msg.pose.pose.position.z = 0;
 
-  auto & covariance = rt_odom_state_publisher_->msg_.twist.covariance;
+  auto & pose_covariance = odom_state_msg.pose.covariance;
+  auto & twist_covariance = odom_state_msg.twist.covariance;
   constexpr size_t NUM_DIMENSIONS = 6;
   for (size_t index = 0; index < 6; ++index)
   {
     // 0, 7, 14, 21, 28, 35
     const size_t diagonal_index = NUM_DIMENSIONS * index + index;
-    covariance[diagonal_index] = params_.pose_covariance_diagonal[index];
-    covariance[diagonal_index] = params_.twist_covariance_diagonal[index];
+    pose_covariance[diagonal_index] = params_.pose_covariance_diagonal[index];
+    twist_covariance[diagonal_index] = params_.twist_covariance_diagonal[index];
   }
-  rt_odom_state_publisher_->unlock();
+
+  ControllerStateMsgTf tf_odom_state_msg;
+  tf_odom_state_msg.transforms.resize(1);
+  tf_odom_state_msg.transforms[0].header.stamp = get_node()->now();
+  tf_odom_state_msg.transforms[0].header.frame_id = params_.odom_frame_id;
+  tf_odom_state_msg.transforms[0].child_frame_id = params_.base_frame_id;
+  tf_odom_state_msg.transforms[0].transform.translation.z = 0.0;
+
+  odom_state_publisher_ = std::make_unique<OdometryStatePublisher>(
+    odom_s_publisher_, odom_state_msg, params_.enable_odom_tf ? tf_odom_s_publisher_ : nullptr,
+    tf_odom_state_msg,
+    std::chrono::nanoseconds(static_cast<int64_t>(1e9 / params_.odom_publish_rate)));
 
   try
   {
-    // Tf State publisher
-    tf_odom_s_publisher_ = get_node()->create_publisher<ControllerStateMsgTf>(
-      "~/tf_odometry", rclcpp::SystemDefaultsQoS());
-    rt_tf_odom_state_publisher_ =
-      std::make_unique<ControllerStatePublisherTf>(tf_odom_s_publisher_);
+    // State publisher
+    controller_s_publisher_ = get_node()->create_publisher<AckermanControllerState>(
+      "~/controller_state", rclcpp::SystemDefaultsQoS());
   }
   catch (const std::exception & e)
   {
@@ -181,100 +287,287 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_configure(
     return controller_interface::CallbackReturn::ERROR;
   }
 
-  rt_tf_odom_state_publisher_->lock();
-  rt_tf_odom_state_publisher_->msg_.transforms.resize(1);
-  rt_tf_odom_state_publisher_->msg_.transforms[0].header.stamp = get_node()->now();
-  rt_tf_odom_state_publisher_->msg_.transforms[0].header.frame_id = params_.odom_frame_id;
-  rt_tf_odom_state_publisher_->msg_.transforms[0].child_frame_id = params_.base_frame_id;
-  rt_tf_odom_state_publisher_->msg_.transforms[0].transform.translation.z = 0.0;
-  rt_tf_odom_state_publisher_->unlock();
+  if (params_.four_steering)
+  {
+    nr_traction_wheels_ = params_.wheels_names.size();
+    nr_steering_wheels_ = params_.steers_names.size();
+  }
+  else if (params_.front_steering)
+  {
+    nr_traction_wheels_ = params_.rear_wheels_names.size();
+    nr_steering_wheels_ = params_.front_wheels_names.size();
+  }
+  else
+  {
+    nr_traction_wheels_ = params_.front_wheels_names.size();
+    nr_steering_wheels_ = params_.rear_wheels_names.size();
+  }
+
+  // size the arrays once, update() only writes them in place
+  auto & state_msg = controller_state_msg_;
+  state_msg.header.stamp = get_node()->now();
+  state_msg.header.frame_id = params_.odom_frame_id;
+  // the traction wheels of four steering always have velocity state interfaces
+  const bool traction_positions = params_.position_feedback && !params_.four_steering;
+  state_msg.traction_wheels_position.assign(
+    traction_positions ? nr_traction_wheels_ : 0, std::numeric_limits<double>::quiet_NaN());
+  state_msg.traction_wheels_velocity.assign(
+    traction_positions ? 0 : nr_traction_wheels_, std::numeric_limits<double>::quiet_NaN());
+  state_msg.linear_velocity_command.assign(
+    nr_traction_wheels_, std::numeric_limits<double>::quiet_NaN());
+  state_msg.steer_positions.assign(nr_steering_wheels_, std::numeric_limits<double>::quiet_NaN());
+  state_msg.steering_angle_command.assign(
+    nr_steering_wheels_, std::numeric_limits<double>::quiet_NaN());
+
+  const auto state_publish_period =
+    params_.state_publish_rate > 0.0
+      ? rclcpp::Duration::from_seconds(1.0 / params_.state_publish_rate)
+      : rclcpp::Duration::from_nanoseconds(0);
+  controller_state_publisher_ = std::make_unique<ControllerStatePublisher>(
+    controller_s_publisher_, state_msg, state_publish_period.to_chrono<std::chrono::nanoseconds>());
+
+  if (params_.command_latency.enable)
+  {
+    command_latency_ = std::make_unique<controller_realtime_tools::LatencyProbe>();
+    command_latency_publisher_ =
+      get_node()->create_publisher<statistics_msgs::msg::MetricsMessage>(
+        "~/command_latency", rclcpp::SystemDefaultsQoS());
+    command_latency_window_start_ = get_node()->now();
+    command_latency_timer_ = get_node()->create_wall_timer(
+      std::chrono::duration<double>(1.0 / params_.command_latency.publish_rate),
+      [this]() { publish_command_latency(); });
+  }
+  else
+  {
+    command_latency_timer_.reset();
+    command_latency_publisher_.reset();
+    command_latency_.reset();
+  }
 
-  try
+  if (params_.cycle_budget.enable)
   {
-    // State publisher
-    controller_s_publisher_ = get_node()->create_publisher<AckermanControllerState>(
-      "~/controller_state", rclcpp::SystemDefaultsQoS());
-    controller_state_publisher_ =
-      std::make_unique<ControllerStatePublisher>(controller_s_publisher_);
+    cycle_budget_ = std::make_unique<controller_realtime_tools::CycleBudget>(
+      std::chrono::nanoseconds(static_cast<int64_t>(params_.cycle_budget.update_time * 1e9)),
+      static_cast<uint32_t>(params_.cycle_budget.recovery_cycles),
+      std::vector<std::string>{"controller_state"});
+    cycle_budget_timer_ = get_node()->create_wall_timer(
+      std::chrono::seconds(1),
+      [this]()
+      {
+        const auto report = cycle_budget_->get_report();
+        if (!report.empty())
+        {
+          RCLCPP_WARN(get_node()->get_logger(), "%s", report.c_str());
+        }
+      });
   }
-  catch (const std::exception & e)
+  else
   {
-    fprintf(
-      stderr, "Exception thrown during publisher creation at configure stage with message : %s \n",
-      e.what());
-    return controller_interface::CallbackReturn::ERROR;
+    cycle_budget_timer_.reset();
+    cycle_budget_.reset();
   }
 
-  controller_state_publisher_->lock();
-  controller_state_publisher_->msg_.header.stamp = get_node()->now();
-  controller_state_publisher_->msg_.header.frame_id = params_.odom_frame_id;
-  controller_state_publisher_->unlock();
+  // before exporting them, so update() also works if they are never claimed
+  state_interfaces_values_.resize(ODOMETRY_STATE_INTERFACES.size(), 0.0);
   RCLCPP_INFO(get_node()->get_logger(), "configure successful");
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
-void SteeringControllersLibrary::reference_callback(
-  const std::shared_ptr<ControllerTwistReferenceMsg> msg)
+bool SteeringControllersLibrary::configure_limiters()
+{
+  // the limits of the tricycle_controller, for the magnitudes of the commands
+  auto traction = params_.traction;
+  if (!std::isnan(traction.min_acceleration) && std::isnan(traction.max_acceleration))
+  {
+    traction.max_acceleration = std::numeric_limits<double>::infinity();
+  }
+  auto steering = params_.steering;
+  if (!std::isnan(steering.min_position) && std::isnan(steering.max_position))
+  {
+    steering.max_position = -steering.min_position;
+  }
+  if (!std::isnan(steering.max_position) && std::isnan(steering.min_position))
+  {
+    steering.min_position = -steering.max_position;
+  }
+
+  // comparisons with NaN are false, so only the set limits are checked
+  const std::array<double, 12> magnitudes = {
+    traction.min_velocity,     traction.max_velocity,     traction.min_acceleration,
+    traction.max_acceleration, traction.min_deceleration, traction.max_deceleration,
+    traction.min_jerk,         traction.max_jerk,         steering.min_velocity,
+    steering.max_velocity,     steering.min_acceleration, steering.max_acceleration};
+  for (const double magnitude : magnitudes)
+  {
+    if (magnitude < 0.0)
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(),
+        "The velocity, acceleration, deceleration and jerk limits of the traction and steering "
+        "joints apply in both directions and cannot be negative");
+      return false;
+    }
+  }
+
+  traction_limiter_ = JointLimiter();
+  steering_limiter_ = JointLimiter();
+  for (size_t i = 0; i < steering_odometry::MAX_COMMANDED_JOINTS; ++i)
+  {
+    traction_limiter_.set_value_limits(
+      i, -traction.max_velocity, traction.max_velocity, traction.min_velocity);
+    // the deceleration is only limited along with the acceleration
+    if (!std::isnan(traction.max_acceleration))
+    {
+      traction_limiter_.set_rate_limits(
+        i, -traction.max_acceleration, traction.max_acceleration, traction.min_acceleration);
+      traction_limiter_.set_decreasing_rate_limits(
+        i, -traction.max_deceleration, traction.max_deceleration, traction.min_deceleration);
+    }
+    traction_limiter_.set_second_rate_limits(
+      i, -traction.max_jerk, traction.max_jerk, traction.min_jerk);
+
+    steering_limiter_.set_value_limits(i, steering.min_position, steering.max_position);
+    steering_limiter_.set_rate_limits(
+      i, -steering.max_velocity, steering.max_velocity, steering.min_velocity);
+    steering_limiter_.set_second_rate_limits(
+      i, -steering.max_acceleration, steering.max_acceleration, steering.min_acceleration);
+  }
+  return true;
+}
+
+void SteeringControllersLibrary::limit_joint_commands(double dt)
+{
+  const auto & last = previous_commands_[0];
+  const auto & second_to_last = previous_commands_[1];
+  traction_limiter_.limit(joint_commands_.traction, last.traction, second_to_last.traction, dt);
+  steering_limiter_.limit(joint_commands_.steering, last.steering, second_to_last.steering, dt);
+  previous_commands_[1] = previous_commands_[0];
+  previous_commands_[0] = joint_commands_;
+}
+
+bool SteeringControllersLibrary::is_reference_stamp_valid(std_msgs::msg::Header & header)
 {
   // if no timestamp provided use current time for command timestamp
-  if (msg->header.stamp.sec == 0 && msg->header.stamp.nanosec == 0u)
+  if (header.stamp.sec == 0 && header.stamp.nanosec == 0u)
   {
     RCLCPP_WARN(
       get_node()->get_logger(),
       "Timestamp in header is missing, using current time as command timestamp.");
-    msg->header.stamp = get_node()->now();
+    header.stamp = get_node()->now();
   }
-  const auto age_of_last_command = get_node()->now() - msg->header.stamp;
+  const auto age_of_last_command = get_node()->now() - header.stamp;
 
   if (ref_timeout_ == rclcpp::Duration::from_seconds(0) || age_of_last_command <= ref_timeout_)
   {
-    input_ref_.writeFromNonRT(msg);
+    return true;
   }
-  else
+  RCLCPP_ERROR(
+    get_node()->get_logger(),
+    "Received message has timestamp %.10f older for %.10f which is more then allowed timeout "
+    "(%.4f).",
+    rclcpp::Time(header.stamp).seconds(), age_of_last_command.seconds(), ref_timeout_.seconds());
+  return false;
+}
+
+void SteeringControllersLibrary::note_reference_received(int64_t stamp_ns)
+{
+  if (command_latency_)
   {
-    RCLCPP_ERROR(
-      get_node()->get_logger(),
-      "Received message has timestamp %.10f older for %.10f which is more then allowed timeout "
-      "(%.4f).",
-      rclcpp::Time(msg->header.stamp).seconds(), age_of_last_command.seconds(),
-      ref_timeout_.seconds());
+    command_latency_->command_received(stamp_ns, get_node()->now().nanoseconds());
+  }
+}
+
+void SteeringControllersLibrary::publish_command_latency()
+{
+  using controller_realtime_tools::LatencyProbe;
+  const rclcpp::Time now = get_node()->now();
+  const auto statistics = command_latency_->get_statistics();
+  for (size_t stage = 0; stage < LatencyProbe::NUM_STAGES; ++stage)
+  {
+    statistics_msgs::msg::MetricsMessage msg;
+    msg.measurement_source_name = get_node()->get_name();
+    msg.metrics_source = LatencyProbe::STAGE_NAMES[stage];
+    msg.window_start = command_latency_window_start_;
+    msg.window_stop = now;
+    controller_realtime_tools::fill_metrics<statistics_msgs::msg::StatisticDataType>(
+      statistics[stage], msg);
+    command_latency_publisher_->publish(msg);
+  }
+  command_latency_window_start_ = now;
+}
+
+void SteeringControllersLibrary::reference_callback(
+  std::unique_ptr<ControllerTwistReferenceMsg> msg)
+{
+  // before a missing stamp is set to now
+  const int64_t stamp_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
+  if (is_reference_stamp_valid(msg->header))
+  {
+    write_reference(std::move(*msg));
+    note_reference_received(stamp_ns);
+  }
+}
+
+void SteeringControllersLibrary::reference_callback_ackermann(
+  std::unique_ptr<ControllerAckermannReferenceMsg> msg)
+{
+  const int64_t stamp_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
+  if (is_reference_stamp_valid(msg->header))
+  {
+    write_reference(std::move(*msg));
+    note_reference_received(stamp_ns);
   }
 }
 
 void SteeringControllersLibrary::reference_callback_unstamped(
-  const std::shared_ptr<geometry_msgs::msg::Twist> msg)
+  std::unique_ptr<geometry_msgs::msg::Twist> msg)
 {
   RCLCPP_WARN(
     get_node()->get_logger(),
     "Use of Twist message without stamped is deprecated and it will be removed in ROS 2 J-Turtle "
     "version. Use '~/reference' topic with 'geometry_msgs::msg::TwistStamped' message type in the "
     "future.");
-  auto twist_stamped = *(input_ref_.readFromNonRT());
-  twist_stamped->header.stamp = get_node()->now();
-  // if no timestamp provided use current time for command timestamp
-  if (twist_stamped->header.stamp.sec == 0 && twist_stamped->header.stamp.nanosec == 0u)
-  {
-    RCLCPP_WARN(
-      get_node()->get_logger(),
-      "Timestamp in header is missing, using current time as command timestamp.");
-    twist_stamped->header.stamp = get_node()->now();
-  }
-
-  const auto age_of_last_command = get_node()->now() - twist_stamped->header.stamp;
+  ControllerTwistReferenceMsg twist_stamped;
+  twist_stamped.header.stamp = get_node()->now();
+  twist_stamped.twist = *msg;
+  write_reference(std::move(twist_stamped));
+  note_reference_received(0);
+}
 
-  if (ref_timeout_ == rclcpp::Duration::from_seconds(0) || age_of_last_command <= ref_timeout_)
+void SteeringControllersLibrary::write_reference(ControllerTwistReferenceMsg msg)
+{
+  std::lock_guard<std::mutex> guard(reference_write_mutex_);
+  if (reference_jitter_buffer_)
   {
-    twist_stamped->twist = *msg;
+    reference_jitter_buffer_->push(
+      rclcpp::Time(msg.header.stamp).nanoseconds(), {msg.twist.linear.x, msg.twist.angular.z});
   }
-  else
+  auto & slot = input_ref_->write_buffer();
+  slot.msg = std::move(msg);
+  slot.sequence = written_references_.fetch_add(1, std::memory_order_relaxed) + 1;
+  input_ref_->publish();
+}
+
+void SteeringControllersLibrary::write_reference(ControllerAckermannReferenceMsg msg)
+{
+  std::lock_guard<std::mutex> guard(reference_write_mutex_);
+  if (reference_jitter_buffer_)
   {
-    RCLCPP_ERROR(
-      get_node()->get_logger(),
-      "Received message has timestamp %.10f older for %.10f which is more then allowed timeout "
-      "(%.4f).",
-      rclcpp::Time(twist_stamped->header.stamp).seconds(), age_of_last_command.seconds(),
-      ref_timeout_.seconds());
+    reference_jitter_buffer_->push(
+      rclcpp::Time(msg.header.stamp).nanoseconds(),
+      {static_cast<double>(msg.drive.speed), static_cast<double>(msg.drive.steering_angle)});
   }
+  auto & slot = input_ref_->write_buffer();
+  slot.ackermann_msg = std::move(msg);
+  slot.sequence = written_references_.fetch_add(1, std::memory_order_relaxed) + 1;
+  input_ref_->publish();
+}
+
+const SteeringControllersLibrary::ControllerTwistReferenceMsg *
+SteeringControllersLibrary::read_reference()
+{
+  const auto & slot = input_ref_->read();
+  return slot.sequence > consumed_reference_ ? &slot.msg : nullptr;
 }
 
 controller_interface::InterfaceConfiguration
@@ -343,20 +636,17 @@ SteeringControllersLibrary::state_interface_configuration() const
 
   if (params_.four_steering)
   {
-    for (size_t i = 0; i <  params_.wheels_names.size(); i++)
+    for (size_t i = 0; i < params_.wheels_names.size(); i++)
     {
-      state_interfaces_config.names.push_back(
-        wheels_names_[i] + "/" + hardware_interface::HW_IF_VELOCITY);
+      state_interfaces_config.names.push_back(wheels_names_[i] + "/" + traction_wheels_feedback);
     }
-    for (size_t i = 0; i <  params_.steers_names.size(); i++)
+    for (size_t i = 0; i < params_.steers_names.size(); i++)
     {
       state_interfaces_config.names.push_back(
         steers_names_[i] + "/" + hardware_interface::HW_IF_POSITION);
     }
-  return state_interfaces_config;
   }
-
-  if (params_.front_steering)
+  else if (params_.front_steering)
   {
     for (size_t i = 0; i < rear_wheels_state_names_.size(); i++)
     {
@@ -385,6 +675,13 @@ SteeringControllersLibrary::state_interface_configuration() const
     }
   }
 
+  // after the joints, so the implementations index the joint states as without an IMU
+  if (params_.imu_heading.enable)
+  {
+    state_interfaces_config.names.push_back(
+      params_.imu_heading.sensor_name + "/" + IMU_YAW_RATE_INTERFACE);
+  }
+
   return state_interfaces_config;
 }
 
@@ -396,17 +693,36 @@ SteeringControllersLibrary::on_export_reference_interfaces()
   std::vector<hardware_interface::CommandInterface> reference_interfaces;
   reference_interfaces.reserve(nr_ref_itfs_);
 
+  // a speed and a steering angle, or a linear and an angular velocity
+  const std::string linear_name = params_.use_ackermann_reference ? "speed/" : "linear/";
+  const std::string angular_name =
+    params_.use_ackermann_reference ? "steering_angle/" : "angular/";
   reference_interfaces.push_back(hardware_interface::CommandInterface(
-    get_node()->get_name(), std::string("linear/") + hardware_interface::HW_IF_VELOCITY,
+    get_node()->get_name(), linear_name + hardware_interface::HW_IF_VELOCITY,
     &reference_interfaces_[0]));
 
   reference_interfaces.push_back(hardware_interface::CommandInterface(
-    get_node()->get_name(), std::string("angular/") + hardware_interface::HW_IF_POSITION,
+    get_node()->get_name(), angular_name + hardware_interface::HW_IF_POSITION,
     &reference_interfaces_[1]));
 
   return reference_interfaces;
 }
 
+std::vector<hardware_interface::StateInterface>
+SteeringControllersLibrary::on_export_state_interfaces()
+{
+  state_interfaces_values_.resize(ODOMETRY_STATE_INTERFACES.size(), 0.0);
+
+  std::vector<hardware_interface::StateInterface> state_interfaces;
+  state_interfaces.reserve(state_interfaces_values_.size());
+  for (size_t i = 0; i < ODOMETRY_STATE_INTERFACES.size(); ++i)
+  {
+    state_interfaces.push_back(hardware_interface::StateInterface(
+      get_node()->get_name(), ODOMETRY_STATE_INTERFACES[i], &state_interfaces_values_[i]));
+  }
+  return state_interfaces;
+}
+
 bool SteeringControllersLibrary::on_set_chained_mode(bool chained_mode)
 {
   // Always accept switch to/from chained mode
@@ -416,8 +732,40 @@ bool SteeringControllersLibrary::on_set_chained_mode(bool chained_mode)
 controller_interface::CallbackReturn SteeringControllersLibrary::on_activate(
   const rclcpp_lifecycle::State & /*previous_state*/)
 {
-  // Set default value in command
-  reset_controller_reference_msg(*(input_ref_.readFromRT()), get_node());
+  // Don't apply the references received before the activation
+  consumed_reference_ = written_references_.load();
+  if (reference_jitter_buffer_)
+  {
+    std::lock_guard<std::mutex> guard(reference_write_mutex_);
+    reference_jitter_buffer_->reset();
+  }
+  controller_state_publisher_->reset_period();
+  // the IMU yaw rate is read separately, a NaN only disables the blend
+  const size_t joint_states = state_interfaces_.size() - (params_.imu_heading.enable ? 1 : 0);
+  state_values_.assign(joint_states, std::numeric_limits<double>::quiet_NaN());
+  state_values_valid_ = false;
+  // the limits start from standing still with straight steering, like the tricycle_controller
+  previous_commands_.fill(steering_odometry::JointCommands());
+
+  if (params_.input_recording.enable)
+  {
+    std::vector<std::string> state_names;
+    for (const auto & interface : state_interfaces_)
+    {
+      state_names.push_back(interface.get_name());
+    }
+    input_recorder_ = std::make_unique<controller_realtime_tools::InputRecorder>(
+      params_.input_recording.path, state_names, reference_interfaces_.size(),
+      static_cast<size_t>(params_.input_recording.capacity));
+    if (!input_recorder_->good())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Unable to record the inputs to '%s'",
+        params_.input_recording.path.c_str());
+      input_recorder_.reset();
+      return controller_interface::CallbackReturn::ERROR;
+    }
+  }
 
   return controller_interface::CallbackReturn::SUCCESS;
 }
@@ -429,55 +777,142 @@ controller_interface::CallbackReturn SteeringControllersLibrary::on_deactivate(
   {
     command_interfaces_[i].set_value(std::numeric_limits<double>::quiet_NaN());
   }
+  // writes the inputs left
+  input_recorder_.reset();
   return controller_interface::CallbackReturn::SUCCESS;
 }
 
+bool SteeringControllersLibrary::read_state_values()
+{
+  // gather the snapshot first, then check it for NaN in one vectorized pass
+  for (size_t i = 0; i < state_values_.size(); ++i)
+  {
+    state_values_[i] = state_interfaces_[i].get_value();
+  }
+  return !controller_realtime_tools::any_nan(state_values_);
+}
+
 controller_interface::return_type SteeringControllersLibrary::update_reference_from_subscribers(
   const rclcpp::Time & time, const rclcpp::Duration & /*period*/)
 {
-  auto current_ref = *(input_ref_.readFromRT());
-  const auto age_of_last_command = time - (current_ref)->header.stamp;
-
-  // send message only if there is no timeout
-  if (age_of_last_command <= ref_timeout_ || ref_timeout_ == rclcpp::Duration::from_seconds(0))
-  {
-    if (!std::isnan(current_ref->twist.linear.x) && !std::isnan(current_ref->twist.angular.z))
+  if (reference_jitter_buffer_)
+  {
+    return update_reference_from_jitter_buffer(time);
+  }
+  // the reference is only read, a timeout marks it as consumed instead of overwriting it
+  const auto & slot = input_ref_->read();
+  CONTROLLER_TRACEPOINT(REFERENCE_RECEIVED, this, 0);
+  const bool ackermann = params_.use_ackermann_reference;
+  const auto & stamp = ackermann ? slot.ackermann_msg.header.stamp : slot.msg.header.stamp;
+  const double linear_reference =
+    ackermann ? static_cast<double>(slot.ackermann_msg.drive.speed) : slot.msg.twist.linear.x;
+  const double angular_reference = ackermann
+                                     ? static_cast<double>(slot.ackermann_msg.drive.steering_angle)
+                                     : slot.msg.twist.angular.z;
+  if (
+    slot.sequence > consumed_reference_ && !std::isnan(linear_reference) &&
+    !std::isnan(angular_reference))
+  {
+    const auto age_of_last_command = time - stamp;
+    // send message only if there is no timeout
+    if (age_of_last_command <= ref_timeout_ || ref_timeout_ == rclcpp::Duration::from_seconds(0))
     {
-      reference_interfaces_[0] = current_ref->twist.linear.x;
-      reference_interfaces_[1] = current_ref->twist.angular.z;
+      reference_interfaces_[0] = linear_reference;
+      reference_interfaces_[1] = angular_reference;
     }
-  }
-  else
-  {
-    if (!std::isnan(current_ref->twist.linear.x) && !std::isnan(current_ref->twist.angular.z))
+    else
     {
       reference_interfaces_[0] = 0.0;
       reference_interfaces_[1] = 0.0;
-      current_ref->twist.linear.x = std::numeric_limits<double>::quiet_NaN();
-      current_ref->twist.angular.z = std::numeric_limits<double>::quiet_NaN();
+      consumed_reference_ = slot.sequence;
     }
   }
 
   return controller_interface::return_type::OK;
 }
 
+controller_interface::return_type
+SteeringControllersLibrary::update_reference_from_jitter_buffer(const rclcpp::Time & time)
+{
+  const int64_t now_ns = time.nanoseconds();
+  const bool has_reference = reference_jitter_buffer_->play_out(now_ns);
+  CONTROLLER_TRACEPOINT(REFERENCE_RECEIVED, this, 0);
+  if (!has_reference)
+  {
+    return controller_interface::return_type::OK;
+  }
+  const ReferenceValues & reference = reference_jitter_buffer_->value();
+  if (std::isnan(reference.linear) || std::isnan(reference.angular))
+  {
+    return controller_interface::return_type::OK;
+  }
+  // the timeout applies from the play out of the reference
+  const auto age_of_reference = rclcpp::Duration::from_nanoseconds(
+    now_ns - reference_jitter_buffer_->delay() - reference_jitter_buffer_->stamp());
+  if (age_of_reference <= ref_timeout_ || ref_timeout_ == rclcpp::Duration::from_seconds(0))
+  {
+    reference_interfaces_[0] = reference.linear;
+    reference_interfaces_[1] = reference.angular;
+  }
+  else
+  {
+    reference_interfaces_[0] = 0.0;
+    reference_interfaces_[1] = 0.0;
+  }
+  return controller_interface::return_type::OK;
+}
+
 controller_interface::return_type SteeringControllersLibrary::update_and_write_commands(
   const rclcpp::Time & time, const rclcpp::Duration & period)
 {
+  controller_realtime_tools::CycleBudget::Scope cycle_budget_scope(cycle_budget_.get());
+  if (input_recorder_)
+  {
+    input_recorder_->record(
+      time.nanoseconds(), period.nanoseconds(), state_interfaces_, reference_interfaces_);
+  }
+  state_values_valid_ = read_state_values();
+  if (params_.imu_heading.enable)
+  {
+    odometry_.set_imu_angular_velocity(state_interfaces_.back().get_value());
+  }
   update_odometry(period);
+  CONTROLLER_TRACEPOINT(ODOMETRY_INTEGRATED, this, time.nanoseconds());
 
   // MOVE ROBOT
 
-  // Limit velocities and accelerations:
-  // TODO(destogl): add limiter for the velocities
-
   if (!std::isnan(reference_interfaces_[0]) && !std::isnan(reference_interfaces_[1]))
   {
     // store and set commands
     const double linear_command = reference_interfaces_[0];
     const double angular_command = reference_interfaces_[1];
-    auto [traction_commands, steering_commands] =
-      odometry_.get_commands(linear_command, angular_command);
+    bool has_commands;
+    last_linear_velocity_ = linear_command;
+    if (params_.use_ackermann_reference)
+    {
+      // the angular reference is the steering angle, it is only converted for open loop odometry
+      has_commands = odometry_.get_commands_from_steering_angle(
+        linear_command, angular_command, joint_commands_);
+      if (params_.open_loop)
+      {
+        last_angular_velocity_ =
+          odometry_.convert_steering_angle_to_rot_vel(linear_command, angular_command);
+      }
+    }
+    else
+    {
+      has_commands = odometry_.get_commands(linear_command, angular_command, joint_commands_);
+      last_angular_velocity_ = angular_command;
+    }
+    if (!has_commands)
+    {
+      RCLCPP_ERROR(get_node()->get_logger(), "The odometry type is not implemented");
+      return controller_interface::return_type::ERROR;
+    }
+    // Limit velocities and accelerations of the joints
+    limit_joint_commands(period.seconds());
+    const auto & traction_commands = joint_commands_.traction;
+    const auto & steering_commands = joint_commands_.steering;
 
     if (params_.four_steering)
     {
@@ -518,81 +953,56 @@ controller_interface::return_type SteeringControllersLibrary::update_and_write_c
         }
       }
     }
-  }
-
-  // Publish odometry message
-  // Compute and store orientation info
-  tf2::Quaternion orientation;
-  orientation.setRPY(0.0, 0.0, odometry_.get_heading());
-
-  // Populate odom message and publish
-  if (rt_odom_state_publisher_->trylock())
-  {
-    rt_odom_state_publisher_->msg_.header.stamp = time;
-    rt_odom_state_publisher_->msg_.pose.pose.position.x = odometry_.get_x();
-    rt_odom_state_publisher_->msg_.pose.pose.position.y = odometry_.get_y();
-    rt_odom_state_publisher_->msg_.pose.pose.orientation = tf2::toMsg(orientation);
-    rt_odom_state_publisher_->msg_.twist.twist.linear.x = odometry_.get_linear();
-    rt_odom_state_publisher_->msg_.twist.twist.angular.z = odometry_.get_angular();
-    rt_odom_state_publisher_->unlockAndPublish();
-  }
-
-  // Publish tf /odom frame
-  if (params_.enable_odom_tf && rt_tf_odom_state_publisher_->trylock())
-  {
-    rt_tf_odom_state_publisher_->msg_.transforms.front().header.stamp = time;
-    rt_tf_odom_state_publisher_->msg_.transforms.front().transform.translation.x =
-      odometry_.get_x();
-    rt_tf_odom_state_publisher_->msg_.transforms.front().transform.translation.y =
-      odometry_.get_y();
-    rt_tf_odom_state_publisher_->msg_.transforms.front().transform.rotation =
-      tf2::toMsg(orientation);
-    rt_tf_odom_state_publisher_->unlockAndPublish();
-  }
-
-  if (controller_state_publisher_->trylock())
-  {
-    controller_state_publisher_->msg_.header.stamp = time;
-    controller_state_publisher_->msg_.traction_wheels_position.clear();
-    controller_state_publisher_->msg_.traction_wheels_velocity.clear();
-    controller_state_publisher_->msg_.linear_velocity_command.clear();
-    controller_state_publisher_->msg_.steer_positions.clear();
-    controller_state_publisher_->msg_.steering_angle_command.clear();
-
-    auto number_of_traction_wheels = params_.rear_wheels_names.size();
-    auto number_of_steering_wheels = params_.front_wheels_names.size();
-
-    if (!params_.front_steering)
+    // the references of a preceding controller don't come from the subscribers
+    if (command_latency_ && !is_in_chained_mode())
     {
-      number_of_traction_wheels = params_.front_wheels_names.size();
-      number_of_steering_wheels = params_.rear_wheels_names.size();
+      command_latency_->command_written(time.nanoseconds());
     }
+  }
 
-    for (size_t i = 0; i < number_of_traction_wheels; ++i)
+  // Hand the odometry over to be published, the messages are built on the publishing thread
+  controller_realtime_tools::OdometrySnapshot odometry_snapshot;
+  odometry_snapshot.stamp_nanoseconds = time.nanoseconds();
+  odometry_snapshot.x = odometry_.get_x();
+  odometry_snapshot.y = odometry_.get_y();
+  odometry_snapshot.heading = odometry_.get_heading();
+  odometry_snapshot.linear = odometry_.get_linear();
+  odometry_snapshot.angular = odometry_.get_angular();
+  odometry_snapshot.has_pose_covariance = params_.pose_covariance_propagation.enable;
+  if (odometry_snapshot.has_pose_covariance)
+  {
+    odometry_snapshot.pose_covariance = odometry_.get_pose_covariance();
+  }
+  odom_state_publisher_->update(odometry_snapshot);
+  // read by the following controllers in the same cycle
+  state_interfaces_values_[0] = odometry_snapshot.x;
+  state_interfaces_values_[1] = odometry_snapshot.y;
+  state_interfaces_values_[2] = odometry_snapshot.heading;
+  state_interfaces_values_[3] = odometry_snapshot.linear;
+  state_interfaces_values_[4] = odometry_snapshot.angular;
+
+  if (
+    controller_state_publisher_->is_due(time.nanoseconds()) &&
+    !(cycle_budget_ && cycle_budget_->skip(SHED_CONTROLLER_STATE)))
+  {
+    auto & state_msg = controller_state_msg_;
+    state_msg.header.stamp = time;
+    auto & traction_wheels_feedback = state_msg.traction_wheels_position.empty()
+                                        ? state_msg.traction_wheels_velocity
+                                        : state_msg.traction_wheels_position;
+    for (size_t i = 0; i < nr_traction_wheels_; ++i)
     {
-      if (params_.position_feedback)
-      {
-        controller_state_publisher_->msg_.traction_wheels_position.push_back(
-          state_interfaces_[i].get_value());
-      }
-      else
-      {
-        controller_state_publisher_->msg_.traction_wheels_velocity.push_back(
-          state_interfaces_[i].get_value());
-      }
-      controller_state_publisher_->msg_.linear_velocity_command.push_back(
-        command_interfaces_[i].get_value());
+      traction_wheels_feedback[i] = state_values_[i];
+      state_msg.linear_velocity_command[i] = command_interfaces_[i].get_value();
     }
-
-    for (size_t i = 0; i < number_of_steering_wheels; ++i)
+    for (size_t i = 0; i < nr_steering_wheels_; ++i)
     {
-      controller_state_publisher_->msg_.steer_positions.push_back(
-        state_interfaces_[number_of_traction_wheels + i].get_value());
-      controller_state_publisher_->msg_.steering_angle_command.push_back(
-        command_interfaces_[number_of_traction_wheels + i].get_value());
+      state_msg.steer_positions[i] = state_values_[nr_traction_wheels_ + i];
+      state_msg.steering_angle_command[i] =
+        command_interfaces_[nr_traction_wheels_ + i].get_value();
     }
 
-    controller_state_publisher_->unlockAndPublish();
+    controller_state_publisher_->try_publish(state_msg, time.nanoseconds());
   }
 
   reference_interfaces_[0] = std::numeric_limits<double>::quiet_NaN();
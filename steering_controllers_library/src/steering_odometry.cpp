@@ -21,23 +21,34 @@
 
 #include "steering_controllers_library/steering_odometry.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 namespace steering_odometry
 {
 SteeringOdometry::SteeringOdometry(size_t velocity_rolling_window_size)
 : timestamp_(0.0),
-  x_(0.0),
-  y_(0.0),
-  heading_(0.0),
+  steer_pos_(0.0),
   linear_(0.0),
   angular_(0.0),
   wheel_track_(0.0),
   wheelbase_(0.0),
   wheel_radius_(0.0),
+  y_steering_offset_(0.0),
   traction_wheel_old_pos_(0.0),
+  traction_right_wheel_old_pos_(0.0),
+  traction_left_wheel_old_pos_(0.0),
+  propagate_pose_covariance_(false),
+  pose_covariance_{},
+  initial_pose_covariance_{},
+  linear_noise_(0.0),
+  angular_noise_(0.0),
+  imu_weight_(0.0),
+  imu_angular_velocity_(std::numeric_limits<double>::quiet_NaN()),
   velocity_rolling_window_size_(velocity_rolling_window_size),
+  velocity_smoothing_mode_(controller_realtime_tools::SmoothingMode::MEAN),
   linear_acc_(velocity_rolling_window_size),
   angular_acc_(velocity_rolling_window_size)
 {
@@ -51,10 +62,16 @@ void SteeringOdometry::init(const rclcpp::Time & time)
 }
 
 bool SteeringOdometry::update_odometry(
-  const double linear_velocity, const double angular, const double dt)
+  const double linear_velocity, const double wheel_angular_velocity, const double dt)
 {
+  // without a valid IMU yaw rate, the yaw rate of the wheels is integrated alone
+  const double angular_velocity =
+    imu_weight_ == 0.0 || std::isnan(imu_angular_velocity_)
+      ? wheel_angular_velocity
+      : imu_weight_ * imu_angular_velocity_ + (1.0 - imu_weight_) * wheel_angular_velocity;
+
   /// Integrate odometry:
-  SteeringOdometry::integrate_exact(linear_velocity * dt, angular);
+  SteeringOdometry::integrate_exact(linear_velocity * dt, angular_velocity * dt);
 
   /// We cannot estimate the speed with very small time intervals:
   if (dt < 0.0001)
@@ -62,12 +79,9 @@ bool SteeringOdometry::update_odometry(
     return false;  // Interval too small to integrate with
   }
 
-  /// Estimate speeds using a rolling mean to filter them out:
-  linear_acc_.accumulate(linear_velocity);
-  angular_acc_.accumulate(angular / dt);
-
-  linear_ = linear_acc_.getRollingMean();
-  angular_ = angular_acc_.getRollingMean();
+  /// Estimate speeds smoothed over the rolling window:
+  linear_ = linear_acc_.filter(linear_velocity);
+  angular_ = angular_acc_.filter(angular_velocity);
 
   return true;
 }
@@ -140,56 +154,84 @@ bool SteeringOdometry::update_from_position(
 
   return update_odometry(linear_velocity, angular, dt);
 }
+bool SteeringOdometry::update_from_position(
+  const double fr_pos, const double fl_pos, const double rr_pos, const double rl_pos,
+  const double front_steering, const double rear_steering, const double dt)
+{
+  /// Velocities from the difference to the previous wheel positions:
+  const std::array<double, 4> positions = {fr_pos, fl_pos, rr_pos, rl_pos};
+  std::array<double, 4> velocities;
+  for (size_t i = 0; i < positions.size(); ++i)
+  {
+    velocities[i] = (positions[i] - four_steering_old_pos_[i]) / dt;
+  }
+  four_steering_old_pos_ = positions;
+
+  return update_from_velocity(
+    velocities[0], velocities[1], velocities[2], velocities[3], front_steering, rear_steering, dt);
+}
+
 bool SteeringOdometry::update_four_steering(
-  const double fr_speed, const double fl_speed, const double rr_speed,
-  const double rl_speed, const double front_steering, const double rear_steering, const double dt)
+  const double fr_speed, const double fl_speed, const double rr_speed, const double rl_speed,
+  const double front_steering, const double rear_steering, const double dt)
 {
-  const double front_tmp = cos(front_steering) * (tan(front_steering) - tan(rear_steering)) / wheelbase_;
+  return update_from_velocity(
+    fr_speed, fl_speed, rr_speed, rl_speed, front_steering, rear_steering, dt);
+}
 
-  const double front_left_tmp = front_tmp / sqrt(1 - wheel_track_ * front_tmp * cos(front_steering)
-                                              +pow(wheel_track_*front_tmp / 2, 2));
-  const double front_right_tmp = front_tmp / sqrt(1 + wheel_track_ * front_tmp * cos(front_steering)
-                                              +pow(wheel_track_*front_tmp / 2, 2));
+bool SteeringOdometry::update_from_velocity(
+  const double fr_speed, const double fl_speed, const double rr_speed, const double rl_speed,
+  const double front_steering, const double rear_steering, const double dt)
+{
+  // every trigonometric function of the steering angles is only evaluated once
+  const double sin_front = std::sin(front_steering);
+  const double cos_front = std::cos(front_steering);
+  const double sin_rear = std::sin(rear_steering);
+  const double cos_rear = std::cos(rear_steering);
+  const double tan_difference = (sin_front / cos_front - sin_rear / cos_rear) / wheelbase_;
+
+  const double front_tmp = cos_front * tan_difference;
+  const double front_track_tmp = wheel_track_ * front_tmp;
+  const double front_track_term = 1 + front_track_tmp * front_track_tmp / 4;
+  const double front_left_tmp =
+    front_tmp / std::sqrt(front_track_term - front_track_tmp * cos_front);
+  const double front_right_tmp =
+    front_tmp / std::sqrt(front_track_term + front_track_tmp * cos_front);
 
   const double fl_speed_tmp = fl_speed * (1 / (1 - y_steering_offset_ * front_left_tmp));
   const double fr_speed_tmp = fr_speed * (1 / (1 - y_steering_offset_ * front_right_tmp));
 
-  const double front_linear_speed = wheel_radius_ * copysign(1.0, fl_speed_tmp + fr_speed_tmp) *
-      sqrt((pow(fl_speed, 2) + pow(fr_speed, 2)) / (2 + pow(wheel_track_ * front_tmp, 2) / 2.0));
+  const double front_linear_speed =
+    wheel_radius_ * std::copysign(1.0, fl_speed_tmp + fr_speed_tmp) *
+    std::sqrt(
+      (fl_speed_tmp * fl_speed_tmp + fr_speed_tmp * fr_speed_tmp) /
+      (2 + front_track_tmp * front_track_tmp / 2.0));
 
-  const double rear_tmp = cos(rear_steering) * (tan(front_steering) - tan(rear_steering)) / wheelbase_;
-
-  const double rear_left_tmp = rear_tmp / sqrt(1 - wheel_track_ * rear_tmp * cos(rear_steering)
-                                              + pow(wheel_track_ * rear_tmp/ 2, 2));
-  const double rear_right_tmp = rear_tmp / sqrt(1 + wheel_track_ * rear_tmp * cos(rear_steering)
-                                              +pow(wheel_track_ * rear_tmp/ 2, 2));
+  const double rear_tmp = cos_rear * tan_difference;
+  const double rear_track_tmp = wheel_track_ * rear_tmp;
+  const double rear_track_term = 1 + rear_track_tmp * rear_track_tmp / 4;
+  const double rear_left_tmp = rear_tmp / std::sqrt(rear_track_term - rear_track_tmp * cos_rear);
+  const double rear_right_tmp = rear_tmp / std::sqrt(rear_track_term + rear_track_tmp * cos_rear);
 
   const double rl_speed_tmp = rl_speed * (1 / (1 - y_steering_offset_ * rear_left_tmp));
   const double rr_speed_tmp = rr_speed * (1 / (1 - y_steering_offset_ * rear_right_tmp));
 
-  const double rear_linear_speed = wheel_radius_ * copysign(1.0, rl_speed_tmp + rr_speed_tmp)*
-      sqrt((pow(rl_speed_tmp, 2) + pow(rr_speed_tmp, 2)) / (2 + pow(wheel_track_ * rear_tmp, 2) / 2.0));
-
-  angular_ = (front_linear_speed * front_tmp + rear_linear_speed * rear_tmp) / 2.0;
+  const double rear_linear_speed =
+    wheel_radius_ * std::copysign(1.0, rl_speed_tmp + rr_speed_tmp) *
+    std::sqrt(
+      (rl_speed_tmp * rl_speed_tmp + rr_speed_tmp * rr_speed_tmp) /
+      (2 + rear_track_tmp * rear_track_tmp / 2.0));
 
-  const double linear_x_ = (front_linear_speed * cos(front_steering) + rear_linear_speed * cos(rear_steering)) / 2.0;
-  const double linear_y_ = (front_linear_speed * sin(front_steering) - wheelbase_ * angular_ / 2.0
-              + rear_linear_speed * sin(rear_steering) + wheelbase_ * angular_ / 2.0) / 2.0;
+  const double angular = (front_linear_speed * front_tmp + rear_linear_speed * rear_tmp) / 2.0;
 
-  const double linear_velocity =  copysign(1.0, rear_linear_speed)*sqrt(pow(linear_x_,2)+pow(linear_y_,2));
+  const double linear_x_ = (front_linear_speed * cos_front + rear_linear_speed * cos_rear) / 2.0;
+  // the rotation of the front and rear axles around the center cancels out
+  const double linear_y_ = (front_linear_speed * sin_front + rear_linear_speed * sin_rear) / 2.0;
 
-  /// Integrate odometry:
-  // integrateXY(linear_x_*dt, linear_y_*dt, angular_*dt);
+  const double linear_velocity =
+    std::copysign(1.0, rear_linear_speed) * std::hypot(linear_x_, linear_y_);
 
-  // linear_accel_acc_((linear_vel_prev_ - linear_velocity)/dt);
-  // linear_vel_prev_ = linear_velocity;
-  // linear_jerk_acc_((linear_accel_prev_ - bacc::rolling_mean(linear_accel_acc_))/dt);
-  // linear_accel_prev_ = bacc::rolling_mean(linear_accel_acc_);
-  // front_steer_vel_acc_((front_steer_vel_prev_ - front_steering)/dt);
-  // front_steer_vel_prev_ = front_steering;
-  // rear_steer_vel_acc_((rear_steer_vel_prev_ - rear_steering)/dt);
-  // rear_steer_vel_prev_ = rear_steering;
-  return update_odometry(linear_velocity, angular_, dt);
+  return update_odometry(linear_velocity, angular, dt);
 }
 
 bool SteeringOdometry::update_from_velocity(
@@ -259,9 +301,54 @@ void SteeringOdometry::set_velocity_rolling_window_size(size_t velocity_rolling_
   reset_accumulators();
 }
 
-void SteeringOdometry::set_odometry_type(const unsigned int type) { config_type_ = type; }
+void SteeringOdometry::set_velocity_smoothing_mode(controller_realtime_tools::SmoothingMode mode)
+{
+  velocity_smoothing_mode_ = mode;
+
+  reset_accumulators();
+}
+
+void SteeringOdometry::set_pose_covariance_params(
+  bool propagate, double x_variance, double y_variance, double heading_variance,
+  double linear_noise, double angular_noise)
+{
+  propagate_pose_covariance_ = propagate;
+  initial_pose_covariance_ = {
+    x_variance, 0.0, 0.0, 0.0, y_variance, 0.0, 0.0, 0.0, heading_variance};
+  pose_covariance_ = initial_pose_covariance_;
+  linear_noise_ = linear_noise;
+  angular_noise_ = angular_noise;
+}
 
-double SteeringOdometry::convert_trans_rot_vel_to_steering_angle(double Vx, double theta_dot)
+void SteeringOdometry::set_imu_weight(double weight)
+{
+  imu_weight_ = std::clamp(weight, 0.0, 1.0);
+}
+
+void SteeringOdometry::set_odometry_type(const unsigned int type)
+{
+  switch (type)
+  {
+    case BICYCLE_CONFIG:
+      set_kinematic_model<BicycleModel>();
+      break;
+    case TRICYCLE_CONFIG:
+      set_kinematic_model<TricycleModel>();
+      break;
+    case ACKERMANN_CONFIG:
+      set_kinematic_model<AckermannModel>();
+      break;
+    case FOUR_STEERING_CONFIG:
+      set_kinematic_model<FourWheelSteerModel>();
+      break;
+    default:
+      config_type_ = static_cast<int>(type);
+      commands_function_ = nullptr;
+      break;
+  }
+}
+
+double SteeringOdometry::convert_trans_rot_vel_to_steering_angle(double Vx, double theta_dot) const
 {
   if (theta_dot == 0 || Vx == 0)
   {
@@ -270,166 +357,196 @@ double SteeringOdometry::convert_trans_rot_vel_to_steering_angle(double Vx, doub
   return std::atan(theta_dot * wheelbase_ / Vx);
 }
 
+void SteeringOdometry::get_wheel_command(
+  double Vx, double theta_dot, double & Ws, double & alpha) const
+{
+  steering_odometry::get_wheel_command(
+    {wheel_radius_, wheelbase_, wheel_track_, y_steering_offset_, steer_pos_}, Vx, theta_dot, Ws,
+    alpha);
+}
+
 std::tuple<std::vector<double>, std::vector<double>> SteeringOdometry::get_commands(
   double Vx, double theta_dot)
 {
-  // desired velocity and steering angle of the middle of traction and steering axis
-  double Ws, alpha;
-
-  if (Vx == 0 && theta_dot != 0)
+  JointCommands commands;
+  if (!get_commands(Vx, theta_dot, commands))
   {
-    alpha = theta_dot > 0 ? M_PI_2 : -M_PI_2;
-    Ws = abs(theta_dot) * wheelbase_ / wheel_radius_;
+    throw std::runtime_error("Config not implemented");
   }
-  else
+  const auto traction_end =
+    commands.traction.begin() + static_cast<std::ptrdiff_t>(commands.traction_count);
+  const auto steering_end =
+    commands.steering.begin() + static_cast<std::ptrdiff_t>(commands.steering_count);
+  return std::make_tuple(
+    std::vector<double>(commands.traction.begin(), traction_end),
+    std::vector<double>(commands.steering.begin(), steering_end));
+}
+
+bool SteeringOdometry::get_commands(double Vx, double theta_dot, JointCommands & commands)
+{
+  if (commands_function_ == nullptr)
   {
-    alpha = SteeringOdometry::convert_trans_rot_vel_to_steering_angle(Vx, theta_dot);
-    Ws = Vx / (wheel_radius_ * std::cos(steer_pos_));
+    return false;
   }
+  double Ws, alpha;
+  get_wheel_command(Vx, theta_dot, Ws, alpha);
+  (this->*commands_function_)(Ws, alpha, commands);
+  return true;
+}
 
-  if (config_type_ == BICYCLE_CONFIG)
+bool SteeringOdometry::get_commands_from_steering_angle(
+  double speed, double steering_angle, JointCommands & commands)
+{
+  if (commands_function_ == nullptr)
   {
-    std::vector<double> traction_commands = {Ws};
-    std::vector<double> steering_commands = {alpha};
-    return std::make_tuple(traction_commands, steering_commands);
+    return false;
   }
-  else if (config_type_ == TRICYCLE_CONFIG)
+  // wheel velocity as in get_wheel_command()
+  const double Ws = speed / (wheel_radius_ * std::cos(steer_pos_));
+  (this->*commands_function_)(Ws, steering_angle, commands);
+  return true;
+}
+
+double SteeringOdometry::convert_steering_angle_to_rot_vel(
+  double speed, double steering_angle) const
+{
+  return speed * std::tan(steering_angle) / wheelbase_;
+}
+
+bool SteeringOdometry::set_wheel_positions(
+  const std::vector<double> & x, const std::vector<double> & y, const std::vector<bool> & steered)
+{
+  return multi_wheel_kinematics_.set_wheels(x, y, steered);
+}
+
+bool SteeringOdometry::update_from_wheel_velocities(
+  const std::vector<double> & wheel_velocities, const std::vector<double> & steering_angles,
+  const double dt)
+{
+  const size_t wheels = multi_wheel_kinematics_.size();
+  if (wheels == 0 || wheel_velocities.size() != wheels || steering_angles.size() != wheels)
   {
-    std::vector<double> traction_commands;
-    std::vector<double> steering_commands;
-    if (fabs(steer_pos_) < 1e-6)
-    {
-      traction_commands = {Ws, Ws};
-    }
-    else
-    {
-      double turning_radius = wheelbase_ / std::tan(steer_pos_);
-      double Wr = Ws * (turning_radius + wheel_track_ * 0.5) / turning_radius;
-      double Wl = Ws * (turning_radius - wheel_track_ * 0.5) / turning_radius;
-      traction_commands = {Wr, Wl};
-    }
-    steering_commands = {alpha};
-    return std::make_tuple(traction_commands, steering_commands);
+    return false;
   }
-  else if (config_type_ == ACKERMANN_CONFIG)
+  std::array<double, 3> twist;
+  multi_wheel_kinematics_.get_twist(wheel_velocities, steering_angles, wheel_radius_, twist);
+
+  // integrate along the direction of travel in the base frame, which turns with the heading
+  double linear_velocity = std::hypot(twist[0], twist[1]);
+  double direction = std::atan2(twist[1], twist[0]);
+  if (twist[0] < 0.0)
   {
-    std::vector<double> traction_commands;
-    std::vector<double> steering_commands;
-    if (fabs(steer_pos_) < 1e-6)
-    {
-      traction_commands = {Ws, Ws};
-      steering_commands = {alpha, alpha};
-    }
-    else
-    {
-      double turning_radius = wheelbase_ / std::tan(steer_pos_);
-      double Wr = Ws * (turning_radius + wheel_track_ * 0.5) / turning_radius;
-      double Wl = Ws * (turning_radius - wheel_track_ * 0.5) / turning_radius;
-      traction_commands = {Wr, Wl};
-
-      double numerator = 2 * wheelbase_ * std::sin(alpha);
-      double denominator_first_member = 2 * wheelbase_ * std::cos(alpha);
-      double denominator_second_member = wheel_track_ * std::sin(alpha);
-
-      double alpha_r = std::atan2(numerator, denominator_first_member - denominator_second_member);
-      double alpha_l = std::atan2(numerator, denominator_first_member + denominator_second_member);
-      steering_commands = {alpha_r, alpha_l};
-    }
-    return std::make_tuple(traction_commands, steering_commands);
+    linear_velocity = -linear_velocity;
+    direction = std::atan2(-twist[1], -twist[0]);
   }
-  else if (config_type_ == FOUR_STEERING_CONFIG) 
-  {
-    std::vector<double> traction_commands;
-    std::vector<double> steering_commands;
-    
-    double steering_track = wheel_track_- 2 * y_steering_offset_;
-    double vel_steering_offset = (alpha * y_steering_offset_) / wheel_radius_;
-    double sign = copysign(1.0, Ws);
-    double vel_left_front  = sign * std::hypot((Ws - alpha * steering_track / 2),
-                                        (wheelbase_ * alpha / 2.0)) / wheel_radius_
-                      - vel_steering_offset;
-    double vel_right_front = sign * std::hypot((Ws + alpha * steering_track / 2),
-                                        (wheelbase_ * alpha / 2.0)) / wheel_radius_
-                      + vel_steering_offset;
-    double vel_left_rear = sign * std::hypot((Ws - alpha * steering_track / 2),
-                                      (wheelbase_ * alpha / 2.0)) / wheel_radius_
-                    - vel_steering_offset;
-    double vel_right_rear = sign * std::hypot((Ws + alpha * steering_track / 2),
-                                        (wheelbase_ * alpha / 2.0)) / wheel_radius_
-                      + vel_steering_offset;
-    traction_commands = {vel_left_front, vel_right_front, vel_left_rear, vel_right_rear};
-
-    double front_left_steering = 0.0;
-    double front_right_steering = 0.0;
-    // Compute steering angles
-    if(fabs(2.0 * Ws) > fabs(alpha * steering_track))
-    {
-      front_left_steering = atan(alpha * wheelbase_ /
-                                  (2.0 * Ws - alpha * steering_track));
-      front_right_steering = atan(alpha * wheelbase_ /
-                                    (2.0 * Ws + alpha * steering_track));
-    }
-    else if(fabs(Ws) > 0.001)
-    {
-      front_left_steering = copysign(M_PI_2, alpha);
-      front_right_steering = copysign(M_PI_2, alpha);
-    }
-    double rear_left_steering = -front_left_steering;
-    double rear_right_steering = -front_right_steering;
-    steering_commands = {front_left_steering, front_right_steering, rear_left_steering, rear_right_steering};
+  pose_.set_heading(pose_.heading() + direction);
+  const bool updated = update_odometry(linear_velocity, twist[2], dt);
+  pose_.set_heading(pose_.heading() - direction);
+  return updated;
+}
 
-    return std::make_tuple(traction_commands, steering_commands);
-  }
-  else
+bool SteeringOdometry::get_wheel_commands(
+  double Vx, double Vy, double theta_dot, std::vector<double> & wheel_velocities,
+  std::vector<double> & steering_angles) const
+{
+  const size_t wheels = multi_wheel_kinematics_.size();
+  if (wheels == 0 || wheel_velocities.size() != wheels || steering_angles.size() != wheels)
   {
-    throw std::runtime_error("Config not implemented");
+    return false;
   }
+  multi_wheel_kinematics_.get_commands(
+    {Vx, Vy, theta_dot}, wheel_radius_, wheel_velocities, steering_angles);
+  return true;
 }
 
 void SteeringOdometry::reset_odometry()
 {
-  x_ = 0.0;
-  y_ = 0.0;
-  heading_ = 0.0;
+  pose_.reset(0.0, 0.0, 0.0);
+  pose_covariance_ = initial_pose_covariance_;
   reset_accumulators();
 }
 
-void SteeringOdometry::integrate_runge_kutta_2(double linear, double angular)
+void SteeringOdometry::integrate_exact(double linear, double angular)
 {
-  const double direction = heading_ + angular * 0.5;
-
-  /// Runge-Kutta 2nd order integration:
-  x_ += linear * cos(direction);
-  y_ += linear * sin(direction);
-  heading_ += angular;
+  if (propagate_pose_covariance_)
+  {
+    propagate_step_covariance(linear, angular);
+  }
+  pose_.integrate(linear, angular);
 }
 
-/**
- * \brief Other possible integration method provided by the class
- * \param linear
- * \param angular
- */
-void SteeringOdometry::integrate_exact(double linear, double angular)
+void SteeringOdometry::propagate_step_covariance(double linear, double angular)
 {
-  if (fabs(angular) < 1e-6)
+  // Jacobians of the step of PoseIntegrator::integrate() at the pose before it
+  const double sin_heading = pose_.sin_heading();
+  const double cos_heading = pose_.cos_heading();
+  if (fabs(angular) < controller_realtime_tools::STRAIGHT_STEP_ANGULAR_THRESHOLD)
   {
-    integrate_runge_kutta_2(linear, angular);
+    const double cos_direction = cos_heading - sin_heading * angular * 0.5;
+    const double sin_direction = sin_heading + cos_heading * angular * 0.5;
+    propagate_pose_covariance(
+      -linear * sin_direction, linear * cos_direction,
+      {cos_direction, -0.5 * linear * sin_direction, sin_direction, 0.5 * linear * cos_direction},
+      linear, angular);
   }
   else
   {
-    /// Exact integration (should solve problems when angular is zero):
-    const double heading_old = heading_;
+    double sin_heading_new;
+    double cos_heading_new;
+    controller_realtime_tools::sin_cos(pose_.heading() + angular, sin_heading_new, cos_heading_new);
     const double r = linear / angular;
-    heading_ += angular;
-    x_ += r * (sin(heading_) - sin(heading_old));
-    y_ += -r * (cos(heading_) - cos(heading_old));
+    const double delta_sin = sin_heading_new - sin_heading;
+    const double delta_cos = cos_heading_new - cos_heading;
+    propagate_pose_covariance(
+      r * delta_cos, r * delta_sin,
+      {delta_sin / angular, r * (cos_heading_new - delta_sin / angular), -delta_cos / angular,
+       r * (sin_heading_new + delta_cos / angular)},
+      linear, angular);
+  }
+}
+
+void SteeringOdometry::propagate_pose_covariance(
+  double dx_dheading, double dy_dheading, const std::array<double, 4> & position_jacobian,
+  double linear, double angular)
+{
+  // P = F * P * F^T + G * Q * G^T, with the Jacobians of the step with respect to the pose (F)
+  // and to the linear and angular displacements (G), whose variances Q grow with their size
+  const double F[3][3] = {{1.0, 0.0, dx_dheading}, {0.0, 1.0, dy_dheading}, {0.0, 0.0, 1.0}};
+  const double G[3][2] = {
+    {position_jacobian[0], position_jacobian[1]},
+    {position_jacobian[2], position_jacobian[3]},
+    {0.0, 1.0}};
+  const double Q[2] = {linear_noise_ * fabs(linear), angular_noise_ * fabs(angular)};
+
+  std::array<double, 9> FP{};
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      for (size_t k = 0; k < 3; ++k)
+      {
+        FP[i * 3 + j] += F[i][k] * pose_covariance_[k * 3 + j];
+      }
+    }
+  }
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      double value = G[i][0] * G[j][0] * Q[0] + G[i][1] * G[j][1] * Q[1];
+      for (size_t k = 0; k < 3; ++k)
+      {
+        value += FP[i * 3 + k] * F[j][k];
+      }
+      pose_covariance_[i * 3 + j] = value;
+    }
   }
 }
 
 void SteeringOdometry::reset_accumulators()
 {
-  linear_acc_ = rcpputils::RollingMeanAccumulator<double>(velocity_rolling_window_size_);
-  angular_acc_ = rcpputils::RollingMeanAccumulator<double>(velocity_rolling_window_size_);
+  linear_acc_.configure(velocity_rolling_window_size_, velocity_smoothing_mode_);
+  angular_acc_.configure(velocity_rolling_window_size_, velocity_smoothing_mode_);
 }
 
 }  // namespace steering_odometry
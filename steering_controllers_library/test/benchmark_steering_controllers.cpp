@@ -0,0 +1,528 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the realtime path of the steering controllers, for every vehicle model.
+//
+// The controllers of the vehicle models depend on this library, so they are not linked here.
+// Instead, every model is configured and updates its odometry like its controller, see
+// BenchmarkSteeringController. The mock hardware follows the commands, and a new reference is
+// written every REFERENCE_CYCLES cycles, from outside of the timed and counted part of the cycle
+// like by the subscribers.
+//
+// The benchmark 'update' reports the time of update_reference_from_subscribers() and
+// update_and_write_commands() per cycle, the heap allocations per cycle and the tail latency of
+// single cycles (p50_ns, p99_ns, max_ns). Arguments: vehicle model (see Model), traction
+// feedback (see Feedback) and reference (see Reference).
+//
+// The benchmarks 'odometry' and 'commands' report the cost of the odometry update and the
+// inverse kinematics of every model alone, the latter dispatched at compile time (0) or through
+// the configured odometry type (1).
+//
+// Like all performance tests, the benchmarks only run with ctest if AMENT_RUN_PERFORMANCE_TESTS is
+// set. Run a subset directly with, e.g.,
+//   benchmark_steering_controllers --benchmark_filter='update/model:2/.*'
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "steering_controllers_library/steering_controllers_library.hpp"
+
+namespace
+{
+enum Model : int64_t
+{
+  BICYCLE = 0,
+  TRICYCLE = 1,
+  ACKERMANN = 2,
+  FOUR_WHEEL_STEER = 3,
+};
+
+enum Feedback : int64_t
+{
+  POSITION = 0,
+  VELOCITY = 1,
+  OPEN_LOOP = 2,
+};
+
+enum Reference : int64_t
+{
+  TWIST = 0,
+  ACKERMANN_DRIVE = 1,
+};
+
+const rclcpp::Duration CYCLE_PERIOD = rclcpp::Duration::from_seconds(0.001);
+constexpr size_t REFERENCE_CYCLES = 10;
+constexpr size_t ODOMETRY_SAMPLES = 1000;
+
+constexpr double WHEELBASE = 3.24644;
+constexpr double WHEEL_TRACK = 1.76868;
+constexpr double WHEEL_RADIUS = 0.45;
+
+/// Call \p function with an instance of the kinematic model of \p model
+template <typename Function>
+void with_model(int64_t model, Function && function)
+{
+  switch (model)
+  {
+    case BICYCLE:
+      function(steering_odometry::BicycleModel{});
+      break;
+    case TRICYCLE:
+      function(steering_odometry::TricycleModel{});
+      break;
+    case ACKERMANN:
+      function(steering_odometry::AckermannModel{});
+      break;
+    default:
+      function(steering_odometry::FourWheelSteerModel{});
+      break;
+  }
+}
+
+/// Body velocities along a winding path
+double get_linear(double t) { return 1.0 + 0.5 * std::sin(0.1 * t); }
+double get_angular(double t) { return 0.2 * std::sin(0.05 * t); }
+
+/// Update \p odometry from the traction and steering \p values like the controller of the model
+template <typename KinematicModel>
+void update_model_odometry(
+  steering_odometry::SteeringOdometry & odometry, bool position_feedback,
+  const std::vector<double> & values, double dt)
+{
+  if constexpr (std::is_same_v<KinematicModel, steering_odometry::BicycleModel>)
+  {
+    if (position_feedback)
+    {
+      odometry.update_from_position(values[0], values[1], dt);
+    }
+    else
+    {
+      odometry.update_from_velocity(values[0], values[1], dt);
+    }
+  }
+  else if constexpr (std::is_same_v<KinematicModel, steering_odometry::TricycleModel>)
+  {
+    if (position_feedback)
+    {
+      odometry.update_from_position(values[0], values[1], values[2], dt);
+    }
+    else
+    {
+      odometry.update_from_velocity(values[0], values[1], values[2], dt);
+    }
+  }
+  else if constexpr (std::is_same_v<KinematicModel, steering_odometry::AckermannModel>)
+  {
+    if (position_feedback)
+    {
+      odometry.update_from_position(values[0], values[1], values[2], values[3], dt);
+    }
+    else
+    {
+      odometry.update_from_velocity(values[0], values[1], values[2], values[3], dt);
+    }
+  }
+  else
+  {
+    const double front_steer_position =
+      steering_odometry::equivalent_steering_angle(values[4], values[5]);
+    const double rear_steer_position =
+      steering_odometry::equivalent_steering_angle(values[6], values[7]);
+    if (position_feedback)
+    {
+      odometry.update_from_position(
+        values[0], values[1], values[2], values[3], front_steer_position, rear_steer_position,
+        dt);
+    }
+    else
+    {
+      odometry.update_from_velocity(
+        values[0], values[1], values[2], values[3], front_steer_position, rear_steer_position,
+        dt);
+    }
+  }
+}
+
+class BenchmarkSteeringControllersLibrary
+: public steering_controllers_library::SteeringControllersLibrary
+{
+public:
+  using steering_controllers_library::SteeringControllersLibrary::write_reference;
+
+  // the parameters of the library are all a vehicle model needs here
+  void initialize_implementation_parameter_listener() override {}
+};
+
+/// Configured and updating its odometry like the controller of the model
+template <typename KinematicModel>
+class BenchmarkSteeringController : public BenchmarkSteeringControllersLibrary
+{
+public:
+  controller_interface::CallbackReturn configure_odometry() override
+  {
+    odometry_.set_wheel_params(WHEEL_RADIUS, WHEELBASE, WHEEL_TRACK, 0.0);
+    odometry_.set_kinematic_model<KinematicModel>();
+    const size_t joints = KinematicModel::TRACTION_JOINTS + KinematicModel::STEERING_JOINTS;
+    return set_interface_numbers(joints, joints, 2);
+  }
+
+  bool update_odometry(const rclcpp::Duration & period) override
+  {
+    if (params_.open_loop)
+    {
+      odometry_.update_open_loop(last_linear_velocity_, last_angular_velocity_, period.seconds());
+    }
+    else if (state_values_valid_)
+    {
+      update_model_odometry<KinematicModel>(
+        odometry_, params_.position_feedback, state_values_, period.seconds());
+    }
+    return true;
+  }
+};
+
+std::vector<std::string> make_joint_names(const std::string & prefix, size_t count)
+{
+  std::vector<std::string> joint_names(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    joint_names[i] = prefix + std::to_string(i + 1) + "_joint";
+  }
+  return joint_names;
+}
+
+std::vector<rclcpp::Parameter> make_parameters(Model model, Feedback feedback, Reference reference)
+{
+  size_t traction_joints = 0;
+  size_t steering_joints = 0;
+  with_model(
+    model,
+    [&](auto kinematic_model)
+    {
+      traction_joints = decltype(kinematic_model)::TRACTION_JOINTS;
+      steering_joints = decltype(kinematic_model)::STEERING_JOINTS;
+    });
+  const auto traction_names = make_joint_names("traction_wheel", traction_joints);
+  const auto steering_names = make_joint_names("steering_wheel", steering_joints);
+  return {
+    rclcpp::Parameter("reference_timeout", 0.1),
+    rclcpp::Parameter("front_steering", true),
+    rclcpp::Parameter("four_steering", model == FOUR_WHEEL_STEER),
+    rclcpp::Parameter("rear_wheels_names", traction_names),
+    rclcpp::Parameter("front_wheels_names", steering_names),
+    rclcpp::Parameter("wheels_names", traction_names),
+    rclcpp::Parameter("steers_names", steering_names),
+    rclcpp::Parameter("open_loop", feedback == OPEN_LOOP),
+    rclcpp::Parameter("position_feedback", feedback == POSITION),
+    rclcpp::Parameter("use_ackermann_reference", reference == ACKERMANN_DRIVE)};
+}
+
+/// Times of single cycles, to report the tail latency
+class CycleTimes
+{
+public:
+  explicit CycleTimes(const benchmark::State & state)
+  {
+    times_ns_.reserve(static_cast<size_t>(state.max_iterations));
+  }
+
+  void add(std::chrono::steady_clock::duration cycle_time, benchmark::State & state)
+  {
+    const auto cycle_time_ns = std::chrono::duration<double, std::nano>(cycle_time).count();
+    times_ns_.push_back(cycle_time_ns);
+    state.SetIterationTime(cycle_time_ns * 1e-9);
+  }
+
+  void report(benchmark::State & state, size_t allocations)
+  {
+    std::sort(times_ns_.begin(), times_ns_.end());
+    auto percentile = [this](double p)
+    {
+      return times_ns_[static_cast<size_t>(p * static_cast<double>(times_ns_.size() - 1))];
+    };
+    if (!times_ns_.empty())
+    {
+      state.counters["p50_ns"] = percentile(0.5);
+      state.counters["p99_ns"] = percentile(0.99);
+      state.counters["max_ns"] = times_ns_.back();
+    }
+    state.counters["allocations"] = benchmark::Counter(
+      static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+  }
+
+private:
+  std::vector<double> times_ns_;
+};
+
+class SteeringControllerBenchmark : public benchmark::Fixture
+{
+public:
+  void SetUp(benchmark::State & state) override
+  {
+    rclcpp::init(0, nullptr);
+
+    const auto model = static_cast<Model>(state.range(0));
+    const auto feedback = static_cast<Feedback>(state.range(1));
+    reference_ = static_cast<Reference>(state.range(2));
+    with_model(
+      model,
+      [this](auto kinematic_model)
+      {
+        controller_ =
+          std::make_shared<BenchmarkSteeringController<decltype(kinematic_model)>>();
+      });
+
+    const auto options = rclcpp::NodeOptions()
+                           .allow_undeclared_parameters(false)
+                           .parameter_overrides(make_parameters(model, feedback, reference_))
+                           .automatically_declare_parameters_from_overrides(false);
+    controller_->init("benchmark_steering_controllers", "", options);
+    auto node = controller_->get_node();
+    node->configure();
+    controller_->export_reference_interfaces();
+
+    // the traction wheels come first, the states follow the commands
+    const auto command_names = controller_->command_interface_configuration().names;
+    const auto state_names = controller_->state_interface_configuration().names;
+    const auto traction_joints = static_cast<size_t>(std::count_if(
+      command_names.begin(), command_names.end(), [](const std::string & name)
+      { return name.substr(name.rfind('/') + 1) == hardware_interface::HW_IF_VELOCITY; }));
+    command_values_.assign(command_names.size(), 0.0);
+    state_values_.assign(state_names.size(), 0.0);
+    std::vector<hardware_interface::LoanedCommandInterface> loaned_command_interfaces;
+    std::vector<hardware_interface::LoanedStateInterface> loaned_state_interfaces;
+    command_interfaces_.reserve(command_names.size());
+    state_interfaces_.reserve(state_names.size());
+    for (size_t i = 0; i < command_names.size(); ++i)
+    {
+      const auto separator = command_names[i].rfind('/');
+      command_interfaces_.emplace_back(
+        command_names[i].substr(0, separator), command_names[i].substr(separator + 1),
+        &command_values_[i]);
+      loaned_command_interfaces.emplace_back(command_interfaces_.back());
+    }
+    for (size_t i = 0; i < state_names.size(); ++i)
+    {
+      const auto separator = state_names[i].rfind('/');
+      const auto interface_name = state_names[i].substr(separator + 1);
+      state_interfaces_.emplace_back(
+        state_names[i].substr(0, separator), interface_name, &state_values_[i]);
+      loaned_state_interfaces.emplace_back(state_interfaces_.back());
+      integrate_state_.push_back(
+        i < traction_joints && interface_name == hardware_interface::HW_IF_POSITION);
+    }
+    controller_->assign_interfaces(
+      std::move(loaned_command_interfaces), std::move(loaned_state_interfaces));
+    node->activate();
+  }
+
+  void TearDown(benchmark::State &) override
+  {
+    controller_->get_node()->deactivate();
+    controller_.reset();
+    command_interfaces_.clear();
+    state_interfaces_.clear();
+    integrate_state_.clear();
+    rclcpp::shutdown();
+  }
+
+protected:
+  void write_reference(const rclcpp::Time & time)
+  {
+    const double t = time.seconds();
+    if (reference_ == ACKERMANN_DRIVE)
+    {
+      steering_controllers_library::SteeringControllersLibrary::ControllerAckermannReferenceMsg
+        msg;
+      msg.header.stamp = time;
+      msg.drive.speed = static_cast<float>(get_linear(t));
+      msg.drive.steering_angle =
+        static_cast<float>(std::atan(get_angular(t) * WHEELBASE / get_linear(t)));
+      controller_->write_reference(msg);
+      return;
+    }
+    steering_controllers_library::SteeringControllersLibrary::ControllerTwistReferenceMsg msg;
+    msg.header.stamp = time;
+    msg.twist.linear.x = get_linear(t);
+    msg.twist.angular.z = get_angular(t);
+    controller_->write_reference(msg);
+  }
+
+  /// Move the mock hardware to the commands, integrating the traction positions
+  void follow_commands()
+  {
+    for (size_t i = 0; i < state_values_.size(); ++i)
+    {
+      state_values_[i] = integrate_state_[i]
+                           ? state_values_[i] + command_values_[i] * CYCLE_PERIOD.seconds()
+                           : command_values_[i];
+    }
+  }
+
+  Reference reference_;
+  std::shared_ptr<BenchmarkSteeringControllersLibrary> controller_;
+  std::vector<double> command_values_;
+  std::vector<double> state_values_;
+  std::vector<bool> integrate_state_;
+  std::vector<hardware_interface::CommandInterface> command_interfaces_;
+  std::vector<hardware_interface::StateInterface> state_interfaces_;
+};
+}  // namespace
+
+BENCHMARK_DEFINE_F(SteeringControllerBenchmark, update)(benchmark::State & state)
+{
+  rclcpp::Time time(1, 0, RCL_ROS_TIME);
+  size_t cycle = 0;
+
+  CycleTimes cycle_times(state);
+  controller_realtime_tools::ScopedRealtimeSafetyCounter allocation_counter;
+  for (auto _ : state)
+  {
+    if (cycle++ % REFERENCE_CYCLES == 0)
+    {
+      controller_realtime_tools::realtime_safety::counting = false;
+      write_reference(time);
+      controller_realtime_tools::realtime_safety::counting = true;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    controller_->update_reference_from_subscribers(time, CYCLE_PERIOD);
+    controller_->update_and_write_commands(time, CYCLE_PERIOD);
+    cycle_times.add(std::chrono::steady_clock::now() - start, state);
+    follow_commands();
+    time += CYCLE_PERIOD;
+  }
+  cycle_times.report(state, allocation_counter.get_allocations());
+}
+
+BENCHMARK_REGISTER_F(SteeringControllerBenchmark, update)
+  ->ArgNames({"model", "feedback", "reference"})
+  ->ArgsProduct(
+    {{BICYCLE, TRICYCLE, ACKERMANN, FOUR_WHEEL_STEER},
+     {POSITION, VELOCITY, OPEN_LOOP},
+     {TWIST, ACKERMANN_DRIVE}})
+  ->UseManualTime();
+
+static void odometry(benchmark::State & state)
+{
+  const auto feedback = static_cast<Feedback>(state.range(1));
+  with_model(
+    state.range(0),
+    [&](auto kinematic_model)
+    {
+      using KinematicModel = decltype(kinematic_model);
+      steering_odometry::SteeringOdometry odometry;
+      odometry.set_wheel_params(WHEEL_RADIUS, WHEELBASE, WHEEL_TRACK, 0.0);
+      odometry.set_kinematic_model<KinematicModel>();
+
+      // wheel states of a drive along the winding path, the traction positions integrated
+      const double dt = CYCLE_PERIOD.seconds();
+      std::vector<std::vector<double>> samples(ODOMETRY_SAMPLES);
+      std::vector<double> traction_positions(KinematicModel::TRACTION_JOINTS, 0.0);
+      steering_odometry::JointCommands commands;
+      for (size_t k = 0; k < ODOMETRY_SAMPLES; ++k)
+      {
+        const double t = static_cast<double>(k) * dt;
+        odometry.get_commands<KinematicModel>(get_linear(t), get_angular(t), commands);
+        auto & values = samples[k];
+        for (size_t i = 0; i < KinematicModel::TRACTION_JOINTS; ++i)
+        {
+          traction_positions[i] += commands.traction[i] * dt;
+          values.push_back(feedback == POSITION ? traction_positions[i] : commands.traction[i]);
+        }
+        values.insert(
+          values.end(), commands.steering.begin(),
+          commands.steering.begin() +
+            static_cast<std::ptrdiff_t>(KinematicModel::STEERING_JOINTS));
+      }
+
+      size_t k = 0;
+      controller_realtime_tools::ScopedRealtimeSafetyCounter allocation_counter;
+      for (auto _ : state)
+      {
+        if (feedback == OPEN_LOOP)
+        {
+          const double t = static_cast<double>(k) * dt;
+          odometry.update_open_loop(get_linear(t), get_angular(t), dt);
+        }
+        else
+        {
+          update_model_odometry<KinematicModel>(odometry, feedback == POSITION, samples[k], dt);
+        }
+        benchmark::DoNotOptimize(odometry.get_x());
+        k = (k + 1) % ODOMETRY_SAMPLES;
+      }
+      state.counters["allocations"] = benchmark::Counter(
+        static_cast<double>(allocation_counter.get_allocations()),
+        benchmark::Counter::kAvgIterations);
+    });
+}
+
+BENCHMARK(odometry)
+  ->ArgNames({"model", "feedback"})
+  ->ArgsProduct(
+    {{BICYCLE, TRICYCLE, ACKERMANN, FOUR_WHEEL_STEER}, {POSITION, VELOCITY, OPEN_LOOP}});
+
+static void commands(benchmark::State & state)
+{
+  const bool configured_type = state.range(1) == 1;
+  with_model(
+    state.range(0),
+    [&](auto kinematic_model)
+    {
+      using KinematicModel = decltype(kinematic_model);
+      steering_odometry::SteeringOdometry odometry;
+      odometry.set_wheel_params(WHEEL_RADIUS, WHEELBASE, WHEEL_TRACK, 0.0);
+      odometry.set_kinematic_model<KinematicModel>();
+      odometry.update_from_velocity(1.0, 0.1, CYCLE_PERIOD.seconds());
+
+      steering_odometry::JointCommands commands;
+      double t = 0.0;
+      controller_realtime_tools::ScopedRealtimeSafetyCounter allocation_counter;
+      for (auto _ : state)
+      {
+        if (configured_type)
+        {
+          odometry.get_commands(get_linear(t), get_angular(t), commands);
+        }
+        else
+        {
+          odometry.get_commands<KinematicModel>(get_linear(t), get_angular(t), commands);
+        }
+        benchmark::DoNotOptimize(commands);
+        t += CYCLE_PERIOD.seconds();
+      }
+      state.counters["allocations"] = benchmark::Counter(
+        static_cast<double>(allocation_counter.get_allocations()),
+        benchmark::Counter::kAvgIterations);
+    });
+}
+
+BENCHMARK(commands)
+  ->ArgNames({"model", "dispatch"})
+  ->ArgsProduct({{BICYCLE, TRICYCLE, ACKERMANN, FOUR_WHEEL_STEER}, {0, 1}});
@@ -0,0 +1,331 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replay of traction wheel and steering recordings through
+// steering_odometry::SteeringOdometry in the bicycle configuration.
+//
+// The recording is read from the CSV file named by the environment variable ODOMETRY_RECORDING,
+// with the columns 'time,traction_position,traction_velocity,steering_angle' in s, rad, rad/s and
+// rad, optionally followed by the ground truth 'x,y,heading' and 'linear,angular'. Lines that
+// don't start with a number are skipped. The wheels are set with ODOMETRY_WHEELBASE and
+// ODOMETRY_WHEEL_RADIUS. Without a file, a drive of ODOMETRY_SAMPLES samples (default 1000000) at
+// 1 kHz along a winding path is generated, with the exact pose as ground truth.
+//
+// The argument 'method' selects the update of the odometry: from the traction wheel position
+// (0), from its velocity (1), or open loop from the body velocities (2). The argument 'window'
+// sets the velocity rolling window size.
+//
+// Every benchmark replays the whole recording per iteration and reports the time per update
+// (ns_per_update). A replay before the timed ones reports the drift from the ground truth at the
+// end of the recording (position_error, heading_error, drift_per_km) and the RMS error of the
+// estimated velocities (linear_rms_error, angular_rms_error).
+//
+// Like all performance tests, the benchmarks only run with ctest if AMENT_RUN_PERFORMANCE_TESTS is
+// set.
+
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "steering_controllers_library/steering_odometry.hpp"
+
+namespace
+{
+enum Method : int64_t
+{
+  POSITION = 0,
+  VELOCITY = 1,
+  OPEN_LOOP = 2,
+};
+constexpr double SAMPLE_PERIOD = 0.001;
+
+double get_env(const char * name, double default_value)
+{
+  const char * value = std::getenv(name);
+  return value ? std::strtod(value, nullptr) : default_value;
+}
+
+/// Traction wheel position, velocity and steering angle per sample, with the ground truth if known
+struct Recording
+{
+  double wheelbase = 0.0;
+  double wheel_radius = 0.0;
+  std::vector<double> time;
+  std::vector<double> traction_position;
+  std::vector<double> traction_velocity;
+  std::vector<double> steering_angle;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> heading;
+  std::vector<double> linear;
+  std::vector<double> angular;
+  // travelled distance [m]
+  double distance = 0.0;
+
+  size_t size() const { return time.size(); }
+};
+
+Recording read_recording(const std::string & file_name)
+{
+  Recording recording;
+  recording.wheelbase = get_env("ODOMETRY_WHEELBASE", 1.0);
+  recording.wheel_radius = get_env("ODOMETRY_WHEEL_RADIUS", 0.1);
+
+  std::ifstream file(file_name);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (
+      line.empty() ||
+      !(std::isdigit(static_cast<unsigned char>(line[0])) || line[0] == '-' || line[0] == '.'))
+    {
+      continue;
+    }
+    std::vector<double> values;
+    std::istringstream stream(line);
+    std::string value;
+    while (std::getline(stream, value, ','))
+    {
+      values.push_back(std::strtod(value.c_str(), nullptr));
+    }
+    if (values.size() < 4)
+    {
+      continue;
+    }
+    recording.time.push_back(values[0]);
+    recording.traction_position.push_back(values[1]);
+    recording.traction_velocity.push_back(values[2]);
+    recording.steering_angle.push_back(values[3]);
+    if (values.size() >= 7)
+    {
+      if (!recording.x.empty())
+      {
+        recording.distance +=
+          std::hypot(values[4] - recording.x.back(), values[5] - recording.y.back());
+      }
+      recording.x.push_back(values[4]);
+      recording.y.push_back(values[5]);
+      recording.heading.push_back(values[6]);
+    }
+    if (values.size() >= 9)
+    {
+      recording.linear.push_back(values[7]);
+      recording.angular.push_back(values[8]);
+    }
+  }
+  return recording;
+}
+
+/// Drive along a winding path, integrated exactly over 10 steps per sample
+Recording generate_recording()
+{
+  Recording recording;
+  recording.wheelbase = 1.0;
+  recording.wheel_radius = 0.1;
+  const auto samples = static_cast<size_t>(get_env("ODOMETRY_SAMPLES", 1e6));
+
+  constexpr size_t STEPS = 10;
+  const double step = SAMPLE_PERIOD / static_cast<double>(STEPS);
+  auto traction_velocity = [](double t) { return 10.0 + 5.0 * std::sin(0.1 * t); };
+  auto steering_angle = [](double t)
+  { return 0.4 * std::sin(0.05 * t) + 0.2 * std::sin(0.37 * t); };
+  auto linear = [&](double t) { return traction_velocity(t) * recording.wheel_radius; };
+  auto angular = [&](double t)
+  { return std::tan(steering_angle(t)) * linear(t) / recording.wheelbase; };
+
+  double traction_position = 0.0;
+  double x = 0.0;
+  double y = 0.0;
+  double heading = 0.0;
+  for (size_t i = 0; i < samples; ++i)
+  {
+    for (size_t k = 0; k < STEPS; ++k)
+    {
+      const double t = (static_cast<double>(i * STEPS + k) + 0.5) * step;
+      const double v = linear(t);
+      const double w = angular(t);
+      traction_position += traction_velocity(t) * step;
+      const double heading_old = heading;
+      heading += w * step;
+      if (std::fabs(w) > 1e-12)
+      {
+        x += v / w * (std::sin(heading) - std::sin(heading_old));
+        y -= v / w * (std::cos(heading) - std::cos(heading_old));
+      }
+      else
+      {
+        x += v * step * std::cos(heading);
+        y += v * step * std::sin(heading);
+      }
+      recording.distance += v * step;
+    }
+    const double t = static_cast<double>(i + 1) * SAMPLE_PERIOD;
+    recording.time.push_back(t);
+    recording.traction_position.push_back(traction_position);
+    recording.traction_velocity.push_back(traction_velocity(t));
+    recording.steering_angle.push_back(steering_angle(t));
+    recording.x.push_back(x);
+    recording.y.push_back(y);
+    recording.heading.push_back(heading);
+    recording.linear.push_back(linear(t));
+    recording.angular.push_back(angular(t));
+  }
+  return recording;
+}
+
+const Recording & get_recording()
+{
+  static const Recording recording = []()
+  {
+    const char * file_name = std::getenv("ODOMETRY_RECORDING");
+    return file_name ? read_recording(file_name) : generate_recording();
+  }();
+  return recording;
+}
+
+/// Replays a recording through the odometry with one of the update methods
+class Replay
+{
+public:
+  Replay(const Recording & recording, Method method, size_t window)
+  : recording_(recording), method_(method), odometry_(window)
+  {
+    odometry_.set_wheel_params(recording.wheel_radius, recording.wheelbase);
+    odometry_.set_odometry_type(steering_odometry::BICYCLE_CONFIG);
+    periods_.reserve(recording.size());
+    double previous_time = 0.0;
+    for (const double time : recording.time)
+    {
+      periods_.push_back(time - previous_time);
+      previous_time = time;
+    }
+  }
+
+  void update(size_t i)
+  {
+    const double steering_angle = recording_.steering_angle[i];
+    switch (method_)
+    {
+      case POSITION:
+        odometry_.update_from_position(
+          recording_.traction_position[i], steering_angle, periods_[i]);
+        break;
+      case VELOCITY:
+        odometry_.update_from_velocity(
+          recording_.traction_velocity[i], steering_angle, periods_[i]);
+        break;
+      default:
+      {
+        const double linear = recording_.traction_velocity[i] * recording_.wheel_radius;
+        odometry_.update_open_loop(
+          linear, std::tan(steering_angle) * linear / recording_.wheelbase, periods_[i]);
+        break;
+      }
+    }
+  }
+
+  const steering_odometry::SteeringOdometry & odometry() const { return odometry_; }
+
+private:
+  const Recording & recording_;
+  const Method method_;
+  steering_odometry::SteeringOdometry odometry_;
+  std::vector<double> periods_;
+};
+
+/// Replay once and report the errors from the ground truth
+void report_errors(
+  benchmark::State & state, const Recording & recording, Method method, size_t window)
+{
+  Replay replay(recording, method, window);
+  double linear_squared_error = 0.0;
+  double angular_squared_error = 0.0;
+  const bool has_velocities = recording.linear.size() == recording.size();
+  for (size_t i = 0; i < recording.size(); ++i)
+  {
+    replay.update(i);
+    if (has_velocities)
+    {
+      linear_squared_error += std::pow(replay.odometry().get_linear() - recording.linear[i], 2);
+      angular_squared_error += std::pow(replay.odometry().get_angular() - recording.angular[i], 2);
+    }
+  }
+
+  if (recording.x.size() == recording.size())
+  {
+    const double position_error = std::hypot(
+      replay.odometry().get_x() - recording.x.back(),
+      replay.odometry().get_y() - recording.y.back());
+    state.counters["position_error"] = position_error;
+    state.counters["heading_error"] = std::fabs(
+      std::remainder(replay.odometry().get_heading() - recording.heading.back(), 2.0 * M_PI));
+    state.counters["drift_per_km"] =
+      recording.distance > 0.0 ? 1000.0 * position_error / recording.distance : 0.0;
+  }
+  if (has_velocities)
+  {
+    const auto samples = static_cast<double>(recording.size());
+    state.counters["linear_rms_error"] = std::sqrt(linear_squared_error / samples);
+    state.counters["angular_rms_error"] = std::sqrt(angular_squared_error / samples);
+  }
+}
+}  // namespace
+
+static void replay(benchmark::State & state)
+{
+  const auto & recording = get_recording();
+  if (recording.size() == 0)
+  {
+    state.SkipWithError("Empty recording.");
+    return;
+  }
+  const auto method = static_cast<Method>(state.range(0));
+  const auto window = static_cast<size_t>(state.range(1));
+  report_errors(state, recording, method, window);
+
+  double total_ns = 0.0;
+  size_t updates = 0;
+  for (auto _ : state)
+  {
+    Replay replay(recording, method, window);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < recording.size(); ++i)
+    {
+      replay.update(i);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    benchmark::DoNotOptimize(replay.odometry().get_x());
+
+    const double elapsed_ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    total_ns += elapsed_ns;
+    updates += recording.size();
+    state.SetIterationTime(elapsed_ns * 1e-9);
+  }
+  state.counters["ns_per_update"] = updates > 0 ? total_ns / static_cast<double>(updates) : 0.0;
+  state.counters["samples"] = static_cast<double>(recording.size());
+}
+
+BENCHMARK(replay)
+  ->ArgNames({"method", "window"})
+  ->ArgsProduct({{POSITION, VELOCITY, OPEN_LOOP}, {1, 10, 100}})
+  ->UseManualTime()
+  ->Unit(benchmark::kMillisecond);
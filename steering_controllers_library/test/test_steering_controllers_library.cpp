@@ -14,13 +14,17 @@
 
 #include "test_steering_controllers_library.hpp"
 
+#include <array>
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "controller_realtime_tools/realtime_safety_counter.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "steering_controllers_library/fleet_kinematics.hpp"
 
 class SteeringControllersLibraryTest
 : public SteeringControllersLibraryFixture<TestableSteeringControllersLibrary>
@@ -113,17 +117,18 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   msg->twist.angular.x = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.y = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.z = TEST_ANGULAR_VELOCITY_Z;
-  controller_->input_ref_.writeFromNonRT(msg);
+  controller_->write_reference(*msg);
 
   const auto age_of_last_command =
-    controller_->get_node()->now() - (*(controller_->input_ref_.readFromNonRT()))->header.stamp;
+    controller_->get_node()->now() - msg->header.stamp;
 
   // case 1 position_feedback = false
   controller_->params_.position_feedback = false;
 
   // age_of_last_command > ref_timeout_
   ASSERT_FALSE(age_of_last_command <= controller_->ref_timeout_);
-  ASSERT_EQ((*(controller_->input_ref_.readFromRT()))->twist.linear.x, TEST_LINEAR_VELOCITY_X);
+  ASSERT_NE(controller_->read_reference(), nullptr);
+  ASSERT_EQ(controller_->read_reference()->twist.linear.x, TEST_LINEAR_VELOCITY_X);
   ASSERT_EQ(
     controller_->update(controller_->get_node()->now(), rclcpp::Duration::from_seconds(0.01)),
     controller_interface::return_type::OK);
@@ -134,8 +139,8 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   {
     EXPECT_TRUE(std::isnan(interface));
   }
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.linear.x));
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.angular.z));
+  // the timed out reference was consumed
+  EXPECT_EQ(controller_->read_reference(), nullptr);
 
   EXPECT_TRUE(std::isnan(controller_->reference_interfaces_[0]));
   for (const auto & interface : controller_->reference_interfaces_)
@@ -160,11 +165,12 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   msg->twist.angular.x = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.y = std::numeric_limits<double>::quiet_NaN();
   msg->twist.angular.z = TEST_ANGULAR_VELOCITY_Z;
-  controller_->input_ref_.writeFromNonRT(msg);
+  controller_->write_reference(*msg);
 
   // age_of_last_command > ref_timeout_
   ASSERT_FALSE(age_of_last_command <= controller_->ref_timeout_);
-  ASSERT_EQ((*(controller_->input_ref_.readFromRT()))->twist.linear.x, TEST_LINEAR_VELOCITY_X);
+  ASSERT_NE(controller_->read_reference(), nullptr);
+  ASSERT_EQ(controller_->read_reference()->twist.linear.x, TEST_LINEAR_VELOCITY_X);
   ASSERT_EQ(
     controller_->update(controller_->get_node()->now(), rclcpp::Duration::from_seconds(0.01)),
     controller_interface::return_type::OK);
@@ -175,8 +181,8 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   {
     EXPECT_TRUE(std::isnan(interface));
   }
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.linear.x));
-  EXPECT_TRUE(std::isnan((*(controller_->input_ref_.readFromNonRT()))->twist.angular.z));
+  // the timed out reference was consumed
+  EXPECT_EQ(controller_->read_reference(), nullptr);
 
   EXPECT_TRUE(std::isnan(controller_->reference_interfaces_[0]));
   for (const auto & interface : controller_->reference_interfaces_)
@@ -190,6 +196,495 @@ TEST_F(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout)
   }
 }
 
+TEST_F(SteeringControllersLibraryTest, command_latency)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter(rclcpp::Parameter("command_latency.enable", true));
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_NE(controller_->command_latency_, nullptr);
+  controller_->set_chained_mode(false);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto msg = std::make_unique<ControllerReferenceMsg>();
+  msg->header.stamp = controller_->get_node()->now();
+  msg->twist.linear.x = 1.5;
+  msg->twist.angular.z = 0.3;
+  const rclcpp::Time stamp(msg->header.stamp);
+  controller_->reference_callback(std::move(msg));
+
+  // written 50 ms after it was published, the next cycle doesn't count
+  for (const double delay : {0.05, 0.06})
+  {
+    ASSERT_EQ(
+      controller_->update(
+        stamp + rclcpp::Duration::from_seconds(delay), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+  }
+
+  using controller_realtime_tools::LatencyProbe;
+  const auto statistics = controller_->command_latency_->get_statistics();
+  EXPECT_EQ(statistics[LatencyProbe::PUBLISH_TO_WRITE].count, 1u);
+  EXPECT_DOUBLE_EQ(statistics[LatencyProbe::PUBLISH_TO_WRITE].mean_ns, 50e6);
+  EXPECT_EQ(statistics[LatencyProbe::PUBLISH_TO_RECEIVE].count, 1u);
+  EXPECT_EQ(statistics[LatencyProbe::RECEIVE_TO_WRITE].count, 1u);
+}
+
+TEST_F(SteeringControllersLibraryTest, jitter_buffer_plays_out_references_delayed)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter(rclcpp::Parameter("jitter_buffer.enable", true));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("jitter_buffer.delay", 0.1));
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  ASSERT_NE(controller_->reference_jitter_buffer_, nullptr);
+  controller_->set_chained_mode(false);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto msg = std::make_unique<ControllerReferenceMsg>();
+  msg->header.stamp = controller_->get_node()->now();
+  msg->twist.linear.x = 1.5;
+  msg->twist.angular.z = 0.3;
+  const rclcpp::Time stamp(msg->header.stamp);
+  controller_->reference_callback(std::move(msg));
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+
+  // the reference isn't due before the delay
+  ASSERT_EQ(
+    controller_->update_reference_from_subscribers(
+      stamp + rclcpp::Duration::from_seconds(0.05), period),
+    controller_interface::return_type::OK);
+  EXPECT_TRUE(std::isnan(controller_->reference_interfaces_[0]));
+  EXPECT_TRUE(std::isnan(controller_->reference_interfaces_[1]));
+
+  ASSERT_EQ(
+    controller_->update_reference_from_subscribers(
+      stamp + rclcpp::Duration::from_seconds(0.1), period),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(controller_->reference_interfaces_[0], 1.5);
+  EXPECT_EQ(controller_->reference_interfaces_[1], 0.3);
+
+  // the timeout applies from the play out of the reference
+  const rclcpp::Time timed_out =
+    stamp + rclcpp::Duration::from_seconds(0.15) + controller_->ref_timeout_;
+  ASSERT_EQ(
+    controller_->update_reference_from_subscribers(timed_out, period),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(controller_->reference_interfaces_[0], 0.0);
+  EXPECT_EQ(controller_->reference_interfaces_[1], 0.0);
+}
+
+TEST_F(SteeringControllersLibraryTest, update_is_realtime_safe)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  controller_->set_chained_mode(false);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto msg = std::make_unique<ControllerReferenceMsg>();
+  msg->header.stamp = controller_->get_node()->now();
+  msg->twist.linear.x = 1.5;
+  msg->twist.angular.z = 0.3;
+  const rclcpp::Time stamp(msg->header.stamp);
+  controller_->reference_callback(std::move(msg));
+
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+  // the first update takes over the reference
+  ASSERT_EQ(controller_->update(stamp, period), controller_interface::return_type::OK);
+
+  // the odometry and the controller state are published in every cycle
+  controller_realtime_tools::ScopedRealtimeSafetyCounter counter;
+  for (int i = 1; i <= 20; ++i)
+  {
+    controller_->update(stamp + rclcpp::Duration::from_seconds(0.001 * i), period);
+  }
+  EXPECT_EQ(counter.get_allocations(), 0u);
+  EXPECT_EQ(counter.get_deallocations(), 0u);
+  EXPECT_EQ(counter.get_locks(), 0u);
+}
+
+TEST_F(SteeringControllersLibraryTest, intra_process_references_require_keep_last_history)
+{
+  SetUpController();
+  controller_->get_node()->set_parameter(rclcpp::Parameter("reference_qos.intra_process", true));
+
+  controller_->get_node()->set_parameter(rclcpp::Parameter("reference_qos.history", "keep_all"));
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+
+  controller_->get_node()->set_parameter(rclcpp::Parameter("reference_qos.history", "keep_last"));
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+}
+
+TEST_F(SteeringControllersLibraryTest, joint_commands_are_limited)
+{
+  SetUpController();
+  auto node = controller_->get_node();
+  node->set_parameter(rclcpp::Parameter("traction.max_acceleration", -1.0));
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_ERROR);
+
+  node->set_parameter(rclcpp::Parameter("traction.max_acceleration", 1.0));
+  node->set_parameter(rclcpp::Parameter("steering.max_position", 0.1));
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  controller_->set_chained_mode(false);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto msg = std::make_unique<ControllerReferenceMsg>();
+  msg->header.stamp = node->now();
+  msg->twist.linear.x = 1.5;
+  msg->twist.angular.z = 0.3;
+  controller_->reference_callback(std::move(msg));
+
+  // the wheels accelerate from standing still by at most 1 rad/s^2, the steering stops at 0.1 rad
+  for (int i = 1; i <= 3; ++i)
+  {
+    ASSERT_EQ(
+      controller_->update(node->now(), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    EXPECT_NEAR(controller_->command_interfaces_[0].get_value(), 0.01 * i, 1e-12);
+    EXPECT_NEAR(controller_->command_interfaces_[1].get_value(), 0.01 * i, 1e-12);
+    EXPECT_DOUBLE_EQ(controller_->command_interfaces_[2].get_value(), 0.1);
+    EXPECT_DOUBLE_EQ(controller_->command_interfaces_[3].get_value(), 0.1);
+  }
+}
+
+TEST_F(SteeringControllersLibraryTest, exports_odometry_state_interfaces)
+{
+  SetUpController();
+
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), NODE_SUCCESS);
+  auto state_interfaces = controller_->export_state_interfaces();
+  const std::vector<std::string> names = {
+    "odometry/x", "odometry/y", "odometry/heading", "odometry/linear_velocity",
+    "odometry/angular_velocity"};
+  ASSERT_EQ(state_interfaces.size(), names.size());
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    EXPECT_EQ(
+      state_interfaces[i].get_name(),
+      std::string(controller_->get_node()->get_name()) + "/" + names[i]);
+  }
+  controller_->set_chained_mode(false);
+  ASSERT_EQ(controller_->on_activate(rclcpp_lifecycle::State()), NODE_SUCCESS);
+
+  auto msg = std::make_unique<ControllerReferenceMsg>();
+  msg->header.stamp = controller_->get_node()->now();
+  msg->twist.linear.x = 1.5;
+  msg->twist.angular.z = 0.3;
+  const rclcpp::Time stamp(msg->header.stamp);
+  controller_->reference_callback(std::move(msg));
+
+  // the following controllers read the odometry of the same cycle
+  for (int i = 0; i < 5; ++i)
+  {
+    ASSERT_EQ(
+      controller_->update(
+        stamp + rclcpp::Duration::from_seconds(0.01 * i), rclcpp::Duration::from_seconds(0.01)),
+      controller_interface::return_type::OK);
+    EXPECT_EQ(state_interfaces[0].get_value(), controller_->odometry_.get_x());
+    EXPECT_EQ(state_interfaces[1].get_value(), controller_->odometry_.get_y());
+    EXPECT_EQ(state_interfaces[2].get_value(), controller_->odometry_.get_heading());
+    EXPECT_EQ(state_interfaces[3].get_value(), controller_->odometry_.get_linear());
+    EXPECT_EQ(state_interfaces[4].get_value(), controller_->odometry_.get_angular());
+  }
+}
+
+TEST(SteeringOdometryTest, get_commands_in_place_matches_allocating_version)
+{
+  steering_odometry::SteeringOdometry odometry;
+  odometry.set_wheel_params(0.5, 2.0, 1.0);
+  for (const auto config :
+       {steering_odometry::BICYCLE_CONFIG, steering_odometry::TRICYCLE_CONFIG,
+        steering_odometry::ACKERMANN_CONFIG, steering_odometry::FOUR_STEERING_CONFIG})
+  {
+    odometry.set_odometry_type(config);
+    odometry.update_from_velocity(1.0, 0.1, 0.01);
+
+    steering_odometry::JointCommands commands;
+    ASSERT_TRUE(odometry.get_commands(1.5, 0.3, commands));
+    const auto [traction_commands, steering_commands] = odometry.get_commands(1.5, 0.3);
+    ASSERT_EQ(commands.traction_count, traction_commands.size());
+    ASSERT_EQ(commands.steering_count, steering_commands.size());
+    for (size_t i = 0; i < commands.traction_count; ++i)
+    {
+      EXPECT_DOUBLE_EQ(commands.traction[i], traction_commands[i]);
+    }
+    for (size_t i = 0; i < commands.steering_count; ++i)
+    {
+      EXPECT_DOUBLE_EQ(commands.steering[i], steering_commands[i]);
+    }
+  }
+
+  steering_odometry::JointCommands commands;
+  odometry.set_odometry_type(42);
+  EXPECT_FALSE(odometry.get_commands(1.5, 0.3, commands));
+}
+
+TEST(SteeringOdometryTest, get_commands_from_steering_angle_matches_twist_commands)
+{
+  steering_odometry::SteeringOdometry odometry;
+  odometry.set_wheel_params(0.5, 2.0, 1.0);
+  for (const auto config :
+       {steering_odometry::BICYCLE_CONFIG, steering_odometry::TRICYCLE_CONFIG,
+        steering_odometry::ACKERMANN_CONFIG})
+  {
+    odometry.set_odometry_type(config);
+    odometry.update_from_velocity(1.0, 0.1, 0.01);
+
+    const double speed = 1.5;
+    const double steering_angle = 0.3;
+    const double angular = odometry.convert_steering_angle_to_rot_vel(speed, steering_angle);
+    EXPECT_NEAR(std::atan(angular * 2.0 / speed), steering_angle, 1e-12);
+
+    steering_odometry::JointCommands commands;
+    steering_odometry::JointCommands twist_commands;
+    ASSERT_TRUE(odometry.get_commands_from_steering_angle(speed, steering_angle, commands));
+    ASSERT_TRUE(odometry.get_commands(speed, angular, twist_commands));
+    ASSERT_EQ(commands.traction_count, twist_commands.traction_count);
+    ASSERT_EQ(commands.steering_count, twist_commands.steering_count);
+    for (size_t i = 0; i < commands.traction_count; ++i)
+    {
+      EXPECT_NEAR(commands.traction[i], twist_commands.traction[i], 1e-12);
+    }
+    for (size_t i = 0; i < commands.steering_count; ++i)
+    {
+      EXPECT_NEAR(commands.steering[i], twist_commands.steering[i], 1e-12);
+    }
+  }
+}
+
+TEST(SteeringOdometryTest, equivalent_steering_angle_turns_around_the_same_point)
+{
+  EXPECT_EQ(steering_odometry::equivalent_steering_angle(0.0005, -0.0005), 0.0);
+  EXPECT_NEAR(steering_odometry::equivalent_steering_angle(0.3, 0.3), 0.3, 1e-12);
+
+  // the bicycle wheel is in the middle of the right and left wheels, on the same axle
+  const double wheelbase = 2.0;
+  const double wheel_track = 1.0;
+  const double turning_radius = 5.0;
+  const double right = std::atan(wheelbase / (turning_radius - wheel_track / 2));
+  const double left = std::atan(wheelbase / (turning_radius + wheel_track / 2));
+  EXPECT_NEAR(
+    steering_odometry::equivalent_steering_angle(right, left),
+    std::atan(wheelbase / turning_radius), 1e-12);
+}
+
+TEST(SteeringOdometryTest, four_steering_odometry_from_positions_matches_velocities)
+{
+  steering_odometry::SteeringOdometry position_odometry(1);
+  steering_odometry::SteeringOdometry velocity_odometry(1);
+  for (auto * odometry : {&position_odometry, &velocity_odometry})
+  {
+    odometry->set_wheel_params(0.5, 2.0, 1.0, 0.0);
+    odometry->set_kinematic_model<steering_odometry::FourWheelSteerModel>();
+  }
+
+  // straight ahead at 1 m/s for 1 s
+  const double dt = 0.01;
+  std::array<double, 4> positions{};
+  for (size_t i = 0; i < 100; ++i)
+  {
+    for (auto & position : positions)
+    {
+      position += 2.0 * dt;
+    }
+    ASSERT_TRUE(position_odometry.update_from_position(
+      positions[0], positions[1], positions[2], positions[3], 0.0, 0.0, dt));
+    ASSERT_TRUE(velocity_odometry.update_from_velocity(2.0, 2.0, 2.0, 2.0, 0.0, 0.0, dt));
+  }
+  for (const auto * odometry : {&position_odometry, &velocity_odometry})
+  {
+    EXPECT_NEAR(odometry->get_linear(), 1.0, 1e-9);
+    EXPECT_NEAR(odometry->get_angular(), 0.0, 1e-9);
+    EXPECT_NEAR(odometry->get_x(), 1.0, 1e-9);
+    EXPECT_NEAR(odometry->get_y(), 0.0, 1e-9);
+  }
+
+  // turning, with the front and rear wheels steered in opposite directions
+  const std::array<double, 4> velocities = {2.2, 1.8, 2.2, 1.8};
+  for (size_t i = 0; i < 100; ++i)
+  {
+    for (size_t k = 0; k < positions.size(); ++k)
+    {
+      positions[k] += velocities[k] * dt;
+    }
+    ASSERT_TRUE(position_odometry.update_from_position(
+      positions[0], positions[1], positions[2], positions[3], 0.1, -0.1, dt));
+    ASSERT_TRUE(velocity_odometry.update_from_velocity(
+      velocities[0], velocities[1], velocities[2], velocities[3], 0.1, -0.1, dt));
+  }
+  EXPECT_GT(velocity_odometry.get_angular(), 0.0);
+  EXPECT_NEAR(position_odometry.get_linear(), velocity_odometry.get_linear(), 1e-9);
+  EXPECT_NEAR(position_odometry.get_angular(), velocity_odometry.get_angular(), 1e-9);
+  EXPECT_NEAR(position_odometry.get_x(), velocity_odometry.get_x(), 1e-9);
+  EXPECT_NEAR(position_odometry.get_y(), velocity_odometry.get_y(), 1e-9);
+  EXPECT_NEAR(position_odometry.get_heading(), velocity_odometry.get_heading(), 1e-9);
+}
+
+TEST(MultiWheelKinematicsTest, twist_of_consistent_wheels_is_recovered)
+{
+  // six wheels on three axles, the front and rear ones steered
+  steering_odometry::MultiWheelKinematics kinematics;
+  ASSERT_TRUE(kinematics.set_wheels(
+    {2.0, 2.0, 0.0, 0.0, -2.0, -2.0}, {0.8, -0.8, 0.8, -0.8, 0.8, -0.8},
+    {true, true, false, false, true, true}));
+  ASSERT_EQ(kinematics.size(), 6u);
+
+  const double wheel_radius = 0.4;
+  std::vector<double> wheel_velocities(6);
+  std::vector<double> steering_angles(6, 0.0);
+  kinematics.get_commands({1.5, 0.0, 0.3}, wheel_radius, wheel_velocities, steering_angles);
+  EXPECT_GT(steering_angles[0], 0.0);
+  EXPECT_EQ(steering_angles[2], 0.0);
+  EXPECT_NEAR(steering_angles[4], -steering_angles[0], 1e-12);
+
+  std::array<double, 3> twist;
+  kinematics.get_twist(wheel_velocities, steering_angles, wheel_radius, twist);
+  EXPECT_NEAR(twist[0], 1.5, 1e-12);
+  EXPECT_NEAR(twist[1], 0.0, 1e-12);
+  EXPECT_NEAR(twist[2], 0.3, 1e-12);
+
+  // reversing keeps the steering angles within [-pi/2, pi/2]
+  kinematics.get_commands({-1.5, 0.0, 0.3}, wheel_radius, wheel_velocities, steering_angles);
+  for (const double angle : steering_angles)
+  {
+    EXPECT_LE(std::fabs(angle), M_PI_2);
+  }
+  kinematics.get_twist(wheel_velocities, steering_angles, wheel_radius, twist);
+  EXPECT_NEAR(twist[0], -1.5, 1e-12);
+  EXPECT_NEAR(twist[2], 0.3, 1e-12);
+}
+
+TEST(MultiWheelKinematicsTest, degenerate_layouts_are_rejected)
+{
+  steering_odometry::MultiWheelKinematics kinematics;
+  EXPECT_FALSE(kinematics.set_wheels({}, {}, {}));
+  EXPECT_FALSE(kinematics.set_wheels({1.0, 1.0}, {0.5}, {true, true}));
+  EXPECT_FALSE(kinematics.set_wheels({1.0, 1.0}, {0.5, 0.5}, {true, true}));
+  EXPECT_EQ(kinematics.size(), 0u);
+}
+
+TEST(SteeringOdometryTest, wheel_velocities_odometry_drives_a_circle)
+{
+  // eight wheels, all steered, turning around the center of the base
+  const std::vector<double> x = {1.5, 1.5, 0.5, 0.5, -0.5, -0.5, -1.5, -1.5};
+  const std::vector<double> y = {0.7, -0.7, 0.7, -0.7, 0.7, -0.7, 0.7, -0.7};
+  steering_odometry::SteeringOdometry odometry(1);
+  odometry.set_wheel_params(0.4);
+  ASSERT_TRUE(odometry.set_wheel_positions(x, y, std::vector<bool>(8, true)));
+
+  std::vector<double> wheel_velocities(8);
+  std::vector<double> steering_angles;
+  EXPECT_FALSE(odometry.get_wheel_commands(1.0, 0.0, 0.2, wheel_velocities, steering_angles));
+  steering_angles.assign(8, 0.0);
+  ASSERT_TRUE(odometry.get_wheel_commands(1.0, 0.0, 0.2, wheel_velocities, steering_angles));
+
+  const double dt = 0.01;
+  for (size_t i = 0; i < 500; ++i)
+  {
+    ASSERT_TRUE(odometry.update_from_wheel_velocities(wheel_velocities, steering_angles, dt));
+  }
+  // 5 s on a circle of radius 5 m
+  EXPECT_NEAR(odometry.get_linear(), 1.0, 1e-9);
+  EXPECT_NEAR(odometry.get_angular(), 0.2, 1e-9);
+  EXPECT_NEAR(odometry.get_heading(), 1.0, 1e-9);
+  EXPECT_NEAR(odometry.get_x(), 5.0 * std::sin(1.0), 1e-9);
+  EXPECT_NEAR(odometry.get_y(), 5.0 * (1.0 - std::cos(1.0)), 1e-9);
+
+  // crab steering, sideways without turning
+  odometry.reset_odometry();
+  ASSERT_TRUE(odometry.get_wheel_commands(0.0, 0.5, 0.0, wheel_velocities, steering_angles));
+  for (size_t i = 0; i < 100; ++i)
+  {
+    ASSERT_TRUE(odometry.update_from_wheel_velocities(wheel_velocities, steering_angles, dt));
+  }
+  EXPECT_NEAR(odometry.get_x(), 0.0, 1e-9);
+  EXPECT_NEAR(odometry.get_y(), 0.5, 1e-9);
+  EXPECT_NEAR(odometry.get_heading(), 0.0, 1e-9);
+}
+
+TEST(SteeringFleetKinematicsTest, commands_match_odometry_and_velocities_are_reached)
+{
+  steering_odometry::FleetKinematics<steering_odometry::AckermannModel> fleet;
+  fleet.configure(3, {0.5, 2.0, 1.0, 0.0, 0.0});
+  ASSERT_EQ(fleet.size(), 3u);
+
+  const std::vector<double> linear_commands = {1.5, 1.0, -0.5};
+  const std::vector<double> angular_commands = {0.5, 0.0, -0.2};
+  std::vector<steering_odometry::JointCommands> joint_commands(3);
+  constexpr double dt = 0.01;
+  fleet.step(
+    linear_commands.data(), angular_commands.data(), dt, joint_commands.data(), 0, fleet.size());
+
+  // the first step starts from straight steering, like a new odometry
+  for (size_t i = 0; i < fleet.size(); ++i)
+  {
+    steering_odometry::SteeringOdometry odometry;
+    odometry.set_wheel_params(0.5, 2.0, 1.0);
+    steering_odometry::JointCommands commands;
+    odometry.get_commands<steering_odometry::AckermannModel>(
+      linear_commands[i], angular_commands[i], commands);
+    ASSERT_EQ(joint_commands[i].traction_count, commands.traction_count);
+    ASSERT_EQ(joint_commands[i].steering_count, commands.steering_count);
+    for (size_t j = 0; j < commands.traction_count; ++j)
+    {
+      EXPECT_DOUBLE_EQ(joint_commands[i].traction[j], commands.traction[j]);
+    }
+    for (size_t j = 0; j < commands.steering_count; ++j)
+    {
+      EXPECT_DOUBLE_EQ(joint_commands[i].steering[j], commands.steering[j]);
+    }
+  }
+
+  // in two ranges, e.g. from two threads
+  for (size_t k = 0; k < 99; ++k)
+  {
+    fleet.step(
+      linear_commands.data(), angular_commands.data(), dt, joint_commands.data(), 0, 1);
+    fleet.step(
+      linear_commands.data(), angular_commands.data(), dt, joint_commands.data(), 1, 3);
+  }
+  for (size_t i = 0; i < fleet.size(); ++i)
+  {
+    EXPECT_NEAR(fleet.linear()[i], linear_commands[i], 1e-9);
+    EXPECT_NEAR(fleet.angular()[i], angular_commands[i], 1e-9);
+  }
+  // straight ahead for 1 s
+  EXPECT_NEAR(fleet.x()[1], 1.0, 1e-9);
+  EXPECT_NEAR(fleet.y()[1], 0.0, 1e-9);
+  // turning for 1 s, a little less in the first step from straight steering
+  EXPECT_NEAR(fleet.heading()[0], 0.5, 1e-2);
+  EXPECT_LT(fleet.heading()[0], 0.5);
+
+  fleet.reset();
+  EXPECT_EQ(fleet.x()[1], 0.0);
+  EXPECT_EQ(fleet.steer_pos()[0], 0.0);
+}
+
+TEST(SteeringOdometryTest, imu_yaw_rate_is_blended_into_the_heading)
+{
+  steering_odometry::SteeringOdometry odometry(1);
+  odometry.set_wheel_params(0.5, 2.0, 1.0);
+  odometry.set_odometry_type(steering_odometry::BICYCLE_CONFIG);
+  // the wheels turn at 0.1 rad/s, the IMU measures 0.3 rad/s
+  const double steer_pos = std::atan(0.1 * 2.0 / 1.0);
+  odometry.set_imu_weight(0.5);
+  odometry.set_imu_angular_velocity(0.3);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    ASSERT_TRUE(odometry.update_from_velocity(2.0, steer_pos, 0.01));
+  }
+  EXPECT_NEAR(odometry.get_linear(), 1.0, 1e-9);
+  EXPECT_NEAR(odometry.get_angular(), 0.2, 1e-9);
+  EXPECT_NEAR(odometry.get_heading(), 0.2, 1e-9);
+
+  // without a valid yaw rate the wheels are integrated alone
+  odometry.set_imu_angular_velocity(std::numeric_limits<double>::quiet_NaN());
+  ASSERT_TRUE(odometry.update_from_velocity(2.0, steer_pos, 0.01));
+  EXPECT_NEAR(odometry.get_angular(), 0.1, 1e-9);
+  EXPECT_NEAR(odometry.get_heading(), 0.201, 1e-9);
+}
+
 int main(int argc, char ** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -75,6 +75,10 @@ class TestableSteeringControllersLibrary
 {
   FRIEND_TEST(SteeringControllersLibraryTest, check_exported_intefaces);
   FRIEND_TEST(SteeringControllersLibraryTest, test_both_update_methods_for_ref_timeout);
+  FRIEND_TEST(SteeringControllersLibraryTest, command_latency);
+  FRIEND_TEST(SteeringControllersLibraryTest, exports_odometry_state_interfaces);
+  FRIEND_TEST(SteeringControllersLibraryTest, joint_commands_are_limited);
+  FRIEND_TEST(SteeringControllersLibraryTest, jitter_buffer_plays_out_references_delayed);
 
 public:
   controller_interface::CallbackReturn on_configure(
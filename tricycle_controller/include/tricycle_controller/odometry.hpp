@@ -20,41 +20,51 @@
 #define TRICYCLE_CONTROLLER__ODOMETRY_HPP_
 
 #include <cmath>
+#include <cstddef>
 
+#include "controller_realtime_tools/pose_integration.hpp"
+#include "controller_realtime_tools/smoothing_filter.hpp"
 #include "rclcpp/time.hpp"
-#include "rcpputils/rolling_mean_accumulator.hpp"
 
 namespace tricycle_controller
 {
 class Odometry
 {
 public:
+  // Largest velocity rolling window, the filters are preallocated for it:
+  static constexpr size_t MAX_VELOCITY_ROLLING_WINDOW_SIZE = 256;
+
   explicit Odometry(size_t velocity_rolling_window_size = 10);
 
   bool update(double left_vel, double right_vel, const rclcpp::Duration & dt);
+  bool updateFromSamples(
+    const double * Ws, const double * alpha, const double * times, size_t count,
+    const rclcpp::Time & time, const rclcpp::Duration & dt);
   void updateOpenLoop(double linear, double angular, const rclcpp::Duration & dt);
   void resetOdometry();
 
-  double getX() const { return x_; }
-  double getY() const { return y_; }
-  double getHeading() const { return heading_; }
+  double getX() const { return pose_.x(); }
+  double getY() const { return pose_.y(); }
+  double getHeading() const { return pose_.heading(); }
   double getLinear() const { return linear_; }
   double getAngular() const { return angular_; }
 
   void setWheelParams(double wheel_separation, double wheel_radius);
   void setVelocityRollingWindowSize(size_t velocity_rolling_window_size);
+  void setVelocitySmoothingMode(controller_realtime_tools::SmoothingMode mode);
 
 private:
-  using RollingMeanAccumulator = rcpputils::RollingMeanAccumulator<double>;
+  using VelocityFilter =
+    controller_realtime_tools::SmoothingFilter<MAX_VELOCITY_ROLLING_WINDOW_SIZE>;
 
-  void integrateRungeKutta2(double linear, double angular);
   void integrateExact(double linear, double angular);
   void resetAccumulators();
 
-  // Current pose:
-  double x_;        //   [m]
-  double y_;        //   [m]
-  double heading_;  // [rad]
+  // Time of the last integrated feedback sample [s], NaN until the first one:
+  double last_sample_time_;
+
+  // Current pose, x and y [m] and heading [rad]:
+  controller_realtime_tools::PoseIntegrator pose_;
 
   // Current velocity:
   double linear_;   //   [m/s]
@@ -64,10 +74,11 @@ private:
   double wheelbase_;
   double wheel_radius_;
 
-  // Rolling mean accumulators for the linear and angular velocities:
+  // Smoothing filters for the linear and angular velocities:
   size_t velocity_rolling_window_size_;
-  RollingMeanAccumulator linear_accumulator_;
-  RollingMeanAccumulator angular_accumulator_;
+  controller_realtime_tools::SmoothingMode velocity_smoothing_mode_;
+  VelocityFilter linear_accumulator_;
+  VelocityFilter angular_accumulator_;
 };
 
 }  // namespace tricycle_controller
@@ -21,6 +21,8 @@
 
 #include <cmath>
 
+#include "controller_realtime_tools/limiter.hpp"
+
 namespace tricycle_controller
 {
 class SteeringLimiter
@@ -76,17 +78,8 @@ public:
   double limit_acceleration(double & p, double p0, double p1, double dt);
 
 private:
-  // Position limits:
-  double min_position_;
-  double max_position_;
-
-  // Velocity limits:
-  double min_velocity_;
-  double max_velocity_;
-
-  // Acceleration limits:
-  double min_acceleration_;
-  double max_acceleration_;
+  // limits of the position and of the magnitudes of its velocity and acceleration
+  controller_realtime_tools::Limiter<1> limiter_;
 };
 
 }  // namespace tricycle_controller
@@ -21,6 +21,8 @@
 
 #include <cmath>
 
+#include "controller_realtime_tools/limiter.hpp"
+
 namespace tricycle_controller
 {
 class TractionLimiter
@@ -80,21 +82,8 @@ public:
   double limit_jerk(double & v, double v0, double v1, double dt);
 
 private:
-  // Velocity limits:
-  double min_velocity_;
-  double max_velocity_;
-
-  // Acceleration limits:
-  double min_acceleration_;
-  double max_acceleration_;
-
-  // Deceleration limits:
-  double min_deceleration_;
-  double max_deceleration_;
-
-  // Jerk limits:
-  double min_jerk_;
-  double max_jerk_;
+  // limits of the velocity, its acceleration and deceleration and its jerk, as magnitudes
+  controller_realtime_tools::Limiter<1> limiter_;
 };
 
 }  // namespace tricycle_controller
@@ -0,0 +1,70 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRICYCLE_CONTROLLER__TRACTION_SCALING_HPP_
+#define TRICYCLE_CONTROLLER__TRACTION_SCALING_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace tricycle_controller
+{
+/**
+ * \brief Scaling of the traction speed by the error of the steering angle
+ *
+ * The traction wheel slows down until the steering joint reaches its target angle. The profile
+ * is a piecewise linear function of the absolute steering error, given by its points. It is
+ * sampled once into a table with a constant step, so scale() is a constant-time lookup which
+ * neither branches on the profile nor allocates.
+ */
+class TractionScaling
+{
+public:
+  /// Number of samples of the table
+  static constexpr size_t TABLE_SIZE = 256;
+
+  /**
+   * \brief Default profile: 1 up to an error of pi/6, then the cosine of the error, at least 0.01
+   */
+  TractionScaling();
+
+  /**
+   * \brief Constructor
+   * \param [in] steering_errors Absolute steering errors of the points, strictly increasing and
+   * starting at 0 or above [rad]
+   * \param [in] factors Scaling factor at each point, in [0, 1]
+   * \throw std::invalid_argument if the points are invalid
+   *
+   * The factor of the first point applies below it, the one of the last point above it.
+   */
+  TractionScaling(const std::vector<double> & steering_errors, const std::vector<double> & factors);
+
+  /**
+   * \brief Scaling factor of the traction speed
+   * \param [in] steering_error Target minus measured steering angle [rad]
+   * \return factor in [0, 1], the one of the largest error if \p steering_error is NaN
+   */
+  double scale(double steering_error) const;
+
+private:
+  // samples of the profile from 0 to the steering error of its last point
+  std::array<double, TABLE_SIZE> table_{};
+  // 1 / step [1/rad]
+  double inverse_step_ = 0.0;
+};
+
+}  // namespace tricycle_controller
+
+#endif  // TRICYCLE_CONTROLLER__TRACTION_SCALING_HPP_
@@ -22,27 +22,28 @@
 #include <chrono>
 #include <cmath>
 #include <memory>
-#include <queue>
 #include <string>
 #include <tuple>
 #include <vector>
 
 #include "ackermann_msgs/msg/ackermann_drive.hpp"
 #include "controller_interface/controller_interface.hpp"
+#include "controller_realtime_tools/jitter_buffer.hpp"
+#include "controller_realtime_tools/realtime_swap_publisher.hpp"
+#include "controller_realtime_tools/realtime_triple_buffer.hpp"
+#include "controller_realtime_tools/ring_buffer.hpp"
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "hardware_interface/handle.hpp"
 #include "nav_msgs/msg/odometry.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_box.h"
-#include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
 #include "std_srvs/srv/empty.hpp"
 #include "tf2_msgs/msg/tf_message.hpp"
 #include "tricycle_controller/odometry.hpp"
 #include "tricycle_controller/steering_limiter.hpp"
 #include "tricycle_controller/traction_limiter.hpp"
+#include "tricycle_controller/traction_scaling.hpp"
 #include "tricycle_controller/visibility_control.h"
 
 namespace tricycle_controller
@@ -54,6 +55,9 @@ class TricycleController : public controller_interface::ControllerInterface
   using Twist = geometry_msgs::msg::Twist;
   using TwistStamped = geometry_msgs::msg::TwistStamped;
   using AckermannDrive = ackermann_msgs::msg::AckermannDrive;
+  template <typename MessageT>
+  using RealtimePublisher =
+    controller_realtime_tools::RealtimeSwapPublisher<MessageT, rclcpp::Publisher<MessageT>>;
 
 public:
   TRICYCLE_CONTROLLER_PUBLIC
@@ -95,17 +99,26 @@ protected:
   {
     std::reference_wrapper<const hardware_interface::LoanedStateInterface> velocity_state;
     std::reference_wrapper<hardware_interface::LoanedCommandInterface> velocity_command;
+    // timestamped feedback samples of the last cycle, only with feedback_samples_per_cycle > 0
+    const hardware_interface::LoanedStateInterface * sample_count = nullptr;
+    std::vector<const hardware_interface::LoanedStateInterface *> sample_velocities;
+    std::vector<const hardware_interface::LoanedStateInterface *> sample_times;
   };
   struct SteeringHandle
   {
     std::reference_wrapper<const hardware_interface::LoanedStateInterface> position_state;
     std::reference_wrapper<hardware_interface::LoanedCommandInterface> position_command;
+    // feedback samples at the times of the traction samples
+    std::vector<const hardware_interface::LoanedStateInterface *> sample_positions;
   };
 
   CallbackReturn get_traction(
     const std::string & traction_joint_name, std::vector<TractionHandle> & joint);
   CallbackReturn get_steering(
     const std::string & steering_joint_name, std::vector<SteeringHandle> & joint);
+  bool use_feedback_samples() const;
+  bool update_odometry_from_feedback_samples(
+    const rclcpp::Time & time, const rclcpp::Duration & period);
   double convert_trans_rot_vel_to_steering_angle(double v, double omega, double wheelbase);
   std::tuple<double, double> twist_to_ackermann(double linear_command, double angular_command);
 
@@ -135,19 +148,28 @@ protected:
 
   bool publish_ackermann_command_ = false;
   std::shared_ptr<rclcpp::Publisher<AckermannDrive>> ackermann_command_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<AckermannDrive>>
-    realtime_ackermann_command_publisher_ = nullptr;
+  std::shared_ptr<RealtimePublisher<AckermannDrive>> realtime_ackermann_command_publisher_ =
+    nullptr;
+  AckermannDrive ackermann_command_msg_;
 
   Odometry odometry_;
+  // maximum number of feedback samples per cycle, 0 to use the joint states
+  size_t feedback_samples_per_cycle_ = 0;
+  // feedback samples of the traction and steering joints and their times, preallocated
+  std::vector<double> traction_velocity_samples_;
+  std::vector<double> steering_position_samples_;
+  std::vector<double> feedback_sample_times_;
 
   std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odometry_publisher_ = nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
-    realtime_odometry_publisher_ = nullptr;
+  std::shared_ptr<RealtimePublisher<nav_msgs::msg::Odometry>> realtime_odometry_publisher_ =
+    nullptr;
+  nav_msgs::msg::Odometry odometry_msg_;
 
   std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> odometry_transform_publisher_ =
     nullptr;
-  std::shared_ptr<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>
+  std::shared_ptr<RealtimePublisher<tf2_msgs::msg::TFMessage>>
     realtime_odometry_transform_publisher_ = nullptr;
+  tf2_msgs::msg::TFMessage odometry_transform_msg_;
 
   // Timeout to consider cmd_vel commands old
   std::chrono::milliseconds cmd_vel_timeout_{500};
@@ -157,16 +179,27 @@ protected:
   rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr
     velocity_command_unstamped_subscriber_ = nullptr;
 
-  realtime_tools::RealtimeBox<std::shared_ptr<TwistStamped>> received_velocity_msg_ptr_{nullptr};
+  // last received command, written by the subscriber callback and read by update()
+  std::unique_ptr<controller_realtime_tools::RealtimeTripleBuffer<TwistStamped>>
+    received_velocity_msg_;
+  // received commands played out in the order of their stamps, up to 32 waiting for their turn,
+  // nullptr unless jitter_buffer.enable is set
+  using CommandJitterBuffer =
+    controller_realtime_tools::JitterBuffer<geometry_msgs::msg::Twist, 32>;
+  std::unique_ptr<CommandJitterBuffer> command_jitter_buffer_;
 
   rclcpp::Service<std_srvs::srv::Empty>::SharedPtr reset_odom_service_;
 
-  std::queue<AckermannDrive> previous_commands_;  // last two commands
+  // last two commands
+  controller_realtime_tools::RingBuffer<AckermannDrive, 2> previous_commands_;
 
   // speed limiters
   TractionLimiter limiter_traction_;
   SteeringLimiter limiter_steering_;
 
+  // scaling of the traction speed by the steering error
+  TractionScaling traction_scaling_;
+
   bool is_halted = false;
   bool use_stamped_vel_ = true;
 
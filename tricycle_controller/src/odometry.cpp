@@ -16,19 +16,20 @@
  * Author: Tony Najjar
  */
 
+#include <limits>
+
 #include "tricycle_controller/odometry.hpp"
 
 namespace tricycle_controller
 {
 Odometry::Odometry(size_t velocity_rolling_window_size)
-: x_(0.0),
-  y_(0.0),
-  heading_(0.0),
+: last_sample_time_(std::numeric_limits<double>::quiet_NaN()),
   linear_(0.0),
   angular_(0.0),
   wheelbase_(0.0),
   wheel_radius_(0.0),
   velocity_rolling_window_size_(velocity_rolling_window_size),
+  velocity_smoothing_mode_(controller_realtime_tools::SmoothingMode::MEAN),
   linear_accumulator_(velocity_rolling_window_size),
   angular_accumulator_(velocity_rolling_window_size)
 {
@@ -44,12 +45,54 @@ bool Odometry::update(double Ws, double alpha, const rclcpp::Duration & dt)
   // Integrate odometry:
   integrateExact(Vx * dt.seconds(), theta_dot * dt.seconds());
 
-  // Estimate speeds using a rolling mean to filter them out:
-  linear_accumulator_.accumulate(Vx);
-  angular_accumulator_.accumulate(theta_dot);
+  // Estimate speeds smoothed over the rolling window:
+  linear_ = linear_accumulator_.filter(Vx);
+  angular_ = angular_accumulator_.filter(theta_dot);
+
+  return true;
+}
+
+bool Odometry::updateFromSamples(
+  const double * Ws, const double * alpha, const double * times, size_t count,
+  const rclcpp::Time & time, const rclcpp::Duration & dt)
+{
+  // The first samples after a reset start one period before this update:
+  const double start_time =
+    std::isnan(last_sample_time_) ? (time - dt).seconds() : last_sample_time_;
+  double last_time = start_time;
+  double linear_sum = 0.0;
+  double angular_sum = 0.0;
+  size_t new_samples = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (times[i] <= last_time)
+    {
+      continue;  // Already integrated in an earlier update
+    }
+
+    // Each sample holds since the previous one, so the arc is integrated exactly:
+    const double sample_dt = times[i] - last_time;
+    const double Vs = Ws[i] * wheel_radius_;
+    const double linear = Vs * std::cos(alpha[i]) * sample_dt;
+    const double angular = Vs * std::sin(alpha[i]) / wheelbase_ * sample_dt;
+    integrateExact(linear, angular);
+
+    linear_sum += linear;
+    angular_sum += angular;
+    last_time = times[i];
+    ++new_samples;
+  }
+
+  if (new_samples == 0)
+  {
+    return false;
+  }
+  last_sample_time_ = last_time;
 
-  linear_ = linear_accumulator_.getRollingMean();
-  angular_ = angular_accumulator_.getRollingMean();
+  // Estimate the mean speeds over the whole batch, smoothed over the rolling window:
+  const double batch_dt = last_time - start_time;
+  linear_ = linear_accumulator_.filter(linear_sum / batch_dt);
+  angular_ = angular_accumulator_.filter(angular_sum / batch_dt);
 
   return true;
 }
@@ -66,9 +109,8 @@ void Odometry::updateOpenLoop(double linear, double angular, const rclcpp::Durat
 
 void Odometry::resetOdometry()
 {
-  x_ = 0.0;
-  y_ = 0.0;
-  heading_ = 0.0;
+  pose_.reset(0.0, 0.0, 0.0);
+  last_sample_time_ = std::numeric_limits<double>::quiet_NaN();
   resetAccumulators();
 }
 
@@ -85,37 +127,22 @@ void Odometry::setVelocityRollingWindowSize(size_t velocity_rolling_window_size)
   resetAccumulators();
 }
 
-void Odometry::integrateRungeKutta2(double linear, double angular)
+void Odometry::setVelocitySmoothingMode(controller_realtime_tools::SmoothingMode mode)
 {
-  const double direction = heading_ + angular * 0.5;
+  velocity_smoothing_mode_ = mode;
 
-  /// Runge-Kutta 2nd order integration:
-  x_ += linear * cos(direction);
-  y_ += linear * sin(direction);
-  heading_ += angular;
+  resetAccumulators();
 }
 
 void Odometry::integrateExact(double linear, double angular)
 {
-  if (fabs(angular) < 1e-6)
-  {
-    integrateRungeKutta2(linear, angular);
-  }
-  else
-  {
-    /// Exact integration (should solve problems when angular is zero):
-    const double heading_old = heading_;
-    const double r = linear / angular;
-    heading_ += angular;
-    x_ += r * (sin(heading_) - sin(heading_old));
-    y_ += -r * (cos(heading_) - cos(heading_old));
-  }
+  pose_.integrate(linear, angular);
 }
 
 void Odometry::resetAccumulators()
 {
-  linear_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
-  angular_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
+  linear_accumulator_.configure(velocity_rolling_window_size_, velocity_smoothing_mode_);
+  angular_accumulator_.configure(velocity_rolling_window_size_, velocity_smoothing_mode_);
 }
 
 }  // namespace tricycle_controller
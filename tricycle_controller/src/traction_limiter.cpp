@@ -16,7 +16,7 @@
  * Author: Tony Najjar
  */
 
-#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <string>
 
@@ -27,61 +27,62 @@ namespace tricycle_controller
 TractionLimiter::TractionLimiter(
   double min_velocity, double max_velocity, double min_acceleration, double max_acceleration,
   double min_deceleration, double max_deceleration, double min_jerk, double max_jerk)
-: min_velocity_(min_velocity),
-  max_velocity_(max_velocity),
-  min_acceleration_(min_acceleration),
-  max_acceleration_(max_acceleration),
-  min_deceleration_(min_deceleration),
-  max_deceleration_(max_deceleration),
-  min_jerk_(min_jerk),
-  max_jerk_(max_jerk)
 {
-  if (!std::isnan(min_velocity_) && std::isnan(max_velocity_))
-    max_velocity_ = 1000.0;  // Arbitrarily big number
-  if (!std::isnan(max_velocity_) && std::isnan(min_velocity_)) min_velocity_ = 0.0;
+  if (!std::isnan(min_velocity) && std::isnan(max_velocity))
+    max_velocity = 1000.0;  // Arbitrarily big number
+  if (!std::isnan(max_velocity) && std::isnan(min_velocity)) min_velocity = 0.0;
 
-  if (!std::isnan(min_acceleration_) && std::isnan(max_acceleration_)) max_acceleration_ = 1000.0;
-  if (!std::isnan(max_acceleration_) && std::isnan(min_acceleration_)) min_acceleration_ = 0.0;
+  if (!std::isnan(min_acceleration) && std::isnan(max_acceleration)) max_acceleration = 1000.0;
+  if (!std::isnan(max_acceleration) && std::isnan(min_acceleration)) min_acceleration = 0.0;
 
-  if (!std::isnan(min_deceleration_) && std::isnan(max_deceleration_)) max_deceleration_ = 1000.0;
-  if (!std::isnan(max_deceleration_) && std::isnan(min_acceleration_)) min_deceleration_ = 0.0;
+  if (!std::isnan(min_deceleration) && std::isnan(max_deceleration)) max_deceleration = 1000.0;
+  if (!std::isnan(max_deceleration) && std::isnan(min_deceleration)) min_deceleration = 0.0;
 
-  if (!std::isnan(min_jerk_) && std::isnan(max_jerk_)) max_jerk_ = 1000.0;
-  if (!std::isnan(max_jerk_) && std::isnan(min_jerk_)) min_jerk_ = 0.0;
+  if (!std::isnan(min_jerk) && std::isnan(max_jerk)) max_jerk = 1000.0;
+  if (!std::isnan(max_jerk) && std::isnan(min_jerk)) min_jerk = 0.0;
 
   const std::string error =
     "The positive limit will be applied to both directions. Setting different limits for positive "
     "and negative directions is not supported. Actuators are "
     "assumed to have the same constraints in both directions";
-  if (min_velocity_ < 0 || max_velocity_ < 0)
+  if (min_velocity < 0 || max_velocity < 0)
   {
     throw std::invalid_argument("Velocity cannot be negative." + error);
   }
 
-  if (min_acceleration_ < 0 || max_acceleration_ < 0)
+  if (min_acceleration < 0 || max_acceleration < 0)
   {
     throw std::invalid_argument("Acceleration cannot be negative." + error);
   }
 
-  if (min_deceleration_ < 0 || max_deceleration_ < 0)
+  if (min_deceleration < 0 || max_deceleration < 0)
   {
     throw std::invalid_argument("Deceleration cannot be negative." + error);
   }
 
-  if (min_jerk_ < 0 || max_jerk_ < 0)
+  if (min_jerk < 0 || max_jerk < 0)
   {
     throw std::invalid_argument("Jerk cannot be negative." + error);
   }
+
+  // the limits apply to the magnitudes, i.e. in [-max, -min] and [min, max]
+  limiter_.set_value_limits(0, -max_velocity, max_velocity, min_velocity);
+  // the deceleration is only limited along with the acceleration
+  if (!std::isnan(max_acceleration))
+  {
+    limiter_.set_rate_limits(0, -max_acceleration, max_acceleration, min_acceleration);
+    limiter_.set_decreasing_rate_limits(0, -max_deceleration, max_deceleration, min_deceleration);
+  }
+  limiter_.set_second_rate_limits(0, -max_jerk, max_jerk, min_jerk);
 }
 
 double TractionLimiter::limit(double & v, double v0, double v1, double dt)
 {
   const double tmp = v;
 
-  if (!std::isnan(min_jerk_) && !std::isnan(max_jerk_)) limit_jerk(v, v0, v1, dt);
-  if (!std::isnan(min_acceleration_) && !std::isnan(max_acceleration_))
-    limit_acceleration(v, v0, dt);
-  if (!std::isnan(min_velocity_) && !std::isnan(max_velocity_)) limit_velocity(v);
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit(values, {v0}, {v1}, dt);
+  v = values[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
@@ -90,9 +91,10 @@ double TractionLimiter::limit_velocity(double & v)
 {
   const double tmp = v;
 
-  v = std::clamp(std::fabs(v), min_velocity_, max_velocity_);
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit_value(values);
+  v = values[0];
 
-  v *= tmp >= 0 ? 1 : -1;
   return tmp != 0.0 ? v / tmp : 1.0;
 }
 
@@ -100,21 +102,9 @@ double TractionLimiter::limit_acceleration(double & v, double v0, double dt)
 {
   const double tmp = v;
 
-  double dv_min;
-  double dv_max;
-  if (std::fabs(v) >= std::fabs(v0))
-  {
-    dv_min = min_acceleration_ * dt;
-    dv_max = max_acceleration_ * dt;
-  }
-  else
-  {
-    dv_min = min_deceleration_ * dt;
-    dv_max = max_deceleration_ * dt;
-  }
-  double dv = std::clamp(std::fabs(v - v0), dv_min, dv_max);
-  dv *= (v - v0 >= 0 ? 1 : -1);
-  v = v0 + dv;
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit_rate(values, {v0}, dt);
+  v = values[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
@@ -123,17 +113,9 @@ double TractionLimiter::limit_jerk(double & v, double v0, double v1, double dt)
 {
   const double tmp = v;
 
-  const double dv = v - v0;
-  const double dv0 = v0 - v1;
-
-  const double dt2 = 2. * dt * dt;
-
-  const double da_min = min_jerk_ * dt2;
-  const double da_max = max_jerk_ * dt2;
-
-  double da = std::clamp(std::fabs(dv - dv0), da_min, da_max);
-  da *= (dv - dv0 >= 0 ? 1 : -1);
-  v = v0 + dv0 + da;
+  controller_realtime_tools::Limiter<1>::Values values{v};
+  limiter_.limit_second_rate(values, {v0}, {v1}, dt);
+  v = values[0];
 
   return tmp != 0.0 ? v / tmp : 1.0;
 }
@@ -0,0 +1,92 @@
+// Copyright (c) 2024 ros2_control Development Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tricycle_controller/traction_scaling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace tricycle_controller
+{
+TractionScaling::TractionScaling()
+{
+  const double step = M_PI_2 / static_cast<double>(TABLE_SIZE - 1);
+  for (size_t i = 0; i < TABLE_SIZE; ++i)
+  {
+    const double steering_error = step * static_cast<double>(i);
+    table_[i] = steering_error < M_PI / 6 ? 1.0 : std::max(std::cos(steering_error), 0.01);
+  }
+  inverse_step_ = 1.0 / step;
+}
+
+TractionScaling::TractionScaling(
+  const std::vector<double> & steering_errors, const std::vector<double> & factors)
+{
+  if (steering_errors.size() != factors.size())
+  {
+    throw std::invalid_argument("The steering errors and factors must have the same size");
+  }
+  if (steering_errors.size() < 2)
+  {
+    throw std::invalid_argument("The traction scaling needs at least two points");
+  }
+  if (!(steering_errors.front() >= 0.0))
+  {
+    throw std::invalid_argument("The steering errors must be positive or zero");
+  }
+  for (size_t i = 0; i < steering_errors.size(); ++i)
+  {
+    if (i > 0 && !(steering_errors[i] > steering_errors[i - 1]))
+    {
+      throw std::invalid_argument("The steering errors must be strictly increasing");
+    }
+    if (!(factors[i] >= 0.0 && factors[i] <= 1.0))
+    {
+      throw std::invalid_argument("The traction scaling factors must be in [0, 1]");
+    }
+  }
+
+  const double step = steering_errors.back() / static_cast<double>(TABLE_SIZE - 1);
+  size_t segment = 0;
+  for (size_t i = 0; i < TABLE_SIZE; ++i)
+  {
+    const double steering_error = step * static_cast<double>(i);
+    while (segment + 2 < steering_errors.size() && steering_error > steering_errors[segment + 1])
+    {
+      ++segment;
+    }
+    const double begin = steering_errors[segment];
+    const double end = steering_errors[segment + 1];
+    const double fraction = std::clamp((steering_error - begin) / (end - begin), 0.0, 1.0);
+    table_[i] = factors[segment] + fraction * (factors[segment + 1] - factors[segment]);
+  }
+  inverse_step_ = 1.0 / step;
+}
+
+double TractionScaling::scale(double steering_error) const
+{
+  const double last = static_cast<double>(TABLE_SIZE - 1);
+  const double position = std::fabs(steering_error) * inverse_step_;
+  // also catches NaN
+  if (!(position < last))
+  {
+    return table_[TABLE_SIZE - 1];
+  }
+  const auto index = static_cast<size_t>(position);
+  const double fraction = position - static_cast<double>(index);
+  return table_[index] + fraction * (table_[index + 1] - table_[index]);
+}
+
+}  // namespace tricycle_controller
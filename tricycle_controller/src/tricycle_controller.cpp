@@ -16,12 +16,13 @@
  * Author: Tony Najjar
  */
 
+#include <algorithm>
 #include <memory>
-#include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "controller_realtime_tools/tracing.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/logging.hpp"
@@ -35,6 +36,30 @@ constexpr auto DEFAULT_ACKERMANN_OUT_TOPIC = "~/cmd_ackermann";
 constexpr auto DEFAULT_ODOMETRY_TOPIC = "~/odom";
 constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
 constexpr auto DEFAULT_RESET_ODOM_SERVICE = "~/reset_odometry";
+constexpr auto FEEDBACK_SAMPLE_COUNT_INTERFACE = "velocity_samples";
+
+std::string feedback_sample_interface(const char * interface_name, size_t index)
+{
+  return std::string(interface_name) + "_sample_" + std::to_string(index);
+}
+
+std::string feedback_sample_time_interface(size_t index)
+{
+  return feedback_sample_interface(hardware_interface::HW_IF_VELOCITY, index) + "_time";
+}
+
+std::vector<hardware_interface::LoanedStateInterface>::const_iterator find_state_interface(
+  const std::vector<hardware_interface::LoanedStateInterface> & state_interfaces,
+  const std::string & joint_name, const std::string & interface_name)
+{
+  return std::find_if(
+    state_interfaces.cbegin(), state_interfaces.cend(),
+    [&joint_name, &interface_name](const auto & interface)
+    {
+      return interface.get_prefix_name() == joint_name &&
+             interface.get_interface_name() == interface_name;
+    });
+}
 }  // namespace
 
 namespace tricycle_controller
@@ -48,6 +73,11 @@ using lifecycle_msgs::msg::State;
 
 TricycleController::TricycleController() : controller_interface::ControllerInterface() {}
 
+bool TricycleController::use_feedback_samples() const
+{
+  return !odom_params_.open_loop && feedback_samples_per_cycle_ > 0;
+}
+
 CallbackReturn TricycleController::on_init()
 {
   try
@@ -70,7 +100,14 @@ CallbackReturn TricycleController::on_init()
     auto_declare<int>("cmd_vel_timeout", static_cast<int>(cmd_vel_timeout_.count()));
     auto_declare<bool>("publish_ackermann_command", publish_ackermann_command_);
     auto_declare<int>("velocity_rolling_window_size", 10);
+    auto_declare<std::string>("velocity_smoothing", "mean");
+    auto_declare<int>("feedback_samples_per_cycle", 0);
     auto_declare<bool>("use_stamped_vel", use_stamped_vel_);
+    auto_declare<std::string>("cmd_vel_qos.history", "system_default");
+    auto_declare<int>("cmd_vel_qos.depth", 1);
+    auto_declare<bool>("cmd_vel_qos.intra_process", false);
+    auto_declare<bool>("jitter_buffer.enable", false);
+    auto_declare<double>("jitter_buffer.delay", 0.1);
 
     auto_declare<double>("traction.max_velocity", NAN);
     auto_declare<double>("traction.min_velocity", NAN);
@@ -81,6 +118,9 @@ CallbackReturn TricycleController::on_init()
     auto_declare<double>("traction.max_jerk", NAN);
     auto_declare<double>("traction.min_jerk", NAN);
 
+    auto_declare<std::vector<double>>("traction_scaling.steering_errors", std::vector<double>());
+    auto_declare<std::vector<double>>("traction_scaling.factors", std::vector<double>());
+
     auto_declare<double>("steering.max_position", NAN);
     auto_declare<double>("steering.min_position", NAN);
     auto_declare<double>("steering.max_velocity", NAN);
@@ -112,6 +152,20 @@ InterfaceConfiguration TricycleController::state_interface_configuration() const
   state_interfaces_config.type = interface_configuration_type::INDIVIDUAL;
   state_interfaces_config.names.push_back(traction_joint_name_ + "/" + HW_IF_VELOCITY);
   state_interfaces_config.names.push_back(steering_joint_name_ + "/" + HW_IF_POSITION);
+  if (use_feedback_samples())
+  {
+    state_interfaces_config.names.push_back(
+      traction_joint_name_ + "/" + FEEDBACK_SAMPLE_COUNT_INTERFACE);
+    for (size_t i = 0; i < feedback_samples_per_cycle_; ++i)
+    {
+      state_interfaces_config.names.push_back(
+        traction_joint_name_ + "/" + feedback_sample_interface(HW_IF_VELOCITY, i));
+      state_interfaces_config.names.push_back(
+        traction_joint_name_ + "/" + feedback_sample_time_interface(i));
+      state_interfaces_config.names.push_back(
+        steering_joint_name_ + "/" + feedback_sample_interface(HW_IF_POSITION, i));
+    }
+  }
   return state_interfaces_config;
 }
 
@@ -127,27 +181,39 @@ controller_interface::return_type TricycleController::update(
     }
     return controller_interface::return_type::OK;
   }
-  std::shared_ptr<TwistStamped> last_command_msg;
-  received_velocity_msg_ptr_.get(last_command_msg);
-  if (last_command_msg == nullptr)
+  if (!received_velocity_msg_)
   {
-    RCLCPP_WARN(get_node()->get_logger(), "Velocity message received was a nullptr.");
+    RCLCPP_WARN(
+      get_node()->get_logger(), "No velocity message buffer, the controller is not configured.");
     return controller_interface::return_type::ERROR;
   }
 
-  const auto age_of_last_command = time - last_command_msg->header.stamp;
-  // Brake if cmd_vel has timeout, override the stored command
-  if (age_of_last_command > cmd_vel_timeout_)
+  // only the stamp and the two commanded velocities are read from the received twist, which is
+  // left as it was, so the command may be limited further by Limiters
+  const TwistStamped & last_command_msg = received_velocity_msg_->read();
+  CONTROLLER_TRACEPOINT(REFERENCE_RECEIVED, this, 0);
+  double linear_command = 0.0;
+  double angular_command = 0.0;
+  if (command_jitter_buffer_)
+  {
+    // the commands are played out the delay after their stamps, which the timeout applies to
+    const int64_t now_ns = time.nanoseconds();
+    if (
+      command_jitter_buffer_->play_out(now_ns) &&
+      std::chrono::nanoseconds(
+        now_ns - command_jitter_buffer_->delay() - command_jitter_buffer_->stamp()) <=
+        cmd_vel_timeout_)
+    {
+      linear_command = command_jitter_buffer_->value().linear.x;
+      angular_command = command_jitter_buffer_->value().angular.z;
+    }
+  }
+  // Brake if cmd_vel has timeout
+  else if (time - last_command_msg.header.stamp <= cmd_vel_timeout_)
   {
-    last_command_msg->twist.linear.x = 0.0;
-    last_command_msg->twist.angular.z = 0.0;
+    linear_command = last_command_msg.twist.linear.x;
+    angular_command = last_command_msg.twist.angular.z;
   }
-
-  // command may be limited further by Limiters,
-  // without affecting the stored twist command
-  TwistStamped command = *last_command_msg;
-  double & linear_command = command.twist.linear.x;
-  double & angular_command = command.twist.angular.z;
   double Ws_read = traction_joint_[0].velocity_state.get().get_value();     // in radians/s
   double alpha_read = steering_joint_[0].position_state.get().get_value();  // in radians
 
@@ -155,6 +221,13 @@ controller_interface::return_type TricycleController::update(
   {
     odometry_.updateOpenLoop(linear_command, angular_command, period);
   }
+  else if (use_feedback_samples())
+  {
+    if (!update_odometry_from_feedback_samples(time, period))
+    {
+      return controller_interface::return_type::ERROR;
+    }
+  }
   else
   {
     if (std::isnan(Ws_read) || std::isnan(alpha_read))
@@ -164,31 +237,31 @@ controller_interface::return_type TricycleController::update(
     }
     odometry_.update(Ws_read, alpha_read, period);
   }
+  CONTROLLER_TRACEPOINT(ODOMETRY_INTEGRATED, this, time.nanoseconds());
 
   tf2::Quaternion orientation;
   orientation.setRPY(0.0, 0.0, odometry_.getHeading());
 
-  if (realtime_odometry_publisher_->trylock())
+  odometry_msg_.header.stamp = time;
+  if (!odom_params_.odom_only_twist)
   {
-    auto & odometry_message = realtime_odometry_publisher_->msg_;
-    odometry_message.header.stamp = time;
-    if (!odom_params_.odom_only_twist)
-    {
-      odometry_message.pose.pose.position.x = odometry_.getX();
-      odometry_message.pose.pose.position.y = odometry_.getY();
-      odometry_message.pose.pose.orientation.x = orientation.x();
-      odometry_message.pose.pose.orientation.y = orientation.y();
-      odometry_message.pose.pose.orientation.z = orientation.z();
-      odometry_message.pose.pose.orientation.w = orientation.w();
-    }
-    odometry_message.twist.twist.linear.x = odometry_.getLinear();
-    odometry_message.twist.twist.angular.z = odometry_.getAngular();
-    realtime_odometry_publisher_->unlockAndPublish();
+    odometry_msg_.pose.pose.position.x = odometry_.getX();
+    odometry_msg_.pose.pose.position.y = odometry_.getY();
+    odometry_msg_.pose.pose.orientation.x = orientation.x();
+    odometry_msg_.pose.pose.orientation.y = orientation.y();
+    odometry_msg_.pose.pose.orientation.z = orientation.z();
+    odometry_msg_.pose.pose.orientation.w = orientation.w();
+  }
+  odometry_msg_.twist.twist.linear.x = odometry_.getLinear();
+  odometry_msg_.twist.twist.angular.z = odometry_.getAngular();
+  if (realtime_odometry_publisher_->try_publish(odometry_msg_))
+  {
+    CONTROLLER_TRACEPOINT(ODOMETRY_PUBLISHED, this, time.nanoseconds());
   }
 
-  if (odom_params_.enable_odom_tf && realtime_odometry_transform_publisher_->trylock())
+  if (odom_params_.enable_odom_tf)
   {
-    auto & transform = realtime_odometry_transform_publisher_->msg_.transforms.front();
+    auto & transform = odometry_transform_msg_.transforms.front();
     transform.header.stamp = time;
     transform.transform.translation.x = odometry_.getX();
     transform.transform.translation.y = odometry_.getY();
@@ -196,32 +269,17 @@ controller_interface::return_type TricycleController::update(
     transform.transform.rotation.y = orientation.y();
     transform.transform.rotation.z = orientation.z();
     transform.transform.rotation.w = orientation.w();
-    realtime_odometry_transform_publisher_->unlockAndPublish();
+    realtime_odometry_transform_publisher_->try_publish(odometry_transform_msg_);
   }
 
   // Compute wheel velocity and angle
   auto [alpha_write, Ws_write] = twist_to_ackermann(linear_command, angular_command);
 
   // Reduce wheel speed until the target angle has been reached
-  double alpha_delta = abs(alpha_write - alpha_read);
-  double scale;
-  if (alpha_delta < M_PI / 6)
-  {
-    scale = 1;
-  }
-  else if (alpha_delta > M_PI_2)
-  {
-    scale = 0.01;
-  }
-  else
-  {
-    // TODO(anyone): find the best function, e.g convex power functions
-    scale = cos(alpha_delta);
-  }
-  Ws_write *= scale;
+  Ws_write *= traction_scaling_.scale(alpha_write - alpha_read);
 
-  auto & last_command = previous_commands_.back();
-  auto & second_to_last_command = previous_commands_.front();
+  const auto & last_command = previous_commands_.latest(0);
+  const auto & second_to_last_command = previous_commands_.latest(1);
 
   limiter_traction_.limit(
     Ws_write, last_command.speed, second_to_last_command.speed, period.seconds());
@@ -230,23 +288,18 @@ controller_interface::return_type TricycleController::update(
     alpha_write, last_command.steering_angle, second_to_last_command.steering_angle,
     period.seconds());
 
-  previous_commands_.pop();
   AckermannDrive ackermann_command;
   // speed in AckermannDrive is defined as desired forward speed (m/s) but it is used here as wheel
   // speed (rad/s)
   ackermann_command.speed = static_cast<float>(Ws_write);
   ackermann_command.steering_angle = static_cast<float>(alpha_write);
-  previous_commands_.emplace(ackermann_command);
+  previous_commands_.push(ackermann_command);
 
   //  Publish ackermann command
-  if (publish_ackermann_command_ && realtime_ackermann_command_publisher_->trylock())
+  if (publish_ackermann_command_)
   {
-    auto & realtime_ackermann_command = realtime_ackermann_command_publisher_->msg_;
-    // speed in AckermannDrive is defined desired forward speed (m/s) but we use it here as wheel
-    // speed (rad/s)
-    realtime_ackermann_command.speed = static_cast<float>(Ws_write);
-    realtime_ackermann_command.steering_angle = static_cast<float>(alpha_write);
-    realtime_ackermann_command_publisher_->unlockAndPublish();
+    ackermann_command_msg_ = ackermann_command;
+    realtime_ackermann_command_publisher_->try_publish(ackermann_command_msg_);
   }
 
   traction_joint_[0].velocity_command.get().set_value(Ws_write);
@@ -276,8 +329,28 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
   wheel_params_.radius = get_node()->get_parameter("wheel_radius").as_double();
 
   odometry_.setWheelParams(wheel_params_.wheelbase, wheel_params_.radius);
-  odometry_.setVelocityRollingWindowSize(
-    get_node()->get_parameter("velocity_rolling_window_size").as_int());
+  const auto velocity_rolling_window_size =
+    get_node()->get_parameter("velocity_rolling_window_size").as_int();
+  if (
+    velocity_rolling_window_size < 1 ||
+    velocity_rolling_window_size >
+      static_cast<int64_t>(Odometry::MAX_VELOCITY_ROLLING_WINDOW_SIZE))
+  {
+    RCLCPP_ERROR(
+      logger, "'velocity_rolling_window_size' has to be in [1, %zu]",
+      Odometry::MAX_VELOCITY_ROLLING_WINDOW_SIZE);
+    return CallbackReturn::ERROR;
+  }
+  odometry_.setVelocityRollingWindowSize(static_cast<size_t>(velocity_rolling_window_size));
+  controller_realtime_tools::SmoothingMode velocity_smoothing_mode;
+  if (!controller_realtime_tools::smoothing_mode_from_string(
+        get_node()->get_parameter("velocity_smoothing").as_string(), velocity_smoothing_mode))
+  {
+    RCLCPP_ERROR(
+      logger, "'velocity_smoothing' has to be one of 'mean', 'exponential' or 'median'");
+    return CallbackReturn::ERROR;
+  }
+  odometry_.setVelocitySmoothingMode(velocity_smoothing_mode);
 
   odom_params_.odom_frame_id = get_node()->get_parameter("odom_frame_id").as_string();
   odom_params_.base_frame_id = get_node()->get_parameter("base_frame_id").as_string();
@@ -294,11 +367,65 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
   odom_params_.enable_odom_tf = get_node()->get_parameter("enable_odom_tf").as_bool();
   odom_params_.odom_only_twist = get_node()->get_parameter("odom_only_twist").as_bool();
 
+  const auto feedback_samples_per_cycle =
+    get_node()->get_parameter("feedback_samples_per_cycle").as_int();
+  if (feedback_samples_per_cycle < 0)
+  {
+    RCLCPP_ERROR(logger, "'feedback_samples_per_cycle' has to be positive or zero");
+    return CallbackReturn::ERROR;
+  }
+  feedback_samples_per_cycle_ = static_cast<size_t>(feedback_samples_per_cycle);
+  traction_velocity_samples_.assign(feedback_samples_per_cycle_, 0.0);
+  steering_position_samples_.assign(feedback_samples_per_cycle_, 0.0);
+  feedback_sample_times_.assign(feedback_samples_per_cycle_, 0.0);
+
   cmd_vel_timeout_ =
     std::chrono::milliseconds{get_node()->get_parameter("cmd_vel_timeout").as_int()};
   publish_ackermann_command_ = get_node()->get_parameter("publish_ackermann_command").as_bool();
+  const double jitter_buffer_delay = get_node()->get_parameter("jitter_buffer.delay").as_double();
+  if (jitter_buffer_delay < 0.0)
+  {
+    RCLCPP_ERROR(logger, "'jitter_buffer.delay' has to be positive or zero");
+    return CallbackReturn::ERROR;
+  }
   use_stamped_vel_ = get_node()->get_parameter("use_stamped_vel").as_bool();
 
+  auto subscriber_qos = rclcpp::SystemDefaultsQoS();
+  const auto history = get_node()->get_parameter("cmd_vel_qos.history").as_string();
+  const auto depth = get_node()->get_parameter("cmd_vel_qos.depth").as_int();
+  if (depth < 1)
+  {
+    RCLCPP_ERROR(logger, "'cmd_vel_qos.depth' has to be positive");
+    return CallbackReturn::ERROR;
+  }
+  if (history == "keep_last")
+  {
+    subscriber_qos.keep_last(static_cast<size_t>(depth));
+  }
+  else if (history == "keep_all")
+  {
+    subscriber_qos.keep_all();
+  }
+  else if (history != "system_default")
+  {
+    RCLCPP_ERROR(
+      logger, "'cmd_vel_qos.history' has to be one of 'system_default', 'keep_last' or 'keep_all'");
+    return CallbackReturn::ERROR;
+  }
+  // the subscriber takes ownership of the messages to move them into the buffer, without a copy if
+  // they are passed within the process
+  rclcpp::SubscriptionOptions subscriber_options;
+  if (get_node()->get_parameter("cmd_vel_qos.intra_process").as_bool())
+  {
+    if (history != "keep_last")
+    {
+      RCLCPP_ERROR(
+        logger, "Intra-process communication of 'cmd_vel' requires the keep_last history");
+      return CallbackReturn::ERROR;
+    }
+    subscriber_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+  }
+
   try
   {
     limiter_traction_ = TractionLimiter(
@@ -317,6 +444,22 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
     return CallbackReturn::ERROR;
   }
 
+  const auto scaling_steering_errors =
+    get_node()->get_parameter("traction_scaling.steering_errors").as_double_array();
+  const auto scaling_factors =
+    get_node()->get_parameter("traction_scaling.factors").as_double_array();
+  try
+  {
+    traction_scaling_ = scaling_steering_errors.empty() && scaling_factors.empty()
+                          ? TractionScaling()
+                          : TractionScaling(scaling_steering_errors, scaling_factors);
+  }
+  catch (const std::invalid_argument & e)
+  {
+    RCLCPP_ERROR(get_node()->get_logger(), "Error configuring traction scaling: %s", e.what());
+    return CallbackReturn::ERROR;
+  }
+
   try
   {
     limiter_steering_ = SteeringLimiter(
@@ -339,29 +482,36 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
   }
 
   const TwistStamped empty_twist;
-  received_velocity_msg_ptr_.set(std::make_shared<TwistStamped>(empty_twist));
+  received_velocity_msg_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<TwistStamped>>(empty_twist);
+  if (get_node()->get_parameter("jitter_buffer.enable").as_bool())
+  {
+    command_jitter_buffer_ = std::make_unique<CommandJitterBuffer>();
+    command_jitter_buffer_->set_delay(static_cast<int64_t>(jitter_buffer_delay * 1e9));
+  }
+  else
+  {
+    command_jitter_buffer_.reset();
+  }
 
   // Fill last two commands with default constructed commands
-  const AckermannDrive empty_ackermann_drive;
-  previous_commands_.emplace(empty_ackermann_drive);
-  previous_commands_.emplace(empty_ackermann_drive);
+  previous_commands_.fill(AckermannDrive());
 
   // initialize ackermann command publisher
   if (publish_ackermann_command_)
   {
     ackermann_command_publisher_ = get_node()->create_publisher<AckermannDrive>(
       DEFAULT_ACKERMANN_OUT_TOPIC, rclcpp::SystemDefaultsQoS());
-    realtime_ackermann_command_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<AckermannDrive>>(
-        ackermann_command_publisher_);
+    realtime_ackermann_command_publisher_ = std::make_shared<RealtimePublisher<AckermannDrive>>(
+      ackermann_command_publisher_, ackermann_command_msg_);
   }
 
   // initialize command subscriber
   if (use_stamped_vel_)
   {
     velocity_command_subscriber_ = get_node()->create_subscription<TwistStamped>(
-      DEFAULT_COMMAND_TOPIC, rclcpp::SystemDefaultsQoS(),
-      [this](const std::shared_ptr<TwistStamped> msg) -> void
+      DEFAULT_COMMAND_TOPIC, subscriber_qos,
+      [this](std::unique_ptr<TwistStamped> msg) -> void
       {
         if (!subscriber_is_active_)
         {
@@ -377,14 +527,20 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
             "time, this message will only be shown once");
           msg->header.stamp = get_node()->get_clock()->now();
         }
-        received_velocity_msg_ptr_.set(std::move(msg));
-      });
+        if (command_jitter_buffer_)
+        {
+          command_jitter_buffer_->push(rclcpp::Time(msg->header.stamp).nanoseconds(), msg->twist);
+        }
+        received_velocity_msg_->write_buffer() = std::move(*msg);
+        received_velocity_msg_->publish();
+      },
+      subscriber_options);
   }
   else
   {
     velocity_command_unstamped_subscriber_ = get_node()->create_subscription<Twist>(
-      DEFAULT_COMMAND_TOPIC, rclcpp::SystemDefaultsQoS(),
-      [this](const std::shared_ptr<Twist> msg) -> void
+      DEFAULT_COMMAND_TOPIC, subscriber_qos,
+      [this](std::unique_ptr<Twist> msg) -> void
       {
         if (!subscriber_is_active_)
         {
@@ -393,22 +549,27 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
           return;
         }
 
-        // Write fake header in the stored stamped command
-        std::shared_ptr<TwistStamped> twist_stamped;
-        received_velocity_msg_ptr_.get(twist_stamped);
-        twist_stamped->twist = *msg;
-        twist_stamped->header.stamp = get_node()->get_clock()->now();
-      });
+        // Write fake header in the stamped command
+        auto & twist_stamped = received_velocity_msg_->write_buffer();
+        twist_stamped.twist = *msg;
+        twist_stamped.header.stamp = get_node()->get_clock()->now();
+        received_velocity_msg_->publish();
+        // without a stamp, the commands are played out the delay after their arrival
+        if (command_jitter_buffer_)
+        {
+          command_jitter_buffer_->push(
+            rclcpp::Time(twist_stamped.header.stamp).nanoseconds(), twist_stamped.twist);
+        }
+      },
+      subscriber_options);
   }
 
   // initialize odometry publisher and messasge
   odometry_publisher_ = get_node()->create_publisher<nav_msgs::msg::Odometry>(
     DEFAULT_ODOMETRY_TOPIC, rclcpp::SystemDefaultsQoS());
-  realtime_odometry_publisher_ =
-    std::make_shared<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(
-      odometry_publisher_);
 
-  auto & odometry_message = realtime_odometry_publisher_->msg_;
+  odometry_msg_ = nav_msgs::msg::Odometry();
+  auto & odometry_message = odometry_msg_;
   odometry_message.header.frame_id = odom_params_.odom_frame_id;
   odometry_message.child_frame_id = odom_params_.base_frame_id;
 
@@ -425,21 +586,23 @@ CallbackReturn TricycleController::on_configure(const rclcpp_lifecycle::State &
     odometry_message.twist.covariance[diagonal_index] =
       odom_params_.twist_covariance_diagonal[index];
   }
+  realtime_odometry_publisher_ = std::make_shared<RealtimePublisher<nav_msgs::msg::Odometry>>(
+    odometry_publisher_, odometry_message);
 
   // initialize transform publisher and message
   if (odom_params_.enable_odom_tf)
   {
     odometry_transform_publisher_ = get_node()->create_publisher<tf2_msgs::msg::TFMessage>(
       DEFAULT_TRANSFORM_TOPIC, rclcpp::SystemDefaultsQoS());
-    realtime_odometry_transform_publisher_ =
-      std::make_shared<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
-        odometry_transform_publisher_);
 
     // keeping track of odom and base_link transforms only
-    auto & odometry_transform_message = realtime_odometry_transform_publisher_->msg_;
-    odometry_transform_message.transforms.resize(1);
+    auto & odometry_transform_message = odometry_transform_msg_;
+    odometry_transform_message.transforms.assign(1, geometry_msgs::msg::TransformStamped());
     odometry_transform_message.transforms.front().header.frame_id = odom_params_.odom_frame_id;
     odometry_transform_message.transforms.front().child_frame_id = odom_params_.base_frame_id;
+    realtime_odometry_transform_publisher_ =
+      std::make_shared<RealtimePublisher<tf2_msgs::msg::TFMessage>>(
+        odometry_transform_publisher_, odometry_transform_message);
   }
 
   // Create odom reset service
@@ -469,6 +632,11 @@ CallbackReturn TricycleController::on_activate(const rclcpp_lifecycle::State &)
     return CallbackReturn::ERROR;
   }
 
+  if (command_jitter_buffer_)
+  {
+    command_jitter_buffer_->reset();
+  }
+
   is_halted = false;
   subscriber_is_active_ = true;
 
@@ -489,7 +657,9 @@ CallbackReturn TricycleController::on_cleanup(const rclcpp_lifecycle::State &)
     return CallbackReturn::ERROR;
   }
 
-  received_velocity_msg_ptr_.set(std::make_shared<TwistStamped>());
+  received_velocity_msg_ =
+    std::make_unique<controller_realtime_tools::RealtimeTripleBuffer<TwistStamped>>(
+      TwistStamped());
   return CallbackReturn::SUCCESS;
 }
 
@@ -515,9 +685,7 @@ bool TricycleController::reset()
 {
   odometry_.resetOdometry();
 
-  // release the old queue
-  std::queue<AckermannDrive> empty_ackermann_drive;
-  std::swap(previous_commands_, empty_ackermann_drive);
+  previous_commands_.clear();
 
   traction_joint_.clear();
   steering_joint_.clear();
@@ -526,7 +694,8 @@ bool TricycleController::reset()
   velocity_command_subscriber_.reset();
   velocity_command_unstamped_subscriber_.reset();
 
-  received_velocity_msg_ptr_.set(nullptr);
+  received_velocity_msg_.reset();
+  command_jitter_buffer_.reset();
   is_halted = false;
   return true;
 }
@@ -580,7 +749,37 @@ CallbackReturn TricycleController::get_traction(
   }
 
   // Create the traction joint instance
-  joint.emplace_back(TractionHandle{std::ref(*state_handle), std::ref(*command_handle)});
+  TractionHandle handle{std::ref(*state_handle), std::ref(*command_handle)};
+  if (use_feedback_samples())
+  {
+    const auto count_handle = find_state_interface(
+      state_interfaces_, traction_joint_name, FEEDBACK_SAMPLE_COUNT_INTERFACE);
+    if (count_handle == state_interfaces_.cend())
+    {
+      RCLCPP_ERROR(
+        get_node()->get_logger(), "Unable to obtain feedback sample count handle for %s",
+        traction_joint_name.c_str());
+      return CallbackReturn::ERROR;
+    }
+    handle.sample_count = &(*count_handle);
+    for (size_t i = 0; i < feedback_samples_per_cycle_; ++i)
+    {
+      const auto velocity_handle = find_state_interface(
+        state_interfaces_, traction_joint_name, feedback_sample_interface(HW_IF_VELOCITY, i));
+      const auto time_handle = find_state_interface(
+        state_interfaces_, traction_joint_name, feedback_sample_time_interface(i));
+      if (velocity_handle == state_interfaces_.cend() || time_handle == state_interfaces_.cend())
+      {
+        RCLCPP_ERROR(
+          get_node()->get_logger(), "Unable to obtain feedback sample handles %zu for %s", i,
+          traction_joint_name.c_str());
+        return CallbackReturn::ERROR;
+      }
+      handle.sample_velocities.push_back(&(*velocity_handle));
+      handle.sample_times.push_back(&(*time_handle));
+    }
+  }
+  joint.push_back(std::move(handle));
   return CallbackReturn::SUCCESS;
 }
 
@@ -622,10 +821,58 @@ CallbackReturn TricycleController::get_steering(
   }
 
   // Create the steering joint instance
-  joint.emplace_back(SteeringHandle{std::ref(*state_handle), std::ref(*command_handle)});
+  SteeringHandle handle{std::ref(*state_handle), std::ref(*command_handle)};
+  if (use_feedback_samples())
+  {
+    for (size_t i = 0; i < feedback_samples_per_cycle_; ++i)
+    {
+      const auto position_handle = find_state_interface(
+        state_interfaces_, steering_joint_name, feedback_sample_interface(HW_IF_POSITION, i));
+      if (position_handle == state_interfaces_.cend())
+      {
+        RCLCPP_ERROR(
+          get_node()->get_logger(), "Unable to obtain feedback sample handle %zu for %s", i,
+          steering_joint_name.c_str());
+        return CallbackReturn::ERROR;
+      }
+      handle.sample_positions.push_back(&(*position_handle));
+    }
+  }
+  joint.push_back(std::move(handle));
   return CallbackReturn::SUCCESS;
 }
 
+bool TricycleController::update_odometry_from_feedback_samples(
+  const rclcpp::Time & time, const rclcpp::Duration & period)
+{
+  const TractionHandle & traction = traction_joint_[0];
+  const SteeringHandle & steering = steering_joint_[0];
+  const double sample_count = traction.sample_count->get_value();
+  const size_t count =
+    sample_count >= 0.0
+      ? static_cast<size_t>(
+          std::min(sample_count, static_cast<double>(feedback_samples_per_cycle_)))
+      : 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    traction_velocity_samples_[i] = traction.sample_velocities[i]->get_value();
+    steering_position_samples_[i] = steering.sample_positions[i]->get_value();
+    feedback_sample_times_[i] = traction.sample_times[i]->get_value();
+    if (
+      std::isnan(traction_velocity_samples_[i]) || std::isnan(steering_position_samples_[i]) ||
+      std::isnan(feedback_sample_times_[i]))
+    {
+      RCLCPP_ERROR(get_node()->get_logger(), "Feedback sample %zu is invalid", i);
+      return false;
+    }
+  }
+
+  odometry_.updateFromSamples(
+    traction_velocity_samples_.data(), steering_position_samples_.data(),
+    feedback_sample_times_.data(), count, time, period);
+  return true;
+}
+
 double TricycleController::convert_trans_rot_vel_to_steering_angle(
   double Vx, double theta_dot, double wheelbase)
 {
@@ -19,7 +19,10 @@
 #include <gmock/gmock.h>
 
 #include <array>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <utility>
@@ -30,6 +33,7 @@
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/rclcpp.hpp"
+#include "tricycle_controller/traction_scaling.hpp"
 #include "tricycle_controller/tricycle_controller.hpp"
 
 using CallbackReturn = controller_interface::CallbackReturn;
@@ -44,11 +48,9 @@ class TestableTricycleController : public tricycle_controller::TricycleControlle
 {
 public:
   using TricycleController::TricycleController;
-  std::shared_ptr<geometry_msgs::msg::TwistStamped> getLastReceivedTwist()
+  geometry_msgs::msg::TwistStamped getLastReceivedTwist()
   {
-    std::shared_ptr<geometry_msgs::msg::TwistStamped> ret;
-    received_velocity_msg_ptr_.get(ret);
-    return ret;
+    return received_velocity_msg_->read();
   }
 
   /**
@@ -209,6 +211,28 @@ TEST_F(TestTricycleController, configure_succeeds_when_joints_are_specified)
   ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
 }
 
+TEST_F(TestTricycleController, configure_checks_cmd_vel_qos)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+
+  controller_->get_node()->set_parameter(rclcpp::Parameter("cmd_vel_qos.history", "keep_first"));
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::ERROR);
+
+  // intra-process communication needs a bounded queue
+  controller_->get_node()->set_parameter(rclcpp::Parameter("cmd_vel_qos.history", "keep_all"));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("cmd_vel_qos.intra_process", true));
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::ERROR);
+
+  controller_->get_node()->set_parameter(rclcpp::Parameter("cmd_vel_qos.history", "keep_last"));
+  ASSERT_EQ(controller_->on_configure(rclcpp_lifecycle::State()), CallbackReturn::SUCCESS);
+}
+
 TEST_F(TestTricycleController, activate_fails_without_resources_assigned)
 {
   const auto ret = controller_->init(controller_name);
@@ -348,3 +372,159 @@ TEST_F(TestTricycleController, correct_initialization_using_parameters)
   ASSERT_EQ(State::PRIMARY_STATE_INACTIVE, state.id());
   executor.cancel();
 }
+
+TEST_F(TestTricycleController, timeout_brakes_without_overriding_received_command)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheelbase", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  assignResources();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  publish(1.0, 0.0);
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  const auto received_command = controller_->getLastReceivedTwist();
+  EXPECT_EQ(1.0, received_command.twist.linear.x);
+
+  // the command is older than the timeout at this time
+  const rclcpp::Time late_time =
+    rclcpp::Time(received_command.header.stamp) + rclcpp::Duration::from_seconds(1.0);
+  ASSERT_EQ(
+    controller_->update(late_time, rclcpp::Duration::from_seconds(0.01)),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, traction_joint_vel_cmd_.get_value());
+
+  // only the applied command brakes, the received one is left as it was
+  EXPECT_EQ(1.0, controller_->getLastReceivedTwist().twist.linear.x);
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST_F(TestTricycleController, jitter_buffer_plays_out_commands_delayed)
+{
+  const auto ret = controller_->init(controller_name);
+  ASSERT_EQ(ret, controller_interface::return_type::OK);
+
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("traction_joint_name", rclcpp::ParameterValue(traction_joint_name)));
+  controller_->get_node()->set_parameter(
+    rclcpp::Parameter("steering_joint_name", rclcpp::ParameterValue(steering_joint_name)));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheelbase", 0.4));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("wheel_radius", 1.0));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("jitter_buffer.enable", true));
+  controller_->get_node()->set_parameter(rclcpp::Parameter("jitter_buffer.delay", 0.1));
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(controller_->get_node()->get_node_base_interface());
+
+  auto state = controller_->get_node()->configure();
+  assignResources();
+  state = controller_->get_node()->activate();
+  ASSERT_EQ(State::PRIMARY_STATE_ACTIVE, state.id());
+
+  publish(1.0, 0.0);
+  ASSERT_TRUE(controller_->wait_for_twist(executor));
+  const rclcpp::Time stamp(controller_->getLastReceivedTwist().header.stamp);
+  const auto period = rclcpp::Duration::from_seconds(0.01);
+
+  // the command isn't due before the delay
+  ASSERT_EQ(
+    controller_->update(stamp + rclcpp::Duration::from_seconds(0.05), period),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, traction_joint_vel_cmd_.get_value());
+
+  ASSERT_EQ(
+    controller_->update(stamp + rclcpp::Duration::from_seconds(0.1), period),
+    controller_interface::return_type::OK);
+  EXPECT_GT(traction_joint_vel_cmd_.get_value(), 0.0);
+
+  // the timeout applies from the play out of the command
+  ASSERT_EQ(
+    controller_->update(stamp + rclcpp::Duration::from_seconds(0.55), period),
+    controller_interface::return_type::OK);
+  EXPECT_GT(traction_joint_vel_cmd_.get_value(), 0.0);
+  ASSERT_EQ(
+    controller_->update(stamp + rclcpp::Duration::from_seconds(0.65), period),
+    controller_interface::return_type::OK);
+  EXPECT_EQ(0.0, traction_joint_vel_cmd_.get_value());
+
+  state = controller_->get_node()->deactivate();
+  ASSERT_EQ(state.id(), State::PRIMARY_STATE_INACTIVE);
+  executor.cancel();
+}
+
+TEST(TractionScaling, default_profile_slows_down_with_the_steering_error)
+{
+  const tricycle_controller::TractionScaling scaling;
+  EXPECT_DOUBLE_EQ(1.0, scaling.scale(0.1));
+  EXPECT_NEAR(std::cos(1.0), scaling.scale(-1.0), 1e-4);
+  EXPECT_EQ(0.01, scaling.scale(2.0));
+  EXPECT_EQ(0.01, scaling.scale(std::numeric_limits<double>::quiet_NaN()));
+}
+
+TEST(TractionScaling, interpolates_the_configured_points)
+{
+  const tricycle_controller::TractionScaling scaling({0.2, 0.6, 1.0}, {1.0, 0.5, 0.0});
+  EXPECT_DOUBLE_EQ(1.0, scaling.scale(0.1));
+  EXPECT_NEAR(0.75, scaling.scale(0.4), 1e-9);
+  EXPECT_NEAR(0.25, scaling.scale(-0.8), 1e-9);
+  EXPECT_EQ(0.0, scaling.scale(3.0));
+
+  EXPECT_THROW(tricycle_controller::TractionScaling({0.0}, {1.0}), std::invalid_argument);
+  EXPECT_THROW(
+    tricycle_controller::TractionScaling({0.0, 0.0}, {1.0, 1.0}), std::invalid_argument);
+  EXPECT_THROW(
+    tricycle_controller::TractionScaling({0.0, 1.0}, {1.0, 1.5}), std::invalid_argument);
+  EXPECT_THROW(tricycle_controller::TractionScaling({0.0, 1.0}, {1.0}), std::invalid_argument);
+}
+
+TEST(TricycleOdometry, samples_are_integrated_over_their_intervals)
+{
+  tricycle_controller::Odometry per_cycle(1);
+  tricycle_controller::Odometry from_samples(1);
+  per_cycle.setWheelParams(0.4, 0.1);
+  from_samples.setWheelParams(0.4, 0.1);
+
+  // constant samples over one period match a single update
+  const std::array<double, 4> Ws = {2.0, 2.0, 2.0, 2.0};
+  const std::array<double, 4> alpha = {0.3, 0.3, 0.3, 0.3};
+  const std::array<double, 4> times = {10.025, 10.05, 10.075, 10.1};
+  const rclcpp::Time time(10, 100000000, RCL_ROS_TIME);
+  const auto period = rclcpp::Duration::from_seconds(0.1);
+  per_cycle.update(2.0, 0.3, period);
+  ASSERT_TRUE(
+    from_samples.updateFromSamples(Ws.data(), alpha.data(), times.data(), 4, time, period));
+  EXPECT_NEAR(per_cycle.getX(), from_samples.getX(), 1e-12);
+  EXPECT_NEAR(per_cycle.getY(), from_samples.getY(), 1e-12);
+  EXPECT_NEAR(per_cycle.getHeading(), from_samples.getHeading(), 1e-12);
+  EXPECT_NEAR(per_cycle.getLinear(), from_samples.getLinear(), 1e-12);
+  EXPECT_NEAR(per_cycle.getAngular(), from_samples.getAngular(), 1e-12);
+
+  // samples integrated before are skipped
+  const double heading = from_samples.getHeading();
+  EXPECT_FALSE(
+    from_samples.updateFromSamples(Ws.data(), alpha.data(), times.data(), 4, time, period));
+  EXPECT_EQ(heading, from_samples.getHeading());
+
+  // a steering change within the cycle turns the heading of its interval only
+  const std::array<double, 2> turn_alpha = {0.3, -0.3};
+  const std::array<double, 2> turn_times = {10.15, 10.2};
+  ASSERT_TRUE(from_samples.updateFromSamples(
+    Ws.data(), turn_alpha.data(), turn_times.data(), 2, time + period, period));
+  EXPECT_NEAR(heading, from_samples.getHeading(), 1e-12);
+  EXPECT_NEAR(0.2 * std::cos(0.3), from_samples.getLinear(), 1e-12);
+}
@@ -44,7 +44,7 @@ controller_interface::CallbackReturn TricycleSteeringController::configure_odome
     odometry_.set_wheel_params(front_wheels_radius, wheelbase, wheel_track);
   }
 
-  odometry_.set_odometry_type(steering_odometry::TRICYCLE_CONFIG);
+  odometry_.set_kinematic_model<steering_odometry::TricycleModel>();
 
   set_interface_numbers(NR_STATE_ITFS, NR_CMD_ITFS, NR_REF_ITFS);
 
@@ -60,13 +60,11 @@ bool TricycleSteeringController::update_odometry(const rclcpp::Duration & period
   }
   else
   {
-    const double rear_right_wheel_value = state_interfaces_[STATE_TRACTION_RIGHT_WHEEL].get_value();
-    const double rear_left_wheel_value = state_interfaces_[STATE_TRACTION_LEFT_WHEEL].get_value();
-    const double steer_position = state_interfaces_[STATE_STEER_AXIS].get_value();
-    if (
-      !std::isnan(rear_right_wheel_value) && !std::isnan(rear_left_wheel_value) &&
-      !std::isnan(steer_position))
+    if (state_values_valid_)
     {
+      const double rear_right_wheel_value = state_values_[STATE_TRACTION_RIGHT_WHEEL];
+      const double rear_left_wheel_value = state_values_[STATE_TRACTION_LEFT_WHEEL];
+      const double steer_position = state_values_[STATE_STEER_AXIS];
       if (params_.position_feedback)
       {
         // Estimate linear and angular velocity using joint information